@@ -0,0 +1,59 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Shared declarations for the scopehal-bench micro-benchmark suite
+ */
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include <benchmark/benchmark.h>
+
+#include "../scopehal/scopehal.h"
+#include "../scopehal/TestWaveformSource.h"
+#include "../scopeprotocols/scopeprotocols.h"
+
+///@brief Compute queue shared by all benchmarks (they run single threaded)
+extern std::shared_ptr<QueueHandle> g_benchQueue;
+
+///@brief Command buffer shared by all benchmarks
+extern std::unique_ptr<vk::raii::CommandBuffer> g_benchCmdBuf;
+
+///@brief Wraps a waveform in a scope-less channel so it can be fed to a filter input
+OscilloscopeChannel* MakeBenchChannel(
+	WaveformBase* wfm,
+	Stream::StreamType type = Stream::STREAM_TYPE_ANALOG,
+	Unit yunit = Unit(Unit::UNIT_VOLTS));
+
+///@brief Returns a path in the system temporary directory for generated benchmark input files
+std::string MakeBenchFilePath(const std::string& name);
+
+#endif
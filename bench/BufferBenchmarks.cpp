@@ -0,0 +1,106 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Benchmarks for AcceleratorBuffer transfer paths
+ */
+#include "Benchmark.h"
+
+using namespace std;
+
+///@brief Host-to-device transfer throughput via the implicit PrepareForGpuAccess() path
+static void BM_BufferCopyToGpu(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	AcceleratorBuffer<float> buf("BM_BufferCopyToGpu");
+	buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.resize(depth);
+	for(size_t i=0; i<depth; i++)
+		buf[i] = i;
+
+	for(auto _ : state)
+	{
+		buf.MarkModifiedFromCpu();
+		buf.PrepareForGpuAccess();
+	}
+
+	state.SetBytesProcessed(int64_t(state.iterations()) * depth * sizeof(float));
+}
+BENCHMARK(BM_BufferCopyToGpu)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+///@brief Device-to-host transfer throughput via the implicit PrepareForCpuAccess() path
+static void BM_BufferCopyToCpu(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	AcceleratorBuffer<float> buf("BM_BufferCopyToCpu");
+	buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.resize(depth);
+	for(size_t i=0; i<depth; i++)
+		buf[i] = i;
+	buf.PrepareForGpuAccess();
+
+	for(auto _ : state)
+	{
+		buf.MarkModifiedFromGpu();
+		buf.PrepareForCpuAccess();
+	}
+
+	state.SetBytesProcessed(int64_t(state.iterations()) * depth * sizeof(float));
+}
+BENCHMARK(BM_BufferCopyToCpu)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+///@brief Round trip: upload, then immediately download (worst case ping-pong filter chain)
+static void BM_BufferRoundTrip(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	AcceleratorBuffer<float> buf("BM_BufferRoundTrip");
+	buf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	buf.resize(depth);
+	for(size_t i=0; i<depth; i++)
+		buf[i] = i;
+
+	for(auto _ : state)
+	{
+		buf.MarkModifiedFromCpu();
+		buf.PrepareForGpuAccess();
+		buf.MarkModifiedFromGpu();
+		buf.PrepareForCpuAccess();
+	}
+
+	state.SetBytesProcessed(int64_t(state.iterations()) * depth * sizeof(float) * 2);
+}
+BENCHMARK(BM_BufferRoundTrip)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
@@ -0,0 +1,208 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Benchmarks for frequently used filter kernels, driven by synthetic TestWaveformSource inputs
+ */
+#include "Benchmark.h"
+
+using namespace std;
+
+///@brief 10 Gsps sample interval, in fs
+static const int64_t SAMPLE_PERIOD = 100000;
+
+///@brief FIR filter with default band settings over a noisy 1 GHz sinewave
+static void BM_FIRFilter(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	minstd_rand rng;
+	TestWaveformSource source(rng);
+	auto chan = MakeBenchChannel(source.GenerateNoisySinewave(1.0, 0, 1e6, SAMPLE_PERIOD, depth));
+
+	auto filt = new FIRFilter("#ffffff");
+	filt->SetInput("in", StreamDescriptor(chan, 0));
+
+	for(auto _ : state)
+		filt->Refresh(*g_benchCmdBuf, g_benchQueue);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * depth);
+
+	delete filt;
+	delete chan;
+}
+BENCHMARK(BM_FIRFilter)->Arg(1 << 18)->Arg(1 << 22);
+
+///@brief Forward FFT of a noisy 1 GHz sinewave
+static void BM_FFTFilter(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	minstd_rand rng;
+	TestWaveformSource source(rng);
+	auto chan = MakeBenchChannel(source.GenerateNoisySinewave(1.0, 0, 1e6, SAMPLE_PERIOD, depth));
+
+	auto filt = new FFTFilter("#ffffff");
+	filt->SetInput("din", StreamDescriptor(chan, 0));
+
+	for(auto _ : state)
+		filt->Refresh(*g_benchCmdBuf, g_benchQueue);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * depth);
+
+	delete filt;
+	delete chan;
+}
+BENCHMARK(BM_FFTFilter)->Arg(1 << 18)->Arg(1 << 22);
+
+///@brief Writes a synthetic 2-port Touchstone file (flat -1 dB thru with linear phase) and returns its path
+static string MakeBenchS2pFile()
+{
+	auto path = MakeBenchFilePath("scopehal-bench.s2p");
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Failed to create %s\n", path.c_str());
+		return "";
+	}
+	fprintf(fp, "# HZ S MA R 50\n");
+	for(int i=1; i<=100; i++)
+		fprintf(fp, "%e 0.1 0 0.89 %f 0.89 %f 0.1 0\n", i * 5e8, -3.6 * i, -3.6 * i);
+	fclose(fp);
+	return path;
+}
+
+///@brief Channel de-embed of a PRBS31 waveform through a synthetic 2-port S-parameter set
+static void BM_DeEmbedFilter(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	minstd_rand rng;
+	TestWaveformSource source(rng);
+	auto chan = MakeBenchChannel(source.GeneratePRBS31(
+		*g_benchCmdBuf, g_benchQueue, 1.0, 200000, SAMPLE_PERIOD, depth));
+
+	auto sparams = new TouchstoneImportFilter("#ffffff");
+	sparams->GetParameter("Touchstone File").SetFileName(MakeBenchS2pFile());
+
+	//Find the S21 output streams of the Touchstone import
+	size_t magIdx = 0;
+	size_t angIdx = 0;
+	for(size_t i=0; i<sparams->GetStreamCount(); i++)
+	{
+		if(sparams->GetStreamName(i) == "S21_mag")
+			magIdx = i;
+		if(sparams->GetStreamName(i) == "S21_ang")
+			angIdx = i;
+	}
+
+	auto filt = new DeEmbedFilter("#ffffff");
+	filt->SetInput("signal", StreamDescriptor(chan, 0));
+	filt->SetInput("mag", StreamDescriptor(sparams, magIdx));
+	filt->SetInput("angle", StreamDescriptor(sparams, angIdx));
+
+	for(auto _ : state)
+		filt->Refresh(*g_benchCmdBuf, g_benchQueue);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * depth);
+
+	delete filt;
+	delete sparams;
+	delete chan;
+}
+BENCHMARK(BM_DeEmbedFilter)->Arg(1 << 18)->Arg(1 << 22);
+
+///@brief PLL clock recovery over a 5 Gbps PRBS31 pattern
+static void BM_ClockRecoveryFilter(benchmark::State& state)
+{
+	size_t depth = state.range(0);
+
+	minstd_rand rng;
+	TestWaveformSource source(rng);
+	auto chan = MakeBenchChannel(source.GeneratePRBS31(
+		*g_benchCmdBuf, g_benchQueue, 1.0, 200000, 50000, depth));
+
+	auto filt = new ClockRecoveryFilter("#ffffff");
+	filt->SetInput("IN", StreamDescriptor(chan, 0));
+	filt->GetParameter("Symbol rate").SetFloatVal(5e9);
+
+	for(auto _ : state)
+		filt->Refresh(*g_benchCmdBuf, g_benchQueue);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * depth);
+
+	delete filt;
+	delete chan;
+}
+BENCHMARK(BM_ClockRecoveryFilter)->Arg(1 << 18)->Arg(1 << 22);
+
+///@brief 8b/10b line code decode of an idle-heavy digital stream with a recovered UI-rate clock
+static void BM_IBM8b10bDecoder(benchmark::State& state)
+{
+	size_t nbits = state.range(0);
+
+	//K28.5- comma followed by a data symbol, repeating
+	static const char pattern[] = "00111110101010010110";
+
+	auto data = new UniformDigitalWaveform;
+	data->m_timescale = 100000;
+	data->Resize(nbits);
+	data->PrepareForCpuAccess();
+	for(size_t i=0; i<nbits; i++)
+		data->m_samples[i] = (pattern[i % 20] == '1');
+	data->MarkModifiedFromCpu();
+
+	//Clock toggles once per UI so there's one edge per bit
+	auto clk = new UniformDigitalWaveform;
+	clk->m_timescale = 100000;
+	clk->Resize(nbits);
+	clk->PrepareForCpuAccess();
+	for(size_t i=0; i<nbits; i++)
+		clk->m_samples[i] = (i & 1) ? true : false;
+	clk->MarkModifiedFromCpu();
+
+	auto dchan = MakeBenchChannel(data, Stream::STREAM_TYPE_DIGITAL, Unit(Unit::UNIT_COUNTS));
+	auto cchan = MakeBenchChannel(clk, Stream::STREAM_TYPE_DIGITAL, Unit(Unit::UNIT_COUNTS));
+
+	auto filt = new IBM8b10bDecoder("#ffffff");
+	filt->SetInput("data", StreamDescriptor(dchan, 0));
+	filt->SetInput("clk", StreamDescriptor(cchan, 0));
+
+	for(auto _ : state)
+		filt->Refresh(*g_benchCmdBuf, g_benchQueue);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * nbits);
+
+	delete filt;
+	delete dchan;
+	delete cchan;
+}
+BENCHMARK(BM_IBM8b10bDecoder)->Arg(1 << 18)->Arg(1 << 22);
@@ -0,0 +1,206 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief System-level golden-path benchmarks: a demo instrument driving canonical filter graphs end to end
+
+	Unlike the kernel micro-benchmarks, these measure the whole pipeline the way a release candidate is used
+	on the production floor: fresh waveforms per trigger, the real scheduler, and multiple interacting filters.
+	Each benchmark reports a comparable scorecard:
+
+	* items/sec = sustained triggers decoded per second
+	* "util% <stage>" counters = share of total graph wall time spent in each filter (from the executor profiler)
+	* peak_rss_MB = peak resident set of the process
+	* peak_buffers_MB = high-water mark of live AcceleratorBuffer bytes (host + device), an upper bound on VRAM demand
+
+	The demo driver rate-limits acquisition to emulate a real instrument, so waveform generation is excluded
+	from the timed region; triggers/sec reflects graph throughput alone.
+ */
+#include "Benchmark.h"
+#include "../scopehal/DemoOscilloscope.h"
+#include "../scopehal/BufferAllocationRegistry.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+///@brief Creates a demo oscilloscope with only the requested channels enabled and the trigger armed
+static DemoOscilloscope* MakeDemoScope(const vector<size_t>& channels, uint64_t depth)
+{
+	auto scope = new DemoOscilloscope(new SCPINullTransport(""));
+	for(size_t i=0; i<4; i++)
+		scope->DisableChannel(i);
+	for(auto i : channels)
+		scope->EnableChannel(i);
+	scope->SetSampleDepth(depth);
+	scope->Start();
+	return scope;
+}
+
+///@brief Acquires a fresh trigger per iteration, runs the graph, and reports the standard scorecard
+static void RunGoldenPath(benchmark::State& state, DemoOscilloscope* scope, const set<FlowGraphNode*>& graph)
+{
+	//The profiler adds a little overhead per dispatch, but it's the same overhead for every release
+	//candidate so the scorecards stay comparable
+	FilterGraphExecutor executor;
+	executor.SetProfilingEnabled(true);
+
+	BufferAllocationRegistry::Clear();
+	BufferAllocationRegistry::SetEnabled(true);
+
+	for(auto _ : state)
+	{
+		//Acquisition is rate-limited by the demo driver to emulate a real instrument,
+		//so keep it out of the timed region
+		state.PauseTiming();
+		scope->AcquireData();
+		while(scope->HasPendingWaveforms())
+			scope->PopPendingWaveform();
+		state.ResumeTiming();
+
+		executor.RunBlocking(graph);
+	}
+
+	//items/sec = sustained triggers/sec through the graph
+	state.SetItemsProcessed(state.iterations());
+
+	//Per-stage utilization: share of total graph wall time spent in each node
+	auto stats = executor.GetPerfStats();
+	int64_t total = 0;
+	for(auto& it : stats)
+		total += it.second.m_wallTimeFs;
+	if(total > 0)
+	{
+		for(auto& it : stats)
+		{
+			auto chan = dynamic_cast<InstrumentChannel*>(it.first);
+			if(!chan)
+				continue;
+			state.counters["util% " + chan->GetDisplayName()] =
+				(100.0 * it.second.m_wallTimeFs) / total;
+		}
+	}
+
+	//Peak working set of the whole process
+	#ifndef _WIN32
+		struct rusage ru;
+		getrusage(RUSAGE_SELF, &ru);
+		state.counters["peak_rss_MB"] = ru.ru_maxrss / 1024.0;
+	#endif
+
+	//High-water mark of live AcceleratorBuffer bytes across all tags.
+	//This counts host and device copies together, so treat it as an upper bound on VRAM demand.
+	size_t peakBuf = 0;
+	for(auto& it : BufferAllocationRegistry::GetSnapshot())
+		peakBuf += it.second.m_peakLiveBytes;
+	state.counters["peak_buffers_MB"] = peakBuf / (1024.0 * 1024.0);
+
+	BufferAllocationRegistry::SetEnabled(false);
+}
+
+///@brief Decode-heavy serial stack: CDR and thresholding of the demo 8B/10B channel feeding symbol decode
+static void BM_GoldenPath_SerialDecode(benchmark::State& state)
+{
+	auto scope = MakeDemoScope({3}, state.range(0));
+	StreamDescriptor din(scope->GetOscilloscopeChannel(3), 0);
+
+	auto cdr = new ClockRecoveryFilter("#ffffff");
+	cdr->SetInput("IN", din);
+
+	auto thresh = new ThresholdFilter("#ffffff");
+	thresh->SetInput("din", din);
+
+	auto dec = new IBM8b10bDecoder("#ffffff");
+	dec->SetInput("data", StreamDescriptor(thresh, 0));
+	dec->SetInput("clk", StreamDescriptor(cdr, 0));
+
+	set<FlowGraphNode*> graph = {cdr, thresh, dec};
+	RunGoldenPath(state, scope, graph);
+
+	delete dec;
+	delete thresh;
+	delete cdr;
+	delete scope;
+}
+BENCHMARK(BM_GoldenPath_SerialDecode)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+///@brief Spectral stack: FFT and spectrogram of the demo swept-sine channel
+static void BM_GoldenPath_Spectral(benchmark::State& state)
+{
+	auto scope = MakeDemoScope({1}, state.range(0));
+	StreamDescriptor din(scope->GetOscilloscopeChannel(1), 0);
+
+	auto fft = new FFTFilter("#ffffff");
+	fft->SetInput("din", din);
+
+	auto spec = new SpectrogramFilter("#ffffff");
+	spec->SetInput("din", din);
+
+	set<FlowGraphNode*> graph = {fft, spec};
+	RunGoldenPath(state, scope, graph);
+
+	delete spec;
+	delete fft;
+	delete scope;
+}
+BENCHMARK(BM_GoldenPath_Spectral)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+///@brief Eye/jitter stack: CDR of the demo 10.3125 Gbps PRBS-31 channel feeding an eye pattern and TIE measurement
+static void BM_GoldenPath_EyeJitter(benchmark::State& state)
+{
+	auto scope = MakeDemoScope({2}, state.range(0));
+	StreamDescriptor din(scope->GetOscilloscopeChannel(2), 0);
+
+	auto cdr = new ClockRecoveryFilter("#ffffff");
+	cdr->GetParameter("Symbol rate").SetFloatVal(10312500000.0);	//10.3125 Gbps
+	cdr->SetInput("IN", din);
+
+	auto eye = new EyePattern("#ffffff");
+	eye->SetWidth(512);
+	eye->SetHeight(256);
+	eye->SetInput("din", din);
+	eye->SetInput("clk", StreamDescriptor(cdr, 0));
+
+	auto tie = new TIEMeasurement("#ffffff");
+	tie->SetInput("Clock", din);
+	tie->SetInput("Golden", StreamDescriptor(cdr, 0));
+
+	set<FlowGraphNode*> graph = {cdr, eye, tie};
+	RunGoldenPath(state, scope, graph);
+
+	delete tie;
+	delete eye;
+	delete cdr;
+	delete scope;
+}
+BENCHMARK(BM_GoldenPath_EyeJitter)->Arg(1000000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,96 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Benchmarks for waveform import filters
+ */
+#include "Benchmark.h"
+
+using namespace std;
+
+///@brief Writes a synthetic CSV capture with the given number of rows and returns its path
+static string MakeBenchCsvFile(size_t rows)
+{
+	auto path = MakeBenchFilePath("scopehal-bench.csv");
+	FILE* fp = fopen(path.c_str(), "w");
+	if(!fp)
+	{
+		LogError("Failed to create %s\n", path.c_str());
+		return "";
+	}
+	fprintf(fp, "Time,Voltage\n");
+	for(size_t i=0; i<rows; i++)
+		fprintf(fp, "%e,%f\n", i * 1e-10, sin(i * 0.01));
+	fclose(fp);
+	return path;
+}
+
+///@brief Full reparse of a synthetic single-column CSV capture
+static void BM_CSVImport(benchmark::State& state)
+{
+	size_t rows = state.range(0);
+	auto path = MakeBenchCsvFile(rows);
+
+	auto filt = new CSVImportFilter("#ffffff");
+
+	//Setting the filename parameter triggers a reload even if the value is unchanged
+	for(auto _ : state)
+		filt->GetParameter("CSV File").SetFileName(path);
+
+	state.SetItemsProcessed(int64_t(state.iterations()) * rows);
+
+	delete filt;
+}
+BENCHMARK(BM_CSVImport)->Arg(100000)->Arg(1000000);
+
+/**
+	@brief Full reparse of a Tektronix WFM capture
+
+	The WFM container is too involved to synthesize credibly, so this benchmark reads a real capture:
+	point SCOPEHAL_BENCH_WFM at a .wfm file to enable it.
+ */
+static void BM_WFMImport(benchmark::State& state)
+{
+	auto path = getenv("SCOPEHAL_BENCH_WFM");
+	if(!path)
+	{
+		state.SkipWithError("SCOPEHAL_BENCH_WFM not set (point it at a .wfm file to enable this benchmark)");
+		return;
+	}
+
+	auto filt = new WFMImportFilter("#ffffff");
+
+	for(auto _ : state)
+		filt->GetParameter("WFM File").SetFileName(path);
+
+	delete filt;
+}
+BENCHMARK(BM_WFMImport);
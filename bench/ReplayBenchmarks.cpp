@@ -0,0 +1,85 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+
+/**
+	@file
+	@brief Benchmarks replaying captured instrument traffic through real driver parse paths
+
+	Capture a dump by prefixing an instrument's transport args with the recording transport, e.g.
+	connecting with "record:capture.scpirec|lan|192.0.2.10:5025" and triggering a few acquisitions,
+	then point SCOPEHAL_BENCH_SCPIREC at the dump and SCOPEHAL_BENCH_SCPIREC_DRIVER at the driver
+	name (e.g. "lecroy") to measure waveform parse throughput with no instrument attached.
+ */
+#include "Benchmark.h"
+
+using namespace std;
+
+///@brief Replays the AcquireData traffic from a captured dump through the selected driver
+static void BM_DriverReplay(benchmark::State& state)
+{
+	auto path = getenv("SCOPEHAL_BENCH_SCPIREC");
+	auto driver = getenv("SCOPEHAL_BENCH_SCPIREC_DRIVER");
+	if(!path || !driver)
+	{
+		state.SkipWithError(
+			"Set SCOPEHAL_BENCH_SCPIREC to a dump captured with SCPIRecordingTransport "
+			"and SCOPEHAL_BENCH_SCPIREC_DRIVER to the driver name to run this benchmark");
+		return;
+	}
+
+	auto transport = new SCPIReplayTransport(path);
+	if(!transport->IsConnected())
+	{
+		state.SkipWithError("Failed to load traffic dump");
+		delete transport;
+		return;
+	}
+
+	//The driver's constructor replays the IDN/setup exchange from the start of the dump
+	auto scope = Oscilloscope::CreateOscilloscope(driver, transport);
+	if(!scope)
+	{
+		state.SkipWithError("Failed to create driver");
+		delete transport;
+		return;
+	}
+
+	for(auto _ : state)
+	{
+		transport->Rewind();
+		scope->AcquireData();
+	}
+
+	state.SetBytesProcessed(state.iterations() * transport->GetDumpSize());
+
+	delete scope;	//also deletes the transport
+}
+BENCHMARK(BM_DriverReplay)->Unit(benchmark::kMillisecond);
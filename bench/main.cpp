@@ -0,0 +1,99 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Entry point and shared fixtures for the scopehal-bench micro-benchmark suite
+
+	Run with no arguments to execute everything, or use the standard Google Benchmark flags
+	(--benchmark_filter, --benchmark_format=json, etc.) to select and export results for
+	per-commit comparison.
+ */
+#include "Benchmark.h"
+
+using namespace std;
+
+shared_ptr<QueueHandle> g_benchQueue;
+unique_ptr<vk::raii::CommandBuffer> g_benchCmdBuf;
+
+///@brief Command pool the shared command buffer is allocated from
+static unique_ptr<vk::raii::CommandPool> g_benchCommandPool;
+
+OscilloscopeChannel* MakeBenchChannel(WaveformBase* wfm, Stream::StreamType type, Unit yunit)
+{
+	auto chan = new OscilloscopeChannel(nullptr, "bench", "#ffffff", Unit(Unit::UNIT_FS), yunit, type);
+	chan->SetData(wfm, 0);
+	return chan;
+}
+
+string MakeBenchFilePath(const string& name)
+{
+	#ifdef _WIN32
+		auto tmpdir = getenv("TEMP");
+		return string(tmpdir ? tmpdir : ".") + "\\" + name;
+	#else
+		return "/tmp/" + name;
+	#endif
+}
+
+int main(int argc, char** argv)
+{
+	//Log at "notice" severity so benchmark output isn't drowned in driver debug spam
+	g_log_sinks.emplace_back(make_unique<ColoredSTDLogSink>(Severity::NOTICE));
+
+	if(!VulkanInit(true))
+	{
+		LogError("Vulkan initialization failed, cannot run benchmarks\n");
+		return 1;
+	}
+	TransportStaticInit();
+	DriverStaticInit();
+	ScopeProtocolStaticInit();
+
+	//Queue and command buffer shared by all of the benchmarks
+	g_benchQueue = g_vkQueueManager->GetComputeQueue("scopehal-bench.queue");
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		g_benchQueue->m_family );
+	g_benchCommandPool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+	vk::CommandBufferAllocateInfo bufinfo(**g_benchCommandPool, vk::CommandBufferLevel::ePrimary, 1);
+	g_benchCmdBuf = make_unique<vk::raii::CommandBuffer>(
+		std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	::benchmark::Initialize(&argc, argv);
+	::benchmark::RunSpecifiedBenchmarks();
+	::benchmark::Shutdown();
+
+	g_benchCmdBuf = nullptr;
+	g_benchCommandPool = nullptr;
+	g_benchQueue = nullptr;
+	ScopehalStaticCleanup();
+	return 0;
+}
@@ -318,11 +318,12 @@ void TouchstoneExportWizard::on_apply()
 	else /*if(sFormatText.find("RI") == 0)*/
 		format = SParameters::FORMAT_REAL_IMAGINARY;
 
-	//Finally, save it
+	//Finally, save it (with a binary sidecar so re-importing the model is instant)
 	params.SaveToFile(
 		m_filePathPage.m_chooser.get_filename(),
 		format,
-		freqUnit);
+		freqUnit,
+		true);
 
 	hide();
 }
@@ -34,6 +34,7 @@
  */
 #include "scopeexports.h"
 #include "VCDExportWizard.h"
+#include <cinttypes>
 
 using namespace std;
 
@@ -278,50 +279,105 @@ void VCDExportWizard::on_apply()
 	fprintf(fp, "$enddefinitions $end\n");
 	fprintf(fp, "$dumpvars\n");
 
-	//Print the actual waveform
-	//TODO: more efficient, don't export every signal if only one has changed
-	int64_t timestamp = 0;
-	while(true)
+	//Extract the per-channel edge lists: initial value plus one (time, value) entry per transition.
+	//Everything after this is proportional to transition count, not sample count.
+	vector<vector<pair<int64_t, bool>>> transitions;
+	transitions.resize(streams.size());
+	for(size_t i=0; i<streams.size(); i++)
 	{
-		//Print signal values
-		fprintf(fp, "#%ld\n", timestamp);
-		for(size_t i=0; i<streams.size(); i++)
+		auto& tl = transitions[i];
+		if(!lens[i])
+			continue;
+		if(sparsewaveforms[i])
 		{
-			if(sparsewaveforms[i])
-				fprintf(fp,"%d%s\n", sparsewaveforms[i]->m_samples[indexes[i]], ids[i].c_str());
-			else
-				fprintf(fp,"%d%s\n", uniformwaveforms[i]->m_samples[indexes[i]], ids[i].c_str());
+			auto wfm = sparsewaveforms[i];
+			bool last = wfm->m_samples[0];
+			tl.push_back(pair<int64_t, bool>(
+				wfm->m_triggerPhase + wfm->m_timescale * wfm->m_offsets[0], last));
+			for(size_t j=1; j<lens[i]; j++)
+			{
+				bool value = wfm->m_samples[j];
+				if(value == last)
+					continue;
+				tl.push_back(pair<int64_t, bool>(
+					wfm->m_triggerPhase + wfm->m_timescale * wfm->m_offsets[j], value));
+				last = value;
+			}
+		}
+		else
+		{
+			auto wfm = uniformwaveforms[i];
+			bool last = wfm->m_samples[0];
+			tl.push_back(pair<int64_t, bool>(wfm->m_triggerPhase, last));
+			for(size_t j=1; j<lens[i]; j++)
+			{
+				bool value = wfm->m_samples[j];
+				if(value == last)
+					continue;
+				tl.push_back(pair<int64_t, bool>(
+					wfm->m_triggerPhase + wfm->m_timescale * (int64_t)j, value));
+				last = value;
+			}
 		}
+	}
 
-		//Get timestamp of next event on any channel
-		int64_t next = timestamp;
+	//Merge the edge lists by timestamp, writing only signals that changed at each point,
+	//into a memory buffer flushed in large blocks
+	const size_t FLUSH_THRESHOLD = 1024 * 1024;
+	string outbuf;
+	outbuf.reserve(2 * FLUSH_THRESHOLD);
+	char tmp[64];
+	bool firstTimestamp = true;
+	while(true)
+	{
+		//Find the timestamp of the next transition on any channel
+		bool found = false;
+		int64_t next = 0;
 		for(size_t i=0; i<streams.size(); i++)
 		{
-			int64_t t;
-			if(sparsewaveforms[i])
-				t = Filter::GetNextEventTimestampScaled(sparsewaveforms[i], indexes[i], lens[i], timestamp);
-			else
-				t = Filter::GetNextEventTimestampScaled(uniformwaveforms[i], indexes[i], lens[i], timestamp);
-			if(i == 0)
+			if(indexes[i] >= transitions[i].size())
+				continue;
+			int64_t t = transitions[i][indexes[i]].first;
+			if(!found || (t < next) )
+			{
 				next = t;
-			else
-				next = min(next, t);
+				found = true;
+			}
 		}
-
-		//If we can't move forward, stop
-		if(next == timestamp)
+		if(!found)
 			break;
 
-		//Move on
-		timestamp = next;
+		//The first timestamp carries every signal's initial value ($dumpvars block); align it to
+		//time zero like the old exporter did rather than starting mid-capture
+		if(firstTimestamp)
+			next = min(next, (int64_t)0);
+
+		snprintf(tmp, sizeof(tmp), "#%" PRId64 "\n", next);
+		outbuf += tmp;
+
 		for(size_t i=0; i<streams.size(); i++)
 		{
-			if(sparsewaveforms[i])
-				Filter::AdvanceToTimestampScaled(sparsewaveforms[i], indexes[i], lens[i], timestamp);
-			else
-				Filter::AdvanceToTimestampScaled(uniformwaveforms[i], indexes[i], lens[i], timestamp);
+			if(indexes[i] >= transitions[i].size())
+				continue;
+			if(!firstTimestamp && (transitions[i][indexes[i]].first > next) )
+				continue;
+
+			outbuf += transitions[i][indexes[i]].second ? '1' : '0';
+			outbuf += ids[i];
+			outbuf += '\n';
+			if(transitions[i][indexes[i]].first <= next)
+				indexes[i] ++;
+		}
+		firstTimestamp = false;
+
+		if(outbuf.size() >= FLUSH_THRESHOLD)
+		{
+			fwrite(outbuf.c_str(), 1, outbuf.size(), fp);
+			outbuf.clear();
 		}
 	}
+	if(!outbuf.empty())
+		fwrite(outbuf.c_str(), 1, outbuf.size(), fp);
 
 	fclose(fp);
 	hide();
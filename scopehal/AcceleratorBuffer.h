@@ -49,8 +49,13 @@
 
 #include <type_traits>
 
+#include "BufferAllocationRegistry.h"
+#include "GpuMemoryArena.h"
+#include "SampleConversion.h"
+
 extern uint32_t g_vkPinnedMemoryType;
 extern uint32_t g_vkLocalMemoryType;
+extern uint32_t g_vkBarMemoryType;
 extern std::shared_ptr<vk::raii::Device> g_vkComputeDevice;
 extern std::unique_ptr<vk::raii::CommandBuffer> g_vkTransferCommandBuffer;
 extern std::shared_ptr<QueueHandle> g_vkTransferQueue;
@@ -58,6 +63,37 @@ extern std::mutex g_vkTransferMutex;
 
 extern bool g_hasDebugUtils;
 extern bool g_vulkanDeviceHasUnifiedMemory;
+extern bool g_hasResizableBar;
+
+///@brief Number of asynchronous transfers that can be in flight simultaneously
+constexpr size_t ASYNC_TRANSFER_SLOTS = 4;
+
+extern bool g_hasTimelineSemaphores;
+extern bool g_hasMemoryPriority;
+
+uint64_t SubmitAsyncTransfer(vk::Buffer src, vk::Buffer dst, size_t size);
+void WaitForAsyncTransfer(uint64_t handle);
+bool IsAsyncTransferDone(uint64_t handle);
+
+/**
+	@brief Per-thread counters of buffer traffic, sampled by the filter graph profiler
+
+	Updated by every AcceleratorBuffer on the current thread; FilterGraphExecutor snapshots them around each
+	node's execution to attribute transfer volume and allocation churn to individual filters.
+ */
+struct BufferPerfCounters
+{
+	///@brief Bytes copied from GPU to CPU
+	uint64_t m_bytesToCpu = 0;
+
+	///@brief Bytes copied from CPU to GPU
+	uint64_t m_bytesToGpu = 0;
+
+	///@brief Number of CPU- or GPU-side physical buffer allocations
+	uint64_t m_allocations = 0;
+};
+
+extern thread_local BufferPerfCounters g_bufferPerfCounters;
 
 template<class T>
 class AcceleratorBuffer;
@@ -260,9 +296,15 @@ protected:
 	///@brief CPU-side physical memory
 	std::unique_ptr<vk::raii::DeviceMemory> m_cpuPhysMem;
 
-	///@brief GPU-side physical memory
+	///@brief GPU-side physical memory (dedicated allocation; null if arena-backed or not allocated)
 	std::unique_ptr<vk::raii::DeviceMemory> m_gpuPhysMem;
 
+	///@brief GPU-side physical memory sub-allocated from the global arena (null if dedicated or not allocated)
+	std::shared_ptr<GpuMemoryBlock> m_gpuArenaBlock;
+
+	///@brief Persistent CPU mapping of m_gpuPhysMem if it came from the BAR memory type (null otherwise)
+	T* m_gpuMappedPtr;
+
 	///@brief Buffer object for CPU-side memory
 	std::unique_ptr<vk::raii::Buffer> m_cpuBuffer;
 
@@ -278,6 +320,9 @@ protected:
 	///@brief True if m_gpuPhysMem contains stale data (m_cpuPtr has been modified and they point to different memory)
 	bool m_gpuPhysMemIsStale;
 
+	///@brief True if m_cpuPtr aliases memory owned by another buffer rather than an allocation of our own (see Borrow() )
+	bool m_cpuPtrIsBorrowed;
+
 	///@brief File handle used for MEM_TYPE_CPU_PAGED
 #ifndef _WIN32
 	int m_tempFileHandle;
@@ -324,9 +369,11 @@ public:
 		, m_gpuMemoryType(MEM_TYPE_NULL)
 		, m_cpuPtr(nullptr)
 		, m_gpuPhysMem(nullptr)
+		, m_gpuMappedPtr(nullptr)
 		, m_buffersAreSame(false)
 		, m_cpuPhysMemIsStale(false)
 		, m_gpuPhysMemIsStale(false)
+		, m_cpuPtrIsBorrowed(false)
 		#ifndef _WIN32
 		, m_tempFileHandle(0)
 		#endif
@@ -413,7 +460,13 @@ public:
 		@brief Returns true if there is currently a GPU-side buffer
 	 */
 	bool HasGpuBuffer() const
-	{ return (m_gpuPhysMem != nullptr); }
+	{ return (m_gpuPhysMem != nullptr) || (m_gpuArenaBlock != nullptr); }
+
+	/**
+		@brief Returns true if the CPU-side buffer is a borrowed view of another buffer's storage (see Borrow() )
+	 */
+	bool IsCpuBufferBorrowed() const
+	{ return m_cpuPtrIsBorrowed; }
 
 	/**
 		@brief Returns true if the object contains only a single buffer
@@ -540,6 +593,90 @@ public:
 		m_gpuPhysMemIsStale = rhs.m_gpuPhysMemIsStale;
 	}
 
+	/**
+		@brief Makes this buffer a zero-copy view of a sub-range of another buffer
+
+		After this call, m_cpuPtr aliases elements [start, start+count) of the parent's CPU-side storage. No
+		allocation or copy is made, so windowing a multi-gigapoint record down to a small burst costs the same
+		as windowing a short one. Writes through the view modify the parent's samples.
+
+		The view is CPU-side only: the first GPU access, or any operation that has to grow or reallocate the
+		buffer, transparently detaches it into a private copy of the windowed data (see Detach() ).
+
+		The view does NOT extend the parent's lifetime. It stays valid only until the parent is freed, resized,
+		or reallocated, so it should be re-created each time the producing filter refreshes rather than cached
+		across acquisitions. Call Detach() to keep the data past that point.
+
+		@param parent	Buffer whose storage we alias
+		@param start	Index of the first element of the window
+		@param count	Number of elements in the window
+	 */
+	void Borrow(AcceleratorBuffer<T>& parent, size_t start, size_t count)
+	{
+		//Get rid of whatever we were holding before
+		//(frees nothing if we were already a view, thanks to the m_cpuPtrIsBorrowed guards)
+		FreeCpuBuffer();
+		FreeGpuBuffer(true);
+
+		//Empty window? Nothing to alias
+		if(count == 0)
+			return;
+
+		//Make sure the parent's CPU-side data is valid before we point into it
+		parent.PrepareForCpuAccess();
+
+		//Alias the parent's storage. We claim plain host memory regardless of how the parent allocated it,
+		//since we have no Vulkan buffer object of our own covering the window.
+		m_cpuPtr = parent.m_cpuPtr + start;
+		m_cpuMemoryType = MEM_TYPE_CPU_ONLY;
+		m_cpuPtrIsBorrowed = true;
+		m_cpuPhysMemIsStale = false;
+		m_gpuPhysMemIsStale = false;
+		m_buffersAreSame = false;
+		m_size = count;
+		m_capacity = count;
+
+		//GPU access has to detach into an owned copy first, so hint "never" until that happens
+		m_cpuAccessHint = HINT_LIKELY;
+		m_gpuAccessHint = HINT_NEVER;
+	}
+
+	/**
+		@brief If the CPU-side pointer is borrowed from another buffer, replaces it with a private copy of the data
+
+		No effect on buffers that own their storage.
+	 */
+	void Detach()
+	{
+		if(m_cpuPtrIsBorrowed)
+			Reallocate(m_size);
+	}
+
+	/**
+		@brief Fills this buffer with samples converted from a raw ADC sample format, with fused gain/offset
+
+		Resizes the buffer to count elements, then converts pin[i] * gain - offset into the CPU-side buffer
+		using the best vectorized backend available for the source format (see SampleConversion.h), and marks
+		CPU-side data as modified.
+
+		Only available for fp32 buffers; the source sample type selects the conversion kernel at compile time.
+
+		@param pin		Pointer to the raw input samples
+		@param count	Number of samples to convert
+		@param gain		Scale factor applied to each raw sample
+		@param offset	Offset subtracted after scaling
+	 */
+	template<class Src>
+	void CopyConvertFrom(const Src* pin, size_t count, float gain = 1.0f, float offset = 0.0f)
+	{
+		static_assert(std::is_same<T, float>::value, "CopyConvertFrom() can only target fp32 buffers");
+
+		resize(count);
+		PrepareForCpuAccess();
+		ConvertSamples(m_cpuPtr, pin, gain, offset, count);
+		MarkModifiedFromCpu();
+	}
+
 protected:
 
 	/**
@@ -551,6 +688,10 @@ protected:
 		if(size == 0)
 			return;
 
+		//Resizing an existing buffer is a churn event worth attributing separately from first-time allocation
+		if(BufferAllocationRegistry::IsEnabled() && (m_capacity != 0))
+			BufferAllocationRegistry::OnReallocation(m_name);
+
 		/*
 			If we are a bool[] or similar one-byte type, we are likely going to be accessed from the GPU via a uint32
 			descriptor for at least some shaders (such as rendering).
@@ -617,8 +758,17 @@ protected:
 				//If CPU-side data is stale, just allocate the new buffer but leave it as stale
 				//(don't do a potentially unnecessary copy from the GPU)
 
-				//Now we're done with the old pointer so get rid of it
-				FreeCpuPointer(pOld, pOldPin, type, m_capacity);
+				//Now we're done with the old pointer so get rid of it.
+				//If it was borrowed from another buffer we never owned it; just drop the reference
+				//(this is how a view detaches into a private copy)
+				if(m_cpuPtrIsBorrowed)
+					m_cpuPtrIsBorrowed = false;
+				else
+				{
+					if(BufferAllocationRegistry::IsEnabled())
+						BufferAllocationRegistry::OnFree(m_name, m_capacity * sizeof(T));
+					FreeCpuPointer(pOld, pOldPin, type, m_capacity);
+				}
 			}
 
 			//Allocate new CPU memory, replacing our current (null) pointer
@@ -628,7 +778,7 @@ protected:
 
 				//If we already had GPU-side memory containing data, then the new CPU-side buffer is stale
 				//until we copy stuff over to it
-				if(m_gpuPhysMem != nullptr)
+				if(HasGpuBuffer())
 					m_cpuPhysMemIsStale = true;
 			}
 		}
@@ -646,9 +796,10 @@ protected:
 			else
 			{
 				//If we have an existing buffer with valid content, save it and copy content over
-				if( (m_gpuPhysMem != nullptr) && !m_gpuPhysMemIsStale && (m_size != 0))
+				if( HasGpuBuffer() && !m_gpuPhysMemIsStale && (m_size != 0))
 				{
 					auto pOld = std::move(m_gpuPhysMem);
+					auto aOld = std::move(m_gpuArenaBlock);
 					//auto type = m_gpuMemoryType;
 					auto bOld = std::move(m_gpuBuffer);
 
@@ -667,6 +818,9 @@ protected:
 
 					//make sure buffer is freed before underlying physical memory (pOld) goes out of scope
 					bOld = nullptr;
+
+					if(BufferAllocationRegistry::IsEnabled())
+						BufferAllocationRegistry::OnFree(m_name, m_capacity * sizeof(T));
 				}
 
 				//Nope, just allocate a new buffer
@@ -684,7 +838,7 @@ protected:
 		}
 
 		//Existing GPU buffer we never expect to use again - needs to be freed
-		else if(m_gpuPhysMem != nullptr)
+		else if(HasGpuBuffer())
 			FreeGpuBuffer();
 
 		//We are never going to use the buffer on the GPU, but don't have any existing GPU memory
@@ -798,6 +952,48 @@ public:
 		MarkModifiedFromCpu();
 	}
 
+	/**
+		@brief Removes the first n items in the container in a single pass
+
+		Much cheaper than n calls to pop_front() for windowed eviction from a rolling buffer:
+		the retained elements are moved once per batch, not once per evicted element.
+
+		TODO: GPU implementation of this?
+	 */
+	void pop_front_n(size_t n)
+	{
+		if(n == 0)
+			return;
+
+		//No need to move data if evicting everything
+		if(n >= m_size)
+		{
+			clear();
+			return;
+		}
+
+		//Don't touch GPU side buffer
+
+		PrepareForCpuAccess();
+
+		size_t nleft = m_size - n;
+
+		//non-trivially-copyable types have to be copied one at a time
+		if(!std::is_trivially_copyable<T>::value)
+		{
+			for(size_t i=0; i<nleft; i++)
+				m_cpuPtr[i] = std::move(m_cpuPtr[i+n]);
+		}
+
+		//Trivially copyable types can be done more efficiently in a block
+		else
+			memmove(m_cpuPtr, m_cpuPtr+n, sizeof(T) * nleft);
+
+		resize(nleft);
+
+		MarkModifiedFromCpu();
+	}
+
 	AcceleratorBufferIterator<T> begin()
 	{ return AcceleratorBufferIterator<T>(*this, 0); }
 
@@ -898,8 +1094,17 @@ public:
 	 */
 	void PrepareForGpuAccess(bool outputOnly = false)
 	{
-		//Early out if no content or if unified memory
-		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
+		//Early out if no content
+		if(m_size == 0)
+			return;
+
+		//A borrowed view aliases another buffer's storage and has no Vulkan buffer object of its own,
+		//so detach into a GPU-capable private copy before the GPU touches it
+		if(m_cpuPtrIsBorrowed)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//Early out if unified memory
+		if(g_vulkanDeviceHasUnifiedMemory)
 			return;
 
 		//If our current hint has no GPU access at all, update to say "unlikely" and reallocate
@@ -915,6 +1120,46 @@ public:
 			CopyToGpu();
 	}
 
+	/**
+		@brief Prepares the buffer to be accessed from the GPU, starting any needed copy asynchronously.
+
+		The copy runs on a dedicated transfer queue and overlaps with CPU work and compute on other buffers.
+		The buffer must not be resized, freed, or accessed from the GPU until the returned transfer handle has
+		been passed to WaitForAsyncTransfer(). Falls back to a blocking copy if the device has no timeline
+		semaphore support.
+
+		@return Handle to pass to WaitForAsyncTransfer() / IsAsyncTransferDone(). May be 0 (already complete)
+				if no copy was needed or the blocking fallback was taken.
+	 */
+	uint64_t PrepareForGpuAccessAsync(bool outputOnly = false)
+	{
+		//Early out if no content
+		if(m_size == 0)
+			return 0;
+
+		//A borrowed view aliases another buffer's storage and has no Vulkan buffer object of its own,
+		//so detach into a GPU-capable private copy before the GPU touches it
+		if(m_cpuPtrIsBorrowed)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//Early out if unified memory
+		if(g_vulkanDeviceHasUnifiedMemory)
+			return 0;
+
+		//If our current hint has no GPU access at all, update to say "unlikely" and reallocate
+		if(m_gpuAccessHint == HINT_NEVER)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//If we don't have a buffer, allocate one unless our CPU buffer is pinned and GPU-readable
+		if(!HasGpuBuffer() && (m_cpuMemoryType != MEM_TYPE_CPU_DMA_CAPABLE) )
+			AllocateGpuBuffer(m_capacity);
+
+		//Kick off the copy if the GPU-side buffer is out of date
+		if(m_gpuPhysMemIsStale && !outputOnly)
+			return CopyToGpuAsync();
+		return 0;
+	}
+
 	/**
 		@brief Prepares the buffer to be accessed from the GPU
 
@@ -925,8 +1170,17 @@ public:
 	 */
 	void PrepareForGpuAccessNonblocking(bool outputOnly, vk::raii::CommandBuffer& cmdBuf)
 	{
-		//Early out if no content or if unified memory
-		if(m_size == 0 || g_vulkanDeviceHasUnifiedMemory)
+		//Early out if no content
+		if(m_size == 0)
+			return;
+
+		//A borrowed view aliases another buffer's storage and has no Vulkan buffer object of its own,
+		//so detach into a GPU-capable private copy before the GPU touches it
+		if(m_cpuPtrIsBorrowed)
+			SetGpuAccessHint(HINT_UNLIKELY, true);
+
+		//Early out if unified memory
+		if(g_vulkanDeviceHasUnifiedMemory)
 			return;
 
 		//If our current hint has no GPU access at all, update to say "unlikely" and reallocate
@@ -965,6 +1219,7 @@ protected:
 		//Submit the request and block until it completes
 		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
+		g_bufferPerfCounters.m_bytesToCpu += m_size * sizeof(T);
 		m_cpuPhysMemIsStale = false;
 	}
 
@@ -975,6 +1230,15 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		//BAR-mapped destination: write straight into VRAM, no staging hop
+		if(m_gpuMappedPtr != nullptr)
+		{
+			memcpy(m_gpuMappedPtr, m_cpuPtr, m_size * sizeof(T));
+			g_bufferPerfCounters.m_bytesToGpu += m_size * sizeof(T);
+			m_gpuPhysMemIsStale = false;
+			return;
+		}
+
 		std::lock_guard<std::mutex> lock(g_vkTransferMutex);
 
 		//Make the transfer request
@@ -986,10 +1250,40 @@ protected:
 		//Submit the request and block until it completes
 		g_vkTransferQueue->SubmitAndBlock(*g_vkTransferCommandBuffer);
 
+		g_bufferPerfCounters.m_bytesToGpu += m_size * sizeof(T);
 		m_gpuPhysMemIsStale = false;
 	}
 
 
+	/**
+		@brief Copy the buffer contents from CPU to GPU asynchronously on the dedicated transfer queue.
+
+		@return Handle to pass to WaitForAsyncTransfer() before the GPU-side buffer may be used
+	 */
+	uint64_t CopyToGpuAsync()
+	{
+		assert(std::is_trivially_copyable<T>::value);
+
+		//BAR-mapped destination: the memcpy completes synchronously, nothing to wait on
+		if(m_gpuMappedPtr != nullptr)
+		{
+			CopyToGpu();
+			return 0;
+		}
+
+		//No async transfer support? Do it the slow way
+		if(!g_hasTimelineSemaphores)
+		{
+			CopyToGpu();
+			return 0;
+		}
+
+		auto handle = SubmitAsyncTransfer(**m_cpuBuffer, **m_gpuBuffer, m_size * sizeof(T));
+		g_bufferPerfCounters.m_bytesToGpu += m_size * sizeof(T);
+		m_gpuPhysMemIsStale = false;
+		return handle;
+	}
+
 	/**
 		@brief Copy the buffer contents from CPU to GPU without blocking on the CPU.
 
@@ -999,6 +1293,17 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		//BAR-mapped destination: write straight into VRAM.
+		//Host writes made before the command buffer is submitted are visible to the device
+		//without an explicit barrier, so there's nothing to record.
+		if(m_gpuMappedPtr != nullptr)
+		{
+			memcpy(m_gpuMappedPtr, m_cpuPtr, m_size * sizeof(T));
+			g_bufferPerfCounters.m_bytesToGpu += m_size * sizeof(T);
+			m_gpuPhysMemIsStale = false;
+			return;
+		}
+
 		//Make the transfer request
 		vk::BufferCopy region(0, 0, m_size * sizeof(T));
 		cmdBuf.copyBuffer(**m_cpuBuffer, **m_gpuBuffer, {region});
@@ -1014,6 +1319,7 @@ protected:
 			{},
 			{});
 
+		g_bufferPerfCounters.m_bytesToGpu += m_size * sizeof(T);
 		m_gpuPhysMemIsStale = false;
 	}
 public:
@@ -1057,7 +1363,15 @@ protected:
 		m_cpuBuffer = nullptr;
 
 		//Free the buffer and unmap any memory
-		FreeCpuPointer(m_cpuPtr, m_cpuPhysMem, m_cpuMemoryType, m_capacity);
+		//(if the pointer is borrowed from another buffer it's not ours to free)
+		if(m_cpuPtrIsBorrowed)
+			m_cpuPtrIsBorrowed = false;
+		else
+		{
+			if(BufferAllocationRegistry::IsEnabled())
+				BufferAllocationRegistry::OnFree(m_name, m_capacity * sizeof(T));
+			FreeCpuPointer(m_cpuPtr, m_cpuPhysMem, m_cpuMemoryType, m_capacity);
+		}
 
 		//Mark CPU-side buffer as empty
 		m_cpuPtr = nullptr;
@@ -1083,7 +1397,7 @@ public:
 	void FreeGpuBuffer(bool dataLossOK = false)
 	{
 		//Early out if buffer is already null
-		if(m_gpuPhysMem == nullptr)
+		if(!HasGpuBuffer())
 			return;
 
 		//If we do NOT have a CPU-side buffer, we're deleting all of our data! Warn for now
@@ -1096,8 +1410,15 @@ public:
 		if( (m_cpuMemoryType != MEM_TYPE_NULL) && m_cpuPhysMemIsStale && !empty() )
 			CopyToCpu();
 
+		if(BufferAllocationRegistry::IsEnabled())
+			BufferAllocationRegistry::OnFree(m_name, m_capacity * sizeof(T));
+
+		//Freeing the device memory implicitly unmaps any BAR mapping
+		m_gpuMappedPtr = nullptr;
+
 		m_gpuBuffer = nullptr;
 		m_gpuPhysMem = nullptr;
+		m_gpuArenaBlock = nullptr;
 		m_gpuMemoryType = MEM_TYPE_NULL;
 	}
 
@@ -1115,6 +1436,10 @@ protected:
 		if(size == 0)
 			LogFatal("AllocateCpuBuffer with size zero (invalid)\n");
 
+		g_bufferPerfCounters.m_allocations ++;
+		if(BufferAllocationRegistry::IsEnabled())
+			BufferAllocationRegistry::OnCpuAllocation(m_name, size * sizeof(T));
+
 		//If any GPU access is expected, use pinned memory so we don't have to move things around
 		if(m_gpuAccessHint != HINT_NEVER)
 		{
@@ -1292,6 +1617,9 @@ protected:
 	{
 		assert(std::is_trivially_copyable<T>::value);
 
+		g_bufferPerfCounters.m_allocations ++;
+		bool audit = BufferAllocationRegistry::IsEnabled();
+
 		//Make a Vulkan buffer first
 		vk::BufferCreateInfo bufinfo(
 			{},
@@ -1305,8 +1633,65 @@ protected:
 		//(may be rounded up from what we asked for)
 		auto req = m_gpuBuffer->getMemoryRequirements();
 
+		//Any previous mapping belonged to the old physical memory, which is gone (or going away)
+		m_gpuMappedPtr = nullptr;
+
+		//Try to sub-allocate from the global arena first, so small buffers share a few big slabs
+		//rather than burning one of the (limited) device memory allocations each
+		if(g_gpuMemoryArena != nullptr)
+		{
+			m_gpuArenaBlock = g_gpuMemoryArena->Allocate(req);
+			if(m_gpuArenaBlock != nullptr)
+			{
+				m_gpuMemoryType = MEM_TYPE_GPU_ONLY;
+				m_gpuBuffer->bindMemory(m_gpuArenaBlock->GetMemory(), m_gpuArenaBlock->GetOffset());
+
+				if(audit)
+					BufferAllocationRegistry::OnGpuAllocation(m_name, size * sizeof(T), true);
+
+				if(g_hasDebugUtils)
+					UpdateGpuNames();
+				return;
+			}
+		}
+
+		//On systems with resizable BAR, put buffers the CPU writes and shaders consume in host-mappable VRAM.
+		//The CPU then writes samples straight into device memory and the staging copy disappears entirely
+		//(see CopyToGpu). Readbacks stay on the DMA engine since uncached reads through the BAR are slow.
+		//Not worthwhile for buffers the CPU rarely or never touches; those keep plain device-local memory.
+		if(g_hasResizableBar && (m_cpuAccessHint == HINT_LIKELY) && (m_gpuAccessHint != HINT_NEVER) )
+		{
+			try
+			{
+				vk::MemoryAllocateInfo barinfo(req.size, g_vkBarMemoryType);
+				m_gpuPhysMem = std::make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, barinfo);
+				m_gpuMappedPtr = reinterpret_cast<T*>(m_gpuPhysMem->mapMemory(0, req.size));
+				m_gpuMemoryType = MEM_TYPE_GPU_DMA_CAPABLE;
+				m_gpuBuffer->bindMemory(**m_gpuPhysMem, 0);
+
+				if(audit)
+					BufferAllocationRegistry::OnGpuAllocation(m_name, size * sizeof(T), false);
+
+				if(g_hasDebugUtils)
+					UpdateGpuNames();
+				return;
+			}
+			catch(vk::OutOfDeviceMemoryError& ex)
+			{
+				//BAR heap is full, fall through to a regular device-local allocation
+				m_gpuPhysMem = nullptr;
+			}
+		}
+
 		//Try to allocate the memory
 		vk::MemoryAllocateInfo info(req.size, g_vkLocalMemoryType);
+
+		//Tell the driver how reluctant to be about demoting this allocation to host memory under VRAM pressure.
+		//Buffers we expect shaders to hit every refresh are costlier to re-migrate than occasional-use ones.
+		vk::MemoryPriorityAllocateInfoEXT prioInfo( (m_gpuAccessHint == HINT_LIKELY) ? 0.75f : 0.5f );
+		if(g_hasMemoryPriority)
+			info.pNext = &prioInfo;
+
 		try
 		{
 			//For now, always use local memory
@@ -1368,6 +1753,9 @@ protected:
 
 		m_gpuBuffer->bindMemory(**m_gpuPhysMem, 0);
 
+		if(audit)
+			BufferAllocationRegistry::OnGpuAllocation(m_name, size * sizeof(T), false);
+
 		if(g_hasDebugUtils)
 			UpdateGpuNames();
 	}
@@ -1397,11 +1785,15 @@ protected:
 				reinterpret_cast<uint64_t>(static_cast<VkBuffer>(**m_gpuBuffer)),
 				gpuBufName.c_str()));
 
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eDeviceMemory,
-				reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**m_gpuPhysMem)),
-				gpuPhysName.c_str()));
+		//Don't rename the physical memory if it's an arena slab shared with other buffers
+		if(m_gpuPhysMem != nullptr)
+		{
+			g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+				vk::DebugUtilsObjectNameInfoEXT(
+					vk::ObjectType::eDeviceMemory,
+					reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**m_gpuPhysMem)),
+					gpuPhysName.c_str()));
+		}
 	}
 
 	/**
@@ -801,7 +801,7 @@ bool AgilentOscilloscope::AcquireData()
 		for (size_t j = 0; j < m_channels.size(); j++)
 			if(IsChannelEnabled(j) && pending_waveforms.find(j) != pending_waveforms.end())
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
@@ -41,6 +41,110 @@
 #include <windows.h>
 #endif
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+	@brief Preferred NUMA node for memory allocated by the calling thread (-1 = no preference)
+
+	Set by FilterGraphExecutor when NUMA pinning is enabled, so buffers allocated by a worker thread
+	land on the node its CPU belongs to instead of wherever the first-touch happens to fall.
+
+	@ingroup core
+ */
+extern thread_local int g_numaPreferredNode;
+
+#ifdef __linux__
+/**
+	@brief Requests that pages in the given range be allocated from a specific NUMA node when first touched
+
+	Uses a raw mbind() syscall with MPOL_PREFERRED so we don't need a libnuma dependency; the kernel
+	falls back to other nodes if the preferred one is full. Non-page-aligned ranges and failures are
+	silently ignored (the allocation still works, just without locality).
+
+	@ingroup core
+ */
+inline void BindToNumaNode(void* p, size_t len, int node)
+{
+	#ifdef SYS_mbind
+	if( (node < 0) || (node >= 64) )
+		return;
+	if(reinterpret_cast<uintptr_t>(p) & (sysconf(_SC_PAGESIZE) - 1))
+		return;
+
+	const int MBIND_MPOL_PREFERRED = 1;
+	unsigned long nodemask = 1UL << node;
+	syscall(SYS_mbind, p, len, MBIND_MPOL_PREFERRED, &nodemask, 64UL, 0UL);
+	#else
+	(void)p;
+	(void)len;
+	(void)node;
+	#endif
+}
+
+/**
+	@brief Size of a transparent hugepage on x86-64 and AArch64, in bytes
+
+	@ingroup core
+ */
+constexpr size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+	@brief Allocations at least this many bytes get a dedicated hugepage-hinted mapping
+
+	Smaller blocks would waste most of the 2M rounding and don't touch enough pages for
+	TLB pressure to matter.
+
+	@ingroup core
+ */
+constexpr size_t HUGEPAGE_THRESHOLD = HUGEPAGE_SIZE;
+
+///@brief Rounds a byte count up to a whole number of hugepages
+inline size_t RoundUpToHugepage(size_t n)
+{
+	if(n % HUGEPAGE_SIZE)
+		n = (n | (HUGEPAGE_SIZE - 1)) + 1;
+	return n;
+}
+
+/**
+	@brief Maps an anonymous 2M-aligned block and asks the kernel to back it with transparent hugepages
+
+	mmap() only guarantees 4K alignment, so over-map by one hugepage and trim the unaligned head and tail.
+	The MADV_HUGEPAGE hint is advisory: if THP is disabled system-wide the block still works, just on 4K pages.
+
+	@param nbytes	Size of the block, must be a multiple of HUGEPAGE_SIZE
+
+	@return Pointer to the block, or NULL on failure
+ */
+inline void* MapHugepageBlock(size_t nbytes)
+{
+	size_t nmap = nbytes + HUGEPAGE_SIZE;
+	void* raw = mmap(nullptr, nmap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(raw == MAP_FAILED)
+		return NULL;
+
+	auto base = reinterpret_cast<uintptr_t>(raw);
+	uintptr_t aligned = (base + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1);
+
+	//Trim the unaligned head and whatever is left over past the end
+	if(aligned != base)
+		munmap(raw, aligned - base);
+	size_t tail = (base + nmap) - (aligned + nbytes);
+	if(tail)
+		munmap(reinterpret_cast<void*>(aligned + nbytes), tail);
+
+	void* p = reinterpret_cast<void*>(aligned);
+	#ifdef MADV_HUGEPAGE
+	madvise(p, nbytes, MADV_HUGEPAGE);
+	#endif
+	return p;
+}
+#endif
+
 /**
 	@brief Aligned memory allocator for STL containers
 
@@ -174,6 +278,36 @@ public:
 		//Do the actual allocation
 #ifdef _WIN32
 		T* ret = static_cast<T*>(_aligned_malloc(n*sizeof(T), alignment));
+#elif defined(__linux__)
+		T* ret;
+
+		//Big blocks get a dedicated 2M-aligned anonymous mapping hinted for transparent hugepages.
+		//Waveform sized buffers touch enough 4K pages that TLB misses show up hot in filter and export
+		//profiles; 2M pages cut the TLB footprint 512x, and the rounding waste is at most one hugepage.
+		//deallocate() recomputes the same size threshold to know which path a block came from.
+		if(n*sizeof(T) >= HUGEPAGE_THRESHOLD)
+		{
+			size_t nbytes = RoundUpToHugepage(n*sizeof(T));
+			ret = static_cast<T*>(MapHugepageBlock(nbytes));
+			if( (ret != NULL) && (g_numaPreferredNode >= 0) )
+				BindToNumaNode(ret, nbytes, g_numaPreferredNode);
+		}
+
+		//If the calling thread has a NUMA node preference, place large blocks on that node.
+		//mbind() needs page alignment, so over-align the allocation in that case (still satisfies our alignment).
+		//Small blocks aren't worth a syscall and policy churn per page.
+		else if( (g_numaPreferredNode >= 0) && (n*sizeof(T) >= 65536) )
+		{
+			size_t pagesize = sysconf(_SC_PAGESIZE);
+			size_t nbytes = n*sizeof(T);
+			if(nbytes % pagesize)
+				nbytes = (nbytes | (pagesize-1)) + 1;
+			ret = static_cast<T*>(aligned_alloc(pagesize, nbytes));
+			if(ret != NULL)
+				BindToNumaNode(ret, nbytes, g_numaPreferredNode);
+		}
+		else
+			ret = static_cast<T*>(aligned_alloc(alignment, n*sizeof(T)));
 #else
 		T* ret = static_cast<T*>(aligned_alloc(alignment, n*sizeof(T)));
 #endif
@@ -188,13 +322,26 @@ public:
 	/**
 		@brief	Free a block of memory
 
-		@param p		Block to free
-		@param unused	Size of block (ignored)
+		@param p	Block to free
+		@param n	Size passed to the matching allocate() call (used to detect hugepage-backed blocks)
 	 */
-	void deallocate(T* const p, [[maybe_unused]] const size_t unused) const
+	void deallocate(T* const p, [[maybe_unused]] const size_t n) const
 	{
 #ifdef _WIN32
 		_aligned_free(p);
+#elif defined(__linux__)
+		//Redo the rounding allocate() applied so the threshold test matches
+		size_t rounded = n;
+		if( (rounded % alignment) != 0)
+		{
+			rounded |= (alignment - 1);
+			rounded ++;
+		}
+
+		if(rounded*sizeof(T) >= HUGEPAGE_THRESHOLD)
+			munmap(p, RoundUpToHugepage(rounded*sizeof(T)));
+		else
+			free(p);
 #else
 		free(p);
 #endif
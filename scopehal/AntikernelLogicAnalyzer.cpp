@@ -416,7 +416,7 @@ bool AntikernelLogicAnalyzer::AcquireData()
 		}
 	}
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(pending_waveforms);
+	AddPendingWaveform(pending_waveforms);
 	m_pendingWaveformsMutex.unlock();
 
 	//Re-arm the trigger if not in one-shot mode
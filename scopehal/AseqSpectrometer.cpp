@@ -359,7 +359,7 @@ bool AseqSpectrometer::AcquireData()
 
 	//Save the waveforms to our queue
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 	m_pendingWaveformsMutex.unlock();
 
 	//Done, clean up
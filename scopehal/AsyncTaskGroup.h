@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AsyncTaskGroup
+	@ingroup core
+ */
+#ifndef AsyncTaskGroup_h
+#define AsyncTaskGroup_h
+
+#include <functional>
+#include <future>
+#include <vector>
+
+/**
+	@brief A group of background tasks which must all complete before some synchronization point
+	@ingroup core
+
+	Intended for overlapping CPU-bound work with I/O in instrument drivers: AcquireData() can hand the
+	parse/convert stage of one channel off to a task, then immediately start the transfer of the next channel
+	over the (inherently serial) SCPI link. Session code can use the same pattern to download from several
+	instruments concurrently.
+
+	The destructor waits for all outstanding tasks, so work submitted to a stack-local group can never outlive
+	the data it captures. Submitted tasks must not throw.
+ */
+class AsyncTaskGroup
+{
+public:
+	AsyncTaskGroup()
+	{}
+
+	~AsyncTaskGroup()
+	{ WaitAll(); }
+
+	//not copyable or assignable
+	AsyncTaskGroup(const AsyncTaskGroup&) =delete;
+	AsyncTaskGroup& operator=(const AsyncTaskGroup&) =delete;
+
+	/**
+		@brief Starts a task running in the background
+
+		@param fn	The work to run
+	 */
+	void Submit(std::function<void()> fn)
+	{ m_tasks.push_back(std::async(std::launch::async, std::move(fn))); }
+
+	///@brief Blocks until every submitted task has completed
+	void WaitAll()
+	{
+		for(auto& t : m_tasks)
+			t.wait();
+		m_tasks.clear();
+	}
+
+protected:
+	///@brief Completion handles of all submitted tasks
+	std::vector<std::future<void>> m_tasks;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of BufferAllocationRegistry
+	@ingroup core
+ */
+
+#include "scopehal.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+using namespace std;
+
+atomic<bool> BufferAllocationRegistry::m_enabled{false};
+mutex BufferAllocationRegistry::m_mutex;
+map<string, BufferAllocationStats> BufferAllocationRegistry::m_stats;
+
+/**
+	@brief Looks up (creating if necessary) the statistics entry for a tag
+
+	The caller must hold m_mutex.
+ */
+BufferAllocationStats& BufferAllocationRegistry::GetStats(const string& tag)
+{
+	if(tag.empty())
+	{
+		static const string unnamed = "(unnamed)";
+		return m_stats[unnamed];
+	}
+	return m_stats[tag];
+}
+
+///@brief Records a CPU-side physical allocation
+void BufferAllocationRegistry::OnCpuAllocation(const string& tag, size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto& st = GetStats(tag);
+	st.m_cpuAllocs ++;
+	st.m_bytesAllocated += bytes;
+	st.m_liveBytes += bytes;
+	if(st.m_liveBytes > (int64_t)st.m_peakLiveBytes)
+		st.m_peakLiveBytes = st.m_liveBytes;
+}
+
+///@brief Records a GPU-side physical allocation, noting whether the arena served it
+void BufferAllocationRegistry::OnGpuAllocation(const string& tag, size_t bytes, bool fromArena)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto& st = GetStats(tag);
+	st.m_gpuAllocs ++;
+	st.m_bytesAllocated += bytes;
+	st.m_liveBytes += bytes;
+	if(st.m_liveBytes > (int64_t)st.m_peakLiveBytes)
+		st.m_peakLiveBytes = st.m_liveBytes;
+	if(fromArena)
+		st.m_arenaHits ++;
+	else
+		st.m_arenaMisses ++;
+}
+
+///@brief Records a reallocation event (grow/shrink of an existing buffer, including the copy)
+void BufferAllocationRegistry::OnReallocation(const string& tag)
+{
+	lock_guard<mutex> lock(m_mutex);
+	GetStats(tag).m_reallocations ++;
+}
+
+///@brief Records a buffer free
+void BufferAllocationRegistry::OnFree(const string& tag, size_t bytes)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto& st = GetStats(tag);
+	st.m_frees ++;
+	st.m_liveBytes -= bytes;
+}
+
+///@brief Returns a copy of the current statistics for offline analysis
+map<string, BufferAllocationStats> BufferAllocationRegistry::GetSnapshot()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_stats;
+}
+
+///@brief Discards all collected statistics
+void BufferAllocationRegistry::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_stats.clear();
+}
+
+/**
+	@brief Logs a table of the collected statistics, sorted by cumulative bytes allocated
+
+	Tags responsible for the most allocation traffic come first, so the top of the table is where to look
+	when hunting churn.
+ */
+void BufferAllocationRegistry::Dump()
+{
+	auto snapshot = GetSnapshot();
+
+	vector<pair<string, BufferAllocationStats>> rows(snapshot.begin(), snapshot.end());
+	sort(rows.begin(), rows.end(),
+		[](const pair<string, BufferAllocationStats>& a, const pair<string, BufferAllocationStats>& b)
+		{ return a.second.m_bytesAllocated > b.second.m_bytesAllocated; });
+
+	Unit bytes(Unit::UNIT_BYTES);
+	LogNotice("Buffer allocation statistics (%zu tags)\n", rows.size());
+	LogIndenter li;
+	LogNotice("%-40s %10s %10s %10s %10s %12s %12s %8s\n",
+		"Tag", "CPU allocs", "GPU allocs", "Reallocs", "Frees", "Total", "Peak live", "Arena %");
+	for(auto& row : rows)
+	{
+		auto& st = row.second;
+		double arenaRate = 0;
+		if(st.m_arenaHits + st.m_arenaMisses)
+			arenaRate = 100.0 * st.m_arenaHits / (st.m_arenaHits + st.m_arenaMisses);
+		LogNotice("%-40s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %12s %12s %7.1f%%\n",
+			row.first.c_str(),
+			st.m_cpuAllocs,
+			st.m_gpuAllocs,
+			st.m_reallocations,
+			st.m_frees,
+			bytes.PrettyPrint(st.m_bytesAllocated).c_str(),
+			bytes.PrettyPrint(st.m_peakLiveBytes).c_str(),
+			arenaRate);
+	}
+}
@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of BufferAllocationRegistry
+	@ingroup core
+ */
+
+#ifndef BufferAllocationRegistry_h
+#define BufferAllocationRegistry_h
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+	@brief Aggregated allocation statistics for one buffer tag
+	@ingroup core
+ */
+struct BufferAllocationStats
+{
+	///@brief Number of CPU-side physical allocations
+	uint64_t m_cpuAllocs = 0;
+
+	///@brief Number of GPU-side physical allocations (arena or dedicated)
+	uint64_t m_gpuAllocs = 0;
+
+	///@brief Number of reallocation events (an existing buffer was resized, copying its contents)
+	uint64_t m_reallocations = 0;
+
+	///@brief Number of buffer frees
+	uint64_t m_frees = 0;
+
+	///@brief Cumulative bytes allocated over the lifetime of the program
+	uint64_t m_bytesAllocated = 0;
+
+	///@brief GPU allocations served by sub-allocating from the global memory arena
+	uint64_t m_arenaHits = 0;
+
+	///@brief GPU allocations that fell back to a dedicated device memory allocation
+	uint64_t m_arenaMisses = 0;
+
+	///@brief Bytes currently allocated
+	int64_t m_liveBytes = 0;
+
+	///@brief High-water mark of m_liveBytes
+	uint64_t m_peakLiveBytes = 0;
+};
+
+/**
+	@brief Global registry attributing AcceleratorBuffer allocation churn to individual buffers
+
+	Statistics are aggregated by buffer tag (the friendly name set with AcceleratorBuffer::SetName(), which
+	filters already use to identify their buffers to debug tools). Collection is off by default since every
+	allocation takes a global lock while it's on; enable it around the workload being investigated, then call
+	Dump() to log a table sorted by cumulative bytes, or GetSnapshot() to post-process the numbers elsewhere.
+
+	@ingroup core
+ */
+class BufferAllocationRegistry
+{
+public:
+	///@brief Turns statistics collection on or off (off by default)
+	static void SetEnabled(bool enabled)
+	{ m_enabled = enabled; }
+
+	///@brief Returns true if statistics collection is active
+	static bool IsEnabled()
+	{ return m_enabled; }
+
+	static void OnCpuAllocation(const std::string& tag, size_t bytes);
+	static void OnGpuAllocation(const std::string& tag, size_t bytes, bool fromArena);
+	static void OnReallocation(const std::string& tag);
+	static void OnFree(const std::string& tag, size_t bytes);
+
+	static std::map<std::string, BufferAllocationStats> GetSnapshot();
+	static void Clear();
+	static void Dump();
+
+protected:
+	static BufferAllocationStats& GetStats(const std::string& tag);
+
+	///@brief True if statistics are being collected
+	static std::atomic<bool> m_enabled;
+
+	///@brief Mutex protecting m_stats
+	static std::mutex m_mutex;
+
+	///@brief Statistics for each buffer tag
+	static std::map<std::string, BufferAllocationStats> m_stats;
+};
+
+#endif
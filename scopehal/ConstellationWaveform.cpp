@@ -50,6 +50,7 @@ ConstellationWaveform::ConstellationWaveform(size_t width, size_t height)
 {
 	size_t npix = width*height;
 	m_accumdata = new int64_t[npix];
+	m_accumCapacity = npix;
 	for(size_t i=0; i<npix; i++)
 		m_accumdata[i] = 0;
 }
@@ -60,6 +61,28 @@ ConstellationWaveform::~ConstellationWaveform()
 	m_accumdata = NULL;
 }
 
+/**
+	@brief Resizes the constellation in place and restarts integration, reusing existing allocations when possible
+
+	@param width	New bitmap width, in pixels
+	@param height	New bitmap height, in pixels
+ */
+void ConstellationWaveform::Resize(size_t width, size_t height)
+{
+	DensityFunctionWaveform::Resize(width, height);
+
+	size_t npix = width*height;
+	if(npix > m_accumCapacity)
+	{
+		delete[] m_accumdata;
+		m_accumdata = new int64_t[npix];
+		m_accumCapacity = npix;
+	}
+	memset(m_accumdata, 0, npix * sizeof(int64_t));
+
+	m_totalSymbols = 0;
+}
+
 /**
 	@brief Normalizes the waveform so that the output buffer has values in the range [0, 1].
 
@@ -91,6 +91,8 @@ public:
 	virtual bool HasGpuBuffer() override
 	{ return false; }
 
+	virtual void Resize(size_t width, size_t height) override;
+
 protected:
 
 	/**
@@ -100,6 +102,9 @@ protected:
 	 */
 	int64_t* m_accumdata;
 
+	///@brief Allocated size of m_accumdata, in pixels (may exceed width*height after an in-place shrink)
+	size_t m_accumCapacity;
+
 	///@brief The number of symbols which have been integrated so far
 	size_t m_totalSymbols;
 };
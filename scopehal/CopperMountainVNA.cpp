@@ -309,7 +309,7 @@ bool CopperMountainVNA::AcquireData()
 
 	//Save the waveforms to our queue
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 	m_pendingWaveformsMutex.unlock();
 
 	//If this was a one-shot trigger we're no longer armed
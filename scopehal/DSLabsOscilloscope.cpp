@@ -431,47 +431,53 @@ bool DSLabsOscilloscope::AcquireData()
 			cap->m_startFemtoseconds = fs;
 			cap->PrepareForCpuAccess();
 
-			//Preallocate memory assuming no deduplication possible
-			cap->Resize(memdepth * 8);
+			//First pass: count transitions so we can size the output exactly.
+			//A deep capture with few toggles needs entries proportional to the toggles, not the sample clock;
+			//sizing up front avoids a transient allocation of 8 entries per raw byte (gigabytes on long
+			//captures) that would immediately be thrown away again.
+			size_t nedges = 0;
+			uint8_t prev = buf[0] & 1;
+			for(size_t m=0; m<memdepth; m++)
+			{
+				uint8_t b = buf[m];
+
+				//XOR each bit with its predecessor: set bits mark value changes
+				nedges += __builtin_popcount( (uint32_t)(b ^ (uint8_t)((b << 1) | prev)) );
+				prev = b >> 7;
+			}
 
-			//First sample never gets deduplicated
+			//Second pass: emit one entry per run
+			cap->Resize(nedges + 1);
 			bool last = (buf[0] & 1) ? true : false;
 			size_t k = 0;
 			cap->m_offsets[0] = first_sample;
-			cap->m_durations[0] = 1;
 			cap->m_samples[0] = last;
-
-			//Read and de-duplicate the other samples
-			//TODO: can we vectorize this somehow?
-			for(size_t m=1; m<memdepth; m++)
+			for(size_t m=0; m<memdepth; m++)
 			{
-				for (int bit = 0; bit < 8; bit++)
-				{
-					bool sample = (buf[m] & (1 << bit)) ? true : false;
+				uint8_t b = buf[m];
 
-					//Deduplicate consecutive samples with same value
-					//FIXME: temporary workaround for rendering bugs
-					//if(last == sample)
-					if( (last == sample) && ((m+1) < memdepth) && (m > 0))
-						cap->m_durations[k] ++;
+				//Skip bytes with no transitions (the common case for RLE-friendly data)
+				if(b == (last ? 0xff : 0x00))
+					continue;
 
-					//Nope, it toggled - store the new value
-					else
+				for(int bit = 0; bit < 8; bit++)
+				{
+					bool sample = (b & (1 << bit)) ? true : false;
+					if(sample != last)
 					{
+						int64_t off = first_sample + (m * 8) + bit;
+						cap->m_durations[k] = off - cap->m_offsets[k];
 						k++;
-						cap->m_offsets[k] = first_sample + (m * 8) + bit;
-						cap->m_durations[k] = 1;
+						cap->m_offsets[k] = off;
 						cap->m_samples[k] = sample;
 						last = sample;
 					}
 				}
 			}
 
-			//Free space reclaimed by deduplication
-			cap->Resize(k);
-			cap->m_offsets.shrink_to_fit();
-			cap->m_durations.shrink_to_fit();
-			cap->m_samples.shrink_to_fit();
+			//Last run extends to the end of the capture
+			cap->m_durations[k] = (first_sample + memdepth*8) - cap->m_offsets[k];
+
 			cap->MarkSamplesModifiedFromCpu();
 			cap->MarkTimestampsModifiedFromCpu();
 
@@ -484,13 +490,7 @@ bool DSLabsOscilloscope::AcquireData()
 	for(size_t i=0; i<awfms.size(); i++)
 	{
 		auto cap = awfms[i];
-		cap->PrepareForCpuAccess();
-		ConvertUnsigned8BitSamples(
-			cap->m_samples.GetCpuPointer(),
-			abufs[i],
-			scales[i],
-			offsets[i],
-			cap->size());
+		cap->m_samples.CopyConvertFrom(abufs[i], cap->size(), scales[i], offsets[i]);
 		cap->MarkSamplesModifiedFromCpu();
 		delete[] abufs[i];
 	}
@@ -504,7 +504,7 @@ bool DSLabsOscilloscope::AcquireData()
 
 	//Save the waveforms to our queue
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 
 	while (m_pendingWaveforms.size() > 2)
 	{
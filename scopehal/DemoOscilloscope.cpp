@@ -602,7 +602,7 @@ bool DemoOscilloscope::AcquireData()
 	}
 
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 	m_pendingWaveformsMutex.unlock();
 
 	if(m_triggerOneShot)
@@ -48,6 +48,8 @@ DensityFunctionWaveform::DensityFunctionWaveform(size_t width, size_t height)
 	: m_width(width)
 	, m_height(height)
 	, m_outdata("DensityFunctionWaveform.m_outdata")
+	, m_mipdata("DensityFunctionWaveform.m_mipdata")
+	, m_mipChainDirty(true)
 {
 	//Default to CPU+GPU mirror
 	m_outdata.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -64,3 +66,161 @@ DensityFunctionWaveform::DensityFunctionWaveform(size_t width, size_t height)
 DensityFunctionWaveform::~DensityFunctionWaveform()
 {
 }
+
+/**
+	@brief Resizes the bitmap in place, reusing the existing allocation when possible
+
+	Pixel content is cleared to zero. Growing beyond the current buffer capacity reallocates; shrinking or
+	height-only changes reuse the existing memory, so interactive plot resizes don't thrash device memory.
+
+	@param width	New bitmap width, in pixels
+	@param height	New bitmap height, in pixels
+ */
+void DensityFunctionWaveform::Resize(size_t width, size_t height)
+{
+	m_width = width;
+	m_height = height;
+
+	size_t npix = width*height;
+	m_outdata.resize(npix);
+	m_outdata.PrepareForCpuAccess();
+	memset(m_outdata.GetCpuPointer(), 0, npix * sizeof(float));
+	m_outdata.MarkModifiedFromCpu();
+
+	//The old chain is for the old geometry
+	m_mipLevels.clear();
+	m_mipChainDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Level-of-detail mip chain
+
+/**
+	@brief Returns the number of levels in the mip chain, including the full resolution base level
+
+	Each level halves both dimensions (rounding down, with a floor of one pixel) until a 1x1 level is reached.
+ */
+size_t DensityFunctionWaveform::GetMipLevelCount()
+{
+	size_t levels = 1;
+	size_t w = m_width;
+	size_t h = m_height;
+	while( (w > 1) || (h > 1) )
+	{
+		w = std::max(w >> 1, (size_t)1);
+		h = std::max(h >> 1, (size_t)1);
+		levels ++;
+	}
+	return levels;
+}
+
+/**
+	@brief Returns the index of the coarsest mip level that still meets or exceeds the target dimensions
+
+	Consumers drawing the bitmap at a reduced size (zoomed-out spectrograms, thumbnails, etc) should ask for
+	the size they intend to display at, then read that level instead of the full resolution grid. The chosen
+	level is always at least as large as the target, so they downsample slightly rather than upscale.
+
+	@param targetWidth	Width the bitmap will be displayed or processed at, in pixels
+	@param targetHeight	Height the bitmap will be displayed or processed at, in pixels
+ */
+size_t DensityFunctionWaveform::GetBestMipLevel(size_t targetWidth, size_t targetHeight)
+{
+	size_t nlevels = GetMipLevelCount();
+	size_t best = 0;
+	for(size_t i=1; i<nlevels; i++)
+	{
+		if( (GetMipWidth(i) >= targetWidth) && (GetMipHeight(i) >= targetHeight) )
+			best = i;
+		else
+			break;
+	}
+	return best;
+}
+
+/**
+	@brief Returns a pointer to the CPU-side pixel data for one mip level, building the chain if stale
+
+	Level 0 aliases the full resolution bitmap. Pixels are row major, GetMipWidth(level) by GetMipHeight(level).
+
+	@param level	Mip level to fetch (see GetBestMipLevel() )
+ */
+float* DensityFunctionWaveform::GetMipData(size_t level)
+{
+	if(level == 0)
+		return GetData();
+
+	RefreshMipChain();
+
+	if(level >= m_mipLevels.size())
+		return nullptr;
+
+	m_mipdata.PrepareForCpuAccess();
+	return m_mipdata.GetCpuPointer() + m_mipLevels[level].m_offset;
+}
+
+/**
+	@brief Rebuilds the mip chain from the full resolution bitmap if it has changed since the last build
+
+	Each level is a 2x2 box filter reduction of the previous one, so the whole chain costs about a third of
+	the base bitmap in both memory and build time. The build is skipped entirely when nothing was modified
+	since the previous call.
+ */
+void DensityFunctionWaveform::RefreshMipChain()
+{
+	size_t nlevels = GetMipLevelCount();
+	if(!m_mipChainDirty && (m_mipLevels.size() == nlevels) )
+		return;
+	m_mipChainDirty = false;
+
+	//Lay out the chain
+	m_mipLevels.clear();
+	MipLevel base;
+	base.m_width = m_width;
+	base.m_height = m_height;
+	base.m_offset = 0;
+	m_mipLevels.push_back(base);
+	size_t totalpix = 0;
+	for(size_t i=1; i<nlevels; i++)
+	{
+		MipLevel lvl;
+		lvl.m_width = GetMipWidth(i);
+		lvl.m_height = GetMipHeight(i);
+		lvl.m_offset = totalpix;
+		totalpix += lvl.m_width * lvl.m_height;
+		m_mipLevels.push_back(lvl);
+	}
+
+	m_mipdata.resize(totalpix);
+	m_mipdata.PrepareForCpuAccess();
+	m_outdata.PrepareForCpuAccess();
+	auto pmip = m_mipdata.GetCpuPointer();
+
+	//Reduce each level from the one above it with a 2x2 box filter
+	for(size_t i=1; i<nlevels; i++)
+	{
+		auto& dst = m_mipLevels[i];
+		auto& src = m_mipLevels[i-1];
+		const float* psrc = (i == 1) ? m_outdata.GetCpuPointer() : (pmip + src.m_offset);
+		float* pdst = pmip + dst.m_offset;
+
+		#pragma omp parallel for
+		for(int64_t y=0; y<(int64_t)dst.m_height; y++)
+		{
+			size_t y0 = std::min(2*(size_t)y, src.m_height - 1);
+			size_t y1 = std::min(2*(size_t)y + 1, src.m_height - 1);
+			const float* row0 = psrc + y0*src.m_width;
+			const float* row1 = psrc + y1*src.m_width;
+			float* rowout = pdst + y*dst.m_width;
+
+			for(size_t x=0; x<dst.m_width; x++)
+			{
+				size_t x0 = std::min(2*x, src.m_width - 1);
+				size_t x1 = std::min(2*x + 1, src.m_width - 1);
+				rowout[x] = (row0[x0] + row0[x1] + row1[x0] + row1[x1]) * 0.25f;
+			}
+		}
+	}
+
+	m_mipdata.MarkModifiedFromCpu();
+}
@@ -38,6 +38,7 @@
 #ifndef DensityFunctionWaveform_h
 #define DensityFunctionWaveform_h
 
+#include <algorithm>
 #include "Waveform.h"
 
 /**
@@ -63,14 +64,14 @@ public:
 	{}
 
 	///@brief Returns a pointer to the CPU-side sample data buffer
-	float* GetData()
+	virtual float* GetData()
 	{
 		m_outdata.PrepareForCpuAccess();
 		return m_outdata.GetCpuPointer();
 	}
 
 	///@brief Returns a reference to the output data buffer object
-	AcceleratorBuffer<float>& GetOutData()
+	virtual AcceleratorBuffer<float>& GetOutData()
 	{ return m_outdata; }
 
 	///@brief Returns the height of the bitmap in pixels
@@ -88,6 +89,8 @@ public:
 	virtual void Resize([[maybe_unused]] size_t unused) override
 	{}
 
+	virtual void Resize(size_t width, size_t height);
+
 	virtual void PrepareForCpuAccess() override
 	{ m_outdata.PrepareForCpuAccess(); }
 
@@ -95,23 +98,53 @@ public:
 	{ m_outdata.PrepareForGpuAccess();}
 
 	virtual void MarkSamplesModifiedFromCpu() override
-	{ m_outdata.MarkModifiedFromCpu(); }
+	{
+		m_outdata.MarkModifiedFromCpu();
+		m_mipChainDirty = true;
+	}
 
 	virtual void MarkSamplesModifiedFromGpu() override
-	{ m_outdata.MarkModifiedFromGpu(); }
+	{
+		m_outdata.MarkModifiedFromGpu();
+		m_mipChainDirty = true;
+	}
 
 	virtual void MarkModifiedFromCpu() override
-	{ m_outdata.MarkModifiedFromCpu(); }
+	{
+		m_outdata.MarkModifiedFromCpu();
+		m_mipChainDirty = true;
+	}
 
 	virtual void MarkModifiedFromGpu() override
-	{ m_outdata.MarkModifiedFromGpu(); }
+	{
+		m_outdata.MarkModifiedFromGpu();
+		m_mipChainDirty = true;
+	}
 
 	//we have no linear sample buffer so return 0
 	virtual size_t size() const override
 	{ return 0; }
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Level-of-detail mip chain
+
+	size_t GetMipLevelCount();
+	size_t GetBestMipLevel(size_t targetWidth, size_t targetHeight);
+
+	float* GetMipData(size_t level);
+
+	///@brief Returns the width of a mip level, in pixels (level 0 is the full resolution bitmap)
+	size_t GetMipWidth(size_t level)
+	{ return std::max(m_width >> level, (size_t)1); }
+
+	///@brief Returns the height of a mip level, in pixels (level 0 is the full resolution bitmap)
+	size_t GetMipHeight(size_t level)
+	{ return std::max(m_height >> level, (size_t)1); }
+
 protected:
 
+	void RefreshMipChain();
+
 	///@brief Buffer width, in pixels
 	size_t m_width;
 
@@ -120,6 +153,28 @@ protected:
 
 	///@brief Pixel buffer
 	AcceleratorBuffer<float> m_outdata;
+
+	///@brief Geometry of one level of the mip chain
+	struct MipLevel
+	{
+		///@brief Level width, in pixels
+		size_t m_width;
+
+		///@brief Level height, in pixels
+		size_t m_height;
+
+		///@brief Index of the first pixel of this level within m_mipdata (unused for level 0)
+		size_t m_offset;
+	};
+
+	///@brief Geometry of each level of the mip chain (empty if never built)
+	std::vector<MipLevel> m_mipLevels;
+
+	///@brief Reduced-resolution pixel data for mip levels 1 and up, packed end to end
+	AcceleratorBuffer<float> m_mipdata;
+
+	///@brief True if the pixel data has changed since the mip chain was last built
+	bool m_mipChainDirty;
 };
 
 #endif
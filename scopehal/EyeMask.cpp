@@ -305,3 +305,93 @@ float EyeMask::CalculateHitRate(
 		return nmax;
 	}
 }
+
+/**
+	@brief Checks a raw eye pattern dataset against the mask, doing the bulk of the work on the GPU
+
+	The mask polygons are rasterized once (on first use, or when the plot geometry changes) into a per-pixel
+	coverage buffer. Each trigger then ANDs the coverage against the eye accumulator and reduces per-workgroup
+	hit counts on the GPU, so only a tiny partial-sum buffer comes back to the CPU and a per-trigger pass/fail
+	verdict doesn't require walking the whole integration buffer host side.
+
+	BER-type eyes take the serial path, since their verdict is a max over float BER values rather than a hit count.
+ */
+float EyeMask::CalculateHitRate(
+	EyeWaveform* cap,
+	size_t width,
+	size_t height,
+	float fullscalerange,
+	float xscale,
+	float xoff,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if( (cap->GetType() != EyeWaveform::EYE_NORMAL) || !g_gpuFilterEnabled )
+		return CalculateHitRate(cap, width, height, fullscalerange, xscale, xoff);
+
+	//Re-rasterize the mask if the plot geometry changed
+	if(!m_canvas || (m_width != width) || (m_height != height))
+	{
+		m_width = width;
+		m_height = height;
+		m_canvas = std::make_unique< canvas_ity::canvas >( width, height );
+
+		//Software rendering
+		float yscale = height / fullscalerange;
+		RenderForAnalysis(
+			cap,
+			xscale,
+			xoff,
+			yscale,
+			0,
+			height);
+	}
+
+	//Convert the rasterization to a per-pixel coverage buffer for the shader
+	size_t npixels = width * height;
+	if(m_maskPixels.size() != npixels)
+	{
+		vector<uint8_t> image_data(npixels*4);
+		m_canvas->get_image_data(image_data.data(), width, height, m_width*4, 0,0);
+
+		m_maskPixels.resize(npixels);
+		m_maskPixels.PrepareForCpuAccess();
+		uint32_t* data = reinterpret_cast<uint32_t*>(&image_data[0]);
+		for(size_t i=0; i<npixels; i++)
+			m_maskPixels[i] = (data[i] & 0xff) ? 1 : 0;
+		m_maskPixels.MarkModifiedFromCpu();
+	}
+
+	//Create the pipeline on first use
+	if(!m_hitTestPipeline)
+	{
+		m_hitTestPipeline = make_unique<ComputePipeline>(
+			"shaders/EyeMaskHitTest.spv", 3, sizeof(EyeMaskHitTestArgs));
+
+		m_partialHits.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+		m_partialHits.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+	}
+
+	size_t nblocks = GetComputeBlockCount(npixels, HITTEST_BLOCK);
+	m_partialHits.resize(nblocks);
+
+	//Mask the accumulator and reduce per-workgroup hit counts
+	EyeMaskHitTestArgs args;
+	args.size = npixels;
+	cmdBuf.begin({});
+	m_hitTestPipeline->BindBufferNonblocking(0, cap->GetAccumBuffer(), cmdBuf);
+	m_hitTestPipeline->BindBufferNonblocking(1, m_maskPixels, cmdBuf);
+	m_hitTestPipeline->BindBufferNonblocking(2, m_partialHits, cmdBuf, true);
+	m_hitTestPipeline->Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_partialHits.MarkModifiedFromGpu();
+
+	//Final reduction of the per-workgroup partials
+	m_partialHits.PrepareForCpuAccess();
+	int64_t nhits = 0;
+	for(size_t i=0; i<nblocks; i++)
+		nhits += m_partialHits[i];
+
+	return nhits * 1.0 / (cap->GetTotalSamples() * EYE_ACCUM_SCALE);
+}
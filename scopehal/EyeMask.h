@@ -39,9 +39,17 @@
 
 #include "../canvas_ity/src/canvas_ity.hpp"
 
+#include "../scopehal/ComputePipeline.h"
+#include "../scopehal/QueueManager.h"
+
 class EyeDecoder2;
 class EyeWaveform;
 
+struct EyeMaskHitTestArgs
+{
+	uint32_t size;
+};
+
 /**
 	@brief A single point within an EyeMaskPolygon
 	@ingroup datamodel
@@ -136,6 +144,16 @@ public:
 		float xscale,
 		float xoff);
 
+	float CalculateHitRate(
+		EyeWaveform* cap,
+		size_t width,
+		size_t height,
+		float fullscalerange,
+		float xscale,
+		float xoff,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	///@brief Return true if there are no polygons in the mask
 	bool empty() const
 	{ return m_polygons.empty(); }
@@ -195,6 +213,18 @@ protected:
 
     ///@brief Current height
     size_t m_height;
+
+	///@brief Mask coverage per pixel of the rasterization (1 = inside a mask polygon), for GPU hit testing
+	AcceleratorBuffer<uint32_t> m_maskPixels;
+
+	///@brief Per-workgroup hit count partial sums from the hit test shader
+	AcceleratorBuffer<int64_t> m_partialHits;
+
+	///@brief Compute pipeline for GPU hit testing (created on first use)
+	std::unique_ptr<ComputePipeline> m_hitTestPipeline;
+
+	///@brief Number of pixels reduced by each workgroup of the hit test shader
+	static const size_t HITTEST_BLOCK = 256;
 };
 
 #endif
@@ -63,16 +63,49 @@ EyeWaveform::EyeWaveform(size_t width, size_t height, float center, EyeType etyp
 	, m_maskHitRate(0)
 	, m_type(etype)
 {
+	m_accumdata.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+	m_accumdata.SetGpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
+
 	size_t npix = width*height;
-	m_accumdata = new int64_t[npix];
-	for(size_t i=0; i<npix; i++)
-		m_accumdata[i] = 0;
+	m_accumdata.resize(npix);
+	m_accumdata.PrepareForCpuAccess();
+	memset(m_accumdata.GetCpuPointer(), 0, npix * sizeof(int64_t));
+	m_accumdata.MarkModifiedFromCpu();
+
+	m_normalizationDirty = false;
+	m_rowMax.resize(height, 0);
+	m_dirtyRowStart = 0;
+	m_dirtyRowEnd = height - 1;
 }
 
 EyeWaveform::~EyeWaveform()
 {
-	delete[] m_accumdata;
-	m_accumdata = NULL;
+}
+
+/**
+	@brief Resizes the eye in place and restarts integration, reusing existing allocations when possible
+
+	@param width	New bitmap width, in pixels
+	@param height	New bitmap height, in pixels
+ */
+void EyeWaveform::Resize(size_t width, size_t height)
+{
+	DensityFunctionWaveform::Resize(width, height);
+
+	size_t npix = width*height;
+	m_accumdata.resize(npix);
+	m_accumdata.PrepareForCpuAccess();
+	memset(m_accumdata.GetCpuPointer(), 0, npix * sizeof(int64_t));
+	m_accumdata.MarkModifiedFromCpu();
+
+	m_uiWidth = 0;
+	m_totalUIs = 0;
+	m_totalSamples = 0;
+
+	m_normalizationDirty = false;
+	m_rowMax.assign(height, 0);
+	m_dirtyRowStart = 0;
+	m_dirtyRowEnd = height - 1;
 }
 
 /**
@@ -80,35 +113,88 @@ EyeWaveform::~EyeWaveform()
  */
 void EyeWaveform::Normalize()
 {
-	//Preprocessing
-	int64_t nmax = 0;
+	m_normalizationDirty = false;
+
+	//Preprocessing: peak detection and mirroring only touch rows integrated since the last pass.
+	//Clean rows keep their cached maxima and are already mirrored, so steady-state monitoring of a signal
+	//spanning part of the plot doesn't re-scan the full height every display update.
+	m_accumdata.PrepareForCpuAccess();
+	int64_t* adata = m_accumdata.GetCpuPointer();
 	int64_t halfwidth = m_width/2;
 	size_t blocksize = halfwidth * sizeof(int64_t);
-	for(size_t y=0; y<m_height; y++)
+	size_t ystart = m_dirtyRowStart;
+	size_t yend = min(m_dirtyRowEnd, m_height - 1);
+	#pragma omp parallel for
+	for(size_t y=ystart; y<=yend; y++)
 	{
-		int64_t* row = m_accumdata + y*m_width;
+		int64_t* row = adata + y*m_width;
 
-		//Find peak amplitude
+		//Find peak amplitude of this row
+		int64_t rmax = 0;
 		for(size_t x=halfwidth; x<m_width; x++)
-			nmax = max(row[x], nmax);
+			rmax = max(row[x], rmax);
+		m_rowMax[y] = rmax;
 
 		//Copy right half to left half
 		memcpy(row, row+halfwidth, blocksize);
 	}
+	m_dirtyRowStart = m_height;
+	m_dirtyRowEnd = 0;
+
+	//Hierarchical merge of the cached per-row maxima into the global normalization peak
+	int64_t nmax = 0;
+	for(size_t y=0; y<m_height; y++)
+		nmax = max(m_rowMax[y], nmax);
+	m_accumdata.MarkModifiedFromCpu();
 	if(nmax == 0)
 		nmax = 1;
 	float norm = 2.0f / nmax;
 
-	/*
-		Normalize with saturation
-		TODO: do this in a shader?
-	 */
+	//Normalize with saturation
 	norm *= m_saturationLevel;
 	size_t len = m_width * m_height;
-	m_outdata.PrepareForCpuAccess();
-	for(size_t i=0; i<len; i++)
-		m_outdata[i] = min(1.0f, m_accumdata[i] * norm);
-	m_outdata.MarkModifiedFromCpu();
+
+	//Convert in a compute pass if we can, so the output stays GPU resident for the display
+	if(g_gpuFilterEnabled)
+	{
+		//Lazily create our Vulkan objects the first time we normalize on the GPU
+		if(m_normalizePipeline == nullptr)
+		{
+			m_normalizePipeline = make_unique<ComputePipeline>(
+				"shaders/EyeNormalize.spv", 2, sizeof(EyeNormalizeArgs));
+
+			m_queue = g_vkQueueManager->GetComputeQueue("EyeWaveform.queue");
+			vk::CommandPoolCreateInfo poolInfo(
+				vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+				m_queue->m_family );
+			m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+
+			vk::CommandBufferAllocateInfo bufinfo(**m_pool, vk::CommandBufferLevel::ePrimary, 1);
+			m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
+				std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+		}
+
+		EyeNormalizeArgs args;
+		args.size = len;
+		args.norm = norm;
+
+		m_cmdBuf->begin({});
+		m_normalizePipeline->BindBufferNonblocking(0, m_accumdata, *m_cmdBuf);
+		m_normalizePipeline->BindBufferNonblocking(1, m_outdata, *m_cmdBuf, true);
+		m_normalizePipeline->Dispatch(*m_cmdBuf, args, GetComputeBlockCount(len, 64));
+		m_cmdBuf->end();
+		m_queue->SubmitAndBlock(*m_cmdBuf);
+
+		m_outdata.MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		m_outdata.PrepareForCpuAccess();
+		for(size_t i=0; i<len; i++)
+			m_outdata[i] = min(1.0f, adata[i] * norm);
+		m_outdata.MarkModifiedFromCpu();
+	}
 }
 
 /**
@@ -127,6 +213,10 @@ void EyeWaveform::Normalize()
  */
 double EyeWaveform::GetBERAtPoint(ssize_t pointx, ssize_t pointy, ssize_t xmid, ssize_t ymid)
 {
+	//Make sure the left half of the accumulator is mirrored and the data is CPU accessible
+	NormalizeIfNeeded();
+	m_accumdata.PrepareForCpuAccess();
+
 	if(m_type == EYE_BER)
 	{
 		//out of bounds? all error
@@ -38,9 +38,17 @@
 #define EyeWaveform_h
 
 #include "../scopehal/DensityFunctionWaveform.h"
+#include "../scopehal/ComputePipeline.h"
+#include "../scopehal/QueueManager.h"
 
 #define EYE_ACCUM_SCALE 64
 
+struct EyeNormalizeArgs
+{
+	uint32_t size;
+	float norm;
+};
+
 /**
 	@brief An eye-pattern waveform
 	@ingroup datamodel
@@ -72,10 +80,75 @@ public:
 
 	///@brief Returns a pointer to the raw (not normalized) accumulator data
 	int64_t* GetAccumData()
+	{
+		m_accumdata.PrepareForCpuAccess();
+		return m_accumdata.GetCpuPointer();
+	}
+
+	///@brief Returns a reference to the accumulator buffer object
+	AcceleratorBuffer<int64_t>& GetAccumBuffer()
 	{ return m_accumdata; }
 
 	void Normalize();
 
+	/**
+		@brief Marks the accumulated data as changed, deferring normalization until the eye is next read.
+
+		Typically called by filters at the end of a refresh cycle in place of an eager Normalize(), so free-running
+		integration never touches the output buffer unless the display or a measurement actually looks at it.
+	 */
+	void MarkNormalizationDirty()
+	{ MarkNormalizationDirty(0, m_height - 1); }
+
+	/**
+		@brief Marks a range of rows of the accumulator as changed, deferring normalization until the eye is next read.
+
+		Integrators that know which rows they touched (e.g. from the min/max voltage of the integrated record) should
+		use this overload: Normalize() then re-scans and re-mirrors only the dirty rows, reusing cached per-row maxima
+		for the rest, so steady-state monitoring of a signal spanning part of the plot doesn't pay for the full height.
+
+		@param ymin	First dirty row
+		@param ymax	Last dirty row
+	 */
+	void MarkNormalizationDirty(size_t ymin, size_t ymax)
+	{
+		m_normalizationDirty = true;
+		m_dirtyRowStart = std::min(m_dirtyRowStart, ymin);
+		m_dirtyRowEnd = std::max(m_dirtyRowEnd, std::min(ymax, m_height - 1));
+	}
+
+	///@brief Normalizes the eye if the accumulated data has changed since the last normalization
+	void NormalizeIfNeeded()
+	{
+		if(m_normalizationDirty)
+			Normalize();
+	}
+
+	//Lazily normalize when the output is read
+	virtual float* GetData() override
+	{
+		NormalizeIfNeeded();
+		return DensityFunctionWaveform::GetData();
+	}
+
+	virtual AcceleratorBuffer<float>& GetOutData() override
+	{
+		NormalizeIfNeeded();
+		return m_outdata;
+	}
+
+	virtual void PrepareForCpuAccess() override
+	{
+		NormalizeIfNeeded();
+		m_outdata.PrepareForCpuAccess();
+	}
+
+	virtual void PrepareForGpuAccess() override
+	{
+		NormalizeIfNeeded();
+		m_outdata.PrepareForGpuAccess();
+	}
+
 	///@brief Get the total number of UIs integrated in this eye
 	size_t GetTotalUIs()
 	{ return m_totalUIs; }
@@ -145,6 +218,21 @@ public:
 	EyeType GetType()
 	{ return m_type; }
 
+	virtual void Resize(size_t width, size_t height) override;
+
+	/**
+		@brief Resets this eye for reuse as a fresh capture (normally called when recycling it from a pool)
+
+		@param center	Center voltage of the new eye
+		@param etype	Type of the new eye (BER or normal integrated samples)
+	 */
+	void Reinitialize(float center, EyeType etype)
+	{
+		m_centerVoltage = center;
+		m_type = etype;
+		m_maskHitRate = 0;
+	}
+
 	virtual void FreeGpuMemory() override
 	{}
 
@@ -154,7 +242,31 @@ public:
 protected:
 
 	///@brief Accumulator buffer
-	int64_t* m_accumdata;
+	AcceleratorBuffer<int64_t> m_accumdata;
+
+	///@brief True if the accumulator has changed since the last Normalize() call
+	bool m_normalizationDirty;
+
+	///@brief Cached peak amplitude of each accumulator row, updated when the row is re-scanned by Normalize()
+	std::vector<int64_t> m_rowMax;
+
+	///@brief First row changed since the last Normalize() call
+	size_t m_dirtyRowStart;
+
+	///@brief Last row changed since the last Normalize() call
+	size_t m_dirtyRowEnd;
+
+	///@brief Compute pipeline for normalizing on the GPU (created on first use)
+	std::unique_ptr<ComputePipeline> m_normalizePipeline;
+
+	///@brief Queue for normalization compute passes
+	std::shared_ptr<QueueHandle> m_queue;
+
+	///@brief Command pool for m_cmdBuf
+	std::unique_ptr<vk::raii::CommandPool> m_pool;
+
+	///@brief Command buffer for normalization compute passes
+	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
 
 	///@brief Total UIs integrated
 	size_t m_totalUIs;
@@ -36,6 +36,10 @@
 
 #include "scopehal.h"
 #include "Filter.h"
+#include "EyeWaveform.h"
+#include "ConstellationWaveform.h"
+#include <typeinfo>
+#include <cfloat>
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
@@ -43,13 +47,31 @@
 using namespace std;
 
 Filter::CreateMapType Filter::m_createprocs;
+map<string, string> Filter::m_lazyCreateprocs;
 set<Filter*> Filter::m_filters;
 
 mutex Filter::m_cacheMutex;
 map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_zeroCrossingCache;
+map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_risingEdgeCache;
+map<WaveformBase*, float> Filter::m_minVoltageCache;
+map<WaveformBase*, float> Filter::m_maxVoltageCache;
+map<WaveformBase*, Filter::ReductionResults> Filter::m_reductionCache;
+map<WaveformBase*, float> Filter::m_baseVoltageCache;
+map<WaveformBase*, float> Filter::m_topVoltageCache;
 
 map<string, unsigned int> Filter::m_instanceCount;
 
+map<WaveformBase*, set<Filter*>> Filter::m_waveformBorrowers;
+mutex Filter::m_borrowMutex;
+mutex Filter::m_outputCacheMutex;
+
+WaveformPool Filter::m_uniformAnalogWaveformPool;
+WaveformPool Filter::m_sparseAnalogWaveformPool;
+WaveformPool Filter::m_uniformDigitalWaveformPool;
+WaveformPool Filter::m_sparseDigitalWaveformPool;
+WaveformPool Filter::m_eyeWaveformPool;
+WaveformPool Filter::m_constellationWaveformPool;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -60,6 +82,11 @@ Filter::Filter(
 	: OscilloscopeChannel(NULL, "", color, xunit, 0)	//TODO: handle this better?
 	, m_category(cat)
 	, m_usingDefault(true)
+	, m_hasSpilledOutputs(false)
+	, m_offloadHint(false)
+	, m_dedupAllowed(true)
+	, m_refreshStateValid(false)
+	, m_refreshHash(0)
 {
 	m_instanceNum = 0;
 	m_filters.emplace(this);
@@ -72,6 +99,41 @@ Filter::Filter(
 Filter::~Filter()
 {
 	m_filters.erase(this);
+
+	//Drop any spilled output state (nothing to rehydrate: we're going away)
+	FilterSpillEngine::GetInstance().Forget(this);
+
+	//Free any retained output sets (subclasses holding packets have already flushed in their own destructor)
+	FlushOutputCache();
+
+	//Tear down any shared-output relationships before the base destructor deletes our stream waveforms:
+	//waveforms we borrowed aren't ours to delete, and waveforms others borrowed are about to go away
+	for(size_t i=0; i<m_streams.size(); i++)
+	{
+		auto wfm = m_streams[i].m_waveform;
+		if(!wfm)
+			continue;
+
+		if(m_borrowedOutputs.find(wfm) != m_borrowedOutputs.end())
+			m_streams[i].m_waveform = nullptr;
+		else
+			DetachBorrowers(wfm);
+	}
+
+	if(!m_borrowedOutputs.empty())
+	{
+		lock_guard<mutex> lock(m_borrowMutex);
+		for(auto wfm : m_borrowedOutputs)
+		{
+			auto it = m_waveformBorrowers.find(wfm);
+			if(it != m_waveformBorrowers.end())
+			{
+				it->second.erase(this);
+				if(it->second.empty())
+					m_waveformBorrowers.erase(it);
+			}
+		}
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -94,6 +156,465 @@ void Filter::Release()
 		delete this;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Memoization of refresh results
+
+/**
+	@brief Helper for ComputeRefreshHash(): mixes a block of bytes into a FNV-1a hash
+ */
+static void HashBytes(uint64_t& hash, const void* p, size_t len)
+{
+	auto bytes = reinterpret_cast<const uint8_t*>(p);
+	for(size_t i=0; i<len; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+}
+
+/**
+	@brief Computes a hash of everything our output depends on: the identity, content revision, and length of each
+	input stream, plus the value of every parameter
+
+	A waveform's m_revision stands in for its content here, so producers which rewrite a waveform in place must bump
+	the revision for downstream filters to notice (all in-tree producers do).
+ */
+uint64_t Filter::ComputeRefreshHash()
+{
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for(size_t i=0; i<m_inputs.size(); i++)
+	{
+		auto& in = m_inputs[i];
+		HashBytes(hash, &in.m_channel, sizeof(in.m_channel));
+		HashBytes(hash, &in.m_stream, sizeof(in.m_stream));
+
+		auto data = in.GetData();
+		HashBytes(hash, &data, sizeof(data));
+		if(data)
+		{
+			HashBytes(hash, &data->m_revision, sizeof(data->m_revision));
+			auto len = data->size();
+			HashBytes(hash, &len, sizeof(len));
+		}
+
+		//Scalar streams carry their value outside any waveform object
+		if(in.m_channel && (in.GetType() == Stream::STREAM_TYPE_ANALOG_SCALAR) )
+		{
+			auto v = in.GetScalarValue();
+			HashBytes(hash, &v, sizeof(v));
+		}
+	}
+
+	for(auto& it : m_parameters)
+	{
+		HashBytes(hash, it.first.data(), it.first.size());
+		auto str = it.second.ToString();
+		HashBytes(hash, str.data(), str.size());
+	}
+
+	return hash;
+}
+
+/**
+	@brief Checks if evaluating this filter now could produce different output than its last Refresh()
+
+	Returns false (letting the scheduler skip us) only if all of the following hold:
+	* This filter is memoizable (see ShouldMemoize())
+	* We have completed a Refresh() since construction
+	* Our inputs and parameters hash identically to the last completed Refresh()
+	* Our output waveforms are the same objects, at the same revisions, as the last completed Refresh()
+	  (so an output freed or replaced behind our back forces a re-run rather than serving stale data)
+ */
+bool Filter::IsRefreshNeeded()
+{
+	if(!ShouldMemoize() || !m_refreshStateValid)
+		return true;
+
+	if(ComputeRefreshHash() != m_refreshHash)
+		return true;
+
+	if(GetStreamCount() != m_memoizedOutputs.size())
+		return true;
+	for(size_t i=0; i<m_memoizedOutputs.size(); i++)
+	{
+		//Read the stream directly rather than through GetData(): a spilled output is still the
+		//memoized one, and must not be rehydrated just to check that
+		auto data = InstrumentChannel::GetData(i);
+		if(data == nullptr)
+		{
+			//A null stream is fine if the output is sitting in the spill file
+			if( (m_memoizedOutputs[i].m_wfm != nullptr) && !m_hasSpilledOutputs)
+				return true;
+		}
+		else if(m_memoizedOutputs[i] != data)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+	@brief Records the input/parameter hash and output revisions of a just-completed Refresh()
+ */
+void Filter::OnRefreshed()
+{
+	if(!ShouldMemoize())
+		return;
+
+	m_refreshHash = ComputeRefreshHash();
+
+	m_memoizedOutputs.clear();
+	auto nstreams = GetStreamCount();
+	for(size_t i=0; i<nstreams; i++)
+	{
+		auto data = GetData(i);
+		if(data)
+			m_memoizedOutputs.push_back(WaveformCacheKey(data));
+		else
+			m_memoizedOutputs.push_back(WaveformCacheKey());
+	}
+
+	m_refreshStateValid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output caching across configuration changes
+
+/**
+	@brief Attempts to serve this filter's outputs from the output cache
+
+	Looks up the current input/parameter hash among the retained configurations. On a hit, the currently
+	installed outputs are stashed into the cache under the hash they were computed from, the cached waveforms
+	(and packets, for protocol decoders) are reinstalled, and the memoization state is updated so
+	IsRefreshNeeded() reports false until something actually changes.
+
+	On a miss, the current outputs are still stashed so the upcoming Refresh() cannot recycle them.
+
+	Called by FilterGraphExecutor before falling back to a full Refresh().
+
+	@return True if the outputs were served from cache and Refresh() can be skipped
+ */
+bool Filter::TryRestoreCachedOutputs()
+{
+	if( (GetOutputCacheDepth() == 0) || !ShouldMemoize() )
+		return false;
+
+	lock_guard<mutex> lock(m_outputCacheMutex);
+
+	auto hash = ComputeRefreshHash();
+	for(auto it = m_outputCache.begin(); it != m_outputCache.end(); ++it)
+	{
+		if(it->m_hash != hash)
+			continue;
+
+		//Move the entry out of the cache before touching stream state
+		CachedOutputSet entry = std::move(*it);
+		m_outputCache.erase(it);
+
+		//Retain the outputs we're about to displace
+		StashOutputsToCache();
+
+		//Reinstall the cached outputs.
+		//Assign the streams directly: SetData() would recycle or delete the old waveform, but the old
+		//waveform now lives in the cache (or the streams are already null after the stash).
+		for(size_t i=0; (i < entry.m_outputs.size()) && (i < m_streams.size()); i++)
+			m_streams[i].m_waveform = entry.m_outputs[i];
+		RestorePacketsFromCache(entry);
+
+		//Update memoization state so the scheduler sees this configuration as freshly refreshed
+		OnRefreshed();
+		return true;
+	}
+
+	//Miss: retain the outputs the upcoming Refresh() will displace
+	StashOutputsToCache();
+	return false;
+}
+
+/**
+	@brief Moves the currently installed outputs (and packets) into the output cache
+
+	The streams are nulled out afterwards, so the next Refresh() allocates fresh waveforms instead of
+	recycling the retained ones. Does nothing if the current outputs don't represent a completed Refresh()
+	of a known configuration, or if any output is borrowed from another filter (it's the owner's to retain).
+
+	Evicts the oldest entries beyond the configured cache depth.
+
+	The caller must hold m_outputCacheMutex.
+ */
+void Filter::StashOutputsToCache()
+{
+	if(!m_refreshStateValid)
+		return;
+
+	CachedOutputSet entry;
+	entry.m_hash = m_refreshHash;
+	bool any = false;
+	for(size_t i=0; i<m_streams.size(); i++)
+	{
+		auto wfm = m_streams[i].m_waveform;
+		if(wfm && (m_borrowedOutputs.find(wfm) != m_borrowedOutputs.end()) )
+			return;
+		entry.m_outputs.push_back(wfm);
+		if(wfm)
+			any = true;
+	}
+	if(!any)
+		return;
+
+	//If we somehow already have an entry for this hash, replace it rather than duplicating
+	for(auto it = m_outputCache.begin(); it != m_outputCache.end(); ++it)
+	{
+		if(it->m_hash == entry.m_hash)
+		{
+			FreeCachedOutputSet(*it);
+			m_outputCache.erase(it);
+			break;
+		}
+	}
+
+	//Hide the retained waveforms from the streams.
+	//Anyone borrowing them has to detach first, same as when SetData() recycles an old output.
+	for(size_t i=0; i<m_streams.size(); i++)
+	{
+		auto wfm = m_streams[i].m_waveform;
+		if(wfm)
+			DetachBorrowers(wfm);
+		m_streams[i].m_waveform = nullptr;
+	}
+	StashPacketsToCache(entry);
+	m_outputCache.push_back(std::move(entry));
+
+	//Evict the oldest entries if we're over budget
+	auto depth = GetOutputCacheDepth();
+	while(m_outputCache.size() > depth)
+	{
+		FreeCachedOutputSet(m_outputCache.front());
+		m_outputCache.pop_front();
+	}
+
+	//No outputs are installed anymore, so the memoization state no longer describes live streams
+	m_refreshStateValid = false;
+}
+
+///@brief Frees the waveforms and packets held by one cache entry
+void Filter::FreeCachedOutputSet(CachedOutputSet& entry)
+{
+	for(auto wfm : entry.m_outputs)
+		delete wfm;
+	entry.m_outputs.clear();
+	FreeCachedPackets(entry);
+}
+
+/**
+	@brief Frees all entries in the output cache
+
+	Called on destruction and under memory pressure. Subclasses holding packets must call this from their own
+	destructor (rather than relying on ours) so the packet cleanup hook still dispatches to them.
+ */
+void Filter::FlushOutputCache()
+{
+	lock_guard<mutex> lock(m_outputCacheMutex);
+	for(auto& entry : m_outputCache)
+		FreeCachedOutputSet(entry);
+	m_outputCache.clear();
+}
+
+/**
+	@brief Frees the output caches of every filter in existence to reclaim memory
+
+	@return True if any memory was freed
+ */
+bool Filter::FlushAllOutputCaches()
+{
+	bool freed = false;
+	for(auto f : m_filters)
+	{
+		if(!f->m_outputCache.empty())
+		{
+			f->FlushOutputCache();
+			freed = true;
+		}
+	}
+	return freed;
+}
+
+//Packet retention hooks: plain filters have no packets, PacketDecoder overrides these
+void Filter::StashPacketsToCache([[maybe_unused]] CachedOutputSet& entry)
+{
+}
+
+void Filter::RestorePacketsFromCache([[maybe_unused]] CachedOutputSet& entry)
+{
+}
+
+void Filter::FreeCachedPackets([[maybe_unused]] CachedOutputSet& entry)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Spilling of idle intermediate outputs
+
+/**
+	@brief Gets the contents of a data stream, rehydrating from the spill file first if needed
+
+	This is the transparent-rehydration hook for FilterSpillEngine: anything reading a spilled output through the
+	normal channel API (a downstream filter, a probe on an intermediate, etc) gets the waveform back without having
+	to know spilling exists.
+ */
+WaveformBase* Filter::GetData(size_t stream)
+{
+	if(m_hasSpilledOutputs)
+		FilterSpillEngine::GetInstance().Rehydrate(this);
+	return InstrumentChannel::GetData(stream);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shared subexpression elimination
+
+/**
+	@brief Computes a hash of this filter's structure: its class, inputs, and parameter values
+
+	Two filters with equal structural hashes are candidates for shared subexpression elimination. The hash can
+	collide, so confirm with IsEquivalentTo() before actually merging anything.
+ */
+uint64_t Filter::GetStructuralHash()
+{
+	uint64_t hash = 0xcbf29ce484222325;
+
+	auto tname = typeid(*this).name();
+	HashBytes(hash, tname, strlen(tname));
+
+	for(auto& in : m_inputs)
+	{
+		HashBytes(hash, &in.m_channel, sizeof(in.m_channel));
+		HashBytes(hash, &in.m_stream, sizeof(in.m_stream));
+	}
+
+	for(auto& it : m_parameters)
+	{
+		HashBytes(hash, it.first.data(), it.first.size());
+		auto str = it.second.ToString();
+		HashBytes(hash, str.data(), str.size());
+	}
+
+	return hash;
+}
+
+/**
+	@brief Checks if this filter is structurally equivalent to another: same class, same inputs, and same parameter
+	values
+
+	Two equivalent filters compute identical outputs (as long as both are pure functions, see ShouldMemoize()), so
+	the scheduler can evaluate one of them and share the result.
+ */
+bool Filter::IsEquivalentTo(Filter* rhs)
+{
+	if(typeid(*this) != typeid(*rhs))
+		return false;
+
+	if(m_inputs.size() != rhs->m_inputs.size())
+		return false;
+	for(size_t i=0; i<m_inputs.size(); i++)
+	{
+		if(m_inputs[i] != rhs->m_inputs[i])
+			return false;
+	}
+
+	if(m_parameters.size() != rhs->m_parameters.size())
+		return false;
+	auto it = m_parameters.begin();
+	auto jt = rhs->m_parameters.begin();
+	for(; it != m_parameters.end(); ++it, ++jt)
+	{
+		if(it->first != jt->first)
+			return false;
+		if(it->second.ToString() != jt->second.ToString())
+			return false;
+	}
+
+	return true;
+}
+
+/**
+	@brief Points our output streams at another (structurally equivalent) filter's output waveforms
+
+	Used by FilterGraphExecutor for shared subexpression elimination: the leader evaluates normally, then each
+	duplicate borrows its waveforms instead of recomputing them. Ownership stays with the leader; our SetData() and
+	destructor know not to recycle borrowed waveforms, and the leader detaches us before recycling a waveform we
+	still point at.
+ */
+void Filter::BorrowOutputsFrom(Filter* leader)
+{
+	auto len = min(GetStreamCount(), leader->GetStreamCount());
+	for(size_t i=0; i<len; i++)
+	{
+		auto wfm = leader->m_streams[i].m_waveform;
+		if(m_streams[i].m_waveform != wfm)
+		{
+			//Recycle whatever we had before (this also releases a previous borrow)
+			SetData(nullptr, i);
+
+			m_streams[i].m_waveform = wfm;
+			if(wfm)
+			{
+				lock_guard<mutex> lock(m_borrowMutex);
+				m_waveformBorrowers[wfm].insert(this);
+				m_borrowedOutputs.insert(wfm);
+			}
+		}
+
+		//Scalar streams carry their value outside any waveform object
+		m_streams[i].m_value = leader->m_streams[i].m_value;
+	}
+}
+
+/**
+	@brief Publishes a partial result for one of our output streams during a long Refresh()
+
+	Long-running filters building large outputs (density maps, deep packet decodes, etc.) may call this periodically
+	once a prefix of the output is fully written and marked modified, so display-side consumers can show the data
+	already computed instead of staring at the previous run's output. Bumps the stream's revision (so anything polling
+	WaveformCacheKey notices the new content) and invokes the executor's partial result callback if one is installed.
+
+	This does NOT unblock downstream graph nodes: they still wait for the Refresh() to complete fully, same as with
+	time-sliced evaluation (see IsRefreshIncomplete()). Only out-of-band observers such as renderers see the partials.
+ */
+void Filter::PublishPartialResult(size_t stream)
+{
+	auto data = GetData(stream);
+	if(!data)
+		return;
+
+	data->m_revision ++;
+
+	if(m_partialResultCallback)
+		m_partialResultCallback(this, stream);
+}
+
+/**
+	@brief Detaches any filters currently borrowing wfm as an output, so it can be recycled or deleted safely
+
+	The borrowers' streams read as empty until the next graph execution re-borrows the replacement waveform.
+ */
+void Filter::DetachBorrowers(WaveformBase* wfm)
+{
+	lock_guard<mutex> lock(m_borrowMutex);
+	auto it = m_waveformBorrowers.find(wfm);
+	if(it == m_waveformBorrowers.end())
+		return;
+
+	for(auto f : it->second)
+	{
+		for(size_t i=0; i<f->m_streams.size(); i++)
+		{
+			if(f->m_streams[i].m_waveform == wfm)
+				f->m_streams[i].m_waveform = nullptr;
+		}
+		f->m_borrowedOutputs.erase(wfm);
+	}
+
+	m_waveformBorrowers.erase(it);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Enumeration
 
@@ -102,18 +623,62 @@ void Filter::DoAddDecoderClass(const string& name, CreateProcType proc)
 	m_createprocs[name] = proc;
 }
 
+/**
+	@brief Registers a filter class provided by a plugin that hasn't been loaded yet
+
+	The name shows up in EnumProtocols() immediately; the plugin itself is loaded the first time
+	CreateFilter() asks for one of its classes. See InitializePlugins().
+ */
+void Filter::AddLazyDecoderClass(const string& name, const string& pluginPath)
+{
+	//Never shadow a class that's already registered for real
+	if(m_createprocs.find(name) == m_createprocs.end())
+		m_lazyCreateprocs[name] = pluginPath;
+}
+
 void Filter::EnumProtocols(vector<string>& names)
 {
 	for(CreateMapType::iterator it=m_createprocs.begin(); it != m_createprocs.end(); ++it)
 		names.push_back(it->first);
+
+	//Classes from plugins we haven't loaded yet
+	for(auto& it : m_lazyCreateprocs)
+	{
+		if(m_createprocs.find(it.first) == m_createprocs.end())
+			names.push_back(it.first);
+	}
 }
 
 Filter* Filter::CreateFilter(const string& protocol, const string& color)
 {
+	//Filter from a plugin we haven't loaded yet? Load it now; its PluginInit() registers the real factory
+	auto lit = m_lazyCreateprocs.find(protocol);
+	if( (lit != m_lazyCreateprocs.end()) && (m_createprocs.find(protocol) == m_createprocs.end()) )
+	{
+		auto path = lit->second;
+		if(!LoadPlugin(path))
+			LogError("Failed to load plugin %s providing filter \"%s\"\n", path.c_str(), protocol.c_str());
+
+		//Drop all stubs pointing at this module, whether or not the load worked, so a stale manifest
+		//can't make us retry the dlopen for every class it lists
+		for(auto it = m_lazyCreateprocs.begin(); it != m_lazyCreateprocs.end(); )
+		{
+			if(it->second == path)
+				it = m_lazyCreateprocs.erase(it);
+			else
+				++it;
+		}
+	}
+
 	if(m_createprocs.find(protocol) != m_createprocs.end())
 	{
 		auto f = m_createprocs[protocol](color);
 		f->m_instanceNum = (m_instanceCount[protocol] ++);
+
+		//Start building any pipelines the new filter registered, so neither the first trigger after adding
+		//a filter nor the first refresh of a freshly loaded session stalls on shader compilation
+		ComputePipeline::PrecompileAllAsync();
+
 		return f;
 	}
 
@@ -310,44 +875,181 @@ void Filter::FillDurationsAVX2(SparseWaveformBase& wfm)
 	//Constant duration of last sample
 	wfm.m_durations[len-1] = 1;
 }
-#endif /* __x86_64__ */
 
 /**
-	@brief Find rising edges in a waveform, interpolating to sub-sample resolution as necessary
+	@brief AVX2 optimized zero crossing search for uniform analog waveforms.
+
+	Compares 8 samples per iteration against the threshold and uses the comparison masks of adjacent sample
+	windows to skip blocks with no transitions, only dropping to scalar interpolation for lanes containing an
+	edge. Produces identical output to the scalar loop in FindZeroCrossings().
  */
-void Filter::FindRisingEdges(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
+__attribute__((target("avx2")))
+void Filter::FindZeroCrossingsAVX2(UniformAnalogWaveform* data, float threshold, vector<int64_t>& edges)
 {
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
 	int64_t phoff = data->m_triggerPhase;
-	size_t len = data->size();
+	size_t len = data->m_samples.size();
 	float fscale = data->m_timescale;
+	if(len < 2)
+		return;
+	const float* samples = reinterpret_cast<const float*>(&data->m_samples[0]);
 
-	for(size_t i=1; i<len; i++)
+	__m256 vthresh = _mm256_set1_ps(threshold);
+
+	//The scalar loop uses sample 1 (not 0) to initialize its state, so transitions are detected from i=2 on
+	size_t i = 2;
+	size_t end = (len >= 8) ? (len - 7) : 2;
+	for(; i < end; i += 8)
 	{
-		bool value = data->m_samples[i] > threshold;
+		//Compare the windows [i-1, i+6] and [i, i+7] against the threshold
+		__m256 prev		= _mm256_loadu_ps(samples + i - 1);
+		__m256 cur		= _mm256_loadu_ps(samples + i);
+		int mprev		= _mm256_movemask_ps(_mm256_cmp_ps(prev, vthresh, _CMP_GT_OQ));
+		int mcur		= _mm256_movemask_ps(_mm256_cmp_ps(cur, vthresh, _CMP_GT_OQ));
+
+		//Lanes that crossed the threshold in either direction
+		int mcross = mprev ^ mcur;
+		if(!mcross)
+			continue;
 
-		//Save the last value
-		if(first)
+		//Interpolate the crossings
+		for(int k = 0; k < 8; k++)
 		{
-			last = value;
-			first = false;
+			if(!(mcross & (1 << k)))
+				continue;
+			size_t j = (i + k) - 1;
+			int64_t tfrac = fscale * InterpolateTime(data, j, threshold);
+			edges.push_back(phoff + data->m_timescale*j + tfrac);
+		}
+	}
+
+	//Scalar tail
+	for(; i < len; i++)
+	{
+		bool value = samples[i] > threshold;
+		bool last = samples[i-1] > threshold;
+		if(value == last)
+			continue;
+
+		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+		edges.push_back(phoff + data->m_timescale*(i-1) + tfrac);
+	}
+}
+
+/**
+	@brief AVX2 optimized rising edge search for uniform analog waveforms.
+
+	Same blockwise threshold comparison as FindZeroCrossingsAVX2(), but only keeping low-to-high transitions.
+ */
+__attribute__((target("avx2")))
+void Filter::FindRisingEdgesAVX2(UniformAnalogWaveform* data, float threshold, vector<int64_t>& edges)
+{
+	int64_t phoff = data->m_triggerPhase;
+	size_t len = data->m_samples.size();
+	float fscale = data->m_timescale;
+	if(len < 2)
+		return;
+	const float* samples = reinterpret_cast<const float*>(&data->m_samples[0]);
+
+	__m256 vthresh = _mm256_set1_ps(threshold);
+
+	size_t i = 2;
+	size_t end = (len >= 8) ? (len - 7) : 2;
+	for(; i < end; i += 8)
+	{
+		__m256 prev		= _mm256_loadu_ps(samples + i - 1);
+		__m256 cur		= _mm256_loadu_ps(samples + i);
+		int mprev		= _mm256_movemask_ps(_mm256_cmp_ps(prev, vthresh, _CMP_GT_OQ));
+		int mcur		= _mm256_movemask_ps(_mm256_cmp_ps(cur, vthresh, _CMP_GT_OQ));
+
+		//Lanes that went from below to above the threshold
+		int mrise = mcur & ~mprev;
+		if(!mrise)
 			continue;
+
+		for(int k = 0; k < 8; k++)
+		{
+			if(!(mrise & (1 << k)))
+				continue;
+			size_t j = (i + k) - 1;
+			int64_t tfrac = fscale * InterpolateTime(data, j, threshold);
+			edges.push_back(phoff + data->m_timescale*j + tfrac);
 		}
-		if(!value)
-			last = false;
+	}
 
-		//Skip samples with no rising edge
+	//Scalar tail
+	for(; i < len; i++)
+	{
+		bool value = samples[i] > threshold;
+		bool last = samples[i-1] > threshold;
 		if(!value || last)
 			continue;
 
-		//Midpoint of the sample, plus the zero crossing
 		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-		int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-		edges.push_back(t);
-		last = true;
+		edges.push_back(phoff + data->m_timescale*(i-1) + tfrac);
+	}
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Find rising edges in a waveform, interpolating to sub-sample resolution as necessary
+ */
+void Filter::FindRisingEdges(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
+{
+	pair<WaveformBase*, float> cachekey(data, threshold);
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_risingEdgeCache.find(cachekey);
+		if(it != m_risingEdgeCache.end())
+		{
+			edges = it->second;
+			return;
+		}
+	}
+
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		FindRisingEdgesAVX2(data, threshold, edges);
+	else
+	#endif
+	{
+		//Find times of the zero crossings
+		bool first = true;
+		bool last = false;
+		int64_t phoff = data->m_triggerPhase;
+		size_t len = data->size();
+		float fscale = data->m_timescale;
+
+		for(size_t i=1; i<len; i++)
+		{
+			bool value = data->m_samples[i] > threshold;
+
+			//Save the last value
+			if(first)
+			{
+				last = value;
+				first = false;
+				continue;
+			}
+			if(!value)
+				last = false;
+
+			//Skip samples with no rising edge
+			if(!value || last)
+				continue;
+
+			//Midpoint of the sample, plus the zero crossing
+			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+			int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
+			edges.push_back(t);
+			last = true;
+		}
 	}
+
+	//Add to cache
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_risingEdgeCache[cachekey] = edges;
 }
 
 /**
@@ -355,6 +1057,19 @@ void Filter::FindRisingEdges(UniformAnalogWaveform* data, float threshold, std::
  */
 void Filter::FindRisingEdges(SparseAnalogWaveform* data, float threshold, std::vector<int64_t>& edges)
 {
+	pair<WaveformBase*, float> cachekey(data, threshold);
+
+	//Check cache
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_risingEdgeCache.find(cachekey);
+		if(it != m_risingEdgeCache.end())
+		{
+			edges = it->second;
+			return;
+		}
+	}
+
 	//Find times of the zero crossings
 	bool first = true;
 	bool last = false;
@@ -387,6 +1102,10 @@ void Filter::FindRisingEdges(SparseAnalogWaveform* data, float threshold, std::v
 		edges.push_back(t);
 		last = true;
 	}
+
+	//Add to cache
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_risingEdgeCache[cachekey] = edges;
 }
 
 /**
@@ -460,34 +1179,41 @@ void Filter::FindZeroCrossings(UniformAnalogWaveform* data, float threshold, std
 		}
 	}
 
-	//Find times of the zero crossings
-	bool first = true;
-	bool last = false;
-	int64_t phoff = data->m_triggerPhase;
-	size_t len = data->m_samples.size();
-	float fscale = data->m_timescale;
-
-	for(size_t i=1; i<len; i++)
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		FindZeroCrossingsAVX2(data, threshold, edges);
+	else
+	#endif
 	{
-		bool value = data->m_samples[i] > threshold;
-
-		//Save the last value
-		if(first)
+		//Find times of the zero crossings
+		bool first = true;
+		bool last = false;
+		int64_t phoff = data->m_triggerPhase;
+		size_t len = data->m_samples.size();
+		float fscale = data->m_timescale;
+
+		for(size_t i=1; i<len; i++)
 		{
-			last = value;
-			first = false;
-			continue;
-		}
+			bool value = data->m_samples[i] > threshold;
 
-		//Skip samples with no transition
-		if(last == value)
-			continue;
+			//Save the last value
+			if(first)
+			{
+				last = value;
+				first = false;
+				continue;
+			}
 
-		//Midpoint of the sample, plus the zero crossing
-		int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
-		int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
-		edges.push_back(t);
-		last = value;
+			//Skip samples with no transition
+			if(last == value)
+				continue;
+
+			//Midpoint of the sample, plus the zero crossing
+			int64_t tfrac = fscale * InterpolateTime(data, i-1, threshold);
+			int64_t t = phoff + data->m_timescale*(i-1) + tfrac;
+			edges.push_back(t);
+			last = value;
+		}
 	}
 
 	//Add to cache
@@ -1036,11 +1762,164 @@ void Filter::ClearAnalysisCache()
 {
 	lock_guard<mutex> lock(m_cacheMutex);
 	m_zeroCrossingCache.clear();
+	m_risingEdgeCache.clear();
+	m_minVoltageCache.clear();
+	m_maxVoltageCache.clear();
+	m_baseVoltageCache.clear();
+	m_topVoltageCache.clear();
+	m_reductionCache.clear();
+}
+
+/**
+	@brief Computes (or fetches memoized) full-record min/max/sum statistics for a waveform
+
+	Results are cached for the duration of the current graph execution, so when several filters observe the
+	same input (e.g. the Minimum / Maximum / Average trio on one channel) only the first one performs a
+	reduction, and the single fused pass serves all of them.
+
+	Dense waveforms are reduced on the GPU via the caller's StatisticsEngine when enabled; sparse waveforms
+	and GPU-less configurations fall back to a parallel CPU loop.
+ */
+Filter::ReductionResults Filter::GetOrComputeReduction(
+	WaveformBase* data,
+	StatisticsEngine& engine,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	//Check the cache first
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_reductionCache.find(data);
+		if(it != m_reductionCache.end())
+			return it->second;
+	}
+
+	auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
+	auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
+	size_t len = data->size();
+
+	ReductionResults ret;
+	ret.m_min = FLT_MAX;
+	ret.m_max = -FLT_MAX;
+	ret.m_sum = 0;
+	ret.m_count = len;
+
+	//Dense waveforms can be reduced on the GPU in a single fused pass
+	if(udata && g_gpuFilterEnabled)
+	{
+		engine.Compute(udata->m_samples, cmdBuf, queue);
+		ret.m_min = engine.GetMin();
+		ret.m_max = engine.GetMax();
+		ret.m_sum = engine.GetSum();
+	}
+
+	else if(udata || sdata)
+	{
+		data->PrepareForCpuAccess();
+		auto samples = udata ? udata->m_samples.GetCpuPointer() : sdata->m_samples.GetCpuPointer();
+
+		float vmin = FLT_MAX;
+		float vmax = -FLT_MAX;
+		double sum = 0;
+		#pragma omp parallel for reduction(min:vmin) reduction(max:vmax) reduction(+:sum)
+		for(size_t i=0; i<len; i++)
+		{
+			float v = samples[i];
+			vmin = min(vmin, v);
+			vmax = max(vmax, v);
+			sum += v;
+		}
+
+		ret.m_min = vmin;
+		ret.m_max = vmax;
+		ret.m_sum = sum;
+	}
+
+	//Add to cache
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_reductionCache[data] = ret;
+	return ret;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helpers for various common boilerplate operations
 
+/**
+	@brief Sets the waveform for a stream, recycling the old waveform into the global pools if possible.
+
+	Pooling waveforms rather than deleting them lets steady-state acquisition run without any GPU memory allocations,
+	since another filter (or this one, next trigger) can reuse the old waveform's buffers.
+ */
+void Filter::SetData(WaveformBase* pNew, size_t stream)
+{
+	auto old = m_streams[stream].m_waveform;
+	if( (old == pNew) || (old == nullptr) )
+	{
+		InstrumentChannel::SetData(pNew, stream);
+		return;
+	}
+
+	//If the old waveform was borrowed from another filter, just drop our reference: it's the owner's to recycle
+	if(m_borrowedOutputs.find(old) != m_borrowedOutputs.end())
+	{
+		{
+			lock_guard<mutex> lock(m_borrowMutex);
+			auto it = m_waveformBorrowers.find(old);
+			if(it != m_waveformBorrowers.end())
+			{
+				it->second.erase(this);
+				if(it->second.empty())
+					m_waveformBorrowers.erase(it);
+			}
+		}
+		m_borrowedOutputs.erase(old);
+		m_streams[stream].m_waveform = pNew;
+		return;
+	}
+
+	//If other filters borrowed the old waveform, detach them before recycling it out from under them
+	DetachBorrowers(old);
+
+	//Recycle the old waveform into the pool matching its concrete type
+	if(dynamic_cast<UniformAnalogWaveform*>(old) != nullptr)
+		m_uniformAnalogWaveformPool.Add(old);
+	else if(dynamic_cast<SparseAnalogWaveform*>(old) != nullptr)
+		m_sparseAnalogWaveformPool.Add(old);
+	else if(dynamic_cast<UniformDigitalWaveform*>(old) != nullptr)
+		m_uniformDigitalWaveformPool.Add(old);
+	else if(dynamic_cast<SparseDigitalWaveform*>(old) != nullptr)
+		m_sparseDigitalWaveformPool.Add(old);
+
+	//Density plots report size() of zero, so bucket them by their actual bitmap size
+	else if(auto eye = dynamic_cast<EyeWaveform*>(old))
+		m_eyeWaveformPool.Add(old, eye->GetWidth() * eye->GetHeight());
+	else if(auto constellation = dynamic_cast<ConstellationWaveform*>(old))
+		m_constellationWaveformPool.Add(old, constellation->GetWidth() * constellation->GetHeight());
+
+	//Some other waveform type (spectrogram, waterfall, etc) that we don't pool
+	else
+		delete old;
+
+	m_streams[stream].m_waveform = pNew;
+}
+
+/**
+	@brief Free all waveforms in the global filter waveform pools to reclaim memory
+
+	@return True if any memory was freed
+ */
+bool Filter::ClearWaveformPools()
+{
+	//Deliberately not short-circuited: clear all of the pools even if the first one freed something
+	bool freedUA = m_uniformAnalogWaveformPool.clear();
+	bool freedSA = m_sparseAnalogWaveformPool.clear();
+	bool freedUD = m_uniformDigitalWaveformPool.clear();
+	bool freedSD = m_sparseDigitalWaveformPool.clear();
+	bool freedEye = m_eyeWaveformPool.clear();
+	bool freedConst = m_constellationWaveformPool.clear();
+	return freedUA || freedSA || freedUD || freedSD || freedEye || freedConst;
+}
+
 /**
 	@brief Sets up an analog output waveform and copies basic metadata from the input.
 
@@ -1054,11 +1933,13 @@ void Filter::ClearAnalysisCache()
  */
 UniformAnalogWaveform* Filter::SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear)
 {
-	//Create the waveform, but only if necessary
+	//Create the waveform, but only if necessary (trying the global pool before allocating fresh buffers)
 	auto cap = dynamic_cast<UniformAnalogWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new UniformAnalogWaveform;
+		cap = dynamic_cast<UniformAnalogWaveform*>(m_uniformAnalogWaveformPool.Get(din->size()));
+		if(cap == NULL)
+			cap = new UniformAnalogWaveform;
 		SetData(cap, stream);
 	}
 
@@ -1091,11 +1972,13 @@ UniformAnalogWaveform* Filter::SetupEmptyUniformAnalogOutputWaveform(WaveformBas
  */
 SparseAnalogWaveform* Filter::SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear)
 {
-	//Create the waveform, but only if necessary
+	//Create the waveform, but only if necessary (trying the global pool before allocating fresh buffers)
 	auto cap = dynamic_cast<SparseAnalogWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new SparseAnalogWaveform;
+		cap = dynamic_cast<SparseAnalogWaveform*>(m_sparseAnalogWaveformPool.Get(din->size()));
+		if(cap == NULL)
+			cap = new SparseAnalogWaveform;
 		SetData(cap, stream);
 	}
 
@@ -1127,11 +2010,13 @@ SparseAnalogWaveform* Filter::SetupEmptySparseAnalogOutputWaveform(WaveformBase*
  */
 UniformDigitalWaveform* Filter::SetupEmptyUniformDigitalOutputWaveform(WaveformBase* din, size_t stream)
 {
-	//Create the waveform, but only if necessary
+	//Create the waveform, but only if necessary (trying the global pool before allocating fresh buffers)
 	auto cap = dynamic_cast<UniformDigitalWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new UniformDigitalWaveform;
+		cap = dynamic_cast<UniformDigitalWaveform*>(m_uniformDigitalWaveformPool.Get(din->size()));
+		if(cap == NULL)
+			cap = new UniformDigitalWaveform;
 		SetData(cap, stream);
 	}
 
@@ -1162,11 +2047,13 @@ UniformDigitalWaveform* Filter::SetupEmptyUniformDigitalOutputWaveform(WaveformB
  */
 SparseDigitalWaveform* Filter::SetupEmptySparseDigitalOutputWaveform(WaveformBase* din, size_t stream)
 {
-	//Create the waveform, but only if necessary
+	//Create the waveform, but only if necessary (trying the global pool before allocating fresh buffers)
 	auto cap = dynamic_cast<SparseDigitalWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new SparseDigitalWaveform;
+		cap = dynamic_cast<SparseDigitalWaveform*>(m_sparseDigitalWaveformPool.Get(din->size()));
+		if(cap == NULL)
+			cap = new SparseDigitalWaveform;
 		SetData(cap, stream);
 	}
 
@@ -1234,11 +2121,13 @@ SparseAnalogWaveform* Filter::SetupSparseOutputWaveform(SparseWaveformBase* din,
  */
 SparseDigitalWaveform* Filter::SetupSparseDigitalOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend)
 {
-	//Create the waveform, but only if necessary
+	//Create the waveform, but only if necessary (trying the global pool before allocating fresh buffers)
 	auto cap = dynamic_cast<SparseDigitalWaveform*>(GetData(stream));
 	if(cap == NULL)
 	{
-		cap = new SparseDigitalWaveform;
+		cap = dynamic_cast<SparseDigitalWaveform*>(m_sparseDigitalWaveformPool.Get(din->size()));
+		if(cap == NULL)
+			cap = new SparseDigitalWaveform;
 		SetData(cap, stream);
 	}
 
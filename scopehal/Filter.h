@@ -37,10 +37,17 @@
 #ifndef Filter_h
 #define Filter_h
 
+#include <atomic>
+#include <list>
+
 #include "OscilloscopeChannel.h"
 #include "FlowGraphNode.h"
+#include "WaveformPool.h"
 
 class QueueHandle;
+class Packet;
+class FilterSpillEngine;
+class StatisticsEngine;
 
 /**
 	@brief Describes a particular revision of a waveform
@@ -93,6 +100,9 @@ public:
  */
 class Filter	: public OscilloscopeChannel
 {
+	//Spill engine detaches and reinstalls our output waveforms directly (see FilterSpillEngine)
+	friend class FilterSpillEngine;
+
 public:
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -327,6 +337,11 @@ public:
 			return GetNextEventTimestampScaled(uwfm, i, len, timestamp);
 	}
 
+public:
+	virtual void SetData(WaveformBase* pNew, size_t stream) override;
+
+	static bool ClearWaveformPools();
+
 protected:
 	UniformAnalogWaveform* SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
 	SparseAnalogWaveform* SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
@@ -335,6 +350,14 @@ protected:
 	SparseAnalogWaveform* SetupSparseOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 	SparseDigitalWaveform* SetupSparseDigitalOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 
+	//Global size-class-bucketed pools of recycled filter output waveforms, one per concrete waveform type
+	static WaveformPool m_uniformAnalogWaveformPool;
+	static WaveformPool m_sparseAnalogWaveformPool;
+	static WaveformPool m_uniformDigitalWaveformPool;
+	static WaveformPool m_sparseDigitalWaveformPool;
+	static WaveformPool m_eyeWaveformPool;
+	static WaveformPool m_constellationWaveformPool;
+
 public:
 	//Helpers for sub-sample interpolation
 
@@ -426,6 +449,14 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
+		//Check cache
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			auto it = m_minVoltageCache.find(cap);
+			if(it != m_minVoltageCache.end())
+				return it->second;
+		}
+
 		//Loop over samples and find the minimum
 		float tmp = FLT_MAX;
 		for(float f : cap->m_samples)
@@ -433,6 +464,10 @@ public:
 			if(f < tmp)
 				tmp = f;
 		}
+
+		//Add to cache
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_minVoltageCache[cap] = tmp;
 		return tmp;
 	}
 
@@ -456,6 +491,14 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
+		//Check cache
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			auto it = m_maxVoltageCache.find(cap);
+			if(it != m_maxVoltageCache.end())
+				return it->second;
+		}
+
 		//Loop over samples and find the maximum
 		float tmp = -FLT_MAX;
 		for(float f : cap->m_samples)
@@ -463,6 +506,10 @@ public:
 			if(f > tmp)
 				tmp = f;
 		}
+
+		//Add to cache
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_maxVoltageCache[cap] = tmp;
 		return tmp;
 	}
 
@@ -486,6 +533,14 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
+		//Check cache, so a stack of measurement filters on one channel only scans the waveform once
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			auto it = m_baseVoltageCache.find(cap);
+			if(it != m_baseVoltageCache.end())
+				return it->second;
+		}
+
 		float vmin = GetMinVoltage(cap);
 		float vmax = GetMaxVoltage(cap);
 		float delta = vmax - vmin;
@@ -505,7 +560,12 @@ public:
 		}
 
 		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		float v = fbin*delta + vmin;
+
+		//Add to cache
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_baseVoltageCache[cap] = v;
+		return v;
 	}
 
 	/**
@@ -528,6 +588,14 @@ public:
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
+		//Check cache, so a stack of measurement filters on one channel only scans the waveform once
+		{
+			std::lock_guard<std::mutex> lock(m_cacheMutex);
+			auto it = m_topVoltageCache.find(cap);
+			if(it != m_topVoltageCache.end())
+				return it->second;
+		}
+
 		float vmin = GetMinVoltage(cap);
 		float vmax = GetMaxVoltage(cap);
 		float delta = vmax - vmin;
@@ -547,7 +615,12 @@ public:
 		}
 
 		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		float v = fbin*delta + vmin;
+
+		//Add to cache
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_topVoltageCache[cap] = v;
+		return v;
 	}
 
 	/**
@@ -876,6 +949,259 @@ public:
 			SampleOnRisingEdges(sdata, uclock, samples);
 	}
 
+	/**
+		@brief Samples a digital bus waveform on clock edges, packing each bus sample into a single word
+
+		Lane j of the bus maps to bit j of the output word; at most 16 lanes are packed and any additional
+		lanes are ignored. Packing at sampling time avoids allocating a std::vector<bool> per sampled clock
+		edge, and lets decoders consume whole bus words with a single load instead of a per-lane bit test.
+
+		@param data			The bus to sample. Must be a sparse digital bus waveform.
+		@param clock		The clock signal to use. Must be sparse or uniform digital.
+		@param samples		Output waveform
+		@param risingOnly	True to sample on rising clock edges only, false to sample on all edges
+	 */
+	template<class R>
+	__attribute__((noinline))
+	static void SampleDigitalBusPacked(
+		SparseDigitalBusWaveform* data,
+		R* clock,
+		SparseWaveform<uint16_t>& samples,
+		bool risingOnly)
+	{
+		//Compile-time check to make sure inputs are correct types
+		AssertTypeIsDigitalWaveform(clock);
+
+		samples.clear();
+		samples.SetGpuAccessHint(AcceleratorBuffer<uint16_t>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
+
+		size_t len = clock->size();
+		size_t dlen = data->size();
+
+		size_t ndata = 0;
+		for(size_t i=1; i<len; i++)
+		{
+			//Throw away clock samples until we find an edge of interest
+			if(risingOnly)
+			{
+				if(!(clock->m_samples[i] && !clock->m_samples[i-1]))
+					continue;
+			}
+			else if(clock->m_samples[i] == clock->m_samples[i-1])
+				continue;
+
+			//Throw away data samples until the data is synced with us
+			int64_t clkstart = GetOffsetScaled(clock, i);
+			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
+				ndata ++;
+			if(ndata >= dlen)
+				break;
+
+			//Pack the bus lanes into a single word
+			auto& bits = data->m_samples[ndata];
+			size_t width = std::min(bits.size(), (size_t)16);
+			uint16_t word = 0;
+			for(size_t j=0; j<width; j++)
+			{
+				if(bits[j])
+					word |= (1 << j);
+			}
+
+			//Add the new sample
+			samples.m_offsets.push_back(clkstart);
+			samples.m_samples.push_back(word);
+		}
+
+		//Compute sample durations
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			FillDurationsAVX2(samples);
+		else
+		#endif
+			FillDurationsGeneric(samples);
+
+		samples.MarkModifiedFromCpu();
+	}
+
+	/**
+		@brief Samples a digital bus waveform on the rising edges of a clock, packing each bus sample
+		into a single word
+
+		See SampleDigitalBusPacked() for the word format.
+
+		@param data		The bus to sample. Must be a sparse digital bus waveform.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform
+	 */
+	static void SampleDigitalBusOnRisingEdgesPackedBase(
+		WaveformBase* data, WaveformBase* clock, SparseWaveform<uint16_t>& samples)
+	{
+		data->PrepareForCpuAccess();
+		clock->PrepareForCpuAccess();
+		samples.PrepareForCpuAccess();
+
+		auto sdata = dynamic_cast<SparseDigitalBusWaveform*>(data);
+
+		auto uclock = dynamic_cast<UniformDigitalWaveform*>(clock);
+		auto sclock = dynamic_cast<SparseDigitalWaveform*>(clock);
+
+		if(sdata && uclock)
+			SampleDigitalBusPacked(sdata, uclock, samples, true);
+		else if(sdata && sclock)
+			SampleDigitalBusPacked(sdata, sclock, samples, true);
+	}
+
+	/**
+		@brief Samples a digital bus waveform on all edges of a clock, packing each bus sample into a single word
+
+		See SampleDigitalBusPacked() for the word format.
+
+		@param data		The bus to sample. Must be a sparse digital bus waveform.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform
+	 */
+	static void SampleDigitalBusOnAnyEdgesPackedBase(
+		WaveformBase* data, WaveformBase* clock, SparseWaveform<uint16_t>& samples)
+	{
+		data->PrepareForCpuAccess();
+		clock->PrepareForCpuAccess();
+		samples.PrepareForCpuAccess();
+
+		auto sdata = dynamic_cast<SparseDigitalBusWaveform*>(data);
+
+		auto uclock = dynamic_cast<UniformDigitalWaveform*>(clock);
+		auto sclock = dynamic_cast<SparseDigitalWaveform*>(clock);
+
+		if(sdata && uclock)
+			SampleDigitalBusPacked(sdata, uclock, samples, false);
+		else if(sdata && sclock)
+			SampleDigitalBusPacked(sdata, sclock, samples, false);
+	}
+
+	/**
+		@brief Samples up to 16 separate digital lanes on the rising edges of a clock in a single pass,
+		packing lane k into bit k of the output word
+
+		This replaces one sampling pass over the clock per lane with a single shared pass, so decoding
+		a multi-lane parallel interface only walks the (typically much longer) clock waveform once.
+
+		@param lanes	The lanes to sample. Each must be sparse or uniform digital; others are skipped.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform
+	 */
+	template<class R>
+	__attribute__((noinline))
+	static void SampleDigitalLanesOnRisingEdges(
+		const std::vector<WaveformBase*>& lanes,
+		R* clock,
+		SparseWaveform<uint16_t>& samples)
+	{
+		//Compile-time check to make sure inputs are correct types
+		AssertTypeIsDigitalWaveform(clock);
+
+		samples.clear();
+		samples.SetGpuAccessHint(AcceleratorBuffer<uint16_t>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
+
+		//Look up each lane's concrete type once, then track a per-lane data cursor through the shared pass
+		struct LaneState
+		{
+			SparseDigitalWaveform*	m_sparse;
+			UniformDigitalWaveform*	m_uniform;
+			size_t					m_len;
+			size_t					m_cursor;
+		};
+		std::vector<LaneState> states;
+		for(auto lane : lanes)
+		{
+			LaneState state;
+			state.m_sparse = dynamic_cast<SparseDigitalWaveform*>(lane);
+			state.m_uniform = dynamic_cast<UniformDigitalWaveform*>(lane);
+			if(!state.m_sparse && !state.m_uniform)
+				continue;
+			state.m_len = lane->size();
+			state.m_cursor = 0;
+			states.push_back(state);
+		}
+		size_t nlanes = std::min(states.size(), (size_t)16);
+
+		size_t len = clock->size();
+		for(size_t i=1; i<len; i++)
+		{
+			//Throw away clock samples until we find a rising edge
+			if(!(clock->m_samples[i] && !clock->m_samples[i-1]))
+				continue;
+
+			int64_t clkstart = GetOffsetScaled(clock, i);
+
+			//Advance every lane to the sample containing this edge and pack its value
+			uint16_t word = 0;
+			bool done = false;
+			for(size_t k=0; k<nlanes; k++)
+			{
+				auto& state = states[k];
+				while( (state.m_cursor+1 < state.m_len) &&
+					(GetOffsetScaled(state.m_sparse, state.m_uniform, state.m_cursor+1) < clkstart) )
+				{
+					state.m_cursor ++;
+				}
+				if(state.m_cursor >= state.m_len)
+				{
+					done = true;
+					break;
+				}
+
+				bool value = state.m_sparse ?
+					(bool)state.m_sparse->m_samples[state.m_cursor] :
+					(bool)state.m_uniform->m_samples[state.m_cursor];
+				if(value)
+					word |= (1 << k);
+			}
+			if(done)
+				break;
+
+			//Add the new sample
+			samples.m_offsets.push_back(clkstart);
+			samples.m_samples.push_back(word);
+		}
+
+		//Compute sample durations
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			FillDurationsAVX2(samples);
+		else
+		#endif
+			FillDurationsGeneric(samples);
+
+		samples.MarkModifiedFromCpu();
+	}
+
+	/**
+		@brief Samples up to 16 separate digital lanes on the rising edges of a clock in a single pass,
+		packing lane k into bit k of the output word
+
+		See SampleDigitalLanesOnRisingEdges() for details.
+
+		@param lanes	The lanes to sample. Each must be sparse or uniform digital; others are skipped.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform
+	 */
+	static void SampleDigitalLanesOnRisingEdgesBase(
+		const std::vector<WaveformBase*>& lanes, WaveformBase* clock, SparseWaveform<uint16_t>& samples)
+	{
+		for(auto lane : lanes)
+			lane->PrepareForCpuAccess();
+		clock->PrepareForCpuAccess();
+		samples.PrepareForCpuAccess();
+
+		auto uclock = dynamic_cast<UniformDigitalWaveform*>(clock);
+		auto sclock = dynamic_cast<SparseDigitalWaveform*>(clock);
+
+		if(uclock)
+			SampleDigitalLanesOnRisingEdges(lanes, uclock, samples);
+		else if(sclock)
+			SampleDigitalLanesOnRisingEdges(lanes, sclock, samples);
+	}
+
 	/**
 		@brief Samples a waveform on the falling edges of a clock
 
@@ -1130,11 +1456,201 @@ public:
 
 	static void ClearAnalysisCache();
 
+	///@brief Results of a full-record min/max/sum reduction, see GetOrComputeReduction()
+	struct ReductionResults
+	{
+		float m_min;
+		float m_max;
+		double m_sum;
+		size_t m_count;
+	};
+
+	ReductionResults GetOrComputeReduction(
+		WaveformBase* data,
+		StatisticsEngine& engine,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Memoization of refresh results
+
+	virtual bool IsRefreshNeeded() override;
+	virtual void OnRefreshed() override;
+
+	/**
+		@brief Checks if this filter's outputs are a pure function of its inputs and parameters
+
+		Returns true for the vast majority of filters, enabling the scheduler to skip evaluation when inputs and
+		parameters are identical to the previous run. Filters with side effects (e.g. writing to files) or state not
+		captured by their output waveforms should override this to return false so they run every graph execution.
+	 */
+	virtual bool ShouldMemoize()
+	{ return true; }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Output caching across configuration changes
+
+	/**
+		@brief One retained output set: the input/parameter hash it was computed under, the output waveforms,
+		and any protocol packets (for PacketDecoder subclasses)
+	 */
+	struct CachedOutputSet
+	{
+		///@brief Hash of the inputs and parameters these outputs were computed from
+		uint64_t m_hash;
+
+		///@brief Retained output waveform for each stream (null for streams that had no data)
+		std::vector<WaveformBase*> m_outputs;
+
+		///@brief Retained protocol packets (only used by PacketDecoder subclasses)
+		std::vector<Packet*> m_packets;
+	};
+
+	/**
+		@brief Returns how many previously computed configurations this filter may retain for reuse
+
+		IsRefreshNeeded() already lets the scheduler skip a filter whose inputs and parameters are identical to
+		its last run. The output cache extends this across configuration changes: when a heavyweight decoder's
+		parameters are toggled away and back, or its input reverts to a previously seen revision, the outputs
+		computed earlier are reinstalled instead of re-running the whole decode.
+
+		The default of zero disables the cache. Expensive decoders whose settings get flipped interactively
+		(flash command set decoders and similar) should override this with a small number; cached waveforms
+		stay resident in memory until evicted, flushed by memory pressure, or the filter is destroyed.
+	 */
+	virtual size_t GetOutputCacheDepth()
+	{ return 0; }
+
+	bool TryRestoreCachedOutputs();
+	void FlushOutputCache();
+
+	static bool FlushAllOutputCaches();
+
+protected:
+	void StashOutputsToCache();
+	void FreeCachedOutputSet(CachedOutputSet& entry);
+
+	//Hooks for PacketDecoder to retain protocol packets alongside the cached waveforms
+	virtual void StashPacketsToCache(CachedOutputSet& entry);
+	virtual void RestorePacketsFromCache(CachedOutputSet& entry);
+	virtual void FreeCachedPackets(CachedOutputSet& entry);
+
+	///@brief Retained output sets from previous configurations, most recently stashed last
+	std::list<CachedOutputSet> m_outputCache;
+
+	///@brief Mutex guarding all output cache lists (memory pressure may flush them from any thread)
+	static std::mutex m_outputCacheMutex;
+
+public:
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Spilling of idle intermediate outputs (see FilterSpillEngine)
+
+	virtual WaveformBase* GetData(size_t stream) override;
+
+	///@brief Checks if our output waveforms are currently spilled to the scratch file
+	bool HasSpilledOutputs()
+	{ return m_hasSpilledOutputs; }
+
+protected:
+	///@brief True if our output waveforms have been spilled to disk by the FilterSpillEngine
+	std::atomic<bool> m_hasSpilledOutputs;
+
+public:
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Shared subexpression elimination
+
+	uint64_t GetStructuralHash();
+	bool IsEquivalentTo(Filter* rhs);
+
+	/**
+		@brief Checks if the scheduler may merge this filter with a structurally equivalent instance
+
+		Requires both the global enable flag (g_filterDedupEnabled) and that this filter is a pure function of its
+		inputs and parameters (see ShouldMemoize()). Individual instances can be opted out with
+		SetDeduplicationAllowed(), e.g. if the user wants two copies of a filter so they can tweak one of them.
+	 */
+	bool CanDeduplicate()
+	{ return m_dedupAllowed && ShouldMemoize(); }
+
+	///@brief Opts this instance in or out of shared subexpression elimination (see CanDeduplicate())
+	void SetDeduplicationAllowed(bool allowed)
+	{ m_dedupAllowed = allowed; }
+
+	///@brief Checks if this instance is allowed to participate in shared subexpression elimination
+	bool IsDeduplicationAllowed()
+	{ return m_dedupAllowed; }
+
+	void BorrowOutputsFrom(Filter* leader);
+
+	/**
+		@brief Marks this filter for execution on a remote offload worker
+
+		Has no effect unless an offload client has been attached to the executor with
+		FilterGraphExecutor::SetOffloadClient(); see FilterGraphOffloadClient.
+	 */
+	void SetOffloadHint(bool hint)
+	{ m_offloadHint = hint; }
+
+	///@brief Checks if this filter has been marked for execution on a remote offload worker
+	bool GetOffloadHint()
+	{ return m_offloadHint; }
+
+	/**
+		@brief Sets the callback invoked each time this filter publishes a partial result
+
+		Normally installed by FilterGraphExecutor (see FilterGraphExecutor::SetPartialResultCallback()) rather than
+		called directly.
+	 */
+	void SetPartialResultCallback(std::function<void(Filter*, size_t)> cb)
+	{ m_partialResultCallback = cb; }
+
+protected:
+	void PublishPartialResult(size_t stream = 0);
+
+	///@brief Callback invoked each time we publish a partial result (see PublishPartialResult())
+	std::function<void(Filter*, size_t)> m_partialResultCallback;
+
+protected:
+	static void DetachBorrowers(WaveformBase* wfm);
+
+	///@brief True if this filter has been marked for execution on a remote offload worker
+	bool m_offloadHint;
+
+	///@brief False if this instance has been opted out of shared subexpression elimination
+	bool m_dedupAllowed;
+
+	///@brief Waveforms in our output streams which are owned by another filter (see BorrowOutputsFrom())
+	std::set<WaveformBase*> m_borrowedOutputs;
+
+	///@brief Map from a waveform to the set of filters currently borrowing it as an output
+	static std::map<WaveformBase*, std::set<Filter*>> m_waveformBorrowers;
+
+	///@brief Mutex for m_waveformBorrowers
+	static std::mutex m_borrowMutex;
+
+protected:
+	uint64_t ComputeRefreshHash();
+
+	///@brief True if m_refreshHash and m_memoizedOutputs describe a completed Refresh() of this configuration
+	bool m_refreshStateValid;
+
+	///@brief Hash of our inputs and parameters as of the last completed Refresh()
+	uint64_t m_refreshHash;
+
+	///@brief Identity and revision of each of our output waveforms as of the last completed Refresh()
+	std::vector<WaveformCacheKey> m_memoizedOutputs;
+
 protected:
 	//Helpers for sparse waveforms
 	static void FillDurationsGeneric(SparseWaveformBase& wfm);
 #ifdef __x86_64__
 	static void FillDurationsAVX2(SparseWaveformBase& wfm);
+
+	//Vectorized edge extraction kernels
+	static void FindZeroCrossingsAVX2(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
+	static void FindRisingEdgesAVX2(UniformAnalogWaveform* data, float threshold, std::vector<int64_t>& edges);
 #endif
 
 public:
@@ -1155,6 +1671,7 @@ protected:
 public:
 	typedef Filter* (*CreateProcType)(const std::string&);
 	static void DoAddDecoderClass(const std::string& name, CreateProcType proc);
+	static void AddLazyDecoderClass(const std::string& name, const std::string& pluginPath);
 
 	static void EnumProtocols(std::vector<std::string>& names);
 	static Filter* CreateFilter(const std::string& protocol, const std::string& color = "#ffffff");
@@ -1164,6 +1681,9 @@ protected:
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
 
+	///@brief Map of filter names to the plugin module providing them, for plugins not yet loaded
+	static std::map<std::string, std::string> m_lazyCreateprocs;
+
 	//Object enumeration
 	static std::set<Filter*> m_filters;
 
@@ -1173,6 +1693,14 @@ protected:
 	//Caching
 	static std::mutex m_cacheMutex;
 	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_zeroCrossingCache;
+	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_risingEdgeCache;
+
+	//Memoized waveform statistics, valid for a single graph execution (cleared by ClearAnalysisCache)
+	static std::map<WaveformBase*, float> m_minVoltageCache;
+	static std::map<WaveformBase*, float> m_maxVoltageCache;
+	static std::map<WaveformBase*, ReductionResults> m_reductionCache;
+	static std::map<WaveformBase*, float> m_baseVoltageCache;
+	static std::map<WaveformBase*, float> m_topVoltageCache;
 };
 
 #define PROTOCOL_DECODER_INITPROC(T) \
@@ -0,0 +1,240 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterCostModel
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "FilterCostModel.h"
+#include "PipelineCacheManager.h"
+
+using namespace std;
+
+unique_ptr<FilterCostModel> g_filterCostModel;
+
+///@brief Key of our blob in the pipeline cache raw data store
+static const string g_costModelCacheKey = "filter_cost_model";
+
+///@brief Version number of the serialized calibration data
+static const uint32_t g_costModelVersion = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+FilterCostModel::FilterCostModel()
+	: m_loaded(false)
+	, m_updatesSinceSave(0)
+{
+}
+
+FilterCostModel::~FilterCostModel()
+{
+	lock_guard<mutex> lock(m_mutex);
+	Save();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cost queries
+
+/**
+	@brief Checks whether the GPU path of a filter is predicted to be faster than the CPU path for a given input size
+
+	If we have no calibration data for this filter and size class yet, defaults to the GPU path (the previous
+	hardcoded behavior). Each path is tried at least once per size class so the model converges after two runs.
+
+	@param key	Name of the filter kernel (should be unique per filter class)
+	@param size	Input size, in samples
+
+	@return True if the GPU path should be used
+ */
+bool FilterCostModel::PreferGpu(const string& key, size_t size)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(!m_loaded)
+		Load();
+
+	auto kit = m_costs.find(key);
+	if(kit == m_costs.end())
+		return true;
+	auto bit = kit->second.find(SizeClass(size));
+	if(bit == kit->second.end())
+		return true;
+	auto& bucket = bit->second;
+
+	//Try each path at least once per size class so there is always something to compare
+	if(bucket.m_gpu.m_count == 0)
+		return true;
+	if(bucket.m_cpu.m_count == 0)
+		return false;
+
+	//Compare mean execution times (cross multiplied to avoid the divisions)
+	return (bucket.m_gpu.m_totalSeconds * bucket.m_cpu.m_count) <=
+		(bucket.m_cpu.m_totalSeconds * bucket.m_gpu.m_count);
+}
+
+/**
+	@brief Records the observed execution time of one run of a filter kernel
+
+	@param key		Name of the filter kernel (should be unique per filter class)
+	@param gpu		True if the GPU path was used, false for the CPU path
+	@param size		Input size, in samples
+	@param seconds	Observed execution time
+ */
+void FilterCostModel::RecordSample(const string& key, bool gpu, size_t size, double seconds)
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(!m_loaded)
+		Load();
+
+	auto& bucket = m_costs[key][SizeClass(size)];
+	auto& path = gpu ? bucket.m_gpu : bucket.m_cpu;
+
+	//Age out old measurements so the model can track thermal throttling, clock changes, etc.
+	if(path.m_count >= 256)
+	{
+		path.m_totalSeconds *= 0.5;
+		path.m_count /= 2;
+	}
+
+	path.m_totalSeconds += seconds;
+	path.m_count ++;
+
+	//Periodically push the calibration to the pipeline cache so a crash doesn't lose it
+	m_updatesSinceSave ++;
+	if(m_updatesSinceSave >= 64)
+	{
+		m_updatesSinceSave = 0;
+		Save();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Serialization
+
+/**
+	@brief Loads calibration data from the pipeline cache raw data store
+
+	The caller must hold m_mutex.
+ */
+void FilterCostModel::Load()
+{
+	m_loaded = true;
+
+	if(!g_pipelineCacheMgr)
+		return;
+	auto blob = g_pipelineCacheMgr->LookupRaw(g_costModelCacheKey);
+	if(!blob)
+		return;
+
+	const uint8_t* p = &(*blob)[0];
+	size_t len = blob->size();
+	size_t pos = 0;
+	auto read = [&p, &pos, len](void* dst, size_t n)
+	{
+		if(pos + n > len)
+			return false;
+		memcpy(dst, p + pos, n);
+		pos += n;
+		return true;
+	};
+
+	uint32_t version = 0;
+	if(!read(&version, sizeof(version)) || (version != g_costModelVersion))
+	{
+		LogTrace("Discarding filter cost model with unexpected version %u\n", version);
+		return;
+	}
+
+	//Read rows until we run out of data, stopping at the first truncated record
+	while(pos < len)
+	{
+		uint32_t keylen = 0;
+		if(!read(&keylen, sizeof(keylen)) || (pos + keylen > len))
+			break;
+		string key(reinterpret_cast<const char*>(p + pos), keylen);
+		pos += keylen;
+
+		uint32_t sclass = 0;
+		BucketCost bucket;
+		if(!read(&sclass, sizeof(sclass)))
+			break;
+		if(!read(&bucket.m_cpu.m_totalSeconds, sizeof(double)))
+			break;
+		if(!read(&bucket.m_cpu.m_count, sizeof(uint64_t)))
+			break;
+		if(!read(&bucket.m_gpu.m_totalSeconds, sizeof(double)))
+			break;
+		if(!read(&bucket.m_gpu.m_count, sizeof(uint64_t)))
+			break;
+
+		m_costs[key][sclass] = bucket;
+	}
+
+	LogTrace("Loaded filter cost model (%zu kernels)\n", m_costs.size());
+}
+
+/**
+	@brief Stores calibration data to the pipeline cache raw data store
+
+	The caller must hold m_mutex.
+ */
+void FilterCostModel::Save()
+{
+	if(!g_pipelineCacheMgr)
+		return;
+
+	auto blob = make_shared< vector<uint8_t> >();
+	auto append = [&blob](const void* src, size_t n)
+	{
+		auto q = reinterpret_cast<const uint8_t*>(src);
+		blob->insert(blob->end(), q, q + n);
+	};
+
+	append(&g_costModelVersion, sizeof(g_costModelVersion));
+	for(auto& kit : m_costs)
+	{
+		for(auto& bit : kit.second)
+		{
+			uint32_t keylen = kit.first.length();
+			append(&keylen, sizeof(keylen));
+			append(kit.first.data(), keylen);
+			append(&bit.first, sizeof(uint32_t));
+			append(&bit.second.m_cpu.m_totalSeconds, sizeof(double));
+			append(&bit.second.m_cpu.m_count, sizeof(uint64_t));
+			append(&bit.second.m_gpu.m_totalSeconds, sizeof(double));
+			append(&bit.second.m_gpu.m_count, sizeof(uint64_t));
+		}
+	}
+
+	g_pipelineCacheMgr->StoreRaw(g_costModelCacheKey, blob);
+}
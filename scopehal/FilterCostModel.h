@@ -0,0 +1,123 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterCostModel
+	@ingroup core
+ */
+
+#ifndef FilterCostModel_h
+#define FilterCostModel_h
+
+/**
+	@brief Calibrated cost model for choosing between the CPU and GPU execution paths of a filter
+	@ingroup core
+
+	For small records the fixed overhead of a GPU dispatch outweighs the compute win; for large ones the CPU
+	loses badly. The crossover point differs per machine (and per filter), so rather than hardcoding thresholds
+	we measure: filters with both paths report the observed execution time of each run via RecordSample(), and
+	consult PreferGpu() to pick the path predicted to be faster for the current input size.
+
+	Costs are bucketed by power-of-two size class per filter kernel. Each path is tried at least once per size
+	class so there is always something to compare, after which the faster observed mean wins. The calibration
+	is persisted with the rest of the per-host GPU state through PipelineCacheManager, so a fresh session
+	starts out already tuned for this machine.
+
+	Filters without a measurable benefit (or with only one implementation) simply never call us; uncalibrated
+	lookups default to the GPU path, preserving the previous behavior.
+ */
+class FilterCostModel
+{
+public:
+	FilterCostModel();
+	~FilterCostModel();
+
+	bool PreferGpu(const std::string& key, size_t size);
+	void RecordSample(const std::string& key, bool gpu, size_t size, double seconds);
+
+protected:
+	void Load();
+	void Save();
+
+	/**
+		@brief Calculates the size class of a given input size (same bucketing as WaveformPool)
+
+		@param size	Input size, in samples
+	 */
+	static size_t SizeClass(size_t size)
+	{
+		size_t sclass = 0;
+		while( (1UL << sclass) < size)
+			sclass ++;
+		return sclass;
+	}
+
+	///@brief Observed cost of one execution path of a filter within one size class
+	struct PathCost
+	{
+		PathCost()
+			: m_totalSeconds(0)
+			, m_count(0)
+		{}
+
+		///@brief Total execution time of all recorded runs, in seconds
+		double m_totalSeconds;
+
+		///@brief Number of runs recorded
+		uint64_t m_count;
+	};
+
+	///@brief Observed cost of both execution paths of a filter within one size class
+	struct BucketCost
+	{
+		///@brief Cost of the CPU path
+		PathCost m_cpu;
+
+		///@brief Cost of the GPU path
+		PathCost m_gpu;
+	};
+
+	///@brief Mutex to interlock access to the STL containers
+	std::mutex m_mutex;
+
+	///@brief Observed costs, keyed by filter kernel name and then input size class
+	std::map<std::string, std::map<uint32_t, BucketCost> > m_costs;
+
+	///@brief True if we have tried to load calibration data from the pipeline cache
+	bool m_loaded;
+
+	///@brief Number of samples recorded since the last save
+	size_t m_updatesSinceSave;
+};
+
+extern std::unique_ptr<FilterCostModel> g_filterCostModel;
+
+#endif
@@ -36,18 +36,181 @@
 
 #include "scopehal.h"
 
+#include <cinttypes>
+#include <fstream>
+
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// NUMA topology discovery
+
+/**
+	@brief Returns the CPUs belonging to each NUMA node, read from sysfs
+
+	Returns a single node containing no CPUs on platforms without NUMA support (callers should
+	treat an empty CPU list as "don't pin").
+ */
+static vector<vector<int>> GetNumaTopology()
+{
+	vector<vector<int>> nodes;
+
+	#ifdef __linux__
+	for(int n = 0; ; n ++)
+	{
+		ifstream f(string("/sys/devices/system/node/node") + to_string(n) + "/cpulist");
+		if(!f)
+			break;
+
+		//Parse the cpulist (comma separated list of single CPUs or dash separated ranges)
+		vector<int> cpus;
+		string list;
+		f >> list;
+		size_t pos = 0;
+		while(pos < list.length())
+		{
+			int lo = atoi(list.c_str() + pos);
+			int hi = lo;
+			size_t dash = list.find('-', pos);
+			size_t comma = list.find(',', pos);
+			if( (dash != string::npos) && ( (comma == string::npos) || (dash < comma) ) )
+				hi = atoi(list.c_str() + dash + 1);
+			for(int c = lo; c <= hi; c ++)
+				cpus.push_back(c);
+
+			if(comma == string::npos)
+				break;
+			pos = comma + 1;
+		}
+		nodes.push_back(cpus);
+	}
+	#endif
+
+	if(nodes.empty())
+		nodes.push_back(vector<int>());
+	return nodes;
+}
+
+///@brief Returns the number of NUMA nodes in the system (1 on non-NUMA platforms)
+size_t FilterGraphExecutor::GetNumaNodeCount()
+{
+	return GetNumaTopology().size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiling helpers
+
+///@brief Returns the CPU time consumed by the calling thread, in fs
+static int64_t GetThreadCpuTimeFs()
+{
+	#ifdef _WIN32
+		FILETIME creation;
+		FILETIME exited;
+		FILETIME kernel;
+		FILETIME user;
+		if(GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user))
+		{
+			//FILETIME is in 100ns units
+			uint64_t k = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+			uint64_t u = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+			return (k + u) * 100000000LL;
+		}
+		return 0;
+	#else
+		timespec ts;
+		if(0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+			return 0;
+		return ts.tv_sec * static_cast<int64_t>(FS_PER_SECOND) + ts.tv_nsec * 1000000LL;
+	#endif
+}
+
+/**
+	@brief Formats the most recent profiled run's statistics as Chrome trace JSON
+
+	Save the result to a .json file and load it in chrome://tracing or Perfetto. One complete ("X") event is
+	emitted per node on a track per worker thread, with CPU/GPU time, transfer volume, and allocation counts
+	attached as event arguments.
+
+	Only meaningful after a run with profiling enabled (see SetProfilingEnabled()).
+ */
+string FilterGraphExecutor::GetChromeTrace()
+{
+	lock_guard<mutex> lock(m_perfStatsMutex);
+
+	string json = "{\"traceEvents\":[";
+	bool first = true;
+	for(auto& it : m_lastPerfStats)
+	{
+		auto& s = it.second;
+
+		string name = "node";
+		auto chan = dynamic_cast<InstrumentChannel*>(it.first);
+		if(chan)
+			name = chan->GetDisplayName();
+		name = str_replace("\\", "\\\\", name);
+		name = str_replace("\"", "\\\"", name);
+
+		//Times are in microseconds in the trace format
+		char tmp[512];
+		snprintf(tmp, sizeof(tmp),
+			"%s{\"name\":\"%s\",\"cat\":\"filter\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+			"\"ts\":%.3f,\"dur\":%.3f,"
+			"\"args\":{\"cpuTimeUs\":%.3f,\"gpuTimeUs\":%.3f,"
+			"\"bytesToGpu\":%llu,\"bytesToCpu\":%llu,\"allocations\":%llu}}",
+			first ? "" : ",",
+			name.c_str(),
+			s.m_thread,
+			s.m_startTimeFs * 1e-9,
+			s.m_wallTimeFs * 1e-9,
+			s.m_cpuTimeFs * 1e-9,
+			s.m_gpuTimeFs * 1e-9,
+			static_cast<unsigned long long>(s.m_bytesToGpu),
+			static_cast<unsigned long long>(s.m_bytesToCpu),
+			static_cast<unsigned long long>(s.m_allocations));
+		json += tmp;
+		first = false;
+	}
+	json += "]}";
+	return json;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
-FilterGraphExecutor::FilterGraphExecutor(size_t numThreads)
-	: m_allWorkersComplete(true)
+/**
+	@brief Creates the executor thread pool
+
+	@param numThreads	Number of worker threads to spawn
+	@param numaAware	If set, worker threads are distributed round-robin across NUMA nodes, pinned to the
+						CPUs of their node, and prefer stealing work from same-node workers. Buffers allocated
+						by a worker are placed on its node so filter chains stay node-local.
+ */
+FilterGraphExecutor::FilterGraphExecutor(size_t numThreads, bool numaAware)
+	: m_planTopologyVersion(0)
+	, m_planValid(false)
+	, m_numIncompleteNodes(0)
+	, m_allWorkersComplete(true)
 	, m_terminating(false)
+	, m_profilingEnabled(false)
+	, m_runStartTime(0)
+	, m_verifyMemoization(getenv("SCOPEHAL_VERIFY_MEMOIZATION") != nullptr)
 {
-	//Create our thread pool
+	//Figure out thread-to-node assignments up front so stealing order can use them
+	if(numaAware)
+	{
+		auto topology = GetNumaTopology();
+		if( (topology.size() > 1) && !topology[0].empty() )
+		{
+			for(size_t i=0; i<numThreads; i++)
+				m_threadNumaNode.push_back(i % topology.size());
+		}
+	}
+
+	//Create our thread pool, one work-stealing queue per thread
 	for(size_t i=0; i<numThreads; i++)
+	{
+		m_queues.push_back(make_unique<WorkQueue>());
 		m_threads.push_back(make_unique<thread>(&FilterGraphExecutor::ExecutorThread, this, i));
+	}
 }
 
 FilterGraphExecutor::~FilterGraphExecutor()
@@ -71,10 +234,16 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 	if(nodes.empty())
 		return;
 
+	//Record the whole evaluation as one span; tagged with the caller's trace context, so it can be
+	//correlated with the acquisition it's processing (see LatencyTracer::SetCurrentCapture)
+	LatencyTracerSpan traceSpan("graph", "evaluate");
+
 	{
 		lock_guard<mutex> lock(m_perfStatsMutex);
 		m_currentExecutionTime.clear();
+		m_currentPerfStats.clear();
 	}
+	m_runStartTime = GetTime();
 
 	{
 		lock_guard<mutex> lock(m_mutex);
@@ -82,11 +251,177 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 		if(!m_allWorkersComplete)
 			LogWarning("Entering RunBlocking() but not all workers are complete from previous run\n");
 
-		m_incompleteNodes = nodes;
-		m_incompleteNodes.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
+		set<FlowGraphNode*> pending = nodes;
+		pending.erase(nullptr);	//don't crash if a null filter somehow ended up in the list
 
-		m_runnableNodes.clear();
-		m_allWorkersComplete = false;
+		//Parameter edits don't bump the topology version, so re-verify any cached dedup pairings each run.
+		//(Skip this if the version moved: the plan is stale anyway, and a paired node may have been destroyed.)
+		uint64_t topologyVersion = g_filterGraphTopologyVersion;
+		if(m_planValid && (topologyVersion == m_planTopologyVersion) && !m_dedupLeader.empty())
+		{
+			for(auto& it : m_dedupLeader)
+			{
+				auto dup = dynamic_cast<Filter*>(it.first);
+				auto leader = dynamic_cast<Filter*>(it.second);
+				if(!g_filterDedupEnabled || !dup->CanDeduplicate() || !leader->CanDeduplicate() ||
+					!dup->IsEquivalentTo(leader))
+				{
+					m_planValid = false;
+					break;
+				}
+			}
+		}
+
+		//(Re)compile the execution plan if the graph has been rewired, or we're running a different node set,
+		//since the plan was built. Only edges within the set of nodes being evaluated count as dependencies.
+		if(!m_planValid || (topologyVersion != m_planTopologyVersion) || (pending != m_planNodes) )
+		{
+			//Find structurally equivalent filters: only the first instance of each group actually runs,
+			//the others share its output waveforms
+			m_dedupLeader.clear();
+			if(g_filterDedupEnabled)
+			{
+				map<uint64_t, vector<Filter*>> groups;
+				for(auto f : pending)
+				{
+					auto filt = dynamic_cast<Filter*>(f);
+					if(filt && filt->CanDeduplicate())
+						groups[filt->GetStructuralHash()].push_back(filt);
+				}
+				for(auto& git : groups)
+				{
+					auto& group = git.second;
+					for(size_t i=1; i<group.size(); i++)
+					{
+						//Hashes can collide, so confirm equivalence before merging
+						if(group[i]->IsEquivalentTo(group[0]))
+							m_dedupLeader[group[i]] = group[0];
+					}
+				}
+			}
+
+			m_downstreamNodes.clear();
+			m_remainingDeps.clear();
+			m_initialDeps.clear();
+			m_seedNodes.clear();
+			for(auto f : pending)
+			{
+				//A duplicate's only scheduling dependency is its leader: it can run the moment the
+				//leader's outputs exist (its real inputs are the leader's inputs, which ran even earlier)
+				auto lit = m_dedupLeader.find(f);
+				if(lit != m_dedupLeader.end())
+				{
+					m_downstreamNodes[lit->second].push_back(f);
+					m_initialDeps[f] = 1;
+					continue;
+				}
+
+				size_t ndeps = 0;
+				for(size_t i=0; i<f->GetInputCount(); i++)
+				{
+					auto in = f->GetInput(i).m_channel;
+					if(pending.find(in) != pending.end())
+					{
+						m_downstreamNodes[in].push_back(f);
+						ndeps ++;
+					}
+				}
+				m_initialDeps[f] = ndeps;
+				if(ndeps == 0)
+					m_seedNodes.push_back(f);
+			}
+			//Infer output residency for each node from the declared input locations of its consumers.
+			//This lets the producing thread move each output to where it'll be read, once, rather than
+			//every consumer pulling it lazily (and several workers doing the same transfer in parallel,
+			//or bouncing a waveform back and forth between CPU and GPU consumers).
+			m_inferredResidency.clear();
+			for(auto& it : m_downstreamNodes)
+			{
+				bool wantCpu = false;
+				bool wantGpu = false;
+				for(auto consumer : it.second)
+				{
+					switch(consumer->GetInputLocation())
+					{
+						case FlowGraphNode::LOC_CPU:
+							wantCpu = true;
+							break;
+						case FlowGraphNode::LOC_GPU:
+							wantGpu = true;
+							break;
+						default:
+							break;
+					}
+				}
+
+				if(wantCpu && wantGpu)
+					m_inferredResidency[it.first] = InstrumentChannel::RES_MIRRORED;
+				else if(wantGpu)
+					m_inferredResidency[it.first] = InstrumentChannel::RES_GPU_ONLY;
+				else if(wantCpu)
+					m_inferredResidency[it.first] = InstrumentChannel::RES_CPU_ONLY;
+			}
+
+			m_planNodes = std::move(pending);
+			m_planTopologyVersion = topologyVersion;
+			m_planValid = true;
+		}
+
+		//If an offload client is attached, run marked subgraphs on the remote worker before scheduling
+		//local work. Their outputs are attached to the filter objects as if they had just refreshed,
+		//so local consumers downstream see current data.
+		set<FlowGraphNode*> offloaded;
+		if(m_offloadClient && m_offloadClient->IsConnected())
+			offloaded = RunOffloadedSubgraphs();
+
+		//Reset per-run state from the plan (no allocation on the steady-state path: the keys already exist
+		//in m_remainingDeps after the first run on a given plan)
+		for(auto& it : m_initialDeps)
+			m_remainingDeps[it.first] = it.second;
+
+		//Nodes already evaluated remotely don't run here: drop them from the incomplete count and
+		//release their downstream dependencies up front
+		for(auto f : offloaded)
+		{
+			auto dit = m_downstreamNodes.find(f);
+			if(dit == m_downstreamNodes.end())
+				continue;
+			for(auto d : dit->second)
+			{
+				if(!offloaded.count(d))
+					m_remainingDeps[d] --;
+			}
+		}
+		m_numIncompleteNodes = m_planNodes.size() - offloaded.size();
+
+		//Seed nodes with no remaining dependencies round-robin across the worker queues.
+		//The precomputed seed list is only valid when nothing was offloaded, since offloading can
+		//make additional nodes immediately runnable (and removes the offloaded seeds themselves).
+		size_t q = 0;
+		if(offloaded.empty())
+		{
+			for(auto f : m_seedNodes)
+			{
+				lock_guard<mutex> qlock(m_queues[q]->m_mutex);
+				m_queues[q]->m_nodes.push_back(f);
+				q = (q+1) % m_queues.size();
+			}
+		}
+		else
+		{
+			for(auto f : m_planNodes)
+			{
+				if(offloaded.count(f) || (m_remainingDeps[f] != 0))
+					continue;
+				lock_guard<mutex> qlock(m_queues[q]->m_mutex);
+				m_queues[q]->m_nodes.push_back(f);
+				q = (q+1) % m_queues.size();
+			}
+		}
+
+		//If the entire graph was offloaded there's nothing for the workers to do (and nobody would
+		//ever signal completion), so don't make the wait below block forever
+		m_allWorkersComplete = (m_numIncompleteNodes == 0);
 
 		Filter::ClearAnalysisCache();
 	}
@@ -95,21 +430,178 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 	m_workerCvar.notify_all();
 
 	//Block until they're finished
-	while(true)
 	{
 		unique_lock<mutex> lock(m_completionCvarMutex);
 		m_completionCvar.wait(lock, [this]{return m_allWorkersComplete;});
-
-		lock_guard<mutex> lock2(m_mutex);
-		if(m_runnableNodes.empty())
-			break;
 	}
 
 	//Update global performance stats
 	{
 		lock_guard<mutex> lock(m_perfStatsMutex);
 		m_lastExecutionTime = m_currentExecutionTime;
+		if(m_profilingEnabled)
+			m_lastPerfStats = m_currentPerfStats;
+	}
+
+	//Every consumer of an intermediate output has now run, so the output is idle until the next graph
+	//change and may be spilled to disk if memory pressure fires. Terminal nodes (the ones actually being
+	//displayed) have no downstream entry and are never offered.
+	{
+		lock_guard<mutex> lock(m_mutex);
+		auto& engine = FilterSpillEngine::GetInstance();
+		for(auto& it : m_downstreamNodes)
+		{
+			auto f = dynamic_cast<Filter*>(it.first);
+			if(f && !it.second.empty())
+				engine.MarkSpillable(f);
+		}
+	}
+}
+
+/**
+	@brief Executes marked subgraphs of the current plan on the remote offload worker
+
+	Finds the connected components of filters marked with Filter::SetOffloadHint() and sends each to the
+	worker as one unit, so intermediate waveforms never cross the network. A component is only eligible if
+	every input crossing its boundary comes from outside the plan (i.e. acquisition hardware or an already
+	evaluated filter): offload runs before the local pass, so an input produced by a local node scheduled
+	this run would still hold last run's data. Ineligible or failed components simply execute locally.
+
+	Must be called with m_mutex held and the plan compiled.
+
+	@return The set of nodes which were successfully executed remotely
+ */
+set<FlowGraphNode*> FilterGraphExecutor::RunOffloadedSubgraphs()
+{
+	set<FlowGraphNode*> offloaded;
+
+	//Find the marked filters. Dedup duplicates stay local: they borrow their leader's outputs,
+	//which is free, so shipping them over the network makes no sense.
+	set<Filter*> unvisited;
+	for(auto n : m_planNodes)
+	{
+		auto f = dynamic_cast<Filter*>(n);
+		if(f && f->GetOffloadHint() && !m_dedupLeader.count(n))
+			unvisited.emplace(f);
+	}
+	if(unvisited.empty())
+		return offloaded;
+
+	//Pull out one connected component at a time
+	while(!unvisited.empty())
+	{
+		//Flood fill from an arbitrary unvisited filter, following both input and output edges
+		//(but only between marked filters)
+		vector<Filter*> component;
+		deque<Filter*> frontier;
+		frontier.push_back(*unvisited.begin());
+		unvisited.erase(frontier.front());
+		while(!frontier.empty())
+		{
+			auto f = frontier.front();
+			frontier.pop_front();
+			component.push_back(f);
+
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = dynamic_cast<Filter*>(f->GetInput(i).m_channel);
+				if(in && unvisited.count(in))
+				{
+					frontier.push_back(in);
+					unvisited.erase(in);
+				}
+			}
+
+			auto dit = m_downstreamNodes.find(f);
+			if(dit != m_downstreamNodes.end())
+			{
+				for(auto d : dit->second)
+				{
+					auto df = dynamic_cast<Filter*>(d);
+					if(df && unvisited.count(df))
+					{
+						frontier.push_back(df);
+						unvisited.erase(df);
+					}
+				}
+			}
+		}
+		set<FlowGraphNode*> members(component.begin(), component.end());
+
+		//Check eligibility: every boundary input must come from outside the plan
+		bool eligible = true;
+		for(auto f : component)
+		{
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				auto in = f->GetInput(i).m_channel;
+				if(in && !members.count(in) && m_planNodes.count(in))
+				{
+					eligible = false;
+					break;
+				}
+			}
+			if(!eligible)
+				break;
+		}
+		if(!eligible)
+		{
+			LogTrace("Offload-marked subgraph depends on local filters scheduled this run, executing locally\n");
+			continue;
+		}
+
+		//Topologically sort the component (small, so the quadratic relaxation doesn't matter)
+		map<Filter*, size_t> indeg;
+		for(auto f : component)
+		{
+			size_t deg = 0;
+			for(size_t i=0; i<f->GetInputCount(); i++)
+			{
+				if(members.count(f->GetInput(i).m_channel))
+					deg ++;
+			}
+			indeg[f] = deg;
+		}
+		vector<Filter*> order;
+		deque<Filter*> ready;
+		for(auto& it : indeg)
+		{
+			if(it.second == 0)
+				ready.push_back(it.first);
+		}
+		while(!ready.empty())
+		{
+			auto f = ready.front();
+			ready.pop_front();
+			order.push_back(f);
+
+			for(auto g : component)
+			{
+				for(size_t i=0; i<g->GetInputCount(); i++)
+				{
+					if(g->GetInput(i).m_channel == f)
+					{
+						if(--indeg[g] == 0)
+							ready.push_back(g);
+					}
+				}
+			}
+		}
+
+		//Hand it to the worker; on failure fall back to local execution of this component
+		if(m_offloadClient->ExecuteSubgraph(order))
+			offloaded.insert(members.begin(), members.end());
+		else
+		{
+			LogWarning("Remote execution of offloaded subgraph failed, executing locally\n");
+
+			//If the connection died, don't bother trying the remaining components
+			if(!m_offloadClient->IsConnected())
+				break;
+		}
 	}
+
+	return offloaded;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -118,74 +610,194 @@ void FilterGraphExecutor::RunBlocking(const set<FlowGraphNode*>& nodes)
 /**
 	@brief Returns the next filter available to run, blocking if none are ready.
 
+	Pops from the head of our own queue first, then attempts to steal from the tail of other workers' queues.
 	Returns null if there are no remaining filters to evaluate.
  */
-FlowGraphNode* FilterGraphExecutor::GetNextRunnableNode()
+FlowGraphNode* FilterGraphExecutor::GetNextRunnableNode(size_t i)
 {
 	while(true)
 	{
-		//Check for stuff
+		//Nothing left to run anywhere? Stop
+		if(m_numIncompleteNodes == 0)
+			return nullptr;
+
+		//Check our own queue first (pop the head, so chains of dependent filters stay on this core)
 		{
-			lock_guard<mutex> lock(m_mutex);
+			auto& q = *m_queues[i];
+			lock_guard<mutex> lock(q.m_mutex);
+			if(!q.m_nodes.empty())
+			{
+				auto f = q.m_nodes.front();
+				q.m_nodes.pop_front();
+				return f;
+			}
+		}
 
-			//Nothing left to run? Stop
-			if(m_incompleteNodes.empty())
-				return nullptr;
+		//Our queue is empty, try to steal from the tail of another worker's queue.
+		//With NUMA pinning active, make two passes: same-node victims first so filter inputs
+		//stay on our memory node, then cross-node as a last resort.
+		size_t npasses = m_threadNumaNode.empty() ? 1 : 2;
+		for(size_t pass=0; pass<npasses; pass++)
+		{
+			for(size_t j=1; j<m_queues.size(); j++)
+			{
+				size_t victim = (i+j) % m_queues.size();
+				if(npasses == 2)
+				{
+					bool sameNode = (m_threadNumaNode[victim] == m_threadNumaNode[i]);
+					if(sameNode != (pass == 0) )
+						continue;
+				}
 
-			//Nothing ready to run? Update the run queue
-			if(m_runnableNodes.empty())
-				UpdateRunnable();
+				auto& q = *m_queues[victim];
+				lock_guard<mutex> lock(q.m_mutex);
+				if(!q.m_nodes.empty())
+				{
+					auto f = q.m_nodes.back();
+					q.m_nodes.pop_back();
+					return f;
+				}
+			}
+		}
+
+		//Still nothing to run, but the graph isn't finished. Block until someone completes a node.
+		//Use a timeout so we can't deadlock if the notify raced our queue scan.
+		unique_lock<mutex> lock(m_workerCvarMutex);
+		m_workerCvar.wait_for(lock, chrono::milliseconds(1));
+	}
+}
 
-			//If there is something ready to run, grab it
-			if(!m_runnableNodes.empty())
+/**
+	@brief Marks a node as complete and pushes any newly unblocked downstream nodes onto worker i's local queue
+ */
+void FilterGraphExecutor::OnNodeComplete(FlowGraphNode* node, size_t i)
+{
+	//Push any downstream nodes that just became runnable onto our own queue
+	bool newWork = false;
+	auto it = m_downstreamNodes.find(node);
+	if(it != m_downstreamNodes.end())
+	{
+		for(auto d : it->second)
+		{
+			if(m_remainingDeps[d].fetch_sub(1) == 1)
 			{
-				auto f = *m_runnableNodes.begin();
-				m_runnableNodes.erase(f);
-				m_runningNodes.emplace(f);
-				return f;
+				lock_guard<mutex> lock(m_queues[i]->m_mutex);
+				m_queues[i]->m_nodes.push_back(d);
+				newWork = true;
 			}
 		}
+	}
 
-		//Still nothing to run? Block
-		unique_lock<mutex> lock(m_workerCvarMutex);
-		m_workerCvar.wait(lock);
+	//If this was the last node, wake up the main thread (and any idle workers so they can go back to sleep)
+	if(m_numIncompleteNodes.fetch_sub(1) == 1)
+	{
+		{
+			lock_guard<mutex> lock(m_completionCvarMutex);
+			m_allWorkersComplete = true;
+		}
+		m_completionCvar.notify_all();
+		m_workerCvar.notify_all();
 	}
+
+	//Otherwise, if we made new work available, wake up anyone looking to steal it
+	else if(newWork)
+		m_workerCvar.notify_all();
 }
 
 /**
-	@brief Searches m_incompleteNodes for any that are unblocked, and adds them to m_runnableNodes
+	@brief Records content digests of a node's current outputs (memoization verification only)
 
-	Assumes m_mutex is locked
+	Called after a node's refresh (or cache restore) has fully completed, so the digests describe exactly
+	what downstream consumers will see. Entries for deleted nodes are never pruned; this is a debug
+	facility, active only when SCOPEHAL_VERIFY_MEMOIZATION is set in the environment.
  */
-void FilterGraphExecutor::UpdateRunnable()
+void FilterGraphExecutor::RecordOutputDigests(FlowGraphNode* node)
 {
-	//Do nothing if we already have other filters marked runnable
-	if(!m_runnableNodes.empty())
+	auto chan = dynamic_cast<InstrumentChannel*>(node);
+	if(!chan)
 		return;
 
-	//Look for new filters that are eligible to run
-	for(auto f : m_incompleteNodes)
+	vector<uint64_t> digests;
+	for(size_t j=0; j<chan->GetStreamCount(); j++)
 	{
-		//If the filter is already running, nothing we can do
-		if(m_runningNodes.find(f) != m_runningNodes.end())
-			continue;
+		auto data = chan->GetData(j);
+		digests.push_back(data ? WaveformDigest::ComputeDigestCpu(data) : 0);
+	}
 
-		//Not actively running.
-		//Is it blocked by any of our incomplete filters?
-		bool ok = true;
-		for(size_t i=0; i<f->GetInputCount(); i++)
+	lock_guard<mutex> lock(m_outputDigestMutex);
+	m_outputDigests[node] = move(digests);
+}
+
+/**
+	@brief Checks that a node's outputs still match the digests recorded when it last refreshed
+
+	Called when IsRefreshNeeded() reports the node can be skipped: if anything mutated the output
+	waveforms in place since then, the memoized skip would silently propagate stale or corrupted data,
+	so log loudly. Only active when SCOPEHAL_VERIFY_MEMOIZATION is set in the environment.
+ */
+void FilterGraphExecutor::VerifyMemoizedOutputs(FlowGraphNode* node)
+{
+	auto chan = dynamic_cast<InstrumentChannel*>(node);
+	if(!chan)
+		return;
+
+	vector<uint64_t> expected;
+	{
+		lock_guard<mutex> lock(m_outputDigestMutex);
+		auto it = m_outputDigests.find(node);
+		if(it == m_outputDigests.end())
+			return;
+		expected = it->second;
+	}
+
+	for(size_t j=0; (j < chan->GetStreamCount()) && (j < expected.size()); j++)
+	{
+		auto data = chan->GetData(j);
+		uint64_t actual = data ? WaveformDigest::ComputeDigestCpu(data) : 0;
+		if(actual != expected[j])
 		{
-			auto in = f->GetInput(i).m_channel;
-			if(m_incompleteNodes.find(in) != m_incompleteNodes.end())
-			{
-				ok = false;
-				break;
-			}
+			LogWarning(
+				"FilterGraphExecutor: memoized output of %s stream %zu changed since last refresh "
+				"(digest %016" PRIx64 ", expected %016" PRIx64 ")\n",
+				chan->GetDisplayName().c_str(), j, actual, expected[j]);
 		}
+	}
+}
 
-		//Not blocked. It's runnable.
-		if(ok)
-			m_runnableNodes.emplace(f);
+/**
+	@brief Moves a node's output waveforms to the memory space its consumers will read them from
+
+	Uses the channel's residency hint if one was set explicitly, otherwise the residency inferred from consumer
+	GetInputLocation() declarations when the plan was compiled. Doing this once, on the thread that produced the
+	data, means consumers' PrepareForCpuAccess / PrepareForGpuAccess calls find everything already resident
+	instead of several workers pulling the same waveform across the bus during one graph execution.
+ */
+void FilterGraphExecutor::ApplyResidencyPolicy(FlowGraphNode* node)
+{
+	auto chan = dynamic_cast<InstrumentChannel*>(node);
+	if(!chan)
+		return;
+
+	//An explicit hint on the channel wins; otherwise use what we inferred from the plan
+	auto policy = chan->GetResidencyHint();
+	if(policy == InstrumentChannel::RES_AUTO)
+	{
+		auto it = m_inferredResidency.find(node);
+		if(it == m_inferredResidency.end())
+			return;
+		policy = it->second;
+	}
+
+	for(size_t i=0; i<chan->GetStreamCount(); i++)
+	{
+		auto data = chan->GetData(i);
+		if(!data)
+			continue;
+
+		if( (policy == InstrumentChannel::RES_CPU_ONLY) || (policy == InstrumentChannel::RES_MIRRORED) )
+			data->PrepareForCpuAccess();
+		if( (policy == InstrumentChannel::RES_GPU_ONLY) || (policy == InstrumentChannel::RES_MIRRORED) )
+			data->PrepareForGpuAccess();
 	}
 }
 
@@ -206,6 +818,26 @@ void FilterGraphExecutor::ExecutorThread(FilterGraphExecutor* pThis, size_t i)
 
 void FilterGraphExecutor::DoExecutorThread(size_t i)
 {
+	//If NUMA pinning is enabled, bind this thread to the CPUs of its node and prefer
+	//allocating from that node, so first-touch places our output buffers locally
+	#ifdef __linux__
+	if(i < m_threadNumaNode.size())
+	{
+		int node = m_threadNumaNode[i];
+		auto topology = GetNumaTopology();
+		if( (node < (int)topology.size()) && !topology[node].empty() )
+		{
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			for(auto c : topology[node])
+				CPU_SET(c, &cpuset);
+			pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+
+			g_numaPreferredNode = node;
+		}
+	}
+	#endif
+
 	//Create a queue and command buffer for this thread's accelerated processing
 	std::shared_ptr<QueueHandle> queue(g_vkQueueManager->GetComputeQueue("FilterGraphExecutor[" + to_string(i) + "].queue"));
 	vk::CommandPoolCreateInfo poolInfo(
@@ -213,8 +845,10 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 		queue->m_family );
 	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
 
-	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, 1);
-	vk::raii::CommandBuffer cmdbuf(std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+	//Allocate one command buffer per batch slot, so several independent filters can be recorded before one submit
+	vk::CommandBufferAllocateInfo bufinfo(*pool, vk::CommandBufferLevel::ePrimary, MAX_SUBMIT_BATCH);
+	vk::raii::CommandBuffers cmdbufs(*g_vkComputeDevice, bufinfo);
+	vk::raii::CommandBuffer& cmdbuf = cmdbufs.front();
 
 	if(g_hasDebugUtils)
 	{
@@ -236,6 +870,20 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 				bufname.c_str()));
 	}
 
+	//Query pool for GPU timestamp profiling, if the device can timestamp compute work
+	auto limits = g_vkComputePhysicalDevice->getProperties().limits;
+	bool canTimestamp = (limits.timestampComputeAndGraphics == VK_TRUE);
+	double fsPerTick = limits.timestampPeriod * 1e6;	//timestampPeriod is in ns per tick
+	unique_ptr<vk::raii::QueryPool> queryPool;
+	GpuTimestampContext tctx;
+	if(canTimestamp)
+	{
+		vk::QueryPoolCreateInfo qpinfo({}, vk::QueryType::eTimestamp, TIMESTAMP_QUERY_SLOTS);
+		queryPool = make_unique<vk::raii::QueryPool>(*g_vkComputeDevice, qpinfo);
+		tctx.m_pool = **queryPool;
+		tctx.m_capacity = TIMESTAMP_QUERY_SLOTS;
+	}
+
 	//Main loop
 	while(true)
 	{
@@ -256,60 +904,220 @@ void FilterGraphExecutor::DoExecutorThread(size_t i)
 
 		//Evaluate nodes as they become available, then stop when there's nothing left to do
 		FlowGraphNode* f;
-		while( (f = GetNextRunnableNode()) != nullptr)
+		while( (f = GetNextRunnableNode(i)) != nullptr)
 		{
-			//Make sure the filter's inputs are where we need them
-			auto loc = f->GetInputLocation();
-			if(loc != Filter::LOC_DONTCARE)
+			//If this node is safe to batch, opportunistically grab more batchable nodes from our local queue.
+			//All runnable nodes are mutually independent, so ordering within the batch doesn't matter.
+			FlowGraphNode* batch[MAX_SUBMIT_BATCH];
+			size_t batchlen = 0;
+			batch[batchlen++] = f;
+			if(f->IsDeferredSubmitSafe())
 			{
-				bool expectGpuInput = (loc == Filter::LOC_GPU);
-				bool expectCpuInput = (loc == Filter::LOC_CPU);
-				for(size_t j=0; j<f->GetInputCount(); j++)
+				auto& q = *m_queues[i];
+				lock_guard<mutex> lock(q.m_mutex);
+				while( (batchlen < MAX_SUBMIT_BATCH) && !q.m_nodes.empty() && q.m_nodes.front()->IsDeferredSubmitSafe() )
 				{
-					auto data = f->GetInput(j).GetData();
-					if(data)
+					batch[batchlen++] = q.m_nodes.front();
+					q.m_nodes.pop_front();
+				}
+			}
+
+			//With more than one node, record everything into separate command buffers
+			//but make a single queue submission with a single fence
+			if(batchlen > 1)
+				queue->BeginBatch();
+
+			//Point compute dispatches on this thread at our timestamp pool while profiling
+			bool profiling = m_profilingEnabled;
+			if(profiling && canTimestamp)
+			{
+				tctx.m_next = 0;
+				g_gpuTimestampContext = &tctx;
+			}
+			NodePerfStats stats[MAX_SUBMIT_BATCH];
+			uint32_t slotStart[MAX_SUBMIT_BATCH] = {0};
+			uint32_t slotEnd[MAX_SUBMIT_BATCH] = {0};
+			bool refreshed[MAX_SUBMIT_BATCH] = {false};
+
+			for(size_t k=0; k<batchlen; k++)
+			{
+				auto node = batch[k];
+
+				//A deduplicated node borrows its leader's outputs rather than refreshing
+				auto lit = m_dedupLeader.find(node);
+				if(lit != m_dedupLeader.end())
+				{
+					dynamic_cast<Filter*>(node)->BorrowOutputsFrom(dynamic_cast<Filter*>(lit->second));
+
+					lock_guard<mutex> slock(m_perfStatsMutex);
+					m_currentExecutionTime[node] = 0;
+					continue;
+				}
+
+				//Skip evaluation entirely if the node's inputs, parameters, and outputs are all unchanged
+				//since its last run: the existing outputs are still valid
+				if(!node->IsRefreshNeeded())
+				{
+					if(m_verifyMemoization)
+						VerifyMemoizedOutputs(node);
+
+					lock_guard<mutex> slock(m_perfStatsMutex);
+					m_currentExecutionTime[node] = 0;
+					continue;
+				}
+
+				//Something changed; heavyweight decoders may still have the outputs for this exact
+				//configuration retained from an earlier run (see Filter::GetOutputCacheDepth())
+				auto cacheNode = dynamic_cast<Filter*>(node);
+				if(cacheNode && cacheNode->TryRestoreCachedOutputs())
+				{
+					if(m_verifyMemoization)
+						RecordOutputDigests(node);
+
+					lock_guard<mutex> slock(m_perfStatsMutex);
+					m_currentExecutionTime[node] = 0;
+					continue;
+				}
+
+				//Make sure the filter's inputs are where we need them
+				auto loc = node->GetInputLocation();
+				if(loc != Filter::LOC_DONTCARE)
+				{
+					bool expectGpuInput = (loc == Filter::LOC_GPU);
+					bool expectCpuInput = (loc == Filter::LOC_CPU);
+					for(size_t j=0; j<node->GetInputCount(); j++)
 					{
-						if(expectGpuInput)
-							data->PrepareForGpuAccess();
-						else if(expectCpuInput)
-							data->PrepareForCpuAccess();
+						auto data = node->GetInput(j).GetData();
+						if(data)
+						{
+							if(expectGpuInput)
+								data->PrepareForGpuAccess();
+							else if(expectCpuInput)
+								data->PrepareForCpuAccess();
+						}
 					}
 				}
+
+				//Install the partial result callback so progressive filters can stream output mid-Refresh
+				auto fnode = dynamic_cast<Filter*>(node);
+				if(fnode)
+				{
+					fnode->SetPartialResultCallback(m_partialResultCallback);
+
+					//We're about to replace the outputs, so any spilled copies are stale
+					FilterSpillEngine::GetInstance().Forget(fnode);
+				}
+
+				//Actually execute the filter
+				bool resuming = node->IsRefreshIncomplete();
+				double start = GetTime();
+				auto countersBefore = g_bufferPerfCounters;
+				int64_t cpuBefore = GetThreadCpuTimeFs();
+				slotStart[k] = tctx.m_next;
+
+				node->Refresh(cmdbufs[k], queue);
+
+				slotEnd[k] = tctx.m_next;
+
+				//If the node used up its time slice before finishing, don't mark it refreshed:
+				//memoization must not skip the follow-up run that finishes the job
+				if(!node->IsRefreshIncomplete())
+				{
+					node->OnRefreshed();
+					refreshed[k] = true;
+				}
+
+				double dt = GetTime() - start;
+				if(profiling)
+				{
+					stats[k].m_wallTimeFs = dt * FS_PER_SECOND;
+					stats[k].m_cpuTimeFs = GetThreadCpuTimeFs() - cpuBefore;
+					stats[k].m_bytesToGpu = g_bufferPerfCounters.m_bytesToGpu - countersBefore.m_bytesToGpu;
+					stats[k].m_bytesToCpu = g_bufferPerfCounters.m_bytesToCpu - countersBefore.m_bytesToCpu;
+					stats[k].m_allocations = g_bufferPerfCounters.m_allocations - countersBefore.m_allocations;
+					stats[k].m_startTimeFs = (start - m_runStartTime) * FS_PER_SECOND;
+					stats[k].m_thread = i;
+				}
+				{
+					lock_guard<mutex> slock(m_perfStatsMutex);
+					if(resuming)
+						m_currentExecutionTime[node] += dt * FS_PER_SECOND;
+					else
+						m_currentExecutionTime[node] = dt * FS_PER_SECOND;
+				}
 			}
 
-			//Actually execute the filter
-			double start = GetTime();
-			f->Refresh(cmdbuf, queue);
-			double dt = GetTime() - start;
+			if(batchlen > 1)
+				queue->EndBatch();
+
+			//Push each node's outputs to wherever their consumers will read them.
+			//Must happen after the batch is submitted, since the compute work writing those outputs
+			//may not have been dispatched until EndBatch()
+			for(size_t k=0; k<batchlen; k++)
+				ApplyResidencyPolicy(batch[k]);
+
+			//Record content digests of freshly computed outputs, now that the batch's GPU work has retired
+			if(m_verifyMemoization)
 			{
-				lock_guard<mutex> slock(m_perfStatsMutex);
-				m_currentExecutionTime[f] = dt * FS_PER_SECOND;
+				for(size_t k=0; k<batchlen; k++)
+				{
+					if(refreshed[k])
+						RecordOutputDigests(batch[k]);
+				}
 			}
 
-			//Filter execution has completed, remove it from the running list and mark as completed
-			lock_guard<mutex> lock2(m_mutex);
-			m_runningNodes.erase(f);
-			m_incompleteNodes.erase(f);
+			//Read back the dispatch timestamps now that the batch's GPU work has retired,
+			//then publish the stats for the whole batch
+			if(profiling)
+			{
+				g_gpuTimestampContext = nullptr;
+				if(tctx.m_next > 0)
+				{
+					auto ticks = queryPool->getResults<uint64_t>(
+						0, tctx.m_next, tctx.m_next * sizeof(uint64_t), sizeof(uint64_t),
+						vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait).second;
+					for(size_t k=0; k<batchlen; k++)
+					{
+						for(uint32_t slot = slotStart[k]; (slot+1) < slotEnd[k]; slot += 2)
+							stats[k].m_gpuTimeFs += static_cast<int64_t>( (ticks[slot+1] - ticks[slot]) * fsPerTick );
+					}
+				}
 
-			//Wake up all threads that might have been waiting on this filter to complete
-			m_workerCvar.notify_all();
-		}
+				lock_guard<mutex> slock(m_perfStatsMutex);
+				for(size_t k=0; k<batchlen; k++)
+				{
+					auto sit = m_currentPerfStats.find(batch[k]);
+					if(sit == m_currentPerfStats.end())
+						m_currentPerfStats[batch[k]] = stats[k];
 
-		//We have no more filters to run.
-		//If this was the last filter (nothing left incomplete), we're done - wake up the main thread
-		bool empty = false;
-		{
-			lock_guard<mutex> lock2(m_mutex);
-			empty = m_incompleteNodes.empty();
-		}
-		if(empty)
-		{
-			{
-				lock_guard<mutex> lock3(m_completionCvarMutex);
-				m_allWorkersComplete = true;
+					//Continuation of a time-sliced refresh: accumulate onto the earlier slices
+					else
+					{
+						sit->second.m_wallTimeFs += stats[k].m_wallTimeFs;
+						sit->second.m_cpuTimeFs += stats[k].m_cpuTimeFs;
+						sit->second.m_gpuTimeFs += stats[k].m_gpuTimeFs;
+						sit->second.m_bytesToGpu += stats[k].m_bytesToGpu;
+						sit->second.m_bytesToCpu += stats[k].m_bytesToCpu;
+						sit->second.m_allocations += stats[k].m_allocations;
+					}
+				}
 			}
 
-			m_completionCvar.notify_all();
+			//Only mark nodes complete after the whole batch's GPU work has retired,
+			//so downstream filters never see half-written buffers
+			for(size_t k=0; k<batchlen; k++)
+			{
+				//A node that ran out of its time slice goes to the back of our queue to finish later,
+				//letting other runnable nodes interleave. Its downstream nodes stay blocked until the
+				//final slice completes and its outputs are fully valid.
+				if(batch[k]->IsRefreshIncomplete())
+				{
+					lock_guard<mutex> lock(m_queues[i]->m_mutex);
+					m_queues[i]->m_nodes.push_back(batch[k]);
+				}
+				else
+					OnNodeComplete(batch[k], i);
+			}
 		}
 	}
 }
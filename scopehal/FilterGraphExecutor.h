@@ -39,20 +39,37 @@
 
 #include <condition_variable>
 #include <atomic>
+#include <deque>
+
+class FilterGraphOffloadClient;
 
 /**
 	@brief Execution manager / scheduler for the filter graph
+
+	Scheduling uses per-thread work-stealing deques: when a worker completes a node, any downstream nodes that became
+	runnable are pushed onto that worker's local queue (keeping producer-consumer chains on one core), and idle workers
+	steal from the tail of other workers' queues. This avoids the wakeup storms and global lock contention of a single
+	shared run queue on large graphs.
+
 	@ingroup core
  */
 class FilterGraphExecutor
 {
 public:
-	FilterGraphExecutor(size_t numThreads = 8);
+	FilterGraphExecutor(size_t numThreads = 8, bool numaAware = false);
 	~FilterGraphExecutor();
 
+	static size_t GetNumaNodeCount();
+
 	void RunBlocking(const std::set<FlowGraphNode*>& nodes);
 
-	FlowGraphNode* GetNextRunnableNode();
+	FlowGraphNode* GetNextRunnableNode(size_t i);
+
+	///@brief Maximum number of independent nodes batched into a single queue submission
+	static constexpr size_t MAX_SUBMIT_BATCH = 8;
+
+	///@brief Number of GPU timestamp query slots per worker thread (two per timed dispatch)
+	static constexpr uint32_t TIMESTAMP_QUERY_SLOTS = 512;
 
 	///@brief Get the run times of the most recent filter graph evaluation
 	std::map<FlowGraphNode*, int64_t> GetRunTimes()
@@ -61,27 +78,154 @@ public:
 		return m_lastExecutionTime;
 	}
 
+	///@brief Detailed performance statistics for a single node, gathered when profiling is enabled
+	struct NodePerfStats
+	{
+		///@brief Wall clock time spent executing the node, in fs
+		int64_t m_wallTimeFs = 0;
+
+		///@brief CPU time consumed by the worker thread while executing the node, in fs
+		int64_t m_cpuTimeFs = 0;
+
+		///@brief GPU execution time of the node's compute dispatches, in fs
+		int64_t m_gpuTimeFs = 0;
+
+		///@brief Bytes copied from CPU to GPU while executing the node
+		uint64_t m_bytesToGpu = 0;
+
+		///@brief Bytes copied from GPU to CPU while executing the node
+		uint64_t m_bytesToCpu = 0;
+
+		///@brief Number of physical buffer allocations made while executing the node
+		uint64_t m_allocations = 0;
+
+		///@brief Wall clock start time of the node, in fs relative to the start of the run
+		int64_t m_startTimeFs = 0;
+
+		///@brief Index of the worker thread the node ran on
+		size_t m_thread = 0;
+	};
+
+	/**
+		@brief Enables or disables detailed per-node profiling
+
+		Profiling adds a pair of GPU timestamp writes around every compute dispatch plus some bookkeeping per node,
+		so it's off by default; the basic wall times from GetRunTimes() are always collected.
+	 */
+	void SetProfilingEnabled(bool enabled)
+	{ m_profilingEnabled = enabled; }
+
+	///@brief Returns true if detailed per-node profiling is active
+	bool IsProfilingEnabled()
+	{ return m_profilingEnabled; }
+
+	///@brief Get the detailed performance statistics of the most recent profiled evaluation
+	std::map<FlowGraphNode*, NodePerfStats> GetPerfStats()
+	{
+		std::lock_guard<std::mutex> lock(m_perfStatsMutex);
+		return m_lastPerfStats;
+	}
+
+	std::string GetChromeTrace();
+
+	/**
+		@brief Attaches a client connection to a remote offload worker (null to detach)
+
+		Once attached, each run offloads connected components of filters marked with Filter::SetOffloadHint()
+		to the worker instead of executing them locally; see FilterGraphOffloadClient.
+	 */
+	void SetOffloadClient(std::shared_ptr<FilterGraphOffloadClient> client)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_offloadClient = client;
+	}
+
+	/**
+		@brief Sets the callback invoked when a filter publishes a partial result mid-Refresh
+
+		The executor installs this on each filter before evaluating it, so progressive filters can notify
+		display-side consumers (typically to trigger a redraw) as each range of their output completes.
+		Call while the graph is idle; the callback may be invoked from any executor thread.
+	 */
+	void SetPartialResultCallback(std::function<void(Filter*, size_t)> cb)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_partialResultCallback = cb;
+	}
+
 protected:
 	static void ExecutorThread(FilterGraphExecutor* pThis, size_t i);
 	void DoExecutorThread(size_t i);
 
-	void UpdateRunnable();
+	void OnNodeComplete(FlowGraphNode* node, size_t i);
+
+	void ApplyResidencyPolicy(FlowGraphNode* node);
+
+	std::set<FlowGraphNode*> RunOffloadedSubgraphs();
+
+	///@brief A single worker thread's work queue
+	struct WorkQueue
+	{
+		///@brief Mutex protecting m_nodes
+		std::mutex m_mutex;
+
+		///@brief Runnable nodes: the owning thread pops the head, thieves pop the tail
+		std::deque<FlowGraphNode*> m_nodes;
+	};
 
-	///@brief Mutex for access to shared state
+	///@brief Mutex for access to shared state during setup of a run
 	std::mutex m_mutex;
 
-	///@brief Nodes that have not yet been updated
-	std::set<FlowGraphNode*> m_incompleteNodes;
+	///@brief Per-thread work-stealing queues
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+	///@brief Map from each node to the set of nodes immediately downstream of it (part of the compiled plan)
+	std::map<FlowGraphNode*, std::vector<FlowGraphNode*>> m_downstreamNodes;
+
+	///@brief Number of not-yet-completed dependencies of each node (values reset from m_initialDeps each run)
+	std::map<FlowGraphNode*, std::atomic<size_t>> m_remainingDeps;
+
+	///@brief Dependency count of each node at the start of a run (part of the compiled plan)
+	std::map<FlowGraphNode*, size_t> m_initialDeps;
+
+	///@brief Nodes with no dependencies, used to seed the worker queues (part of the compiled plan)
+	std::vector<FlowGraphNode*> m_seedNodes;
+
+	/**
+		@brief Map from each structurally-duplicate node to the equivalent node that actually runs
+		(part of the compiled plan)
+
+		A duplicate's only scheduling dependency is its leader; when it "executes" it borrows the leader's output
+		waveforms instead of refreshing. See Filter::IsEquivalentTo() and Filter::BorrowOutputsFrom().
+	 */
+	std::map<FlowGraphNode*, FlowGraphNode*> m_dedupLeader;
+
+	/**
+		@brief Output residency inferred for each node from the declared input locations of its consumers
+		(part of the compiled plan)
 
-	///@brief Nodes that have no dependencies and are eligible to run now
-	std::set<FlowGraphNode*> m_runnableNodes;
+		Only used for channels whose residency hint is RES_AUTO; see ApplyResidencyPolicy().
+	 */
+	std::map<FlowGraphNode*, InstrumentChannel::ResidencyHint> m_inferredResidency;
 
-	///@brief Nodes that are actively being run
-	std::set<FlowGraphNode*> m_runningNodes;
+	///@brief The set of nodes the compiled plan was built for
+	std::set<FlowGraphNode*> m_planNodes;
+
+	///@brief Value of g_filterGraphTopologyVersion when the plan was compiled
+	uint64_t m_planTopologyVersion;
+
+	///@brief True if the compiled plan (downstream edges, dependency counts, seed list) is usable
+	bool m_planValid;
+
+	///@brief Number of nodes in the current run which have not yet completed
+	std::atomic<size_t> m_numIncompleteNodes;
 
 	///@brief Set of thread contexts
 	std::vector<std::unique_ptr<std::thread>> m_threads;
 
+	///@brief NUMA node each worker thread is pinned to (empty if NUMA pinning is disabled)
+	std::vector<int> m_threadNumaNode;
+
 	///@brief Condition variable for waking up worker threads when work arrives
 	std::condition_variable m_workerCvar;
 
@@ -100,14 +244,44 @@ protected:
 	///@brief Shutdown flag
 	bool m_terminating;
 
+	///@brief True if detailed per-node profiling (including GPU timestamps) is active
+	std::atomic<bool> m_profilingEnabled;
+
+	///@brief Wall clock time at the start of the current run (only written while workers are idle)
+	double m_runStartTime;
+
 	///@brief Performance statistics from previous execution
 	std::map<FlowGraphNode*, int64_t> m_lastExecutionTime;
 
 	///@brief Performance statistics from current execution
 	std::map<FlowGraphNode*, int64_t> m_currentExecutionTime;
 
+	///@brief Detailed performance statistics from the previous profiled execution
+	std::map<FlowGraphNode*, NodePerfStats> m_lastPerfStats;
+
+	///@brief Detailed performance statistics from the current execution
+	std::map<FlowGraphNode*, NodePerfStats> m_currentPerfStats;
+
 	///@brief Mutex for updating performance statistics
 	std::mutex m_perfStatsMutex;
+
+	///@brief Client connection to a remote offload worker (null if offload is not in use)
+	std::shared_ptr<FilterGraphOffloadClient> m_offloadClient;
+
+	///@brief Callback invoked when a filter publishes a partial result (see SetPartialResultCallback())
+	std::function<void(Filter*, size_t)> m_partialResultCallback;
+
+	void VerifyMemoizedOutputs(FlowGraphNode* node);
+	void RecordOutputDigests(FlowGraphNode* node);
+
+	///@brief True if memoized-output digest verification is active (SCOPEHAL_VERIFY_MEMOIZATION set)
+	bool m_verifyMemoization;
+
+	///@brief Content digests of each node's outputs as of its last completed refresh (verification only)
+	std::map<FlowGraphNode*, std::vector<uint64_t>> m_outputDigests;
+
+	///@brief Mutex for access to m_outputDigests
+	std::mutex m_outputDigestMutex;
 };
 
 #endif
@@ -0,0 +1,659 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphOffloadClient and FilterGraphOffloadServer
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "FilterGraphOffload.h"
+
+using namespace std;
+
+/**
+	@brief Placeholder channel holding waveforms received from the client at a subgraph boundary
+	@ingroup core
+ */
+class OffloadInputStub : public Filter
+{
+public:
+	OffloadInputStub(size_t nstreams)
+		: Filter("#808080", CAT_MISC)
+	{
+		//Streams get retyped as the subgraph description is parsed; default to analog
+		for(size_t i=0; i<nstreams; i++)
+			AddStream(Unit(Unit::UNIT_VOLTS), string("data") + to_string(i), Stream::STREAM_TYPE_ANALOG);
+	}
+
+	void SetStreamType(size_t i, Stream::StreamType type, const Unit& yunit)
+	{
+		m_streams[i].m_stype = type;
+		SetYAxisUnits(yunit, i);
+	}
+
+	virtual void Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/) override
+	{}
+
+	virtual bool ValidateChannel(size_t /*i*/, StreamDescriptor /*stream*/) override
+	{ return false; }
+
+	virtual string GetProtocolDisplayName() override
+	{ return "Offload Input Stub"; }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FilterGraphOffloadClient
+
+/**
+	@brief Creates an offload client (does not connect; call Connect() before use)
+
+	@param host		Hostname or IP of the worker process
+	@param port		TCP port the worker is listening on
+ */
+FilterGraphOffloadClient::FilterGraphOffloadClient(const string& host, uint16_t port)
+	: m_host(host)
+	, m_port(port)
+	, m_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+	, m_connected(false)
+{
+}
+
+/**
+	@brief Connects to the worker process
+
+	@return True on success
+ */
+bool FilterGraphOffloadClient::Connect()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_connected)
+		return true;
+
+	LogDebug("Connecting to offload worker at %s:%d\n", m_host.c_str(), m_port);
+	if(!m_socket.Connect(m_host, m_port))
+	{
+		m_socket.Close();
+		LogWarning("Couldn't connect to offload worker at %s:%d\n", m_host.c_str(), m_port);
+		return false;
+	}
+	m_socket.DisableNagle();
+
+	m_connected = true;
+	return true;
+}
+
+/**
+	@brief Sends the fixed message framing (type plus payload length)
+ */
+bool FilterGraphOffloadClient::SendMessageHeader(OffloadMessageType type, uint64_t length)
+{
+	uint32_t t = type;
+	if(!m_socket.SendLooped((unsigned char*)&t, sizeof(t)))
+		return false;
+	return m_socket.SendLooped((unsigned char*)&length, sizeof(length));
+}
+
+/**
+	@brief Executes a subgraph of the local filter graph on the remote worker
+
+	The filters must be in topological order, and every input coming from outside the subgraph must already
+	hold current data (i.e. come from acquisition hardware or a previously evaluated filter, not a filter
+	scheduled to run later in the same pass).
+
+	On success the subgraph's output waveforms and scalars have been attached to the local filter objects,
+	exactly as if they had been refreshed locally; the caller must not Refresh() them this pass.
+
+	@param filters	The subgraph to execute, in topological order
+
+	@return True on success. On failure nothing has been attached and the caller should evaluate the
+			subgraph locally; if the connection died, IsConnected() returns false afterwards.
+ */
+bool FilterGraphOffloadClient::ExecuteSubgraph(const vector<Filter*>& filters)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(!m_connected || filters.empty())
+		return false;
+
+	//Serialize the subgraph with the session codepath.
+	//The table assigns wire IDs to each filter, and to each boundary input channel as a side effect of
+	//serializing the input references.
+	IDTable table;
+	YAML::Node doc;
+	doc["version"] = 1;
+	YAML::Node fnodes;
+	map<uintptr_t, Filter*> filtersById;
+	for(auto f : filters)
+	{
+		fnodes.push_back(f->SerializeConfiguration(table));
+		filtersById[table.emplace(f)] = f;
+	}
+	doc["filters"] = fnodes;
+
+	//Find the boundary inputs: channels feeding the subgraph that aren't part of it
+	set<void*> members(filters.begin(), filters.end());
+	map<InstrumentChannel*, set<size_t>> externals;
+	for(auto f : filters)
+	{
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto in = f->GetInput(i);
+			if(!in.m_channel || members.count(in.m_channel))
+				continue;
+			externals[in.m_channel].insert(in.m_stream);
+		}
+	}
+	YAML::Node extnodes;
+	for(auto& it : externals)
+	{
+		auto chan = it.first;
+		YAML::Node e;
+		e["id"] = (uint64_t)table.emplace(chan);
+		e["nstreams"] = chan->GetStreamCount();
+		e["xunit"] = chan->GetXAxisUnits().ToString();
+		YAML::Node streams;
+		for(auto s : it.second)
+		{
+			YAML::Node sn;
+			sn["index"] = s;
+			sn["type"] = (int)chan->GetType(s);
+			sn["yunit"] = chan->GetYAxisUnits(s).ToString();
+			streams.push_back(sn);
+		}
+		e["streams"] = streams;
+		extnodes.push_back(e);
+	}
+	doc["external"] = extnodes;
+
+	//Send the subgraph description
+	string yaml = YAML::Dump(doc);
+	if( !SendMessageHeader(OFFLOAD_MSG_SUBGRAPH, yaml.size()) ||
+		!m_socket.SendLooped((unsigned char*)yaml.c_str(), yaml.size()) )
+	{
+		m_connected = false;
+		return false;
+	}
+
+	//Send the boundary input data
+	for(auto& it : externals)
+	{
+		for(auto s : it.second)
+		{
+			if(!SendStreamData(table.emplace(it.first), it.first, s))
+			{
+				m_connected = false;
+				return false;
+			}
+		}
+	}
+
+	//Kick off execution and apply whatever comes back
+	if(!SendMessageHeader(OFFLOAD_MSG_EXECUTE, 0))
+	{
+		m_connected = false;
+		return false;
+	}
+	if(!ApplyResult(filtersById))
+	{
+		m_connected = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+	@brief Sends one stream of a boundary input channel (compressed waveform or scalar value)
+ */
+bool FilterGraphOffloadClient::SendStreamData(uint64_t id, InstrumentChannel* chan, size_t stream)
+{
+	if(chan->GetType(stream) == Stream::STREAM_TYPE_ANALOG_SCALAR)
+	{
+		OffloadScalarHeader h;
+		h.m_channelId = id;
+		h.m_stream = stream;
+		h.m_value = chan->GetScalarValue(stream);
+		if(!SendMessageHeader(OFFLOAD_MSG_SCALAR, sizeof(h)))
+			return false;
+		return m_socket.SendLooped((unsigned char*)&h, sizeof(h));
+	}
+
+	//No waveform is a legal state (e.g. nothing acquired yet); the remote filter sees a null input
+	auto data = chan->GetData(stream);
+	if(!data)
+		return true;
+
+	auto cw = WaveformCompressor::Compress(data);
+	if(!cw)
+	{
+		LogWarning("Input waveform of type unsupported by WaveformCompressor, can't offload subgraph\n");
+		return false;
+	}
+
+	OffloadWaveformHeader h;
+	h.m_channelId = id;
+	h.m_stream = stream;
+	h.m_kind = cw->m_kind;
+	h.m_flags = cw->m_flags;
+	h.m_sampleCount = cw->m_sampleCount;
+	h.m_timescale = cw->m_timescale;
+	h.m_startTimestamp = cw->m_startTimestamp;
+	h.m_startFemtoseconds = cw->m_startFemtoseconds;
+	h.m_triggerPhase = cw->m_triggerPhase;
+	h.m_samplesLen = cw->m_samples.size();
+	h.m_offsetsLen = cw->m_offsets.size();
+	h.m_durationsLen = cw->m_durations.size();
+
+	if(!SendMessageHeader(OFFLOAD_MSG_WAVEFORM, sizeof(h) + h.m_samplesLen + h.m_offsetsLen + h.m_durationsLen))
+		return false;
+	if(!m_socket.SendLooped((unsigned char*)&h, sizeof(h)))
+		return false;
+	if(h.m_samplesLen && !m_socket.SendLooped(cw->m_samples.data(), h.m_samplesLen))
+		return false;
+	if(h.m_offsetsLen && !m_socket.SendLooped(cw->m_offsets.data(), h.m_offsetsLen))
+		return false;
+	if(h.m_durationsLen && !m_socket.SendLooped(cw->m_durations.data(), h.m_durationsLen))
+		return false;
+	return true;
+}
+
+/**
+	@brief Receives result messages until OFFLOAD_MSG_DONE and attaches them to the local filters
+ */
+bool FilterGraphOffloadClient::ApplyResult(map<uintptr_t, Filter*>& filtersById)
+{
+	while(true)
+	{
+		uint32_t type;
+		uint64_t length;
+		if(!m_socket.RecvLooped((unsigned char*)&type, sizeof(type)))
+			return false;
+		if(!m_socket.RecvLooped((unsigned char*)&length, sizeof(length)))
+			return false;
+
+		switch(type)
+		{
+			case OFFLOAD_MSG_DONE:
+				{
+					uint32_t status;
+					if(!m_socket.RecvLooped((unsigned char*)&status, sizeof(status)))
+						return false;
+					return (status == 1);
+				}
+
+			case OFFLOAD_MSG_WAVEFORM:
+				{
+					OffloadWaveformHeader h;
+					if(!m_socket.RecvLooped((unsigned char*)&h, sizeof(h)))
+						return false;
+
+					CompressedWaveform cw;
+					cw.m_kind = (CompressedWaveform::WaveformKind)h.m_kind;
+					cw.m_flags = h.m_flags;
+					cw.m_sampleCount = h.m_sampleCount;
+					cw.m_timescale = h.m_timescale;
+					cw.m_startTimestamp = h.m_startTimestamp;
+					cw.m_startFemtoseconds = h.m_startFemtoseconds;
+					cw.m_triggerPhase = h.m_triggerPhase;
+					cw.m_revision = 0;
+					cw.m_samples.resize(h.m_samplesLen);
+					cw.m_offsets.resize(h.m_offsetsLen);
+					cw.m_durations.resize(h.m_durationsLen);
+					if(h.m_samplesLen && !m_socket.RecvLooped(cw.m_samples.data(), h.m_samplesLen))
+						return false;
+					if(h.m_offsetsLen && !m_socket.RecvLooped(cw.m_offsets.data(), h.m_offsetsLen))
+						return false;
+					if(h.m_durationsLen && !m_socket.RecvLooped(cw.m_durations.data(), h.m_durationsLen))
+						return false;
+
+					auto it = filtersById.find(h.m_channelId);
+					if(it != filtersById.end())
+						it->second->SetData(WaveformCompressor::Decompress(cw), h.m_stream);
+				}
+				break;
+
+			case OFFLOAD_MSG_SCALAR:
+				{
+					OffloadScalarHeader h;
+					if(!m_socket.RecvLooped((unsigned char*)&h, sizeof(h)))
+						return false;
+
+					auto it = filtersById.find(h.m_channelId);
+					if(it != filtersById.end())
+						it->second->SetScalarValue(h.m_stream, h.m_value);
+				}
+				break;
+
+			default:
+				LogWarning("Unexpected offload message type %u from worker\n", type);
+				return false;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FilterGraphOffloadServer
+
+/**
+	@brief Creates the server and starts listening
+
+	@param port		TCP port to listen on
+ */
+FilterGraphOffloadServer::FilterGraphOffloadServer(uint16_t port)
+	: m_socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP)
+{
+	m_socket.Bind(port);
+	m_socket.Listen();
+}
+
+/**
+	@brief Accept loop: handles one client at a time, forever
+ */
+void FilterGraphOffloadServer::Run()
+{
+	while(true)
+	{
+		Socket client = m_socket.Accept();
+		if(!client.IsValid())
+			break;
+		client.DisableNagle();
+
+		LogNotice("Offload client connected\n");
+		while(OnClient(client))
+		{}
+		CleanupSubgraph();
+		LogNotice("Offload client disconnected\n");
+	}
+}
+
+/**
+	@brief Sends the fixed message framing (type plus payload length)
+ */
+bool FilterGraphOffloadServer::SendMessageHeader(Socket& client, OffloadMessageType type, uint64_t length)
+{
+	uint32_t t = type;
+	if(!client.SendLooped((unsigned char*)&t, sizeof(t)))
+		return false;
+	return client.SendLooped((unsigned char*)&length, sizeof(length));
+}
+
+/**
+	@brief Receives and dispatches one message
+
+	@return False if the connection should be closed
+ */
+bool FilterGraphOffloadServer::OnClient(Socket& client)
+{
+	uint32_t type;
+	uint64_t length;
+	if(!client.RecvLooped((unsigned char*)&type, sizeof(type)))
+		return false;
+	if(!client.RecvLooped((unsigned char*)&length, sizeof(length)))
+		return false;
+
+	switch(type)
+	{
+		case OFFLOAD_MSG_SUBGRAPH:
+			{
+				string yaml;
+				yaml.resize(length);
+				if(length && !client.RecvLooped((unsigned char*)&yaml[0], length))
+					return false;
+				return OnSubgraph(client, yaml);
+			}
+
+		case OFFLOAD_MSG_WAVEFORM:
+			return OnWaveform(client, length);
+
+		case OFFLOAD_MSG_SCALAR:
+			return OnScalar(client);
+
+		case OFFLOAD_MSG_EXECUTE:
+			return OnExecute(client);
+
+		default:
+			LogWarning("Unexpected offload message type %u from client\n", type);
+			return false;
+	}
+}
+
+/**
+	@brief Reconstructs a submitted subgraph using the session deserialization path
+ */
+bool FilterGraphOffloadServer::OnSubgraph(Socket& /*client*/, const string& yaml)
+{
+	CleanupSubgraph();
+
+	YAML::Node doc;
+	try
+	{
+		doc = YAML::Load(yaml);
+	}
+	catch(const YAML::Exception& e)
+	{
+		LogWarning("Malformed subgraph description: %s\n", e.what());
+		return false;
+	}
+
+	IDTable table;
+
+	//Create stub channels for the boundary inputs
+	for(auto e : doc["external"])
+	{
+		auto id = e["id"].as<uintptr_t>();
+		auto stub = new OffloadInputStub(e["nstreams"].as<size_t>());
+		stub->SetXAxisUnits(Unit(e["xunit"].as<string>()));
+		for(auto sn : e["streams"])
+		{
+			stub->SetStreamType(
+				sn["index"].as<size_t>(),
+				(Stream::StreamType)sn["type"].as<int>(),
+				Unit(sn["yunit"].as<string>()));
+		}
+		table.emplace(id, static_cast<OscilloscopeChannel*>(stub));
+		m_channelsById[id] = stub;
+		m_stubs.push_back(stub);
+	}
+
+	//Create the filters, then load parameters and inputs in a second pass once every node exists
+	vector<YAML::Node> fnodes;
+	for(auto fn : doc["filters"])
+	{
+		auto f = Filter::CreateFilter(fn["protocol"].as<string>(), fn["color"].as<string>());
+		if(!f)
+		{
+			LogWarning("Unknown filter \"%s\" in offloaded subgraph (worker plugins out of date?)\n",
+				fn["protocol"].as<string>().c_str());
+			CleanupSubgraph();
+			return false;
+		}
+		auto id = fn["id"].as<uintptr_t>();
+		table.emplace(id, static_cast<OscilloscopeChannel*>(f));
+		m_channelsById[id] = f;
+		m_filters.push_back(f);
+		fnodes.push_back(fn);
+	}
+	for(size_t i=0; i<m_filters.size(); i++)
+	{
+		m_filters[i]->LoadParameters(fnodes[i], table);
+		m_filters[i]->LoadInputs(fnodes[i], table);
+	}
+	return true;
+}
+
+/**
+	@brief Receives a boundary input waveform and attaches it to its stub channel
+ */
+bool FilterGraphOffloadServer::OnWaveform(Socket& client, uint64_t /*length*/)
+{
+	OffloadWaveformHeader h;
+	if(!client.RecvLooped((unsigned char*)&h, sizeof(h)))
+		return false;
+
+	CompressedWaveform cw;
+	cw.m_kind = (CompressedWaveform::WaveformKind)h.m_kind;
+	cw.m_flags = h.m_flags;
+	cw.m_sampleCount = h.m_sampleCount;
+	cw.m_timescale = h.m_timescale;
+	cw.m_startTimestamp = h.m_startTimestamp;
+	cw.m_startFemtoseconds = h.m_startFemtoseconds;
+	cw.m_triggerPhase = h.m_triggerPhase;
+	cw.m_revision = 0;
+	cw.m_samples.resize(h.m_samplesLen);
+	cw.m_offsets.resize(h.m_offsetsLen);
+	cw.m_durations.resize(h.m_durationsLen);
+	if(h.m_samplesLen && !client.RecvLooped(cw.m_samples.data(), h.m_samplesLen))
+		return false;
+	if(h.m_offsetsLen && !client.RecvLooped(cw.m_offsets.data(), h.m_offsetsLen))
+		return false;
+	if(h.m_durationsLen && !client.RecvLooped(cw.m_durations.data(), h.m_durationsLen))
+		return false;
+
+	auto it = m_channelsById.find(h.m_channelId);
+	if(it != m_channelsById.end())
+		it->second->SetData(WaveformCompressor::Decompress(cw), h.m_stream);
+	return true;
+}
+
+/**
+	@brief Receives a boundary input scalar and attaches it to its stub channel
+ */
+bool FilterGraphOffloadServer::OnScalar(Socket& client)
+{
+	OffloadScalarHeader h;
+	if(!client.RecvLooped((unsigned char*)&h, sizeof(h)))
+		return false;
+
+	auto it = m_channelsById.find(h.m_channelId);
+	if(it != m_channelsById.end())
+		it->second->SetScalarValue(h.m_stream, h.m_value);
+	return true;
+}
+
+/**
+	@brief Executes the current subgraph and streams the results back
+ */
+bool FilterGraphOffloadServer::OnExecute(Socket& client)
+{
+	//Run the whole subgraph with our local executor, using this machine's full CPU and GPU
+	set<FlowGraphNode*> nodes(m_filters.begin(), m_filters.end());
+	m_executor.RunBlocking(nodes);
+
+	//Stream back every output stream of every filter (any of them may be displayed or consumed locally)
+	uint32_t status = 1;
+	for(auto f : m_filters)
+	{
+		//Find this filter's wire ID
+		uint64_t id = 0;
+		for(auto& it : m_channelsById)
+		{
+			if(it.second == f)
+			{
+				id = it.first;
+				break;
+			}
+		}
+
+		for(size_t s=0; s<f->GetStreamCount(); s++)
+		{
+			if(f->GetType(s) == Stream::STREAM_TYPE_ANALOG_SCALAR)
+			{
+				OffloadScalarHeader h;
+				h.m_channelId = id;
+				h.m_stream = s;
+				h.m_value = f->GetScalarValue(s);
+				if(!SendMessageHeader(client, OFFLOAD_MSG_SCALAR, sizeof(h)))
+					return false;
+				if(!client.SendLooped((unsigned char*)&h, sizeof(h)))
+					return false;
+				continue;
+			}
+
+			auto data = f->GetData(s);
+			if(!data)
+				continue;
+			auto cw = WaveformCompressor::Compress(data);
+			if(!cw)
+			{
+				//Output type the codec can't pack (eye patterns etc); report failure so the
+				//client reruns the subgraph locally rather than silently losing this stream
+				status = 0;
+				continue;
+			}
+
+			OffloadWaveformHeader h;
+			h.m_channelId = id;
+			h.m_stream = s;
+			h.m_kind = cw->m_kind;
+			h.m_flags = cw->m_flags;
+			h.m_sampleCount = cw->m_sampleCount;
+			h.m_timescale = cw->m_timescale;
+			h.m_startTimestamp = cw->m_startTimestamp;
+			h.m_startFemtoseconds = cw->m_startFemtoseconds;
+			h.m_triggerPhase = cw->m_triggerPhase;
+			h.m_samplesLen = cw->m_samples.size();
+			h.m_offsetsLen = cw->m_offsets.size();
+			h.m_durationsLen = cw->m_durations.size();
+
+			if(!SendMessageHeader(client, OFFLOAD_MSG_WAVEFORM,
+				sizeof(h) + h.m_samplesLen + h.m_offsetsLen + h.m_durationsLen))
+			{
+				return false;
+			}
+			if(!client.SendLooped((unsigned char*)&h, sizeof(h)))
+				return false;
+			if(h.m_samplesLen && !client.SendLooped(cw->m_samples.data(), h.m_samplesLen))
+				return false;
+			if(h.m_offsetsLen && !client.SendLooped(cw->m_offsets.data(), h.m_offsetsLen))
+				return false;
+			if(h.m_durationsLen && !client.SendLooped(cw->m_durations.data(), h.m_durationsLen))
+				return false;
+		}
+	}
+
+	if(!SendMessageHeader(client, OFFLOAD_MSG_DONE, sizeof(status)))
+		return false;
+	return client.SendLooped((unsigned char*)&status, sizeof(status));
+}
+
+/**
+	@brief Tears down the current subgraph (filters first, since they reference the stubs as inputs)
+ */
+void FilterGraphOffloadServer::CleanupSubgraph()
+{
+	for(auto f : m_filters)
+		delete f;
+	m_filters.clear();
+	for(auto s : m_stubs)
+		delete s;
+	m_stubs.clear();
+	m_channelsById.clear();
+}
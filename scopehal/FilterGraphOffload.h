@@ -0,0 +1,221 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphOffloadClient and FilterGraphOffloadServer
+	@ingroup core
+ */
+#ifndef FilterGraphOffload_h
+#define FilterGraphOffload_h
+
+#include "../xptools/Socket.h"
+#include "FilterGraphExecutor.h"
+#include "WaveformCompressor.h"
+
+/**
+	@brief Message types for the filter graph offload wire protocol
+	@ingroup core
+
+	Every message is a uint32 type, a uint64 payload length, then the payload. Both ends are assumed
+	to be little endian 64-bit hosts (the same assumption the compressed session format makes).
+ */
+enum OffloadMessageType : uint32_t
+{
+	///@brief YAML description of the subgraph and its external inputs (client to server)
+	OFFLOAD_MSG_SUBGRAPH	= 1,
+
+	///@brief One compressed waveform (OffloadWaveformHeader plus blobs, either direction)
+	OFFLOAD_MSG_WAVEFORM	= 2,
+
+	///@brief One scalar stream value (OffloadScalarHeader, either direction)
+	OFFLOAD_MSG_SCALAR		= 3,
+
+	///@brief All inputs have been sent, execute the subgraph (client to server)
+	OFFLOAD_MSG_EXECUTE		= 4,
+
+	///@brief Execution finished, payload is a uint32 status (1 = success; server to client)
+	OFFLOAD_MSG_DONE		= 5
+};
+
+/**
+	@brief Fixed-size header of an OFFLOAD_MSG_WAVEFORM message
+
+	Followed by the compressed sample, offset, and duration blobs in that order.
+
+	@ingroup core
+ */
+struct OffloadWaveformHeader
+{
+	///@brief IDTable ID of the channel this waveform belongs to
+	uint64_t m_channelId;
+
+	///@brief Stream index on that channel
+	uint64_t m_stream;
+
+	///@brief CompressedWaveform::WaveformKind of the original waveform
+	uint32_t m_kind;
+
+	///@brief Flags of the original waveform
+	uint32_t m_flags;
+
+	///@brief Number of samples in the original waveform
+	uint64_t m_sampleCount;
+
+	///@brief Time scale of the original waveform, in femtoseconds per timebase unit
+	int64_t m_timescale;
+
+	///@brief Start time of the original waveform
+	int64_t m_startTimestamp;
+
+	///@brief Fractional start time of the original waveform
+	int64_t m_startFemtoseconds;
+
+	///@brief Trigger phase of the original waveform
+	int64_t m_triggerPhase;
+
+	///@brief Size of the compressed sample blob, in bytes
+	uint64_t m_samplesLen;
+
+	///@brief Size of the compressed offset blob, in bytes (zero for uniform waveforms)
+	uint64_t m_offsetsLen;
+
+	///@brief Size of the compressed duration blob, in bytes (zero for uniform waveforms)
+	uint64_t m_durationsLen;
+};
+
+/**
+	@brief Fixed-size payload of an OFFLOAD_MSG_SCALAR message
+	@ingroup core
+ */
+struct OffloadScalarHeader
+{
+	///@brief IDTable ID of the channel this value belongs to
+	uint64_t m_channelId;
+
+	///@brief Stream index on that channel
+	uint64_t m_stream;
+
+	///@brief The scalar value
+	float m_value;
+};
+
+/**
+	@brief Client side of filter subgraph offload
+	@ingroup core
+
+	Connects to a FilterGraphOffloadServer in a scopehal worker process on another host and delegates
+	execution of subgraphs of the local filter graph to it. Input waveforms crossing the subgraph boundary
+	are serialized with WaveformCompressor and streamed over; after remote execution the subgraph's output
+	waveforms are streamed back and attached to the local filter objects, which are never Refresh()ed here.
+
+	Attach an instance to a FilterGraphExecutor with SetOffloadClient() and mark filters for remote
+	execution with Filter::SetOffloadHint(); the executor offloads each connected component of marked
+	filters as one unit, so intermediate waveforms never cross the network.
+ */
+class FilterGraphOffloadClient
+{
+public:
+	FilterGraphOffloadClient(const std::string& host, uint16_t port);
+
+	bool Connect();
+
+	///@brief Returns true if we have a live connection to the worker
+	bool IsConnected()
+	{ return m_connected; }
+
+	bool ExecuteSubgraph(const std::vector<Filter*>& filters);
+
+protected:
+	bool SendMessageHeader(OffloadMessageType type, uint64_t length);
+	bool SendStreamData(uint64_t id, InstrumentChannel* chan, size_t stream);
+	bool ApplyResult(std::map<uintptr_t, Filter*>& filtersById);
+
+	///@brief Hostname or IP of the worker
+	std::string m_host;
+
+	///@brief TCP port the worker is listening on
+	uint16_t m_port;
+
+	///@brief Socket connection to the worker
+	Socket m_socket;
+
+	///@brief True if the connection is believed to be up
+	bool m_connected;
+
+	///@brief Serializes subgraph executions (one outstanding request per connection)
+	std::mutex m_mutex;
+};
+
+/**
+	@brief Server side of filter subgraph offload, run inside a scopehal worker process
+	@ingroup core
+
+	Listens for a FilterGraphOffloadClient, reconstructs each submitted subgraph with Filter::CreateFilter()
+	plus the session deserialization path, executes it with a local FilterGraphExecutor (so the worker's full
+	CPU and GPU are used), and streams the compressed output waveforms back.
+
+	The worker process must have initialized scopehal (including ScopeProtocolStaticInit() and Vulkan setup)
+	before calling Run(). Handles one client at a time; Run() blocks forever.
+ */
+class FilterGraphOffloadServer
+{
+public:
+	FilterGraphOffloadServer(uint16_t port);
+
+	void Run();
+
+protected:
+	bool OnClient(Socket& client);
+	bool OnSubgraph(Socket& client, const std::string& yaml);
+	bool OnWaveform(Socket& client, uint64_t length);
+	bool OnScalar(Socket& client);
+	bool OnExecute(Socket& client);
+	void CleanupSubgraph();
+
+	bool SendMessageHeader(Socket& client, OffloadMessageType type, uint64_t length);
+
+	///@brief Listening socket
+	Socket m_socket;
+
+	///@brief Executor used to run submitted subgraphs
+	FilterGraphExecutor m_executor;
+
+	///@brief Map from client-assigned IDs to reconstructed channels (filters and input stubs)
+	std::map<uintptr_t, InstrumentChannel*> m_channelsById;
+
+	///@brief The filters of the current subgraph, in the order the client sent them
+	std::vector<Filter*> m_filters;
+
+	///@brief Input stub channels holding waveforms received from the client
+	std::vector<Filter*> m_stubs;
+};
+
+#endif
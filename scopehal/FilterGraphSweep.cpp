@@ -0,0 +1,213 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterGraphSweep
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "FilterGraphSweep.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a sweep over a subgraph
+
+	@param subgraph		The filters to clone, which must form a connected chain from the swept filter to the metric
+	@param target		The filter (within subgraph) whose parameter forms the sweep axis
+	@param parameter	Name of the swept parameter on target
+	@param metric		Scalar output stream (of a filter within subgraph) providing the metric value
+ */
+FilterGraphSweep::FilterGraphSweep(
+	const set<Filter*>& subgraph,
+	Filter* target,
+	const string& parameter,
+	StreamDescriptor metric)
+	: m_subgraph(subgraph)
+	, m_target(target)
+	, m_parameter(parameter)
+	, m_metric(metric)
+{
+	if(m_subgraph.find(m_target) == m_subgraph.end())
+		LogError("FilterGraphSweep: target filter is not part of the subgraph\n");
+	if(m_subgraph.find(dynamic_cast<Filter*>(m_metric.m_channel)) == m_subgraph.end())
+		LogError("FilterGraphSweep: metric stream does not come from a filter in the subgraph\n");
+}
+
+FilterGraphSweep::~FilterGraphSweep()
+{
+	for(auto& v : m_variants)
+		DestroyVariant(v);
+	m_variants.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Subgraph cloning
+
+/**
+	@brief Makes one clone of the subgraph
+
+	Parameters are copied through their string representation (the same round trip used by session files).
+	Inputs coming from inside the subgraph are remapped to the corresponding clones; anything fed from
+	outside is connected to the original stream, so every variant shares those waveforms zero copy.
+ */
+FilterGraphSweep::SweepVariant FilterGraphSweep::CloneSubgraph()
+{
+	SweepVariant v;
+
+	//First pass: instantiate the clones and copy parameters
+	for(auto f : m_subgraph)
+	{
+		auto clone = Filter::CreateFilter(f->GetProtocolDisplayName(), f->m_displaycolor);
+		for(auto it = f->GetParamBegin(); it != f->GetParamEnd(); it ++)
+			clone->GetParameter(it->first).ParseString(it->second.ToString());
+		v.m_clones[f] = clone;
+	}
+
+	//Second pass: hook up inputs, now that all of the clones exist
+	for(auto f : m_subgraph)
+	{
+		auto clone = v.m_clones[f];
+		for(size_t i=0; i<f->GetInputCount(); i++)
+		{
+			auto stream = f->GetInput(i);
+			if(stream.m_channel == nullptr)
+				continue;
+
+			auto src = dynamic_cast<Filter*>(stream.m_channel);
+			if( (src != nullptr) && (m_subgraph.find(src) != m_subgraph.end()) )
+				clone->SetInput(i, StreamDescriptor(v.m_clones[src], stream.m_stream), true);
+			else
+				clone->SetInput(i, stream, true);
+		}
+	}
+
+	v.m_parameter = &v.m_clones[m_target]->GetParameter(m_parameter);
+	v.m_metric = StreamDescriptor(v.m_clones[dynamic_cast<Filter*>(m_metric.m_channel)], m_metric.m_stream);
+	return v;
+}
+
+void FilterGraphSweep::DestroyVariant(SweepVariant& variant)
+{
+	//Break the links between clones first, so refcounts don't keep anything alive
+	for(auto it : variant.m_clones)
+		it.second->DetachInputs();
+	for(auto it : variant.m_clones)
+		it.second->Release();
+	variant.m_clones.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Execution
+
+/**
+	@brief Sets the parameter values to sweep over
+
+	The variant pool is grown or shrunk to match, so clones are reused across repeated executions with the
+	same point count.
+ */
+void FilterGraphSweep::SetSweepPoints(const vector<double>& points)
+{
+	m_points = points;
+
+	while(m_variants.size() < m_points.size())
+		m_variants.push_back(CloneSubgraph());
+	while(m_variants.size() > m_points.size())
+	{
+		DestroyVariant(m_variants[m_variants.size() - 1]);
+		m_variants.pop_back();
+	}
+}
+
+/**
+	@brief Runs every variant of the sweep as a single concurrent graph evaluation
+
+	@param executor	Executor to run the variants on
+
+	@return Sparse analog waveform with one sample per sweep point (X = parameter value, Y = metric).
+			Caller takes ownership.
+ */
+SparseAnalogWaveform* FilterGraphSweep::Execute(FilterGraphExecutor& executor)
+{
+	//Apply the sweep axis
+	for(size_t i=0; i<m_variants.size(); i++)
+	{
+		auto param = m_variants[i].m_parameter;
+		if(param->GetType() == FilterParameter::TYPE_FLOAT)
+			param->SetFloatVal(m_points[i]);
+		else
+			param->SetIntVal(llround(m_points[i]));
+	}
+
+	//Run all of the variants in one pass so the executor can spread them across its worker pool
+	set<FlowGraphNode*> nodes;
+	for(auto& v : m_variants)
+	{
+		for(auto it : v.m_clones)
+			nodes.emplace(it.second);
+	}
+	executor.RunBlocking(nodes);
+
+	//Gather the (parameter, metric) points and sort by parameter value
+	vector<pair<double, float>> points;
+	for(size_t i=0; i<m_variants.size(); i++)
+		points.push_back(pair<double, float>(m_points[i], m_variants[i].m_metric.GetScalarValue()));
+	sort(points.begin(), points.end());
+
+	//Emit the dataset in the same layout XYSweepFilter builds incrementally
+	auto cap = new SparseAnalogWaveform;
+	cap->m_timescale = 1;
+	cap->m_triggerPhase = 0;
+	cap->m_flags = 0;
+	double t = GetTime();
+	cap->m_startTimestamp = floor(t);
+	cap->m_startFemtoseconds = (t - cap->m_startTimestamp) * FS_PER_SECOND;
+	cap->PrepareForCpuAccess();
+
+	size_t n = points.size();
+	cap->Resize(n);
+	for(size_t i=0; i<n; i++)
+	{
+		cap->m_offsets[i] = points[i].first;
+		if(i+1 < n)
+			cap->m_durations[i] = points[i+1].first - points[i].first;
+		else
+			cap->m_durations[i] = 1;
+		cap->m_samples[i] = points[i].second;
+	}
+
+	cap->MarkModifiedFromCpu();
+	return cap;
+}
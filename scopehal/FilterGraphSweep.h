@@ -0,0 +1,116 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterGraphSweep
+	@ingroup core
+ */
+
+#ifndef FilterGraphSweep_h
+#define FilterGraphSweep_h
+
+#include "FilterGraphExecutor.h"
+
+/**
+	@brief Executes a subgraph once per point of a parameter axis, running every variant concurrently
+
+	The subgraph (for example a channel emulation -> CTLE -> eye measurement chain) is cloned once per sweep
+	point. Connections inside the subgraph are remapped to the corresponding clones; inputs fed from outside
+	the subgraph are shared by every variant zero copy, so all clones read the same acquired waveform objects.
+	One FilterGraphExecutor::RunBlocking() call then evaluates all variants at once, spreading them across the
+	worker pool instead of re-running the graph serially per parameter value.
+
+	Execute() returns the results as a sparse analog waveform of (parameter value, metric) points, the same
+	dataset layout XYSweepFilter accumulates one point at a time, so existing display and post-processing
+	paths can consume it unchanged.
+
+	@ingroup core
+ */
+class FilterGraphSweep
+{
+public:
+	FilterGraphSweep(
+		const std::set<Filter*>& subgraph,
+		Filter* target,
+		const std::string& parameter,
+		StreamDescriptor metric);
+	virtual ~FilterGraphSweep();
+
+	void SetSweepPoints(const std::vector<double>& points);
+
+	SparseAnalogWaveform* Execute(FilterGraphExecutor& executor);
+
+	///@brief Returns the X axis unit of the sweep (the unit of the swept parameter)
+	Unit GetSweepUnits()
+	{ return m_target->GetParameter(m_parameter).GetUnit(); }
+
+	///@brief Returns the Y axis unit of the sweep (the unit of the metric stream)
+	Unit GetMetricUnits()
+	{ return m_metric.GetYAxisUnits(); }
+
+protected:
+
+	///@brief One clone of the subgraph, evaluating a single sweep point
+	struct SweepVariant
+	{
+		///@brief Map of original filters to their clones
+		std::map<Filter*, Filter*> m_clones;
+
+		///@brief The swept parameter on the cloned target filter
+		FilterParameter* m_parameter;
+
+		///@brief The metric stream on the cloned source filter
+		StreamDescriptor m_metric;
+	};
+
+	SweepVariant CloneSubgraph();
+	void DestroyVariant(SweepVariant& variant);
+
+	///@brief The filters being swept
+	std::set<Filter*> m_subgraph;
+
+	///@brief The filter whose parameter forms the sweep axis
+	Filter* m_target;
+
+	///@brief Name of the swept parameter on m_target
+	std::string m_parameter;
+
+	///@brief Scalar stream within the subgraph providing the metric (Y axis) value
+	StreamDescriptor m_metric;
+
+	///@brief Parameter values to evaluate, one per variant
+	std::vector<double> m_points;
+
+	///@brief Cloned subgraphs, one per sweep point
+	std::vector<SweepVariant> m_variants;
+};
+
+#endif
@@ -57,6 +57,7 @@ FilterParameter::FilterParameter(ParameterTypes type, Unit unit)
 	, m_string("")
 	, m_hidden(false)
 	, m_readOnly(false)
+	, m_presentationOnly(false)
 {
 
 }
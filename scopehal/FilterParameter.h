@@ -243,6 +243,24 @@ public:
 	bool IsReadOnly()
 	{ return m_readOnly; }
 
+	/**
+		@brief Marks this parameter as affecting only how existing output is displayed, not the output itself.
+
+		Graph drivers can skip re-running the filter (and everything downstream of it) when a presentation-only
+		parameter changes, since the output waveform is unchanged and only its rendering needs to update. The
+		typical example is a display format selector whose value is read at render time by GetText().
+
+		Parameters default to data-affecting; only mark one presentation-only if Refresh() never reads it.
+	 */
+	void MarkPresentationOnly()
+	{ m_presentationOnly = true; }
+
+	/**
+		@brief Checks if this parameter affects only presentation of existing output (see MarkPresentationOnly())
+	 */
+	bool IsPresentationOnly()
+	{ return m_presentationOnly; }
+
 protected:
 	ParameterTypes				m_type;
 
@@ -262,6 +280,7 @@ protected:
 
 	bool						m_hidden;
 	bool						m_readOnly;
+	bool						m_presentationOnly;
 };
 
 #endif
@@ -0,0 +1,355 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of FilterSpillEngine
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "FilterSpillEngine.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+///@brief Returns the spill engine singleton
+FilterSpillEngine& FilterSpillEngine::GetInstance()
+{
+	static FilterSpillEngine engine;
+	return engine;
+}
+
+FilterSpillEngine::FilterSpillEngine()
+	: m_spillFile(nullptr)
+	, m_spillSize(0)
+{
+	MemoryPressureManager::GetInstance().Register(this);
+}
+
+FilterSpillEngine::~FilterSpillEngine()
+{
+	MemoryPressureManager::GetInstance().Unregister(this);
+
+	if(m_spillFile)
+	{
+		fclose(m_spillFile);
+		unlink(m_spillPath.c_str());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+///@brief Estimates the RAM consumed by a waveform's sample storage, in bytes
+static size_t EstimateWaveformBytes(WaveformBase* wfm)
+{
+	size_t n = wfm->size();
+	if(dynamic_cast<UniformAnalogWaveform*>(wfm))
+		return n * sizeof(float);
+	if(dynamic_cast<SparseAnalogWaveform*>(wfm))
+		return n * (sizeof(float) + 2*sizeof(int64_t));
+	if(dynamic_cast<UniformDigitalWaveform*>(wfm))
+		return n;
+	if(dynamic_cast<SparseDigitalWaveform*>(wfm))
+		return n * (1 + 2*sizeof(int64_t));
+	return 0;
+}
+
+///@brief Appends a blob to the scratch file, recording the offset it landed at
+bool FilterSpillEngine::WriteBlob(const vector<uint8_t>& blob, size_t& offset)
+{
+	offset = m_spillSize;
+	if(blob.empty())
+		return true;
+	if(fwrite(&blob[0], 1, blob.size(), m_spillFile) != blob.size())
+		return false;
+	m_spillSize += blob.size();
+	return true;
+}
+
+///@brief Reads a blob back from the scratch file
+bool FilterSpillEngine::ReadBlob(vector<uint8_t>& blob, size_t offset, size_t length)
+{
+	blob.resize(length);
+	if(length == 0)
+		return true;
+	if(fseek(m_spillFile, offset, SEEK_SET) != 0)
+		return false;
+	return fread(&blob[0], 1, length, m_spillFile) == length;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Spill queue management
+
+/**
+	@brief Offers a filter's outputs for spilling
+
+	Called by the executor after a graph run in which all of the filter's consumers executed: the outputs
+	are now idle and may be pushed to disk if memory pressure fires. Has no effect if the filter is
+	already queued or spilled, or its outputs are shared with a deduplicated peer.
+ */
+void FilterSpillEngine::MarkSpillable(Filter* f)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_spillQueueSet.count(f) || m_spilled.count(f))
+		return;
+
+	//Shared waveforms can't be spilled: the peer holds raw pointers to them
+	if(!f->m_borrowedOutputs.empty())
+		return;
+	{
+		lock_guard<mutex> block(Filter::m_borrowMutex);
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			auto data = f->m_streams[i].m_waveform;
+			if(data && Filter::m_waveformBorrowers.count(data))
+				return;
+		}
+	}
+
+	m_spillQueue.push_back(f);
+	m_spillQueueSet.insert(f);
+}
+
+/**
+	@brief Drops all spill state for a filter
+
+	Called when the filter is about to refresh (its outputs are being replaced, so any spilled copy is
+	stale) and when it is destroyed. Spilled blobs are abandoned in place; the scratch file is truncated
+	once the last spilled entry is gone.
+ */
+void FilterSpillEngine::Forget(Filter* f)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_spillQueueSet.erase(f))
+		m_spillQueue.remove(f);
+
+	if(m_spilled.erase(f))
+		f->m_hasSpilledOutputs = false;
+
+	//Reclaim the scratch file space once nothing references it anymore
+	if(m_spilled.empty())
+		TruncateSpillFile();
+}
+
+///@brief Empties the scratch file (caller must hold m_mutex and have verified nothing is spilled)
+void FilterSpillEngine::TruncateSpillFile()
+{
+	if(!m_spillFile)
+		return;
+
+	fseek(m_spillFile, 0, SEEK_SET);
+	#ifndef _WIN32
+	if(0 != ftruncate(fileno(m_spillFile), 0))
+		LogWarning("Failed to truncate filter spill file \"%s\"\n", m_spillPath.c_str());
+	#endif
+	m_spillSize = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Spilling
+
+/**
+	@brief Compresses and spills the outputs of one filter (caller must hold m_mutex)
+
+	@return Estimated number of bytes of waveform RAM freed
+ */
+size_t FilterSpillEngine::SpillFilter(Filter* f)
+{
+	//Create the spill file the first time we need it
+	if(!m_spillFile)
+	{
+		if(m_spillPath.empty())
+		{
+			const char* tmpdir = getenv("TMPDIR");
+			#ifdef _WIN32
+			if(!tmpdir)
+				tmpdir = getenv("TEMP");
+			#endif
+			if(!tmpdir)
+				tmpdir = "/tmp";
+			m_spillPath = string(tmpdir) + "/scopehal-spill-" + to_string(getpid()) + ".tmp";
+		}
+		m_spillFile = fopen(m_spillPath.c_str(), "w+b");
+		if(!m_spillFile)
+		{
+			LogError("Couldn't create filter spill file \"%s\"\n", m_spillPath.c_str());
+			return 0;
+		}
+	}
+	fseek(m_spillFile, 0, SEEK_END);
+
+	size_t freed = 0;
+	vector<SpilledStream> streams;
+	bool spilledAny = false;
+	for(size_t i=0; i<f->GetStreamCount(); i++)
+	{
+		streams.push_back(SpilledStream());
+		auto& ss = streams.back();
+
+		//Streams with no data, or with waveform types that have no compressed representation
+		//(protocol decodes etc), simply stay as they are
+		auto data = f->m_streams[i].m_waveform;
+		if(!data)
+			continue;
+		auto cwfm = WaveformCompressor::Compress(data);
+		if(!cwfm)
+			continue;
+
+		//Push the compressed blobs to the scratch file, keeping only the metadata resident
+		ss.m_samplesLength = cwfm->m_samples.size();
+		ss.m_offsetsLength = cwfm->m_offsets.size();
+		ss.m_durationsLength = cwfm->m_durations.size();
+		if( !WriteBlob(cwfm->m_samples, ss.m_samplesOffset) ||
+			!WriteBlob(cwfm->m_offsets, ss.m_offsetsOffset) ||
+			!WriteBlob(cwfm->m_durations, ss.m_durationsOffset) )
+		{
+			//This stream stays resident; anything already spilled is still recorded below
+			LogError("Write to filter spill file \"%s\" failed, remaining outputs stay resident\n",
+				m_spillPath.c_str());
+			ss.m_meta = nullptr;
+			break;
+		}
+		vector<uint8_t>().swap(cwfm->m_samples);
+		vector<uint8_t>().swap(cwfm->m_offsets);
+		vector<uint8_t>().swap(cwfm->m_durations);
+		ss.m_meta = move(cwfm);
+
+		//Free the live waveform. The memoized output key keeps dangling pointer identity only;
+		//Filter::IsRefreshNeeded() knows not to compare keys for spilled streams.
+		freed += EstimateWaveformBytes(data);
+		delete data;
+		f->m_streams[i].m_waveform = nullptr;
+		spilledAny = true;
+	}
+
+	if(spilledAny)
+	{
+		fflush(m_spillFile);
+		m_spilled[f] = move(streams);
+		f->m_hasSpilledOutputs = true;
+	}
+	return freed;
+}
+
+/**
+	@brief Spills everything in the spill queue, coldest first
+
+	Invoked by the MemoryPressureManager when host memory runs short.
+
+	@return Number of bytes of waveform RAM freed
+ */
+size_t FilterSpillEngine::SpillHostMemory()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t freed = 0;
+	for(auto f : m_spillQueue)
+	{
+		m_spillQueueSet.erase(f);
+		freed += SpillFilter(f);
+	}
+	m_spillQueue.clear();
+	return freed;
+}
+
+///@brief Returns the estimated number of bytes of waveform RAM that would be freed by spilling the queue
+size_t FilterSpillEngine::GetHostMemoryUse()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t total = 0;
+	for(auto f : m_spillQueue)
+	{
+		for(size_t i=0; i<f->GetStreamCount(); i++)
+		{
+			auto data = f->m_streams[i].m_waveform;
+			if(data)
+				total += EstimateWaveformBytes(data);
+		}
+	}
+	return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rehydration
+
+/**
+	@brief Restores a filter's spilled outputs from the scratch file
+
+	The decompressed waveforms are bit-exact copies of the originals, including revision counters, so the
+	filter's own memoization state is updated to the new objects and it remains skippable. Safe to call on
+	a filter with nothing spilled (does nothing); typically invoked from Filter::GetData().
+ */
+void FilterSpillEngine::Rehydrate(Filter* f)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto it = m_spilled.find(f);
+	if(it == m_spilled.end())
+		return;
+
+	auto& streams = it->second;
+	for(size_t i=0; i<streams.size(); i++)
+	{
+		auto& ss = streams[i];
+		if(!ss.m_meta)
+			continue;
+
+		//Pull the blobs back and decompress
+		auto& cwfm = *ss.m_meta;
+		if( !ReadBlob(cwfm.m_samples, ss.m_samplesOffset, ss.m_samplesLength) ||
+			!ReadBlob(cwfm.m_offsets, ss.m_offsetsOffset, ss.m_offsetsLength) ||
+			!ReadBlob(cwfm.m_durations, ss.m_durationsOffset, ss.m_durationsLength) )
+		{
+			LogError("Read from filter spill file \"%s\" failed, output of %s stream %zu is lost\n",
+				m_spillPath.c_str(), f->GetDisplayName().c_str(), i);
+			continue;
+		}
+		auto wfm = WaveformCompressor::Decompress(cwfm);
+		f->m_streams[i].m_waveform = wfm;
+
+		//Revision and content are identical to what was memoized, only the object identity changed
+		if(f->m_refreshStateValid && (i < f->m_memoizedOutputs.size()) && wfm)
+			f->m_memoizedOutputs[i] = WaveformCacheKey(wfm);
+	}
+
+	m_spilled.erase(it);
+	f->m_hasSpilledOutputs = false;
+
+	if(m_spilled.empty())
+		TruncateSpillFile();
+
+	MemoryPressureManager::GetInstance().Touch(this);
+}
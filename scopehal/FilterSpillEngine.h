@@ -0,0 +1,151 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of FilterSpillEngine
+	@ingroup core
+ */
+#ifndef FilterSpillEngine_h
+#define FilterSpillEngine_h
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "WaveformCompressor.h"
+#include "MemoryPressureManager.h"
+
+class Filter;
+
+/**
+	@brief Spills idle filter intermediate outputs to a scratch file under memory pressure
+	@ingroup core
+
+	A deep filter chain holds every intermediate output waveform in RAM even though most of them are
+	only read once, by the next stage. After a graph run completes, the executor offers every
+	intermediate (a filter all of whose consumers are inside the run) to this engine; if memory
+	pressure later fires, those outputs are compressed (see WaveformCompressor), appended to a scratch
+	file in $TMPDIR, and freed, trading cheap NVMe bandwidth for an otherwise impossible working set.
+
+	Rehydration is transparent: Filter::GetData() on a spilled filter decompresses the outputs back
+	from the scratch file, bit-exact including the revision counter, so probing an intermediate or
+	re-running a consumer just works. The producing filter itself stays skippable by memoization
+	while spilled; consumers that re-hash their inputs after a rehydrate will see a new waveform
+	object and re-run once, which is the price of having freed the original.
+
+	Waveform types without a compressed representation (protocol decodes) stay resident; borrowed or
+	borrowing (deduplicated) outputs are never spilled since the waveforms are shared. The scratch
+	file is append-only and is truncated whenever the last spilled entry is rehydrated or forgotten.
+
+	All public methods are thread safe.
+ */
+class FilterSpillEngine : public MemoryPressureClient
+{
+public:
+	static FilterSpillEngine& GetInstance();
+
+	void MarkSpillable(Filter* f);
+	void Forget(Filter* f);
+	void Rehydrate(Filter* f);
+
+	//MemoryPressureClient
+	virtual size_t GetDeviceMemoryUse() override
+	{ return 0; }
+
+	virtual size_t GetHostMemoryUse() override;
+
+	virtual size_t EvictDeviceMemory() override
+	{ return 0; }
+
+	virtual size_t SpillHostMemory() override;
+
+	virtual MemoryBudgetGroup GetBudgetGroup() override
+	{ return MemoryBudgetGroup::FilterIntermediates; }
+
+protected:
+	FilterSpillEngine();
+	~FilterSpillEngine();
+
+	//not copyable or assignable
+	FilterSpillEngine(const FilterSpillEngine&) =delete;
+	FilterSpillEngine& operator=(const FilterSpillEngine&) =delete;
+
+	size_t SpillFilter(Filter* f);
+	void TruncateSpillFile();
+	bool WriteBlob(const std::vector<uint8_t>& blob, size_t& offset);
+	bool ReadBlob(std::vector<uint8_t>& blob, size_t offset, size_t length);
+
+	///@brief One spilled output stream: compressed metadata resident, compressed bytes in the scratch file
+	struct SpilledStream
+	{
+		///@brief Compressed waveform with its byte vectors emptied out (null for streams left resident)
+		std::unique_ptr<CompressedWaveform> m_meta;
+
+		///@brief Offset of the sample bytes within the scratch file
+		size_t m_samplesOffset = 0;
+
+		///@brief Offset of the offset bytes within the scratch file (sparse only)
+		size_t m_offsetsOffset = 0;
+
+		///@brief Offset of the duration bytes within the scratch file (sparse only)
+		size_t m_durationsOffset = 0;
+
+		///@brief Lengths of the three blobs, in bytes
+		size_t m_samplesLength = 0;
+		size_t m_offsetsLength = 0;
+		size_t m_durationsLength = 0;
+	};
+
+	///@brief Mutex serializing all spill/rehydrate activity
+	std::mutex m_mutex;
+
+	///@brief Filters whose outputs are idle and may be spilled if pressure fires, coldest first
+	std::list<Filter*> m_spillQueue;
+
+	///@brief Contents of m_spillQueue, for O(log n) membership tests
+	std::set<Filter*> m_spillQueueSet;
+
+	///@brief Spilled output streams of each spilled filter
+	std::map<Filter*, std::vector<SpilledStream>> m_spilled;
+
+	///@brief Scratch file holding the compressed blobs (created on first spill)
+	FILE* m_spillFile;
+
+	///@brief Path of the scratch file
+	std::string m_spillPath;
+
+	///@brief Current size of the scratch file, in bytes
+	size_t m_spillSize;
+};
+
+#endif
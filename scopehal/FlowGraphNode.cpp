@@ -45,6 +45,8 @@ string StreamDescriptor::GetName() const
 	return name;
 }
 
+atomic<uint64_t> g_filterGraphTopologyVersion{0};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -54,6 +56,8 @@ FlowGraphNode::FlowGraphNode()
 
 FlowGraphNode::~FlowGraphNode()
 {
+	g_filterGraphTopologyVersion ++;
+
 	//Release any inputs we currently have refs to
 	for(auto c : m_inputs)
 	{
@@ -71,6 +75,8 @@ FlowGraphNode::~FlowGraphNode()
  */
 void FlowGraphNode::DetachInputs()
 {
+	g_filterGraphTopologyVersion ++;
+
 	for(auto& c : m_inputs)
 		c.m_channel = nullptr;
 }
@@ -98,6 +104,41 @@ void FlowGraphNode::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 	Refresh();
 }
 
+/**
+	@brief Checks if this node would produce different output than its last Refresh() if evaluated now
+
+	The default implementation always returns true (node is evaluated every graph execution). Subclasses which can
+	prove their outputs are still valid (see Filter) may return false, in which case the scheduler skips the node.
+ */
+bool FlowGraphNode::IsRefreshNeeded()
+{
+	return true;
+}
+
+/**
+	@brief Notification that a Refresh() of this node has completed
+
+	Called by the scheduler after each evaluation; the default implementation does nothing.
+ */
+void FlowGraphNode::OnRefreshed()
+{
+}
+
+/**
+	@brief Checks if the last Refresh() of this node ran out of its time slice before finishing
+
+	Long-running nodes (typically packet decoders processing a deep capture) may decode in bounded time slices so that
+	a single heavy node does not monopolize an executor thread. If this returns true after a Refresh(), the scheduler
+	requeues the node (letting other runnable nodes interleave) and calls Refresh() again to continue where it left
+	off; downstream nodes are not unblocked until a Refresh() completes fully.
+
+	The default implementation always returns false (every Refresh() runs to completion).
+ */
+bool FlowGraphNode::IsRefreshIncomplete()
+{
+	return false;
+}
+
 /**
 	@brief Gets the desired location of the nodes's input data
 
@@ -112,6 +153,18 @@ FlowGraphNode::DataLocation FlowGraphNode::GetInputLocation()
 	return LOC_CPU;
 }
 
+/**
+	@brief Returns true if this node's Refresh() does not depend on GPU work having completed by the time it returns.
+
+	A node may return true if it never reads back GPU results on the CPU within Refresh() itself (marking buffers
+	modified-from-GPU is fine, mapping and reading them is not). The executor may then batch this node's command buffer
+	submission with those of other independent nodes, deferring the fence wait until the whole batch is submitted.
+ */
+bool FlowGraphNode::IsDeferredSubmitSafe()
+{
+	return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -166,6 +219,9 @@ void FlowGraphNode::SetInput(size_t i, StreamDescriptor stream, bool force)
 		if(stream == m_inputs[i])
 			return;
 
+		//Anything past this point rewires the graph
+		g_filterGraphTopologyVersion ++;
+
 		if(stream.m_channel == nullptr)	//NULL is always legal
 		{
 			m_inputs[i] = StreamDescriptor(nullptr, 0);
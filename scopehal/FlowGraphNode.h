@@ -44,6 +44,90 @@ class StreamDescriptor;
 #include "Waveform.h"
 #include "Stream.h"
 
+/**
+	@brief Tracks one input of a FlowGraphNode across refresh cycles so the node can reprocess only
+	appended samples when the input is streamed.
+	@ingroup core
+
+	Producers which append samples to a waveform in place advertise this by calling
+	WaveformBase::MarkSamplesAppended(). A consumer keeps one tracker per input it wants to process
+	incrementally, calls IsAppendOnly() at the start of each refresh to decide whether it may resume from
+	its previously committed state, and calls Commit() once it has consumed the input up to its current
+	length. Any other kind of change (new waveform object, rewrite in place, or multiple updates between
+	refreshes) fails the check and the consumer must reprocess the whole record.
+ */
+class InputDirtyRegionTracker
+{
+public:
+	InputDirtyRegionTracker()
+		: m_waveform(nullptr)
+		, m_revision(0)
+		, m_length(0)
+	{}
+
+	/**
+		@brief Checks whether wfm is unchanged, or has only had new samples appended, since the last Commit().
+
+		@return True if all samples before the committed length are intact, false if the consumer must
+				reprocess from scratch
+	 */
+	bool IsAppendOnly(WaveformBase* wfm)
+	{
+		if(wfm != m_waveform)
+			return false;
+
+		//Nothing happened at all
+		if(wfm->m_revision == m_revision)
+			return wfm->size() == m_length;
+
+		//Exactly one update, and it was an append at the point we had processed up to
+		return
+			(wfm->m_revision == m_revision + 1) &&
+			(wfm->m_dirtyStartIndex == m_length) &&
+			(wfm->size() >= m_length);
+	}
+
+	///@brief Records that wfm has been fully consumed at its current revision and length
+	void Commit(WaveformBase* wfm)
+	{
+		m_waveform = wfm;
+		m_revision = wfm->m_revision;
+		m_length = wfm->size();
+	}
+
+	///@brief Forgets any committed state (e.g. when the consumer's configuration changes)
+	void Reset()
+	{
+		m_waveform = nullptr;
+		m_revision = 0;
+		m_length = 0;
+	}
+
+	///@brief Returns the committed length (the index of the first sample not yet processed)
+	size_t GetCommittedLength()
+	{ return m_length; }
+
+protected:
+	///@brief The waveform we are tracking
+	WaveformBase* m_waveform;
+
+	///@brief Revision of the waveform as of the last Commit()
+	uint64_t m_revision;
+
+	///@brief Length of the waveform as of the last Commit()
+	size_t m_length;
+};
+
+/**
+	@brief Generation number for the topology of the global filter graph
+
+	Bumped whenever any node's input is rewired or a node is destroyed, so schedulers can cache derived
+	structures (dependency counts, execution order) and cheaply detect when they've gone stale.
+
+	@ingroup core
+ */
+extern std::atomic<uint64_t> g_filterGraphTopologyVersion;
+
 /**
 	@brief Abstract base class for a node in the signal flow graph.
 	@ingroup core
@@ -89,6 +173,18 @@ public:
 	bool HasParameter(std::string s)
 	{ return (m_parameters.find(s) != m_parameters.end()); }
 
+	/**
+		@brief Checks whether a change to the named parameter requires re-running this node
+
+		Returns false only for parameters marked presentation-only (see FilterParameter::MarkPresentationOnly()),
+		which alter how existing output is drawn but not the output itself. Graph drivers should skip the
+		downstream refresh pass when every parameter touched by an edit reports false here.
+
+		@param s	Name of the parameter
+	 */
+	bool ParameterChangeRequiresRefresh(std::string s)
+	{ return !GetParameter(s).IsPresentationOnly(); }
+
 	///@brief Returns an iterator to the beginning of our parameter map
 	ParameterMapType::iterator GetParamBegin()
 	{ return m_parameters.begin(); }
@@ -128,6 +224,8 @@ public:
 
 	virtual DataLocation GetInputLocation();
 
+	virtual bool IsDeferredSubmitSafe();
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Filter evaluation
 	[[deprecated]]
@@ -136,6 +234,10 @@ public:
 	//Filter evaluation (GPU accelerated)
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 
+	virtual bool IsRefreshNeeded();
+	virtual void OnRefreshed();
+	virtual bool IsRefreshIncomplete();
+
 	//Input handling helpers
 protected:
 
@@ -0,0 +1,224 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of GpuMemoryArena
+	@ingroup vksupport
+ */
+
+#include "scopehal.h"
+#include "GpuMemoryArena.h"
+
+using namespace std;
+
+unique_ptr<GpuMemoryArena> g_gpuMemoryArena;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+GpuMemoryBlock::~GpuMemoryBlock()
+{
+	m_arena->Free(m_slab, m_offset, m_size);
+}
+
+GpuMemoryArena::GpuMemoryArena(uint32_t memoryType, vk::DeviceSize slabSize)
+	: m_memoryType(memoryType)
+	, m_slabSize(slabSize)
+{
+}
+
+GpuMemoryArena::~GpuMemoryArena()
+{
+	//All blocks must have been freed by now, since they hold a raw pointer back to us
+	for(auto& slab : m_slabs)
+	{
+		if(slab && (slab->m_bytesUsed != 0))
+			LogWarning("GpuMemoryArena destroyed with %zu bytes still allocated\n", (size_t)slab->m_bytesUsed);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Allocation
+
+/**
+	@brief Sub-allocates a block of device memory satisfying the given requirements.
+
+	@return The block, or nullptr if the request is too big for the arena or a new slab could not be allocated
+			(in which case the caller should make a dedicated allocation instead).
+ */
+shared_ptr<GpuMemoryBlock> GpuMemoryArena::Allocate(const vk::MemoryRequirements& req)
+{
+	//Refuse huge requests so a few deep-memory waveforms don't fragment the slabs
+	if(req.size > GetMaxSuballocationSize())
+		return nullptr;
+
+	//Refuse requests the slab memory type can't satisfy
+	if( (req.memoryTypeBits & (1 << m_memoryType)) == 0)
+		return nullptr;
+
+	lock_guard<mutex> lock(m_mutex);
+
+	//Try twice: once with what we have, then once more after allocating a fresh slab
+	for(int attempt = 0; attempt < 2; attempt ++)
+	{
+		//First fit search over all slabs
+		for(size_t i=0; i<m_slabs.size(); i++)
+		{
+			//Skip slots emptied by FreeUnusedSlabs()
+			if(!m_slabs[i])
+				continue;
+
+			auto& slab = *m_slabs[i];
+			for(auto it = slab.m_freeBlocks.begin(); it != slab.m_freeBlocks.end(); ++it)
+			{
+				vk::DeviceSize blockStart = it->first;
+				vk::DeviceSize blockSize = it->second;
+
+				//Align the start of the proposed allocation, then see if it still fits in this free block
+				vk::DeviceSize start = (blockStart + req.alignment - 1) & ~(req.alignment - 1);
+				vk::DeviceSize end = start + req.size;
+				if(end > (blockStart + blockSize))
+					continue;
+
+				//It fits. Remove the free block, then put back any unused space before and after us.
+				slab.m_freeBlocks.erase(it);
+				if(start > blockStart)
+					slab.m_freeBlocks[blockStart] = start - blockStart;
+				if( (blockStart + blockSize) > end)
+					slab.m_freeBlocks[end] = (blockStart + blockSize) - end;
+
+				slab.m_bytesUsed += req.size;
+				return make_shared<GpuMemoryBlock>(this, i, **slab.m_memory, start, req.size);
+			}
+		}
+
+		//Nothing fit, grab a new slab and try again
+		if(!AllocateSlab())
+			return nullptr;
+	}
+
+	//Should be unreachable: a fresh slab always fits a request under GetMaxSuballocationSize()
+	return nullptr;
+}
+
+/**
+	@brief Returns a block to its slab's free list, merging with adjacent free blocks
+ */
+void GpuMemoryArena::Free(size_t slab, vk::DeviceSize offset, vk::DeviceSize size)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto& freeBlocks = m_slabs[slab]->m_freeBlocks;
+	m_slabs[slab]->m_bytesUsed -= size;
+
+	//Coalesce with the next free block, if adjacent
+	auto next = freeBlocks.lower_bound(offset);
+	if( (next != freeBlocks.end()) && (next->first == (offset + size)) )
+	{
+		size += next->second;
+		freeBlocks.erase(next);
+	}
+
+	//Coalesce with the previous free block, if adjacent
+	if(!freeBlocks.empty())
+	{
+		auto prev = freeBlocks.lower_bound(offset);
+		if(prev != freeBlocks.begin())
+		{
+			--prev;
+			if( (prev->first + prev->second) == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				freeBlocks.erase(prev);
+			}
+		}
+	}
+
+	freeBlocks[offset] = size;
+}
+
+/**
+	@brief Allocates a new slab of device memory (assumes m_mutex is locked)
+
+	@return True on success, false if the device is out of memory
+ */
+bool GpuMemoryArena::AllocateSlab()
+{
+	vk::MemoryAllocateInfo info(m_slabSize, m_memoryType);
+	try
+	{
+		auto slab = make_unique<Slab>();
+		slab->m_memory = make_unique<vk::raii::DeviceMemory>(*g_vkComputeDevice, info);
+		slab->m_freeBlocks[0] = m_slabSize;
+		slab->m_bytesUsed = 0;
+
+		if(g_hasDebugUtils)
+		{
+			string name = string("GpuMemoryArena.slab") + to_string(m_slabs.size());
+			g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+				vk::DebugUtilsObjectNameInfoEXT(
+					vk::ObjectType::eDeviceMemory,
+					reinterpret_cast<uint64_t>(static_cast<VkDeviceMemory>(**slab->m_memory)),
+					name.c_str()));
+		}
+
+		m_slabs.push_back(std::move(slab));
+		return true;
+	}
+	catch(vk::OutOfDeviceMemoryError& ex)
+	{
+		LogDebug("GpuMemoryArena: failed to allocate new slab (out of device memory)\n");
+		return false;
+	}
+}
+
+/**
+	@brief Frees any slabs that have no live allocations, to reclaim memory under pressure
+
+	@return True if memory was freed
+ */
+bool GpuMemoryArena::FreeUnusedSlabs()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	//Note that we can only null out empty slabs, not erase them from the vector,
+	//since live GpuMemoryBlocks refer to slabs by index
+	bool freed = false;
+	for(auto& slab : m_slabs)
+	{
+		if(slab && (slab->m_bytesUsed == 0))
+		{
+			slab = nullptr;
+			freed = true;
+		}
+	}
+	return freed;
+}
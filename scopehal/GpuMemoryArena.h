@@ -0,0 +1,155 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of GpuMemoryArena
+	@ingroup vksupport
+ */
+
+#ifndef GpuMemoryArena_h
+#define GpuMemoryArena_h
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+class GpuMemoryArena;
+
+/**
+	@brief A sub-allocated range of device memory, returned to the arena's free list on destruction
+	@ingroup vksupport
+ */
+class GpuMemoryBlock
+{
+public:
+	GpuMemoryBlock(GpuMemoryArena* arena, size_t slab, vk::DeviceMemory memory, vk::DeviceSize offset, vk::DeviceSize size)
+	: m_arena(arena)
+	, m_slab(slab)
+	, m_memory(memory)
+	, m_offset(offset)
+	, m_size(size)
+	{}
+
+	~GpuMemoryBlock();
+
+	///@brief Returns the (non-owning) handle to the slab's device memory
+	vk::DeviceMemory GetMemory() const
+	{ return m_memory; }
+
+	///@brief Returns the byte offset of this block within the slab
+	vk::DeviceSize GetOffset() const
+	{ return m_offset; }
+
+	///@brief Returns the size of this block, in bytes
+	vk::DeviceSize GetSize() const
+	{ return m_size; }
+
+public:
+	//non-copyable
+	GpuMemoryBlock(GpuMemoryBlock const&) = delete;
+	GpuMemoryBlock& operator=(GpuMemoryBlock const&) = delete;
+
+protected:
+	GpuMemoryArena* m_arena;
+	size_t m_slab;
+	vk::DeviceMemory m_memory;
+	vk::DeviceSize m_offset;
+	vk::DeviceSize m_size;
+};
+
+/**
+	@brief Arena allocator that sub-allocates buffers from large slabs of device memory
+	@ingroup vksupport
+
+	Many Vulkan implementations limit the total number of live VkDeviceMemory allocations (commonly 4096) and take
+	milliseconds per vkAllocateMemory call. Sub-allocating small buffers from a handful of large slabs avoids both
+	problems: thousands of filter output buffers share a few allocations, and the hot allocation path is a free-list
+	search under a mutex.
+
+	Requests larger than GetMaxSuballocationSize() are refused (returning null) and should fall back to a dedicated
+	allocation, so a few huge deep-memory waveforms don't fragment the slabs.
+ */
+class GpuMemoryArena
+{
+public:
+	GpuMemoryArena(uint32_t memoryType, vk::DeviceSize slabSize = 256 * 1024 * 1024);
+	~GpuMemoryArena();
+
+	std::shared_ptr<GpuMemoryBlock> Allocate(const vk::MemoryRequirements& req);
+
+	///@brief Maximum size of a single sub-allocation; larger requests get a dedicated allocation instead
+	vk::DeviceSize GetMaxSuballocationSize() const
+	{ return m_slabSize / 4; }
+
+	bool FreeUnusedSlabs();
+
+public:
+	//non-copyable
+	GpuMemoryArena(GpuMemoryArena const&) = delete;
+	GpuMemoryArena& operator=(GpuMemoryArena const&) = delete;
+
+protected:
+	friend class GpuMemoryBlock;
+
+	void Free(size_t slab, vk::DeviceSize offset, vk::DeviceSize size);
+
+	///@brief A single large device memory allocation that blocks are carved out of
+	struct Slab
+	{
+		///@brief The underlying device memory
+		std::unique_ptr<vk::raii::DeviceMemory> m_memory;
+
+		///@brief Free ranges within the slab, as a map from byte offset to size
+		std::map<vk::DeviceSize, vk::DeviceSize> m_freeBlocks;
+
+		///@brief Total bytes currently allocated out of this slab
+		vk::DeviceSize m_bytesUsed;
+	};
+
+	bool AllocateSlab();
+
+	///@brief Vulkan memory type index the slabs are allocated from
+	uint32_t m_memoryType;
+
+	///@brief Size of each slab, in bytes
+	vk::DeviceSize m_slabSize;
+
+	///@brief Mutex for synchronizing access to m_slabs across threads
+	std::mutex m_mutex;
+
+	///@brief All slabs allocated so far
+	std::vector<std::unique_ptr<Slab>> m_slabs;
+};
+
+extern std::unique_ptr<GpuMemoryArena> g_gpuMemoryArena;
+
+#endif
@@ -0,0 +1,494 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of GpuPrimitives
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "GpuPrimitives.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+GpuPrimitives::GpuPrimitives()
+	: m_reducePipeline("shaders/PrimitiveReduce.spv", 2, sizeof(GpuReduceArgs))
+	, m_argMaxPipeline("shaders/PrimitiveArgMax.spv", 3, sizeof(GpuReduceArgs))
+	, m_firstBelowPipeline("shaders/PrimitiveFirstBelow.spv", 2, sizeof(GpuThresholdArgs))
+	, m_scanPipeline("shaders/PrimitiveExclusiveScan.spv", 3, sizeof(GpuScanArgs))
+	, m_scanFixupPipeline("shaders/PrimitiveScanAddBlockSums.spv", 2, sizeof(GpuScanArgs))
+	, m_sortHistogramPipeline("shaders/PrimitiveSortHistogram.spv", 2, sizeof(GpuSortPassArgs))
+	, m_sortScatterPipeline("shaders/PrimitiveSortScatter.spv", 3, sizeof(GpuSortPassArgs))
+	, m_sortScatterKVPipeline("shaders/PrimitiveSortScatterKV.spv", 5, sizeof(GpuSortPassArgs))
+	, m_compactPipeline("shaders/PrimitiveCompact.spv", 4, sizeof(GpuCompactArgs))
+{
+	m_reducePartials.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_reducePartials.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_reduceIndices.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_reduceIndices.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+	m_sortScratchKeys.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	m_sortScratchKeys.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_sortScratchValues.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	m_sortScratchValues.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_sortCounts.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	m_sortCounts.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_sortCountsScanned.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+	m_sortCountsScanned.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
+	m_compactIndices.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_compactIndices.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduction
+
+/**
+	@brief Computes the sum of a float buffer
+
+	@param samples	The samples to sum
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+
+	@return Sum of all sample values
+ */
+float GpuPrimitives::ReduceSum(
+	AcceleratorBuffer<float>& samples,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = samples.size();
+	if(npoints == 0)
+		return 0;
+
+	//One partial per workgroup; don't launch more workgroups than there are full thread blocks of input
+	size_t nblocks = min(REDUCE_MAX_BLOCKS, (size_t)GetComputeBlockCount(npoints, REDUCE_THREADS));
+	m_reducePartials.resize(nblocks);
+
+	cmdBuf.begin({});
+	GpuReduceArgs args;
+	args.npoints = npoints;
+	m_reducePipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_reducePipeline.BindBufferNonblocking(1, m_reducePartials, cmdBuf, true);
+	m_reducePipeline.Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_reducePartials.MarkModifiedFromGpu();
+
+	//Combine the per-workgroup partials (at most a few kB of data)
+	m_reducePartials.PrepareForCpuAccess();
+	double sum = 0;
+	for(size_t i=0; i<nblocks; i++)
+		sum += m_reducePartials[i];
+	return sum;
+}
+
+/**
+	@brief Finds the value and index of the maximum of a float buffer
+
+	Ties go to the lowest index, matching a serial scan. Commonly used to locate the dominant bin of a spectrum
+	without downloading it to the host.
+
+	@param samples	The samples to search
+	@param maxval	Set to the maximum sample value
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+
+	@return Index of the maximum value (0 with maxval = -FLT_MAX if the buffer is empty)
+ */
+size_t GpuPrimitives::ReduceArgMax(
+	AcceleratorBuffer<float>& samples,
+	float& maxval,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = samples.size();
+	if(npoints == 0)
+	{
+		maxval = -FLT_MAX;
+		return 0;
+	}
+
+	//One partial per workgroup; don't launch more workgroups than there are full thread blocks of input
+	size_t nblocks = min(REDUCE_MAX_BLOCKS, (size_t)GetComputeBlockCount(npoints, REDUCE_THREADS));
+	m_reducePartials.resize(nblocks);
+	m_reduceIndices.resize(nblocks);
+
+	cmdBuf.begin({});
+	GpuReduceArgs args;
+	args.npoints = npoints;
+	m_argMaxPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_argMaxPipeline.BindBufferNonblocking(1, m_reducePartials, cmdBuf, true);
+	m_argMaxPipeline.BindBufferNonblocking(2, m_reduceIndices, cmdBuf, true);
+	m_argMaxPipeline.Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_reducePartials.MarkModifiedFromGpu();
+	m_reduceIndices.MarkModifiedFromGpu();
+
+	//Combine the per-workgroup partials (at most a few kB of data)
+	m_reducePartials.PrepareForCpuAccess();
+	m_reduceIndices.PrepareForCpuAccess();
+	maxval = -FLT_MAX;
+	size_t imax = 0;
+	for(size_t i=0; i<nblocks; i++)
+	{
+		if( (m_reducePartials[i] > maxval) ||
+			( (m_reducePartials[i] == maxval) && (m_reduceIndices[i] < imax) ) )
+		{
+			maxval = m_reducePartials[i];
+			imax = m_reduceIndices[i];
+		}
+	}
+	return imax;
+}
+
+/**
+	@brief Finds the index of the first element of a float buffer below a threshold
+
+	Commonly used for edge measurements on spectra (e.g. the -3 dB point) without downloading them to the host.
+
+	@param samples		The samples to search
+	@param threshold	Values below this threshold match
+	@param cmdBuf		Command buffer for GPU work (must not be in the recording state)
+	@param queue		Queue to submit GPU work to
+
+	@return Index of the first matching element, or samples.size() if no element is below the threshold
+ */
+size_t GpuPrimitives::FindFirstBelow(
+	AcceleratorBuffer<float>& samples,
+	float threshold,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = samples.size();
+	if(npoints == 0)
+		return 0;
+
+	//One partial per workgroup; don't launch more workgroups than there are full thread blocks of input
+	size_t nblocks = min(REDUCE_MAX_BLOCKS, (size_t)GetComputeBlockCount(npoints, REDUCE_THREADS));
+	m_reduceIndices.resize(nblocks);
+
+	cmdBuf.begin({});
+	GpuThresholdArgs args;
+	args.npoints = npoints;
+	args.threshold = threshold;
+	m_firstBelowPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_firstBelowPipeline.BindBufferNonblocking(1, m_reduceIndices, cmdBuf, true);
+	m_firstBelowPipeline.Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_reduceIndices.MarkModifiedFromGpu();
+
+	//Combine the per-workgroup partials (at most a few kB of data)
+	m_reduceIndices.PrepareForCpuAccess();
+	uint32_t imin = 0xffffffff;
+	for(size_t i=0; i<nblocks; i++)
+		imin = min(imin, m_reduceIndices[i]);
+	if(imin == 0xffffffff)
+		return npoints;
+	return imin;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Prefix sums
+
+/**
+	@brief Computes the exclusive prefix sum of a uint32 buffer
+
+	dout[0] = 0, dout[i] = din[0] + ... + din[i-1]. The output buffer is resized to match the input.
+
+	@param din		Input values
+	@param dout		Output prefix sums (may not alias din)
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+ */
+void GpuPrimitives::ExclusiveScan(
+	AcceleratorBuffer<uint32_t>& din,
+	AcceleratorBuffer<uint32_t>& dout,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = din.size();
+	if(npoints == 0)
+	{
+		dout.resize(0);
+		return;
+	}
+	dout.resize(npoints);
+
+	cmdBuf.begin({});
+	RecordScan(din, dout, npoints, 0, cmdBuf);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	dout.MarkModifiedFromGpu();
+}
+
+/**
+	@brief Records an exclusive scan of din into dout (both at least npoints elements)
+
+	Each workgroup scans SCAN_BLOCK elements and emits its total; if there's more than one workgroup, the totals
+	are scanned recursively and a fixup pass adds each workgroup's scanned total to its elements. Scratch buffers
+	are kept per recursion level so repeated scans reuse them.
+ */
+void GpuPrimitives::RecordScan(
+	AcceleratorBuffer<uint32_t>& din,
+	AcceleratorBuffer<uint32_t>& dout,
+	size_t npoints,
+	size_t level,
+	vk::raii::CommandBuffer& cmdBuf)
+{
+	size_t nblocks = (npoints + SCAN_BLOCK - 1) / SCAN_BLOCK;
+
+	//Make sure this level's scratch buffers exist and are big enough
+	while(m_scanSums.size() <= level)
+	{
+		m_scanSums.push_back(make_unique<AcceleratorBuffer<uint32_t>>());
+		m_scanSumsScanned.push_back(make_unique<AcceleratorBuffer<uint32_t>>());
+		m_scanSums[m_scanSums.size()-1]->SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+		m_scanSums[m_scanSums.size()-1]->SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+		m_scanSumsScanned[m_scanSumsScanned.size()-1]->SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_NEVER);
+		m_scanSumsScanned[m_scanSumsScanned.size()-1]->SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	}
+	auto& sums = *m_scanSums[level];
+	auto& sumsScanned = *m_scanSumsScanned[level];
+	if(sums.size() < nblocks)
+	{
+		sums.resize(nblocks);
+		sumsScanned.resize(nblocks);
+	}
+
+	//Scan each workgroup's span and collect the workgroup totals
+	GpuScanArgs args;
+	args.npoints = npoints;
+	m_scanPipeline.BindBufferNonblocking(0, din, cmdBuf);
+	m_scanPipeline.BindBufferNonblocking(1, dout, cmdBuf, true);
+	m_scanPipeline.BindBufferNonblocking(2, sums, cmdBuf, true);
+	m_scanPipeline.Dispatch(cmdBuf, args, nblocks);
+
+	//Single workgroup covered everything, no fixup needed
+	if(nblocks == 1)
+		return;
+
+	//Scan the workgroup totals, then add each workgroup's scanned total to its span
+	m_scanPipeline.AddComputeMemoryBarrier(cmdBuf);
+	RecordScan(sums, sumsScanned, nblocks, level + 1, cmdBuf);
+	m_scanFixupPipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_scanFixupPipeline.BindBufferNonblocking(0, dout, cmdBuf, true);
+	m_scanFixupPipeline.BindBufferNonblocking(1, sumsScanned, cmdBuf);
+	m_scanFixupPipeline.Dispatch(cmdBuf, args, nblocks);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sorting
+
+/**
+	@brief Sorts a buffer of uint32 keys in ascending order
+
+	@param keys		The keys to sort (sorted in place)
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+ */
+void GpuPrimitives::RadixSort(
+	AcceleratorBuffer<uint32_t>& keys,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	DoRadixSort(keys, nullptr, cmdBuf, queue);
+}
+
+/**
+	@brief Sorts a buffer of uint32 keys in ascending order, applying the same permutation to a payload buffer
+
+	Commonly used with the payload holding indices into some other dataset, e.g. ranking peaks by magnitude.
+
+	@param keys		The keys to sort (sorted in place)
+	@param values	Payload to permute alongside the keys (same length as keys)
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+ */
+void GpuPrimitives::RadixSort(
+	AcceleratorBuffer<uint32_t>& keys,
+	AcceleratorBuffer<uint32_t>& values,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	DoRadixSort(keys, &values, cmdBuf, queue);
+}
+
+/**
+	@brief Stable LSD radix sort over 4-bit digits (8 passes for 32-bit keys)
+
+	Each pass histograms the keys' current digit per workgroup (digit-major, so an exclusive scan of the counts
+	yields every digit/workgroup pair's global scatter base), scans the counts, then scatters keys to their final
+	position for this pass. All 24 dispatches are recorded into one submission; after the even number of
+	ping-pong passes the result lands back in the caller's buffer.
+ */
+void GpuPrimitives::DoRadixSort(
+	AcceleratorBuffer<uint32_t>& keys,
+	AcceleratorBuffer<uint32_t>* values,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = keys.size();
+	if(npoints <= 1)
+		return;
+
+	size_t nblocks = (npoints + SORT_BLOCK - 1) / SORT_BLOCK;
+	if(m_sortScratchKeys.size() < npoints)
+		m_sortScratchKeys.resize(npoints);
+	if(values && (m_sortScratchValues.size() < npoints) )
+		m_sortScratchValues.resize(npoints);
+	size_t ncounts = SORT_RADIX_DIGITS * nblocks;
+	if(m_sortCounts.size() < ncounts)
+	{
+		m_sortCounts.resize(ncounts);
+		m_sortCountsScanned.resize(ncounts);
+	}
+
+	cmdBuf.begin({});
+
+	AcceleratorBuffer<uint32_t>* srcKeys = &keys;
+	AcceleratorBuffer<uint32_t>* dstKeys = &m_sortScratchKeys;
+	AcceleratorBuffer<uint32_t>* srcValues = values;
+	AcceleratorBuffer<uint32_t>* dstValues = values ? &m_sortScratchValues : nullptr;
+
+	for(size_t shift = 0; shift < 32; shift += SORT_RADIX_BITS)
+	{
+		GpuSortPassArgs args;
+		args.npoints = npoints;
+		args.nblocks = nblocks;
+		args.shift = shift;
+
+		if(shift > 0)
+			m_sortHistogramPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		//Count this digit's values in each workgroup's span
+		m_sortHistogramPipeline.BindBufferNonblocking(0, *srcKeys, cmdBuf);
+		m_sortHistogramPipeline.BindBufferNonblocking(1, m_sortCounts, cmdBuf, true);
+		m_sortHistogramPipeline.Dispatch(cmdBuf, args, nblocks);
+		m_sortHistogramPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		//Scan the counts to get each digit/workgroup pair's global scatter base
+		RecordScan(m_sortCounts, m_sortCountsScanned, ncounts, 0, cmdBuf);
+		m_scanPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+		//Scatter keys (and payload) to their sorted positions for this pass
+		if(values)
+		{
+			m_sortScatterKVPipeline.BindBufferNonblocking(0, *srcKeys, cmdBuf);
+			m_sortScatterKVPipeline.BindBufferNonblocking(1, *dstKeys, cmdBuf, true);
+			m_sortScatterKVPipeline.BindBufferNonblocking(2, m_sortCountsScanned, cmdBuf);
+			m_sortScatterKVPipeline.BindBufferNonblocking(3, *srcValues, cmdBuf);
+			m_sortScatterKVPipeline.BindBufferNonblocking(4, *dstValues, cmdBuf, true);
+			m_sortScatterKVPipeline.Dispatch(cmdBuf, args, nblocks);
+		}
+		else
+		{
+			m_sortScatterPipeline.BindBufferNonblocking(0, *srcKeys, cmdBuf);
+			m_sortScatterPipeline.BindBufferNonblocking(1, *dstKeys, cmdBuf, true);
+			m_sortScatterPipeline.BindBufferNonblocking(2, m_sortCountsScanned, cmdBuf);
+			m_sortScatterPipeline.Dispatch(cmdBuf, args, nblocks);
+		}
+
+		swap(srcKeys, dstKeys);
+		swap(srcValues, dstValues);
+	}
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	//32/4 = 8 passes, so the final result is back in the caller's buffers
+	keys.MarkModifiedFromGpu();
+	if(values)
+		values->MarkModifiedFromGpu();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compaction
+
+/**
+	@brief Copies the elements of din whose predicate is nonzero to dout, preserving their order
+
+	@param din			Input values
+	@param predicates	One uint32 per input element, nonzero to keep it
+	@param dout			Output buffer, resized to the number of kept elements
+	@param cmdBuf		Command buffer for GPU work (must not be in the recording state)
+	@param queue		Queue to submit GPU work to
+
+	@return Number of elements kept
+ */
+size_t GpuPrimitives::Compact(
+	AcceleratorBuffer<float>& din,
+	AcceleratorBuffer<uint32_t>& predicates,
+	AcceleratorBuffer<float>& dout,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = din.size();
+	if(npoints == 0)
+	{
+		dout.resize(0);
+		return 0;
+	}
+
+	m_compactIndices.resize(npoints);
+	if(dout.size() < npoints)
+		dout.resize(npoints);
+
+	cmdBuf.begin({});
+
+	//Scan the predicates: each kept element's scanned value is its output index
+	RecordScan(predicates, m_compactIndices, npoints, 0, cmdBuf);
+	m_compactPipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	GpuCompactArgs args;
+	args.npoints = npoints;
+	m_compactPipeline.BindBufferNonblocking(0, din, cmdBuf);
+	m_compactPipeline.BindBufferNonblocking(1, dout, cmdBuf, true);
+	m_compactPipeline.BindBufferNonblocking(2, predicates, cmdBuf);
+	m_compactPipeline.BindBufferNonblocking(3, m_compactIndices, cmdBuf);
+	m_compactPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, REDUCE_THREADS));
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	dout.MarkModifiedFromGpu();
+	m_compactIndices.MarkModifiedFromGpu();
+
+	//Number of kept elements = scan total (last scanned index plus last predicate)
+	m_compactIndices.PrepareForCpuAccess();
+	predicates.PrepareForCpuAccess();
+	size_t count = m_compactIndices[npoints-1] + (predicates[npoints-1] ? 1 : 0);
+	dout.resize(count);
+	return count;
+}
@@ -0,0 +1,266 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of GpuPrimitives
+	@ingroup core
+ */
+#ifndef GpuPrimitives_h
+#define GpuPrimitives_h
+
+#include <cstring>
+
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+
+class QueueHandle;
+
+/**
+	@brief Arguments to the sum reduction shader
+	@ingroup core
+ */
+struct GpuReduceArgs
+{
+	///@brief Number of input elements
+	uint32_t npoints;
+};
+
+/**
+	@brief Arguments to the threshold-crossing search shader
+	@ingroup core
+ */
+struct GpuThresholdArgs
+{
+	///@brief Number of input elements
+	uint32_t npoints;
+
+	///@brief Threshold to compare against
+	float threshold;
+};
+
+/**
+	@brief Arguments to the exclusive scan and scan-fixup shaders
+	@ingroup core
+ */
+struct GpuScanArgs
+{
+	///@brief Number of input elements
+	uint32_t npoints;
+};
+
+/**
+	@brief Arguments to the radix sort histogram and scatter shaders
+	@ingroup core
+ */
+struct GpuSortPassArgs
+{
+	///@brief Number of keys being sorted
+	uint32_t npoints;
+
+	///@brief Number of sort workgroups
+	uint32_t nblocks;
+
+	///@brief Bit position of the digit this pass sorts on
+	uint32_t shift;
+};
+
+/**
+	@brief Arguments to the stream compaction scatter shader
+	@ingroup core
+ */
+struct GpuCompactArgs
+{
+	///@brief Number of input elements
+	uint32_t npoints;
+};
+
+/**
+	@brief Reusable GPU sort / scan / reduce / compaction primitives over AcceleratorBuffer
+	@ingroup core
+
+	Provides the building blocks that keep showing up in filters (percentile extraction, peak ranking, hit lists,
+	sparse compaction) so each one doesn't need its own CPU fallback via std::sort or a serial prefix-sum loop:
+
+	* ReduceSum(): sum of a float buffer
+	* ReduceArgMax(): value and index of the maximum of a float buffer
+	* FindFirstBelow(): index of the first element of a float buffer below a threshold
+	* ExclusiveScan(): exclusive prefix sum of a uint32 buffer
+	* RadixSort(): stable LSD radix sort of uint32 keys, optionally with a uint32 payload per key
+	* Compact(): keeps the elements of a float buffer whose predicate is nonzero, preserving order
+
+	Each call records all of its passes into one command buffer submission and blocks until complete, leaving the
+	results GPU resident (except for the small values returned by ReduceSum() and Compact()). Float keys can be
+	sorted by converting them with FloatToSortableKey() first and converting back afterwards.
+
+	An instance owns its scratch buffers, so it is not safe to share one instance between threads; filters should
+	hold their own (the buffers are lazily sized, an unused instance costs almost nothing).
+ */
+class GpuPrimitives
+{
+public:
+	GpuPrimitives();
+
+	float ReduceSum(
+		AcceleratorBuffer<float>& samples,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	size_t ReduceArgMax(
+		AcceleratorBuffer<float>& samples,
+		float& maxval,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	size_t FindFirstBelow(
+		AcceleratorBuffer<float>& samples,
+		float threshold,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void ExclusiveScan(
+		AcceleratorBuffer<uint32_t>& din,
+		AcceleratorBuffer<uint32_t>& dout,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void RadixSort(
+		AcceleratorBuffer<uint32_t>& keys,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	void RadixSort(
+		AcceleratorBuffer<uint32_t>& keys,
+		AcceleratorBuffer<uint32_t>& values,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	size_t Compact(
+		AcceleratorBuffer<float>& din,
+		AcceleratorBuffer<uint32_t>& predicates,
+		AcceleratorBuffer<float>& dout,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	/**
+		@brief Maps a float to a uint32 key with the same ordering, so floats can be radix sorted
+
+		Flips the sign bit of non-negative values and all bits of negative values; the resulting unsigned
+		comparison order matches the float comparison order (with -0 < +0 and NaNs sorting to the ends).
+	 */
+	static uint32_t FloatToSortableKey(float f)
+	{
+		uint32_t u;
+		memcpy(&u, &f, sizeof(u));
+		uint32_t mask = -(int32_t)(u >> 31) | 0x80000000;
+		return u ^ mask;
+	}
+
+	///@brief Inverse of FloatToSortableKey()
+	static float SortableKeyToFloat(uint32_t key)
+	{
+		uint32_t mask = ((key >> 31) - 1) | 0x80000000;
+		uint32_t u = key ^ mask;
+		float f;
+		memcpy(&f, &u, sizeof(f));
+		return f;
+	}
+
+protected:
+	void RecordScan(
+		AcceleratorBuffer<uint32_t>& din,
+		AcceleratorBuffer<uint32_t>& dout,
+		size_t npoints,
+		size_t level,
+		vk::raii::CommandBuffer& cmdBuf);
+
+	void DoRadixSort(
+		AcceleratorBuffer<uint32_t>& keys,
+		AcceleratorBuffer<uint32_t>* values,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	///@brief Number of threads per reduction workgroup (must match the reduce shader's local_size_x)
+	static const size_t REDUCE_THREADS = 256;
+
+	///@brief Maximum number of reduction workgroups (and thus partials combined on the CPU)
+	static const size_t REDUCE_MAX_BLOCKS = 1024;
+
+	///@brief Elements processed by one scan workgroup (two per thread, must match the scan shader)
+	static const size_t SCAN_BLOCK = 512;
+
+	///@brief Keys processed by one radix sort workgroup (must match the sort shaders' local_size_x)
+	static const size_t SORT_BLOCK = 256;
+
+	///@brief Number of bits sorted per radix pass
+	static const size_t SORT_RADIX_BITS = 4;
+
+	///@brief Number of digit values per radix pass
+	static const size_t SORT_RADIX_DIGITS = 16;
+
+	ComputePipeline m_reducePipeline;
+	ComputePipeline m_argMaxPipeline;
+	ComputePipeline m_firstBelowPipeline;
+	ComputePipeline m_scanPipeline;
+	ComputePipeline m_scanFixupPipeline;
+	ComputePipeline m_sortHistogramPipeline;
+	ComputePipeline m_sortScatterPipeline;
+	ComputePipeline m_sortScatterKVPipeline;
+	ComputePipeline m_compactPipeline;
+
+	///@brief Per-workgroup partial sums (or maxima) for the reductions
+	AcceleratorBuffer<float> m_reducePartials;
+
+	///@brief Per-workgroup partial indices for the argmax and threshold-crossing reductions
+	AcceleratorBuffer<uint32_t> m_reduceIndices;
+
+	///@brief Per-level workgroup totals for the scan (index 0 = innermost level)
+	std::vector<std::unique_ptr<AcceleratorBuffer<uint32_t>>> m_scanSums;
+
+	///@brief Per-level scanned workgroup totals (same shape as m_scanSums)
+	std::vector<std::unique_ptr<AcceleratorBuffer<uint32_t>>> m_scanSumsScanned;
+
+	///@brief Ping-pong buffer for sort keys
+	AcceleratorBuffer<uint32_t> m_sortScratchKeys;
+
+	///@brief Ping-pong buffer for sort payloads
+	AcceleratorBuffer<uint32_t> m_sortScratchValues;
+
+	///@brief Per-workgroup, per-digit key counts for the current sort pass
+	AcceleratorBuffer<uint32_t> m_sortCounts;
+
+	///@brief Exclusive scan of m_sortCounts (global scatter base for each digit/workgroup pair)
+	AcceleratorBuffer<uint32_t> m_sortCountsScanned;
+
+	///@brief Scanned predicates (output index of each kept element) for compaction
+	AcceleratorBuffer<uint32_t> m_compactIndices;
+};
+
+#endif
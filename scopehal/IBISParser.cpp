@@ -249,6 +249,14 @@ void IBISParser::Clear()
 
 bool IBISParser::Load(string fname)
 {
+	//If we have an up-to-date binary cache of this file from a previous load, use it and skip the text parse
+	time_t timestamp = 0;
+	int64_t fs = 0;
+	GetTimestampOfFile(fname, timestamp, fs);
+	string cachepath = fname + ".cache";
+	if(LoadFromCache(cachepath, timestamp, fs))
+		return true;
+
 	FILE* fp = fopen(fname.c_str(), "r");
 	if(!fp)
 	{
@@ -650,6 +658,11 @@ bool IBISParser::Load(string fname)
 	}
 
 	fclose(fp);
+
+	//Cache the parsed tables so the next load of this file doesn't redo the text parse.
+	//Best effort only: vendor model directories may well be read-only.
+	SaveToCache(cachepath, timestamp, fs);
+
 	return true;
 }
 
@@ -715,3 +728,268 @@ float IBISParser::ParseNumber(const char* str)
 			return ret;
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary cache
+
+//Magic number and layout revision of the parsed-model cache. Bump the version any time the
+//serialization format (or any of the structures it contains) changes.
+#define IBIS_CACHE_MAGIC	0x49424953
+#define IBIS_CACHE_VERSION	1
+
+struct IBISCacheHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	int64_t		file_mtime;
+	int64_t		file_fs;
+};
+
+//Upper bound on any single string or table in a cache file, used to reject corrupted length fields
+//before we try to allocate from them
+static const uint32_t IBIS_CACHE_MAX_LEN = 0x8000000;
+
+static bool CacheWriteString(FILE* fp, const string& str)
+{
+	uint32_t len = str.length();
+	if(1 != fwrite(&len, sizeof(len), 1, fp))
+		return false;
+	if(len && (len != fwrite(str.data(), 1, len, fp)))
+		return false;
+	return true;
+}
+
+static bool CacheReadString(FILE* fp, string& str)
+{
+	uint32_t len;
+	if(1 != fread(&len, sizeof(len), 1, fp))
+		return false;
+	if(len > IBIS_CACHE_MAX_LEN)
+		return false;
+	str.resize(len);
+	if(len && (len != fread(&str[0], 1, len, fp)))
+		return false;
+	return true;
+}
+
+template<class T>
+static bool CacheWritePoints(FILE* fp, const vector<T>& points)
+{
+	uint32_t len = points.size();
+	if(1 != fwrite(&len, sizeof(len), 1, fp))
+		return false;
+	if(len && (len != fwrite(points.data(), sizeof(T), len, fp)))
+		return false;
+	return true;
+}
+
+template<class T>
+static bool CacheReadPoints(FILE* fp, vector<T>& points)
+{
+	uint32_t len;
+	if(1 != fread(&len, sizeof(len), 1, fp))
+		return false;
+	if(len > IBIS_CACHE_MAX_LEN)
+		return false;
+	points.resize(len);
+	if(len && (len != fread(&points[0], sizeof(T), len, fp)))
+		return false;
+	return true;
+}
+
+static bool CacheWriteVTCurves(FILE* fp, const VTCurves& curves)
+{
+	if(1 != fwrite(&curves.m_fixtureResistance, sizeof(float), 1, fp))
+		return false;
+	if(1 != fwrite(&curves.m_fixtureVoltage, sizeof(float), 1, fp))
+		return false;
+	for(int i=0; i<3; i++)
+	{
+		if(!CacheWritePoints(fp, curves.m_curves[i]))
+			return false;
+	}
+	return true;
+}
+
+static bool CacheReadVTCurves(FILE* fp, VTCurves& curves)
+{
+	if(1 != fread(&curves.m_fixtureResistance, sizeof(float), 1, fp))
+		return false;
+	if(1 != fread(&curves.m_fixtureVoltage, sizeof(float), 1, fp))
+		return false;
+	for(int i=0; i<3; i++)
+	{
+		if(!CacheReadPoints(fp, curves.m_curves[i]))
+			return false;
+	}
+	return true;
+}
+
+/**
+	@brief Loads the parsed models from a binary cache file written by a previous run.
+
+	The cache is only used if it was written from the exact version of the source file we're about to load
+	(matching modification timestamp), so editing or replacing a .ibs file invalidates it automatically.
+
+	@return True if the cache was present, current, and loaded successfully.
+			False means the caller must parse the source text.
+ */
+bool IBISParser::LoadFromCache(const string& path, time_t expectedTimestamp, int64_t expectedFs)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	IBISCacheHeader header;
+	if(1 != fread(&header, sizeof(header), 1, fp))
+	{
+		fclose(fp);
+		return false;
+	}
+	if( (header.magic != IBIS_CACHE_MAGIC) ||
+		(header.version != IBIS_CACHE_VERSION) ||
+		(header.file_mtime != (int64_t)expectedTimestamp) ||
+		(header.file_fs != expectedFs) )
+	{
+		LogTrace("Rejecting stale IBIS cache file %s\n", path.c_str());
+		fclose(fp);
+		return false;
+	}
+
+	bool ok = CacheReadString(fp, m_component);
+	ok = ok && CacheReadString(fp, m_manufacturer);
+
+	uint32_t nmodels = 0;
+	ok = ok && (1 == fread(&nmodels, sizeof(nmodels), 1, fp));
+	ok = ok && (nmodels <= IBIS_CACHE_MAX_LEN);
+
+	for(uint32_t i=0; ok && (i<nmodels); i++)
+	{
+		string name;
+		if(!CacheReadString(fp, name))
+		{
+			ok = false;
+			break;
+		}
+
+		auto model = new IBISModel(name);
+		m_models[name] = model;
+
+		uint32_t type;
+		ok = (1 == fread(&type, sizeof(type), 1, fp));
+		model->m_type = (IBISModel::type_t)type;
+
+		ok = ok && (1 == fread(&model->m_vil, sizeof(model->m_vil), 1, fp));
+		ok = ok && (1 == fread(&model->m_vih, sizeof(model->m_vih), 1, fp));
+		ok = ok && (1 == fread(&model->m_temps, sizeof(model->m_temps), 1, fp));
+		ok = ok && (1 == fread(&model->m_voltages, sizeof(model->m_voltages), 1, fp));
+		ok = ok && (1 == fread(&model->m_dieCapacitance, sizeof(model->m_dieCapacitance), 1, fp));
+
+		for(int j=0; (j<3) && ok; j++)
+			ok = CacheReadPoints(fp, model->m_pulldown[j].m_curve);
+		for(int j=0; (j<3) && ok; j++)
+			ok = CacheReadPoints(fp, model->m_pullup[j].m_curve);
+
+		uint32_t nwaves = 0;
+		ok = ok && (1 == fread(&nwaves, sizeof(nwaves), 1, fp)) && (nwaves <= IBIS_CACHE_MAX_LEN);
+		if(ok)
+			model->m_rising.resize(nwaves);
+		for(uint32_t j=0; ok && (j<nwaves); j++)
+			ok = CacheReadVTCurves(fp, model->m_rising[j]);
+
+		nwaves = 0;
+		ok = ok && (1 == fread(&nwaves, sizeof(nwaves), 1, fp)) && (nwaves <= IBIS_CACHE_MAX_LEN);
+		if(ok)
+			model->m_falling.resize(nwaves);
+		for(uint32_t j=0; ok && (j<nwaves); j++)
+			ok = CacheReadVTCurves(fp, model->m_falling[j]);
+	}
+
+	fclose(fp);
+
+	if(!ok)
+	{
+		LogWarning("Malformed IBIS cache file %s, re-parsing source\n", path.c_str());
+		Clear();
+		m_component = "";
+		m_manufacturer = "";
+		return false;
+	}
+
+	LogTrace("Loaded %zu IBIS models from cache file %s\n", m_models.size(), path.c_str());
+	return true;
+}
+
+/**
+	@brief Writes the parsed models out to a binary cache file alongside the source.
+
+	Failure is harmless (the directory may be read-only); we'll simply re-parse the text next time.
+ */
+bool IBISParser::SaveToCache(const string& path, time_t timestamp, int64_t fs)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+	{
+		LogTrace("Couldn't open IBIS cache file %s for writing\n", path.c_str());
+		return false;
+	}
+
+	IBISCacheHeader header;
+	header.magic = IBIS_CACHE_MAGIC;
+	header.version = IBIS_CACHE_VERSION;
+	header.file_mtime = timestamp;
+	header.file_fs = fs;
+
+	bool ok = (1 == fwrite(&header, sizeof(header), 1, fp));
+	ok = ok && CacheWriteString(fp, m_component);
+	ok = ok && CacheWriteString(fp, m_manufacturer);
+
+	uint32_t nmodels = m_models.size();
+	ok = ok && (1 == fwrite(&nmodels, sizeof(nmodels), 1, fp));
+
+	for(auto it : m_models)
+	{
+		if(!ok)
+			break;
+
+		auto model = it.second;
+		ok = CacheWriteString(fp, model->m_name);
+
+		uint32_t type = model->m_type;
+		ok = ok && (1 == fwrite(&type, sizeof(type), 1, fp));
+
+		ok = ok && (1 == fwrite(&model->m_vil, sizeof(model->m_vil), 1, fp));
+		ok = ok && (1 == fwrite(&model->m_vih, sizeof(model->m_vih), 1, fp));
+		ok = ok && (1 == fwrite(&model->m_temps, sizeof(model->m_temps), 1, fp));
+		ok = ok && (1 == fwrite(&model->m_voltages, sizeof(model->m_voltages), 1, fp));
+		ok = ok && (1 == fwrite(&model->m_dieCapacitance, sizeof(model->m_dieCapacitance), 1, fp));
+
+		for(int j=0; (j<3) && ok; j++)
+			ok = CacheWritePoints(fp, model->m_pulldown[j].m_curve);
+		for(int j=0; (j<3) && ok; j++)
+			ok = CacheWritePoints(fp, model->m_pullup[j].m_curve);
+
+		uint32_t nwaves = model->m_rising.size();
+		ok = ok && (1 == fwrite(&nwaves, sizeof(nwaves), 1, fp));
+		for(uint32_t j=0; ok && (j<nwaves); j++)
+			ok = CacheWriteVTCurves(fp, model->m_rising[j]);
+
+		nwaves = model->m_falling.size();
+		ok = ok && (1 == fwrite(&nwaves, sizeof(nwaves), 1, fp));
+		for(uint32_t j=0; ok && (j<nwaves); j++)
+			ok = CacheWriteVTCurves(fp, model->m_falling[j]);
+	}
+
+	fclose(fp);
+
+	//Don't leave a partial cache file behind if anything went wrong
+	if(!ok)
+	{
+		LogWarning("Failed to write IBIS cache file %s\n", path.c_str());
+		remove(path.c_str());
+		return false;
+	}
+
+	LogTrace("Saved %zu IBIS models to cache file %s\n", m_models.size(), path.c_str());
+	return true;
+}
@@ -194,6 +194,9 @@ public:
 
 protected:
 	float ParseNumber(const char* str);
+
+	bool LoadFromCache(const std::string& path, time_t expectedTimestamp, int64_t expectedFs);
+	bool SaveToCache(const std::string& path, time_t timestamp, int64_t fs);
 };
 
 #endif
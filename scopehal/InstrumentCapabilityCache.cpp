@@ -0,0 +1,285 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of InstrumentCapabilityCache
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "InstrumentCapabilityCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlwapi.h>
+#include <shlobj.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <fstream>
+
+using namespace std;
+
+unique_ptr<InstrumentCapabilityCache> g_instrumentCapabilityCache;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+InstrumentCapabilityCache::InstrumentCapabilityCache()
+	: m_addressCacheLoaded(false)
+{
+	FindPath();
+}
+
+void InstrumentCapabilityCache::FindPath()
+{
+#ifdef _WIN32
+	wchar_t* stem;
+	if(S_OK != SHGetKnownFolderPath(
+		FOLDERID_RoamingAppData,
+		KF_FLAG_CREATE,
+		NULL,
+		&stem))
+	{
+		throw std::runtime_error("failed to resolve %appdata%");
+	}
+
+	wchar_t directory[MAX_PATH];
+	if(NULL == PathCombineW(directory, stem, L"ngscopeclient"))
+	{
+		throw runtime_error("failed to build directory path");
+	}
+
+	// Ensure the directory exists
+	const auto result = CreateDirectoryW(directory, NULL);
+	m_cacheRootDir = NarrowPath(directory) + "\\";
+
+	if(!result && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		throw runtime_error("failed to create preferences directory");
+	}
+
+	CoTaskMemFree(static_cast<void*>(stem));
+#else
+	// Ensure all directories in path exist
+	CreateDirectory("~/.cache");
+	CreateDirectory("~/.cache/ngscopeclient");
+	m_cacheRootDir = ExpandPath("~/.cache/ngscopeclient") + "/";
+#endif
+
+	LogTrace("Capability cache root directory is %s\n", m_cacheRootDir.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual cache logic
+
+/**
+	@brief Builds the on-disk file name for a (model, firmware) pair
+
+	Model and firmware strings come straight off the instrument, so replace anything that isn't
+	filesystem safe.
+ */
+string InstrumentCapabilityCache::GetFileName(const string& model, const string& fwVersion)
+{
+	string key = model + "_" + fwVersion;
+	for(auto& c : key)
+	{
+		if(!isalnum(static_cast<unsigned char>(c)) && (c != '-') && (c != '.') )
+			c = '_';
+	}
+	return m_cacheRootDir + "caps_" + key + ".yml";
+}
+
+/**
+	@brief Looks up the capability map for a (model, firmware) pair
+
+	@param model		Model number of the instrument
+	@param fwVersion	Firmware version of the instrument
+	@param caps			Capability map, filled on a hit
+
+	@return True on a hit (from memory or disk)
+ */
+bool InstrumentCapabilityCache::Lookup(
+	const string& model,
+	const string& fwVersion,
+	map<string, string>& caps)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto fname = GetFileName(model, fwVersion);
+
+	//Check the in-memory copy first
+	auto it = m_cache.find(fname);
+	if(it != m_cache.end())
+	{
+		caps = it->second;
+		return true;
+	}
+
+	//Miss: try to load from disk
+	YAML::Node doc;
+	try
+	{
+		doc = YAML::LoadFile(fname);
+	}
+	catch(const YAML::Exception& e)
+	{
+		return false;
+	}
+	if(!doc || !doc["capabilities"])
+		return false;
+
+	caps.clear();
+	for(auto jt : doc["capabilities"])
+		caps[jt.first.as<string>()] = jt.second.as<string>();
+	m_cache[fname] = caps;
+
+	LogTrace("Loaded cached capabilities for %s (firmware %s)\n", model.c_str(), fwVersion.c_str());
+	return true;
+}
+
+/**
+	@brief Saves the capability map for a (model, firmware) pair to memory and disk
+ */
+void InstrumentCapabilityCache::Store(
+	const string& model,
+	const string& fwVersion,
+	const map<string, string>& caps)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto fname = GetFileName(model, fwVersion);
+	m_cache[fname] = caps;
+
+	YAML::Node doc;
+	doc["model"] = model;
+	doc["firmware"] = fwVersion;
+	YAML::Node cnode;
+	for(auto& it : caps)
+		cnode[it.first] = it.second;
+	doc["capabilities"] = cnode;
+
+	ofstream outfs(fname);
+	if(!outfs)
+	{
+		LogWarning("Couldn't write capability cache file %s\n", fname.c_str());
+		return;
+	}
+	outfs << YAML::Dump(doc);
+}
+
+/**
+	@brief Loads the per-address identity records from disk, if not already loaded
+
+	Caller must hold m_mutex.
+ */
+void InstrumentCapabilityCache::LoadAddressFile()
+{
+	if(m_addressCacheLoaded)
+		return;
+	m_addressCacheLoaded = true;
+
+	YAML::Node doc;
+	try
+	{
+		doc = YAML::LoadFile(m_cacheRootDir + "addresses.yml");
+	}
+	catch(const YAML::Exception& e)
+	{
+		return;
+	}
+	if(!doc || !doc["addresses"])
+		return;
+
+	for(auto it : doc["addresses"])
+		m_addressCache[it.first.as<string>()] = it.second.as<string>();
+}
+
+/**
+	@brief Looks up the last known *IDN? reply for a connection string
+
+	An unchanged reply on reconnect means the same instrument, running the same firmware, is still at that
+	address - so anything previously discovered about it is still valid.
+
+	@param address	Connection string of the transport
+	@param idn		Raw *IDN? reply from the last session, filled on a hit
+
+	@return True on a hit
+ */
+bool InstrumentCapabilityCache::LookupAddress(const string& address, string& idn)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	LoadAddressFile();
+
+	auto it = m_addressCache.find(address);
+	if(it == m_addressCache.end())
+		return false;
+	idn = it->second;
+	return true;
+}
+
+/**
+	@brief Saves the *IDN? reply for a connection string to memory and disk
+ */
+void InstrumentCapabilityCache::StoreAddress(const string& address, const string& idn)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	LoadAddressFile();
+	m_addressCache[address] = idn;
+
+	YAML::Node anode;
+	for(auto& it : m_addressCache)
+		anode[it.first] = it.second;
+	YAML::Node doc;
+	doc["addresses"] = anode;
+
+	auto fname = m_cacheRootDir + "addresses.yml";
+	ofstream outfs(fname);
+	if(!outfs)
+	{
+		LogWarning("Couldn't write capability cache file %s\n", fname.c_str());
+		return;
+	}
+	outfs << YAML::Dump(doc);
+}
+
+/**
+	@brief Removes all content from the in-memory cache (on-disk files are left alone)
+ */
+void InstrumentCapabilityCache::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_cache.clear();
+	m_addressCache.clear();
+	m_addressCacheLoaded = false;
+}
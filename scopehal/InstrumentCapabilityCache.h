@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of InstrumentCapabilityCache
+	@ingroup core
+ */
+#ifndef InstrumentCapabilityCache_h
+#define InstrumentCapabilityCache_h
+
+/**
+	@brief On-disk cache of probed instrument capabilities, keyed by (model, firmware version)
+
+	Many drivers spend most of their bring-up time on capability probing: option lists, channel counts,
+	bandwidth limits, and similar queries whose answers can't change without a firmware update. Caching
+	the probed values keyed by (model, firmware version) turns those round trips into a single file read
+	on reconnect, without risking staleness across firmware upgrades.
+
+	Each capability map is a flat string-to-string dictionary; drivers choose their own key names and value
+	encodings (typically the raw reply of the probe query). Stored under the same cache root as the shader
+	pipeline cache (.cache/ngscopeclient on Linux, local app data on Windows), one YAML file per
+	(model, firmware) pair.
+ */
+class InstrumentCapabilityCache
+{
+public:
+	InstrumentCapabilityCache();
+
+	bool Lookup(
+		const std::string& model,
+		const std::string& fwVersion,
+		std::map<std::string, std::string>& caps);
+
+	void Store(
+		const std::string& model,
+		const std::string& fwVersion,
+		const std::map<std::string, std::string>& caps);
+
+	bool LookupAddress(const std::string& address, std::string& idn);
+	void StoreAddress(const std::string& address, const std::string& idn);
+
+	void Clear();
+
+protected:
+	void FindPath();
+	std::string GetFileName(const std::string& model, const std::string& fwVersion);
+	void LoadAddressFile();
+
+	///@brief Mutex to interlock access to the STL containers
+	std::mutex m_mutex;
+
+	///@brief In-memory copy of the cache, keyed by sanitized (model, firmware) file name
+	std::map<std::string, std::map<std::string, std::string>> m_cache;
+
+	///@brief Last known *IDN? reply for each connection string, so reconnects can detect an unchanged instrument
+	std::map<std::string, std::string> m_addressCache;
+
+	///@brief True if the address records have been loaded from disk
+	bool m_addressCacheLoaded;
+
+	///@brief Root directory of the cache
+	std::string m_cacheRootDir;
+};
+
+extern std::unique_ptr<InstrumentCapabilityCache> g_instrumentCapabilityCache;
+
+#endif
@@ -53,6 +53,7 @@ InstrumentChannel::InstrumentChannel(
 	, m_displayname(hwname)
 	, m_index(index)
 	, m_xAxisUnit(xunit)
+	, m_residencyHint(RES_AUTO)
 {
 }
 
@@ -71,6 +72,7 @@ InstrumentChannel::InstrumentChannel(
 	, m_displayname(hwname)
 	, m_index(index)
 	, m_xAxisUnit(xunit)
+	, m_residencyHint(RES_AUTO)
 {
 	AddStream(yunit, "data", stype);
 }
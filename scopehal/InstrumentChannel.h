@@ -37,6 +37,7 @@
 #define InstrumentChannel_h
 
 #include "Stream.h"
+#include "ScalarStreamStats.h"
 
 class Instrument;
 
@@ -126,7 +127,7 @@ public:
 	// Stream management
 public:
 
-	void SetData(WaveformBase* pNew, size_t stream);
+	virtual void SetData(WaveformBase* pNew, size_t stream);
 
 	/**
 		@brief Returns the X axis unit for this channel
@@ -180,8 +181,8 @@ public:
 			return "";
 	}
 
-	///@brief Get the contents of a data stream
-	WaveformBase* GetData(size_t stream)
+	///@brief Get the contents of a data stream (virtual so filters can rehydrate spilled outputs on access)
+	virtual WaveformBase* GetData(size_t stream)
 	{
 		if(stream >= m_streams.size())
 			return nullptr;
@@ -210,6 +211,41 @@ public:
 		if(stream >= m_streams.size())
 			return;
 		m_streams[stream].m_value = value;
+
+		//Fold the reading into the streaming aggregator, if one has been enabled for this stream
+		if( (stream < m_scalarStats.size()) && m_scalarStats[stream])
+			m_scalarStats[stream]->AddSample(value);
+	}
+
+	/**
+		@brief Enables streaming statistics aggregation for a scalar data stream
+
+		Once enabled, every value pushed through SetScalarValue() is folded into a ScalarStreamStats
+		instance (running min/max/mean, histogram, windowed queries, recent-sample retention), so
+		long-duration telemetry such as PSU current draw can be summarized without retaining and
+		rescanning the full series.
+
+		@param stream	Index of the stream to aggregate
+
+		@return The aggregator for the stream (created if necessary), or nullptr if the stream does not exist
+	 */
+	ScalarStreamStats* EnableScalarStats(size_t stream)
+	{
+		if(stream >= m_streams.size())
+			return nullptr;
+		if(m_scalarStats.size() < m_streams.size())
+			m_scalarStats.resize(m_streams.size());
+		if(!m_scalarStats[stream])
+			m_scalarStats[stream] = std::make_unique<ScalarStreamStats>();
+		return m_scalarStats[stream].get();
+	}
+
+	///@brief Returns the streaming statistics aggregator for a scalar stream, or nullptr if not enabled
+	ScalarStreamStats* GetScalarStats(size_t stream)
+	{
+		if(stream >= m_scalarStats.size())
+			return nullptr;
+		return m_scalarStats[stream].get();
 	}
 
 	/**
@@ -224,6 +260,30 @@ public:
 		return tmp;
 	}
 
+	/**
+		@brief Memory residency policy for this channel's output waveforms
+
+		RES_AUTO (the default) lets the filter graph executor infer placement from the GetInputLocation()
+		declarations of downstream consumers, moving each output to where it will be read as soon as the channel
+		finishes refreshing. The explicit policies force the output to be made readable from the CPU, the GPU,
+		or both, regardless of what consumers declare.
+	 */
+	enum ResidencyHint
+	{
+		RES_AUTO,
+		RES_CPU_ONLY,
+		RES_GPU_ONLY,
+		RES_MIRRORED
+	};
+
+	///@brief Sets the residency policy for this channel's output waveforms
+	void SetResidencyHint(ResidencyHint hint)
+	{ m_residencyHint = hint; }
+
+	///@brief Returns the residency policy for this channel's output waveforms
+	ResidencyHint GetResidencyHint()
+	{ return m_residencyHint; }
+
 	/**
 		@brief Determine whether the channel's waveform(s) should be persisted to a session file
 	 */
@@ -303,6 +363,17 @@ protected:
 		@brief Configuration data for each of our output streams
 	 */
 	std::vector<Stream> m_streams;
+
+	/**
+		@brief Streaming statistics aggregators for scalar streams (entries null unless enabled)
+
+		Indexed parallel to m_streams, but only resized on first enable so channels that never
+		aggregate pay nothing.
+	 */
+	std::vector<std::unique_ptr<ScalarStreamStats>> m_scalarStats;
+
+	///@brief Memory residency policy for our output waveforms
+	ResidencyHint m_residencyHint;
 };
 
 #endif
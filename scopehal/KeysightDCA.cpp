@@ -431,12 +431,14 @@ Oscilloscope::TriggerMode KeysightDCA::PollTrigger()
 	}
 }
 
-vector<int8_t> KeysightDCA::GetWaveformData(string channel)
+void KeysightDCA::RequestWaveformData(string channel)
 {
-	lock_guard<recursive_mutex> lock(m_mutex);
 	m_transport->SendCommand(":WAV:SOUR " + channel);
 	m_transport->SendCommand(":WAV:DATA?");
+}
 
+vector<int8_t> KeysightDCA::ReadWaveformDataReply()
+{
 	// Read the length header size
 	char tmp[16] = {0};
 	m_transport->ReadRawData(2, (unsigned char*)tmp);
@@ -456,13 +458,23 @@ vector<int8_t> KeysightDCA::GetWaveformData(string channel)
 	return buf;
 }
 
-KeysightDCA::WaveformPreamble KeysightDCA::GetWaveformPreamble(string channel)
+vector<int8_t> KeysightDCA::GetWaveformData(string channel)
 {
-	WaveformPreamble ret;
-
 	lock_guard<recursive_mutex> lock(m_mutex);
+	RequestWaveformData(channel);
+	return ReadWaveformDataReply();
+}
+
+void KeysightDCA::RequestWaveformPreamble(string channel)
+{
 	m_transport->SendCommand(":WAV:SOUR " + channel);
 	m_transport->SendCommand(":WAV:PRE?");
+}
+
+KeysightDCA::WaveformPreamble KeysightDCA::ReadWaveformPreambleReply()
+{
+	WaveformPreamble ret;
+
 	string reply = m_transport->ReadReply();
 	sscanf(reply.c_str(), "%u,%u,%zu,%u,%lf,%lf,%lf,%lf,%lf,%lf",
 			&ret.format, &ret.type, &ret.length, &ret.average_count,
@@ -472,31 +484,63 @@ KeysightDCA::WaveformPreamble KeysightDCA::GetWaveformPreamble(string channel)
 	return ret;
 }
 
+KeysightDCA::WaveformPreamble KeysightDCA::GetWaveformPreamble(string channel)
+{
+	lock_guard<recursive_mutex> lock(m_mutex);
+	RequestWaveformPreamble(channel);
+	return ReadWaveformPreambleReply();
+}
+
 bool KeysightDCA::AcquireData()
 {
 	lock_guard<recursive_mutex> lock(m_mutex);
 	LogIndenter li;
 
-	map<int, vector<WaveformBase*> > pending_waveforms;
+	//Sampling scope records are small, so round trips dominate. Pipeline the readback: request every
+	//enabled channel's preamble before reading the first reply, then do the same for the waveform bodies,
+	//so the instrument is serializing channel k+1 while we're pulling channel k off the wire. The transfer
+	//format was negotiated once at connect (ConfigureWaveform), not re-sent per acquisition.
+	vector<size_t> chans;
 	for(size_t i=0; i < m_analogChannelCount; i++)
 	{
-		if(!IsChannelEnabled(i))
-			continue;
+		if(IsChannelEnabled(i))
+			chans.push_back(i);
+	}
 
-		auto chname = GetOscilloscopeChannel(i)->GetHwname();
-		auto preamble = GetWaveformPreamble(chname);
+	for(auto i : chans)
+		RequestWaveformPreamble(GetOscilloscopeChannel(i)->GetHwname());
+	vector<WaveformPreamble> preambles;
+	for(size_t n=0; n < chans.size(); n++)
+		preambles.push_back(ReadWaveformPreambleReply());
+
+	for(auto i : chans)
+		RequestWaveformData(GetOscilloscopeChannel(i)->GetHwname());
+	vector<vector<int8_t>> bufs;
+	for(size_t n=0; n < chans.size(); n++)
+		bufs.push_back(ReadWaveformDataReply());
+
+	double t = GetTime();
+	time_t tstamp = time(NULL);
+
+	//Parse everything off the wire, all channels in parallel
+	map<int, vector<WaveformBase*> > pending_waveforms;
+	vector<UniformAnalogWaveform*> caps(chans.size(), nullptr);
+
+	#pragma omp parallel for
+	for(size_t n=0; n < chans.size(); n++)
+	{
+		auto& preamble = preambles[n];
+		auto& buf = bufs[n];
 
 		int64_t fs_per_sample = round(preamble.xincrement * FS_PER_SECOND);
 
 		auto cap = new UniformAnalogWaveform;
 		cap->m_timescale = fs_per_sample;
 		cap->m_triggerPhase = 0;
-		cap->m_startTimestamp = time(NULL);
-		double t = GetTime();
+		cap->m_startTimestamp = tstamp;
 		cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
 		cap->PrepareForCpuAccess();
 
-		auto buf = GetWaveformData(chname);
 		if(preamble.length != buf.size())
 			LogError("Waveform preamble length (%zu) does not match data length (%zu)", preamble.length, buf.size());
 		cap->Resize(buf.size());
@@ -514,9 +558,12 @@ bool KeysightDCA::AcquireData()
 		}
 
 		cap->MarkSamplesModifiedFromCpu();
-		pending_waveforms[i].push_back(cap);
+		caps[n] = cap;
 	}
 
+	for(size_t n=0; n < chans.size(); n++)
+		pending_waveforms[chans[n]].push_back(caps[n]);
+
 	//Now that we have all of the pending waveforms, save them in sets across all channels
 	m_pendingWaveformsMutex.lock();
 	size_t num_pending = 1;
@@ -526,7 +573,7 @@ bool KeysightDCA::AcquireData()
 		for (size_t j = 0; j < m_channels.size(); j++)
 			if(IsChannelEnabled(j) && pending_waveforms.find(j) != pending_waveforms.end())
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
@@ -147,6 +147,10 @@ private:
 	bool IsModulePresent(std::string name);
 	std::vector<int8_t> GetWaveformData(std::string channel);
 	WaveformPreamble GetWaveformPreamble(std::string channel);
+	void RequestWaveformData(std::string channel);
+	std::vector<int8_t> ReadWaveformDataReply();
+	void RequestWaveformPreamble(std::string channel);
+	WaveformPreamble ReadWaveformPreambleReply();
 	void SetSampleRateAndDepth(uint64_t rate, uint64_t depth);
 
 
@@ -0,0 +1,209 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of LatencyTracer
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "LatencyTracer.h"
+
+using namespace std;
+
+///@brief Maximum number of events retained before recording stops (roughly 100 MB of event storage)
+static const size_t MAX_TRACE_EVENTS = 1000000;
+
+///@brief Trace context (capture sequence number) of the current thread
+static thread_local int64_t t_currentCapture = 0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+LatencyTracer& LatencyTracer::GetInstance()
+{
+	static LatencyTracer tracer;
+	return tracer;
+}
+
+LatencyTracer::LatencyTracer()
+	: m_enabled(false)
+	, m_nextCapture(0)
+	, m_epoch(GetTime())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Trace context management
+
+/**
+	@brief Allocates a new capture sequence number and makes it the calling thread's trace context
+
+	Called by a driver's AcquireData() as it starts pulling a new acquisition off the wire, so all spans
+	recorded while processing it share one capture ID. Returns 0 without consuming a sequence number when
+	tracing is disabled, keeping the hot path cost to one atomic load.
+ */
+int64_t LatencyTracer::BeginCapture()
+{
+	if(!IsEnabled())
+		return 0;
+
+	int64_t capture = ++m_nextCapture;
+	t_currentCapture = capture;
+	return capture;
+}
+
+///@brief Makes an existing capture sequence number the calling thread's trace context (0 to detach)
+void LatencyTracer::SetCurrentCapture(int64_t capture)
+{
+	t_currentCapture = capture;
+}
+
+///@brief Returns the calling thread's trace context (0 if none)
+int64_t LatencyTracer::GetCurrentCapture()
+{
+	return t_currentCapture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Event recording
+
+/**
+	@brief Records a completed span
+
+	@param category	Pipeline stage the span belongs to ("trigger", "driver", "queue", "graph", ...)
+	@param name		Human readable name of the span
+	@param tstart	GetTime() value when the span started
+	@param tend		GetTime() value when the span ended
+ */
+void LatencyTracer::RecordSpan(const string& category, const string& name, double tstart, double tend)
+{
+	if(!IsEnabled())
+		return;
+	Record(category, name, tstart, tend - tstart);
+}
+
+/**
+	@brief Records an instantaneous event at the current time
+
+	@param category	Pipeline stage the event belongs to
+	@param name		Human readable name of the event
+ */
+void LatencyTracer::RecordInstant(const string& category, const string& name)
+{
+	if(!IsEnabled())
+		return;
+	Record(category, name, GetTime(), -1);
+}
+
+void LatencyTracer::Record(const string& category, const string& name, double tstart, double duration)
+{
+	//Small consecutive thread IDs so the trace viewer gets one stable row per thread
+	static atomic<uint64_t> g_nextThreadId{0};
+	static thread_local uint64_t t_threadId = ++g_nextThreadId;
+
+	TraceEvent ev;
+	ev.m_category = category;
+	ev.m_name = name;
+	ev.m_start = tstart - m_epoch;
+	ev.m_duration = duration;
+	ev.m_capture = t_currentCapture;
+	ev.m_thread = t_threadId;
+
+	lock_guard<mutex> lock(m_mutex);
+
+	//Bound memory consumption if someone leaves tracing on indefinitely
+	if(m_events.size() >= MAX_TRACE_EVENTS)
+		return;
+	m_events.push_back(move(ev));
+}
+
+///@brief Discards all recorded events (but keeps the capture sequence running, so IDs stay unique)
+void LatencyTracer::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_events.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Export
+
+/**
+	@brief Exports all recorded events as Chrome trace JSON
+
+	Load the result in chrome://tracing or Perfetto to get a waterfall of the acquisition-to-display
+	pipeline; each event's capture sequence number is in its args, so one trigger's journey through the
+	driver, queue, and graph layers can be followed across threads.
+ */
+string LatencyTracer::GetChromeTrace()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	string json = "{\"traceEvents\":[";
+	bool first = true;
+	for(auto& ev : m_events)
+	{
+		string name = str_replace("\\", "\\\\", ev.m_name);
+		name = str_replace("\"", "\\\"", name);
+
+		//Times are in microseconds in the trace format
+		char tmp[512];
+		if(ev.m_duration >= 0)
+		{
+			snprintf(tmp, sizeof(tmp),
+				"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,"
+				"\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"capture\":%lld}}",
+				first ? "" : ",",
+				name.c_str(),
+				ev.m_category.c_str(),
+				static_cast<unsigned long long>(ev.m_thread),
+				ev.m_start * 1e6,
+				ev.m_duration * 1e6,
+				static_cast<long long>(ev.m_capture));
+		}
+		else
+		{
+			snprintf(tmp, sizeof(tmp),
+				"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%llu,"
+				"\"ts\":%.3f,\"args\":{\"capture\":%lld}}",
+				first ? "" : ",",
+				name.c_str(),
+				ev.m_category.c_str(),
+				static_cast<unsigned long long>(ev.m_thread),
+				ev.m_start * 1e6,
+				static_cast<long long>(ev.m_capture));
+		}
+		json += tmp;
+		first = false;
+	}
+	json += "]}";
+	return json;
+}
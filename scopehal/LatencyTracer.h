@@ -0,0 +1,171 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of LatencyTracer
+	@ingroup core
+ */
+
+#ifndef LatencyTracer_h
+#define LatencyTracer_h
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ScopehalUtil.h"
+
+/**
+	@brief Records timestamped stage spans across the acquisition-to-display pipeline for latency attribution
+
+	Answers questions like "why did this trigger take 340 ms to appear" without ad hoc printfs: drivers,
+	transports, the graph scheduler, and filters record spans and instants against a shared wall clock, and
+	GetChromeTrace() exports everything as Chrome trace JSON (viewable as a waterfall in chrome://tracing or
+	Perfetto, one row per thread).
+
+	Events are correlated by a capture sequence number (the trace context): a driver's AcquireData() calls
+	BeginCapture() to allocate one, which then rides along in a thread-local so every event recorded on that
+	thread is tagged with it until the next BeginCapture(). Code running on a different thread on behalf of
+	the same capture (e.g. the graph evaluation after the client pops the pending waveform queue) calls
+	SetCurrentCapture() to pick the context back up.
+
+	Tracing is off by default; when disabled, instrumentation costs a single relaxed atomic load per event.
+	The event buffer is bounded, so a tracer left enabled indefinitely stops recording rather than eating
+	unbounded memory; Clear() after exporting to keep a long session going.
+
+	@ingroup core
+ */
+class LatencyTracer
+{
+public:
+	static LatencyTracer& GetInstance();
+
+	///@brief Enables or disables trace collection
+	void SetEnabled(bool enabled)
+	{ m_enabled.store(enabled, std::memory_order_relaxed); }
+
+	///@brief Returns true if trace collection is active
+	bool IsEnabled() const
+	{ return m_enabled.load(std::memory_order_relaxed); }
+
+	int64_t BeginCapture();
+	static void SetCurrentCapture(int64_t capture);
+	static int64_t GetCurrentCapture();
+
+	void RecordSpan(const std::string& category, const std::string& name, double tstart, double tend);
+	void RecordInstant(const std::string& category, const std::string& name);
+
+	std::string GetChromeTrace();
+	void Clear();
+
+protected:
+	LatencyTracer();
+
+	///@brief A single completed span or instant event
+	struct TraceEvent
+	{
+		///@brief Category of the pipeline stage ("trigger", "driver", "queue", "graph", ...)
+		std::string m_category;
+
+		///@brief Human readable name of the event
+		std::string m_name;
+
+		///@brief Start time, in seconds since the tracer epoch
+		double m_start;
+
+		///@brief Duration in seconds (negative for an instant event)
+		double m_duration;
+
+		///@brief Capture sequence number the event is attributed to (0 = not tied to a specific capture)
+		int64_t m_capture;
+
+		///@brief Small integer ID of the recording thread
+		uint64_t m_thread;
+	};
+
+	void Record(const std::string& category, const std::string& name, double tstart, double duration);
+
+	///@brief True if trace collection is active
+	std::atomic<bool> m_enabled;
+
+	///@brief Most recently allocated capture sequence number
+	std::atomic<int64_t> m_nextCapture;
+
+	///@brief GetTime() value when the tracer was created; event timestamps are relative to this
+	double m_epoch;
+
+	///@brief Mutex protecting m_events
+	std::mutex m_mutex;
+
+	///@brief Completed events, in recording order per thread
+	std::vector<TraceEvent> m_events;
+};
+
+/**
+	@brief RAII helper recording a LatencyTracer span over its own lifetime
+	@ingroup core
+ */
+class LatencyTracerSpan
+{
+public:
+	LatencyTracerSpan(const std::string& category, const std::string& name)
+		: m_active(LatencyTracer::GetInstance().IsEnabled())
+	{
+		if(m_active)
+		{
+			m_category = category;
+			m_name = name;
+			m_tstart = GetTime();
+		}
+	}
+
+	~LatencyTracerSpan()
+	{
+		if(m_active)
+			LatencyTracer::GetInstance().RecordSpan(m_category, m_name, m_tstart, GetTime());
+	}
+
+protected:
+	///@brief True if tracing was enabled when the span was opened
+	bool m_active;
+
+	///@brief Category of the span
+	std::string m_category;
+
+	///@brief Name of the span
+	std::string m_name;
+
+	///@brief Wall clock time the span was opened
+	double m_tstart;
+};
+
+#endif
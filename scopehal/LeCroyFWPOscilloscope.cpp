@@ -281,7 +281,7 @@ bool LeCroyFWPOscilloscope::AcquireData()
 			if(pending_waveforms.find(j) != pending_waveforms.end())
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j];
 		}
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	m_pendingWaveformsMutex.unlock();
 
 	return true;
@@ -87,6 +87,9 @@ LeCroyOscilloscope::LeCroyOscilloscope(SCPITransport* transport)
 	, m_meterMode(Multimeter::DC_VOLTAGE)
 	, m_meterModeValid(false)
 	, m_highDefinition(false)
+	, m_transferFormat(FORMAT_BYTE)
+	, m_transferIsWord(false)
+	, m_sampleConverter("LeCroyOscilloscope")
 {
 	//standard initialization
 	FlushConfigCache();
@@ -135,7 +138,10 @@ void LeCroyOscilloscope::SharedCtorInit()
 
 	//Desired format for waveform data
 	//Only use increased bit depth if the scope actually puts content there!
-	if(m_highDefinition)
+	//SetTransferFormat(FORMAT_AUTO) opts into adaptive 8-bit transfers on HD scopes.
+	m_transferFormat = m_highDefinition ? FORMAT_WORD : FORMAT_BYTE;
+	m_transferIsWord = m_highDefinition;
+	if(m_transferIsWord)
 		m_transport->SendCommandQueued("COMM_FORMAT DEF9,WORD,BIN");
 	else
 		m_transport->SendCommandQueued("COMM_FORMAT DEF9,BYTE,BIN");
@@ -281,7 +287,24 @@ void LeCroyOscilloscope::DetectOptions()
 {
 	LogDebug("\n");
 
-	auto reply = m_transport->SendCommandQueuedWithReply("*OPT?");
+	//Check the on-disk capability cache before spending a round trip on the query
+	//(the option list can't change without a firmware update)
+	string reply;
+	map<string, string> caps;
+	bool cached = g_instrumentCapabilityCache &&
+		g_instrumentCapabilityCache->Lookup(m_model, m_fwVersion, caps) &&
+		caps.count("opt");
+	if(cached)
+		reply = caps["opt"];
+	else
+	{
+		reply = m_transport->SendCommandQueuedWithReply("*OPT?");
+		if(g_instrumentCapabilityCache)
+		{
+			caps["opt"] = reply.c_str();	//truncate at the null some firmwares append
+			g_instrumentCapabilityCache->Store(m_model, m_fwVersion, caps);
+		}
+	}
 	if(reply.length() > 3)
 	{
 		//Read options until we hit a null
@@ -1080,6 +1103,67 @@ void LeCroyOscilloscope::FlushConfigCache()
 	}
 }
 
+/**
+	@brief Snapshots channel and trigger state in a single round trip
+
+	MAUI executes semicolon-separated commands within one program message in order, and returns the replies
+	semicolon-separated in one response message. We exploit this to query the enable state, gain, and offset of
+	every analog channel (plus the trigger delay) as a single exchange, instead of the three round trips per
+	channel the lazy per-attribute getters would cost. Over a high-latency link this turns connect-time sync
+	from tens of seconds into roughly one RTT.
+
+	Digital channels and other VBS-backed settings are not prefetched, since VBS queries cannot be batched
+	this way; those still populate lazily.
+ */
+void LeCroyOscilloscope::PrefetchConfigCache()
+{
+	//Build the batched query
+	string cmd;
+	for(size_t i=0; i<m_analogChannelCount; i++)
+	{
+		auto hwname = GetOscilloscopeChannel(i)->GetHwname();
+		cmd += hwname + ":TRACE?;" + hwname + ":VOLT_DIV?;" + hwname + ":OFFSET?;";
+	}
+	cmd += "TRDL?";
+
+	//Read the combined response (do NOT stop at the first semicolon, we want all of the fields)
+	auto reply = m_transport->SendCommandQueuedWithReply(cmd, false);
+	auto fields = explode(reply, ';');
+	if(fields.size() < (m_analogChannelCount*3 + 1))
+	{
+		LogWarning("PrefetchConfigCache: expected %zu reply fields, got %zu (malformed response?)\n",
+			m_analogChannelCount*3 + 1, fields.size());
+		return;
+	}
+
+	//Trigger offset conversion needs the timebase config (these are served from cache when valid)
+	int64_t rate = GetSampleRate();
+	int64_t halfdepth = GetSampleDepth() / 2;
+
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+
+	for(size_t i=0; i<m_analogChannelCount; i++)
+	{
+		auto enable = Trim(fields[i*3 + 0]);
+		m_channelsEnabled[i] = (enable.find("OFF") != 0);
+
+		double volts_per_div;
+		sscanf(fields[i*3 + 1].c_str(), "%lf", &volts_per_div);
+		m_channelVoltageRanges[i] = volts_per_div * 8;	//plot is 8 divisions high on all MAUI scopes
+
+		float offset;
+		sscanf(fields[i*3 + 2].c_str(), "%f", &offset);
+		m_channelOffsets[i] = offset;
+	}
+
+	//Convert trigger delay from midpoint-referenced to start-referenced (see GetTriggerOffset)
+	double sec;
+	sscanf(fields[m_analogChannelCount*3].c_str(), "%le", &sec);
+	m_triggerOffset = static_cast<int64_t>(round(sec * FS_PER_SECOND));
+	m_triggerOffset += static_cast<int64_t>(round(FS_PER_SECOND * halfdepth / rate));
+	m_triggerOffsetValid = true;
+}
+
 /**
 	@brief See what measurement capabilities we have
  */
@@ -2307,6 +2391,44 @@ bool LeCroyOscilloscope::PeekTriggerArmed()
 	}
 }
 
+/**
+	@brief Opens additional connections to the scope so waveform downloads can be striped across them.
+
+	The scope accepts multiple concurrent sessions; instrument configuration (COMM_FORMAT etc) is global so the
+	extra connections are used only to issue WF? queries and read the responses. The primary connection counts
+	towards numConnections, so numConnections=4 opens three extra sessions.
+
+	@param numConnections	Total number of connections to download over
+
+	@return True on success, false if the extra connections could not be opened
+ */
+bool LeCroyOscilloscope::EnableParallelWaveformDownload(size_t numConnections)
+{
+	DisableParallelWaveformDownload();
+
+	for(size_t i=1; i<numConnections; i++)
+	{
+		auto transport = SCPITransport::CreateTransport(m_transport->GetName(), m_transport->GetConnectionString());
+		if( (transport == nullptr) || !transport->IsConnected() )
+		{
+			LogWarning("Failed to open secondary connection %zu to %s, parallel download disabled\n",
+				i, m_transport->GetConnectionString().c_str());
+			delete transport;
+			DisableParallelWaveformDownload();
+			return false;
+		}
+		m_downloadTransports.push_back(unique_ptr<SCPITransport>(transport));
+	}
+
+	return true;
+}
+
+///@brief Closes any secondary download connections and reverts to serial downloads on the primary connection
+void LeCroyOscilloscope::DisableParallelWaveformDownload()
+{
+	m_downloadTransports.clear();
+}
+
 bool LeCroyOscilloscope::ReadWaveformBlock(string& data)
 {
 	//Prefix "DESC,\n" or "DAT1,\n". Always seems to be 6 chars and start with a D.
@@ -2448,8 +2570,14 @@ bool LeCroyOscilloscope::ReadWavedescs(
 
 void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled)
 {
+	//If parallel download is enabled, enabled channels are striped round-robin across connections and we only
+	//request the ones assigned to the primary connection here. The secondary connections request their own
+	//channels in DownloadWaveformsOnSecondaryTransport().
+	size_t nconn = m_downloadTransports.size() + 1;
+
 	//Ask for all analog waveforms
 	bool sent_wavetime = false;
+	size_t idx = 0;
 	for(unsigned int i=0; i<m_analogChannelCount; i++)
 	{
 		if(enabled[i])
@@ -2462,7 +2590,9 @@ void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences,
 			}
 
 			//Ask for the data
-			m_transport->SendCommandQueued(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
+			if( (idx % nconn) == 0)
+				m_transport->SendCommandQueued(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
+			idx ++;
 		}
 	}
 
@@ -2471,6 +2601,46 @@ void LeCroyOscilloscope::RequestWaveforms(bool* enabled, uint32_t num_sequences,
 		m_transport->SendCommandQueued("Digital1:WF?");
 }
 
+/**
+	@brief Requests and reads the analog waveforms assigned to one secondary connection.
+
+	Channel assignment must match the round-robin striping used by RequestWaveforms() and AcquireData().
+ */
+void LeCroyOscilloscope::DownloadWaveformsOnSecondaryTransport(
+	size_t conn,
+	size_t nconn,
+	const bool* enabled,
+	map<int, string>& analogWaveformData,
+	mutex& dataMutex)
+{
+	auto transport = m_downloadTransports[conn-1].get();
+
+	//Figure out which channels are ours
+	vector<unsigned int> ours;
+	size_t idx = 0;
+	for(unsigned int i=0; i<m_analogChannelCount; i++)
+	{
+		if(enabled[i])
+		{
+			if( (idx++ % nconn) == conn)
+				ours.push_back(i);
+		}
+	}
+
+	//Request everything up front so the scope can pipeline, then read the replies in order
+	for(auto i : ours)
+		transport->SendCommandImmediate(GetOscilloscopeChannel(i)->GetHwname() + ":WF? DAT1");
+	for(auto i : ours)
+	{
+		auto data = transport->ReadReply(false);
+		{
+			lock_guard<mutex> lock(dataMutex);
+			analogWaveformData[i] = std::move(data);
+		}
+		ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
+	}
+}
+
 time_t LeCroyOscilloscope::ExtractTimestamp(unsigned char* wavedesc, double& basetime)
 {
 	/*
@@ -2554,9 +2724,15 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	if(h_off_frac < 0)
 		h_off_frac = interval + h_off_frac;		//double h_unit = *reinterpret_cast<double*>(pdesc + 244);
 
+	//Wire format of this particular waveform (COMM_TYPE field: 0 = byte, 1 = word).
+	//Use the descriptor rather than our cached COMM_FORMAT state, so adaptive format renegotiation can
+	//never desync parsing from the data.
+	//cppcheck-suppress invalidPointerCast
+	bool wordSamples = (*reinterpret_cast<uint16_t*>(pdesc + 32) != 0);
+
 	//Raw waveform data
 	size_t num_samples;
-	if(m_highDefinition)
+	if(wordSamples)
 		num_samples = datalen/2;
 	else
 		num_samples = datalen;
@@ -2581,27 +2757,37 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 
 		cap->Resize(num_per_segment);
 
-		//Convert raw ADC samples to volts
-		if(m_highDefinition)
+		//Convert raw ADC samples to volts, on the GPU when possible (the converter falls back to the
+		//vectorized CPU loops itself if the GPU can't do it)
+		if(wordSamples)
 		{
-			Convert16BitSamples(
-				cap->m_samples.GetCpuPointer(),
-				wdata + j*num_per_segment,
+			m_rawSamples16.resize(num_per_segment);
+			m_rawSamples16.PrepareForCpuAccess();
+			memcpy(m_rawSamples16.GetCpuPointer(), wdata + j*num_per_segment, num_per_segment * sizeof(int16_t));
+			m_rawSamples16.MarkModifiedFromCpu();
+
+			m_sampleConverter.Convert16BitSamples(
+				cap->m_samples,
+				m_rawSamples16,
 				v_gain,
 				v_off,
 				num_per_segment);
 		}
 		else
 		{
-			Convert8BitSamples(
-				cap->m_samples.GetCpuPointer(),
-				bdata + j*num_per_segment,
+			m_rawSamples8.resize(num_per_segment);
+			m_rawSamples8.PrepareForCpuAccess();
+			memcpy(m_rawSamples8.GetCpuPointer(), bdata + j*num_per_segment, num_per_segment * sizeof(int8_t));
+			m_rawSamples8.MarkModifiedFromCpu();
+
+			m_sampleConverter.Convert8BitSamples(
+				cap->m_samples,
+				m_rawSamples8,
 				v_gain,
 				v_off,
 				num_per_segment);
 		}
 
-		cap->MarkSamplesModifiedFromCpu();
 		ret.push_back(cap);
 	}
 
@@ -2789,6 +2975,10 @@ bool LeCroyOscilloscope::AcquireData()
 	{
 		lock_guard<recursive_mutex> lock2(m_transport->GetMutex());
 
+		//Renegotiate the transfer format if the adaptive policy calls for a change. Do this before grabbing
+		//the wavedescs so the descriptors and the sample data for this acquisition agree on the format.
+		UpdateTransferFormat();
+
 		//Get the wavedescs for all channels
 		unsigned int firstEnabledChannel = UINT_MAX;
 		bool any_enabled = true;
@@ -2852,6 +3042,16 @@ bool LeCroyOscilloscope::AcquireData()
 
 		//Ask for every enabled channel up front, so the scope can send us the next while we parse the first
 		RequestWaveforms(enabled, num_sequences, denabled);
+
+		//If double buffered acquisition is enabled, queue the re-arm behind the waveform queries.
+		//The scope serializes the replies to those queries before executing the re-arm, so the data we're
+		//about to download has already been snapshotted and the next acquisition overlaps the transfer.
+		if(m_rearmBeforeDownload && !m_triggerOneShot)
+		{
+			m_transport->SendCommandQueued("TRIG_MODE SINGLE");
+			m_triggerArmed = true;
+		}
+
 		m_transport->FlushCommandQueue();
 
 		if(pdesc)
@@ -2873,17 +3073,40 @@ bool LeCroyOscilloscope::AcquireData()
 				basetime = t - ttime;
 			}
 
-			//Read the data from each analog waveform
+			//Kick off downloads on the secondary connections, if parallel download is enabled
+			size_t nconn = m_downloadTransports.size() + 1;
+			mutex dataMutex;
+			vector<thread> downloadThreads;
+			for(size_t c=1; c<nconn; c++)
+			{
+				downloadThreads.emplace_back(
+					[this, c, nconn, &enabled, &analogWaveformData, &dataMutex]
+					{ DownloadWaveformsOnSecondaryTransport(c, nconn, enabled, analogWaveformData, dataMutex); });
+			}
+
+			//Read the data for each analog waveform assigned to the primary connection
+			size_t idx = 0;
 			for(unsigned int i=0; i<m_analogChannelCount; i++)
 			{
 				if(enabled[i])
 				{
-					analogWaveformData[i] = m_transport->ReadReply(
+					if( (idx++ % nconn) != 0)
+						continue;
+
+					auto data = m_transport->ReadReply(
 						false,
 						[i, this] (float progress) { ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, progress); });
+					{
+						lock_guard<mutex> dlock(dataMutex);
+						analogWaveformData[i] = std::move(data);
+					}
 					ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
 				}
 			}
+
+			//Wait for the secondary connections to finish
+			for(auto& t : downloadThreads)
+				t.join();
 		}
 
 		//Read the data from the digital waveforms, if enabled
@@ -2898,8 +3121,8 @@ bool LeCroyOscilloscope::AcquireData()
 	}
 
 	//At this point all data has been read so the scope is free to go do its thing while we crunch the results.
-	//Re-arm the trigger if not in one-shot mode
-	if(!m_triggerOneShot)
+	//Re-arm the trigger if not in one-shot mode (and not already re-armed before the download)
+	if(!m_triggerOneShot && !m_rearmBeforeDownload)
 	{
 		m_transport->SendCommandQueued("TRIG_MODE SINGLE");
 		m_transport->FlushCommandQueue();
@@ -2977,7 +3200,7 @@ bool LeCroyOscilloscope::AcquireData()
 			if(pending_waveforms.find(j) != pending_waveforms.end())
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
@@ -3660,6 +3883,13 @@ void LeCroyOscilloscope::EnableTriggerOutput()
 	}
 }
 
+bool LeCroyOscilloscope::CanRearmBeforeDownload()
+{
+	//AcquireData() queues every waveform query up front and the scope serializes the replies in order,
+	//so the acquisition memory is snapshotted before a queued re-arm command can execute.
+	return true;
+}
+
 void LeCroyOscilloscope::SetUseExternalRefclk(bool external)
 {
 	if(external)
@@ -5555,9 +5785,82 @@ void LeCroyOscilloscope::ForceHDMode(bool mode)
 {
 	m_highDefinition = mode;
 
-	if(m_highDefinition)
+	//Reset the transfer format policy to match the new resolution
+	m_transferFormat = m_highDefinition ? FORMAT_WORD : FORMAT_BYTE;
+	m_transferIsWord = m_highDefinition;
+
+	if(m_transferIsWord)
 		m_transport->SendCommandQueued("COMM_FORMAT DEF9,WORD,BIN");
 	else
 		m_transport->SendCommandQueued("COMM_FORMAT DEF9,BYTE,BIN");
 
 }
+
+/**
+	@brief Renegotiates the wire format for waveform downloads if the current policy calls for a change
+
+	COMM_FORMAT is global to the instrument, so in FORMAT_AUTO mode we only drop to 8-bit transfers (halving
+	wire time on bandwidth-limited links) when every enabled analog channel can tolerate it, per the
+	SetChannelTransferFormat() overrides and the gain heuristic in Is8BitTransferAcceptable().
+
+	Called at the start of every acquisition; only touches the wire when the desired format actually changes.
+ */
+void LeCroyOscilloscope::UpdateTransferFormat()
+{
+	bool wantWord;
+	switch(m_transferFormat)
+	{
+		case FORMAT_BYTE:
+			wantWord = false;
+			break;
+
+		case FORMAT_WORD:
+			wantWord = true;
+			break;
+
+		case FORMAT_AUTO:
+		default:
+			//Non-HD scopes never put content in the low byte
+			wantWord = false;
+			if(m_highDefinition)
+			{
+				for(size_t i=0; i<m_analogChannelCount; i++)
+				{
+					if(!IsChannelEnabled(i))
+						continue;
+
+					auto chfmt = GetChannelTransferFormat(i);
+					if(chfmt == FORMAT_BYTE)
+						continue;
+					if( (chfmt == FORMAT_WORD) || !Is8BitTransferAcceptable(i) )
+					{
+						wantWord = true;
+						break;
+					}
+				}
+			}
+			break;
+	}
+
+	if(wantWord == m_transferIsWord)
+		return;
+
+	if(wantWord)
+		m_transport->SendCommandQueued("COMM_FORMAT DEF9,WORD,BIN");
+	else
+		m_transport->SendCommandQueued("COMM_FORMAT DEF9,BYTE,BIN");
+	m_transferIsWord = wantWord;
+}
+
+/**
+	@brief Checks if dropping channel i to 8-bit transfers would lose real information
+
+	At high vertical sensitivity the front end noise of even the HD models spans several 8-bit LSBs, so the
+	extra wire bits carry nothing but noise and we can halve the transfer time for free. At coarser gain
+	settings the quantization step grows with the range while the noise floor doesn't, so keep full resolution.
+ */
+bool LeCroyOscilloscope::Is8BitTransferAcceptable(size_t i)
+{
+	//Full scale range of 80 mV (10 mV/div) or finer: front end noise exceeds an 8-bit LSB
+	return GetChannelVoltageRange(i, 0) <= 0.08f;
+}
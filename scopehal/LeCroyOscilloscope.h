@@ -39,6 +39,8 @@
 
 #include <mutex>
 
+#include "RawSampleConverter.h"
+
 class DropoutTrigger;
 class EdgeTrigger;
 class GlitchTrigger;
@@ -87,9 +89,47 @@ public:
 	virtual uint32_t GetInstrumentTypesForChannel(size_t i) const override;
 
 	virtual void FlushConfigCache() override;
+	virtual void PrefetchConfigCache() override;
 
 	void ForceHDMode(bool mode);
 
+	//Waveform transfer format negotiation
+	enum TransferFormat
+	{
+		FORMAT_AUTO,	//adaptive: 8-bit transfers whenever the extra resolution would be noise anyway
+		FORMAT_BYTE,	//always 8 bit
+		FORMAT_WORD		//always 16 bit
+	};
+
+	///@brief Sets the global waveform transfer format policy (takes effect at the next acquisition)
+	void SetTransferFormat(TransferFormat format)
+	{ m_transferFormat = format; }
+
+	///@brief Gets the global waveform transfer format policy
+	TransferFormat GetTransferFormat()
+	{ return m_transferFormat; }
+
+	/**
+		@brief Overrides the transfer format policy for a single channel
+
+		COMM_FORMAT is global to the instrument, so a FORMAT_WORD override keeps the whole transfer at 16 bits
+		while that channel is enabled; FORMAT_BYTE declares the channel fine with 8 bits regardless of the gain
+		heuristic. Only meaningful when the global policy is FORMAT_AUTO.
+	 */
+	void SetChannelTransferFormat(size_t i, TransferFormat format)
+	{ m_channelTransferFormats[i] = format; }
+
+	///@brief Gets the per-channel transfer format override (FORMAT_AUTO if none was set)
+	TransferFormat GetChannelTransferFormat(size_t i)
+	{
+		auto it = m_channelTransferFormats.find(i);
+		return (it == m_channelTransferFormats.end()) ? FORMAT_AUTO : it->second;
+	}
+
+	//Parallel waveform download (opt-in, opens extra connections to the scope)
+	bool EnableParallelWaveformDownload(size_t numConnections);
+	void DisableParallelWaveformDownload();
+
 	//Channel configuration
 	virtual bool IsChannelEnabled(size_t i) override;
 	virtual void EnableChannel(size_t i) override;
@@ -142,6 +182,7 @@ public:
 	virtual void PushTrigger() override;
 	virtual void PullTrigger() override;
 	virtual void EnableTriggerOutput() override;
+	virtual bool CanRearmBeforeDownload() override;
 	virtual std::vector<std::string> GetTriggerTypes() override;
 	bool IsCDRLocked();
 
@@ -308,6 +349,9 @@ protected:
 
 	std::string GetPossiblyEmptyString(const std::string& property);
 
+	void UpdateTransferFormat();
+	bool Is8BitTransferAcceptable(size_t i);
+
 	bool ReadWaveformBlock(std::string& data);
 	bool ReadWavedescs(
 		std::vector<std::string>& wavedescs,
@@ -315,6 +359,12 @@ protected:
 		unsigned int& firstEnabledChannel,
 		bool& any_enabled);
 	void RequestWaveforms(bool* enabled, uint32_t num_sequences, bool denabled);
+	void DownloadWaveformsOnSecondaryTransport(
+		size_t conn,
+		size_t nconn,
+		const bool* enabled,
+		std::map<int, std::string>& analogWaveformData,
+		std::mutex& dataMutex);
 	std::vector<WaveformBase*> ProcessAnalogWaveform(
 		const char* data,
 		size_t datalen,
@@ -326,6 +376,9 @@ protected:
 		);
 	std::map<int, SparseDigitalWaveform*> ProcessDigitalWaveform(std::string& data, int64_t analog_hoff);
 
+	//Extra connections used to stripe waveform downloads (empty unless parallel download is enabled)
+	std::vector<std::unique_ptr<SCPITransport>> m_downloadTransports;
+
 	//hardware analog channel count, independent of LA option etc
 	unsigned int m_analogChannelCount;
 	unsigned int m_digitalChannelCount;
@@ -380,6 +433,24 @@ protected:
 	//True if we have >8 bit capture depth
 	bool m_highDefinition;
 
+	///@brief Global waveform transfer format policy
+	TransferFormat m_transferFormat;
+
+	///@brief Per-channel overrides to the global transfer format policy
+	std::map<size_t, TransferFormat> m_channelTransferFormats;
+
+	///@brief True if the scope is currently configured for 16-bit (WORD) transfers
+	bool m_transferIsWord;
+
+	///@brief Converts raw ADC codes to fp32 samples, on the GPU when possible
+	RawSampleConverter m_sampleConverter;
+
+	///@brief Scratch buffer holding raw 8-bit samples prior to conversion
+	AcceleratorBuffer<int8_t> m_rawSamples8;
+
+	///@brief Scratch buffer holding raw 16-bit samples prior to conversion
+	AcceleratorBuffer<int16_t> m_rawSamples16;
+
 	///@brief External trigger input
 	OscilloscopeChannel* m_extTrigChannel;
 
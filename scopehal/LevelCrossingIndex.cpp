@@ -0,0 +1,137 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of LevelCrossingIndex
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "LevelCrossingIndex.h"
+
+#include <omp.h>
+
+using namespace std;
+
+/**
+	@brief Finds every sample above / below the thresholds in one parallel pass over the record
+
+	Any previous index contents are discarded.
+
+	@param wfm				Waveform to index (must be CPU accessible)
+	@param highThreshold	Samples strictly above this go in the "above" index
+	@param lowThreshold		Samples strictly below this go in the "below" index
+ */
+void LevelCrossingIndex::Build(UniformAnalogWaveform* wfm, float highThreshold, float lowThreshold)
+{
+	m_aboveIdx.clear();
+	m_belowIdx.clear();
+
+	size_t len = wfm->size();
+	float* samples = wfm->m_samples.GetCpuPointer();
+
+	//Each chunk collects its qualifying samples independently; indexes within a chunk are naturally sorted
+	//and chunks are concatenated in order, so no merge or sort pass is needed.
+	const size_t minChunkSize = 256 * 1024;
+	size_t nchunks = min((len + minChunkSize - 1) / minChunkSize, (size_t)omp_get_max_threads());
+	nchunks = max(nchunks, (size_t)1);
+	size_t chunkSize = (len + nchunks - 1) / nchunks;
+	vector<vector<size_t>> chunkAbove(nchunks);
+	vector<vector<size_t>> chunkBelow(nchunks);
+
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
+	{
+		size_t start = c * chunkSize;
+		size_t end = min(start + chunkSize, len);
+		auto& above = chunkAbove[c];
+		auto& below = chunkBelow[c];
+
+		for(size_t i=start; i<end; i++)
+		{
+			float v = samples[i];
+			if(v > highThreshold)
+				above.push_back(i);
+			else if(v < lowThreshold)
+				below.push_back(i);
+		}
+	}
+
+	//Stitch the per-chunk lists together
+	size_t nabove = 0;
+	size_t nbelow = 0;
+	for(size_t c=0; c<nchunks; c++)
+	{
+		nabove += chunkAbove[c].size();
+		nbelow += chunkBelow[c].size();
+	}
+	m_aboveIdx.reserve(nabove);
+	m_belowIdx.reserve(nbelow);
+	for(size_t c=0; c<nchunks; c++)
+	{
+		m_aboveIdx.insert(m_aboveIdx.end(), chunkAbove[c].begin(), chunkAbove[c].end());
+		m_belowIdx.insert(m_belowIdx.end(), chunkBelow[c].begin(), chunkBelow[c].end());
+	}
+}
+
+/**
+	@brief Finds the first sample at or after a given position which is above the high threshold
+
+	@param i	Position to search from (inclusive)
+	@param pos	Output: index of the qualifying sample
+
+	@return True if a qualifying sample was found
+ */
+bool LevelCrossingIndex::NextAbove(size_t i, size_t& pos) const
+{
+	auto it = lower_bound(m_aboveIdx.begin(), m_aboveIdx.end(), i);
+	if(it == m_aboveIdx.end())
+		return false;
+	pos = *it;
+	return true;
+}
+
+/**
+	@brief Finds the first sample at or after a given position which is below the low threshold
+
+	@param i	Position to search from (inclusive)
+	@param pos	Output: index of the qualifying sample
+
+	@return True if a qualifying sample was found
+ */
+bool LevelCrossingIndex::NextBelow(size_t i, size_t& pos) const
+{
+	auto it = lower_bound(m_belowIdx.begin(), m_belowIdx.end(), i);
+	if(it == m_belowIdx.end())
+		return false;
+	pos = *it;
+	return true;
+}
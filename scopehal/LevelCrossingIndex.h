@@ -0,0 +1,76 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of LevelCrossingIndex
+	@ingroup core
+ */
+
+#ifndef LevelCrossingIndex_h
+#define LevelCrossingIndex_h
+
+/**
+	@brief Sorted index of the samples of a waveform qualifying against a pair of level thresholds
+
+	Serial line-coding decoders (Manchester, pulse-width codes, etc) repeatedly scan forward from the current
+	position for the next sample above or below a threshold, which makes the whole decode run at sample rate
+	even though the state machine only advances at edge rate. This class finds every qualifying sample once,
+	in a single parallel pass over the record, after which each "next edge after position i" query is a binary
+	search over the (much shorter) index.
+
+	The 10baseT decoder uses this for its Manchester recovery; other decoders that qualify analog levels
+	against fixed thresholds (1-Wire pulse timing and similar) can share the same index machinery.
+ */
+class LevelCrossingIndex
+{
+public:
+	void Build(UniformAnalogWaveform* wfm, float highThreshold, float lowThreshold);
+
+	bool NextAbove(size_t i, size_t& pos) const;
+	bool NextBelow(size_t i, size_t& pos) const;
+
+	///@brief Returns the indexes of all samples above the high threshold, in ascending order
+	const std::vector<size_t>& GetSamplesAbove() const
+	{ return m_aboveIdx; }
+
+	///@brief Returns the indexes of all samples below the low threshold, in ascending order
+	const std::vector<size_t>& GetSamplesBelow() const
+	{ return m_belowIdx; }
+
+protected:
+	///@brief Indexes of samples above the high threshold
+	std::vector<size_t> m_aboveIdx;
+
+	///@brief Indexes of samples below the low threshold
+	std::vector<size_t> m_belowIdx;
+};
+
+#endif
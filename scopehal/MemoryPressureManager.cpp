@@ -0,0 +1,342 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of MemoryPressureManager
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "MemoryPressureManager.h"
+
+#include <algorithm>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+MemoryPressureManager::MemoryPressureManager()
+	: m_generation(0)
+	, m_softReclaimTarget(256 * 1024 * 1024)
+	, m_hardReclaimMargin(64 * 1024 * 1024)
+	, m_minIdleGenerations(2)
+{
+	for(size_t i=0; i<static_cast<size_t>(MemoryBudgetGroup::Count); i++)
+		m_groupDeviceBudgets[i] = 0;
+}
+
+///@brief Returns the global MemoryPressureManager instance
+MemoryPressureManager& MemoryPressureManager::GetInstance()
+{
+	static MemoryPressureManager instance;
+	return instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Client registry
+
+///@brief Adds a client to the registry (initially marked as just touched)
+void MemoryPressureManager::Register(MemoryPressureClient* client)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_clients[client] = m_generation;
+}
+
+///@brief Removes a client from the registry
+void MemoryPressureManager::Unregister(MemoryPressureClient* client)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_clients.erase(client);
+}
+
+///@brief Marks a client as recently used, protecting it from soft eviction for a while
+void MemoryPressureManager::Touch(MemoryPressureClient* client)
+{
+	uint64_t gen = ++ m_generation;
+
+	lock_guard<mutex> lock(m_mutex);
+	auto it = m_clients.find(client);
+	if(it != m_clients.end())
+		it->second = gen;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Budget groups
+
+/**
+	@brief Returns the eviction priority of a budget group (lower = evicted first)
+
+	Groups whose contents are cheap to regenerate go first; acquisition data, which cannot be
+	re-acquired once lost, goes last.
+ */
+int MemoryPressureManager::GetEvictionPriority(MemoryBudgetGroup group)
+{
+	switch(group)
+	{
+		case MemoryBudgetGroup::FftScratch:
+			return 0;
+		case MemoryBudgetGroup::DensityAccumulators:
+			return 1;
+		case MemoryBudgetGroup::FilterIntermediates:
+			return 2;
+		case MemoryBudgetGroup::Other:
+			return 3;
+		case MemoryBudgetGroup::Acquisition:
+		default:
+			return 4;
+	}
+}
+
+///@brief Returns the total device memory currently consumed by clients in a budget group, in bytes
+size_t MemoryPressureManager::GetGroupDeviceMemoryUse(MemoryBudgetGroup group)
+{
+	//Snapshot the registry, then query the clients without holding our lock.
+	//Clients may call Touch() while holding their own locks, so we can't call into them while holding ours.
+	vector<MemoryPressureClient*> clients;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& it : m_clients)
+			clients.push_back(it.first);
+	}
+
+	size_t total = 0;
+	for(auto c : clients)
+	{
+		if(c->GetBudgetGroup() == group)
+			total += c->GetDeviceMemoryUse();
+	}
+	return total;
+}
+
+///@brief Returns the total pinned host memory currently consumed by clients in a budget group, in bytes
+size_t MemoryPressureManager::GetGroupHostMemoryUse(MemoryBudgetGroup group)
+{
+	vector<MemoryPressureClient*> clients;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& it : m_clients)
+			clients.push_back(it.first);
+	}
+
+	size_t total = 0;
+	for(auto c : clients)
+	{
+		if(c->GetBudgetGroup() == group)
+			total += c->GetHostMemoryUse();
+	}
+	return total;
+}
+
+/**
+	@brief Evicts cold device memory from a single budget group until it is back under its cap
+
+	Only this group's clients are touched, so an over-budget subsystem pays for its own overage
+	rather than pushing other subsystems' data out.
+
+	@return True if any memory was freed
+ */
+bool MemoryPressureManager::EnforceGroupBudget(MemoryBudgetGroup group)
+{
+	size_t budget = m_groupDeviceBudgets[static_cast<size_t>(group)];
+	if(budget == 0)
+		return false;
+
+	//Snapshot the registry, then find this group's clients without holding our lock
+	//(clients may call Touch() while holding their own locks)
+	vector< pair<uint64_t, MemoryPressureClient*> > snapshot;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& it : m_clients)
+			snapshot.push_back(pair<uint64_t, MemoryPressureClient*>(it.second, it.first));
+	}
+
+	vector< pair<uint64_t, MemoryPressureClient*> > cold;
+	size_t used = 0;
+	for(auto& it : snapshot)
+	{
+		if(it.second->GetBudgetGroup() != group)
+			continue;
+		used += it.second->GetDeviceMemoryUse();
+		cold.push_back(it);
+	}
+	if(used <= budget)
+		return false;
+	sort(cold.begin(), cold.end());
+
+	size_t excess = used - budget;
+	size_t freed = 0;
+	for(auto& it : cold)
+	{
+		if(freed >= excess)
+			break;
+		freed += it.second->EvictDeviceMemory();
+	}
+
+	if(freed > 0)
+	{
+		LogTrace("MemoryPressureManager: group over budget, reclaimed %s\n",
+			Unit(Unit::UNIT_BYTES).PrettyPrint(freed, 4).c_str());
+	}
+
+	return (freed > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Eviction policy
+
+/**
+	@brief Frees memory in response to a pressure event
+
+	Processes registered clients in two tiers. The first tier evicts GPU copies of cold buffers to
+	the host, which is cheap to undo (a re-upload). Only if that cannot satisfy the request does the
+	second tier compress or spill host copies, which is expensive to undo.
+
+	Within each tier, victims are ordered by budget group: over-budget groups first, then by group
+	eviction priority (cheap-to-regenerate data before acquisition data), then coldest-first.
+	Soft pressure never evicts acquisition data from the device at all.
+
+	For host-side pressure the first tier is skipped on discrete GPUs, since freeing device memory
+	does not help the host heap there.
+
+	@param level			Soft or hard pressure (hard pressure overrides the idle-time exemption)
+	@param type				Whether host or device memory is exhausted
+	@param requestedSize	Size of the failing allocation (hard pressure only)
+
+	@return True if any memory was freed
+ */
+bool MemoryPressureManager::HandlePressure(MemoryPressureLevel level, MemoryPressureType type, size_t requestedSize)
+{
+	//Figure out how much to reclaim.
+	//For hard pressure go past the failing allocation by a margin so the next allocation doesn't OOM right away.
+	size_t target;
+	if(level == MemoryPressureLevel::Hard)
+		target = requestedSize + m_hardReclaimMargin;
+	else
+		target = m_softReclaimTarget;
+
+	//Snapshot the registry sorted for eviction.
+	//Over-budget groups go first, then by group eviction priority (cheap-to-regenerate data before
+	//acquisition data), then coldest-first within a group.
+	uint64_t now = m_generation;
+	struct Victim
+	{
+		int m_order;
+		uint64_t m_gen;
+		MemoryPressureClient* m_client;
+
+		bool operator<(const Victim& rhs) const
+		{
+			if(m_order != rhs.m_order)
+				return m_order < rhs.m_order;
+			return m_gen < rhs.m_gen;
+		}
+	};
+	//Snapshot the registry, then query group membership and usage without holding our lock
+	//(clients may call Touch() while holding their own locks)
+	vector< pair<uint64_t, MemoryPressureClient*> > snapshot;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for(auto& it : m_clients)
+			snapshot.push_back(pair<uint64_t, MemoryPressureClient*>(it.second, it.first));
+	}
+
+	//Per-group device usage, to find groups over their caps
+	size_t groupUse[static_cast<size_t>(MemoryBudgetGroup::Count)] = {0};
+	for(auto& it : snapshot)
+		groupUse[static_cast<size_t>(it.second->GetBudgetGroup())] += it.second->GetDeviceMemoryUse();
+
+	vector<Victim> cold;
+	for(auto& it : snapshot)
+	{
+		auto group = it.second->GetBudgetGroup();
+		size_t budget = m_groupDeviceBudgets[static_cast<size_t>(group)];
+		bool overBudget = (budget != 0) && (groupUse[static_cast<size_t>(group)] > budget);
+
+		Victim v;
+		v.m_order = GetEvictionPriority(group) + (overBudget ? 0 : static_cast<int>(MemoryBudgetGroup::Count));
+		v.m_gen = it.first;
+		v.m_client = it.second;
+		cold.push_back(v);
+	}
+	sort(cold.begin(), cold.end());
+
+	size_t freed = 0;
+
+	//Tier 1: evict GPU copies of cold buffers to the host.
+	//Skipped for host pressure on discrete GPUs since device memory is a separate heap there.
+	if( (type == MemoryPressureType::Device) || g_vulkanDeviceHasUnifiedMemory )
+	{
+		for(auto& it : cold)
+		{
+			if(freed >= target)
+				break;
+
+			//Don't evict the working set on soft pressure
+			if( (level == MemoryPressureLevel::Soft) && ((now - it.m_gen) < m_minIdleGenerations) )
+				continue;
+
+			//Never take acquisition data for soft pressure: a hungry filter or display accumulator
+			//must not push live waveforms out, since those can't be re-acquired
+			if( (level == MemoryPressureLevel::Soft) &&
+				(it.m_client->GetBudgetGroup() == MemoryBudgetGroup::Acquisition) )
+			{
+				continue;
+			}
+
+			freed += it.m_client->EvictDeviceMemory();
+		}
+	}
+
+	//Tier 2: compress or spill host copies of cold data.
+	//Only reached if device eviction couldn't satisfy the request, or the pressure is on the host heap.
+	if(freed < target)
+	{
+		for(auto& it : cold)
+		{
+			if(freed >= target)
+				break;
+
+			if( (level == MemoryPressureLevel::Soft) && ((now - it.m_gen) < m_minIdleGenerations) )
+				continue;
+
+			freed += it.m_client->SpillHostMemory();
+		}
+	}
+
+	if(freed > 0)
+	{
+		LogWarning("MemoryPressureManager: reclaimed %s (target %s)\n",
+			Unit(Unit::UNIT_BYTES).PrettyPrint(freed, 4).c_str(),
+			Unit(Unit::UNIT_BYTES).PrettyPrint(target, 4).c_str());
+	}
+
+	return (freed > 0);
+}
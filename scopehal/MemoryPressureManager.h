@@ -0,0 +1,207 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of MemoryPressureManager
+	@ingroup core
+ */
+#ifndef MemoryPressureManager_h
+#define MemoryPressureManager_h
+
+#include "AcceleratorBuffer.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+/**
+	@brief Budget groups for memory accounting and eviction prioritization
+
+	Each MemoryPressureClient belongs to one group. Groups can be given per-group device memory caps,
+	and the eviction policy prefers reclaiming from groups whose contents are cheap to regenerate
+	(FFT scratch, density accumulators) before touching data that cannot be re-acquired.
+
+	@ingroup core
+ */
+enum class MemoryBudgetGroup
+{
+	///@brief Scratch buffers owned by FFT plans (cheap to regenerate)
+	FftScratch,
+
+	///@brief Integration buffers for spectrograms, eye patterns, and other density plots
+	DensityAccumulators,
+
+	///@brief Intermediate filter graph outputs (recomputable by re-running the graph)
+	FilterIntermediates,
+
+	///@brief Anything not otherwise classified
+	Other,
+
+	///@brief Live and historical acquisition data (cannot be regenerated once lost)
+	Acquisition,
+
+	///@brief Number of groups, not a valid group
+	Count
+};
+
+/**
+	@brief Interface for objects which own reclaimable memory (history waveforms, caches, etc.)
+
+	Clients register with the MemoryPressureManager and call Touch() whenever their contents are used,
+	so the manager can evict cold data first when memory runs short.
+
+	@ingroup core
+ */
+class MemoryPressureClient
+{
+public:
+	virtual ~MemoryPressureClient()
+	{}
+
+	///@brief Returns the budget group this client's memory is accounted against
+	virtual MemoryBudgetGroup GetBudgetGroup()
+	{ return MemoryBudgetGroup::Other; }
+
+	///@brief Returns the amount of GPU memory currently consumed by this client, in bytes
+	virtual size_t GetDeviceMemoryUse() =0;
+
+	///@brief Returns the amount of pinned host memory currently consumed by this client, in bytes
+	virtual size_t GetHostMemoryUse() =0;
+
+	/**
+		@brief Releases GPU-side copies of this client's data, keeping host copies intact.
+
+		Data must remain recoverable: the next access will re-upload from the host copy.
+
+		@return Number of bytes of device memory freed
+	 */
+	virtual size_t EvictDeviceMemory() =0;
+
+	/**
+		@brief Compresses this client's host-side data or spills it to disk.
+
+		Data must remain recoverable, but recovery may be expensive (decompression or disk read).
+
+		@return Number of bytes of host memory freed
+	 */
+	virtual size_t SpillHostMemory() =0;
+};
+
+/**
+	@brief Tiered eviction policy engine for memory pressure events
+
+	Maintains a registry of MemoryPressureClient objects with a last-touch generation for each.
+	When OnMemoryPressure() fires, clients are processed coldest-first in two tiers: GPU copies of
+	cold buffers are evicted to host first, then host copies are compressed or spilled to disk.
+
+	Hysteresis is provided by two mechanisms: reclaim continues past the failing allocation size
+	to a configurable target (so the very next allocation doesn't immediately OOM again), and
+	recently touched clients are exempt from soft eviction (so the working set doesn't thrash).
+
+	Clients are accounted against MemoryBudgetGroup buckets, which may be given per-group device
+	memory caps. Caps bias the eviction order toward over-budget groups and can be enforced
+	directly with EnforceGroupBudget(); per-group usage is observable for capacity planning.
+
+	@ingroup core
+ */
+class MemoryPressureManager
+{
+public:
+	static MemoryPressureManager& GetInstance();
+
+	void Register(MemoryPressureClient* client);
+	void Unregister(MemoryPressureClient* client);
+	void Touch(MemoryPressureClient* client);
+
+	bool HandlePressure(MemoryPressureLevel level, MemoryPressureType type, size_t requestedSize);
+
+	///@brief Sets the number of bytes to reclaim when soft pressure is reported
+	void SetSoftReclaimTarget(size_t bytes)
+	{ m_softReclaimTarget = bytes; }
+
+	///@brief Sets the number of bytes to reclaim beyond the failing allocation for hard pressure
+	void SetHardReclaimMargin(size_t bytes)
+	{ m_hardReclaimMargin = bytes; }
+
+	///@brief Sets how many generations a client must go untouched before soft eviction may take it
+	void SetMinimumIdleGenerations(uint64_t generations)
+	{ m_minIdleGenerations = generations; }
+
+	///@brief Returns the current touch generation
+	uint64_t GetGeneration()
+	{ return m_generation; }
+
+	/**
+		@brief Sets the device memory cap for a budget group, in bytes (0 = unlimited)
+
+		Caps are advisory: they bias the eviction order toward over-budget groups and drive
+		EnforceGroupBudget(), rather than failing allocations outright.
+	 */
+	void SetGroupDeviceBudget(MemoryBudgetGroup group, size_t bytes)
+	{ m_groupDeviceBudgets[static_cast<size_t>(group)] = bytes; }
+
+	///@brief Returns the device memory cap for a budget group, in bytes (0 = unlimited)
+	size_t GetGroupDeviceBudget(MemoryBudgetGroup group)
+	{ return m_groupDeviceBudgets[static_cast<size_t>(group)]; }
+
+	size_t GetGroupDeviceMemoryUse(MemoryBudgetGroup group);
+	size_t GetGroupHostMemoryUse(MemoryBudgetGroup group);
+
+	bool EnforceGroupBudget(MemoryBudgetGroup group);
+
+	static int GetEvictionPriority(MemoryBudgetGroup group);
+
+protected:
+	MemoryPressureManager();
+
+	///@brief Mutex protecting the client registry
+	std::mutex m_mutex;
+
+	///@brief Registered clients and the generation at which each was last touched
+	std::map<MemoryPressureClient*, uint64_t> m_clients;
+
+	///@brief Monotonic counter incremented on every Touch()
+	std::atomic<uint64_t> m_generation;
+
+	///@brief Bytes to reclaim on soft pressure
+	std::atomic<size_t> m_softReclaimTarget;
+
+	///@brief Bytes to reclaim beyond the failing allocation on hard pressure
+	std::atomic<size_t> m_hardReclaimMargin;
+
+	///@brief Generations a client must be idle before soft eviction
+	std::atomic<uint64_t> m_minIdleGenerations;
+
+	///@brief Device memory caps per budget group, in bytes (0 = unlimited)
+	std::atomic<size_t> m_groupDeviceBudgets[static_cast<size_t>(MemoryBudgetGroup::Count)];
+};
+
+#endif
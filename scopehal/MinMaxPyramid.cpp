@@ -0,0 +1,307 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of MinMaxPyramid
+	@ingroup datamodel
+ */
+#include "scopehal.h"
+#include "MinMaxPyramid.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+MinMaxPyramid::MinMaxPyramid()
+	: m_valid(false)
+	, m_builtRevision(0)
+	, m_builtLength(0)
+	, m_reductionPipeline("shaders/MinMaxPyramid.spv", 2, sizeof(MinMaxPyramidArgs))
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pyramid construction
+
+/**
+	@brief Reallocates the pyramid levels to cover the specified number of raw samples
+ */
+void MinMaxPyramid::ResizeLevels(size_t npoints)
+{
+	size_t nlevels = 0;
+	size_t npairs = (npoints + BASE_BLOCK - 1) / BASE_BLOCK;
+	while(true)
+	{
+		if(nlevels >= m_levels.size())
+		{
+			auto buf = make_unique<AcceleratorBuffer<float>>(
+				string("MinMaxPyramid.m_levels[") + to_string(nlevels) + "]");
+			buf->SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			buf->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+			m_levels.push_back(std::move(buf));
+		}
+		m_levels[nlevels]->resize(npairs * 2);
+		nlevels ++;
+
+		if(npairs <= 1)
+			break;
+		npairs = (npairs + 1) / 2;
+	}
+	m_levels.resize(nlevels);
+}
+
+/**
+	@brief Builds or refreshes the pyramid on the GPU.
+
+	No-op if the pyramid is already current for this revision of the sample data. Falls back to the CPU
+	builder if VK_KHR_push_descriptor is unavailable, since all levels are recorded into one command buffer.
+
+	@param samples	Sample data the pyramid summarizes
+	@param revision	Revision number of the owning waveform
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+ */
+void MinMaxPyramid::Build(
+	AcceleratorBuffer<float>& samples,
+	uint64_t revision,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if(m_valid && (revision == m_builtRevision) && (samples.size() == m_builtLength) )
+		return;
+
+	size_t npoints = samples.size();
+	if(npoints == 0)
+	{
+		m_levels.clear();
+		m_valid = false;
+		return;
+	}
+
+	if(!g_hasPushDescriptor)
+	{
+		BuildCpu(samples, revision);
+		return;
+	}
+
+	ResizeLevels(npoints);
+
+	samples.PrepareForGpuAccess();
+	for(auto& lev : m_levels)
+		lev->PrepareForGpuAccess();
+
+	//Record the whole reduction chain into one command buffer, with a barrier between dependent levels
+	cmdBuf.begin({});
+	MinMaxPyramidArgs args;
+	for(size_t i=0; i<m_levels.size(); i++)
+	{
+		if(i == 0)
+		{
+			args.inlen = npoints;
+			args.firstLevel = 1;
+			m_reductionPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+		}
+		else
+		{
+			ComputePipeline::AddComputeMemoryBarrier(cmdBuf);
+			args.inlen = m_levels[i-1]->size();
+			args.firstLevel = 0;
+			m_reductionPipeline.BindBufferNonblocking(0, *m_levels[i-1], cmdBuf);
+		}
+		args.outlen = m_levels[i]->size() / 2;
+		m_reductionPipeline.BindBufferNonblocking(1, *m_levels[i], cmdBuf, true);
+		m_reductionPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.outlen, 64));
+	}
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	for(auto& lev : m_levels)
+		lev->MarkModifiedFromGpu();
+
+	m_valid = true;
+	m_builtRevision = revision;
+	m_builtLength = npoints;
+}
+
+/**
+	@brief Builds or refreshes the pyramid on the CPU.
+
+	Used when a stale pyramid is queried with no command buffer in hand.
+
+	@param samples	Sample data the pyramid summarizes
+	@param revision	Revision number of the owning waveform
+ */
+void MinMaxPyramid::BuildCpu(AcceleratorBuffer<float>& samples, uint64_t revision)
+{
+	size_t npoints = samples.size();
+	if(npoints == 0)
+	{
+		m_levels.clear();
+		m_valid = false;
+		return;
+	}
+
+	ResizeLevels(npoints);
+	samples.PrepareForCpuAccess();
+
+	//Base level: reduce blocks of raw samples
+	auto& base = *m_levels[0];
+	base.PrepareForCpuAccess();
+	size_t nblocks = base.size() / 2;
+	for(size_t i=0; i<nblocks; i++)
+	{
+		size_t end = min(npoints, (i+1) * BASE_BLOCK);
+		float vmin = samples[i * BASE_BLOCK];
+		float vmax = vmin;
+		for(size_t j = i*BASE_BLOCK + 1; j < end; j++)
+		{
+			vmin = min(vmin, samples[j]);
+			vmax = max(vmax, samples[j]);
+		}
+		base[i*2] = vmin;
+		base[i*2 + 1] = vmax;
+	}
+	base.MarkModifiedFromCpu();
+
+	//Upper levels: reduce pairs from the previous level
+	for(size_t k=1; k<m_levels.size(); k++)
+	{
+		auto& prev = *m_levels[k-1];
+		auto& cur = *m_levels[k];
+		cur.PrepareForCpuAccess();
+		size_t nprev = prev.size() / 2;
+		size_t ncur = cur.size() / 2;
+		for(size_t i=0; i<ncur; i++)
+		{
+			float vmin = prev[i*4];
+			float vmax = prev[i*4 + 1];
+			if( (i*2 + 1) < nprev)
+			{
+				vmin = min(vmin, prev[i*4 + 2]);
+				vmax = max(vmax, prev[i*4 + 3]);
+			}
+			cur[i*2] = vmin;
+			cur[i*2 + 1] = vmax;
+		}
+		cur.MarkModifiedFromCpu();
+	}
+
+	m_valid = true;
+	m_builtRevision = revision;
+	m_builtLength = npoints;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queries
+
+/**
+	@brief Returns the min and max sample value over an arbitrary range of the waveform in O(log n)
+
+	If the pyramid is stale (the waveform has been modified since the last Build() call), it is rebuilt on
+	the CPU first; subsequent queries against the same revision are cheap.
+
+	@param samples	Sample data the pyramid summarizes
+	@param revision	Revision number of the owning waveform
+	@param start	Index of the first sample in the query range
+	@param len		Number of samples in the query range
+	@param vmin		Output: smallest sample value in the range
+	@param vmax		Output: largest sample value in the range
+
+	@return True on success, false if the query range is empty or out of bounds
+ */
+bool MinMaxPyramid::GetEnvelope(
+	AcceleratorBuffer<float>& samples,
+	uint64_t revision,
+	size_t start,
+	size_t len,
+	float& vmin,
+	float& vmax)
+{
+	if( (len == 0) || (start + len > samples.size()) )
+		return false;
+
+	if(!m_valid || (revision != m_builtRevision) || (samples.size() != m_builtLength) )
+		BuildCpu(samples, revision);
+
+	samples.PrepareForCpuAccess();
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
+	size_t end = start + len;
+
+	//Ragged edges not covered by a whole base level block get scanned directly (less than 2*BASE_BLOCK samples)
+	size_t leftBlock = (start + BASE_BLOCK - 1) / BASE_BLOCK;
+	size_t rightBlock = end / BASE_BLOCK;
+	if(leftBlock >= rightBlock)
+	{
+		for(size_t i=start; i<end; i++)
+		{
+			vmin = min(vmin, samples[i]);
+			vmax = max(vmax, samples[i]);
+		}
+		return true;
+	}
+	for(size_t i=start; i < leftBlock*BASE_BLOCK; i++)
+	{
+		vmin = min(vmin, samples[i]);
+		vmax = max(vmax, samples[i]);
+	}
+	for(size_t i = rightBlock*BASE_BLOCK; i<end; i++)
+	{
+		vmin = min(vmin, samples[i]);
+		vmax = max(vmax, samples[i]);
+	}
+
+	//Walk the interior block range up the pyramid segment-tree style, taking at most two entries per level
+	size_t l = leftBlock;
+	size_t r = rightBlock;
+	for(size_t k=0; (l < r) && (k < m_levels.size()); k++)
+	{
+		auto& lev = *m_levels[k];
+		lev.PrepareForCpuAccess();
+		if(l & 1)
+		{
+			vmin = min(vmin, lev[l*2]);
+			vmax = max(vmax, lev[l*2 + 1]);
+			l ++;
+		}
+		if(r & 1)
+		{
+			r --;
+			vmin = min(vmin, lev[r*2]);
+			vmax = max(vmax, lev[r*2 + 1]);
+		}
+		l >>= 1;
+		r >>= 1;
+	}
+
+	return true;
+}
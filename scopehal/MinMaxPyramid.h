@@ -0,0 +1,115 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of MinMaxPyramid
+	@ingroup datamodel
+ */
+#ifndef MinMaxPyramid_h
+#define MinMaxPyramid_h
+
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+
+class QueueHandle;
+
+/**
+	@brief Arguments to the min/max pyramid reduction shader
+	@ingroup datamodel
+ */
+struct MinMaxPyramidArgs
+{
+	///@brief Number of (min, max) pairs in the output level
+	uint32_t outlen;
+
+	///@brief Number of float elements in the input level
+	uint32_t inlen;
+
+	///@brief True if the input is raw samples rather than (min, max) pairs from a previous level
+	uint32_t firstLevel;
+};
+
+/**
+	@brief Multi-resolution min/max reduction (mipmap style) over a buffer of float samples
+	@ingroup datamodel
+
+	The base level stores one (min, max) pair per BASE_BLOCK raw samples; each subsequent level halves the
+	previous one, so total overhead is about 1/16 of the sample data. Once built, the envelope of an arbitrary
+	sample range can be queried in O(log n) by descending the pyramid segment-tree style, instead of scanning
+	every sample in the range.
+
+	The pyramid is validated against the owning waveform's revision number: Build() is a no-op if the pyramid
+	is already current, and a stale pyramid is rebuilt on the CPU by the next GetEnvelope() call. Producers
+	which already have a command buffer in hand (filters, drivers) can instead rebuild on the GPU via Build()
+	after modifying sample data.
+ */
+class MinMaxPyramid
+{
+public:
+	MinMaxPyramid();
+
+	void Build(
+		AcceleratorBuffer<float>& samples,
+		uint64_t revision,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	bool GetEnvelope(
+		AcceleratorBuffer<float>& samples,
+		uint64_t revision,
+		size_t start,
+		size_t len,
+		float& vmin,
+		float& vmax);
+
+	///@brief Number of raw samples covered by each entry of the base pyramid level
+	static const size_t BASE_BLOCK = 64;
+
+protected:
+	void ResizeLevels(size_t npoints);
+	void BuildCpu(AcceleratorBuffer<float>& samples, uint64_t revision);
+
+	///@brief Reduction levels; entry i of each level is the (min, max) pair stored at [2i], [2i+1]
+	std::vector<std::unique_ptr<AcceleratorBuffer<float>>> m_levels;
+
+	///@brief True if the pyramid has been built at least once
+	bool m_valid;
+
+	///@brief Waveform revision the pyramid was last built for
+	uint64_t m_builtRevision;
+
+	///@brief Number of samples the pyramid was last built for
+	size_t m_builtLength;
+
+	ComputePipeline m_reductionPipeline;
+};
+
+#endif
@@ -62,6 +62,12 @@ MultiLaneBERT::MultiLaneBERT(SCPITransport* transport)
 	//Don't push changes to hardware every time we poke a single channel setting
 	transport->SendCommandQueued("DEFER");
 
+	m_hasBatchedLockQuery = false;
+	m_probedBatchedLockQuery = false;
+	m_lastPollTimestamp = 0;
+	m_pollRunning = false;
+	m_pollInterval = 0;
+
 	//Change the data rate
 	SetUseExternalRefclk(false);
 	SetDataRate(0, 10312500000LL);
@@ -69,7 +75,7 @@ MultiLaneBERT::MultiLaneBERT(SCPITransport* transport)
 
 MultiLaneBERT::~MultiLaneBERT()
 {
-
+	StopAsyncPoll();
 }
 
 /**
@@ -809,11 +815,32 @@ void MultiLaneBERT::MeasureEye(size_t i)
 
 bool MultiLaneBERT::AcquireData()
 {
-	//Poll CDR lock status
-	for(int i=0; i<4; i++)
+	//Timestamp the burst before the first exchange so all counters published below share one coherent time
+	m_lastPollTimestamp = GetTime();
+
+	//Poll CDR lock status.
+	//Newer bridge builds support a global LOCK? query returning all four lanes comma separated (same shape
+	//as the global BER? query), cutting the poll burst from five round trips to two. Probe for it on the
+	//first poll and fall back to per-lane queries on older bridges.
+	if(m_hasBatchedLockQuery || !m_probedBatchedLockQuery)
 	{
-		auto reply = m_transport->SendCommandQueuedWithReply(m_channels[i + m_rxChannelBase]->GetHwname() + ":LOCK?");
-		m_rxLock[i] = (reply == "1");
+		auto slock = m_transport->SendCommandQueuedWithReply("LOCK?");
+		auto flags = explode(slock, ',');
+		if(flags.size() >= 4)
+		{
+			for(int i=0; i<4; i++)
+				m_rxLock[i] = (Trim(flags[i]) == "1");
+			m_hasBatchedLockQuery = true;
+		}
+		m_probedBatchedLockQuery = true;
+	}
+	if(!m_hasBatchedLockQuery)
+	{
+		for(int i=0; i<4; i++)
+		{
+			auto reply = m_transport->SendCommandQueuedWithReply(m_channels[i + m_rxChannelBase]->GetHwname() + ":LOCK?");
+			m_rxLock[i] = (reply == "1");
+		}
 	}
 
 	//Read BER for each channel
@@ -834,3 +861,56 @@ bool MultiLaneBERT::AcquireData()
 
 	return true;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Async subscription mode
+
+/**
+	@brief Starts polling all lanes' counters from a background thread
+
+	Each poll burst runs AcquireData() (one batched lock exchange plus one batched BER exchange on current
+	bridges) and then emits signal_pollComplete(), so BER dashboards can subscribe instead of issuing their
+	own per-lane queries. The transport command queue serializes the poll traffic against configuration
+	commands from other threads.
+
+	No-op if the poll thread is already running.
+
+	@param interval	Time between poll bursts, in seconds
+ */
+void MultiLaneBERT::StartAsyncPoll(double interval)
+{
+	if(m_pollRunning.exchange(true))
+		return;
+
+	m_pollInterval = interval;
+	m_pollThread = thread(&MultiLaneBERT::PollThreadMain, this);
+}
+
+/**
+	@brief Stops the background poll thread, blocking until it has exited
+
+	No-op if the poll thread is not running.
+ */
+void MultiLaneBERT::StopAsyncPoll()
+{
+	if(!m_pollRunning.exchange(false))
+		return;
+
+	if(m_pollThread.joinable())
+		m_pollThread.join();
+}
+
+///@brief Main loop for the background poll thread
+void MultiLaneBERT::PollThreadMain()
+{
+	while(m_pollRunning)
+	{
+		double tstart = GetTime();
+		AcquireData();
+		m_pollCompleteSignal.emit();
+
+		//Sleep off the rest of the interval in short chunks so StopAsyncPoll() stays responsive
+		while(m_pollRunning && ( (GetTime() - tstart) < m_pollInterval) )
+			this_thread::sleep_for(chrono::milliseconds(5));
+	}
+}
@@ -37,6 +37,8 @@
 #ifndef MultiLaneBERT_h
 #define MultiLaneBERT_h
 
+#include <atomic>
+
 /**
 	@brief A MultiLANE BERT accessed via scopehal-mlbert-bridge
 	@ingroup bertdrivers
@@ -53,6 +55,27 @@ public:
 
 	virtual bool AcquireData() override;
 
+	//Batched polling
+	void StartAsyncPoll(double interval);
+	void StopAsyncPoll();
+
+	///@brief Returns true if the background poll thread is running
+	bool IsAsyncPollRunning()
+	{ return m_pollRunning; }
+
+	/**
+		@brief Returns the timestamp (GetTime() units) at which the most recent poll burst was initiated
+
+		All lane counters published by that burst were requested at this instant, so dashboards can treat
+		the whole set as one coherent sample.
+	 */
+	double GetLastPollTimestamp()
+	{ return m_lastPollTimestamp; }
+
+	///@brief Signal emitted by the poll thread after each completed poll burst
+	sigc::signal<void()> signal_pollComplete()
+	{ return m_pollCompleteSignal; }
+
 	//Device information
 	virtual uint32_t GetInstrumentTypesForChannel(size_t i) const override;
 
@@ -149,6 +172,29 @@ protected:
 	///@brief RX pattern lock state
 	bool m_rxLock[4];
 
+	///@brief True if the bridge supports the global LOCK? query (probed on first poll)
+	bool m_hasBatchedLockQuery;
+
+	///@brief True if we've probed for the global LOCK? query yet
+	bool m_probedBatchedLockQuery;
+
+	///@brief Timestamp of the most recent poll burst
+	double m_lastPollTimestamp;
+
+	///@brief Background polling thread for async subscription mode
+	std::thread m_pollThread;
+
+	///@brief True if the poll thread should keep running
+	std::atomic<bool> m_pollRunning;
+
+	///@brief Poll interval for async subscription mode, in seconds
+	double m_pollInterval;
+
+	///@brief Signal emitted after each completed poll burst
+	sigc::signal<void()> m_pollCompleteSignal;
+
+	void PollThreadMain();
+
 	///@brief Bit pattern for TX custom-pattern mode
 	uint64_t m_txCustomPattern;
 
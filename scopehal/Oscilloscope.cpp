@@ -38,16 +38,12 @@
 
 #include <stdio.h>
 
-#ifdef __x86_64__
-#include <immintrin.h>
-#endif
-#include <omp.h>
-
 #include "EdgeTrigger.h"
 
 using namespace std;
 
 Oscilloscope::CreateMapType Oscilloscope::m_createprocs;
+map<string, string> Oscilloscope::m_lazyCreateprocs;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
@@ -55,6 +51,18 @@ Oscilloscope::CreateMapType Oscilloscope::m_createprocs;
 Oscilloscope::Oscilloscope()
 {
 	m_trigger = NULL;
+	m_triggerPollShutdown = false;
+	m_asyncTriggerMode = TRIGGER_MODE_STOP;
+	m_asyncTriggerPending = false;
+	m_rearmBeforeDownload = false;
+
+	m_admissionPolicy = ADMIT_ALL;
+	m_maxPendingWaveforms = 0;
+	m_admissionDecimation = 4;
+	m_admissionPhase = 0;
+	m_acquisitionsAdmitted = 0;
+	m_acquisitionsDropped = 0;
+	m_peakPendingWaveforms = 0;
 
 	m_serializers.push_back(sigc::mem_fun(*this, &Oscilloscope::DoSerializeConfiguration));
 	m_loaders.push_back(sigc::mem_fun(*this, &Oscilloscope::DoLoadConfiguration));
@@ -63,6 +71,8 @@ Oscilloscope::Oscilloscope()
 
 Oscilloscope::~Oscilloscope()
 {
+	StopAsyncTriggerPolling();
+
 	if(m_trigger)
 	{
 		m_trigger->DetachInputs();
@@ -86,14 +96,53 @@ void Oscilloscope::DoAddDriverClass(string name, CreateProcType proc)
 	m_createprocs[name] = proc;
 }
 
+/**
+	@brief Registers a driver class provided by a plugin that hasn't been loaded yet
+
+	The name shows up in EnumDrivers() immediately; the plugin itself is loaded the first time
+	CreateOscilloscope() asks for one of its classes. See InitializePlugins().
+ */
+void Oscilloscope::AddLazyDriverClass(const string& name, const string& pluginPath)
+{
+	//Never shadow a class that's already registered for real
+	if(m_createprocs.find(name) == m_createprocs.end())
+		m_lazyCreateprocs[name] = pluginPath;
+}
+
 void Oscilloscope::EnumDrivers(vector<string>& names)
 {
 	for(CreateMapType::iterator it=m_createprocs.begin(); it != m_createprocs.end(); ++it)
 		names.push_back(it->first);
+
+	//Classes from plugins we haven't loaded yet
+	for(auto& it : m_lazyCreateprocs)
+	{
+		if(m_createprocs.find(it.first) == m_createprocs.end())
+			names.push_back(it.first);
+	}
 }
 
 shared_ptr<Oscilloscope> Oscilloscope::CreateOscilloscope(string driver, SCPITransport* transport)
 {
+	//Driver from a plugin we haven't loaded yet? Load it now; its PluginInit() registers the real factory
+	auto lit = m_lazyCreateprocs.find(driver);
+	if( (lit != m_lazyCreateprocs.end()) && (m_createprocs.find(driver) == m_createprocs.end()) )
+	{
+		auto path = lit->second;
+		if(!LoadPlugin(path))
+			LogError("Failed to load plugin %s providing driver \"%s\"\n", path.c_str(), driver.c_str());
+
+		//Drop all stubs pointing at this module, whether or not the load worked, so a stale manifest
+		//can't make us retry the dlopen for every class it lists
+		for(auto it = m_lazyCreateprocs.begin(); it != m_lazyCreateprocs.end(); )
+		{
+			if(it->second == path)
+				it = m_lazyCreateprocs.erase(it);
+			else
+				++it;
+		}
+	}
+
 	if(m_createprocs.find(driver) != m_createprocs.end())
 		return m_createprocs[driver](transport);
 
@@ -109,6 +158,11 @@ void Oscilloscope::FlushConfigCache()
 	//nothing to do, base class has no caching
 }
 
+void Oscilloscope::PrefetchConfigCache()
+{
+	//nothing to do, base class has no caching
+}
+
 bool Oscilloscope::IsOffline()
 {
 	return false;
@@ -146,6 +200,65 @@ bool Oscilloscope::WaitForTrigger(int timeout)
 	return false;
 }
 
+void Oscilloscope::StartAsyncTriggerPolling()
+{
+	//Nothing to do if already polling
+	if(m_triggerPollThread)
+		return;
+
+	m_triggerPollShutdown = false;
+	m_asyncTriggerMode = TRIGGER_MODE_STOP;
+	m_asyncTriggerPending = false;
+	m_triggerPollThread = make_unique<thread>(&Oscilloscope::TriggerPollThread, this);
+}
+
+void Oscilloscope::StopAsyncTriggerPolling()
+{
+	if(!m_triggerPollThread)
+		return;
+
+	m_triggerPollShutdown = true;
+	m_triggerPollThread->join();
+	m_triggerPollThread = nullptr;
+}
+
+void Oscilloscope::AcknowledgeAsyncTrigger()
+{
+	m_asyncTriggerPending = false;
+}
+
+/**
+	@brief Thread procedure for background trigger polling
+
+	Each instrument in a multi-scope setup gets its own poll thread, so the blocking SCPI round trips of
+	PollTrigger() overlap across instruments instead of accumulating.
+ */
+void Oscilloscope::TriggerPollThread()
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "TriggerPoll");
+	#endif
+
+	while(!m_triggerPollShutdown)
+	{
+		//If we saw a trigger event that hasn't been acknowledged yet, don't poll again.
+		//PollTrigger() may clear driver or instrument side "triggered" state, so polling now could lose the event.
+		if(m_asyncTriggerPending)
+		{
+			this_thread::sleep_for(chrono::microseconds(100));
+			continue;
+		}
+
+		auto mode = PollTrigger();
+		if(mode == TRIGGER_MODE_TRIGGERED)
+			m_asyncTriggerPending = true;
+		m_asyncTriggerMode.store(mode, memory_order_release);
+
+		//Brief sleep so an offline or fast-failing driver doesn't spin at 100% CPU
+		this_thread::sleep_for(chrono::microseconds(500));
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Sequenced capture
 
@@ -188,6 +301,7 @@ bool Oscilloscope::PopPendingWaveform()
 		for(auto it : set)
 			it.first.m_channel->SetData(it.second, it.first.m_stream);
 		m_pendingWaveforms.pop_front();
+		LatencyTracer::GetInstance().RecordInstant("queue", m_nickname + " dequeue");
 		return true;
 	}
 	return false;
@@ -201,6 +315,140 @@ bool Oscilloscope::IsAppendingToWaveform()
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Acquisition admission control
+
+/**
+	@brief Adds a new acquisition to the pending waveform queue, applying the admission policy
+
+	Called by driver AcquireData() implementations instead of pushing onto m_pendingWaveforms directly.
+	The caller must hold m_pendingWaveformsMutex. If the acquisition is refused, its waveforms are deleted.
+ */
+void Oscilloscope::AddPendingWaveform(SequenceSet& s)
+{
+	bool drop = false;
+	if(m_maxPendingWaveforms && (m_pendingWaveforms.size() >= m_maxPendingWaveforms) )
+	{
+		switch(m_admissionPolicy)
+		{
+			//Make room by discarding from the head of the queue: latency stays bounded and the
+			//data we do process is always the freshest available
+			case ADMIT_DROP_OLDEST:
+				while(m_pendingWaveforms.size() >= m_maxPendingWaveforms)
+				{
+					for(auto& it : m_pendingWaveforms.front())
+						delete it.second;
+					m_pendingWaveforms.pop_front();
+					m_acquisitionsDropped ++;
+				}
+				break;
+
+			//Refuse the incoming acquisition, keeping the queued backlog intact
+			case ADMIT_DROP_NEWEST:
+				drop = true;
+				break;
+
+			//Admit one acquisition in N for as long as we stay over the limit
+			case ADMIT_DECIMATE:
+				drop = ( (m_admissionPhase % m_admissionDecimation) != 0);
+				m_admissionPhase ++;
+				break;
+
+			case ADMIT_ALL:
+			default:
+				break;
+		}
+	}
+	else
+		m_admissionPhase = 0;
+
+	if(drop)
+	{
+		for(auto& it : s)
+			delete it.second;
+		m_acquisitionsDropped ++;
+		LatencyTracer::GetInstance().RecordInstant("queue", m_nickname + " dropped");
+		return;
+	}
+
+	m_pendingWaveforms.push_back(s);
+	m_acquisitionsAdmitted ++;
+	m_peakPendingWaveforms = max(m_peakPendingWaveforms, m_pendingWaveforms.size());
+
+	LatencyTracer::GetInstance().RecordInstant("queue", m_nickname + " enqueue");
+}
+
+/**
+	@brief Sets the admission policy and pending queue depth limit
+
+	@param policy			What to do with new acquisitions once the queue is at the limit
+	@param maxPendingDepth	Maximum pending queue depth (0 = unlimited, making the policy moot)
+ */
+void Oscilloscope::SetAdmissionPolicy(AdmissionPolicy policy, size_t maxPendingDepth)
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	m_admissionPolicy = policy;
+	m_maxPendingWaveforms = maxPendingDepth;
+}
+
+///@brief Sets the decimation factor for ADMIT_DECIMATE (1 acquisition in N admitted while over the limit)
+void Oscilloscope::SetAdmissionDecimation(size_t factor)
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	m_admissionDecimation = max(factor, (size_t)1);
+}
+
+///@brief Returns the current admission policy
+Oscilloscope::AdmissionPolicy Oscilloscope::GetAdmissionPolicy()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_admissionPolicy;
+}
+
+///@brief Returns the pending queue depth limit (0 = unlimited)
+size_t Oscilloscope::GetPendingWaveformLimit()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_maxPendingWaveforms;
+}
+
+///@brief Returns the decimation factor for ADMIT_DECIMATE
+size_t Oscilloscope::GetAdmissionDecimation()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_admissionDecimation;
+}
+
+///@brief Returns the number of acquisitions admitted to the pending queue since the statistics were last reset
+uint64_t Oscilloscope::GetAcquisitionsAdmitted()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_acquisitionsAdmitted;
+}
+
+///@brief Returns the number of acquisitions dropped by the admission policy since the statistics were last reset
+uint64_t Oscilloscope::GetAcquisitionsDropped()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_acquisitionsDropped;
+}
+
+///@brief Returns the high-water mark of the pending queue depth since the statistics were last reset
+size_t Oscilloscope::GetPeakPendingWaveformCount()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	return m_peakPendingWaveforms;
+}
+
+///@brief Resets the admission statistics (admitted/dropped counts and queue depth high-water mark)
+void Oscilloscope::ResetAdmissionStatistics()
+{
+	lock_guard<mutex> lock(m_pendingWaveformsMutex);
+	m_acquisitionsAdmitted = 0;
+	m_acquisitionsDropped = 0;
+	m_peakPendingWaveforms = m_pendingWaveforms.size();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Averaging
 
@@ -241,6 +489,26 @@ void Oscilloscope::DoSerializeConfiguration(YAML::Node& node, IDTable& table)
 	if(HasFrequencyControls())
 		node["span"] = GetSpan();
 
+	//Save acquisition admission policy
+	switch(GetAdmissionPolicy())
+	{
+		case ADMIT_DROP_OLDEST:
+			node["admission"] = "dropoldest";
+			break;
+		case ADMIT_DROP_NEWEST:
+			node["admission"] = "dropnewest";
+			break;
+		case ADMIT_DECIMATE:
+			node["admission"] = "decimate";
+			break;
+		case ADMIT_ALL:
+		default:
+			node["admission"] = "all";
+			break;
+	}
+	node["admissiondepth"] = GetPendingWaveformLimit();
+	node["admissiondecim"] = GetAdmissionDecimation();
+
 	//Save channels
 	for(size_t i=0; i<GetChannelCount(); i++)
 	{
@@ -387,6 +655,22 @@ void Oscilloscope::DoLoadConfiguration(int version, const YAML::Node& node, IDTa
 {
 	m_nickname = node["nick"].as<string>();
 
+	//Load acquisition admission policy (absent in sessions saved before it existed)
+	if(node["admission"])
+	{
+		auto policy = node["admission"].as<string>();
+		AdmissionPolicy apol = ADMIT_ALL;
+		if(policy == "dropoldest")
+			apol = ADMIT_DROP_OLDEST;
+		else if(policy == "dropnewest")
+			apol = ADMIT_DROP_NEWEST;
+		else if(policy == "decimate")
+			apol = ADMIT_DECIMATE;
+		SetAdmissionPolicy(apol, node["admissiondepth"].as<size_t>(0));
+		if(node["admissiondecim"])
+			SetAdmissionDecimation(node["admissiondecim"].as<size_t>());
+	}
+
 	//Load the channels
 	auto& chans = node["channels"];
 	for(auto it : chans)
@@ -653,6 +937,12 @@ void Oscilloscope::EnableTriggerOutput()
 	//do nothing, assuming the scope needs no config to enable trigger out
 }
 
+bool Oscilloscope::CanRearmBeforeDownload()
+{
+	//assume not supported unless the driver has audited its download path
+	return false;
+}
+
 bool Oscilloscope::IsSamplingModeAvailable(SamplingMode mode)
 {
 	return (mode == REAL_TIME);
@@ -954,561 +1244,30 @@ bool Oscilloscope::HasTimebaseControls()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Helpers for converting raw 8-bit ADC samples to fp32 waveforms
+// Helpers for converting raw ADC samples to fp32 waveforms
+// (compatibility wrappers around the shared kernels in SampleConversion.h, which new code should use directly)
 
 /**
 	@brief Converts 8-bit ADC samples to floating point
  */
 void Oscilloscope::Convert8BitSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-			{
-				Convert8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else
-			#endif /* __x86_64__ */
-			{
-				Convert8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			Convert8BitSamplesAVX2(pout, pin, gain, offset, count);
-		else
-		#endif
-			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Generic backend for Convert8BitSamples()
- */
-void Oscilloscope::Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count)
-{
-	for(unsigned int k=0; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
-}
-
-#ifdef __x86_64__
-/**
-	@brief Optimized version of Convert8BitSamples()
- */
-__attribute__((target("avx2")))
-void Oscilloscope::Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count)
-{
-	unsigned int end = count - (count % 32);
-
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
-
-	for(unsigned int k=0; k<end; k += 32)
-	{
-		//Load all 32 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-
-		//Extract the low and high 16 samples from the block
-		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
-		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
-
-		//Swap the low and high halves of these vectors
-		//Ugly casting needed because all permute instrinsics expect float/double datatypes
-		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
-		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
-
-		//Divide into blocks of 8 samples and sign extend to 32 bit
-		__m256i block0_int = _mm256_cvtepi8_epi32(block01_x8);
-		__m256i block1_int = _mm256_cvtepi8_epi32(block10_x8);
-		__m256i block2_int = _mm256_cvtepi8_epi32(block23_x8);
-		__m256i block3_int = _mm256_cvtepi8_epi32(block32_x8);
-
-		//Convert the 32-bit int blocks to float.
-		//Apparently there's no direct epi8 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_mul_ps(block0_float, gains);
-		block1_float = _mm256_mul_ps(block1_float, gains);
-		block2_float = _mm256_mul_ps(block2_float, gains);
-		block3_float = _mm256_mul_ps(block3_float, gains);
-
-		block0_float = _mm256_sub_ps(block0_float, offsets);
-		block1_float = _mm256_sub_ps(block1_float, offsets);
-		block2_float = _mm256_sub_ps(block2_float, offsets);
-		block3_float = _mm256_sub_ps(block3_float, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
-	}
-
-	//Get any extras we didn't get in the SIMD loop
-	for(unsigned int k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+	ConvertSamples(pout, pin, gain, offset, count);
 }
-#endif /* __x86_64__ */
 
 /**
 	@brief Converts Unsigned 8-bit ADC samples to floating point
  */
 void Oscilloscope::ConvertUnsigned8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-			{
-				ConvertUnsigned8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else
-			#endif
-			{
-				ConvertUnsigned8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			ConvertUnsigned8BitSamplesAVX2(pout, pin, gain, offset, count);
-		else
-		#endif
-			ConvertUnsigned8BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Generic backend for ConvertUnsigned8BitSamples()
- */
-void Oscilloscope::ConvertUnsigned8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
-{
-	for(unsigned int k=0; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
-}
-
-#ifdef __x86_64__
-/**
-	@brief Optimized version of ConvertUnsigned8BitSamples()
- */
-__attribute__((target("avx2")))
-void Oscilloscope::ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
-{
-	unsigned int end = count - (count % 32);
-
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
-
-	for(unsigned int k=0; k<end; k += 32)
-	{
-		//Load all 32 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-
-		//Extract the low and high 16 samples from the block
-		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
-		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
-
-		//Swap the low and high halves of these vectors
-		//Ugly casting needed because all permute instrinsics expect float/double datatypes
-		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
-		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
-
-		//Divide into blocks of 8 samples and sign extend to 32 bit
-		__m256i block0_int = _mm256_cvtepu8_epi32(block01_x8);
-		__m256i block1_int = _mm256_cvtepu8_epi32(block10_x8);
-		__m256i block2_int = _mm256_cvtepu8_epi32(block23_x8);
-		__m256i block3_int = _mm256_cvtepu8_epi32(block32_x8);
-
-		//Convert the 32-bit int blocks to float.
-		//Apparently there's no direct epi8 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_mul_ps(block0_float, gains);
-		block1_float = _mm256_mul_ps(block1_float, gains);
-		block2_float = _mm256_mul_ps(block2_float, gains);
-		block3_float = _mm256_mul_ps(block3_float, gains);
-
-		block0_float = _mm256_sub_ps(block0_float, offsets);
-		block1_float = _mm256_sub_ps(block1_float, offsets);
-		block2_float = _mm256_sub_ps(block2_float, offsets);
-		block3_float = _mm256_sub_ps(block3_float, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
-	}
-
-	//Get any extras we didn't get in the SIMD loop
-	for(unsigned int k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+	ConvertSamples(pout, pin, gain, offset, count);
 }
-#endif /* __x86_64__ */
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Helpers for converting raw 16-bit ADC samples to fp32 waveforms
 
 /**
 	@brief Converts 16-bit ADC samples to floating point
  */
 void Oscilloscope::Convert16BitSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 64 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 64);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx512F)
-			{
-				Convert16BitSamplesAVX512F(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else if(g_hasAvx2)
-			{
-				if(g_hasFMA)
-				{
-					Convert16BitSamplesFMA(
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp);
-				}
-				else
-				{
-					Convert16BitSamplesAVX2(
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp);
-				}
-			}
-			else
-			#endif /* __x86_64__ */
-			{
-				Convert16BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-		{
-			if(g_hasFMA)
-				Convert16BitSamplesFMA(pout, pin, gain, offset, count);
-			else
-				Convert16BitSamplesAVX2(pout, pin, gain, offset, count);
-		}
-		else
-		#endif /* __x86_64__ */
-			Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
-}
-
-/**
-	@brief Converts raw ADC samples to floating point
- */
-void Oscilloscope::Convert16BitSamplesGeneric(float* pout, const int16_t* pin, float gain, float offset, size_t count)
-{
-	for(size_t j=0; j<count; j++)
-		pout[j] = gain*pin[j] - offset;
-}
-
-#ifdef __x86_64__
-__attribute__((target("avx2")))
-void Oscilloscope::Convert16BitSamplesAVX2(float* pout, const int16_t* pin, float gain, float offset, size_t count)
-{
-	size_t end = count - (count % 32);
-
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
-
-	for(size_t k=0; k<end; k += 32)
-	{
-		//Load all 32 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-		__m256i raw_samples2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 16));
-
-		//Extract the low and high halves (8 samples each) from the input blocks
-		__m128i block0_i16 = _mm256_extracti128_si256(raw_samples1, 0);
-		__m128i block1_i16 = _mm256_extracti128_si256(raw_samples1, 1);
-		__m128i block2_i16 = _mm256_extracti128_si256(raw_samples2, 0);
-		__m128i block3_i16 = _mm256_extracti128_si256(raw_samples2, 1);
-
-		//Convert both blocks from 16 to 32 bit, giving us a pair of 8x int32 vectors
-		__m256i block0_i32 = _mm256_cvtepi16_epi32(block0_i16);
-		__m256i block1_i32 = _mm256_cvtepi16_epi32(block1_i16);
-		__m256i block2_i32 = _mm256_cvtepi16_epi32(block2_i16);
-		__m256i block3_i32 = _mm256_cvtepi16_epi32(block3_i16);
-
-		//Convert the 32-bit int blocks to fp32
-		//Sadly there's no direct epi16 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_i32);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_i32);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_i32);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_i32);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_mul_ps(block0_float, gains);
-		block1_float = _mm256_mul_ps(block1_float, gains);
-		block2_float = _mm256_mul_ps(block2_float, gains);
-		block3_float = _mm256_mul_ps(block3_float, gains);
-
-		block0_float = _mm256_sub_ps(block0_float, offsets);
-		block1_float = _mm256_sub_ps(block1_float, offsets);
-		block2_float = _mm256_sub_ps(block2_float, offsets);
-		block3_float = _mm256_sub_ps(block3_float, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
-	}
-
-	//Get any extras we didn't get in the SIMD loop
-	for(size_t k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
-}
-
-__attribute__((target("avx2,fma")))
-void Oscilloscope::Convert16BitSamplesFMA(float* pout, const int16_t* pin, float gain, float offset, size_t count)
-{
-	size_t end = count - (count % 64);
-
-	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
-	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
-
-	for(size_t k=0; k<end; k += 64)
-	{
-		//Load all 64 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m256i raw_samples1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
-		__m256i raw_samples2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 16));
-		__m256i raw_samples3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 32));
-		__m256i raw_samples4 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 48));
-
-		//Extract the low and high halves (8 samples each) from the input blocks
-		__m128i block0_i16 = _mm256_extracti128_si256(raw_samples1, 0);
-		__m128i block1_i16 = _mm256_extracti128_si256(raw_samples1, 1);
-		__m128i block2_i16 = _mm256_extracti128_si256(raw_samples2, 0);
-		__m128i block3_i16 = _mm256_extracti128_si256(raw_samples2, 1);
-		__m128i block4_i16 = _mm256_extracti128_si256(raw_samples3, 0);
-		__m128i block5_i16 = _mm256_extracti128_si256(raw_samples3, 1);
-		__m128i block6_i16 = _mm256_extracti128_si256(raw_samples4, 0);
-		__m128i block7_i16 = _mm256_extracti128_si256(raw_samples4, 1);
-
-		//Convert the blocks from 16 to 32 bit, giving us a pair of 8x int32 vectors
-		__m256i block0_i32 = _mm256_cvtepi16_epi32(block0_i16);
-		__m256i block1_i32 = _mm256_cvtepi16_epi32(block1_i16);
-		__m256i block2_i32 = _mm256_cvtepi16_epi32(block2_i16);
-		__m256i block3_i32 = _mm256_cvtepi16_epi32(block3_i16);
-		__m256i block4_i32 = _mm256_cvtepi16_epi32(block4_i16);
-		__m256i block5_i32 = _mm256_cvtepi16_epi32(block5_i16);
-		__m256i block6_i32 = _mm256_cvtepi16_epi32(block6_i16);
-		__m256i block7_i32 = _mm256_cvtepi16_epi32(block7_i16);
-
-		//Convert the 32-bit int blocks to fp32
-		//Sadly there's no direct epi16 to ps conversion instruction.
-		__m256 block0_float = _mm256_cvtepi32_ps(block0_i32);
-		__m256 block1_float = _mm256_cvtepi32_ps(block1_i32);
-		__m256 block2_float = _mm256_cvtepi32_ps(block2_i32);
-		__m256 block3_float = _mm256_cvtepi32_ps(block3_i32);
-		__m256 block4_float = _mm256_cvtepi32_ps(block4_i32);
-		__m256 block5_float = _mm256_cvtepi32_ps(block5_i32);
-		__m256 block6_float = _mm256_cvtepi32_ps(block6_i32);
-		__m256 block7_float = _mm256_cvtepi32_ps(block7_i32);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm256_fmsub_ps(block0_float, gains, offsets);
-		block1_float = _mm256_fmsub_ps(block1_float, gains, offsets);
-		block2_float = _mm256_fmsub_ps(block2_float, gains, offsets);
-		block3_float = _mm256_fmsub_ps(block3_float, gains, offsets);
-		block4_float = _mm256_fmsub_ps(block4_float, gains, offsets);
-		block5_float = _mm256_fmsub_ps(block5_float, gains, offsets);
-		block6_float = _mm256_fmsub_ps(block6_float, gains, offsets);
-		block7_float = _mm256_fmsub_ps(block7_float, gains, offsets);
-
-		//All done, store back to the output buffer
-		_mm256_store_ps(pout + k, 		block0_float);
-		_mm256_store_ps(pout + k + 8,	block1_float);
-		_mm256_store_ps(pout + k + 16,	block2_float);
-		_mm256_store_ps(pout + k + 24,	block3_float);
-
-		_mm256_store_ps(pout + k + 32,	block4_float);
-		_mm256_store_ps(pout + k + 40,	block5_float);
-		_mm256_store_ps(pout + k + 48,	block6_float);
-		_mm256_store_ps(pout + k + 56,	block7_float);
-	}
-
-	//Get any extras we didn't get in the SIMD loop
-	for(size_t k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
+	ConvertSamples(pout, pin, gain, offset, count);
 }
 
-//WORKAROUND https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593 on Debian bookworm
-#if !defined(__llvm__) && ((__GNUC__ < 12) || ((__GNUC__ == 12) && (__GNUC_MINOR <= 2)))
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif
-__attribute__((target("avx512f")))
-void Oscilloscope::Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, float gain, float offset, size_t count)
-{
-	size_t end = count - (count % 64);
-
-	__m512 gains = _mm512_set1_ps(gain);
-	__m512 offsets = _mm512_set1_ps(offset);
-
-	for(size_t k=0; k<end; k += 64)
-	{
-		//Load all 64 raw ADC samples, without assuming alignment
-		//(on most modern Intel processors, load and loadu have same latency/throughput)
-		__m512i raw_samples1 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pin + k));
-		__m512i raw_samples2 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pin + k + 32));
-
-		//Extract the high and low halves (16 samples each) from the input blocks
-		__m256i block0_i16 = _mm512_extracti64x4_epi64(raw_samples1, 0);
-		__m256i block1_i16 = _mm512_extracti64x4_epi64(raw_samples1, 1);
-		__m256i block2_i16 = _mm512_extracti64x4_epi64(raw_samples2, 0);
-		__m256i block3_i16 = _mm512_extracti64x4_epi64(raw_samples2, 1);
-
-		//Convert the blocks from 16 to 32 bit, giving us a pair of 16x int32 vectors
-		__m512i block0_i32 = _mm512_cvtepi16_epi32(block0_i16);
-		__m512i block1_i32 = _mm512_cvtepi16_epi32(block1_i16);
-		__m512i block2_i32 = _mm512_cvtepi16_epi32(block2_i16);
-		__m512i block3_i32 = _mm512_cvtepi16_epi32(block3_i16);
-
-		//Convert the 32-bit int blocks to fp32
-		//Sadly there's no direct epi16 to ps conversion instruction.
-		__m512 block0_float = _mm512_cvtepi32_ps(block0_i32);
-		__m512 block1_float = _mm512_cvtepi32_ps(block1_i32);
-		__m512 block2_float = _mm512_cvtepi32_ps(block2_i32);
-		__m512 block3_float = _mm512_cvtepi32_ps(block3_i32);
-
-		//Woo! We've finally got floating point data. Now we can do the fun part.
-		block0_float = _mm512_fmsub_ps(block0_float, gains, offsets);
-		block1_float = _mm512_fmsub_ps(block1_float, gains, offsets);
-		block2_float = _mm512_fmsub_ps(block2_float, gains, offsets);
-		block3_float = _mm512_fmsub_ps(block3_float, gains, offsets);
-
-		//All done, store back to the output buffer
-		_mm512_store_ps(pout + k, 		block0_float);
-		_mm512_store_ps(pout + k + 16,	block1_float);
-		_mm512_store_ps(pout + k + 32,	block2_float);
-		_mm512_store_ps(pout + k + 48,	block3_float);
-	}
-
-	//Get any extras we didn't get in the SIMD loop
-	for(size_t k=end; k<count; k++)
-		pout[k] = pin[k] * gain - offset;
-}
-#if !defined(__llvm__) && ((__GNUC__ < 12) || ((__GNUC__ == 12) && (__GNUC_MINOR <= 2)))
-#pragma GCC diagnostic pop
-#endif
-
-#endif /* __x86_64__ */
-
@@ -41,6 +41,9 @@ class Instrument;
 #include "SCPITransport.h"
 #include "WaveformPool.h"
 
+#include <atomic>
+#include <thread>
+
 /**
 	@brief Generic representation of an oscilloscope, logic analyzer, or spectrum analyzer.
 
@@ -78,6 +81,20 @@ public:
 	 */
 	virtual void FlushConfigCache();
 
+	/**
+		@brief Bulk-populates the configuration cache with a minimal number of round trips to the instrument.
+
+		The per-attribute getters (GetChannelOffset() etc) each cost a full round trip on a cache miss, so walking
+		every channel of a freshly connected scope over a high-latency link can take tens of seconds. Drivers that
+		can query many settings in a single program message should override this to snapshot channel, timebase,
+		and trigger state wholesale so subsequent getters are served from cache.
+
+		Intended to be called right after connecting, or after FlushConfigCache(), before iterating channels.
+
+		The default implementation does nothing; per-attribute getters then populate the cache lazily as before.
+	 */
+	virtual void PrefetchConfigCache();
+
 	/**
 		@brief Checks if the instrument is currently online.
 
@@ -458,6 +475,50 @@ public:
 	 */
 	bool WaitForTrigger(int timeout);
 
+	/**
+		@brief Starts polling the trigger from a background thread.
+
+		The poll thread repeatedly calls PollTrigger() and publishes the most recent result via an atomic, readable
+		with GetAsyncTriggerMode(). This allows multi-scope arm/trigger loops to overlap the SCPI round trips of
+		several instruments rather than polling them serially, so effective trigger latency no longer grows with
+		instrument count.
+
+		Since PollTrigger() may have side effects in some drivers (such as clearing a "triggered" flag on the
+		instrument), the poll thread pauses as soon as it observes TRIGGER_MODE_TRIGGERED and does not poll again
+		until the client calls AcknowledgeAsyncTrigger(). This guarantees a trigger event cannot be consumed by the
+		poller and lost before the client sees it.
+
+		While async polling is active the client must not call PollTrigger() directly, as the instrument connection
+		is being used by the poll thread.
+	 */
+	void StartAsyncTriggerPolling();
+
+	/**
+		@brief Stops the background trigger polling thread, blocking until it has terminated.
+
+		Safe to call if polling was never started.
+	 */
+	void StopAsyncTriggerPolling();
+
+	///@brief Checks if the background trigger polling thread is running
+	bool IsAsyncTriggerPollingActive()
+	{ return (m_triggerPollThread != nullptr); }
+
+	/**
+		@brief Returns the most recent trigger state observed by the background polling thread.
+
+		Only meaningful while async polling is active (see StartAsyncTriggerPolling).
+	 */
+	TriggerMode GetAsyncTriggerMode()
+	{ return static_cast<TriggerMode>(m_asyncTriggerMode.load(std::memory_order_acquire)); }
+
+	/**
+		@brief Acknowledges a trigger event observed via GetAsyncTriggerMode() and resumes background polling.
+
+		Call after the triggered waveform has been downloaded and the instrument re-armed.
+	 */
+	void AcknowledgeAsyncTrigger();
+
 	/**
 		@brief Sets a new trigger on the instrument and pushes changes.
 
@@ -546,6 +607,33 @@ public:
 	 */
 	virtual void EnableTriggerOutput();
 
+	/**
+		@brief Checks if the instrument can re-arm the trigger before the previous waveform has finished downloading
+
+		Normally the acquisition loop arms, waits for a trigger, downloads, then re-arms, so the instrument sits idle
+		for the entire download. Drivers which can guarantee the acquisition memory is safe to overwrite once the
+		download has started (for example, because all waveform queries are queued up front and the instrument
+		serializes their replies before executing the re-arm command) may return true here and re-arm inside
+		AcquireData() as soon as that point is reached, overlapping the next acquisition with the transfer.
+
+		The default implementation returns false.
+	 */
+	virtual bool CanRearmBeforeDownload();
+
+	/**
+		@brief Enables or disables re-arming the trigger before waveform download completes (double buffered acquisition)
+
+		Has no effect if CanRearmBeforeDownload() returns false.
+
+		@param enable	True to enable early re-arm, false for the conventional arm-download-rearm sequence
+	 */
+	void SetRearmBeforeDownload(bool enable)
+	{ m_rearmBeforeDownload = enable && CanRearmBeforeDownload(); }
+
+	///@brief Checks if double buffered acquisition is currently enabled
+	bool GetRearmBeforeDownload()
+	{ return m_rearmBeforeDownload; }
+
 public:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Memory depth / sample rate control.
@@ -866,26 +954,11 @@ protected:
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sample format conversion
+	// (compatibility wrappers around the shared kernels in SampleConversion.h, which new code should use directly)
 public:
 	static void Convert8BitSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count);
-	static void Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count);
-#ifdef __x86_64__
-	static void Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count);
-#endif
-
 	static void ConvertUnsigned8BitSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
-	static void ConvertUnsigned8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
-#ifdef __x86_64__
-	static void ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
-#endif
-
 	static void Convert16BitSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count);
-	static void Convert16BitSamplesGeneric(float* pout, const int16_t* pin, float gain, float offset, size_t count);
-#ifdef __x86_64__
-	static void Convert16BitSamplesAVX2(float* pout, const int16_t* pin, float gain, float offset, size_t count);
-	static void Convert16BitSamplesFMA(float* pout, const int16_t* pin, float gain, float offset, size_t count);
-	static void Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, float gain, float offset, size_t count);
-#endif
 
 public:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -897,12 +970,68 @@ public:
 	virtual bool PopPendingWaveform();
 	virtual bool IsAppendingToWaveform();
 
+	/**
+		@brief Policy applied when an acquisition arrives while the pending waveform queue is at its depth limit
+
+		If the trigger rate exceeds the processing rate there is no backpressure in the acquisition-to-graph
+		handoff: the queue grows without bound and displayed data falls progressively further behind the
+		instrument. Setting a depth limit bounds that latency; the policy chooses what to sacrifice.
+	 */
+	enum AdmissionPolicy
+	{
+		///@brief Admit everything, never drop (default; queue depth is unbounded)
+		ADMIT_ALL,
+
+		///@brief Discard the oldest queued acquisitions to make room, so we always process the freshest data
+		ADMIT_DROP_OLDEST,
+
+		///@brief Refuse the incoming acquisition, preserving the queued backlog in order
+		ADMIT_DROP_NEWEST,
+
+		///@brief Admit one acquisition in N (see SetAdmissionDecimation()) while over the limit
+		ADMIT_DECIMATE
+	};
+
+	void SetAdmissionPolicy(AdmissionPolicy policy, size_t maxPendingDepth);
+	void SetAdmissionDecimation(size_t factor);
+	AdmissionPolicy GetAdmissionPolicy();
+	size_t GetPendingWaveformLimit();
+	size_t GetAdmissionDecimation();
+
+	uint64_t GetAcquisitionsAdmitted();
+	uint64_t GetAcquisitionsDropped();
+	size_t GetPeakPendingWaveformCount();
+	void ResetAdmissionStatistics();
+
 protected:
 	typedef std::map<StreamDescriptor, WaveformBase*> SequenceSet;
 	std::list<SequenceSet> m_pendingWaveforms;
 	std::mutex m_pendingWaveformsMutex;
 	std::recursive_mutex m_mutex;
 
+	void AddPendingWaveform(SequenceSet& s);
+
+	///@brief What to do with new acquisitions when the pending queue is at its depth limit
+	AdmissionPolicy m_admissionPolicy;
+
+	///@brief Maximum pending queue depth before m_admissionPolicy kicks in (0 = unlimited)
+	size_t m_maxPendingWaveforms;
+
+	///@brief Decimation factor for ADMIT_DECIMATE (1 acquisition in N admitted while over the limit)
+	size_t m_admissionDecimation;
+
+	///@brief Position in the current decimation cycle (reset whenever the queue drains below the limit)
+	size_t m_admissionPhase;
+
+	///@brief Number of acquisitions admitted to the pending queue (protected by m_pendingWaveformsMutex)
+	uint64_t m_acquisitionsAdmitted;
+
+	///@brief Number of acquisitions dropped by the admission policy (protected by m_pendingWaveformsMutex)
+	uint64_t m_acquisitionsDropped;
+
+	///@brief High-water mark of the pending queue depth (protected by m_pendingWaveformsMutex)
+	size_t m_peakPendingWaveforms;
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Diagnostics Access
 protected:
@@ -939,6 +1068,23 @@ protected:
 	//The trigger
 	Trigger* m_trigger;
 
+	///@brief Background trigger polling thread (null if not running)
+	std::unique_ptr<std::thread> m_triggerPollThread;
+
+	///@brief Set to request shutdown of the trigger polling thread
+	std::atomic<bool> m_triggerPollShutdown;
+
+	///@brief Most recent trigger state observed by the polling thread
+	std::atomic<int> m_asyncTriggerMode;
+
+	///@brief True if the polling thread saw a trigger event which has not yet been acknowledged
+	std::atomic<bool> m_asyncTriggerPending;
+
+	///@brief True if double buffered acquisition is enabled (see SetRearmBeforeDownload)
+	bool m_rearmBeforeDownload;
+
+	void TriggerPollThread();
+
 	//Pool for reusing memory allocations
 	WaveformPool m_analogWaveformPool;
 
@@ -999,6 +1145,7 @@ public:
 public:
 	typedef std::shared_ptr<Oscilloscope> (*CreateProcType)(SCPITransport*);
 	static void DoAddDriverClass(std::string name, CreateProcType proc);
+	static void AddLazyDriverClass(const std::string& name, const std::string& pluginPath);
 
 	static void EnumDrivers(std::vector<std::string>& names);
 	static std::shared_ptr<Oscilloscope> CreateOscilloscope(std::string driver, SCPITransport* transport);
@@ -1007,6 +1154,9 @@ protected:
 	//Class enumeration
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
+
+	///@brief Map of driver names to the plugin module providing them, for plugins not yet loaded
+	static std::map<std::string, std::string> m_lazyCreateprocs;
 };
 
 //must be declared here after Oscilloscope is defined
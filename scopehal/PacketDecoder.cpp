@@ -53,6 +53,7 @@ Packet::Packet()
 	, m_displayForegroundColor("#ffffff")
 	, m_displayBackgroundColor(PacketDecoder::m_backgroundColors[PacketDecoder::PROTO_COLOR_DEFAULT])
 	, m_packedColorsValid(false)
+	, m_pooled(false)
 {
 }
 
@@ -71,17 +72,132 @@ PacketDecoder::PacketDecoder(const std::string& color, Category cat)
 
 PacketDecoder::~PacketDecoder()
 {
+	//Flush the output cache while our packet cleanup hook can still dispatch to us
+	FlushOutputCache();
+
 	ClearPackets();
+
+	for(auto p : m_packetPool)
+		delete p;
+	m_packetPool.clear();
 }
 
 /**
-	@brief Destroys all currently attached packets
+	@brief Retires all currently attached packets
+
+	Pool-allocated packets go back to the pool for reuse by the next refresh; anything allocated directly
+	with new (including subclass-typed packets) is destroyed.
  */
 void PacketDecoder::ClearPackets()
 {
 	for(auto p : m_packets)
-		delete p;
+	{
+		if(p->m_pooled)
+			m_packetPool.push_back(p);
+		else
+			delete p;
+	}
+	m_packets.clear();
+	m_packetIndexes.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output cache packet retention
+
+///@brief Moves the currently attached packets into a cache entry alongside the retained waveforms
+void PacketDecoder::StashPacketsToCache(CachedOutputSet& entry)
+{
+	entry.m_packets = m_packets;
 	m_packets.clear();
+	m_packetIndexes.clear();
+}
+
+///@brief Reinstalls the packets retained by a cache entry, retiring anything currently attached
+void PacketDecoder::RestorePacketsFromCache(CachedOutputSet& entry)
+{
+	ClearPackets();
+	m_packets = entry.m_packets;
+	entry.m_packets.clear();
+}
+
+///@brief Frees the packets held by an evicted cache entry
+void PacketDecoder::FreeCachedPackets(CachedOutputSet& entry)
+{
+	for(auto p : entry.m_packets)
+		delete p;
+	entry.m_packets.clear();
+}
+
+/**
+	@brief Finds all packets whose value for the given header field exactly matches the supplied value
+
+	Backed by an inverted index (header value -> packets) which is built the first time a given header field is
+	queried and then maintained incrementally: subsequent queries only fold in packets appended since the last
+	query, so repeated filter-by-ID style lookups over large packet lists cost a single map probe rather than a
+	linear scan. The index is discarded when the packet list is cleared or detached.
+
+	Intended for downstream consumers (e.g. J1939SourceMatchFilter) running after this decoder's refresh has
+	completed; packets whose headers are mutated after a query will not be re-indexed.
+
+	@param header	Name of the header field to match on
+	@param value	Field value to search for
+
+	@return All packets with the requested header value, in capture order. The reference remains valid until the
+			packet list is next cleared, detached, or appended to.
+ */
+const std::vector<Packet*>& PacketDecoder::FindPackets(const std::string& header, const std::string& value)
+{
+	std::lock_guard<std::mutex> lock(m_packetIndexMutex);
+
+	//Fold any not-yet-indexed packets into the index for this header field
+	auto& index = m_packetIndexes[header];
+	for(size_t i = index.m_numIndexed; i < m_packets.size(); i++)
+	{
+		auto pval = m_packets[i]->m_headers.Find(header);
+		if(pval)
+			index.m_buckets[pval->GetHandle()].push_back(m_packets[i]);
+	}
+	index.m_numIndexed = m_packets.size();
+
+	auto it = index.m_buckets.find(StringTable::Intern(value));
+	if(it != index.m_buckets.end())
+		return it->second;
+
+	//No matches: return a persistent empty list (so we can return by reference)
+	static const std::vector<Packet*> g_emptyPacketList;
+	return g_emptyPacketList;
+}
+
+/**
+	@brief Allocates a Packet, reusing one retired by a previous refresh when possible
+
+	Packets allocated here are recycled, not freed, by ClearPackets(). In steady state a decoder producing
+	a similar number of packets each refresh therefore makes no heap allocations for packet storage: header
+	entries and the data buffer keep their capacity across reuse.
+
+	Subclass-typed packets (e.g. VideoScanlinePacket) must still be allocated with new.
+ */
+Packet* PacketDecoder::AllocatePacket()
+{
+	if(m_packetPool.empty())
+	{
+		auto p = new Packet;
+		p->m_pooled = true;
+		return p;
+	}
+
+	auto p = m_packetPool.back();
+	m_packetPool.pop_back();
+
+	//Reset to freshly constructed state (but keep buffer capacity)
+	p->m_offset = 0;
+	p->m_len = 0;
+	p->m_headers.clear();
+	p->m_data.clear();
+	p->m_displayForegroundColor = "#ffffff";
+	p->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DEFAULT];
+	p->m_packedColorsValid = false;
+	return p;
 }
 
 bool PacketDecoder::GetShowDataColumn()
@@ -31,6 +31,117 @@
 #define PacketDecoder_h
 
 #include "Filter.h"
+#include "StringTable.h"
+
+/**
+	@class
+	@brief Flat key-value store for packet headers
+
+	Packets typically have only a handful of headers, so a small vector with linear search beats std::map:
+	no per-node allocation, and lookups stay in one or two cache lines. Keys and values are interned in the
+	global StringTable and stored as 32-bit handles, so the heavily repeated header text ("ACK", "Read", etc)
+	of a multi-million packet capture is stored once process-wide and each entry costs eight bytes.
+ */
+class PacketHeaderMap
+{
+public:
+	PacketHeaderMap()
+		: m_size(0)
+	{}
+
+	PacketHeaderMap(const PacketHeaderMap& rhs)
+		: m_size(0)
+	{ *this = rhs; }
+
+	PacketHeaderMap& operator=(const PacketHeaderMap& rhs)
+	{
+		if(this == &rhs)
+			return *this;
+		m_entries = rhs.m_entries;
+		m_size = rhs.m_size;
+		return *this;
+	}
+
+	///@brief Returns a reference to the value for the given key, creating an empty entry if not present
+	InternedString& operator[](const std::string& key)
+	{
+		InternedString ikey(key);
+		for(size_t i=0; i<m_size; i++)
+		{
+			if(m_entries[i].first == ikey)
+				return m_entries[i].second;
+		}
+
+		//Not found, append (recycling a retired slot if we have one)
+		if(m_size < m_entries.size())
+		{
+			m_entries[m_size].first = ikey;
+			m_entries[m_size].second = InternedString();
+		}
+		else
+			m_entries.emplace_back(ikey, InternedString());
+		return m_entries[m_size++].second;
+	}
+
+	///@brief Returns a pointer to the value for the given key, or nullptr if not present (creates no entry)
+	const InternedString* Find(const std::string& key) const
+	{
+		InternedString ikey(key);
+		for(size_t i=0; i<m_size; i++)
+		{
+			if(m_entries[i].first == ikey)
+				return &m_entries[i].second;
+		}
+		return nullptr;
+	}
+
+	///@brief Removes all entries, but keeps their storage for reuse
+	void clear()
+	{ m_size = 0; }
+
+	size_t size() const
+	{ return m_size; }
+
+	bool empty() const
+	{ return m_size == 0; }
+
+	const std::pair<InternedString, InternedString>* begin() const
+	{ return m_entries.data(); }
+
+	const std::pair<InternedString, InternedString>* end() const
+	{ return m_entries.data() + m_size; }
+
+	///@brief Key-by-key comparison, insensitive to insertion order (matching std::map semantics)
+	bool operator==(const PacketHeaderMap& rhs) const
+	{
+		if(m_size != rhs.m_size)
+			return false;
+		for(size_t i=0; i<m_size; i++)
+		{
+			bool found = false;
+			for(size_t j=0; j<rhs.m_size; j++)
+			{
+				if(rhs.m_entries[j].first == m_entries[i].first)
+				{
+					if(rhs.m_entries[j].second != m_entries[i].second)
+						return false;
+					found = true;
+					break;
+				}
+			}
+			if(!found)
+				return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const PacketHeaderMap& rhs) const
+	{ return !(*this == rhs); }
+
+protected:
+	std::vector<std::pair<InternedString, InternedString>> m_entries;
+	size_t m_size;
+};
 
 /**
 	@class
@@ -49,16 +160,16 @@ public:
 	int64_t m_len;
 
 	//Arbitrary header properties (human readable)
-	std::map<std::string, std::string> m_headers;
+	PacketHeaderMap m_headers;
 
 	//Packet bytes
 	std::vector<uint8_t> m_data;
 
-	//Text color of the packet
-	std::string m_displayForegroundColor;
+	//Text color of the packet (interned: decoders reuse a small palette across millions of packets)
+	InternedString m_displayForegroundColor;
 
 	//Background color of the packet
-	std::string m_displayBackgroundColor;
+	InternedString m_displayBackgroundColor;
 
 	//Packed colors
 	uint32_t m_displayForegroundColorPacked;
@@ -66,6 +177,9 @@ public:
 
 	bool m_packedColorsValid;
 
+	///True if this packet came from the parent decoder's recycling pool (see PacketDecoder::AllocatePacket)
+	bool m_pooled;
+
 	void RefreshColors()
 	{
 		if(m_packedColorsValid)
@@ -90,6 +204,8 @@ public:
 	const std::vector<Packet*>& GetPackets()
 	{ return m_packets; }
 
+	const std::vector<Packet*>& FindPackets(const std::string& header, const std::string& value);
+
 	virtual std::vector<std::string> GetHeaders() =0;
 
 	virtual bool GetShowDataColumn();
@@ -124,12 +240,46 @@ public:
 		Typically used after copying the packets somewhere else and assuming ownership of them.
 	 */
 	void DetachPackets()
-	{ m_packets.clear(); }
+	{
+		m_packets.clear();
+		m_packetIndexes.clear();
+	}
 
 protected:
 	void ClearPackets();
 
+	//Retain/restore packets alongside the waveforms held by the Filter output cache
+	virtual void StashPacketsToCache(CachedOutputSet& entry) override;
+	virtual void RestorePacketsFromCache(CachedOutputSet& entry) override;
+	virtual void FreeCachedPackets(CachedOutputSet& entry) override;
+
+	Packet* AllocatePacket();
+
 	std::vector<Packet*> m_packets;
+
+	///@brief Packets retired by previous refreshes, available for reuse by AllocatePacket()
+	std::vector<Packet*> m_packetPool;
+
+	///@brief Inverted index over a single header field: maps header value to the packets carrying that value
+	class PacketHeaderIndex
+	{
+	public:
+		PacketHeaderIndex()
+			: m_numIndexed(0)
+		{}
+
+		///@brief Buckets keyed by interned handle of the header value
+		std::map<uint32_t, std::vector<Packet*>> m_buckets;
+
+		///@brief Number of entries of m_packets already folded into the index
+		size_t m_numIndexed;
+	};
+
+	///@brief Lazily built per-header-field indexes, keyed by header name (see FindPackets)
+	std::map<std::string, PacketHeaderIndex> m_packetIndexes;
+
+	///@brief Serializes index maintenance between concurrently executing consumer filters
+	std::mutex m_packetIndexMutex;
 };
 
 #endif
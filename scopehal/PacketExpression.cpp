@@ -0,0 +1,467 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketExpression
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "PacketExpression.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PacketExpression::PacketExpression()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compilation
+
+/**
+	@brief Compiles an expression string into a closure chain
+
+	On failure, returns false and leaves the expression invalid; GetError() describes the problem.
+	The previous compiled expression (if any) is discarded either way.
+
+	@param expr	Expression to compile (see class documentation for the grammar)
+ */
+bool PacketExpression::Compile(const string& expr)
+{
+	m_root = nullptr;
+	m_error = "";
+	m_indexField = "";
+	m_indexValue = "";
+
+	vector<Token> tokens;
+	if(!Tokenize(expr, tokens))
+		return false;
+
+	if(tokens.empty())
+	{
+		m_error = "Empty expression";
+		return false;
+	}
+
+	size_t pos = 0;
+	auto root = ParseOrExpression(tokens, pos, true);
+	if(!root)
+		return false;
+	if(pos != tokens.size())
+	{
+		m_error = string("Unexpected \"") + tokens[pos].m_text + "\" after end of expression";
+		return false;
+	}
+
+	m_root = root;
+	return true;
+}
+
+/**
+	@brief Splits an expression string into tokens
+
+	@param expr		Expression to split
+	@param tokens	Output token list
+ */
+bool PacketExpression::Tokenize(const string& expr, vector<Token>& tokens)
+{
+	size_t i = 0;
+	size_t len = expr.length();
+	while(i < len)
+	{
+		char c = expr[i];
+
+		//Skip whitespace
+		if(isspace(c))
+		{
+			i++;
+			continue;
+		}
+
+		//Quoted string (no escape sequences; header names and values never contain quotes)
+		if(c == '\"')
+		{
+			size_t end = expr.find('\"', i+1);
+			if(end == string::npos)
+			{
+				m_error = "Unterminated string constant";
+				return false;
+			}
+			tokens.push_back(Token{Token::TYPE_WORD, expr.substr(i+1, end-i-1)});
+			i = end + 1;
+			continue;
+		}
+
+		//Two-character operators
+		string two = expr.substr(i, 2);
+		if( (two == "&&") || (two == "||") || (two == "==") || (two == "!=") )
+		{
+			tokens.push_back(Token{Token::TYPE_SYMBOL, two});
+			i += 2;
+			continue;
+		}
+
+		//One-character operators
+		if(strchr("!&()[],", c))
+		{
+			tokens.push_back(Token{Token::TYPE_SYMBOL, string(1, c)});
+			i++;
+			continue;
+		}
+
+		//Bareword: everything up to whitespace, an operator character, or a quote
+		size_t end = i;
+		while( (end < len) && !isspace(expr[end]) && !strchr("!&()[],|=\"", expr[end]) )
+			end++;
+		string word = expr.substr(i, end-i);
+		int64_t ignored;
+		tokens.push_back(Token{ParseNumber(word, ignored) ? Token::TYPE_NUMBER : Token::TYPE_WORD, word});
+		i = end;
+	}
+
+	return true;
+}
+
+/**
+	@brief Parses a chain of one or more AND expressions joined by "||"
+
+	@param tokens	Token list
+	@param pos		Current parse position, advanced past the consumed tokens
+	@param toplevel	True if we're the outermost expression (enables the index hint)
+ */
+function<bool(const Packet*)> PacketExpression::ParseOrExpression(
+	const vector<Token>& tokens, size_t& pos, bool toplevel)
+{
+	auto lhs = ParseAndExpression(tokens, pos, toplevel);
+	if(!lhs)
+		return nullptr;
+
+	while( (pos < tokens.size()) && (tokens[pos].m_text == "||") && (tokens[pos].m_type == Token::TYPE_SYMBOL) )
+	{
+		//A disjunction can match packets outside any one index bucket, so drop the hint
+		m_indexField = "";
+		m_indexValue = "";
+
+		pos++;
+		auto rhs = ParseAndExpression(tokens, pos, false);
+		if(!rhs)
+			return nullptr;
+		lhs = [lhs, rhs](const Packet* p)
+			{ return lhs(p) || rhs(p); };
+	}
+
+	return lhs;
+}
+
+/**
+	@brief Parses a chain of one or more unary expressions joined by "&&"
+
+	@param tokens	Token list
+	@param pos		Current parse position, advanced past the consumed tokens
+	@param toplevel	True if we're part of the outermost AND chain (enables the index hint)
+ */
+function<bool(const Packet*)> PacketExpression::ParseAndExpression(
+	const vector<Token>& tokens, size_t& pos, bool toplevel)
+{
+	auto lhs = ParseUnary(tokens, pos, toplevel);
+	if(!lhs)
+		return nullptr;
+
+	while( (pos < tokens.size()) && (tokens[pos].m_text == "&&") && (tokens[pos].m_type == Token::TYPE_SYMBOL) )
+	{
+		pos++;
+		auto rhs = ParseUnary(tokens, pos, toplevel);
+		if(!rhs)
+			return nullptr;
+		lhs = [lhs, rhs](const Packet* p)
+			{ return lhs(p) && rhs(p); };
+	}
+
+	return lhs;
+}
+
+/**
+	@brief Parses a negation, a parenthesized group, or a single comparison term
+
+	@param tokens	Token list
+	@param pos		Current parse position, advanced past the consumed tokens
+	@param toplevel	True if we're part of the outermost AND chain (enables the index hint)
+ */
+function<bool(const Packet*)> PacketExpression::ParseUnary(const vector<Token>& tokens, size_t& pos, bool toplevel)
+{
+	if(pos >= tokens.size())
+	{
+		m_error = "Unexpected end of expression";
+		return nullptr;
+	}
+
+	if(tokens[pos].m_type == Token::TYPE_SYMBOL)
+	{
+		//Negation (conservatively disables the index hint for the inner expression)
+		if(tokens[pos].m_text == "!")
+		{
+			pos++;
+			auto inner = ParseUnary(tokens, pos, false);
+			if(!inner)
+				return nullptr;
+			return [inner](const Packet* p)
+				{ return !inner(p); };
+		}
+
+		//Parenthesized group
+		if(tokens[pos].m_text == "(")
+		{
+			pos++;
+			auto inner = ParseOrExpression(tokens, pos, false);
+			if(!inner)
+				return nullptr;
+			if( (pos >= tokens.size()) || (tokens[pos].m_text != ")") )
+			{
+				m_error = "Expected \")\"";
+				return nullptr;
+			}
+			pos++;
+			return inner;
+		}
+	}
+
+	return ParseTerm(tokens, pos, toplevel);
+}
+
+/**
+	@brief Parses a single comparison term and compiles it to a closure
+
+	@param tokens	Token list
+	@param pos		Current parse position, advanced past the consumed tokens
+	@param toplevel	True if we're part of the outermost AND chain (enables the index hint)
+ */
+function<bool(const Packet*)> PacketExpression::ParseTerm(const vector<Token>& tokens, size_t& pos, bool toplevel)
+{
+	//Field name
+	if(tokens[pos].m_type == Token::TYPE_SYMBOL)
+	{
+		m_error = string("Expected a header name, got \"") + tokens[pos].m_text + "\"";
+		return nullptr;
+	}
+	string field = tokens[pos].m_text;
+	pos++;
+
+	if(pos >= tokens.size())
+	{
+		m_error = string("Expected an operator after \"") + field + "\"";
+		return nullptr;
+	}
+	string op = tokens[pos].m_text;
+	pos++;
+
+	//Equality / inequality
+	if( (op == "==") || (op == "!=") )
+	{
+		if(pos >= tokens.size())
+		{
+			m_error = string("Expected a value after \"") + op + "\"";
+			return nullptr;
+		}
+		string lit = tokens[pos].m_text;
+		pos++;
+
+		//Intern the literal up front so the per-packet test is a single handle compare.
+		//If the literal is numeric, fall back to a numeric compare on handle mismatch so that e.g.
+		//0x10 matches a header rendered as "16".
+		InternedString ilit(lit);
+		int64_t litnum = 0;
+		bool litIsNum = ParseNumber(lit, litnum);
+
+		auto eq = [field, ilit, litIsNum, litnum](const Packet* p)
+		{
+			auto v = p->m_headers.Find(field);
+			if(!v)
+				return false;
+			if(v->GetHandle() == ilit.GetHandle())
+				return true;
+			if(!litIsNum)
+				return false;
+			int64_t hv;
+			if(!ParseNumber(v->str(), hv))
+				return false;
+			return (hv == litnum);
+		};
+
+		if(op == "!=")
+		{
+			return [eq](const Packet* p)
+				{ return !eq(p); };
+		}
+
+		//A pure string equality in the top-level AND chain can seed candidates from the inverted index.
+		//Numeric literals can't: the index buckets by exact text, which would miss alternate renderings.
+		if(toplevel && !litIsNum && m_indexField.empty())
+		{
+			m_indexField = field;
+			m_indexValue = lit;
+		}
+		return eq;
+	}
+
+	//Mask: field & mask == pattern
+	if(op == "&")
+	{
+		int64_t mask;
+		if( (pos >= tokens.size()) || !ParseNumber(tokens[pos].m_text, mask) )
+		{
+			m_error = string("Expected a mask value after \"") + field + " &\"";
+			return nullptr;
+		}
+		pos++;
+		if( (pos >= tokens.size()) || (tokens[pos].m_text != "==") )
+		{
+			m_error = "Expected \"==\" after mask value";
+			return nullptr;
+		}
+		pos++;
+		int64_t pattern;
+		if( (pos >= tokens.size()) || !ParseNumber(tokens[pos].m_text, pattern) )
+		{
+			m_error = "Expected a pattern value after \"==\"";
+			return nullptr;
+		}
+		pos++;
+
+		return [field, mask, pattern](const Packet* p)
+		{
+			auto v = p->m_headers.Find(field);
+			if(!v)
+				return false;
+			int64_t hv;
+			if(!ParseNumber(v->str(), hv))
+				return false;
+			return ( (hv & mask) == pattern );
+		};
+	}
+
+	//Inclusive range: field in [lo, hi]
+	if(op == "in")
+	{
+		if( (pos >= tokens.size()) || (tokens[pos].m_text != "[") )
+		{
+			m_error = string("Expected \"[\" after \"") + field + " in\"";
+			return nullptr;
+		}
+		pos++;
+		int64_t lo;
+		if( (pos >= tokens.size()) || !ParseNumber(tokens[pos].m_text, lo) )
+		{
+			m_error = "Expected a number as range lower bound";
+			return nullptr;
+		}
+		pos++;
+		if( (pos >= tokens.size()) || (tokens[pos].m_text != ",") )
+		{
+			m_error = "Expected \",\" between range bounds";
+			return nullptr;
+		}
+		pos++;
+		int64_t hi;
+		if( (pos >= tokens.size()) || !ParseNumber(tokens[pos].m_text, hi) )
+		{
+			m_error = "Expected a number as range upper bound";
+			return nullptr;
+		}
+		pos++;
+		if( (pos >= tokens.size()) || (tokens[pos].m_text != "]") )
+		{
+			m_error = "Expected \"]\" after range upper bound";
+			return nullptr;
+		}
+		pos++;
+
+		return [field, lo, hi](const Packet* p)
+		{
+			auto v = p->m_headers.Find(field);
+			if(!v)
+				return false;
+			int64_t hv;
+			if(!ParseNumber(v->str(), hv))
+				return false;
+			return ( (hv >= lo) && (hv <= hi) );
+		};
+	}
+
+	m_error = string("Expected a comparison operator after \"") + field + "\", got \"" + op + "\"";
+	return nullptr;
+}
+
+/**
+	@brief Parses a decimal or 0x-prefixed hex integer, requiring the whole string to be consumed
+
+	@param str		String to parse
+	@param value	Output value
+ */
+bool PacketExpression::ParseNumber(const string& str, int64_t& value)
+{
+	if(str.empty())
+		return false;
+	char* end = nullptr;
+	value = strtoll(str.c_str(), &end, 0);
+	return (end != nullptr) && (*end == '\0');
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+/**
+	@brief Evaluates the expression against every packet of a decoder in a single pass
+
+	If the expression carries an index hint, the candidate set is seeded from the decoder's inverted header
+	index so only packets already matching the hinted equality term are scanned.
+
+	@param source	Decoder whose packets to filter
+ */
+vector<Packet*> PacketExpression::Evaluate(PacketDecoder* source)
+{
+	vector<Packet*> ret;
+	if(!IsValid())
+		return ret;
+
+	const vector<Packet*>& candidates = m_indexField.empty() ?
+		source->GetPackets() :
+		source->FindPackets(m_indexField, m_indexValue);
+
+	for(auto p : candidates)
+	{
+		if(Match(p))
+			ret.push_back(p);
+	}
+	return ret;
+}
@@ -0,0 +1,140 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketExpression
+	@ingroup core
+ */
+
+#ifndef PacketExpression_h
+#define PacketExpression_h
+
+#include "PacketDecoder.h"
+
+#include <functional>
+
+/**
+	@brief A match expression over packet headers, compiled to a closure chain evaluated in a single pass
+
+	Expressions combine header comparisons with boolean operators, so a triage workflow that used to stack
+	several single-purpose match filters (each scanning the full packet list) can express the whole predicate
+	in one filter and one scan:
+
+	    Source == "Engine #1" && PGN & 0xff00 == 0xf000 && Length in [8, 64]
+
+	Grammar (whitespace insensitive):
+
+	    orexpr  := andexpr ("||" andexpr)*
+	    andexpr := unary ("&&" unary)*
+	    unary   := "!" unary | "(" orexpr ")" | term
+	    term    := field "==" value
+	             | field "!=" value
+	             | field "&" number "==" number
+	             | field "in" "[" number "," number "]"
+	    field   := bareword | quoted string (quote field names containing spaces, e.g. "Group ext")
+	    value   := bareword | quoted string | number
+
+	Numbers accept decimal or 0x-prefixed hex. Equality terms compare interned string handles (a single
+	integer compare per packet); if both sides parse as numbers, numeric equality is used instead so that
+	"0x10" matches a header displayed as "16". Mask and range terms require the header value to parse as a
+	number. A term referencing a header the packet doesn't carry evaluates false.
+
+	Compile() builds the closure chain and records an index hint: if the expression is a top-level AND chain
+	containing a string-equality term, Evaluate() seeds the candidate set from the source decoder's inverted
+	header index (PacketDecoder::FindPackets) rather than the full packet list.
+ */
+class PacketExpression
+{
+public:
+	PacketExpression();
+
+	bool Compile(const std::string& expr);
+
+	///@brief Returns true if the last Compile() succeeded
+	bool IsValid() const
+	{ return m_root != nullptr; }
+
+	///@brief Returns a human readable description of the last Compile() failure
+	const std::string& GetError() const
+	{ return m_error; }
+
+	/**
+		@brief Evaluates the compiled expression against a single packet
+
+		Only valid if IsValid() returns true.
+
+		@param pack	Packet to test
+	 */
+	bool Match(const Packet* pack) const
+	{ return m_root(pack); }
+
+	std::vector<Packet*> Evaluate(PacketDecoder* source);
+
+protected:
+	///@brief A token produced by the lexer
+	struct Token
+	{
+		enum Type
+		{
+			TYPE_WORD,		//bareword or quoted string
+			TYPE_NUMBER,	//bareword that also parses as a number
+			TYPE_SYMBOL		//operator or punctuation
+		};
+
+		Type m_type;
+		std::string m_text;
+	};
+
+	bool Tokenize(const std::string& expr, std::vector<Token>& tokens);
+
+	std::function<bool(const Packet*)> ParseOrExpression(
+		const std::vector<Token>& tokens, size_t& pos, bool toplevel);
+	std::function<bool(const Packet*)> ParseAndExpression(
+		const std::vector<Token>& tokens, size_t& pos, bool toplevel);
+	std::function<bool(const Packet*)> ParseUnary(const std::vector<Token>& tokens, size_t& pos, bool toplevel);
+	std::function<bool(const Packet*)> ParseTerm(const std::vector<Token>& tokens, size_t& pos, bool toplevel);
+
+	static bool ParseNumber(const std::string& str, int64_t& value);
+
+	///@brief Compiled match predicate (null if the last Compile() failed)
+	std::function<bool(const Packet*)> m_root;
+
+	///@brief Description of the last parse failure
+	std::string m_error;
+
+	///@brief Header field of the index hint, or empty if the expression isn't index accelerated
+	std::string m_indexField;
+
+	///@brief Header value of the index hint
+	std::string m_indexValue;
+};
+
+#endif
@@ -44,6 +44,194 @@ PeakDetector::~PeakDetector()
 {
 }
 
+/**
+	@brief GPU accelerated peak search over a uniform analog waveform.
+
+	Two stage pipeline: a compute shader reduces each CANDIDATE_BLOCK samples to an (index, max, min) summary,
+	then only the per-block candidates are refined on the CPU. A candidate is accepted iff nothing else in its
+	search window is greater or equal; blocks entirely inside the window are checked against their precomputed
+	maxima and only the candidate's own block plus partially covered edge blocks are scanned sample by sample,
+	so the CPU never touches more than a tiny fraction of the record. Results match the serial scan.
+
+	Small waveforms fall back to the serial scan since dispatch overhead would dominate.
+
+	@param cap			Waveform to search
+	@param max_peaks	Maximum number of peaks to report
+	@param search_hz	Width of the search window, in X axis units
+	@param cmdBuf		Command buffer for GPU work (must not be in the recording state)
+	@param queue		Queue to submit GPU work to
+ */
+void PeakDetector::FindPeaks(
+	UniformAnalogWaveform* cap,
+	int64_t max_peaks,
+	float search_hz,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t nouts = cap->size();
+	if( (max_peaks == 0) || (nouts < 2) )
+	{
+		m_peaks.clear();
+		return;
+	}
+	if(nouts < MIN_GPU_PEAK_SAMPLES)
+	{
+		FindPeaks(cap, max_peaks, search_hz);
+		return;
+	}
+
+	//Same search geometry as the serial scan
+	int64_t binsize = GetOffsetScaled(cap, 1) - GetOffsetScaled(cap, 0);
+	int64_t search_bins = ceil(search_hz / binsize);
+	ssize_t search_rad = std::max(search_bins/2, (int64_t)1);
+
+	//Stage 1: reduce each block of CANDIDATE_BLOCK samples to an (index, max, min) summary on the GPU
+	if(!m_candidatePipeline)
+	{
+		m_candidatePipeline = make_unique<ComputePipeline>(
+			"shaders/PeakCandidate.spv", 2, sizeof(PeakCandidateArgs));
+		m_blockInfo = make_unique<AcceleratorBuffer<PeakBlockInfo>>("PeakDetector.m_blockInfo");
+		m_blockInfo->SetCpuAccessHint(AcceleratorBuffer<PeakBlockInfo>::HINT_LIKELY);
+		m_blockInfo->SetGpuAccessHint(AcceleratorBuffer<PeakBlockInfo>::HINT_LIKELY);
+	}
+	size_t nblocks = GetComputeBlockCount(nouts, CANDIDATE_BLOCK);
+	m_blockInfo->resize(nblocks);
+
+	cap->PrepareForGpuAccess();
+	cmdBuf.begin({});
+	PeakCandidateArgs args;
+	args.npoints = nouts;
+	m_candidatePipeline->BindBufferNonblocking(0, cap->m_samples, cmdBuf);
+	m_candidatePipeline->BindBufferNonblocking(1, *m_blockInfo, cmdBuf, true);
+	m_candidatePipeline->Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_blockInfo->MarkModifiedFromGpu();
+
+	//Stage 2: refine the candidates on the CPU
+	m_blockInfo->PrepareForCpuAccess();
+	cap->PrepareForCpuAccess();
+	auto& blocks = *m_blockInfo;
+	auto& samples = cap->m_samples;
+
+	//Baseline from the per-block minima (same value GetMinVoltage() would find, without rescanning everything)
+	float baseline = FLT_MAX;
+	for(size_t b=0; b<nblocks; b++)
+		baseline = std::min(baseline, blocks[b].m_min);
+
+	std::vector<Peak> peaks;
+	ssize_t nend = nouts - 1;
+	const ssize_t minpeak = 10;	//Skip this many bins at left to avoid false positives on the DC peak
+								//(must match the serial scan)
+	for(size_t b=0; b<nblocks; b++)
+	{
+		ssize_t i = blocks[b].m_idx;
+		float target = blocks[b].m_max;
+
+		//The first block overlaps the skipped DC bins: its max may sit in the skipped region while an
+		//eligible peak hides behind it, so recompute that one candidate over the eligible bins only
+		if(b == 0)
+		{
+			ssize_t end = std::min((ssize_t)CANDIDATE_BLOCK, (ssize_t)nouts);
+			if(end <= minpeak)
+				continue;
+			i = minpeak;
+			target = samples[minpeak];
+			for(ssize_t j=minpeak+1; j<end; j++)
+			{
+				if(samples[j] > target)
+				{
+					target = samples[j];
+					i = j;
+				}
+			}
+		}
+		if(i < minpeak)
+			continue;
+
+		//Candidate is a peak iff nothing else in the search window is >= it
+		ssize_t left = std::max(minpeak, i - search_rad);
+		ssize_t right = std::min(i + search_rad, nend);
+		bool is_peak = true;
+		for(ssize_t ob = left/(ssize_t)CANDIDATE_BLOCK; (ob <= right/(ssize_t)CANDIDATE_BLOCK) && is_peak; ob++)
+		{
+			ssize_t obStart = ob * CANDIDATE_BLOCK;
+			ssize_t obEnd = std::min(obStart + (ssize_t)CANDIDATE_BLOCK, (ssize_t)nouts) - 1;
+
+			//Block entirely inside the window: its precomputed max speaks for all of its samples
+			if( (ob != (ssize_t)b) && (obStart >= left) && (obEnd <= right) )
+			{
+				if(blocks[ob].m_max >= target)
+					is_peak = false;
+			}
+
+			//Own block or partially covered edge block: scan the in-window samples
+			else
+			{
+				ssize_t s0 = std::max(left, obStart);
+				ssize_t s1 = std::min(right, obEnd);
+				for(ssize_t j=s0; j<=s1; j++)
+				{
+					if(j == i)
+						continue;
+					if(samples[j] >= target)
+					{
+						is_peak = false;
+						break;
+					}
+				}
+			}
+		}
+		if(!is_peak)
+			continue;
+
+		//Do a weighted average of our immediate neighbors to fine tune our position
+		ssize_t fine_rad = 10;
+		left = std::max((ssize_t)1, i - fine_rad);
+		right = std::min(i + fine_rad, (ssize_t)nouts-1);
+		double total = 0;
+		double count = 0;
+		for(ssize_t j=left; j<=right; j++)
+		{
+			total += GetSampleTimesIndex(cap, j);
+			count += samples[j];
+		}
+		ssize_t peak_location = round(total / count);
+
+		//Move left and right from the peak until we get half magnitude
+		float hmtarget = (target - baseline)/2 + baseline;
+		ssize_t hmleft = target;
+		ssize_t hmright = target;
+		for(ssize_t j=i; j >= 0; j--)
+		{
+			//TODO: interpolate
+			if(samples[j] <= hmtarget)
+			{
+				hmleft = j;
+				break;
+			}
+		}
+		for(ssize_t j=i; j < (ssize_t)nouts; j++)
+		{
+			//TODO: interpolate
+			if(samples[j] <= hmtarget)
+			{
+				hmright = j;
+				break;
+			}
+		}
+		float fwhm = GetOffsetScaled(cap, hmright) - GetOffsetScaled(cap, hmleft);
+
+		peaks.push_back(Peak(peak_location, target, fwhm));
+	}
+
+	//Sort the peak table and pluck out the requested count
+	std::sort(peaks.rbegin(), peaks.rend(), std::less<Peak>());
+	m_peaks.clear();
+	for(size_t i=0; i<(size_t)max_peaks && i<peaks.size(); i++)
+		m_peaks.push_back(peaks[i]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
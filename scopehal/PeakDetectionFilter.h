@@ -35,6 +35,20 @@
 #ifndef PeakDetectionFilter_h
 #define PeakDetectionFilter_h
 
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+
+class QueueHandle;
+
+/**
+	@brief Arguments to the peak candidate extraction shader
+ */
+struct PeakCandidateArgs
+{
+	///@brief Number of input samples
+	uint32_t npoints;
+};
+
 class Peak
 {
 public:
@@ -61,6 +75,13 @@ public:
 	const std::vector<Peak>& GetPeaks()
 	{ return m_peaks; }
 
+	void FindPeaks(
+		UniformAnalogWaveform* cap,
+		int64_t max_peaks,
+		float search_hz,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
 	template<class T>
 	__attribute__((noinline))
 	void FindPeaks(T* cap, int64_t max_peaks, float search_hz)
@@ -172,6 +193,32 @@ public:
 	}
 
 protected:
+
+	///@brief Number of samples covered by each candidate extraction workgroup (must match the shader)
+	static const size_t CANDIDATE_BLOCK = 64;
+
+	///@brief Below this many samples, GPU dispatch overhead exceeds the cost of the serial CPU scan
+	static const size_t MIN_GPU_PEAK_SAMPLES = 262144;
+
+	///@brief Per-workgroup summary from the candidate extraction shader (layout must match the shader)
+	struct PeakBlockInfo
+	{
+		///@brief Index of the largest sample in the block (first one in case of ties)
+		uint32_t m_idx;
+
+		///@brief Largest sample value in the block
+		float m_max;
+
+		///@brief Smallest sample value in the block (for baseline estimation)
+		float m_min;
+	};
+
+	///@brief Candidate extraction pipeline, allocated on first GPU peak search
+	std::unique_ptr<ComputePipeline> m_candidatePipeline;
+
+	///@brief Per-workgroup candidate output buffer
+	std::unique_ptr<AcceleratorBuffer<PeakBlockInfo>> m_blockInfo;
+
 	std::vector<Peak> m_peaks;
 };
 
@@ -197,6 +244,16 @@ protected:
 			m_parameters[m_peakwindowname].GetFloatVal());
 	}
 
+	void FindPeaks(UniformAnalogWaveform* cap, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue)
+	{
+		PeakDetector::FindPeaks(
+			cap,
+			m_parameters[m_numpeaksname].GetIntVal(),
+			m_parameters[m_peakwindowname].GetFloatVal(),
+			cmdBuf,
+			queue);
+	}
+
 	std::string m_numpeaksname;
 	std::string m_peakwindowname;
 };
@@ -42,6 +42,7 @@ using namespace std;
 
 
 extern bool g_hasDebugUtils;
+extern bool g_hasTimelineSemaphores;
 
 
 QueueHandle::QueueHandle(std::shared_ptr<vk::raii::Device> device, size_t family, size_t index, string name)
@@ -52,13 +53,32 @@ QueueHandle::QueueHandle(std::shared_ptr<vk::raii::Device> device, size_t family
 , m_device(device)
 , m_queue(make_unique<vk::raii::Queue>(*device, family, index))
 , m_fence(nullptr)
+, m_timelineSemaphore(nullptr)
+, m_timelineValue(0)
+, m_batching(false)
 {
+	//Use one persistent timeline semaphore rather than a fence per submission when the device supports it.
+	//This lets dependent submissions on the same queue go out back-to-back: ordering comes from queue
+	//submission order, and the CPU only has to wait when someone actually needs the results.
+	if(g_hasTimelineSemaphores)
+	{
+		vk::SemaphoreTypeCreateInfo stinfo(vk::SemaphoreType::eTimeline, 0);
+		vk::SemaphoreCreateInfo sinfo;
+		sinfo.pNext = &stinfo;
+		m_timelineSemaphore = make_unique<vk::raii::Semaphore>(*device, sinfo);
+	}
+
 	AddName(name);
 }
 
 QueueHandle::~QueueHandle()
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
+
+	//Make sure any outstanding work has retired before tearing down the queue
+	_waitFence();
+
+	m_timelineSemaphore = nullptr;
 	m_fence = nullptr;
 	m_queue = nullptr;
 	m_device = nullptr;
@@ -79,6 +99,15 @@ void QueueHandle::AddName(string name)
 				vk::ObjectType::eQueue,
 				reinterpret_cast<uint64_t>(static_cast<VkQueue>(**m_queue)),
 				m_name.c_str()));
+
+		if(m_timelineSemaphore)
+		{
+			m_device->setDebugUtilsObjectNameEXT(
+				vk::DebugUtilsObjectNameInfoEXT(
+					vk::ObjectType::eSemaphore,
+					reinterpret_cast<uint64_t>(static_cast<VkSemaphore>(**m_timelineSemaphore)),
+					m_name.c_str()));
+		}
 	}
 }
 
@@ -86,6 +115,13 @@ void QueueHandle::Submit(vk::raii::CommandBuffer const& cmdBuf)
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
 
+	//Timeline path: no CPU wait, ordering with previous submissions comes from queue submission order
+	if(m_timelineSemaphore)
+	{
+		_submitTimeline({*cmdBuf});
+		return;
+	}
+
 	_waitFence();
 
 	vk::SubmitInfo info({}, {}, *cmdBuf);
@@ -105,6 +141,21 @@ void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
 {
 	const lock_guard<recursive_mutex> lock(m_mutex);
 
+	//If a batch is open, just enqueue the buffer; the submission and completion wait happen in EndBatch()
+	if(m_batching)
+	{
+		m_batchedBuffers.push_back(*cmdBuf);
+		return;
+	}
+
+	//Timeline path: submit then wait for our own value
+	//(which implies everything before us on the queue has retired too)
+	if(m_timelineSemaphore)
+	{
+		WaitUntil(_submitTimeline({*cmdBuf}));
+		return;
+	}
+
 	_waitFence();
 
 	vk::SubmitInfo info({}, {}, *cmdBuf);
@@ -121,8 +172,96 @@ void QueueHandle::SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf)
 	_waitFence();
 }
 
+/**
+	@brief Submits the given command buffer without blocking and returns a completion handle
+
+	The submission executes after all prior work on this queue. Pass the return value to WaitUntil() when the
+	results are actually needed; back-to-back SubmitChained() calls keep the queue fed with no CPU round trips
+	in between.
+
+	On devices without timeline semaphores this degrades to Submit() followed by a full wait in WaitUntil().
+ */
+uint64_t QueueHandle::SubmitChained(vk::raii::CommandBuffer const& cmdBuf)
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+
+	if(m_timelineSemaphore)
+		return _submitTimeline({*cmdBuf});
+
+	Submit(cmdBuf);
+	return 0;
+}
+
+/**
+	@brief Blocks until the submission identified by the given SubmitChained() return value has completed
+ */
+void QueueHandle::WaitUntil(uint64_t value)
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+
+	if(!m_timelineSemaphore)
+	{
+		//Fallback path: all we can do is drain the queue
+		_waitFence();
+		return;
+	}
+
+	vk::Semaphore sem = **m_timelineSemaphore;
+	vk::SemaphoreWaitInfo winfo;
+	winfo.semaphoreCount = 1;
+	winfo.pSemaphores = &sem;
+	winfo.pValues = &value;
+	while(vk::Result::eTimeout == m_device->waitSemaphores(winfo, 1000 * 1000))
+	{}
+}
+
+void QueueHandle::BeginBatch()
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+	m_batching = true;
+}
+
+void QueueHandle::EndBatch()
+{
+	const lock_guard<recursive_mutex> lock(m_mutex);
+	m_batching = false;
+
+	if(m_batchedBuffers.empty())
+		return;
+
+	//Timeline path: one submission and one host wait for the entire batch
+	if(m_timelineSemaphore)
+	{
+		WaitUntil(_submitTimeline(m_batchedBuffers));
+		m_batchedBuffers.clear();
+		return;
+	}
+
+	_waitFence();
+
+	//One submission and one fence for the entire batch
+	vk::SubmitInfo info({}, {}, m_batchedBuffers);
+	m_fence = make_unique<vk::raii::Fence>(*m_device, vk::FenceCreateInfo());
+	if(g_hasDebugUtils)
+	{
+		m_device->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eFence,
+				reinterpret_cast<uint64_t>(static_cast<VkFence>(**m_fence)),
+				m_name.c_str()));
+	}
+	m_queue->submit(info, **m_fence);
+	_waitFence();
+
+	m_batchedBuffers.clear();
+}
+
 void QueueHandle::_waitFence()
 {
+	//Wait for the last timeline value we signaled, if any work was submitted that way
+	if(m_timelineSemaphore && (m_timelineValue != 0))
+		WaitUntil(m_timelineValue);
+
 	if(!m_fence)
 		return;
 
@@ -133,6 +272,23 @@ void QueueHandle::_waitFence()
 	m_fence = nullptr;
 }
 
+uint64_t QueueHandle::_submitTimeline(const vector<vk::CommandBuffer>& bufs)
+{
+	uint64_t value = ++m_timelineValue;
+
+	vk::Semaphore sem = **m_timelineSemaphore;
+	vk::TimelineSemaphoreSubmitInfo tsInfo;
+	tsInfo.signalSemaphoreValueCount = 1;
+	tsInfo.pSignalSemaphoreValues = &value;
+	vk::SubmitInfo info({}, {}, bufs);
+	info.signalSemaphoreCount = 1;
+	info.pSignalSemaphores = &sem;
+	info.pNext = &tsInfo;
+	m_queue->submit(info);
+
+	return value;
+}
+
 
 QueueManager::QueueManager(vk::raii::PhysicalDevice* phys, std::shared_ptr<vk::raii::Device> device)
 : m_phys(phys)
@@ -63,6 +63,16 @@ public:
 	/// Submit the given command buffer on the queue and wait until completion
 	void SubmitAndBlock(vk::raii::CommandBuffer const& cmdBuf);
 
+	/// Submit the given command buffer without blocking and return a value to pass to WaitUntil()
+	uint64_t SubmitChained(vk::raii::CommandBuffer const& cmdBuf);
+	/// Block until the submission identified by the given SubmitChained() return value has completed
+	void WaitUntil(uint64_t value);
+
+	/// Begin a batch: subsequent SubmitAndBlock() calls enqueue their buffers rather than submitting immediately
+	void BeginBatch();
+	/// Submit all command buffers batched since BeginBatch() in one queue submission and wait until all have completed
+	void EndBatch();
+
 	const std::string& GetName() const
 	{ return m_name; }
 
@@ -72,10 +82,14 @@ public:
 	QueueHandle& operator=(QueueHandle const&) = delete;
 
 protected:
-	/// Waits for previous submit's fence, if any, then resets the fence for reuse.
+	/// Waits for all previous submits to complete (fence and/or timeline semaphore).
 	/// Must obtain the lock before calling!
 	void _waitFence();
 
+	/// Submits the given raw command buffers, signaling the timeline semaphore, and returns the signaled value.
+	/// Must obtain the lock before calling, and only if the timeline semaphore exists!
+	uint64_t _submitTimeline(const std::vector<vk::CommandBuffer>& bufs);
+
 public:
 	const size_t m_family;
 	const size_t m_index;
@@ -87,6 +101,16 @@ protected:
 	std::shared_ptr<vk::raii::Device> m_device;
 	std::unique_ptr<vk::raii::Queue> m_queue;
 	std::unique_ptr<vk::raii::Fence> m_fence;
+
+	/// Timeline semaphore signaled by each submission on this queue (null if the device lacks timeline semaphores)
+	std::unique_ptr<vk::raii::Semaphore> m_timelineSemaphore;
+	/// Timeline value signaled by the most recent submission
+	uint64_t m_timelineValue;
+
+	/// True if a batch is open (SubmitAndBlock defers to the batch)
+	bool m_batching;
+	/// Command buffers accumulated since BeginBatch()
+	std::vector<vk::CommandBuffer> m_batchedBuffers;
 };
 
 
@@ -801,54 +801,74 @@ bool RSRTO6Oscilloscope::AcquireData()
 
 		LogDebug(" - Begin transfer of %zu bytes\n", length);
 
-		while (transferred != length)
+		//Segmented streaming transfer: every chunk query is sent one reply ahead of its read, so the scope
+		//is exporting chunk k+1 and the network pipe is filling while we validate and copy chunk k, instead
+		//of the link idling for a full round trip between chunks.
+		//Hold the transport mutex across the whole send/read sequence so no other thread's traffic can
+		//interleave with the in-flight replies.
 		{
-			size_t this_length = block_size;
-			if (this_length > (length - transferred))
-				this_length = length - transferred;
+			lock_guard<recursive_mutex> tlock(m_transport->GetMutex());
 
-			string params =  " "+to_string(transferred)+","+to_string(this_length);
+			//Carve the record into chunks of (start, length) in samples
+			vector<pair<size_t, size_t>> chunks;
+			for(size_t start=0; start < length; start += block_size)
+				chunks.push_back(pair<size_t, size_t>(start, min(block_size, length - start)));
 
-			if (transferred == 0 && this_length == length)
-				params = "";
+			auto sendChunkQuery = [&](size_t k)
+			{
+				string params =  " "+to_string(chunks[k].first)+","+to_string(chunks[k].second);
+				if (chunks[k].first == 0 && chunks[k].second == length)
+					params = "";
+				LogDebug("[%3d%%] Query ...`DATA?%s` (B)\n",
+					(int)(100*((float)chunks[k].first/(float)length)), params.c_str());
+				m_transport->SendCommandImmediate(m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI");
+			};
+			sendChunkQuery(0);
+
+			for(size_t k=0; k<chunks.size(); k++)
+			{
+				size_t this_length = chunks[k].second;
 
-			LogDebug("[%3d%%] Query ...`DATA?%s` (B)\n", (int)(100*((float)transferred/(float)length)), params.c_str());
+				//Collect the reply that's already in flight
+				size_t len_bytes;
+				unsigned char* samples = (unsigned char*)m_transport->ReadRawBlockReply(len_bytes);
 
-			//Ask for the data
-			size_t len_bytes;
-			unsigned char* samples = (unsigned char*)m_transport->SendCommandImmediateWithRawBlockReply(m_channels[i]->GetHwname() + ":DATA?"+params+"; *WAI", len_bytes);
+				//Request the next chunk before touching this one, so the link stays busy during the copy
+				if (k+1 < chunks.size())
+					sendChunkQuery(k+1);
 
-			if (len_bytes != (this_length*sizeof(float)))
-			{
-				LogError("Unexpected number of bytes back; aborting acquisition");
-				std::this_thread::sleep_for(std::chrono::microseconds(100000));
-				m_transport->FlushRXBuffer();
+				if (len_bytes != (this_length*sizeof(float)))
+				{
+					LogError("Unexpected number of bytes back; aborting acquisition");
+					std::this_thread::sleep_for(std::chrono::microseconds(100000));
+					m_transport->FlushRXBuffer();
 
-				delete cap;
+					delete cap;
 
-				for (auto* c : pending_waveforms[i])
-				{
-					delete c;
-				}
+					for (auto* c : pending_waveforms[i])
+					{
+						delete c;
+					}
 
-				delete[] samples;
+					delete[] samples;
 
-				return false;
-			}
+					return false;
+				}
 
-			unsigned char* cpy_target = dest_buf+(transferred*sizeof(float));
-			// LogDebug("Copying %zuB from %p to %p\n", len_bytes, samples, cpy_target);
+				unsigned char* cpy_target = dest_buf+(chunks[k].first*sizeof(float));
+				// LogDebug("Copying %zuB from %p to %p\n", len_bytes, samples, cpy_target);
 
-			memcpy(cpy_target, samples, len_bytes);
-			transferred += this_length;
-			delete[] samples;
+				memcpy(cpy_target, samples, len_bytes);
+				transferred += this_length;
+				delete[] samples;
 
-			//Discard trailing newline
-			uint8_t disregard;
-			m_transport->ReadRawData(1, &disregard);
+				//Discard trailing newline
+				uint8_t disregard;
+				m_transport->ReadRawData(1, &disregard);
+			}
 		}
 
-		LogDebug("[100%%] Done\n");
+		LogDebug("[100%%] Done (%zu samples)\n", transferred);
 
 		cap->MarkSamplesModifiedFromCpu();
 
@@ -976,7 +996,7 @@ bool RSRTO6Oscilloscope::AcquireData()
 				if(IsChannelEnabled(j))
 					s[m_channels[j]] = pending_waveforms[j][i];
 			}
-			m_pendingWaveforms.push_back(s);
+			AddPendingWaveform(s);
 		}
 		m_pendingWaveformsMutex.unlock();
 	}
@@ -0,0 +1,329 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RawSampleConverter
+	@ingroup vksupport
+ */
+
+#include "scopehal.h"
+#include "RawSampleConverter.h"
+#include "SampleConversion.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a sample converter
+
+	@param name	Human readable name (typically the driver class name), used for queue allocation and debug names
+ */
+RawSampleConverter::RawSampleConverter(const string& name)
+	: m_recording(false)
+	, m_anyGpuWork(false)
+{
+	//If the GPU can't run any of our conversion shaders, don't bother creating Vulkan objects.
+	//Conversions will fall back to the CPU helpers.
+	if(!g_hasPushDescriptor)
+		return;
+	if(!g_hasShaderInt8 && !g_hasShaderInt16)
+		return;
+
+	m_queue = g_vkQueueManager->GetComputeQueue(name + ".queue");
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		m_queue->m_family );
+	m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+
+	vk::CommandBufferAllocateInfo bufinfo(**m_pool, vk::CommandBufferLevel::ePrimary, 1);
+	m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
+		std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+	if(g_hasDebugUtils)
+	{
+		string poolname = name + ".pool";
+		string bufname = name + ".cmdbuf";
+
+		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eCommandPool,
+				reinterpret_cast<uint64_t>(static_cast<VkCommandPool>(**m_pool)),
+				poolname.c_str()));
+
+		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eCommandBuffer,
+				reinterpret_cast<uint64_t>(static_cast<VkCommandBuffer>(**m_cmdBuf)),
+				bufname.c_str()));
+	}
+
+	if(g_hasShaderInt8)
+	{
+		m_pipeline8Bit = make_unique<ComputePipeline>(
+			"shaders/Convert8BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
+		m_pipelineInterleaved8Bit = make_unique<ComputePipeline>(
+			"shaders/Convert8BitInterleavedSamples.spv", 2, sizeof(ConvertInterleavedSamplesShaderArgs) );
+	}
+	if(g_hasShaderInt16)
+	{
+		m_pipeline16Bit = make_unique<ComputePipeline>(
+			"shaders/Convert16BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
+		m_pipelineInterleaved16Bit = make_unique<ComputePipeline>(
+			"shaders/Convert16BitInterleavedSamples.spv", 2, sizeof(ConvertInterleavedSamplesShaderArgs) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Conversion
+
+/**
+	@brief Starts recording a batch of conversions, which will be submitted to the GPU in one go by End()
+ */
+void RawSampleConverter::Begin()
+{
+	m_anyGpuWork = false;
+
+	if(m_cmdBuf)
+	{
+		m_cmdBuf->begin({});
+		m_recording = true;
+	}
+}
+
+/**
+	@brief Submits any recorded conversions to the GPU and blocks until they complete
+ */
+void RawSampleConverter::End()
+{
+	if(!m_recording)
+		return;
+
+	m_cmdBuf->end();
+	if(m_anyGpuWork)
+		m_queue->SubmitAndBlock(*m_cmdBuf);
+	m_recording = false;
+}
+
+/**
+	@brief Converts raw int8 ADC samples to floating point (dout = din*gain - offset)
+
+	@param dout		Output sample buffer
+	@param din		Input sample buffer
+	@param gain		System gain in volts per ADC code
+	@param offset	Offset in volts
+	@param count	Number of samples to convert
+ */
+void RawSampleConverter::Convert8BitSamples(
+	AcceleratorBuffer<float>& dout, AcceleratorBuffer<int8_t>& din, float gain, float offset, size_t count)
+{
+	if(m_pipeline8Bit)
+	{
+		//One-shot conversion outside a batch? Make a single-dispatch batch of our own
+		bool oneshot = !m_recording;
+		if(oneshot)
+			Begin();
+
+		m_pipeline8Bit->BindBufferNonblocking(0, dout, *m_cmdBuf, true);
+		m_pipeline8Bit->BindBufferNonblocking(1, din, *m_cmdBuf);
+
+		ConvertRawSamplesShaderArgs args;
+		args.size = count;
+		args.gain = gain;
+		args.offset = offset;
+
+		m_pipeline8Bit->Dispatch(*m_cmdBuf, args, GetComputeBlockCount(count, 64));
+		m_anyGpuWork = true;
+
+		dout.MarkModifiedFromGpu();
+
+		if(oneshot)
+			End();
+	}
+
+	else
+	{
+		din.PrepareForCpuAccess();
+		dout.PrepareForCpuAccess();
+		Oscilloscope::Convert8BitSamples(dout.GetCpuPointer(), din.GetCpuPointer(), gain, offset, count);
+		dout.MarkModifiedFromCpu();
+	}
+}
+
+/**
+	@brief Converts raw int16 ADC samples to floating point (dout = din*gain - offset)
+
+	@param dout		Output sample buffer
+	@param din		Input sample buffer
+	@param gain		System gain in volts per ADC code
+	@param offset	Offset in volts
+	@param count	Number of samples to convert
+ */
+void RawSampleConverter::Convert16BitSamples(
+	AcceleratorBuffer<float>& dout, AcceleratorBuffer<int16_t>& din, float gain, float offset, size_t count)
+{
+	if(m_pipeline16Bit)
+	{
+		bool oneshot = !m_recording;
+		if(oneshot)
+			Begin();
+
+		m_pipeline16Bit->BindBufferNonblocking(0, dout, *m_cmdBuf, true);
+		m_pipeline16Bit->BindBufferNonblocking(1, din, *m_cmdBuf);
+
+		ConvertRawSamplesShaderArgs args;
+		args.size = count;
+		args.gain = gain;
+		args.offset = offset;
+
+		m_pipeline16Bit->Dispatch(*m_cmdBuf, args, GetComputeBlockCount(count, 64));
+		m_anyGpuWork = true;
+
+		dout.MarkModifiedFromGpu();
+
+		if(oneshot)
+			End();
+	}
+
+	else
+	{
+		din.PrepareForCpuAccess();
+		dout.PrepareForCpuAccess();
+		Oscilloscope::Convert16BitSamples(dout.GetCpuPointer(), din.GetCpuPointer(), gain, offset, count);
+		dout.MarkModifiedFromCpu();
+	}
+}
+
+/**
+	@brief De-interleaves and converts raw int8 ADC samples to floating point (dout[i] = din[i*stride + phase]*gain - offset)
+
+	Extracts one channel from a time-multiplexed multi-ADC stream, fused with the scaling pass so reassembly
+	never touches memory twice. Call once per channel (phase) against the same interleaved input buffer.
+
+	@param dout		Output sample buffer
+	@param din		Interleaved input sample buffer, holding at least count*stride samples
+	@param gain		System gain in volts per ADC code
+	@param offset	Offset in volts
+	@param count	Number of output samples to produce
+	@param stride	Interleave factor (number of channels muxed into the stream)
+	@param phase	Index of the desired channel's first sample within the stream
+ */
+void RawSampleConverter::Convert8BitInterleavedSamples(
+	AcceleratorBuffer<float>& dout, AcceleratorBuffer<int8_t>& din,
+	float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	if(m_pipelineInterleaved8Bit)
+	{
+		//One-shot conversion outside a batch? Make a single-dispatch batch of our own
+		bool oneshot = !m_recording;
+		if(oneshot)
+			Begin();
+
+		m_pipelineInterleaved8Bit->BindBufferNonblocking(0, dout, *m_cmdBuf, true);
+		m_pipelineInterleaved8Bit->BindBufferNonblocking(1, din, *m_cmdBuf);
+
+		ConvertInterleavedSamplesShaderArgs args;
+		args.size = count;
+		args.stride = stride;
+		args.phase = phase;
+		args.gain = gain;
+		args.offset = offset;
+
+		m_pipelineInterleaved8Bit->Dispatch(*m_cmdBuf, args, GetComputeBlockCount(count, 64));
+		m_anyGpuWork = true;
+
+		dout.MarkModifiedFromGpu();
+
+		if(oneshot)
+			End();
+	}
+
+	else
+	{
+		din.PrepareForCpuAccess();
+		dout.PrepareForCpuAccess();
+		ConvertInterleavedSamples(dout.GetCpuPointer(), din.GetCpuPointer(), gain, offset, count, stride, phase);
+		dout.MarkModifiedFromCpu();
+	}
+}
+
+/**
+	@brief De-interleaves and converts raw int16 ADC samples to floating point (dout[i] = din[i*stride + phase]*gain - offset)
+
+	Extracts one channel from a time-multiplexed multi-ADC stream, fused with the scaling pass so reassembly
+	never touches memory twice. Call once per channel (phase) against the same interleaved input buffer.
+
+	@param dout		Output sample buffer
+	@param din		Interleaved input sample buffer, holding at least count*stride samples
+	@param gain		System gain in volts per ADC code
+	@param offset	Offset in volts
+	@param count	Number of output samples to produce
+	@param stride	Interleave factor (number of channels muxed into the stream)
+	@param phase	Index of the desired channel's first sample within the stream
+ */
+void RawSampleConverter::Convert16BitInterleavedSamples(
+	AcceleratorBuffer<float>& dout, AcceleratorBuffer<int16_t>& din,
+	float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	if(m_pipelineInterleaved16Bit)
+	{
+		bool oneshot = !m_recording;
+		if(oneshot)
+			Begin();
+
+		m_pipelineInterleaved16Bit->BindBufferNonblocking(0, dout, *m_cmdBuf, true);
+		m_pipelineInterleaved16Bit->BindBufferNonblocking(1, din, *m_cmdBuf);
+
+		ConvertInterleavedSamplesShaderArgs args;
+		args.size = count;
+		args.stride = stride;
+		args.phase = phase;
+		args.gain = gain;
+		args.offset = offset;
+
+		m_pipelineInterleaved16Bit->Dispatch(*m_cmdBuf, args, GetComputeBlockCount(count, 64));
+		m_anyGpuWork = true;
+
+		dout.MarkModifiedFromGpu();
+
+		if(oneshot)
+			End();
+	}
+
+	else
+	{
+		din.PrepareForCpuAccess();
+		dout.PrepareForCpuAccess();
+		ConvertInterleavedSamples(dout.GetCpuPointer(), din.GetCpuPointer(), gain, offset, count, stride, phase);
+		dout.MarkModifiedFromCpu();
+	}
+}
@@ -0,0 +1,120 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RawSampleConverter
+	@ingroup vksupport
+ */
+
+#ifndef RawSampleConverter_h
+#define RawSampleConverter_h
+
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+#include "QueueManager.h"
+
+/**
+	@brief Helper for converting raw int8/int16 ADC codes to fp32 samples, preferring the GPU when possible
+
+	Wraps the Vulkan queue, command buffer, and compute pipeline boilerplate needed to run the
+	Convert8BitSamples / Convert16BitSamples shaders, so that a driver's AcquireData() can hand raw sample buffers
+	straight to the GPU without the samples ever existing as floats in host memory. The interleaved variants
+	additionally de-interleave channel-interleaved multi-ADC streams in the same kernel, so reassembly costs one
+	strided gather rather than a separate scalar pass.
+
+	If the GPU lacks the required integer support (or push descriptors), conversion transparently falls back to the
+	vectorized CPU helpers in Oscilloscope.
+
+	Call Begin() before the first conversion of a waveform set and End() after the last one to batch all of the
+	dispatches into a single queue submission. Conversions made outside a Begin()/End() block are submitted
+	individually.
+
+	@ingroup vksupport
+ */
+class RawSampleConverter
+{
+public:
+	RawSampleConverter(const std::string& name);
+
+	void Begin();
+	void End();
+
+	void Convert8BitSamples(
+		AcceleratorBuffer<float>& dout, AcceleratorBuffer<int8_t>& din, float gain, float offset, size_t count);
+	void Convert16BitSamples(
+		AcceleratorBuffer<float>& dout, AcceleratorBuffer<int16_t>& din, float gain, float offset, size_t count);
+
+	void Convert8BitInterleavedSamples(
+		AcceleratorBuffer<float>& dout, AcceleratorBuffer<int8_t>& din,
+		float gain, float offset, size_t count, size_t stride, size_t phase);
+	void Convert16BitInterleavedSamples(
+		AcceleratorBuffer<float>& dout, AcceleratorBuffer<int16_t>& din,
+		float gain, float offset, size_t count, size_t stride, size_t phase);
+
+	///@brief Returns true if 8-bit conversions will run on the GPU
+	bool IsGpuAccelerated8Bit() const
+	{ return m_pipeline8Bit != nullptr; }
+
+	///@brief Returns true if 16-bit conversions will run on the GPU
+	bool IsGpuAccelerated16Bit() const
+	{ return m_pipeline16Bit != nullptr; }
+
+protected:
+
+	///@brief Vulkan queue used for sample conversion
+	std::shared_ptr<QueueHandle> m_queue;
+
+	///@brief Command pool from which m_cmdBuf was allocated
+	std::unique_ptr<vk::raii::CommandPool> m_pool;
+
+	///@brief Command buffer for sample conversion
+	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
+
+	///@brief Compute pipeline for converting int8 ADC codes to float32 samples (null if GPU lacks int8 support)
+	std::unique_ptr<ComputePipeline> m_pipeline8Bit;
+
+	///@brief Compute pipeline for converting int16 ADC codes to float32 samples (null if GPU lacks int16 support)
+	std::unique_ptr<ComputePipeline> m_pipeline16Bit;
+
+	///@brief Compute pipeline for de-interleaving and converting int8 ADC codes (null if GPU lacks int8 support)
+	std::unique_ptr<ComputePipeline> m_pipelineInterleaved8Bit;
+
+	///@brief Compute pipeline for de-interleaving and converting int16 ADC codes (null if GPU lacks int16 support)
+	std::unique_ptr<ComputePipeline> m_pipelineInterleaved16Bit;
+
+	///@brief True if we're recording a Begin()/End() batch
+	bool m_recording;
+
+	///@brief True if at least one dispatch was recorded in the current batch
+	bool m_anyGpuWork;
+};
+
+#endif
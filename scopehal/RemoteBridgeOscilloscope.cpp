@@ -53,6 +53,8 @@ void RemoteBridgeOscilloscope::Start()
 	lock_guard<recursive_mutex> lock(m_mutex);
 	m_transport->SendCommand("START");
 
+	LatencyTracer::GetInstance().RecordInstant("trigger", m_nickname + " armed");
+
 	m_triggerArmed = true;
 	m_triggerOneShot = false;
 }
@@ -62,6 +64,8 @@ void RemoteBridgeOscilloscope::StartSingleTrigger()
 	lock_guard<recursive_mutex> lock(m_mutex);
 	m_transport->SendCommand("SINGLE");
 
+	LatencyTracer::GetInstance().RecordInstant("trigger", m_nickname + " armed");
+
 	m_triggerArmed = true;
 	m_triggerOneShot = true;
 }
@@ -78,6 +82,9 @@ void RemoteBridgeOscilloscope::ForceTrigger()
 {
 	lock_guard<recursive_mutex> lock(m_mutex);
 	m_transport->SendCommand("FORCE");
+
+	LatencyTracer::GetInstance().RecordInstant("trigger", m_nickname + " forced");
+
 	m_triggerArmed = true;
 	m_triggerOneShot = true;
 }
@@ -994,7 +994,7 @@ bool RigolOscilloscope::AcquireData()
 			if(pending_waveforms.count(j) > 0)
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
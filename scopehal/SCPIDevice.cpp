@@ -36,6 +36,7 @@ using namespace std;
 
 SCPIDevice::SCPIDevice(SCPITransport* transport, bool identify)
 	: m_transport(transport)
+	, m_idnMatchesCache(false)
 {
 	if(identify)
 	{
@@ -60,6 +61,20 @@ SCPIDevice::SCPIDevice(SCPITransport* transport, bool identify)
 			m_serial = serial;
 			m_fwVersion = version;
 
+			//Compare against the identity this address reported last session. An unchanged reply means the
+			//same instrument on the same firmware is at the other end, so anything a driver discovered and
+			//cached about it (options, limits, channel config) is still valid and reconnect probing can be
+			//skipped. The *IDN? round trip we just spent is the validity check.
+			if(g_instrumentCapabilityCache)
+			{
+				auto addr = m_transport->GetConnectionString();
+				string cachedIdn;
+				if(g_instrumentCapabilityCache->LookupAddress(addr, cachedIdn) && (cachedIdn == reply))
+					m_idnMatchesCache = true;
+				else
+					g_instrumentCapabilityCache->StoreAddress(addr, reply);
+			}
+
 			succeeded = true;
 			m_transport->FlushRXBuffer(); // In case our *IDNs got queued behind each other (Tek...)
 			break; // success
@@ -42,9 +42,21 @@ public:
 	SCPITransport* GetTransport() const
 	{ return m_transport; }
 
+	/**
+		@brief Returns true if this address reported the same *IDN? string last session
+
+		When true, the same instrument (model, serial, and firmware) is on the other end as last time, so
+		per-address capabilities a driver cached previously are still valid and don't need re-probing.
+	 */
+	bool IdnMatchesCache() const
+	{ return m_idnMatchesCache; }
+
 protected:
 	SCPITransport* m_transport;
 
+	///@brief True if the *IDN? reply matched the cached identity record for this address
+	bool m_idnMatchesCache;
+
 	//standard *IDN? fields
 	std::string m_vendor;
 	std::string m_model;
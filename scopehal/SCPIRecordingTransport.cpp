@@ -0,0 +1,185 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Implementation of SCPIRecordingTransport
+	@ingroup transports
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Creates a recording transport from a connection string
+
+	@param args		Dump file path, inner transport name, and inner transport arguments, separated by pipes
+ */
+SCPIRecordingTransport::SCPIRecordingTransport(const string& args)
+	: m_inner(nullptr)
+	, m_fp(nullptr)
+{
+	auto fields = explode(args, '|');
+	if(fields.size() < 2)
+	{
+		LogError("SCPIRecordingTransport expects \"file|transport|args\", got \"%s\"\n", args.c_str());
+		return;
+	}
+	m_path = fields[0];
+	string innerArgs = (fields.size() >= 3) ? fields[2] : "";
+
+	m_inner = SCPITransport::CreateTransport(fields[1], innerArgs);
+	if(!m_inner)
+	{
+		LogError("SCPIRecordingTransport failed to create inner transport \"%s\"\n", fields[1].c_str());
+		return;
+	}
+
+	m_fp = fopen(m_path.c_str(), "wb");
+	if(!m_fp)
+		LogError("SCPIRecordingTransport failed to create dump file \"%s\"\n", m_path.c_str());
+}
+
+/**
+	@brief Wraps an existing transport, recording its traffic to the given file
+
+	@param inner	Transport to wrap (ownership is taken)
+	@param path		Path to the dump file to create
+ */
+SCPIRecordingTransport::SCPIRecordingTransport(SCPITransport* inner, const string& path)
+	: m_inner(inner)
+	, m_fp(nullptr)
+	, m_path(path)
+{
+	m_fp = fopen(m_path.c_str(), "wb");
+	if(!m_fp)
+		LogError("SCPIRecordingTransport failed to create dump file \"%s\"\n", m_path.c_str());
+}
+
+SCPIRecordingTransport::~SCPIRecordingTransport()
+{
+	if(m_fp)
+		fclose(m_fp);
+	delete m_inner;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Recording
+
+///@brief Appends one record (type marker, little-endian uint64 length, payload) to the dump
+void SCPIRecordingTransport::WriteRecord(char type, const void* payload, size_t len)
+{
+	if(!m_fp)
+		return;
+
+	lock_guard<mutex> lock(m_recordMutex);
+	uint64_t len64 = len;
+	fwrite(&type, 1, 1, m_fp);
+	fwrite(&len64, sizeof(len64), 1, m_fp);
+	if(len)
+		fwrite(payload, 1, len, m_fp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual transport code
+
+string SCPIRecordingTransport::GetTransportName()
+{
+	return "record";
+}
+
+string SCPIRecordingTransport::GetConnectionString()
+{
+	if(m_inner)
+		return m_path + "|" + m_inner->GetName() + "|" + m_inner->GetConnectionString();
+	return m_path;
+}
+
+bool SCPIRecordingTransport::IsConnected()
+{
+	return m_inner && m_inner->IsConnected();
+}
+
+bool SCPIRecordingTransport::IsCommandBatchingSupported()
+{
+	return m_inner && m_inner->IsCommandBatchingSupported();
+}
+
+void SCPIRecordingTransport::FlushRXBuffer()
+{
+	if(m_inner)
+		m_inner->FlushRXBuffer();
+}
+
+bool SCPIRecordingTransport::SendCommand(const string& cmd)
+{
+	if(!m_inner)
+		return false;
+
+	WriteRecord('C', cmd.c_str(), cmd.length());
+	return m_inner->SendCommand(cmd);
+}
+
+string SCPIRecordingTransport::ReadReply(bool endOnSemicolon, function<void(float)> progress)
+{
+	if(!m_inner)
+		return "";
+
+	auto reply = m_inner->ReadReply(endOnSemicolon, progress);
+	WriteRecord('R', reply.c_str(), reply.length());
+	return reply;
+}
+
+size_t SCPIRecordingTransport::ReadRawData(size_t len, unsigned char* buf, function<void(float)> progress)
+{
+	if(!m_inner)
+		return 0;
+
+	auto n = m_inner->ReadRawData(len, buf, progress);
+	WriteRecord('D', buf, n);
+	return n;
+}
+
+void SCPIRecordingTransport::SendRawData(size_t len, const unsigned char* buf)
+{
+	if(!m_inner)
+		return;
+
+	WriteRecord('W', buf, len);
+	m_inner->SendRawData(len, buf);
+}
@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Declaration of SCPIRecordingTransport
+	@ingroup transports
+ */
+
+#ifndef SCPIRecordingTransport_h
+#define SCPIRecordingTransport_h
+
+/**
+	@brief Decorator transport which records all traffic through an inner transport to a dump file
+
+	The dump can later be played back with SCPIReplayTransport to exercise driver parse paths (waveform
+	descriptors, block downloads, etc.) without the instrument, for offline debugging and benchmarking.
+
+	Connection string syntax: "capture.scpirec|lan|192.0.2.10:5025" (dump file, inner transport name,
+	inner transport arguments, separated by pipes since inner arguments may contain colons and commas).
+
+	Dump file format: a sequence of records, each consisting of a one byte type marker ('C' = command,
+	'R' = reply, 'W' = raw write, 'D' = raw read data), a little-endian uint64 payload length, and the payload.
+
+	@ingroup transports
+ */
+class SCPIRecordingTransport : public SCPITransport
+{
+public:
+	SCPIRecordingTransport(const std::string& args);
+	SCPIRecordingTransport(SCPITransport* inner, const std::string& path);
+	virtual ~SCPIRecordingTransport();
+
+	virtual std::string GetConnectionString() override;
+	static std::string GetTransportName();
+
+	virtual void FlushRXBuffer() override;
+	virtual bool SendCommand(const std::string& cmd) override;
+	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	virtual bool IsCommandBatchingSupported() override;
+	virtual bool IsConnected() override;
+
+	///@brief Returns the transport actually moving the data
+	SCPITransport* GetInnerTransport()
+	{ return m_inner; }
+
+	TRANSPORT_INITPROC(SCPIRecordingTransport)
+
+protected:
+	void WriteRecord(char type, const void* payload, size_t len);
+
+	///@brief The wrapped transport (owned by us)
+	SCPITransport* m_inner;
+
+	///@brief The dump file being written
+	FILE* m_fp;
+
+	///@brief Path to the dump file
+	std::string m_path;
+
+	///@brief Serializes record writes (reads and writes can come from different threads)
+	std::mutex m_recordMutex;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Implementation of SCPIReplayTransport
+	@ingroup transports
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Loads a traffic dump for replay
+
+	@param args		Path to a dump file created by SCPIRecordingTransport
+ */
+SCPIReplayTransport::SCPIReplayTransport(const string& args)
+	: m_path(args)
+	, m_cursor(0)
+	, m_rawReadOffset(0)
+{
+	FILE* fp = fopen(m_path.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("SCPIReplayTransport failed to open dump file \"%s\"\n", m_path.c_str());
+		return;
+	}
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	m_data.resize(size);
+	if(size && (1 != fread(&m_data[0], size, 1, fp)) )
+	{
+		LogError("SCPIReplayTransport failed to read dump file \"%s\"\n", m_path.c_str());
+		m_data.clear();
+	}
+	fclose(fp);
+
+	//Build the record index
+	size_t pos = 0;
+	while( (pos + 9) <= m_data.size() )
+	{
+		Record rec;
+		rec.m_type = m_data[pos];
+		uint64_t len;
+		memcpy(&len, &m_data[pos + 1], sizeof(len));
+		rec.m_offset = pos + 9;
+		rec.m_length = len;
+		if( (rec.m_offset + rec.m_length) > m_data.size() )
+		{
+			LogWarning("SCPIReplayTransport: truncated record at offset %zu in \"%s\"\n", pos, m_path.c_str());
+			break;
+		}
+		m_records.push_back(rec);
+		pos = rec.m_offset + rec.m_length;
+	}
+
+	LogTrace("SCPIReplayTransport: loaded %zu records (%zu bytes) from %s\n",
+		m_records.size(), m_data.size(), m_path.c_str());
+}
+
+SCPIReplayTransport::~SCPIReplayTransport()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual transport code
+
+string SCPIReplayTransport::GetTransportName()
+{
+	return "replay";
+}
+
+string SCPIReplayTransport::GetConnectionString()
+{
+	return m_path;
+}
+
+bool SCPIReplayTransport::IsConnected()
+{
+	return !m_records.empty();
+}
+
+bool SCPIReplayTransport::IsCommandBatchingSupported()
+{
+	return false;
+}
+
+bool SCPIReplayTransport::SendCommand(const string& cmd)
+{
+	//Scan forward (wrapping around once) for a command record matching what the driver sent.
+	//Intervening records are skipped, so drivers don't have to issue every command in the dump.
+	for(size_t n=0; n<m_records.size(); n++)
+	{
+		size_t i = (m_cursor + n) % m_records.size();
+		auto& rec = m_records[i];
+		if(rec.m_type != 'C')
+			continue;
+		if(rec.m_length != cmd.length())
+			continue;
+		if(0 != memcmp(&m_data[rec.m_offset], cmd.c_str(), cmd.length()))
+			continue;
+
+		m_cursor = i + 1;
+		m_rawReadOffset = 0;
+		return true;
+	}
+
+	//Not in the dump: ignore it (likely a setting write we didn't capture)
+	LogTrace("SCPIReplayTransport: no match for command \"%s\"\n", cmd.c_str());
+	return true;
+}
+
+string SCPIReplayTransport::ReadReply(bool /*endOnSemicolon*/, [[maybe_unused]] function<void(float)> progress)
+{
+	//Return the next reply record at or after the cursor
+	while(m_cursor < m_records.size())
+	{
+		auto& rec = m_records[m_cursor];
+		m_cursor ++;
+		m_rawReadOffset = 0;
+		if(rec.m_type == 'R')
+			return string(reinterpret_cast<const char*>(&m_data[rec.m_offset]), rec.m_length);
+	}
+	return "";
+}
+
+size_t SCPIReplayTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> /*progress*/)
+{
+	//Serve bytes from raw-read records in order; one driver read may span several captured reads and vice versa
+	size_t done = 0;
+	while(done < len)
+	{
+		//Advance to the next raw-read record
+		while( (m_cursor < m_records.size()) && (m_records[m_cursor].m_type != 'D') )
+		{
+			m_cursor ++;
+			m_rawReadOffset = 0;
+		}
+		if(m_cursor >= m_records.size())
+			break;
+
+		auto& rec = m_records[m_cursor];
+		size_t avail = rec.m_length - m_rawReadOffset;
+		size_t chunk = min(len - done, avail);
+		memcpy(buf + done, &m_data[rec.m_offset + m_rawReadOffset], chunk);
+		done += chunk;
+		m_rawReadOffset += chunk;
+
+		if(m_rawReadOffset >= rec.m_length)
+		{
+			m_cursor ++;
+			m_rawReadOffset = 0;
+		}
+	}
+
+	m_stats.m_bytesRead += done;
+	m_stats.m_rawReads ++;
+	return done;
+}
+
+void SCPIReplayTransport::SendRawData(size_t /*len*/, const unsigned char* /*buf*/)
+{
+	//Nothing to do: writes have no effect on playback
+}
@@ -0,0 +1,115 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@brief Declaration of SCPIReplayTransport
+	@ingroup transports
+ */
+
+#ifndef SCPIReplayTransport_h
+#define SCPIReplayTransport_h
+
+/**
+	@brief Plays back a traffic dump captured by SCPIRecordingTransport, with no instrument attached
+
+	Lets driver parse paths (waveform descriptors, block downloads, etc.) be exercised, debugged, and
+	benchmarked offline against captured production traffic.
+
+	Connection string syntax: path of the dump file.
+
+	Replay is cursor based: SendCommand() scans forward (wrapping once) for a matching command record
+	and moves the cursor past it, ReadReply() returns the next reply record, and ReadRawData() serves
+	bytes from the raw-read records in order. Commands with no match in the dump are ignored rather than
+	failing, so a driver may be replayed from any point (e.g. skipping its setup sequence) after Rewind().
+
+	@ingroup transports
+ */
+class SCPIReplayTransport : public SCPITransport
+{
+public:
+	SCPIReplayTransport(const std::string& args);
+	virtual ~SCPIReplayTransport();
+
+	virtual std::string GetConnectionString() override;
+	static std::string GetTransportName();
+
+	virtual bool SendCommand(const std::string& cmd) override;
+	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+	virtual void SendRawData(size_t len, const unsigned char* buf) override;
+
+	virtual bool IsCommandBatchingSupported() override;
+	virtual bool IsConnected() override;
+
+	///@brief Moves the replay cursor back to the beginning of the dump
+	void Rewind()
+	{
+		m_cursor = 0;
+		m_rawReadOffset = 0;
+	}
+
+	///@brief Returns the total size of the loaded dump, in bytes
+	size_t GetDumpSize()
+	{ return m_data.size(); }
+
+	TRANSPORT_INITPROC(SCPIReplayTransport)
+
+protected:
+	///@brief One record in the dump
+	struct Record
+	{
+		///@brief Type marker ('C' = command, 'R' = reply, 'W' = raw write, 'D' = raw read data)
+		char m_type;
+
+		///@brief Offset of the payload within m_data
+		size_t m_offset;
+
+		///@brief Payload length
+		size_t m_length;
+	};
+
+	///@brief Path to the dump file
+	std::string m_path;
+
+	///@brief Raw dump contents
+	std::vector<uint8_t> m_data;
+
+	///@brief Parsed record index
+	std::vector<Record> m_records;
+
+	///@brief Index of the next record to be consumed
+	size_t m_cursor;
+
+	///@brief Number of bytes already served from the raw-read record at the cursor
+	size_t m_rawReadOffset;
+};
+
+#endif
@@ -42,8 +42,17 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
+#include <atomic>
+#include <memory>
+#include <thread>
+
 /**
 	@brief SocketCAN based interface for implementing CAN protocol analyzer functionality
+
+	Frames are captured by a background thread in recvmmsg() batches and pushed into a lock-free single
+	producer / single consumer ring buffer, so sustained 100% bus load survives stalls on the consumer side
+	(e.g. filter graph refreshes) without dropping frames.
+
 	@ingroup transports
  */
 class SCPISocketCANTransport : public SCPITransport
@@ -68,7 +77,41 @@ public:
 
 	TRANSPORT_INITPROC(SCPISocketCANTransport)
 
+	///@brief Returns the number of frames dropped because the ring buffer was full
+	uint64_t GetDropCount()
+	{ return m_dropCount.load(std::memory_order_relaxed); }
+
 protected:
+	void CaptureThread();
+
+	///@brief One captured CAN frame plus its kernel receive timestamp
+	struct TimestampedFrame
+	{
+		can_frame m_frame;
+		int64_t m_sec;
+		int64_t m_ns;
+	};
+
+	///@brief Number of slots in the capture ring buffer (must be a power of two)
+	static const size_t RING_DEPTH = 65536;
+
+	///@brief Lock-free SPSC ring of captured frames (capture thread writes, ReadPacket() reads)
+	std::unique_ptr<TimestampedFrame[]> m_ring;
+
+	///@brief Ring write index (monotonic; slot is index mod RING_DEPTH)
+	std::atomic<uint64_t> m_ringHead;
+
+	///@brief Ring read index (monotonic)
+	std::atomic<uint64_t> m_ringTail;
+
+	///@brief Number of frames dropped due to ring overflow
+	std::atomic<uint64_t> m_dropCount;
+
+	///@brief Set to ask the capture thread to exit
+	std::atomic<bool> m_shutdown;
+
+	///@brief Background frame capture thread
+	std::unique_ptr<std::thread> m_captureThread;
 
 	int m_socket;
 
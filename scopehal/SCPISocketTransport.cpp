@@ -36,6 +36,14 @@
 
 #include "scopehal.h"
 
+#ifdef __linux
+#include <netinet/tcp.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +94,10 @@ SCPISocketTransport::SCPISocketTransport(const string& hostname, unsigned short
  */
 void SCPISocketTransport::SharedCtorInit()
 {
+	m_rxBufferStart = 0;
+	m_rxBufferEnd = 0;
+	m_chunkSize = RX_BLOCK_SIZE;
+
 	LogDebug("Connecting to SCPI device at %s:%d\n", m_hostname.c_str(), m_port);
 
 	if(!m_socket.Connect(m_hostname, m_port))
@@ -110,12 +122,53 @@ void SCPISocketTransport::SharedCtorInit()
 		LogError("Couldn't disable delayed ACK\n");
 		return;
 	}
+
+	ApplyLowLatencyProfile();
 }
 
 SCPISocketTransport::~SCPISocketTransport()
 {
 }
 
+/**
+	@brief Applies latency-critical socket options beyond what Socket's helpers cover
+
+	Nagle and delayed ACK are already disabled by SharedCtorInit(); this adds aggressive keepalive so a dead
+	instrument (power cycled, cable pulled) is detected in seconds rather than the kernel default of over two
+	hours, which is what makes automatic reconnection usable. All options are best effort: a platform that
+	rejects one just keeps its defaults.
+ */
+void SCPISocketTransport::ApplyLowLatencyProfile()
+{
+	int one = 1;
+	setsockopt(m_socket, SOL_SOCKET, SO_KEEPALIVE, (const char*)&one, sizeof(one));
+
+#ifdef __linux
+	//Probe an idle connection after 10 seconds, then every 3 seconds, declaring it dead after 3 misses
+	int idle = 10;
+	int intvl = 3;
+	int cnt = 3;
+	setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+	setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+	setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt));
+#endif
+}
+
+/**
+	@brief Re-enables TCP_QUICKACK after a receive
+
+	Linux silently drops out of quickack mode after a while, re-enabling delayed ACKs; on a command/response
+	workload the peer then stalls up to 40 ms waiting for the ACK of its last segment before Nagle lets it send
+	more. Re-arming after every receive keeps the whole exchange on the fast path. No-op elsewhere.
+ */
+void SCPISocketTransport::RearmQuickAck()
+{
+#ifdef __linux
+	int one = 1;
+	setsockopt(m_socket, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#endif
+}
+
 bool SCPISocketTransport::IsConnected()
 {
 	return m_socket.IsValid();
@@ -141,22 +194,74 @@ bool SCPISocketTransport::SendCommand(const string& cmd)
 {
 	LogTrace("[%s] Sending %s\n", m_hostname.c_str(), cmd.c_str());
 	string tempbuf = cmd + "\n";
+	m_stats.m_bytesWritten += tempbuf.length();
 	return m_socket.SendLooped((unsigned char*)tempbuf.c_str(), tempbuf.length());
 }
 
+/**
+	@brief Reads up to len bytes from the socket, blocking until at least one byte is available
+
+	Unlike Socket::RecvLooped() this does not wait for the full requested length, so it's safe to over-ask
+	when we don't know how much data is in flight.
+
+	@param buf	Output buffer
+	@param len	Maximum number of bytes to read
+
+	@return Number of bytes read, or 0 on timeout / connection drop
+ */
+size_t SCPISocketTransport::RecvSome(unsigned char* buf, size_t len)
+{
+	#ifdef _WIN32
+	int result = recv(m_socket, (char*)buf, (int)len, 0);
+	#else
+	ssize_t result = recv(m_socket, buf, len, 0);
+	#endif
+	if(result <= 0)
+		return 0;
+	RearmQuickAck();
+	return (size_t)result;
+}
+
 string SCPISocketTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] function<void(float)> progress)
 {
-	//FIXME: there *has* to be a more efficient way to do this...
-	char tmp = ' ';
 	string ret;
 	while(true)
 	{
-		if(!m_socket.RecvLooped((unsigned char*)&tmp, 1))
-			break;
-		if( (tmp == '\n') || ( (tmp == ';') && endOnSemicolon ) )
+		//Scan anything we've already buffered for a terminator (memchr is vectorized by every modern libc)
+		size_t avail = m_rxBufferEnd - m_rxBufferStart;
+		if(avail)
+		{
+			unsigned char* base = &m_rxBuffer[m_rxBufferStart];
+			unsigned char* end = (unsigned char*)memchr(base, '\n', avail);
+			if(endOnSemicolon)
+			{
+				size_t searchlen = end ? (size_t)(end - base) : avail;
+				unsigned char* semi = (unsigned char*)memchr(base, ';', searchlen);
+				if(semi)
+					end = semi;
+			}
+			if(end)
+			{
+				//Got a terminator: consume through it, leaving anything after it for the next read
+				ret.append((char*)base, end - base);
+				m_rxBufferStart += (end - base) + 1;
+				break;
+			}
+
+			//No terminator yet, so everything buffered is part of this reply
+			ret.append((char*)base, avail);
+			m_rxBufferStart = 0;
+			m_rxBufferEnd = 0;
+		}
+
+		//Pull the next chunk off the socket in one syscall, rather than one per byte
+		m_rxBuffer.resize(RX_BLOCK_SIZE);
+		size_t n = RecvSome(&m_rxBuffer[0], RX_BLOCK_SIZE);
+		if(n == 0)
 			break;
-		else
-			ret += tmp;
+		m_stats.m_bytesRead += n;
+		m_rxBufferStart = 0;
+		m_rxBufferEnd = n;
 	}
 	LogTrace("[%s] Got %s\n", m_hostname.c_str(), ret.c_str());
 	return ret;
@@ -164,46 +269,231 @@ string SCPISocketTransport::ReadReply(bool endOnSemicolon, [[maybe_unused]] func
 
 void SCPISocketTransport::FlushRXBuffer(void)
 {
+	m_rxBufferStart = 0;
+	m_rxBufferEnd = 0;
 	m_socket.FlushRxBuffer();
 }
 
 void SCPISocketTransport::SendRawData(size_t len, const unsigned char* buf)
 {
+	m_stats.m_bytesWritten += len;
 	m_socket.SendLooped(buf, len);
 }
 
 size_t SCPISocketTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
 {
-	size_t chunk_size = len;
+	//Start from the adaptive chunk size, but keep chunks at or below 1% of the total (minimum 32 kB) when a
+	//progress callback is in use so updates stay responsive
+	size_t chunk_size = m_chunkSize;
 	if (progress)
+		chunk_size = min(chunk_size, max(len / 100, MIN_CHUNK_SIZE));
+
+	size_t pos = 0;
+
+	//Drain anything ReadReply() buffered past the last terminator before touching the socket
+	size_t avail = m_rxBufferEnd - m_rxBufferStart;
+	if(avail)
 	{
-		/* carve up the chunk_size into either 1% or 32kB chunks, whichever is larger; later, we'll want RecvLooped to do this for us */
-		chunk_size /= 100;
-		if (chunk_size < 32768)
-			chunk_size = 32768;
+		size_t n = min(avail, len);
+		memcpy(buf, &m_rxBuffer[m_rxBufferStart], n);
+		m_rxBufferStart += n;
+		pos = n;
+		if (progress)
+			progress((float)pos / (float)len);
 	}
 
-	for (size_t pos = 0; pos < len; )
+	for (; pos < len; )
 	{
 		size_t n = chunk_size;
 		if (n > (len - pos))
 			n = len - pos;
+		double tstart = GetTime();
 		if(!m_socket.RecvLooped(buf + pos, n))
 		{
 			LogTrace("Failed to get %zu bytes (@ pos %zu)\n", len, pos);
 			return 0;
 		}
+		double dt = GetTime() - tstart;
 		pos += n;
 		if (progress)
 		{
 			progress((float)pos / (float)len);
 		}
+
+		//Retarget the chunk size so one full chunk takes roughly 10 ms at the measured throughput.
+		//Only full chunks are a valid sample; the tail of a transfer says nothing about link rate.
+		if( (n == chunk_size) && (dt > 0) )
+		{
+			double bps = n / dt;
+			m_stats.m_lastThroughputBps = bps;
+
+			size_t target = bps * 0.01;
+			target = min(max(target, MIN_CHUNK_SIZE), MAX_CHUNK_SIZE);
+			m_chunkSize = (m_chunkSize + target) / 2;
+
+			chunk_size = m_chunkSize;
+			if (progress)
+				chunk_size = min(chunk_size, max(len / 100, MIN_CHUNK_SIZE));
+		}
 	}
+	m_stats.m_chunkSize = m_chunkSize;
+	m_stats.m_bytesRead += len;
+	m_stats.m_rawReads ++;
+
+	RearmQuickAck();
+	TuneReceiveBuffer();
 
 	LogTrace("Got %zu bytes\n", len);
 	return len;
 }
 
+/**
+	@brief Reads one logical block of binary data into several destination ranges with readv()
+
+	A single vectored read fills as many spans as the kernel has data for, so span boundaries (e.g. per-segment
+	waveform buffers in a sequenced capture) cost neither a syscall nor a copy through a stitch buffer. No adaptive
+	chunking is needed here: readv() returns whatever is available rather than blocking for a fixed chunk.
+
+	On Windows there is no readv(), so this falls back to the base class's one-ReadRawData()-per-span loop.
+ */
+size_t SCPISocketTransport::ReadRawDataScattered(
+	const std::vector<TransportReadSpan>& spans, std::function<void(float)> progress)
+{
+#ifdef _WIN32
+	return SCPITransport::ReadRawDataScattered(spans, progress);
+#else
+	size_t total = 0;
+	for(auto& span : spans)
+		total += span.m_len;
+	if(total == 0)
+		return 0;
+
+	//Position within the span list: current span index and offset into it
+	size_t pos = 0;
+	size_t ispan = 0;
+	size_t spanoff = 0;
+
+	//Drain anything ReadReply() buffered past the last terminator before touching the socket
+	while( (m_rxBufferEnd > m_rxBufferStart) && (ispan < spans.size()) )
+	{
+		size_t avail = m_rxBufferEnd - m_rxBufferStart;
+		size_t n = min(avail, spans[ispan].m_len - spanoff);
+		memcpy(spans[ispan].m_data + spanoff, &m_rxBuffer[m_rxBufferStart], n);
+		m_rxBufferStart += n;
+		spanoff += n;
+		pos += n;
+		if(spanoff == spans[ispan].m_len)
+		{
+			ispan ++;
+			spanoff = 0;
+		}
+	}
+	if(progress && pos)
+		progress((float)pos / (float)total);
+
+	double tstart = GetTime();
+	while(pos < total)
+	{
+		//Build the iovec list starting at the current position
+		struct iovec iov[32];
+		int niov = 0;
+		size_t so = spanoff;
+		for(size_t si = ispan; (si < spans.size()) && (niov < 32); si ++)
+		{
+			if(spans[si].m_len > so)
+			{
+				iov[niov].iov_base = spans[si].m_data + so;
+				iov[niov].iov_len = spans[si].m_len - so;
+				niov ++;
+			}
+			so = 0;
+		}
+
+		ssize_t n = readv(m_socket, iov, niov);
+		if(n <= 0)
+		{
+			LogTrace("Failed to get %zu bytes (@ pos %zu)\n", total, pos);
+			return 0;
+		}
+
+		//Advance our position by however much the kernel gave us
+		pos += n;
+		size_t left = n;
+		while(left)
+		{
+			size_t remaining = spans[ispan].m_len - spanoff;
+			if(left >= remaining)
+			{
+				left -= remaining;
+				ispan ++;
+				spanoff = 0;
+			}
+			else
+			{
+				spanoff += left;
+				left = 0;
+			}
+		}
+
+		if(progress)
+			progress((float)pos / (float)total);
+	}
+
+	double dt = GetTime() - tstart;
+	if(dt > 0)
+		m_stats.m_lastThroughputBps = total / dt;
+	m_stats.m_bytesRead += total;
+	m_stats.m_rawReads ++;
+
+	RearmQuickAck();
+	TuneReceiveBuffer();
+
+	LogTrace("Got %zu bytes (%zu spans)\n", total, spans.size());
+	return total;
+#endif
+}
+
+/**
+	@brief Grows the kernel receive buffer to cover the link's bandwidth-delay product
+
+	A WAN connected instrument can't reach link rate if the TCP window is limited by a default sized receive
+	buffer. Uses the kernel's RTT estimate plus our measured throughput to size the buffer; only ever grows it,
+	and does nothing on platforms without TCP_INFO.
+ */
+void SCPISocketTransport::TuneReceiveBuffer()
+{
+#ifdef __linux
+	struct tcp_info info;
+	socklen_t infolen = sizeof(info);
+	if(0 != getsockopt(m_socket, IPPROTO_TCP, TCP_INFO, &info, &infolen))
+		return;
+	if(info.tcpi_rtt == 0)
+		return;
+	double rtt = info.tcpi_rtt * 1e-6;
+	m_stats.m_lastRttSec = rtt;
+
+	double bps = m_stats.m_lastThroughputBps;
+	if(bps <= 0)
+		return;
+
+	//Ask for twice the bandwidth-delay product, capped at 16 MB, so the window never limits throughput
+	uint64_t want = min((uint64_t)(bps * rtt * 2), (uint64_t)(16 * 1024 * 1024));
+
+	int cur = 0;
+	socklen_t curlen = sizeof(cur);
+	if(0 != getsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &cur, &curlen))
+		return;
+	if((uint64_t)cur < want)
+	{
+		int req = want;
+		setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &req, sizeof(req));
+		curlen = sizeof(cur);
+		getsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &cur, &curlen);
+	}
+	m_stats.m_rcvbufSize = cur;
+#endif
+}
+
 bool SCPISocketTransport::IsCommandBatchingSupported()
 {
 	return true;
@@ -58,6 +58,8 @@ public:
 	virtual bool SendCommand(const std::string& cmd) override;
 	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) override;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+	virtual size_t ReadRawDataScattered(
+		const std::vector<TransportReadSpan>& spans, std::function<void(float)> progress = nullptr) override;
 	virtual void SendRawData(size_t len, const unsigned char* buf) override;
 
 	virtual bool IsCommandBatchingSupported() override;
@@ -89,9 +91,36 @@ protected:
 
 	void SharedCtorInit();
 
+	virtual size_t RecvSome(unsigned char* buf, size_t len);
+
+	void ApplyLowLatencyProfile();
+	void RearmQuickAck();
+	void TuneReceiveBuffer();
+
+	///@brief Smallest adaptive read chunk, in bytes
+	static const size_t MIN_CHUNK_SIZE = 32768;
+
+	///@brief Largest adaptive read chunk, in bytes
+	static const size_t MAX_CHUNK_SIZE = 8 * 1024 * 1024;
+
+	///@brief Current adaptive read chunk size, sized so one RecvLooped() call takes about 10 ms at link rate
+	size_t m_chunkSize;
+
 	///@brief The socket for commands
 	Socket m_socket;
 
+	///@brief Size of a single bulk read from the socket
+	static const size_t RX_BLOCK_SIZE = 65536;
+
+	///@brief Data read from the socket but not yet consumed by a caller
+	std::vector<unsigned char> m_rxBuffer;
+
+	///@brief Index of the first unconsumed byte in m_rxBuffer
+	size_t m_rxBufferStart;
+
+	///@brief Index one past the last valid byte in m_rxBuffer
+	size_t m_rxBufferEnd;
+
 	///@brief IP or hostname of the instrument
 	std::string m_hostname;
 
@@ -41,8 +41,10 @@ using namespace std;
 SCPITransport::CreateMapType SCPITransport::m_createprocs;
 
 SCPITransport::SCPITransport()
-	: m_rateLimitingEnabled(false)
+	: m_coalescingEnabled(false)
+	, m_rateLimitingEnabled(false)
 	, m_rateLimitingInterval(0)
+	, m_nextPinnedRxBuffer(0)
 {
 }
 
@@ -76,6 +78,33 @@ SCPITransport* SCPITransport::CreateTransport(const string& transport, const str
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Command batching
 
+/**
+	@brief Parses a command into subject, verb, and body sections
+ */
+SCPITransport::QueuedCommand::QueuedCommand(const string& cmd)
+	: m_full(cmd)
+{
+	//Split off subject, if we have one
+	//(ignore leading colon)
+	string tmp = cmd;
+	size_t icolon;
+	if(!tmp.empty() && (tmp[0] == ':'))
+		icolon = tmp.find(':', 1);
+	else
+		icolon = tmp.find(':', 0);
+	if(icolon != string::npos)
+	{
+		m_subject = tmp.substr(0, icolon);
+		tmp = tmp.substr(icolon + 1);
+	}
+	m_body = tmp;
+
+	//Split off command from arguments
+	size_t ispace = tmp.find(' ');
+	if(ispace != string::npos)
+		m_verb = tmp.substr(0, ispace);
+}
+
 /**
 	@brief Pushes a command into the transmit FIFO then returns immediately.
 
@@ -83,84 +112,43 @@ SCPITransport* SCPITransport::CreateTransport(const string& transport, const str
  */
 void SCPITransport::SendCommandQueued(const string& cmd)
 {
+	//Parse the incoming command into sections before we grab the lock, so we hold it as briefly as possible.
+	//The acquisition and UI threads both push commands; keeping the critical section down to a list splice plus
+	//(for dedup-able commands) a walk of pre-parsed entries avoids measurable stalls when polling many values.
+	QueuedCommand qcmd(cmd);
+
+	//Only attempt to deduplicate previous instances if this command is on the list of commands where it's OK
+	bool dedup = (m_dedupCommands.find(qcmd.m_verb) != m_dedupCommands.end());
+
 	lock_guard<mutex> lock(m_queueMutex);
 
 	//Do deduplication if there are existing queued commands
-	if(!m_dedupCommands.empty() && !m_txQueue.empty())
+	if(dedup && !m_txQueue.empty())
 	{
-		//Parse the INCOMING command into sections
-
-		//Split off subject, if we have one
-		//(ignore leading colon)
-		string tmp = cmd;
-		size_t icolon;
-		if(tmp[0] == ':')
-			icolon = tmp.find(':', 1);
-		else
-			icolon = tmp.find(':', 0);
-		string incoming_subject;
-		if(icolon != string::npos)
+		auto it = m_txQueue.begin();
+		while(it != m_txQueue.end())
 		{
-			incoming_subject = tmp.substr(0, icolon);
-			tmp = tmp.substr(icolon + 1);
-		}
+			//Deduplicate if the same command is operating on the same subject
+			if( (qcmd.m_verb == it->m_verb) && (qcmd.m_subject == it->m_subject) )
+			{
+				LogTrace("Deduplicating redundant %s command %s and pushing new command %s\n",
+					it->m_verb.c_str(),
+					it->m_full.c_str(),
+					cmd.c_str());
 
-		//Split off command from arguments
-		size_t ispace = tmp.find(' ');
-		string incoming_cmd;
-		if(ispace != string::npos)
-			incoming_cmd = tmp.substr(0, ispace);
+				auto oldit = it;
+				it++;
 
-		//Only attempt to deduplicate previous instances if this command is on the list of commands where it's OK
-		if(m_dedupCommands.find(incoming_cmd) != m_dedupCommands.end())
-		{
-			auto it = m_txQueue.begin();
-			while(it != m_txQueue.end())
-			{
-				tmp = *it;
-
-				//Split off subject, if we have one
-				//(ignore leading colon)
-				if(tmp[0] == ':')
-					icolon = tmp.find(':', 1);
-				else
-					icolon = tmp.find(':', 0);
-				string subject;
-				if(icolon != string::npos)
-				{
-					subject = tmp.substr(0, icolon);
-					tmp = tmp.substr(icolon + 1);
-				}
-
-				//Split off command from arguments
-				ispace = tmp.find(' ');
-				string ncmd;
-				if(ispace != string::npos)
-					ncmd = tmp.substr(0, ispace);
-
-				//Deduplicate if the same command is operating on the same subject
-				if( (incoming_cmd == ncmd) && (incoming_subject == subject) )
-				{
-					LogTrace("Deduplicating redundant %s command %s and pushing new command %s\n",
-						ncmd.c_str(),
-						(*it).c_str(),
-						cmd.c_str());
-
-					auto oldit = it;
-					it++;
-
-					m_txQueue.erase(oldit);
-				}
-
-				//Nope, skip it
-				else
-					it++;
+				m_txQueue.erase(oldit);
 			}
-		}
 
+			//Nope, skip it
+			else
+				it++;
+		}
 	}
 
-	m_txQueue.push_back(cmd);
+	m_txQueue.push_back(std::move(qcmd));
 
 	LogTrace("%zu commands now queued\n", m_txQueue.size());
 }
@@ -168,6 +156,101 @@ void SCPITransport::SendCommandQueued(const string& cmd)
 /**
 	@brief Block until it's time to send the next command when rate limiting.
  */
+/**
+	@brief Reads a block of binary data into a recycled pinned buffer, avoiding an intermediate copy.
+
+	The returned buffer's CPU side is pinned, DMA-capable memory, so drivers can pass the data straight to a
+	conversion shader rather than staging through a temporary std::vector and memcpy'ing into an AcceleratorBuffer.
+	Buffers are recycled from a small ring once the caller drops its reference, so steady-state waveform download
+	does no memory allocation.
+
+	@param len		Number of bytes to read
+	@param progress	Optional progress callback, forwarded to ReadRawData()
+
+	@return The buffer, or nullptr if the read failed
+ */
+shared_ptr<AcceleratorBuffer<uint8_t>> SCPITransport::ReadRawDataPinned(size_t len, function<void(float)> progress)
+{
+	//Look for a ring buffer no longer in use by a previous caller
+	shared_ptr<AcceleratorBuffer<uint8_t>> buf;
+	for(size_t i=0; i<m_pinnedRxBuffers.size(); i++)
+	{
+		auto& b = m_pinnedRxBuffers[m_nextPinnedRxBuffer];
+		m_nextPinnedRxBuffer = (m_nextPinnedRxBuffer + 1) % m_pinnedRxBuffers.size();
+		if(b.use_count() == 1)
+		{
+			buf = b;
+			break;
+		}
+	}
+
+	//Every buffer is still checked out (or the ring is empty), add another one
+	if(buf == nullptr)
+	{
+		buf = make_shared<AcceleratorBuffer<uint8_t>>("SCPITransport.m_pinnedRxBuffers");
+		buf->SetCpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		buf->SetGpuAccessHint(AcceleratorBuffer<uint8_t>::HINT_LIKELY);
+		m_pinnedRxBuffers.push_back(buf);
+	}
+
+	//Read directly into the pinned memory
+	buf->resize(len);
+	buf->PrepareForCpuAccess();
+	if(ReadRawData(len, buf->GetCpuPointer(), progress) != len)
+		return nullptr;
+	buf->MarkModifiedFromCpu();
+
+	return buf;
+}
+
+/**
+	@brief Reads one logical block of binary data into several destination ranges
+
+	Intended for segmented captures (sequence mode, FastFrame and friends) where the instrument sends the segments
+	back to back but the driver wants each one in its own waveform buffer: reading straight into the final
+	destinations removes the copy through a stitch buffer that a plain ReadRawData() call would require. Spans may
+	point into pinned AcceleratorBuffer memory.
+
+	The base implementation just issues one ReadRawData() per span; transports backed by a raw socket override this
+	with a vectored read so span boundaries don't force extra syscalls.
+
+	@param spans	Destination ranges, filled in order
+	@param progress	Optional progress callback, called with the completed fraction of the total transfer
+
+	@return Total number of bytes read, or 0 on failure
+ */
+size_t SCPITransport::ReadRawDataScattered(const vector<TransportReadSpan>& spans, function<void(float)> progress)
+{
+	size_t total = 0;
+	for(auto& span : spans)
+		total += span.m_len;
+	if(total == 0)
+		return 0;
+
+	size_t pos = 0;
+	for(auto& span : spans)
+	{
+		if(span.m_len == 0)
+			continue;
+
+		//Rescale the per-span progress to a fraction of the whole transfer
+		function<void(float)> spanProgress = nullptr;
+		if(progress)
+		{
+			size_t base = pos;
+			size_t len = span.m_len;
+			spanProgress = [&progress, base, len, total](float f)
+				{ progress( (base + f*len) / total ); };
+		}
+
+		if(ReadRawData(span.m_len, span.m_data, spanProgress) != span.m_len)
+			return 0;
+		pos += span.m_len;
+	}
+
+	return total;
+}
+
 void SCPITransport::RateLimitingWait()
 {
 	this_thread::sleep_until(m_nextCommandReady);
@@ -180,7 +263,7 @@ void SCPITransport::RateLimitingWait()
 bool SCPITransport::FlushCommandQueue()
 {
 	//Grab the queue, then immediately release the mutex so we can do more queued sends
-	list<string> tmp;
+	list<QueuedCommand> tmp;
 	{
 		lock_guard<mutex> lock(m_queueMutex);
 		tmp = std::move(m_txQueue);
@@ -191,11 +274,30 @@ bool SCPITransport::FlushCommandQueue()
 		LogTrace("%zu commands being flushed\n", tmp.size());
 
 	lock_guard<recursive_mutex> lock(m_netMutex);
-	for(auto str : tmp)
+	for(auto it = tmp.begin(); it != tmp.end(); )
 	{
+		string msg = it->m_full;
+		string subject = it->m_subject;
+		++it;
+
+		//Coalesce consecutive writes to the same subject into a single semicolon separated program message.
+		//After a semicolon the instrument's parser stays at the level of the previous header, so the subject
+		//prefix can be stripped from subsequent commands. Cap message length to stay within instrument buffers.
+		if(m_coalescingEnabled && !subject.empty())
+		{
+			while( (it != tmp.end()) &&
+				(it->m_subject == subject) &&
+				( (msg.length() + it->m_body.length()) < 1024) )
+			{
+				msg += ';';
+				msg += it->m_body;
+				++it;
+			}
+		}
+
 		if(m_rateLimitingEnabled)
 			RateLimitingWait();
-		SendCommand(str);
+		SendCommand(msg);
 	}
 	return true;
 }
@@ -252,6 +354,20 @@ void* SCPITransport::SendCommandImmediateWithRawBlockReply(string cmd, size_t& l
 		RateLimitingWait();
 	SendCommand(cmd);
 
+	return ReadRawBlockReply(len);
+}
+
+/**
+	@brief Reads an IEEE 488.2 length-prefixed block reply (#NL...L<data>) that is already in flight
+
+	For pipelining several block queries: send them all with SendCommandImmediate(), then collect the replies in
+	order with this. The caller must hold the transport mutex across the entire send/read sequence so no other
+	thread's traffic can interleave.
+ */
+void* SCPITransport::ReadRawBlockReply(size_t& len)
+{
+	lock_guard<recursive_mutex> lock(m_netMutex);
+
 	//Read the length
 	char tmplen[3] = {0};
 	if(2 != ReadRawData(2, (unsigned char*)tmplen))			//expect #n
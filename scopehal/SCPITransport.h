@@ -37,8 +37,61 @@
 #ifndef SCPITransport_h
 #define SCPITransport_h
 
+#include <atomic>
 #include <chrono>
 
+#include "AcceleratorBuffer.h"
+
+/**
+	@brief Performance counters for a transport connection
+
+	Updated by transports which move data over a network socket; other transports may leave some or all counters
+	at zero. All fields are atomic and may be read from any thread while the connection is in use.
+
+	@ingroup transports
+ */
+class TransportStatistics
+{
+public:
+	///@brief Total bytes of reply and waveform data read
+	std::atomic<uint64_t> m_bytesRead{0};
+
+	///@brief Total bytes of commands and raw data written
+	std::atomic<uint64_t> m_bytesWritten{0};
+
+	///@brief Number of completed ReadRawData() calls
+	std::atomic<uint64_t> m_rawReads{0};
+
+	///@brief Most recent bulk download throughput, in bytes per second (0 if not yet measured)
+	std::atomic<double> m_lastThroughputBps{0};
+
+	///@brief Most recent TCP round trip time estimate, in seconds (0 if unknown)
+	std::atomic<double> m_lastRttSec{0};
+
+	///@brief Current adaptive read chunk size, in bytes (0 if the transport does not adapt)
+	std::atomic<uint64_t> m_chunkSize{0};
+
+	///@brief Current kernel receive buffer size, in bytes (0 if unknown)
+	std::atomic<uint64_t> m_rcvbufSize{0};
+};
+
+/**
+	@brief One destination range for a scatter-gather read (see SCPITransport::ReadRawDataScattered())
+
+	Spans may point anywhere writable, including into the pinned CPU side of an AcceleratorBuffer, so segmented
+	waveform data can land directly where the driver wants it without an intermediate stitch buffer.
+
+	@ingroup transports
+ */
+struct TransportReadSpan
+{
+	///@brief Destination for this span's data
+	unsigned char* m_data;
+
+	///@brief Number of bytes to read into m_data
+	size_t m_len;
+};
+
 /**
 	@brief Abstraction of a transport layer for moving SCPI data between endpoints
 	@ingroup transports
@@ -67,6 +120,7 @@ public:
 	void SendCommandImmediate(std::string cmd);
 	std::string SendCommandImmediateWithReply(std::string cmd, bool endOnSemicolon = true);
 	void* SendCommandImmediateWithRawBlockReply(std::string cmd, size_t& len);
+	void* ReadRawBlockReply(size_t& len);
 	bool FlushCommandQueue();
 
 	//Manual mutex locking for ReadRawData() etc
@@ -78,6 +132,9 @@ public:
 	virtual bool SendCommand(const std::string& cmd) =0;
 	virtual std::string ReadReply(bool endOnSemicolon = true, std::function<void(float)> progress = nullptr) =0;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) =0;
+	virtual size_t ReadRawDataScattered(
+		const std::vector<TransportReadSpan>& spans, std::function<void(float)> progress = nullptr);
+	std::shared_ptr<AcceleratorBuffer<uint8_t>> ReadRawDataPinned(size_t len, std::function<void(float)> progress = nullptr);
 	virtual void SendRawData(size_t len, const unsigned char* buf) =0;
 
 	virtual bool IsCommandBatchingSupported() =0;
@@ -120,6 +177,32 @@ public:
 	void DeduplicateCommand(const std::string& cmd)
 	{ m_dedupCommands.emplace(cmd); }
 
+	/**
+		@brief Enables coalescing of queued commands.
+
+		When coalescing is enabled, consecutive queued commands with the same subject are concatenated into a single
+		semicolon separated program message at flush time, with the redundant subject prefixes stripped. For example
+
+		:C2:OFFS 1.1
+		:C2:VDIV 0.5
+
+		will be sent as
+
+		:C2:OFFS 1.1;VDIV 0.5
+
+		This reduces the number of network round trips (and rate limiting delays, if enabled) when a driver pushes
+		many settings at once, but is only legal if the instrument implements standard SCPI-1999 semicolon handling
+		(relative headers after a semicolon). Drivers speaking nonstandard grammars should leave it disabled.
+
+		Once coalescing is enabled on a transport, it cannot be disabled.
+	 */
+	void EnableCommandCoalescing()
+	{ m_coalescingEnabled = true; }
+
+	///@brief Returns the performance counters for this connection
+	TransportStatistics& GetStatistics()
+	{ return m_stats; }
+
 public:
 	typedef SCPITransport* (*CreateProcType)(const std::string& args);
 	static void DoAddTransportClass(std::string name, CreateProcType proc);
@@ -134,18 +217,52 @@ protected:
 	typedef std::map< std::string, CreateProcType > CreateMapType;
 	static CreateMapType m_createprocs;
 
+	/**
+		@brief A queued command, parsed into its components at enqueue time
+
+		Parsing happens in the calling thread, before m_queueMutex is taken, so deduplication and coalescing only do
+		cheap string compares while holding the lock.
+	 */
+	class QueuedCommand
+	{
+	public:
+		QueuedCommand(const std::string& cmd);
+
+		///@brief Full text of the command
+		std::string m_full;
+
+		///@brief Subject the command operates on (e.g. ":C2" in ":C2:OFFS 1.1"), empty if none
+		std::string m_subject;
+
+		///@brief Command verb with subject and arguments stripped (e.g. "OFFS" in ":C2:OFFS 1.1")
+		std::string m_verb;
+
+		///@brief Everything after the subject (e.g. "OFFS 1.1" in ":C2:OFFS 1.1")
+		std::string m_body;
+	};
+
 	//Queued commands waiting to be sent
 	std::mutex m_queueMutex;
 	std::recursive_mutex m_netMutex;
-	std::list<std::string> m_txQueue;
+	std::list<QueuedCommand> m_txQueue;
 
 	//Set of commands that are OK to deduplicate
 	std::set<std::string> m_dedupCommands;
 
+	//True if coalescing of same-subject commands is enabled
+	bool m_coalescingEnabled;
+
 	//Rate limiting (send max of one command per X time)
 	bool m_rateLimitingEnabled;
 	std::chrono::system_clock::time_point m_nextCommandReady;
 	std::chrono::milliseconds m_rateLimitingInterval;
+
+	//Ring of recycled pinned buffers handed out by ReadRawDataPinned()
+	std::vector<std::shared_ptr<AcceleratorBuffer<uint8_t>>> m_pinnedRxBuffers;
+	size_t m_nextPinnedRxBuffer;
+
+	///@brief Performance counters for this connection
+	TransportStatistics m_stats;
 };
 
 #define TRANSPORT_INITPROC(T) \
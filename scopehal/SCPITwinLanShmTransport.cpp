@@ -0,0 +1,200 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPITwinLanShmTransport
+	@ingroup transports
+ */
+
+#include "scopehal.h"
+
+#ifdef __linux
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPITwinLanShmTransport::SCPITwinLanShmTransport(const string& args)
+	: SCPITwinLanTransport(args)
+	, m_ring(nullptr)
+	, m_ringData(nullptr)
+	, m_mappingSize(0)
+{
+	NegotiateSharedMemory();
+}
+
+SCPITwinLanShmTransport::~SCPITwinLanShmTransport()
+{
+	if(m_ring)
+		munmap(m_ring, m_mappingSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Discovery
+
+string SCPITwinLanShmTransport::GetTransportName()
+{
+	return "twinshm";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shared memory negotiation
+
+/**
+	@brief Ask the bridge for a shared memory data plane
+
+	Handshake (on the data socket, client speaks first):
+	* Client sends the 8 byte magic number
+	* Server replies with a 1 byte accept flag. On accept: a 2 byte name length, the shared memory object name,
+	  then nothing further (the ring size is read from the mapped header).
+	* Client maps the object and replies with a 1 byte success flag.
+
+	Both ends use the TCP data plane if any step declines or fails. The server is expected to accept only when the
+	connection comes from a loopback address, since the shared memory object is of no use to a remote client.
+ */
+void SCPITwinLanShmTransport::NegotiateSharedMemory()
+{
+	//Say hello
+	uint64_t magic = TWINLAN_SHM_MAGIC;
+	m_secondarysocket.SendLooped((unsigned char*)&magic, sizeof(magic));
+
+	//Server declined (not local, or no shared memory support)? Use the normal TCP path
+	uint8_t ok = 0;
+	if(!m_secondarysocket.RecvLooped(&ok, 1))
+		return;
+	if(!ok)
+	{
+		LogDebug("Bridge declined shared memory data plane, using TCP\n");
+		return;
+	}
+
+	//Get the name of the shared memory object
+	uint16_t namelen;
+	if(!m_secondarysocket.RecvLooped((unsigned char*)&namelen, sizeof(namelen)))
+		return;
+	string name;
+	name.resize(namelen);
+	if(namelen && !m_secondarysocket.RecvLooped((unsigned char*)&name[0], namelen))
+		return;
+
+	//Try to map it, and tell the server whether we managed to
+	uint8_t mapped = 0;
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if(fd >= 0)
+	{
+		struct stat st;
+		if(0 == fstat(fd, &st))
+		{
+			m_mappingSize = st.st_size;
+			void* base = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if(base != MAP_FAILED)
+			{
+				auto ring = reinterpret_cast<TwinLanShmRingHeader*>(base);
+
+				//Sanity check the header before committing to it
+				bool sizeOk =
+					(ring->m_size >= 4096) &&
+					( (ring->m_size & (ring->m_size - 1)) == 0) &&
+					(m_mappingSize >= sizeof(TwinLanShmRingHeader) + ring->m_size);
+				if( (ring->m_magic == TWINLAN_SHM_MAGIC) && sizeOk)
+				{
+					m_ring = ring;
+					m_ringData = reinterpret_cast<uint8_t*>(base) + sizeof(TwinLanShmRingHeader);
+					mapped = 1;
+				}
+				else
+					munmap(base, m_mappingSize);
+			}
+		}
+		close(fd);
+	}
+	m_secondarysocket.SendLooped(&mapped, 1);
+
+	if(mapped)
+		LogDebug("Using shared memory data plane (%s, %zu kB ring)\n", name.c_str(), (size_t)m_ring->m_size / 1024);
+	else
+		LogWarning("Failed to map shared memory object %s, using TCP\n", name.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Data plane I/O
+
+size_t SCPITwinLanShmTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
+{
+	if(!m_ring)
+		return SCPITwinLanTransport::ReadRawData(len, buf, progress);
+
+	uint64_t mask = m_ring->m_size - 1;
+	uint64_t rptr = m_ring->m_rptr.load(memory_order_relaxed);
+
+	size_t done = 0;
+	while(done < len)
+	{
+		//Block on a doorbell token if the ring is empty.
+		//Stale doorbells are possible (one consume can cover several pushes) but harmless, we just loop again.
+		uint64_t avail = m_ring->m_wptr.load(memory_order_acquire) - rptr;
+		if(avail == 0)
+		{
+			uint8_t doorbell;
+			if(!m_secondarysocket.RecvLooped(&doorbell, 1))
+				return 0;
+			continue;
+		}
+
+		//Copy as much as we can use, handling wraparound at the end of the ring
+		size_t take = min((size_t)avail, len - done);
+		size_t pos = rptr & mask;
+		size_t first = min(take, (size_t)(m_ring->m_size - pos));
+		memcpy(buf + done, m_ringData + pos, first);
+		if(take > first)
+			memcpy(buf + done + first, m_ringData, take - first);
+		done += take;
+
+		//Release the space, then send a credit token in case the server is blocked on a full ring
+		rptr += take;
+		m_ring->m_rptr.store(rptr, memory_order_release);
+		uint8_t credit = 1;
+		m_secondarysocket.SendLooped(&credit, 1);
+
+		if(progress)
+			progress((float)done / len);
+	}
+
+	return len;
+}
+
+#endif
@@ -0,0 +1,113 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPITwinLanShmTransport
+	@ingroup transports
+ */
+
+#ifndef SCPITwinLanShmTransport_h
+#define SCPITwinLanShmTransport_h
+
+#ifdef __linux
+
+#include <atomic>
+
+/**
+	@brief Shared memory ring buffer header for SCPITwinLanShmTransport
+
+	The ring payload immediately follows this header in the shared memory object. The payload size is a power of two
+	so positions can be computed with a mask. Write and read pointers are free running byte counts; the server
+	(bridge) advances m_wptr after producing data and the client advances m_rptr after consuming it.
+ */
+struct TwinLanShmRingHeader
+{
+	///@brief Magic number, must equal TWINLAN_SHM_MAGIC
+	uint64_t m_magic;
+
+	///@brief Size of the ring payload in bytes (power of two)
+	uint64_t m_size;
+
+	///@brief Free running count of bytes written by the server
+	std::atomic<uint64_t> m_wptr;
+
+	///@brief Free running count of bytes consumed by the client
+	std::atomic<uint64_t> m_rptr;
+};
+
+/**
+	@brief A SCPITwinLanTransport with a shared memory fast path for waveform data on same-host connections
+
+	On connect, the client sends a handshake on the data socket. A bridge which supports the protocol, and which sees
+	the connection coming from a loopback address, replies with the name of a shared memory ring buffer; waveform
+	data then flows through the ring without ever crossing the loopback TCP stack. Single byte doorbell and credit
+	tokens on the data socket are used to sleep when the ring is empty or full.
+
+	If the bridge declines (remote connection, or shared memory unavailable), the data plane falls back to the
+	inherited TCP path. Only usable with bridges that implement the handshake; use "twinlan" for legacy bridges.
+
+	@ingroup transports
+ */
+class SCPITwinLanShmTransport : public SCPITwinLanTransport
+{
+public:
+	SCPITwinLanShmTransport(const std::string& args);
+	virtual ~SCPITwinLanShmTransport();
+
+	static std::string GetTransportName();
+
+	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+
+	TRANSPORT_INITPROC(SCPITwinLanShmTransport)
+
+	///@brief Returns true if the shared memory data plane was successfully negotiated
+	bool IsShmActive()
+	{ return m_ring != nullptr; }
+
+	///@brief Expected value of TwinLanShmRingHeader::m_magic ("TWINSHM1")
+	static const uint64_t TWINLAN_SHM_MAGIC = 0x314d48534e495754;
+
+protected:
+	void NegotiateSharedMemory();
+
+	///@brief Mapped ring buffer header (null if using the TCP fallback path)
+	TwinLanShmRingHeader* m_ring;
+
+	///@brief Ring payload, immediately after the header
+	uint8_t* m_ringData;
+
+	///@brief Total size of the shared memory mapping (header plus payload)
+	size_t m_mappingSize;
+};
+
+#endif
+
+#endif
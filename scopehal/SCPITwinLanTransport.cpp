@@ -30,12 +30,17 @@
 /**
 	@file
 	@author Andrew D. Zonenberg
-	@brief Implementation of SCPIUARTTransport
+	@brief Implementation of SCPITwinLanTransport
 	@ingroup transports
  */
 
 #include "scopehal.h"
 
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#include <future>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +50,10 @@ SCPITwinLanTransport::SCPITwinLanTransport(const string& args)
 	: SCPISocketTransport(args)
 	, m_dataport(5026)
 	, m_secondarysocket(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+#ifdef HAS_ZSTD
+	, m_zstdContext(nullptr)
+#endif
+	, m_compressionEnabled(false)
 {
 	//Figure out the data port number
 	char hostname[128] = "";
@@ -72,6 +81,10 @@ SCPITwinLanTransport::SCPITwinLanTransport(const string& args)
 
 SCPITwinLanTransport::~SCPITwinLanTransport()
 {
+#ifdef HAS_ZSTD
+	if(m_zstdContext)
+		ZSTD_freeDCtx(reinterpret_cast<ZSTD_DCtx*>(m_zstdContext));
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -92,14 +105,121 @@ string SCPITwinLanTransport::GetConnectionString()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Secondary socket I/O
 
-size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> /*progress*/)
+size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
 {
+#ifdef HAS_ZSTD
+	if(m_compressionEnabled)
+		return ReadCompressedData(len, buf, progress);
+#else
+	(void)progress;
+#endif
+
 	if(m_secondarysocket.RecvLooped(buf, len))
 		return len;
 	else
 		return 0;
 }
 
+#ifdef HAS_ZSTD
+
+/**
+	@brief Reads a zstd compressed data plane transfer
+
+	The bridge sends the transfer as a sequence of chunks, each a uint32 compressed length followed by one
+	independent zstd frame. Chunks decompress directly into the caller's buffer (pinned memory when called
+	via ReadRawDataPinned(), so no staging copy happens), and while one chunk is decompressing the next is
+	already being received on a worker, overlapping network and CPU time.
+
+	@param len		Number of decompressed bytes expected
+	@param buf		Destination buffer
+	@param progress	Optional progress callback
+
+	@return len on success, 0 on a socket error or malformed frame
+ */
+size_t SCPITwinLanTransport::ReadCompressedData(size_t len, unsigned char* buf, std::function<void(float)> progress)
+{
+	//Grab one chunk (length header plus frame) off the socket
+	auto recvChunk = [this](vector<uint8_t>& chunk) -> bool
+	{
+		uint32_t clen;
+		if(!m_secondarysocket.RecvLooped(reinterpret_cast<unsigned char*>(&clen), sizeof(clen)))
+			return false;
+		chunk.resize(clen);
+		return m_secondarysocket.RecvLooped(chunk.data(), clen);
+	};
+
+	auto ctx = reinterpret_cast<ZSTD_DCtx*>(m_zstdContext);
+	vector<uint8_t>* cur = &m_compressBufA;
+	vector<uint8_t>* next = &m_compressBufB;
+
+	if(!recvChunk(*cur))
+		return 0;
+
+	size_t pos = 0;
+	while(pos < len)
+	{
+		//Sanity check the frame before touching it
+		auto dlen = ZSTD_getFrameContentSize(cur->data(), cur->size());
+		if( (dlen == ZSTD_CONTENTSIZE_UNKNOWN) || (dlen == ZSTD_CONTENTSIZE_ERROR) || (pos + dlen > len) )
+		{
+			LogError("Malformed compressed chunk in data plane stream\n");
+			return 0;
+		}
+
+		//Kick off receiving the next chunk while we decompress this one
+		future<bool> pending;
+		bool more = (pos + dlen) < len;
+		if(more)
+			pending = async(launch::async, recvChunk, ref(*next));
+
+		auto written = ZSTD_decompressDCtx(ctx, buf + pos, len - pos, cur->data(), cur->size());
+		if(ZSTD_isError(written))
+		{
+			LogError("Failed to decompress data plane chunk: %s\n", ZSTD_getErrorName(written));
+			if(more)
+				pending.wait();
+			return 0;
+		}
+		pos += written;
+
+		if(progress)
+			progress((float)pos / (float)len);
+
+		if(more)
+		{
+			if(!pending.get())
+				return 0;
+			swap(cur, next);
+		}
+	}
+
+	return len;
+}
+
+#endif	//HAS_ZSTD
+
+void SCPITwinLanTransport::SetDataCompressionEnabled(bool enabled)
+{
+#ifdef HAS_ZSTD
+	if(enabled && !m_zstdContext)
+		m_zstdContext = ZSTD_createDCtx();
+	m_compressionEnabled = enabled;
+#else
+	if(enabled)
+		LogWarning("Can't enable data plane compression, scopehal was built without zstd support\n");
+	m_compressionEnabled = false;
+#endif
+}
+
+bool SCPITwinLanTransport::IsDataCompressionSupported()
+{
+#ifdef HAS_ZSTD
+	return true;
+#else
+	return false;
+#endif
+}
+
 void SCPITwinLanTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_secondarysocket.SendLooped(buf, len);
@@ -57,6 +57,29 @@ public:
 	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
 	virtual void SendRawData(size_t len, const unsigned char* buf) override;
 
+	/**
+		@brief Enables or disables zstd compression of data plane reads
+
+		When enabled, each ReadRawData() expects the bridge to send a sequence of chunks, each consisting of a
+		uint32 compressed length followed by one independent zstd frame, until the requested number of
+		decompressed bytes has been delivered. Raw int8/int16 sample data typically compresses ~3x, so this
+		roughly triples effective waveform bandwidth on links slower than the compression ratio can make up for.
+
+		Compression must only be enabled after the driver has negotiated it with its bridge server (the wire
+		format change is not self-describing); drivers should check IsDataCompressionSupported() first since
+		this is a no-op in builds without zstd.
+
+		@param enabled	True to enable compressed reads, false for raw
+	 */
+	void SetDataCompressionEnabled(bool enabled);
+
+	///@brief Returns true if compressed data plane reads are currently enabled
+	bool IsDataCompressionEnabled()
+	{ return m_compressionEnabled; }
+
+	///@brief Returns true if this build has zstd support compiled in
+	static bool IsDataCompressionSupported();
+
 	TRANSPORT_INITPROC(SCPITwinLanTransport)
 
 	const Socket& GetSecondarySocket()
@@ -66,6 +89,20 @@ protected:
 	unsigned short m_dataport;
 
 	Socket m_secondarysocket;
+
+#ifdef HAS_ZSTD
+	size_t ReadCompressedData(size_t len, unsigned char* buf, std::function<void(float)> progress);
+
+	///@brief Scratch buffers for compressed chunks, double buffered so receive overlaps decompression
+	std::vector<uint8_t> m_compressBufA;
+	std::vector<uint8_t> m_compressBufB;
+
+	///@brief zstd decompression context (ZSTD_DCtx, kept as void* so zstd.h stays out of public headers)
+	void* m_zstdContext;
+#endif
+
+	///@brief True if the data plane is sending compressed chunks
+	bool m_compressionEnabled;
 };
 
 #endif
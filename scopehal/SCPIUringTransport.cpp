@@ -0,0 +1,269 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SCPIUringTransport
+	@ingroup transports
+ */
+
+#include "scopehal.h"
+
+#ifdef HAS_LIBURING
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SCPIUringTransport::SCPIUringTransport(const string& args)
+	: SCPISocketTransport(args)
+	, m_uringOk(false)
+	, m_bufRing(nullptr)
+	, m_bufBase(nullptr)
+	, m_pendingBid(0)
+	, m_pendingOff(0)
+	, m_pendingLen(0)
+	, m_needRearm(false)
+{
+	if(!m_socket.IsValid())
+		return;
+
+	if(0 != io_uring_queue_init(QUEUE_DEPTH, &m_uring, 0))
+	{
+		LogWarning("io_uring_queue_init failed, falling back to blocking socket I/O\n");
+		return;
+	}
+
+	//Register a pool of buffers the kernel delivers receive completions into
+	int err = 0;
+	m_bufRing = io_uring_setup_buf_ring(&m_uring, NUM_BUFFERS, BUFFER_GROUP, 0, &err);
+	if(!m_bufRing)
+	{
+		LogWarning("io_uring_setup_buf_ring failed (%d), falling back to blocking socket I/O\n", err);
+		io_uring_queue_exit(&m_uring);
+		return;
+	}
+	m_bufBase = new uint8_t[NUM_BUFFERS * BUFFER_SIZE];
+	for(unsigned int i=0; i<NUM_BUFFERS; i++)
+	{
+		io_uring_buf_ring_add(
+			m_bufRing, m_bufBase + i*BUFFER_SIZE, BUFFER_SIZE, i, io_uring_buf_ring_mask(NUM_BUFFERS), i);
+	}
+	io_uring_buf_ring_advance(m_bufRing, NUM_BUFFERS);
+
+	m_uringOk = true;
+	ArmReceive();
+}
+
+SCPIUringTransport::~SCPIUringTransport()
+{
+	if(m_uringOk)
+	{
+		io_uring_free_buf_ring(&m_uring, m_bufRing, NUM_BUFFERS, BUFFER_GROUP);
+		io_uring_queue_exit(&m_uring);
+	}
+	delete[] m_bufBase;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Discovery
+
+///@brief Returns the constant transport name "uring"
+string SCPIUringTransport::GetTransportName()
+{
+	return "uring";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Completion handling
+
+/**
+	@brief Arms (or re-arms) the multishot receive on the socket
+
+	Once armed, the kernel keeps generating a completion per incoming chunk with no further submissions from us,
+	until it runs out of provided buffers or the connection drops.
+ */
+void SCPIUringTransport::ArmReceive()
+{
+	auto sqe = io_uring_get_sqe(&m_uring);
+	io_uring_prep_recv_multishot(sqe, m_socket, nullptr, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BUFFER_GROUP;
+	io_uring_submit(&m_uring);
+}
+
+/**
+	@brief Makes sure there's a completion available to consume
+
+	@param blocking	If true, wait (up to the receive timeout) for data to show up.
+					If false, only harvest completions that are already queued.
+
+	@return True if data is available in the pending buffer, false on timeout / error / nothing queued
+ */
+bool SCPIUringTransport::WaitForData(bool blocking)
+{
+	while(m_pendingLen == 0)
+	{
+		struct io_uring_cqe* cqe;
+		if(blocking)
+		{
+			struct __kernel_timespec ts;
+			ts.tv_sec = RX_TIMEOUT_SEC;
+			ts.tv_nsec = 0;
+			if(0 != io_uring_wait_cqe_timeout(&m_uring, &cqe, &ts))
+				return false;
+		}
+		else if(0 != io_uring_peek_cqe(&m_uring, &cqe))
+			return false;
+
+		int res = cqe->res;
+		bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+		unsigned int bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		io_uring_cqe_seen(&m_uring, cqe);
+
+		//Ran out of provided buffers: multishot terminated, re-arm once we've freed one up
+		if(res == -ENOBUFS)
+		{
+			m_needRearm = true;
+			continue;
+		}
+
+		//Connection dropped or hard error
+		if(res <= 0)
+			return false;
+
+		m_pendingBid = bid;
+		m_pendingOff = 0;
+		m_pendingLen = res;
+		if(!more)
+			m_needRearm = true;
+	}
+	return true;
+}
+
+/**
+	@brief Copies data out of the pending completion, returning the buffer to the kernel once fully consumed
+ */
+size_t SCPIUringTransport::ConsumePending(unsigned char* buf, size_t len)
+{
+	size_t n = min(len, m_pendingLen);
+	memcpy(buf, m_bufBase + m_pendingBid*BUFFER_SIZE + m_pendingOff, n);
+	m_pendingOff += n;
+	m_pendingLen -= n;
+
+	if(m_pendingLen == 0)
+	{
+		io_uring_buf_ring_add(
+			m_bufRing, m_bufBase + m_pendingBid*BUFFER_SIZE, BUFFER_SIZE, m_pendingBid,
+			io_uring_buf_ring_mask(NUM_BUFFERS), 0);
+		io_uring_buf_ring_advance(m_bufRing, 1);
+
+		if(m_needRearm)
+		{
+			m_needRearm = false;
+			ArmReceive();
+		}
+	}
+
+	return n;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual transport code
+
+size_t SCPIUringTransport::RecvSome(unsigned char* buf, size_t len)
+{
+	if(!m_uringOk)
+		return SCPISocketTransport::RecvSome(buf, len);
+
+	if(!WaitForData())
+		return 0;
+	return ConsumePending(buf, len);
+}
+
+size_t SCPIUringTransport::ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress)
+{
+	if(!m_uringOk)
+		return SCPISocketTransport::ReadRawData(len, buf, progress);
+
+	size_t pos = 0;
+
+	//Drain anything ReadReply() buffered past the last terminator before touching the completion queue
+	size_t avail = m_rxBufferEnd - m_rxBufferStart;
+	if(avail)
+	{
+		size_t n = min(avail, len);
+		memcpy(buf, &m_rxBuffer[m_rxBufferStart], n);
+		m_rxBufferStart += n;
+		pos = n;
+		if(progress)
+			progress((float)pos / (float)len);
+	}
+
+	while(pos < len)
+	{
+		if(!WaitForData())
+		{
+			LogTrace("Failed to get %zu bytes (@ pos %zu)\n", len, pos);
+			return 0;
+		}
+		pos += ConsumePending(buf + pos, len - pos);
+		if(progress)
+			progress((float)pos / (float)len);
+	}
+	m_stats.m_bytesRead += len;
+	m_stats.m_rawReads ++;
+
+	LogTrace("Got %zu bytes\n", len);
+	return len;
+}
+
+void SCPIUringTransport::FlushRXBuffer(void)
+{
+	if(!m_uringOk)
+	{
+		SCPISocketTransport::FlushRXBuffer();
+		return;
+	}
+
+	//Discard the pending buffer and any completions already queued.
+	//Don't touch the socket directly: the armed multishot recv owns it.
+	unsigned char scratch[4096];
+	while(WaitForData(false))
+	{
+		while(m_pendingLen)
+			ConsumePending(scratch, sizeof(scratch));
+	}
+	m_rxBufferStart = 0;
+	m_rxBufferEnd = 0;
+}
+
+#endif
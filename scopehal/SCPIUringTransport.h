@@ -0,0 +1,119 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SCPIUringTransport
+	@ingroup transports
+ */
+
+#ifndef SCPIUringTransport_h
+#define SCPIUringTransport_h
+
+#ifdef HAS_LIBURING
+
+#include <liburing.h>
+
+/**
+	@brief A SCPISocketTransport which receives through io_uring rather than blocking recv() calls
+
+	A multishot recv is kept armed on the socket, delivering into a pool of provided buffers registered with the
+	kernel, so incoming data is buffered without a syscall per transfer. Read calls consume queued completions and
+	only enter the kernel when the completion queue is empty. This cuts per-transfer overhead when streaming from
+	several high-rate instruments at once.
+
+	Falls back to the inherited blocking path if io_uring setup fails (old kernel, locked memory limits, etc).
+	Sends, which are small and infrequent, always use the blocking path.
+
+	@ingroup transports
+ */
+class SCPIUringTransport : public SCPISocketTransport
+{
+public:
+	SCPIUringTransport(const std::string& args);
+	virtual ~SCPIUringTransport();
+
+	static std::string GetTransportName();
+
+	virtual void FlushRXBuffer(void) override;
+	virtual size_t ReadRawData(size_t len, unsigned char* buf, std::function<void(float)> progress = nullptr) override;
+
+	TRANSPORT_INITPROC(SCPIUringTransport)
+
+protected:
+	virtual size_t RecvSome(unsigned char* buf, size_t len) override;
+
+	void ArmReceive();
+	bool WaitForData(bool blocking = true);
+	size_t ConsumePending(unsigned char* buf, size_t len);
+
+	///@brief Submission/completion queue depth
+	static const unsigned int QUEUE_DEPTH = 64;
+
+	///@brief Number of provided buffers (must be a power of two)
+	static const unsigned int NUM_BUFFERS = 32;
+
+	///@brief Size of each provided buffer, in bytes
+	static const size_t BUFFER_SIZE = 262144;
+
+	///@brief Buffer group ID for the provided buffer ring
+	static const unsigned int BUFFER_GROUP = 0;
+
+	///@brief Receive timeout, in seconds (matches the socket timeout set by SharedCtorInit)
+	static const int64_t RX_TIMEOUT_SEC = 5;
+
+	///@brief True if io_uring setup succeeded and we're using it for receives
+	bool m_uringOk;
+
+	///@brief The ring instance (valid only if m_uringOk)
+	struct io_uring m_uring;
+
+	///@brief Ring of buffers provided to the kernel for receive completions
+	struct io_uring_buf_ring* m_bufRing;
+
+	///@brief Backing storage for the provided buffers (NUM_BUFFERS slots of BUFFER_SIZE each)
+	uint8_t* m_bufBase;
+
+	///@brief Buffer ID of the completion currently being consumed
+	unsigned int m_pendingBid;
+
+	///@brief Read offset within the pending completion
+	size_t m_pendingOff;
+
+	///@brief Bytes remaining in the pending completion
+	size_t m_pendingLen;
+
+	///@brief Set when the multishot recv terminated and must be re-armed
+	bool m_needRearm;
+};
+
+#endif
+
+#endif
@@ -34,6 +34,11 @@
  */
 #include "scopehal.h"
 #include <math.h>
+#include <omp.h>
+
+#ifdef __cpp_lib_to_chars
+#include <charconv>
+#endif
 
 using namespace std;
 
@@ -253,25 +258,59 @@ void SParameters::Allocate(int nports)
 }
 
 /**
-	@brief Serializes a S-parameter model to a Touchstone file
+	@brief Returns the sum of the data revision numbers of all of our parameters
+
+	Changes whenever any parameter changes through the update APIs, so consumers can poll this to decide if cached
+	derived data is still valid.
+ */
+uint64_t SParameters::GetRevision() const
+{
+	uint64_t rev = 0;
+	for(auto& it : m_params)
+		rev += it.second->GetRevision();
+	return rev;
+}
 
-	For now, assumes full 2 port
+/**
+	@brief Returns the sum of the grid revision numbers of all of our parameters
 
-	@param path		Output file name
-	@param format	Output data format
-	@param freqUnit	Frequency units for the generated file
+	Changes only when a frequency grid changes, not when the values at each point do.
  */
-void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUnit freqUnit)
+uint64_t SParameters::GetGridRevision() const
 {
-	if(m_nports != 2)
-	{
-		LogError("SParameters::SaveToFile() only supports 2-port for now\n");
-		return;
-	}
+	uint64_t rev = 0;
+	for(auto& it : m_params)
+		rev += it.second->GetGridRevision();
+	return rev;
+}
+
+///@brief Appends a float to a string in fixed-point notation ("%f" equivalent, but locale independent and faster)
+static void AppendFloat(string& s, float f)
+{
+	char tmp[48];
+#ifdef __cpp_lib_to_chars
+	auto result = to_chars(tmp, tmp + sizeof(tmp), f, chars_format::fixed, 6);
+	s.append(tmp, result.ptr - tmp);
+#else
+	snprintf(tmp, sizeof(tmp), "%f", f);
+	s += tmp;
+#endif
+}
+
+/**
+	@brief Serializes a S-parameter model to a Touchstone file
 
-	if(format != FORMAT_MAG_ANGLE)
-		LogWarning("Formats other than mag-angle not implemented yet (exporting as mag-angle)\n");
+	Supports any port count. Formatting of the frequency points is parallelized across all cores, with each
+	chunk written into its own preallocated buffer and the chunks flushed to disk in order at the end.
 
+	@param path				Output file name
+	@param format			Output data format
+	@param freqUnit			Frequency units for the generated file
+	@param binarySidecar	If set, also write a binary cache next to the file so the next import skips the
+							ASCII parse (see TouchstoneParser)
+ */
+void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUnit freqUnit, bool binarySidecar)
+{
 	FILE* fp = fopen(path.c_str(), "w");
 	if(!fp)
 	{
@@ -305,25 +344,125 @@ void SParameters::SaveToFile(const string& path, ParameterFormat format, FreqUni
 			freqScale = 1e-9;
 			break;
 	}
-	fprintf(fp, "# %s S MA R 50.000\n", freqText.c_str());
+	string formatText;
+	switch(format)
+	{
+		case FORMAT_DBMAG_ANGLE:
+			formatText = "DB";
+			break;
 
-	//Get the parameters
-	auto& s11 = (*this)[SPair(1, 1)];
-	auto& s12 = (*this)[SPair(1, 2)];
-	auto& s21 = (*this)[SPair(2, 1)];
-	auto& s22 = (*this)[SPair(2, 2)];
+		case FORMAT_REAL_IMAGINARY:
+			formatText = "RI";
+			break;
 
-	//Mag-angle format
+		case FORMAT_MAG_ANGLE:
+		default:
+			formatText = "MA";
+			break;
+	}
+	fprintf(fp, "# %s S %s R 50.000\n", freqText.c_str(), formatText.c_str());
+
+	//Gather the parameter vectors in Touchstone order.
+	//2-port uses the classic S11 S21 S12 S22 column order; everything else is row major.
+	vector<SParameterVector*> vecs;
+	if(m_nports == 2)
+	{
+		vecs.push_back(m_params[SPair(1, 1)]);
+		vecs.push_back(m_params[SPair(2, 1)]);
+		vecs.push_back(m_params[SPair(1, 2)]);
+		vecs.push_back(m_params[SPair(2, 2)]);
+	}
+	else
+	{
+		for(size_t to=1; to <= m_nports; to++)
+		{
+			for(size_t from=1; from <= m_nports; from++)
+				vecs.push_back(m_params[SPair(to, from)]);
+		}
+	}
+
+	size_t npoints = vecs[0]->size();
+	for(auto v : vecs)
+		npoints = min(npoints, v->size());
+
+	//Format chunks of frequency points in parallel, each into its own buffer
 	float rad2deg = 180 / M_PI;
-	for(size_t i=0; i<s11.size(); i++)
+	size_t nchunks = min((size_t)(4 * omp_get_max_threads()), npoints / 512 + 1);
+	size_t pointsPerChunk = (npoints + nchunks - 1) / nchunks;
+	vector<string> chunks(nchunks);
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
 	{
-		float freq = s11[i].m_frequency;
-		fprintf(fp, "%f %f %f %f %f %f %f %f %f\n", freq * freqScale,
-			s11[i].m_amplitude, s11[i].m_phase * rad2deg,
-			s21[i].m_amplitude, s21[i].m_phase * rad2deg,
-			s12[i].m_amplitude, s12[i].m_phase * rad2deg,
-			s22[i].m_amplitude, s22[i].m_phase * rad2deg);
+		size_t istart = c * pointsPerChunk;
+		size_t iend = min(istart + pointsPerChunk, npoints);
+
+		auto& out = chunks[c];
+		out.reserve( (iend - istart) * (vecs.size() * 2 + 1) * 12 );
+
+		for(size_t i=istart; i<iend; i++)
+		{
+			AppendFloat(out, (*vecs[0])[i].m_frequency * freqScale);
+
+			size_t pairsOnLine = 0;
+			for(size_t v=0; v<vecs.size(); v++)
+			{
+				auto& point = (*vecs[v])[i];
+
+				float a;
+				float b;
+				switch(format)
+				{
+					case FORMAT_DBMAG_ANGLE:
+						a = 20 * log10(point.m_amplitude);
+						b = point.m_phase * rad2deg;
+						break;
+
+					case FORMAT_REAL_IMAGINARY:
+						a = point.m_amplitude * cosf(point.m_phase);
+						b = point.m_amplitude * sinf(point.m_phase);
+						break;
+
+					case FORMAT_MAG_ANGLE:
+					default:
+						a = point.m_amplitude;
+						b = point.m_phase * rad2deg;
+						break;
+				}
+
+				out += ' ';
+				AppendFloat(out, a);
+				out += ' ';
+				AppendFloat(out, b);
+
+				//For >2 ports, start a new line after each row of the S matrix
+				//(and the spec limits lines to four parameter pairs)
+				pairsOnLine ++;
+				if(m_nports > 2)
+				{
+					bool endOfRow = ( ((v+1) % m_nports) == 0 );
+					if( (endOfRow || (pairsOnLine == 4)) && ((v+1) < vecs.size()) )
+					{
+						out += '\n';
+						pairsOnLine = 0;
+					}
+				}
+			}
+			out += '\n';
+		}
 	}
 
+	//Flush everything in one sequential pass
+	for(auto& chunk : chunks)
+	{
+		if(!chunk.empty())
+			fwrite(chunk.c_str(), 1, chunk.size(), fp);
+	}
 	fclose(fp);
+
+	//Write the binary cache so the next import of this file skips the ASCII parse
+	if(binarySidecar)
+	{
+		TouchstoneParser parser;
+		parser.WriteCacheFor(path, *this);
+	}
 }
@@ -77,6 +77,19 @@ public:
 	SParameterVector()
 	{}
 
+	///@brief Set of changes that UpdateFromWaveforms() can report
+	enum UpdateFlags
+	{
+		///@brief Nothing changed
+		UPDATE_FLAG_NONE	= 0,
+
+		///@brief Magnitude and/or phase values changed, but the frequency grid did not
+		UPDATE_FLAG_VALUES	= 1,
+
+		///@brief The frequency grid (point count or frequencies) changed
+		UPDATE_FLAG_GRID	= 2
+	};
+
 	/**
 		@brief Creates an S-parameter vector from analog waveforms in dB / degree format
 	 */
@@ -139,6 +152,72 @@ public:
 		}
 
 		m_points.MarkModifiedFromCpu();
+
+		//Full rebuild: assume everything changed
+		m_revision ++;
+		m_gridRevision ++;
+	}
+
+	/**
+		@brief Updates the vector in place from a pair of waveforms in mag/angle format.
+
+		Unlike ConvertFromWaveforms(), existing point storage is reused and the revision counters are only bumped
+		if something actually changed. This is intended for continuous sweep acquisition, where an instrument
+		re-measures the same frequency grid at a high update rate: consumers can check the return value (or poll
+		GetRevision() / GetGridRevision()) and skip recomputing cached derived data if nothing moved.
+
+		The waveforms may be sparse or uniformly sampled, but must be sampled at the same frequencies.
+
+		@return Bitwise OR of UpdateFlags values describing what, if anything, changed
+	 */
+	template<class T>
+	__attribute__((noinline))
+	int UpdateFromWaveforms(const T* wmag, const T* wang)
+	{
+		if( (wmag == nullptr) || (wang == nullptr) )
+		{
+			LogError("Null input supplied to SParameterVector::UpdateFromWaveforms\n");
+			return UPDATE_FLAG_NONE;
+		}
+
+		//If the point count changed the grid changed too, so there's nothing to compare against
+		size_t len = std::min(wmag->size(), wang->size());
+		if(len != m_points.size())
+		{
+			ConvertFromWaveforms(wmag, wang);
+			return UPDATE_FLAG_GRID | UPDATE_FLAG_VALUES;
+		}
+
+		m_points.PrepareForCpuAccess();
+
+		int flags = UPDATE_FLAG_NONE;
+		float ascale = M_PI / 180;
+		for(size_t i=0; i<len; i++)
+		{
+			SParameterPoint pt(
+				GetOffsetScaled(wmag, i),
+				pow(10, wmag->m_samples[i] / 20),
+				wang->m_samples[i] * ascale);
+
+			auto& old = m_points[i];
+			if(old.m_frequency != pt.m_frequency)
+				flags |= UPDATE_FLAG_GRID;
+			if( (old.m_amplitude != pt.m_amplitude) || (old.m_phase != pt.m_phase) )
+				flags |= UPDATE_FLAG_VALUES;
+
+			old = pt;
+		}
+
+		if(flags != UPDATE_FLAG_NONE)
+		{
+			m_points.MarkModifiedFromCpu();
+
+			m_revision ++;
+			if(flags & UPDATE_FLAG_GRID)
+				m_gridRevision ++;
+		}
+
+		return flags;
 	}
 
 	/**
@@ -164,6 +243,10 @@ public:
 			m_points[i] = SParameterPoint(GetOffsetScaled(wmag, i), 0, 0);
 
 		m_points.MarkModifiedFromCpu();
+
+		//Full rebuild: assume everything changed
+		m_revision ++;
+		m_gridRevision ++;
 	}
 
 	void ConvertToWaveforms(SparseAnalogWaveform* wmag, SparseAnalogWaveform* wang);
@@ -172,6 +255,7 @@ public:
 	float InterpolateMagnitude(float frequency) const;
 	float InterpolateAngle(float frequency) const;
 
+	///@brief Point data. Writing to this directly does not bump the revision counters.
 	AcceleratorBuffer<SParameterPoint> m_points;
 
 	void resize(size_t nsize)
@@ -186,10 +270,28 @@ public:
 	{ return m_points[i]; }
 
 	void clear()
-	{ m_points.clear(); }
+	{
+		m_points.clear();
+		m_revision ++;
+		m_gridRevision ++;
+	}
+
+	///@brief Returns a revision number that increments whenever the point data changes
+	uint64_t GetRevision() const
+	{ return m_revision; }
+
+	///@brief Returns a revision number that increments only when the frequency grid changes, not the values at each point
+	uint64_t GetGridRevision() const
+	{ return m_gridRevision; }
 
 protected:
 	float InterpolatePhase(float phase_lo, float phase_hi, float frac) const;
+
+	///@brief Incremented whenever the point data changes through the update APIs
+	uint64_t m_revision = 0;
+
+	///@brief Incremented only when the frequency grid changes through the update APIs
+	uint64_t m_gridRevision = 0;
 };
 
 typedef std::pair<int, int> SPair;
@@ -221,6 +323,20 @@ public:
 	const SParameterVector& operator[] (SPair pair) const
 	{ return *(m_params.find(pair)->second); }
 
+	/**
+		@brief Updates a single S-parameter in place from mag/angle waveforms without reallocating point storage
+
+		See SParameterVector::UpdateFromWaveforms() for details.
+
+		@return Bitwise OR of SParameterVector::UpdateFlags values describing what, if anything, changed
+	 */
+	template<class T>
+	int UpdateFromWaveforms(int to, int from, const T* wmag, const T* wang)
+	{ return m_params[ SPair(to, from) ]->UpdateFromWaveforms(wmag, wang); }
+
+	uint64_t GetRevision() const;
+	uint64_t GetGridRevision() const;
+
 	friend class TouchstoneParser;
 
 	enum FreqUnit
@@ -238,7 +354,11 @@ public:
 		FORMAT_REAL_IMAGINARY
 	};
 
-	void SaveToFile(const std::string& path, ParameterFormat format = FORMAT_MAG_ANGLE, FreqUnit freqUnit = FREQ_GHZ);
+	void SaveToFile(
+		const std::string& path,
+		ParameterFormat format = FORMAT_MAG_ANGLE,
+		FreqUnit freqUnit = FREQ_GHZ,
+		bool binarySidecar = false);
 
 	size_t GetNumPorts() const
 	{ return m_nports; }
@@ -0,0 +1,997 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of vectorized raw-sample-to-fp32 conversion helpers
+ */
+
+#include "scopehal.h"
+#include "SampleConversion.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+#include <omp.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers for converting raw 8-bit ADC samples to fp32 waveforms
+
+/**
+	@brief Converts 8-bit ADC samples to floating point
+ */
+void ConvertSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count)
+{
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 32 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 32);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+			{
+				Convert8BitSamplesAVX2(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+			else
+			#endif /* __x86_64__ */
+			{
+				Convert8BitSamplesGeneric(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			Convert8BitSamplesAVX2(pout, pin, gain, offset, count);
+		else
+		#endif
+			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
+	}
+}
+
+/**
+	@brief Generic backend for 8-bit ConvertSamples()
+ */
+void Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count)
+{
+	for(unsigned int k=0; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Optimized version of 8-bit ConvertSamples()
+ */
+__attribute__((target("avx2")))
+void Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count)
+{
+	unsigned int end = count - (count % 32);
+
+	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+
+	for(unsigned int k=0; k<end; k += 32)
+	{
+		//Load all 32 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
+
+		//Extract the low and high 16 samples from the block
+		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
+		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
+
+		//Swap the low and high halves of these vectors
+		//Ugly casting needed because all permute instrinsics expect float/double datatypes
+		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
+		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
+
+		//Divide into blocks of 8 samples and sign extend to 32 bit
+		__m256i block0_int = _mm256_cvtepi8_epi32(block01_x8);
+		__m256i block1_int = _mm256_cvtepi8_epi32(block10_x8);
+		__m256i block2_int = _mm256_cvtepi8_epi32(block23_x8);
+		__m256i block3_int = _mm256_cvtepi8_epi32(block32_x8);
+
+		//Convert the 32-bit int blocks to float.
+		//Apparently there's no direct epi8 to ps conversion instruction.
+		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
+		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
+		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
+		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm256_mul_ps(block0_float, gains);
+		block1_float = _mm256_mul_ps(block1_float, gains);
+		block2_float = _mm256_mul_ps(block2_float, gains);
+		block3_float = _mm256_mul_ps(block3_float, gains);
+
+		block0_float = _mm256_sub_ps(block0_float, offsets);
+		block1_float = _mm256_sub_ps(block1_float, offsets);
+		block2_float = _mm256_sub_ps(block2_float, offsets);
+		block3_float = _mm256_sub_ps(block3_float, offsets);
+
+		//All done, store back to the output buffer
+		_mm256_store_ps(pout + k, 		block0_float);
+		_mm256_store_ps(pout + k + 8,	block1_float);
+		_mm256_store_ps(pout + k + 16,	block2_float);
+		_mm256_store_ps(pout + k + 24,	block3_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(unsigned int k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Converts Unsigned 8-bit ADC samples to floating point
+ */
+void ConvertSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+{
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 32 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 32);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+			{
+				ConvertUnsigned8BitSamplesAVX2(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+			else
+			#endif
+			{
+				ConvertUnsigned8BitSamplesGeneric(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ConvertUnsigned8BitSamplesAVX2(pout, pin, gain, offset, count);
+		else
+		#endif
+			ConvertUnsigned8BitSamplesGeneric(pout, pin, gain, offset, count);
+	}
+}
+
+/**
+	@brief Generic backend for unsigned 8-bit ConvertSamples()
+ */
+void ConvertUnsigned8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+{
+	for(unsigned int k=0; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Optimized version of unsigned 8-bit ConvertSamples()
+ */
+__attribute__((target("avx2")))
+void ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count)
+{
+	unsigned int end = count - (count % 32);
+
+	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+
+	for(unsigned int k=0; k<end; k += 32)
+	{
+		//Load all 32 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m256i raw_samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
+
+		//Extract the low and high 16 samples from the block
+		__m128i block01_x8 = _mm256_extracti128_si256(raw_samples, 0);
+		__m128i block23_x8 = _mm256_extracti128_si256(raw_samples, 1);
+
+		//Swap the low and high halves of these vectors
+		//Ugly casting needed because all permute instrinsics expect float/double datatypes
+		__m128i block10_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block01_x8), 1));
+		__m128i block32_x8 = _mm_castpd_si128(_mm_permute_pd(_mm_castsi128_pd(block23_x8), 1));
+
+		//Divide into blocks of 8 samples and sign extend to 32 bit
+		__m256i block0_int = _mm256_cvtepu8_epi32(block01_x8);
+		__m256i block1_int = _mm256_cvtepu8_epi32(block10_x8);
+		__m256i block2_int = _mm256_cvtepu8_epi32(block23_x8);
+		__m256i block3_int = _mm256_cvtepu8_epi32(block32_x8);
+
+		//Convert the 32-bit int blocks to float.
+		//Apparently there's no direct epi8 to ps conversion instruction.
+		__m256 block0_float = _mm256_cvtepi32_ps(block0_int);
+		__m256 block1_float = _mm256_cvtepi32_ps(block1_int);
+		__m256 block2_float = _mm256_cvtepi32_ps(block2_int);
+		__m256 block3_float = _mm256_cvtepi32_ps(block3_int);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm256_mul_ps(block0_float, gains);
+		block1_float = _mm256_mul_ps(block1_float, gains);
+		block2_float = _mm256_mul_ps(block2_float, gains);
+		block3_float = _mm256_mul_ps(block3_float, gains);
+
+		block0_float = _mm256_sub_ps(block0_float, offsets);
+		block1_float = _mm256_sub_ps(block1_float, offsets);
+		block2_float = _mm256_sub_ps(block2_float, offsets);
+		block3_float = _mm256_sub_ps(block3_float, offsets);
+
+		//All done, store back to the output buffer
+		_mm256_store_ps(pout + k, 		block0_float);
+		_mm256_store_ps(pout + k + 8,	block1_float);
+		_mm256_store_ps(pout + k + 16,	block2_float);
+		_mm256_store_ps(pout + k + 24,	block3_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(unsigned int k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers for converting raw 16-bit ADC samples to fp32 waveforms
+
+/**
+	@brief Converts 16-bit ADC samples to floating point
+ */
+void ConvertSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 64 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 64);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx512F)
+			{
+				Convert16BitSamplesAVX512F(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+			else if(g_hasAvx2)
+			{
+				if(g_hasFMA)
+				{
+					Convert16BitSamplesFMA(
+						pout + off,
+						pin + off,
+						gain,
+						offset,
+						nsamp);
+				}
+				else
+				{
+					Convert16BitSamplesAVX2(
+						pout + off,
+						pin + off,
+						gain,
+						offset,
+						nsamp);
+				}
+			}
+			else
+			#endif /* __x86_64__ */
+			{
+				Convert16BitSamplesGeneric(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+		{
+			if(g_hasFMA)
+				Convert16BitSamplesFMA(pout, pin, gain, offset, count);
+			else
+				Convert16BitSamplesAVX2(pout, pin, gain, offset, count);
+		}
+		else
+		#endif /* __x86_64__ */
+			Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
+	}
+}
+
+/**
+	@brief Generic backend for 16-bit ConvertSamples()
+ */
+void Convert16BitSamplesGeneric(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	for(size_t j=0; j<count; j++)
+		pout[j] = gain*pin[j] - offset;
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void Convert16BitSamplesAVX2(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	size_t end = count - (count % 32);
+
+	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+
+	for(size_t k=0; k<end; k += 32)
+	{
+		//Load all 32 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m256i raw_samples1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
+		__m256i raw_samples2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 16));
+
+		//Extract the low and high halves (8 samples each) from the input blocks
+		__m128i block0_i16 = _mm256_extracti128_si256(raw_samples1, 0);
+		__m128i block1_i16 = _mm256_extracti128_si256(raw_samples1, 1);
+		__m128i block2_i16 = _mm256_extracti128_si256(raw_samples2, 0);
+		__m128i block3_i16 = _mm256_extracti128_si256(raw_samples2, 1);
+
+		//Convert both blocks from 16 to 32 bit, giving us a pair of 8x int32 vectors
+		__m256i block0_i32 = _mm256_cvtepi16_epi32(block0_i16);
+		__m256i block1_i32 = _mm256_cvtepi16_epi32(block1_i16);
+		__m256i block2_i32 = _mm256_cvtepi16_epi32(block2_i16);
+		__m256i block3_i32 = _mm256_cvtepi16_epi32(block3_i16);
+
+		//Convert the 32-bit int blocks to fp32
+		//Sadly there's no direct epi16 to ps conversion instruction.
+		__m256 block0_float = _mm256_cvtepi32_ps(block0_i32);
+		__m256 block1_float = _mm256_cvtepi32_ps(block1_i32);
+		__m256 block2_float = _mm256_cvtepi32_ps(block2_i32);
+		__m256 block3_float = _mm256_cvtepi32_ps(block3_i32);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm256_mul_ps(block0_float, gains);
+		block1_float = _mm256_mul_ps(block1_float, gains);
+		block2_float = _mm256_mul_ps(block2_float, gains);
+		block3_float = _mm256_mul_ps(block3_float, gains);
+
+		block0_float = _mm256_sub_ps(block0_float, offsets);
+		block1_float = _mm256_sub_ps(block1_float, offsets);
+		block2_float = _mm256_sub_ps(block2_float, offsets);
+		block3_float = _mm256_sub_ps(block3_float, offsets);
+
+		//All done, store back to the output buffer
+		_mm256_store_ps(pout + k, 		block0_float);
+		_mm256_store_ps(pout + k + 8,	block1_float);
+		_mm256_store_ps(pout + k + 16,	block2_float);
+		_mm256_store_ps(pout + k + 24,	block3_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+
+__attribute__((target("avx2,fma")))
+void Convert16BitSamplesFMA(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	size_t end = count - (count % 64);
+
+	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+
+	for(size_t k=0; k<end; k += 64)
+	{
+		//Load all 64 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m256i raw_samples1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
+		__m256i raw_samples2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 16));
+		__m256i raw_samples3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 32));
+		__m256i raw_samples4 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 48));
+
+		//Extract the low and high halves (8 samples each) from the input blocks
+		__m128i block0_i16 = _mm256_extracti128_si256(raw_samples1, 0);
+		__m128i block1_i16 = _mm256_extracti128_si256(raw_samples1, 1);
+		__m128i block2_i16 = _mm256_extracti128_si256(raw_samples2, 0);
+		__m128i block3_i16 = _mm256_extracti128_si256(raw_samples2, 1);
+		__m128i block4_i16 = _mm256_extracti128_si256(raw_samples3, 0);
+		__m128i block5_i16 = _mm256_extracti128_si256(raw_samples3, 1);
+		__m128i block6_i16 = _mm256_extracti128_si256(raw_samples4, 0);
+		__m128i block7_i16 = _mm256_extracti128_si256(raw_samples4, 1);
+
+		//Convert the blocks from 16 to 32 bit, giving us a pair of 8x int32 vectors
+		__m256i block0_i32 = _mm256_cvtepi16_epi32(block0_i16);
+		__m256i block1_i32 = _mm256_cvtepi16_epi32(block1_i16);
+		__m256i block2_i32 = _mm256_cvtepi16_epi32(block2_i16);
+		__m256i block3_i32 = _mm256_cvtepi16_epi32(block3_i16);
+		__m256i block4_i32 = _mm256_cvtepi16_epi32(block4_i16);
+		__m256i block5_i32 = _mm256_cvtepi16_epi32(block5_i16);
+		__m256i block6_i32 = _mm256_cvtepi16_epi32(block6_i16);
+		__m256i block7_i32 = _mm256_cvtepi16_epi32(block7_i16);
+
+		//Convert the 32-bit int blocks to fp32
+		//Sadly there's no direct epi16 to ps conversion instruction.
+		__m256 block0_float = _mm256_cvtepi32_ps(block0_i32);
+		__m256 block1_float = _mm256_cvtepi32_ps(block1_i32);
+		__m256 block2_float = _mm256_cvtepi32_ps(block2_i32);
+		__m256 block3_float = _mm256_cvtepi32_ps(block3_i32);
+		__m256 block4_float = _mm256_cvtepi32_ps(block4_i32);
+		__m256 block5_float = _mm256_cvtepi32_ps(block5_i32);
+		__m256 block6_float = _mm256_cvtepi32_ps(block6_i32);
+		__m256 block7_float = _mm256_cvtepi32_ps(block7_i32);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm256_fmsub_ps(block0_float, gains, offsets);
+		block1_float = _mm256_fmsub_ps(block1_float, gains, offsets);
+		block2_float = _mm256_fmsub_ps(block2_float, gains, offsets);
+		block3_float = _mm256_fmsub_ps(block3_float, gains, offsets);
+		block4_float = _mm256_fmsub_ps(block4_float, gains, offsets);
+		block5_float = _mm256_fmsub_ps(block5_float, gains, offsets);
+		block6_float = _mm256_fmsub_ps(block6_float, gains, offsets);
+		block7_float = _mm256_fmsub_ps(block7_float, gains, offsets);
+
+		//All done, store back to the output buffer
+		_mm256_store_ps(pout + k, 		block0_float);
+		_mm256_store_ps(pout + k + 8,	block1_float);
+		_mm256_store_ps(pout + k + 16,	block2_float);
+		_mm256_store_ps(pout + k + 24,	block3_float);
+
+		_mm256_store_ps(pout + k + 32,	block4_float);
+		_mm256_store_ps(pout + k + 40,	block5_float);
+		_mm256_store_ps(pout + k + 48,	block6_float);
+		_mm256_store_ps(pout + k + 56,	block7_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+
+//WORKAROUND https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593 on Debian bookworm
+#if !defined(__llvm__) && ((__GNUC__ < 12) || ((__GNUC__ == 12) && (__GNUC_MINOR <= 2)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+void Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, float gain, float offset, size_t count)
+{
+	size_t end = count - (count % 64);
+
+	__m512 gains = _mm512_set1_ps(gain);
+	__m512 offsets = _mm512_set1_ps(offset);
+
+	for(size_t k=0; k<end; k += 64)
+	{
+		//Load all 64 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m512i raw_samples1 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pin + k));
+		__m512i raw_samples2 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(pin + k + 32));
+
+		//Extract the high and low halves (16 samples each) from the input blocks
+		__m256i block0_i16 = _mm512_extracti64x4_epi64(raw_samples1, 0);
+		__m256i block1_i16 = _mm512_extracti64x4_epi64(raw_samples1, 1);
+		__m256i block2_i16 = _mm512_extracti64x4_epi64(raw_samples2, 0);
+		__m256i block3_i16 = _mm512_extracti64x4_epi64(raw_samples2, 1);
+
+		//Convert the blocks from 16 to 32 bit, giving us a pair of 16x int32 vectors
+		__m512i block0_i32 = _mm512_cvtepi16_epi32(block0_i16);
+		__m512i block1_i32 = _mm512_cvtepi16_epi32(block1_i16);
+		__m512i block2_i32 = _mm512_cvtepi16_epi32(block2_i16);
+		__m512i block3_i32 = _mm512_cvtepi16_epi32(block3_i16);
+
+		//Convert the 32-bit int blocks to fp32
+		//Sadly there's no direct epi16 to ps conversion instruction.
+		__m512 block0_float = _mm512_cvtepi32_ps(block0_i32);
+		__m512 block1_float = _mm512_cvtepi32_ps(block1_i32);
+		__m512 block2_float = _mm512_cvtepi32_ps(block2_i32);
+		__m512 block3_float = _mm512_cvtepi32_ps(block3_i32);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm512_fmsub_ps(block0_float, gains, offsets);
+		block1_float = _mm512_fmsub_ps(block1_float, gains, offsets);
+		block2_float = _mm512_fmsub_ps(block2_float, gains, offsets);
+		block3_float = _mm512_fmsub_ps(block3_float, gains, offsets);
+
+		//All done, store back to the output buffer
+		_mm512_store_ps(pout + k, 		block0_float);
+		_mm512_store_ps(pout + k + 16,	block1_float);
+		_mm512_store_ps(pout + k + 32,	block2_float);
+		_mm512_store_ps(pout + k + 48,	block3_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+#if !defined(__llvm__) && ((__GNUC__ < 12) || ((__GNUC__ == 12) && (__GNUC_MINOR <= 2)))
+#pragma GCC diagnostic pop
+#endif
+
+#endif /* __x86_64__ */
+
+/**
+	@brief Converts unsigned 16-bit ADC samples to floating point
+ */
+void ConvertSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
+{
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 32 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 32);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+			{
+				ConvertUnsigned16BitSamplesAVX2(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+			else
+			#endif
+			{
+				ConvertUnsigned16BitSamplesGeneric(
+					pout + off,
+					pin + off,
+					gain,
+					offset,
+					nsamp);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ConvertUnsigned16BitSamplesAVX2(pout, pin, gain, offset, count);
+		else
+		#endif
+			ConvertUnsigned16BitSamplesGeneric(pout, pin, gain, offset, count);
+	}
+}
+
+/**
+	@brief Generic backend for unsigned 16-bit ConvertSamples()
+ */
+void ConvertUnsigned16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
+{
+	for(size_t j=0; j<count; j++)
+		pout[j] = gain*pin[j] - offset;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Optimized version of unsigned 16-bit ConvertSamples()
+ */
+__attribute__((target("avx2")))
+void ConvertUnsigned16BitSamplesAVX2(float* pout, const uint16_t* pin, float gain, float offset, size_t count)
+{
+	size_t end = count - (count % 32);
+
+	__m256 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+	__m256 offsets = { offset, offset, offset, offset, offset, offset, offset, offset };
+
+	for(size_t k=0; k<end; k += 32)
+	{
+		//Load all 32 raw ADC samples, without assuming alignment
+		//(on most modern Intel processors, load and loadu have same latency/throughput)
+		__m256i raw_samples1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k));
+		__m256i raw_samples2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pin + k + 16));
+
+		//Extract the low and high halves (8 samples each) from the input blocks
+		__m128i block0_i16 = _mm256_extracti128_si256(raw_samples1, 0);
+		__m128i block1_i16 = _mm256_extracti128_si256(raw_samples1, 1);
+		__m128i block2_i16 = _mm256_extracti128_si256(raw_samples2, 0);
+		__m128i block3_i16 = _mm256_extracti128_si256(raw_samples2, 1);
+
+		//Zero extend both blocks from 16 to 32 bit, giving us a pair of 8x int32 vectors
+		__m256i block0_i32 = _mm256_cvtepu16_epi32(block0_i16);
+		__m256i block1_i32 = _mm256_cvtepu16_epi32(block1_i16);
+		__m256i block2_i32 = _mm256_cvtepu16_epi32(block2_i16);
+		__m256i block3_i32 = _mm256_cvtepu16_epi32(block3_i16);
+
+		//Convert the 32-bit int blocks to fp32
+		//Sadly there's no direct epi16 to ps conversion instruction.
+		__m256 block0_float = _mm256_cvtepi32_ps(block0_i32);
+		__m256 block1_float = _mm256_cvtepi32_ps(block1_i32);
+		__m256 block2_float = _mm256_cvtepi32_ps(block2_i32);
+		__m256 block3_float = _mm256_cvtepi32_ps(block3_i32);
+
+		//Woo! We've finally got floating point data. Now we can do the fun part.
+		block0_float = _mm256_mul_ps(block0_float, gains);
+		block1_float = _mm256_mul_ps(block1_float, gains);
+		block2_float = _mm256_mul_ps(block2_float, gains);
+		block3_float = _mm256_mul_ps(block3_float, gains);
+
+		block0_float = _mm256_sub_ps(block0_float, offsets);
+		block1_float = _mm256_sub_ps(block1_float, offsets);
+		block2_float = _mm256_sub_ps(block2_float, offsets);
+		block3_float = _mm256_sub_ps(block3_float, offsets);
+
+		//All done, store back to the output buffer
+		_mm256_store_ps(pout + k, 		block0_float);
+		_mm256_store_ps(pout + k + 8,	block1_float);
+		_mm256_store_ps(pout + k + 16,	block2_float);
+		_mm256_store_ps(pout + k + 24,	block3_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k] * gain - offset;
+}
+#endif /* __x86_64__ */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers for de-interleaving channel-interleaved ADC samples while converting to fp32
+
+/**
+	@brief De-interleaves and converts 8-bit ADC samples to floating point
+
+	Computes pout[i] = pin[i*stride + phase] * gain - offset, extracting one channel from a time-multiplexed
+	multi-ADC stream and scaling it in a single pass through memory.
+ */
+void ConvertInterleavedSamples(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	//Contiguous input is just a conversion, hand off to the dense kernels
+	if(stride <= 1)
+	{
+		ConvertSamples(pout, pin + phase, gain, offset, count);
+		return;
+	}
+
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 8 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 8);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+			{
+				Deinterleave8BitSamplesAVX2(
+					pout + off,
+					pin + off*stride,
+					gain,
+					offset,
+					nsamp,
+					stride,
+					phase);
+			}
+			else
+			#endif /* __x86_64__ */
+			{
+				Deinterleave8BitSamplesGeneric(
+					pout + off,
+					pin + off*stride,
+					gain,
+					offset,
+					nsamp,
+					stride,
+					phase);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			Deinterleave8BitSamplesAVX2(pout, pin, gain, offset, count, stride, phase);
+		else
+		#endif
+			Deinterleave8BitSamplesGeneric(pout, pin, gain, offset, count, stride, phase);
+	}
+}
+
+/**
+	@brief Generic backend for 8-bit ConvertInterleavedSamples()
+ */
+void Deinterleave8BitSamplesGeneric(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	for(size_t k=0; k<count; k++)
+		pout[k] = pin[k*stride + phase] * gain - offset;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Optimized version of 8-bit ConvertInterleavedSamples()
+
+	Uses dword gathers to pull one sample per lane from the interleaved stream; there is no byte-granularity
+	gather instruction, so each lane loads the dword at the sample address and sign extends the low byte.
+ */
+__attribute__((target("avx2")))
+void Deinterleave8BitSamplesAVX2(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	//Each gather lane reads a full dword at the sample address, so stop the SIMD loop a few samples short of
+	//the end of the input buffer and pick up the remainder in the scalar tail
+	size_t guard = (3 + stride - 1) / stride;
+	size_t end = (count > guard) ? (count - guard) : 0;
+	end -= (end % 8);
+
+	__m256 gains = _mm256_set1_ps(gain);
+	__m256 offsets = _mm256_set1_ps(offset);
+
+	//Byte offsets of the first 8 samples, and the distance to the next block of 8
+	int s = (int)stride;
+	int p = (int)phase;
+	__m256i vindex = _mm256_setr_epi32(p, p + s, p + 2*s, p + 3*s, p + 4*s, p + 5*s, p + 6*s, p + 7*s);
+	__m256i vstep = _mm256_set1_epi32(8*s);
+
+	for(size_t k=0; k<end; k += 8)
+	{
+		//Gather one dword per output sample (the sample is in the low byte of each lane)
+		__m256i raw_samples = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pin), vindex, 1);
+		vindex = _mm256_add_epi32(vindex, vstep);
+
+		//Sign extend the low byte of each lane to 32 bits
+		raw_samples = _mm256_srai_epi32(_mm256_slli_epi32(raw_samples, 24), 24);
+
+		//Convert to fp32, scale, and store back to the output buffer
+		__m256 block_float = _mm256_cvtepi32_ps(raw_samples);
+		block_float = _mm256_mul_ps(block_float, gains);
+		block_float = _mm256_sub_ps(block_float, offsets);
+		_mm256_store_ps(pout + k, block_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k*stride + phase] * gain - offset;
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief De-interleaves and converts 16-bit ADC samples to floating point
+
+	Computes pout[i] = pin[i*stride + phase] * gain - offset, extracting one channel from a time-multiplexed
+	multi-ADC stream and scaling it in a single pass through memory.
+ */
+void ConvertInterleavedSamples(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	//Contiguous input is just a conversion, hand off to the dense kernels
+	if(stride <= 1)
+	{
+		ConvertSamples(pout, pin + phase, gain, offset, count);
+		return;
+	}
+
+	//Divide large waveforms (>1M points) into blocks and multithread them
+	//TODO: tune split
+	if(count > 1000000)
+	{
+		//Round blocks to multiples of 8 samples for clean vectorization
+		size_t numblocks = omp_get_max_threads();
+		size_t lastblock = numblocks - 1;
+		size_t blocksize = count / numblocks;
+		blocksize = blocksize - (blocksize % 8);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<numblocks; i++)
+		{
+			//Last block gets any extra that didn't divide evenly
+			size_t nsamp = blocksize;
+			if(i == lastblock)
+				nsamp = count - i*blocksize;
+
+			size_t off = i*blocksize;
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+			{
+				Deinterleave16BitSamplesAVX2(
+					pout + off,
+					pin + off*stride,
+					gain,
+					offset,
+					nsamp,
+					stride,
+					phase);
+			}
+			else
+			#endif /* __x86_64__ */
+			{
+				Deinterleave16BitSamplesGeneric(
+					pout + off,
+					pin + off*stride,
+					gain,
+					offset,
+					nsamp,
+					stride,
+					phase);
+			}
+		}
+	}
+
+	//Small waveforms get done single threaded to avoid overhead
+	else
+	{
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			Deinterleave16BitSamplesAVX2(pout, pin, gain, offset, count, stride, phase);
+		else
+		#endif
+			Deinterleave16BitSamplesGeneric(pout, pin, gain, offset, count, stride, phase);
+	}
+}
+
+/**
+	@brief Generic backend for 16-bit ConvertInterleavedSamples()
+ */
+void Deinterleave16BitSamplesGeneric(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	for(size_t k=0; k<count; k++)
+		pout[k] = pin[k*stride + phase] * gain - offset;
+}
+
+#ifdef __x86_64__
+/**
+	@brief Optimized version of 16-bit ConvertInterleavedSamples()
+
+	Uses dword gathers to pull one sample per lane from the interleaved stream; there is no word-granularity
+	gather instruction, so each lane loads the dword at the sample address and sign extends the low word.
+ */
+__attribute__((target("avx2")))
+void Deinterleave16BitSamplesAVX2(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase)
+{
+	//Each gather lane reads a full dword at the sample address, so stop the SIMD loop one sample short of
+	//the end of the input buffer and pick up the remainder in the scalar tail
+	size_t end = (count > 1) ? (count - 1) : 0;
+	end -= (end % 8);
+
+	__m256 gains = _mm256_set1_ps(gain);
+	__m256 offsets = _mm256_set1_ps(offset);
+
+	//Element offsets of the first 8 samples, and the distance to the next block of 8
+	int s = (int)stride;
+	int p = (int)phase;
+	__m256i vindex = _mm256_setr_epi32(p, p + s, p + 2*s, p + 3*s, p + 4*s, p + 5*s, p + 6*s, p + 7*s);
+	__m256i vstep = _mm256_set1_epi32(8*s);
+
+	for(size_t k=0; k<end; k += 8)
+	{
+		//Gather one dword per output sample (the sample is in the low word of each lane)
+		__m256i raw_samples = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pin), vindex, 2);
+		vindex = _mm256_add_epi32(vindex, vstep);
+
+		//Sign extend the low word of each lane to 32 bits
+		raw_samples = _mm256_srai_epi32(_mm256_slli_epi32(raw_samples, 16), 16);
+
+		//Convert to fp32, scale, and store back to the output buffer
+		__m256 block_float = _mm256_cvtepi32_ps(raw_samples);
+		block_float = _mm256_mul_ps(block_float, gains);
+		block_float = _mm256_sub_ps(block_float, offsets);
+		_mm256_store_ps(pout + k, block_float);
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t k=end; k<count; k++)
+		pout[k] = pin[k*stride + phase] * gain - offset;
+}
+#endif /* __x86_64__ */
@@ -0,0 +1,84 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of vectorized raw-sample-to-fp32 conversion helpers
+
+	Each overload of ConvertSamples() computes pout[i] = pin[i] * gain - offset, picking the best SIMD backend
+	available at runtime and splitting large waveforms across threads. The overload set gives compile-time
+	dispatch on the source sample format, so callers (drivers, AcceleratorBuffer::CopyConvertFrom) share one
+	optimized implementation per format.
+
+	The ConvertInterleavedSamples() overloads additionally de-interleave channel-interleaved ADC data in the
+	same pass, computing pout[i] = pin[i*stride + phase] * gain - offset, so drivers fed by time-multiplexed
+	multi-ADC streams can do reassembly and conversion in a single trip through memory.
+ */
+#ifndef SampleConversion_h
+#define SampleConversion_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+void ConvertSamples(float* pout, const int8_t* pin, float gain, float offset, size_t count);
+void ConvertSamples(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
+void ConvertSamples(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+void ConvertSamples(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
+
+void ConvertInterleavedSamples(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+void ConvertInterleavedSamples(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+
+//Scalar backends
+void Convert8BitSamplesGeneric(float* pout, const int8_t* pin, float gain, float offset, size_t count);
+void ConvertUnsigned8BitSamplesGeneric(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
+void Convert16BitSamplesGeneric(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+void ConvertUnsigned16BitSamplesGeneric(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
+void Deinterleave8BitSamplesGeneric(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+void Deinterleave16BitSamplesGeneric(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+
+#ifdef __x86_64__
+//Vectorized backends, only safe to call if the matching CPU feature flag is set
+void Convert8BitSamplesAVX2(float* pout, const int8_t* pin, float gain, float offset, size_t count);
+void ConvertUnsigned8BitSamplesAVX2(float* pout, const uint8_t* pin, float gain, float offset, size_t count);
+void Convert16BitSamplesAVX2(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+void Convert16BitSamplesFMA(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+void Convert16BitSamplesAVX512F(float* pout, const int16_t* pin, float gain, float offset, size_t count);
+void ConvertUnsigned16BitSamplesAVX2(float* pout, const uint16_t* pin, float gain, float offset, size_t count);
+void Deinterleave8BitSamplesAVX2(
+	float* pout, const int8_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+void Deinterleave16BitSamplesAVX2(
+	float* pout, const int16_t* pin, float gain, float offset, size_t count, size_t stride, size_t phase);
+#endif
+
+#endif
@@ -0,0 +1,350 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of ScalarStreamStats
+	@ingroup datamodel
+ */
+
+#include "scopehal.h"
+#include "ScalarStreamStats.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Initializes the aggregator
+
+	@param histogramBins	Number of histogram bins
+	@param ringDepth		Number of raw samples to retain
+	@param bucketSeconds	Width of one time bucket for windowed queries, in seconds
+ */
+ScalarStreamStats::ScalarStreamStats(size_t histogramBins, size_t ringDepth, double bucketSeconds)
+	: m_histogramBins(histogramBins)
+	, m_histMin(0)
+	, m_histMax(0)
+	, m_histValid(false)
+	, m_bucketSeconds(bucketSeconds)
+	, m_startTime(0)
+	, m_haveStartTime(false)
+	, m_openBucketIndex(0)
+	, m_ringDepth(ringDepth)
+	, m_ringNext(0)
+{
+	m_histCounts.resize(histogramBins);
+	m_ring.reserve(ringDepth);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sample ingest
+
+///@brief Records a sample taken right now
+void ScalarStreamStats::AddSample(float value)
+{
+	AddSample(value, GetTime());
+}
+
+/**
+	@brief Records a sample
+
+	Non-finite values (sensor glitches, transport errors) are discarded so they cannot poison the running sums.
+
+	@param value		Sample value
+	@param timestamp	Time the sample was taken, in seconds (GetTime() epoch)
+ */
+void ScalarStreamStats::AddSample(float value, double timestamp)
+{
+	if(!isfinite(value))
+		return;
+
+	lock_guard<mutex> lock(m_mutex);
+
+	//Session-wide running statistics
+	m_session.m_count ++;
+	m_session.m_sum += value;
+	m_session.m_min = min(m_session.m_min, value);
+	m_session.m_max = max(m_session.m_max, value);
+
+	//Histogram: anchor the range on the first sample, then widen as needed
+	if(!m_histValid)
+	{
+		m_histMin = value - 0.5;
+		m_histMax = value + 0.5;
+		m_histValid = true;
+	}
+	if( (value < m_histMin) || (value >= m_histMax) )
+		WidenHistogram(value);
+	size_t bin = (value - m_histMin) * m_histogramBins / (m_histMax - m_histMin);
+	m_histCounts[min(bin, m_histogramBins - 1)] ++;
+
+	//Time buckets: anchor the timeline on the first sample
+	if(!m_haveStartTime)
+	{
+		m_startTime = timestamp;
+		m_haveStartTime = true;
+	}
+	int64_t ibucket = static_cast<int64_t>((timestamp - m_startTime) / m_bucketSeconds);
+
+	//Commit the open bucket (and empty buckets for any polling gap) if time has moved on.
+	//Samples timestamped before the open bucket (e.g. after a clock adjustment) just fold into it;
+	//the pyramid is append-only.
+	while(m_openBucketIndex < ibucket)
+	{
+		CommitOpenBucket();
+		m_openBucket = Summary();
+		m_openBucketIndex ++;
+	}
+
+	m_openBucket.m_count ++;
+	m_openBucket.m_sum += value;
+	m_openBucket.m_min = min(m_openBucket.m_min, value);
+	m_openBucket.m_max = max(m_openBucket.m_max, value);
+
+	//Raw retention ring
+	if(m_ring.size() < m_ringDepth)
+		m_ring.push_back(RawSample{timestamp, value});
+	else
+	{
+		m_ring[m_ringNext] = RawSample{timestamp, value};
+		m_ringNext = (m_ringNext + 1) % m_ringDepth;
+	}
+}
+
+/**
+	@brief Appends the open bucket to level 0 of the pyramid and propagates pairwise merges upward
+
+	Each completed pair at level k produces one merged Summary at level k+1, so the amortized cost per
+	committed bucket is O(1). Caller must hold m_mutex.
+ */
+void ScalarStreamStats::CommitOpenBucket()
+{
+	if(m_bucketLevels.empty())
+		m_bucketLevels.push_back(vector<Summary>());
+	m_bucketLevels[0].push_back(m_openBucket);
+
+	size_t level = 0;
+	size_t idx = m_bucketLevels[0].size() - 1;
+	while(idx & 1)
+	{
+		Summary merged;
+		const Summary& a = m_bucketLevels[level][idx-1];
+		const Summary& b = m_bucketLevels[level][idx];
+		merged.m_count = a.m_count + b.m_count;
+		merged.m_sum = a.m_sum + b.m_sum;
+		merged.m_min = min(a.m_min, b.m_min);
+		merged.m_max = max(a.m_max, b.m_max);
+
+		if(m_bucketLevels.size() <= (level + 1))
+			m_bucketLevels.push_back(vector<Summary>());
+		m_bucketLevels[level + 1].push_back(merged);
+
+		level ++;
+		idx >>= 1;
+	}
+}
+
+/**
+	@brief Doubles the histogram range until the given value fits
+
+	Growth is by exact power-of-two steps anchored at the existing range, so each old bin maps onto
+	exactly one new bin and no resolution is lost beyond the unavoidable pairwise merge.
+
+	Caller must hold m_mutex.
+
+	@param value	The out-of-range value that must fit after widening
+ */
+void ScalarStreamStats::WidenHistogram(float value)
+{
+	while( (value < m_histMin) || (value >= m_histMax) )
+	{
+		double span = m_histMax - m_histMin;
+		bool growDown = (value < m_histMin);
+
+		vector<uint64_t> newCounts(m_histogramBins, 0);
+		for(size_t i=0; i<m_histogramBins; i++)
+		{
+			size_t newBin = i / 2;
+			if(growDown)
+				newBin += m_histogramBins / 2;
+			newCounts[newBin] += m_histCounts[i];
+		}
+		m_histCounts = move(newCounts);
+
+		if(growDown)
+			m_histMin -= span;
+		else
+			m_histMax += span;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queries
+
+///@brief Returns the running statistics over the whole session
+ScalarStreamStats::Summary ScalarStreamStats::GetSessionStats()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_session;
+}
+
+/**
+	@brief Returns min/max/mean statistics over a time window
+
+	The window is resolved to bucket granularity (see GetBucketSeconds()): any bucket overlapping
+	[tstart, tend) contributes in full. The query decomposes the window into O(log n) pyramid nodes,
+	so cost is independent of capture length.
+
+	@param tstart	Start of the window, in seconds (GetTime() epoch)
+	@param tend		End of the window, in seconds
+
+	@return Summary of the window (empty if no samples fall within it)
+ */
+ScalarStreamStats::Summary ScalarStreamStats::GetWindowStats(double tstart, double tend)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	Summary result;
+	if(!m_haveStartTime || (tend <= tstart) )
+		return result;
+
+	size_t nclosed = m_bucketLevels.empty() ? 0 : m_bucketLevels[0].size();
+
+	//Closed-bucket index range overlapping the window
+	double t0 = (tstart - m_startTime) / m_bucketSeconds;
+	double t1 = (tend - m_startTime) / m_bucketSeconds;
+	size_t lo = (t0 <= 0) ? 0 : min(static_cast<size_t>(t0), nclosed);
+	size_t hi = (t1 <= 0) ? 0 : min(static_cast<size_t>(ceil(t1)), nclosed);
+
+	result = QueryBucketRange(lo, hi);
+
+	//Fold in the still-open bucket if the window reaches it
+	double openStart = m_startTime + m_openBucketIndex * m_bucketSeconds;
+	double openEnd = openStart + m_bucketSeconds;
+	if( (tend > openStart) && (tstart < openEnd) )
+	{
+		result.m_count += m_openBucket.m_count;
+		result.m_sum += m_openBucket.m_sum;
+		result.m_min = min(result.m_min, m_openBucket.m_min);
+		result.m_max = max(result.m_max, m_openBucket.m_max);
+	}
+
+	return result;
+}
+
+/**
+	@brief Merges the closed buckets in the half-open index range [lo, hi)
+
+	Standard bottom-up segment decomposition: at each level, consume an unpaired bucket at either
+	edge of the range, then move up a level. At most two merges per level. Caller must hold m_mutex.
+
+	@param lo	First bucket index (inclusive)
+	@param hi	Last bucket index (exclusive)
+ */
+ScalarStreamStats::Summary ScalarStreamStats::QueryBucketRange(size_t lo, size_t hi)
+{
+	Summary result;
+	size_t level = 0;
+	while( (lo < hi) && (level < m_bucketLevels.size()) )
+	{
+		auto& buckets = m_bucketLevels[level];
+		if(lo & 1)
+		{
+			const Summary& s = buckets[lo];
+			result.m_count += s.m_count;
+			result.m_sum += s.m_sum;
+			result.m_min = min(result.m_min, s.m_min);
+			result.m_max = max(result.m_max, s.m_max);
+			lo ++;
+		}
+		if(hi & 1)
+		{
+			hi --;
+			const Summary& s = buckets[hi];
+			result.m_count += s.m_count;
+			result.m_sum += s.m_sum;
+			result.m_min = min(result.m_min, s.m_min);
+			result.m_max = max(result.m_max, s.m_max);
+		}
+		lo >>= 1;
+		hi >>= 1;
+		level ++;
+	}
+	return result;
+}
+
+/**
+	@brief Returns a snapshot of the value histogram
+
+	@param counts	Receives the per-bin sample counts
+	@param vmin		Receives the low end of the histogram range (start of bin 0)
+	@param vmax		Receives the high end of the histogram range (end of the last bin)
+ */
+void ScalarStreamStats::GetHistogram(vector<uint64_t>& counts, double& vmin, double& vmax)
+{
+	lock_guard<mutex> lock(m_mutex);
+	counts = m_histCounts;
+	vmin = m_histMin;
+	vmax = m_histMax;
+}
+
+/**
+	@brief Returns the retained raw samples, oldest first
+
+	@param samples	Receives up to ringDepth (timestamp, value) pairs
+ */
+void ScalarStreamStats::GetRecentSamples(vector<RawSample>& samples)
+{
+	lock_guard<mutex> lock(m_mutex);
+	samples.clear();
+	samples.reserve(m_ring.size());
+
+	//Once the ring has wrapped, m_ringNext points at the oldest sample
+	size_t start = (m_ring.size() < m_ringDepth) ? 0 : m_ringNext;
+	for(size_t i=0; i<m_ring.size(); i++)
+		samples.push_back(m_ring[(start + i) % m_ring.size()]);
+}
+
+///@brief Discards all accumulated state, as if freshly constructed
+void ScalarStreamStats::Reset()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_session = Summary();
+	m_histCounts.assign(m_histogramBins, 0);
+	m_histValid = false;
+	m_haveStartTime = false;
+	m_openBucket = Summary();
+	m_openBucketIndex = 0;
+	m_bucketLevels.clear();
+	m_ring.clear();
+	m_ringNext = 0;
+}
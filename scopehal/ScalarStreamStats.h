@@ -0,0 +1,186 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of ScalarStreamStats
+	@ingroup datamodel
+ */
+
+#ifndef ScalarStreamStats_h
+#define ScalarStreamStats_h
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+/**
+	@brief Streaming statistics aggregator for a scalar instrument stream
+	@ingroup datamodel
+
+	Scalar channels (power supply voltage/current readback, load measurements, multimeter readings, etc)
+	are polled one value at a time. Plotting or summarizing a long monitoring session by storing every
+	reading and rescanning the whole series on each query does not scale to days of telemetry, so this
+	class folds each reading into fixed-size summary structures as it arrives:
+
+	* Running count / sum / min / max over the whole session (O(1) query)
+	* A fixed-bin histogram whose value range widens automatically by power-of-two steps as outliers
+	  arrive, so the distribution of e.g. current draw can be displayed without a second pass
+	* Time-bucketed summaries merged pairwise into a pyramid, so min/max/mean over an arbitrary time
+	  window costs O(log n) bucket merges regardless of how long the capture has been running
+	* A small ring buffer of raw (timestamp, value) pairs for strip-chart style display of recent history
+
+	Memory use is bounded by the histogram and ring buffer sizes plus roughly two Bucket structs per
+	bucket interval elapsed (32 bytes per second of capture at the default settings).
+
+	All entry points are internally locked: instrument drivers push samples from their polling threads
+	while UI code queries from the render thread. Aggregation is opt-in per stream; see
+	InstrumentChannel::EnableScalarStats().
+ */
+class ScalarStreamStats
+{
+public:
+	ScalarStreamStats(size_t histogramBins = 256, size_t ringDepth = 4096, double bucketSeconds = 1.0);
+
+	void AddSample(float value);
+	void AddSample(float value, double timestamp);
+
+	///@brief Summary statistics over a time window (or the whole session)
+	struct Summary
+	{
+		Summary()
+			: m_count(0)
+			, m_sum(0)
+			, m_min(std::numeric_limits<float>::max())
+			, m_max(-std::numeric_limits<float>::max())
+		{}
+
+		///@brief Number of samples
+		uint64_t m_count;
+
+		///@brief Sum of all sample values
+		double m_sum;
+
+		///@brief Smallest sample value
+		float m_min;
+
+		///@brief Largest sample value
+		float m_max;
+
+		///@brief Mean of all sample values (zero if empty)
+		double GetMean() const
+		{ return m_count ? (m_sum / m_count) : 0; }
+	};
+
+	///@brief One raw retained sample
+	struct RawSample
+	{
+		///@brief Time the sample was taken, in seconds (GetTime() epoch)
+		double m_timestamp;
+
+		///@brief Sample value
+		float m_value;
+	};
+
+	Summary GetSessionStats();
+	Summary GetWindowStats(double tstart, double tend);
+
+	void GetHistogram(std::vector<uint64_t>& counts, double& vmin, double& vmax);
+	void GetRecentSamples(std::vector<RawSample>& samples);
+
+	///@brief Returns the width of one time bucket, in seconds
+	double GetBucketSeconds()
+	{ return m_bucketSeconds; }
+
+	void Reset();
+
+protected:
+	void CommitOpenBucket();
+	void WidenHistogram(float value);
+	Summary QueryBucketRange(size_t lo, size_t hi);
+
+	///@brief Mutex to interlock access from polling and query threads
+	std::mutex m_mutex;
+
+	///@brief Running statistics over the whole session
+	Summary m_session;
+
+	///@brief Number of histogram bins (fixed at construction)
+	size_t m_histogramBins;
+
+	///@brief Histogram bin counts
+	std::vector<uint64_t> m_histCounts;
+
+	///@brief Low end of the histogram range (inclusive)
+	double m_histMin;
+
+	///@brief High end of the histogram range (exclusive)
+	double m_histMax;
+
+	///@brief True once the histogram range has been anchored by the first sample
+	bool m_histValid;
+
+	///@brief Width of one time bucket, in seconds
+	double m_bucketSeconds;
+
+	///@brief Timestamp of the start of bucket 0 (first sample's bucket), valid once m_haveStartTime is set
+	double m_startTime;
+
+	///@brief True once the first sample has anchored the bucket timeline
+	bool m_haveStartTime;
+
+	///@brief Summary of the bucket currently being filled (not yet in m_bucketLevels)
+	Summary m_openBucket;
+
+	///@brief Index of the bucket currently being filled
+	int64_t m_openBucketIndex;
+
+	/**
+		@brief Pairwise-merged bucket pyramid
+
+		Level 0 holds one Summary per elapsed bucket interval; level k+1 holds the merge of each
+		completed pair at level k, built incrementally as buckets are committed. A window query
+		decomposes into at most two partially covered runs per level, bottom-up, giving O(log n)
+		merges for any window.
+	 */
+	std::vector<std::vector<Summary>> m_bucketLevels;
+
+	///@brief Raw sample retention depth (fixed at construction)
+	size_t m_ringDepth;
+
+	///@brief Ring buffer of the most recent raw samples
+	std::vector<RawSample> m_ring;
+
+	///@brief Index within m_ring that the next sample will be written to
+	size_t m_ringNext;
+};
+
+#endif
@@ -0,0 +1,387 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of SessionGraphCache
+	@ingroup core
+ */
+
+#include "scopehal.h"
+#include "SessionGraphCache.h"
+
+using namespace std;
+
+//Node type tags used in the binary encoding
+enum GraphCacheNodeType : uint8_t
+{
+	NODE_TYPE_NULL		= 0,
+	NODE_TYPE_SCALAR	= 1,
+	NODE_TYPE_SEQUENCE	= 2,
+	NODE_TYPE_MAP		= 3
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Saving
+
+/**
+	@brief Writes the configuration of a set of filters to a binary cache file
+
+	Call after serializing the session YAML, with the same IDTable, so both representations agree on IDs.
+
+	@param path				Path of the cache file to write
+	@param filters			Filters to snapshot, in instantiation order
+	@param table			ID table shared with the YAML serialization
+	@param freshnessToken	Token (typically HashText() of the YAML graph section) stored in the header
+
+	@return True on success
+ */
+bool SessionGraphCache::Save(
+	const string& path,
+	const vector<Filter*>& filters,
+	IDTable& table,
+	uint64_t freshnessToken)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+	{
+		LogWarning("SessionGraphCache: couldn't open %s for writing\n", path.c_str());
+		return false;
+	}
+
+	//Header
+	uint32_t magic = FILE_MAGIC;
+	uint32_t version = FILE_VERSION;
+	uint32_t count = filters.size();
+	fwrite(&magic, sizeof(magic), 1, fp);
+	fwrite(&version, sizeof(version), 1, fp);
+	fwrite(&freshnessToken, sizeof(freshnessToken), 1, fp);
+	fwrite(&count, sizeof(count), 1, fp);
+
+	//One record per filter: protocol name, then the same configuration tree the YAML path would store.
+	//Going through SerializeConfiguration() keeps filters with custom serialization correct for free.
+	for(auto f : filters)
+	{
+		WriteString(fp, f->GetProtocolDisplayName());
+		WriteNode(fp, f->SerializeConfiguration(table));
+	}
+
+	fclose(fp);
+	return true;
+}
+
+/**
+	@brief Writes a length-prefixed string
+
+	@param fp	Output file
+	@param str	String to write
+ */
+void SessionGraphCache::WriteString(FILE* fp, const string& str)
+{
+	uint32_t len = str.length();
+	fwrite(&len, sizeof(len), 1, fp);
+	fwrite(str.c_str(), 1, len, fp);
+}
+
+/**
+	@brief Recursively writes a YAML node tree in binary form
+
+	@param fp	Output file
+	@param node	Node to write
+ */
+void SessionGraphCache::WriteNode(FILE* fp, const YAML::Node& node)
+{
+	uint8_t type;
+	uint32_t count;
+	switch(node.Type())
+	{
+		case YAML::NodeType::Scalar:
+			type = NODE_TYPE_SCALAR;
+			fwrite(&type, sizeof(type), 1, fp);
+			WriteString(fp, node.Scalar());
+			break;
+
+		case YAML::NodeType::Sequence:
+			type = NODE_TYPE_SEQUENCE;
+			count = node.size();
+			fwrite(&type, sizeof(type), 1, fp);
+			fwrite(&count, sizeof(count), 1, fp);
+			for(auto it : node)
+				WriteNode(fp, it);
+			break;
+
+		case YAML::NodeType::Map:
+			type = NODE_TYPE_MAP;
+			count = node.size();
+			fwrite(&type, sizeof(type), 1, fp);
+			fwrite(&count, sizeof(count), 1, fp);
+			for(auto it : node)
+			{
+				WriteString(fp, it.first.as<string>());
+				WriteNode(fp, it.second);
+			}
+			break;
+
+		//Null or undefined
+		default:
+			type = NODE_TYPE_NULL;
+			fwrite(&type, sizeof(type), 1, fp);
+			break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+/**
+	@brief Instantiates filters from a binary cache file
+
+	Validates the entire file before creating any filters, so a rejected cache has no side effects and the
+	caller can fall back to the YAML path. Instrument channels referenced by filter inputs must already be
+	in the ID table.
+
+	@param path				Path of the cache file
+	@param freshnessToken	Expected token; a file written with a different token is stale and rejected
+	@param table			ID table pre-populated with instrument channels
+	@param filters			Output: the instantiated filters, in file order
+
+	@return True if the graph was loaded from the cache
+ */
+bool SessionGraphCache::Load(
+	const string& path,
+	uint64_t freshnessToken,
+	IDTable& table,
+	vector<Filter*>& filters)
+{
+	//Read the whole file in one shot
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+		return false;
+	fseek(fp, 0, SEEK_END);
+	long fsize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	vector<uint8_t> buf(fsize);
+	if(fsize <= 0 || (1 != fread(&buf[0], fsize, 1, fp)) )
+	{
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	const uint8_t* p = &buf[0];
+	const uint8_t* end = p + fsize;
+
+	//Validate the header
+	uint32_t magic;
+	uint32_t version;
+	uint64_t token;
+	uint32_t count;
+	if( (end - p) < (ptrdiff_t)(sizeof(magic) + sizeof(version) + sizeof(token) + sizeof(count)) )
+		return false;
+	memcpy(&magic, p, sizeof(magic));
+	p += sizeof(magic);
+	memcpy(&version, p, sizeof(version));
+	p += sizeof(version);
+	memcpy(&token, p, sizeof(token));
+	p += sizeof(token);
+	memcpy(&count, p, sizeof(count));
+	p += sizeof(count);
+	if(magic != FILE_MAGIC)
+		return false;
+	if(version != FILE_VERSION)
+	{
+		LogDebug("SessionGraphCache: version mismatch, falling back to YAML\n");
+		return false;
+	}
+	if(token != freshnessToken)
+	{
+		LogDebug("SessionGraphCache: stale cache (session YAML changed), falling back to YAML\n");
+		return false;
+	}
+
+	//Decode every record up front, before any filters exist, so corruption can't leave a half-built graph
+	vector<string> protocols;
+	vector<YAML::Node> nodes;
+	for(uint32_t i=0; i<count; i++)
+	{
+		string protocol;
+		YAML::Node node;
+		if(!ReadString(p, end, protocol) || !ReadNode(p, end, node))
+		{
+			LogWarning("SessionGraphCache: %s is truncated or corrupt, falling back to YAML\n", path.c_str());
+			return false;
+		}
+		protocols.push_back(protocol);
+		nodes.push_back(node);
+	}
+
+	//Instantiate all of the filters (still no ID table writes, so an unknown protocol backs out cleanly)
+	vector<Filter*> created;
+	for(uint32_t i=0; i<count; i++)
+	{
+		string color = "#ffffff";
+		if(nodes[i]["color"])
+			color = nodes[i]["color"].as<string>();
+		auto f = Filter::CreateFilter(protocols[i], color);
+		if(!f)
+		{
+			LogWarning("SessionGraphCache: unknown filter protocol \"%s\", falling back to YAML\n",
+				protocols[i].c_str());
+			for(auto c : created)
+				delete c;
+			return false;
+		}
+		created.push_back(f);
+	}
+
+	//Register IDs, then configure. Parameters for everything are loaded before any inputs are wired so
+	//forward references between filters resolve, same as the YAML path.
+	for(uint32_t i=0; i<count; i++)
+		table.emplace(nodes[i]["id"].as<uintptr_t>(), created[i]);
+	for(uint32_t i=0; i<count; i++)
+		created[i]->LoadParameters(nodes[i], table);
+	for(uint32_t i=0; i<count; i++)
+		created[i]->LoadInputs(nodes[i], table);
+
+	for(auto f : created)
+		filters.push_back(f);
+	return true;
+}
+
+/**
+	@brief Reads a length-prefixed string
+
+	@param p	Current read position, advanced past the string
+	@param end	End of the buffer
+	@param str	Output string
+ */
+bool SessionGraphCache::ReadString(const uint8_t*& p, const uint8_t* end, string& str)
+{
+	uint32_t len;
+	if( (end - p) < (ptrdiff_t)sizeof(len) )
+		return false;
+	memcpy(&len, p, sizeof(len));
+	p += sizeof(len);
+	if( (end - p) < (ptrdiff_t)len )
+		return false;
+	str.assign(reinterpret_cast<const char*>(p), len);
+	p += len;
+	return true;
+}
+
+/**
+	@brief Recursively reads a binary encoded YAML node tree
+
+	@param p	Current read position, advanced past the node
+	@param end	End of the buffer
+	@param node	Output node
+ */
+bool SessionGraphCache::ReadNode(const uint8_t*& p, const uint8_t* end, YAML::Node& node)
+{
+	if(p >= end)
+		return false;
+	uint8_t type = *p;
+	p++;
+
+	switch(type)
+	{
+		case NODE_TYPE_NULL:
+			node = YAML::Node(YAML::NodeType::Null);
+			return true;
+
+		case NODE_TYPE_SCALAR:
+			{
+				string str;
+				if(!ReadString(p, end, str))
+					return false;
+				node = YAML::Node(str);
+				return true;
+			}
+
+		case NODE_TYPE_SEQUENCE:
+			{
+				uint32_t count;
+				if( (end - p) < (ptrdiff_t)sizeof(count) )
+					return false;
+				memcpy(&count, p, sizeof(count));
+				p += sizeof(count);
+				node = YAML::Node(YAML::NodeType::Sequence);
+				for(uint32_t i=0; i<count; i++)
+				{
+					YAML::Node child;
+					if(!ReadNode(p, end, child))
+						return false;
+					node.push_back(child);
+				}
+				return true;
+			}
+
+		case NODE_TYPE_MAP:
+			{
+				uint32_t count;
+				if( (end - p) < (ptrdiff_t)sizeof(count) )
+					return false;
+				memcpy(&count, p, sizeof(count));
+				p += sizeof(count);
+				node = YAML::Node(YAML::NodeType::Map);
+				for(uint32_t i=0; i<count; i++)
+				{
+					string key;
+					YAML::Node child;
+					if(!ReadString(p, end, key) || !ReadNode(p, end, child))
+						return false;
+					node[key] = child;
+				}
+				return true;
+			}
+
+		default:
+			return false;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+/**
+	@brief FNV-1a hash of a text blob, for use as a freshness token
+
+	@param text	Text to hash (typically the serialized YAML graph section)
+ */
+uint64_t SessionGraphCache::HashText(const string& text)
+{
+	uint64_t hash = 0xcbf29ce484222325;
+	for(auto c : text)
+	{
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
@@ -0,0 +1,87 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SessionGraphCache
+	@ingroup core
+ */
+
+#ifndef SessionGraphCache_h
+#define SessionGraphCache_h
+
+/**
+	@brief Binary fast path for loading the filter graph of a saved session
+
+	Reconstructing a large filter graph from the YAML session file is dominated by text parsing: the whole
+	document is scanned, anchors resolved, and every parameter looked up through yaml-cpp before a single
+	filter exists. This class snapshots the graph section to a flat binary file written alongside the YAML.
+	On load, the file is read into memory in one shot and each filter's configuration tree is rebuilt
+	directly, without any text parsing, then fed through the normal LoadParameters() / LoadInputs() virtuals
+	so filters with custom deserialization behave exactly as they do on the YAML path.
+
+	The cache is advisory: Save() after writing the YAML, then on load call Load() first and fall back to the
+	YAML path if it returns false (missing file, version mismatch, stale freshness token, or corruption).
+	The freshness token ties the cache to the YAML it was written with; HashText() over the serialized graph
+	section is the intended source. The format is machine-local (native endianness) and carries a schema
+	version so stale caches from older builds are rejected, never misparsed.
+ */
+class SessionGraphCache
+{
+public:
+	static bool Save(
+		const std::string& path,
+		const std::vector<Filter*>& filters,
+		IDTable& table,
+		uint64_t freshnessToken);
+
+	static bool Load(
+		const std::string& path,
+		uint64_t freshnessToken,
+		IDTable& table,
+		std::vector<Filter*>& filters);
+
+	static uint64_t HashText(const std::string& text);
+
+protected:
+	static void WriteString(FILE* fp, const std::string& str);
+	static void WriteNode(FILE* fp, const YAML::Node& node);
+
+	static bool ReadString(const uint8_t*& p, const uint8_t* end, std::string& str);
+	static bool ReadNode(const uint8_t*& p, const uint8_t* end, YAML::Node& node);
+
+	///@brief Expected value of the magic number field
+	static const uint32_t FILE_MAGIC = 0x53474331;	//"SGC1"
+
+	///@brief Schema version written by this build
+	static const uint32_t FILE_VERSION = 1;
+};
+
+#endif
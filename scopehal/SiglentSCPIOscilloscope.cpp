@@ -283,21 +283,25 @@ void SiglentSCPIOscilloscope::ParseFirmwareVersion()
 
 void SiglentSCPIOscilloscope::IdentifyHardware()
 {
-	//Ask for the ID
-	string reply = converse("*IDN?");
-	char vendor[128] = "";
-	char model[128] = "";
-	char serial[128] = "";
-	char version[128] = "";
-	if(4 != sscanf(reply.c_str(), "%127[^,],%127[^,],%127[^,],%127s", vendor, model, serial, version))
-	{
-		LogError("Bad IDN response %s\n", reply.c_str());
-		return;
+	//The SCPIDevice base class already asked for *IDN? and parsed the reply; don't spend another round
+	//trip re-asking. Only query ourselves if base class identification failed.
+	if(m_vendor.empty())
+	{
+		string reply = converse("*IDN?");
+		char vendor[128] = "";
+		char model[128] = "";
+		char serial[128] = "";
+		char version[128] = "";
+		if(4 != sscanf(reply.c_str(), "%127[^,],%127[^,],%127[^,],%127s", vendor, model, serial, version))
+		{
+			LogError("Bad IDN response %s\n", reply.c_str());
+			return;
+		}
+		m_vendor = vendor;
+		m_model = model;
+		m_serial = serial;
+		m_fwVersion = version;
 	}
-	m_vendor = vendor;
-	m_model = model;
-	m_serial = serial;
-	m_fwVersion = version;
 
 	//Look up model info
 	m_modelid = MODEL_UNKNOWN;
@@ -2123,38 +2127,71 @@ bool SiglentSCPIOscilloscope::AcquireData()
 				uint64_t pages = ceil(acqPoints/pageSize);
 				uint64_t acqBytes = m_highDefinition ? (acqPoints*2) : acqPoints;
 				bool paginated = (pages > 1);
-				//Read the data from each analog waveform
+
+				//Build the list of channels to fetch so the request for one block can be queued before the previous
+				//block has been read. The instrument buffers incoming commands while transmitting, so keeping one
+				//request in flight means it starts preparing the next block while the current one is still streaming,
+				//rather than eating a full round trip between blocks. This matters most for segmented captures where
+				//each block is small and latency dominates.
+				vector<unsigned int> analogToFetch;
 				for(unsigned int i = 0; i < m_analogChannelCount; i++)
 				{
 					if(analogEnabled[i])
-					{	// Allocate buffer
-						analogWaveformData[i] = new char[acqBytes];
-						if(!paginated)
-						{	// All data fits one page
-							m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(i + 1));
+						analogToFetch.push_back(i);
+				}
+
+				//Issue the request for the first channel's data up front
+				if(!analogToFetch.empty() && !paginated)
+				{
+					m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(analogToFetch[0] + 1));
+					m_transport->SendCommand(":WAVEFORM:DATA?");
+				}
+
+				//Read the data from each analog waveform
+				for(size_t n = 0; n < analogToFetch.size(); n++)
+				{
+					unsigned int i = analogToFetch[n];
+
+					// Allocate buffer
+					analogWaveformData[i] = new char[acqBytes];
+					if(!paginated)
+					{	// All data fits one page
+
+						//Pipeline the request for the next channel's data
+						if(n+1 < analogToFetch.size())
+						{
+							m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(analogToFetch[n+1] + 1));
 							m_transport->SendCommand(":WAVEFORM:DATA?");
-							analogWaveformDataSize[i] = ReadWaveformBlock(acqBytes, analogWaveformData[i], hdWorkaround, [i, this] (float progress) { ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, progress); });
-							// This is the 0x0a0a at the end
-							m_transport->ReadRawData(2, (unsigned char*)tmp);
 						}
-						else
-						{	// We need pagination
-							m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(i + 1));
-							for(uint64_t page = 0; page < pages; page++)
+
+						analogWaveformDataSize[i] = ReadWaveformBlock(acqBytes, analogWaveformData[i], hdWorkaround, [i, this] (float progress) { ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, progress); });
+						// This is the 0x0a0a at the end
+						m_transport->ReadRawData(2, (unsigned char*)tmp);
+					}
+					else
+					{	// We need pagination
+						m_transport->SendCommand(":WAVEFORM:SOURCE C" + to_string(i + 1));
+						m_transport->SendCommand(":WAVEFORM:START 0");
+						m_transport->SendCommand(":WAVEFORM:DATA?");
+						for(uint64_t page = 0; page < pages; page++)
+						{
+							//Pipeline the request for the next page
+							if(page+1 < pages)
 							{
-								m_transport->SendCommand(":WAVEFORM:START "+ to_string(page*pageSize));
+								m_transport->SendCommand(":WAVEFORM:START "+ to_string((page+1)*pageSize));
 								m_transport->SendCommand(":WAVEFORM:DATA?");
-								auto progress = [i, this, page, pages] (float fprogress) {
-									float linear_progress = ((float)page + fprogress) / (float)pages; // the last page will go slightly faster, but oh well
-									ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, linear_progress);
-								};
-								analogWaveformDataSize[i] += ReadWaveformBlock(acqBytes-analogWaveformDataSize[i], analogWaveformData[i]+analogWaveformDataSize[i], hdWorkaround, progress);
-								// This is the 0x0a0a at the end
-								m_transport->ReadRawData(2, (unsigned char*)tmp);
 							}
+
+							auto progress = [i, this, page, pages] (float fprogress) {
+								float linear_progress = ((float)page + fprogress) / (float)pages; // the last page will go slightly faster, but oh well
+								ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, linear_progress);
+							};
+							analogWaveformDataSize[i] += ReadWaveformBlock(acqBytes-analogWaveformDataSize[i], analogWaveformData[i]+analogWaveformDataSize[i], hdWorkaround, progress);
+							// This is the 0x0a0a at the end
+							m_transport->ReadRawData(2, (unsigned char*)tmp);
 						}
-						ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
 					}
+					ChannelsDownloadStatusUpdate(i, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
 				}
 				if(anyDigitalEnabled)
 				{
@@ -2170,39 +2207,69 @@ bool SiglentSCPIOscilloscope::AcquireData()
 					{	// Reset page start
 						m_transport->SendCommand(":WAVEFORM:START 0");
 					}
-					//Read the data from each digital waveform
+
+					//Build the fetch list so requests can be pipelined, same as for the analog channels
+					vector<size_t> digitalToFetch;
 					for(size_t i = 0; i < m_digitalChannelCount; i++)
 					{
 						if(digitalEnabled[i])
-						{	// Allocate buffer
-							digitalWaveformDataBytes[i] = new char[acqDigitalBytes];
-							if(!paginated)
-							{	// All data fits one page
-								m_transport->SendCommand(":WAVEFORM:SOURCE D" + to_string(i));
+							digitalToFetch.push_back(i);
+					}
+
+					//Issue the request for the first channel's data up front
+					if(!digitalToFetch.empty() && !paginated)
+					{
+						m_transport->SendCommand(":WAVEFORM:SOURCE D" + to_string(digitalToFetch[0]));
+						m_transport->SendCommand(":WAVEFORM:DATA?");
+					}
+
+					//Read the data from each digital waveform
+					for(size_t n = 0; n < digitalToFetch.size(); n++)
+					{
+						size_t i = digitalToFetch[n];
+
+						// Allocate buffer
+						digitalWaveformDataBytes[i] = new char[acqDigitalBytes];
+						if(!paginated)
+						{	// All data fits one page
+
+							//Pipeline the request for the next channel's data
+							if(n+1 < digitalToFetch.size())
+							{
+								m_transport->SendCommand(":WAVEFORM:SOURCE D" + to_string(digitalToFetch[n+1]));
 								m_transport->SendCommand(":WAVEFORM:DATA?");
-								digitalWaveformDataSize[i] = ReadWaveformBlock(acqDigitalBytes, digitalWaveformDataBytes[i], false, [i, this] (float progress) { ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, progress); });
-								// This is the 0x0a0a at the end
-								m_transport->ReadRawData(2, (unsigned char*)tmp);
 							}
-							else
-							{	// We need pagination
-								m_transport->SendCommand(":WAVEFORM:SOURCE D" + to_string(i));
-								for(uint64_t page = 0; page < pages; page++)
+
+							digitalWaveformDataSize[i] = ReadWaveformBlock(acqDigitalBytes, digitalWaveformDataBytes[i], false, [i, this] (float progress) { ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, progress); });
+							// This is the 0x0a0a at the end
+							m_transport->ReadRawData(2, (unsigned char*)tmp);
+						}
+						else
+						{	// We need pagination
+							m_transport->SendCommand(":WAVEFORM:SOURCE D" + to_string(i));
+							m_transport->SendCommand(":WAVEFORM:START 0");
+							m_transport->SendCommand(":WAVEFORM:DATA?");
+							for(uint64_t page = 0; page < pages; page++)
+							{
+								// LogDebug("Requesting %lld bytes from byte count to %d.\n",acqDigitalBytes-digitalWaveformDataSize[i],digitalWaveformDataSize[i]);
+
+								//Pipeline the request for the next page
+								if(page+1 < pages)
 								{
-									// LogDebug("Requesting %lld bytes from byte count to %d.\n",acqDigitalBytes-digitalWaveformDataSize[i],digitalWaveformDataSize[i]);
-									m_transport->SendCommand(":WAVEFORM:START "+ to_string(page*pageSize));
+									m_transport->SendCommand(":WAVEFORM:START "+ to_string((page+1)*pageSize));
 									m_transport->SendCommand(":WAVEFORM:DATA?");
-									auto progress = [i, this, page, pages] (float fprogress) {
-										float linear_progress = ((float)page + fprogress) / (float)pages; // the last page will go slightly faster, but oh well
-										ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, linear_progress);
-									};
-									digitalWaveformDataSize[i] += ReadWaveformBlock(acqDigitalBytes-digitalWaveformDataSize[i], digitalWaveformDataBytes[i]+digitalWaveformDataSize[i], false, progress);
-									// This is the 0x0a0a at the end
-									m_transport->ReadRawData(2, (unsigned char*)tmp);
 								}
+
+								auto progress = [i, this, page, pages] (float fprogress) {
+									float linear_progress = ((float)page + fprogress) / (float)pages; // the last page will go slightly faster, but oh well
+									ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_IN_PROGRESS, linear_progress);
+								};
+								digitalWaveformDataSize[i] += ReadWaveformBlock(acqDigitalBytes-digitalWaveformDataSize[i], digitalWaveformDataBytes[i]+digitalWaveformDataSize[i], false, progress);
+								// This is the 0x0a0a at the end
+								m_transport->ReadRawData(2, (unsigned char*)tmp);
 							}
-							ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
 						}
+						ChannelsDownloadStatusUpdate(i + m_analogChannelCount, InstrumentChannel::DownloadState::DOWNLOAD_FINISHED, 1.0);
 					}
 				}
 
@@ -2214,21 +2281,33 @@ bool SiglentSCPIOscilloscope::AcquireData()
 					m_triggerArmed = true;
 				}
 
-				//Process analog waveforms
+				//Process analog waveforms.
+				//Sample conversion is CPU bound with long memory or many segments, so crunch each channel on its
+				//own thread. Warm the voltage range cache first so the workers never touch the transport.
 				waveforms.resize(m_analogChannelCount);
-				for(unsigned int i = 0; i < m_analogChannelCount; i++)
 				{
-					if(analogEnabled[i])
+					vector<thread> threads;
+					for(unsigned int i = 0; i < m_analogChannelCount; i++)
 					{
-						waveforms[i] = ProcessAnalogWaveform(&analogWaveformData[i][0],
-							analogWaveformDataSize[i],
-							&wavedescs[i][0],
-							num_sequences,
-							ttime,
-							basetime,
-							pwtime,
-							i);
+						if(!analogEnabled[i])
+							continue;
+
+						GetChannelVoltageRange(i, 0);
+
+						threads.emplace_back([&, i]
+							{
+								waveforms[i] = ProcessAnalogWaveform(&analogWaveformData[i][0],
+									analogWaveformDataSize[i],
+									&wavedescs[i][0],
+									num_sequences,
+									ttime,
+									basetime,
+									pwtime,
+									i);
+							});
 					}
+					for(auto& t : threads)
+						t.join();
 				}
 
 				//Save analog waveform data
@@ -2242,21 +2321,29 @@ bool SiglentSCPIOscilloscope::AcquireData()
 						pending_waveforms[i].push_back(waveforms[i][j]);
 				}
 
-				//Process digital waveforms
+				//Process digital waveforms, one worker thread per channel as for analog
 				digitalWaveforms.resize(m_digitalChannelCount);
-				for(unsigned int i = 0; i < m_digitalChannelCount; i++)
 				{
-					if(digitalEnabled[i])
+					vector<thread> threads;
+					for(unsigned int i = 0; i < m_digitalChannelCount; i++)
 					{
-						digitalWaveforms[i] = ProcessDigitalWaveform(&digitalWaveformDataBytes[i][0],
-							digitalWaveformDataSize[i],
-							(char*)pdesc,
-							num_sequences,
-							ttime,
-							basetime,
-							pwtime,
-							i);
+						if(!digitalEnabled[i])
+							continue;
+
+						threads.emplace_back([&, i]
+							{
+								digitalWaveforms[i] = ProcessDigitalWaveform(&digitalWaveformDataBytes[i][0],
+									digitalWaveformDataSize[i],
+									(char*)pdesc,
+									num_sequences,
+									ttime,
+									basetime,
+									pwtime,
+									i);
+							});
 					}
+					for(auto& t : threads)
+						t.join();
 				}
 
 				//Save digital waveform data
@@ -2293,7 +2380,7 @@ bool SiglentSCPIOscilloscope::AcquireData()
 			if(pending_waveforms.find(j) != pending_waveforms.end())
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
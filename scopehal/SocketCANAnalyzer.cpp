@@ -209,6 +209,7 @@ bool SocketCANAnalyzer::PopPendingWaveform()
 			if(oldWaveform && data && m_appendingNext)
 			{
 				size_t len = data->size();
+				size_t oldlen = oldWaveform->size();
 				oldWaveform->PrepareForCpuAccess();
 				data->PrepareForCpuAccess();
 				for(size_t i=0; i<len; i++)
@@ -217,7 +218,7 @@ bool SocketCANAnalyzer::PopPendingWaveform()
 					oldWaveform->m_offsets.push_back(data->m_offsets[i]);
 					oldWaveform->m_durations.push_back(data->m_durations[i]);
 				}
-				oldWaveform->m_revision ++;
+				oldWaveform->MarkSamplesAppended(oldlen);
 				oldWaveform->MarkModifiedFromCpu();
 			}
 			else
@@ -349,7 +350,7 @@ bool SocketCANAnalyzer::AcquireData()
 	m_pendingWaveformsMutex.lock();
 		SequenceSet s;
 		s[m_channels[0]] = cap;
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	m_pendingWaveformsMutex.unlock();
 
 	if(m_triggerOneShot)
@@ -0,0 +1,110 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SparseWaveformBuilder
+ */
+#ifndef SparseWaveformBuilder_h
+#define SparseWaveformBuilder_h
+
+#include "Waveform.h"
+
+/**
+	@brief Capacity-managing append helper for decoders building sparse waveform outputs
+
+	Decoders that allocate a fresh output waveform each refresh grow its three buffers from zero capacity
+	through repeated doubling reallocations, each of which copies everything appended so far and reallocates
+	pinned GPU-visible memory. A builder kept as a filter member remembers how large the previous refresh's
+	output was and pre-reserves that much (plus headroom) up front, so steady-state refreshes do at most one
+	allocation per buffer no matter how long the capture is.
+
+	Usage: call Start() after creating or clearing the output waveform, Append() for each output sample, and
+	Finish() once the decode is done. Finish() only records statistics, so a decode that bails out early
+	without calling it simply misses one round of capacity tracking.
+ */
+template<class S>
+class SparseWaveformBuilder
+{
+public:
+	SparseWaveformBuilder()
+		: m_wfm(nullptr)
+		, m_lastSize(0)
+	{}
+
+	///@brief Begins appending to an output waveform, reserving capacity from the previous refresh's statistics
+	void Start(SparseWaveform<S>* wfm)
+	{
+		m_wfm = wfm;
+
+		//Previous output size plus 12.5% headroom, so slow growth between refreshes doesn't
+		//trigger a reallocation every time
+		size_t expected = m_lastSize + (m_lastSize >> 3);
+		if(expected < MIN_RESERVE)
+			expected = MIN_RESERVE;
+
+		//If we're resuming a partial decode, the headroom comes on top of what's already there
+		expected += wfm->size();
+
+		if(expected > wfm->m_offsets.capacity())
+		{
+			wfm->m_offsets.reserve(expected);
+			wfm->m_durations.reserve(expected);
+			wfm->m_samples.reserve(expected);
+		}
+	}
+
+	///@brief Appends one sample to the output waveform
+	void Append(int64_t offset, int64_t duration, const S& sample)
+	{
+		m_wfm->m_offsets.push_back(offset);
+		m_wfm->m_durations.push_back(duration);
+		m_wfm->m_samples.push_back(sample);
+	}
+
+	///@brief Records the final output size for the next refresh's reservation
+	void Finish()
+	{
+		m_lastSize = m_wfm->size();
+		m_wfm = nullptr;
+	}
+
+protected:
+	///@brief The waveform being appended to (only valid between Start() and Finish())
+	SparseWaveform<S>* m_wfm;
+
+	///@brief Size of the previous refresh's output
+	size_t m_lastSize;
+
+	///@brief Smallest reservation worth making (waveforms below this size realloc cheaply anyway)
+	static const size_t MIN_RESERVE = 1024;
+};
+
+#endif
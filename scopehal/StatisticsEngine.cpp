@@ -0,0 +1,196 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of StatisticsEngine
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "StatisticsEngine.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+StatisticsEngine::StatisticsEngine()
+	: m_reductionPipeline("shaders/StatisticsReduction.spv", 2, sizeof(StatisticsReductionArgs))
+	, m_histogramPipeline("shaders/StatisticsHistogram.spv", 2, sizeof(StatisticsHistogramArgs))
+	, m_count(0)
+	, m_min(0)
+	, m_max(0)
+	, m_sum(0)
+	, m_mean(0)
+	, m_stddev(0)
+{
+	m_partials.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_partials.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_histogram.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_histogram.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduction
+
+/**
+	@brief Computes min/max/mean/standard deviation of a sample buffer
+
+	Results are cached and available via the accessors until the next Compute() call.
+
+	@param samples	The samples to reduce
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+ */
+void StatisticsEngine::Compute(
+	AcceleratorBuffer<float>& samples,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t npoints = samples.size();
+	m_count = npoints;
+	if(npoints == 0)
+	{
+		m_min = 0;
+		m_max = 0;
+		m_sum = 0;
+		m_mean = 0;
+		m_stddev = 0;
+		return;
+	}
+
+	//One partial per workgroup; don't launch more workgroups than there are full thread blocks of input
+	size_t nblocks = min(MAX_BLOCKS, (size_t)GetComputeBlockCount(npoints, THREADS_PER_BLOCK));
+	m_partials.resize(4 * nblocks);
+
+	//Run the reduction
+	cmdBuf.begin({});
+	StatisticsReductionArgs args;
+	args.npoints = npoints;
+	m_reductionPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_reductionPipeline.BindBufferNonblocking(1, m_partials, cmdBuf, true);
+	m_reductionPipeline.Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_partials.MarkModifiedFromGpu();
+
+	//Combine the per-workgroup partials (at most a few kB of data)
+	m_partials.PrepareForCpuAccess();
+	float vmin = FLT_MAX;
+	float vmax = -FLT_MAX;
+	double sum = 0;
+	double sumsq = 0;
+	for(size_t i=0; i<nblocks; i++)
+	{
+		vmin = min(vmin, m_partials[i*4 + 0]);
+		vmax = max(vmax, m_partials[i*4 + 1]);
+		sum += m_partials[i*4 + 2];
+		sumsq += m_partials[i*4 + 3];
+	}
+
+	m_min = vmin;
+	m_max = vmax;
+	m_sum = sum;
+	m_mean = sum / npoints;
+	m_stddev = sqrt(max(0.0, (sumsq / npoints) - (m_mean * m_mean)));
+}
+
+/**
+	@brief Estimates a percentile of the sample buffer most recently passed to Compute()
+
+	Bins the samples into a histogram over the [min, max] range found by the reduction, then interpolates
+	linearly within the bin containing the requested rank. Accuracy is bounded by the bin width,
+	(max-min) / 1024.
+
+	@param fraction	Percentile to find, as a fraction (0.5 = median)
+	@param samples	The samples passed to the previous Compute() call
+	@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+	@param queue	Queue to submit GPU work to
+
+	@return The estimated percentile value
+ */
+float StatisticsEngine::GetPercentile(
+	float fraction,
+	AcceleratorBuffer<float>& samples,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	if(m_count == 0)
+		return 0;
+
+	//Degenerate case: all samples equal, every percentile is that value
+	float range = m_max - m_min;
+	if(range <= 0)
+		return m_min;
+
+	fraction = min(max(fraction, 0.0f), 1.0f);
+
+	//Clear the bins (histogram shader accumulates with atomics)
+	m_histogram.resize(HISTOGRAM_BINS);
+	m_histogram.PrepareForCpuAccess();
+	memset(&m_histogram[0], 0, HISTOGRAM_BINS * sizeof(uint32_t));
+	m_histogram.MarkModifiedFromCpu();
+
+	//Bin the samples
+	cmdBuf.begin({});
+	StatisticsHistogramArgs args;
+	args.npoints = m_count;
+	args.nbins = HISTOGRAM_BINS;
+	args.vmin = m_min;
+	args.binscale = HISTOGRAM_BINS / range;
+	m_histogramPipeline.BindBufferNonblocking(0, samples, cmdBuf);
+	m_histogramPipeline.BindBufferNonblocking(1, m_histogram, cmdBuf);
+	m_histogramPipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(m_count, THREADS_PER_BLOCK));
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_histogram.MarkModifiedFromGpu();
+
+	//Walk the histogram to the bin containing the requested rank
+	m_histogram.PrepareForCpuAccess();
+	double target = fraction * m_count;
+	double cumulative = 0;
+	float binwidth = range / HISTOGRAM_BINS;
+	for(size_t i=0; i<HISTOGRAM_BINS; i++)
+	{
+		double bincount = m_histogram[i];
+		if( (cumulative + bincount) >= target)
+		{
+			//Interpolate within the bin
+			float frac = 0.5;
+			if(bincount > 0)
+				frac = (target - cumulative) / bincount;
+			return m_min + (i + frac) * binwidth;
+		}
+		cumulative += bincount;
+	}
+
+	return m_max;
+}
@@ -0,0 +1,163 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of StatisticsEngine
+	@ingroup core
+ */
+#ifndef StatisticsEngine_h
+#define StatisticsEngine_h
+
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+
+class QueueHandle;
+
+/**
+	@brief Arguments to the summary statistics reduction shader
+	@ingroup core
+ */
+struct StatisticsReductionArgs
+{
+	///@brief Number of input samples
+	uint32_t npoints;
+};
+
+/**
+	@brief Arguments to the histogram binning shader
+	@ingroup core
+ */
+struct StatisticsHistogramArgs
+{
+	///@brief Number of input samples
+	uint32_t npoints;
+
+	///@brief Number of histogram bins
+	uint32_t nbins;
+
+	///@brief Lower bound of the histogram range
+	float vmin;
+
+	///@brief Scale factor from (sample - vmin) to bin index
+	float binscale;
+};
+
+/**
+	@brief GPU accelerated summary statistics over a buffer of float samples
+	@ingroup core
+
+	Computes min/max/mean/standard deviation in a single reduction pass: each workgroup accumulates a strided
+	subset of the input into shared memory partials which are then combined on the CPU (a few kB at most).
+	Percentiles are computed on demand by a second histogram pass over the range found by the reduction.
+
+	Intended for measurement filters which produce large scalar streams (per-cycle measurements and the like)
+	so that million-point statistics don't need a per-sample CPU accumulation loop.
+ */
+class StatisticsEngine
+{
+public:
+	StatisticsEngine();
+
+	void Compute(
+		AcceleratorBuffer<float>& samples,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	float GetPercentile(
+		float fraction,
+		AcceleratorBuffer<float>& samples,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	///@brief Returns the number of samples in the most recent Compute() call
+	size_t GetCount() const
+	{ return m_count; }
+
+	///@brief Returns the smallest sample value
+	float GetMin() const
+	{ return m_min; }
+
+	///@brief Returns the largest sample value
+	float GetMax() const
+	{ return m_max; }
+
+	///@brief Returns the sum of all sample values
+	double GetSum() const
+	{ return m_sum; }
+
+	///@brief Returns the arithmetic mean of the sample values
+	double GetMean() const
+	{ return m_mean; }
+
+	///@brief Returns the (population) standard deviation of the sample values
+	double GetStdDev() const
+	{ return m_stddev; }
+
+protected:
+
+	///@brief Number of threads per reduction workgroup (must match the shader's local_size_x)
+	static const size_t THREADS_PER_BLOCK = 256;
+
+	///@brief Maximum number of reduction workgroups (and thus partials combined on the CPU)
+	static const size_t MAX_BLOCKS = 1024;
+
+	///@brief Number of histogram bins used for percentile estimation
+	static const size_t HISTOGRAM_BINS = 1024;
+
+	ComputePipeline m_reductionPipeline;
+	ComputePipeline m_histogramPipeline;
+
+	///@brief Per-workgroup partial results (min, max, sum, sum of squares)
+	AcceleratorBuffer<float> m_partials;
+
+	///@brief Histogram bins for percentile estimation
+	AcceleratorBuffer<uint32_t> m_histogram;
+
+	///@brief Number of samples in the most recent reduction
+	size_t m_count;
+
+	///@brief Smallest sample value
+	float m_min;
+
+	///@brief Largest sample value
+	float m_max;
+
+	///@brief Sum of all sample values
+	double m_sum;
+
+	///@brief Arithmetic mean of the sample values
+	double m_mean;
+
+	///@brief Population standard deviation of the sample values
+	double m_stddev;
+};
+
+#endif
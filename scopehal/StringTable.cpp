@@ -0,0 +1,90 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Implementation of StringTable
+	@ingroup datamodel
+ */
+#include "scopehal.h"
+
+using namespace std;
+
+StringTable::Shard StringTable::m_shards[StringTable::NUM_SHARDS];
+
+/**
+	@brief Returns the handle for a string, adding it to the table if not already present
+
+	Handle 0 is reserved for the empty string and never hits the table.
+
+	@param s	The string to intern
+
+	@return 32-bit handle; equal handles mean equal content
+ */
+uint32_t StringTable::Intern(const string& s)
+{
+	if(s.empty())
+		return 0;
+
+	auto& shard = m_shards[hash<string>{}(s) & (NUM_SHARDS - 1)];
+
+	lock_guard<mutex> lock(shard.m_mutex);
+	auto it = shard.m_lookup.find(s);
+	if(it != shard.m_lookup.end())
+		return it->second;
+
+	//New string: the map node owns the text, the deque gives us handle -> text lookup.
+	//(Keys of an unordered_map have stable addresses across rehashes.)
+	uint32_t handle = (uint32_t)( ((shard.m_strings.size() + 1) << 4) | (size_t)(&shard - m_shards) );
+	auto inserted = shard.m_lookup.emplace(s, handle).first;
+	shard.m_strings.push_back(&inserted->first);
+	return handle;
+}
+
+/**
+	@brief Returns the text for a previously interned handle
+
+	The returned reference stays valid for the lifetime of the process.
+
+	@param handle	Handle returned by Intern()
+ */
+const string& StringTable::Get(uint32_t handle)
+{
+	static const string emptyString;
+	if(handle == 0)
+		return emptyString;
+
+	auto& shard = m_shards[handle & (NUM_SHARDS - 1)];
+	size_t index = (handle >> 4) - 1;
+
+	lock_guard<mutex> lock(shard.m_mutex);
+	if(index >= shard.m_strings.size())
+		return emptyString;
+	return *shard.m_strings[index];
+}
@@ -0,0 +1,208 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@brief Declaration of StringTable and InternedString
+	@ingroup datamodel
+ */
+
+#ifndef StringTable_h
+#define StringTable_h
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+	@brief Global deduplicated string table
+
+	Protocol decodes store millions of short strings with heavily repeated content ("ACK", "Read", register
+	names, etc). Interning maps each distinct string to a 32-bit handle; the text itself is stored exactly once,
+	for the lifetime of the process. Handles are stable and comparison by handle is exact string equality.
+
+	The table is sharded by hash so concurrently refreshing decoders rarely contend on the same lock.
+	Interned strings are never freed; this is intentional, as the set of distinct protocol strings in a session
+	is tiny compared to the number of occurrences.
+ */
+class StringTable
+{
+public:
+	static uint32_t Intern(const std::string& s);
+	static const std::string& Get(uint32_t handle);
+
+protected:
+	///@brief Number of independently locked shards (must be a power of two)
+	static constexpr uint32_t NUM_SHARDS = 16;
+
+	///@brief One lock's worth of the table
+	struct Shard
+	{
+		///@brief Serializes access to this shard
+		std::mutex m_mutex;
+
+		///@brief Handle lookup by content
+		std::unordered_map<std::string, uint32_t> m_lookup;
+
+		///@brief Interned strings, indexed by (handle >> 4) - 1 (deque so references stay stable)
+		std::deque<const std::string*> m_strings;
+	};
+
+	static Shard m_shards[NUM_SHARDS];
+};
+
+/**
+	@brief A string stored by 32-bit handle in the global StringTable
+
+	Drop-in replacement for std::string fields whose values repeat heavily (packet header values, packet
+	colors). Assignment interns; reads go through the table. Comparison between two InternedStrings is a
+	single integer compare. The subset of the std::string interface protocol decoders actually use
+	(find / c_str / empty / length / substr) is forwarded for source compatibility.
+ */
+class InternedString
+{
+public:
+	InternedString()
+		: m_handle(0)
+	{}
+
+	InternedString(const std::string& s)
+		: m_handle(StringTable::Intern(s))
+	{}
+
+	InternedString(const char* s)
+		: m_handle(StringTable::Intern(s))
+	{}
+
+	InternedString& operator=(const std::string& s)
+	{
+		m_handle = StringTable::Intern(s);
+		return *this;
+	}
+
+	InternedString& operator=(const char* s)
+	{
+		m_handle = StringTable::Intern(s);
+		return *this;
+	}
+
+	InternedString& operator+=(const std::string& s)
+	{
+		if(!s.empty())
+			m_handle = StringTable::Intern(str() + s);
+		return *this;
+	}
+
+	InternedString& operator+=(const char* s)
+	{ return *this += std::string(s); }
+
+	///@brief Returns the interned text
+	const std::string& str() const
+	{ return StringTable::Get(m_handle); }
+
+	operator const std::string&() const
+	{ return str(); }
+
+	///@brief Returns the 32-bit handle (equal handles mean equal content)
+	uint32_t GetHandle() const
+	{ return m_handle; }
+
+	bool operator==(const InternedString& rhs) const
+	{ return m_handle == rhs.m_handle; }
+
+	bool operator!=(const InternedString& rhs) const
+	{ return m_handle != rhs.m_handle; }
+
+	bool operator==(const std::string& rhs) const
+	{ return str() == rhs; }
+
+	bool operator!=(const std::string& rhs) const
+	{ return str() != rhs; }
+
+	bool operator==(const char* rhs) const
+	{ return str() == rhs; }
+
+	bool operator!=(const char* rhs) const
+	{ return str() != rhs; }
+
+	bool operator<(const InternedString& rhs) const
+	{ return str() < rhs.str(); }
+
+	//std::string interface forwarding (the subset decoders use)
+
+	const char* c_str() const
+	{ return str().c_str(); }
+
+	bool empty() const
+	{ return m_handle == 0; }
+
+	size_t size() const
+	{ return str().size(); }
+
+	size_t length() const
+	{ return str().length(); }
+
+	size_t find(const std::string& pattern, size_t pos = 0) const
+	{ return str().find(pattern, pos); }
+
+	size_t find(const char* pattern, size_t pos = 0) const
+	{ return str().find(pattern, pos); }
+
+	size_t find(char c, size_t pos = 0) const
+	{ return str().find(c, pos); }
+
+	std::string substr(size_t pos = 0, size_t len = std::string::npos) const
+	{ return str().substr(pos, len); }
+
+	char operator[](size_t i) const
+	{ return str()[i]; }
+
+protected:
+	///@brief Handle within the global table (0 = empty string)
+	uint32_t m_handle;
+};
+
+///@brief Concatenates an interned string with an ordinary one
+inline std::string operator+(const InternedString& lhs, const std::string& rhs)
+{ return lhs.str() + rhs; }
+
+///@brief Concatenates an ordinary string with an interned one
+inline std::string operator+(const std::string& lhs, const InternedString& rhs)
+{ return lhs + rhs.str(); }
+
+///@brief Concatenates an interned string with a C string
+inline std::string operator+(const InternedString& lhs, const char* rhs)
+{ return lhs.str() + rhs; }
+
+///@brief Concatenates a C string with an interned string
+inline std::string operator+(const char* lhs, const InternedString& rhs)
+{ return lhs + rhs.str(); }
+
+#endif
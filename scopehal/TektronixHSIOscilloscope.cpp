@@ -113,7 +113,7 @@ bool TektronixHSIOscilloscope::AcquireData()
 	s[GetOscilloscopeChannel(0)] = cap;
 
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 
 	while (m_pendingWaveforms.size() > 2)
 	{
@@ -1633,7 +1633,7 @@ bool TektronixOscilloscope::AcquireData()
 			if(IsChannelEnabled(j))
 				s[GetOscilloscopeChannel(j)] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
+		AddPendingWaveform(s);
 	}
 	m_pendingWaveformsMutex.unlock();
 
@@ -1886,9 +1886,14 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 	//Make sure record length is valid
 	GetSampleDepth();
 
-	//Ask for the analog data
+	//Parse/convert runs in the background so the next channel's CURV? transfer can start immediately.
+	//The destructor joins everything, so early failure returns can't leave tasks touching freed waveforms.
+	AsyncTaskGroup parseTasks;
+
+	//Queue every enabled analog channel's transfer before collecting any replies: the scope puts the next
+	//channel's curve on the wire while we're still pulling this one, and parsing overlaps both.
 	bool firstAnalog = true;
-	size_t timebase = 0;
+	vector<size_t> analogToFetch;
 	for(size_t i=0; i<m_analogChannelCount; i++)
 	{
 		if(!IsChannelEnabled(i))
@@ -1904,95 +1909,65 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 		//Update the Y axis units
 		GetOscilloscopeChannel(i)->SetYAxisUnits(GetYAxisUnit(i), 0);
 
-		bool succeeded = false;
-		for (int retry = 0; retry < 3; retry++)
-		{
-			// Set source (before setting format)
-			m_transport->SendCommandImmediate(string("DAT:SOU ") + GetOscilloscopeChannel(i)->GetHwname());
-
-			if (firstAnalog || retry) // set again on retry
-			{
-				m_transport->SendCommandImmediate("DAT:WID 1");					//8-bit data in NORMAL mode
-				m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
-				firstAnalog = false;
-			}
-
-			//Ask for the waveform preamble
-			string preamble_str = m_transport->SendCommandImmediateWithReply("WFMO?", false);
-			mso56_preamble preamble;
-
-			//Process it (grab the whole block, semicolons and all)
-			if (!ReadPreamble(preamble_str, preamble))
-				continue; // retry
-
-			timebase = preamble.xincrement * FS_PER_SECOND;	//scope gives sec, not fs
-			m_channelOffsets[i] = -preamble.yoff;
+		// Set source (before setting format)
+		m_transport->SendCommandImmediate(string("DAT:SOU ") + GetOscilloscopeChannel(i)->GetHwname());
 
-			//LogDebug("Channel %zu (%s)\n", i, GetOscilloscopeChannel(i)->GetHwname().c_str());
-			LogIndenter li2;
+		if (firstAnalog)
+		{
+			m_transport->SendCommandImmediate("DAT:WID 1");					//8-bit data in NORMAL mode
+			m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
+			firstAnalog = false;
+		}
 
-			//Read the data block
-			size_t nsamples;
-			int8_t* samples = (int8_t*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", nsamples);
-			if(samples == NULL)
-			{
-				LogWarning("Didn't get any samples (timeout?)\n");
+		m_transport->SendCommandImmediate("WFMO?");
+		m_transport->SendCommandImmediate("CURV?");
+		analogToFetch.push_back(i);
+	}
 
-				ResynchronizeSCPI();
+	//Collect the analog replies in the order we asked for them
+	for(size_t n=0; n<analogToFetch.size(); n++)
+	{
+		size_t i = analogToFetch[n];
 
-				continue; // retry
-			}
+		//Preamble comes first (grab the whole block, semicolons and all)
+		string preamble_str = m_transport->ReadReply(false);
+		mso56_preamble preamble;
+		bool ok = ReadPreamble(preamble_str, preamble);
 
-			if (nsamples != (size_t)preamble.nr_pt)
+		//Then the data block
+		size_t nsamples = 0;
+		int8_t* samples = NULL;
+		if(ok)
+		{
+			samples = (int8_t*)m_transport->ReadRawBlockReply(nsamples);
+			if(samples && (nsamples != (size_t)preamble.nr_pt))
 			{
 				LogWarning("Didn't get the right number of points\n");
-
-				ResynchronizeSCPI();
-
 				delete[] samples;
-
-				continue; // retry
+				samples = NULL;
 			}
 
-			//Set up the capture we're going to store our data into
-			//(no TDC data or fine timestamping available on Tektronix scopes?)
-			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
-			cap->m_timescale = timebase;
-			cap->m_triggerPhase = 0;
-			cap->m_startTimestamp = time(NULL);
-			double t = GetTime();
-			cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
-			cap->Resize(nsamples);
-			cap->PrepareForCpuAccess();
-
-			Convert8BitSamples(
-				cap->m_samples.GetCpuPointer(),
-				samples,
-				preamble.ymult,
-				-preamble.yoff,
-				nsamples);
-
-			cap->MarkSamplesModifiedFromCpu();
-
-			//Done, update the data
-			pending_waveforms[i].push_back(cap);
-
-			//Done
-			delete[] samples;
-
 			//Throw out garbage at the end of the message (why is this needed?)
-			if (m_transport->ReadReply() != "")
+			if(samples && (m_transport->ReadReply() != ""))
 				LogWarning("Tek has junk after CURV? reply\n");
-
-			succeeded = true;
-			break;
 		}
 
-		if (!succeeded)
+		//Anything wrong means the queued replies for the remaining channels are suspect too.
+		//Flush the link, then refetch this channel and the rest one at a time.
+		if(samples == NULL)
 		{
-			LogError("Retried too many times acquiring channel\n");
-			return false;
+			LogWarning("Pipelined transfer failed, resynchronizing\n");
+			ResynchronizeSCPI();
+
+			for(; n<analogToFetch.size(); n++)
+			{
+				if(!AcquireAnalogChannelSerial(analogToFetch[n], pending_waveforms, parseTasks))
+					return false;
+			}
+			break;
 		}
+
+		ProcessAnalogCurve(i, preamble, samples, nsamples, pending_waveforms, parseTasks);
 	}
 
 	//Get the spectrum stuff
@@ -2073,26 +2048,29 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			cap->Resize(nsamples);
 			cap->PrepareForCpuAccess();
 
-			//We get dBm from the instrument, so just have to convert double to single precision
-			//TODO: are other units possible here?
-			//int64_t ibase = preamble.hzoff / preamble.hzbase;
-			for(size_t j=0; j<nsamples; j++)
-				cap->m_samples[j] = preamble.ymult*samples[j] + preamble.yoff;
+			//Convert and peak-search in the background while the next channel's transfer runs
+			auto chan = dynamic_cast<SpectrumChannel*>(m_channels[nchan]);
+			parseTasks.Submit([cap, samples, preamble, nsamples, chan]()
+			{
+				//We get dBm from the instrument, so just have to convert double to single precision
+				//TODO: are other units possible here?
+				for(size_t j=0; j<nsamples; j++)
+					cap->m_samples[j] = preamble.ymult*samples[j] + preamble.yoff;
+
+				cap->MarkSamplesModifiedFromCpu();
+				delete[] samples;
+
+				//Look for peaks
+				//TODO: make this configurable, for now 1 MHz spacing and up to 10 peaks
+				chan->FindPeaks(cap, 10, 1000000);
+			});
 
 			//Done, update the data
-			cap->MarkSamplesModifiedFromCpu();
 			pending_waveforms[nchan].push_back(cap);
 
-			//Done
-			delete[] samples;
-
 			//Throw out garbage at the end of the message (why is this needed?)
 			m_transport->ReadReply();
 
-			//Look for peaks
-			//TODO: make this configurable, for now 1 MHz spacing and up to 10 peaks
-			dynamic_cast<SpectrumChannel*>(m_channels[nchan])->FindPeaks(cap, 10, 1000000);
-
 			succeeded = true;
 			break;
 		}
@@ -2104,8 +2082,9 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 		}
 	}
 
-	//Get the digital stuff
+	//Queue every digital pod's transfer before collecting any replies, same as the analog channels
 	bool firstDigital = true;
+	vector<size_t> podsToFetch;
 	for(size_t i=0; i<m_analogChannelCount; i++)
 	{
 		//Skip anything without a digital probe connected
@@ -2138,128 +2117,322 @@ bool TektronixOscilloscope::AcquireDataMSO56(map<int, vector<WaveformBase*> >& p
 			continue;
 		}
 
-		bool succeeded = false;
-		for (int retry = 0; retry < 3; retry++)
+		//Set source (before setting format); Ask for all of the data
+		m_transport->SendCommandImmediate(string("DAT:SOU CH") + to_string(i+1) + "_DALL");
+
+		//Configuration
+		if(firstDigital)
 		{
-			//Set source (before setting format); Ask for all of the data
-			m_transport->SendCommandImmediate(string("DAT:SOU CH") + to_string(i+1) + "_DALL");
+			m_transport->SendCommandImmediate("DAT:WID 1");					//8 data bits per channel
+			m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
+			firstDigital = false;
+		}
+
+		m_transport->SendCommandImmediate("WFMO?");
+		m_transport->SendCommandImmediate("CURV?");
+		podsToFetch.push_back(i);
+	}
+
+	//Collect the digital replies in the order we asked for them
+	for(size_t n=0; n<podsToFetch.size(); n++)
+	{
+		size_t i = podsToFetch[n];
 
-			//Configuration
-			if(firstDigital || retry) // set again on retry
+		string preamble_str = m_transport->ReadReply(false);
+		mso56_preamble preamble;
+		bool ok = ReadPreamble(preamble_str, preamble);
+
+		size_t msglen = 0;
+		char* samples = NULL;
+		if(ok)
+		{
+			samples = (char*)m_transport->ReadRawBlockReply(msglen);
+			if(samples && (msglen != (size_t)preamble.nr_pt))
 			{
-				m_transport->SendCommandImmediate("DAT:WID 1");					//8 data bits per channel
-				m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
-				firstDigital = false;
+				LogWarning("Didn't get the right number of points\n");
+				delete[] samples;
+				samples = NULL;
 			}
 
-			//Ask for the waveform preamble
-			string preamble_str = m_transport->SendCommandImmediateWithReply("WFMO?", false);
-			mso56_preamble preamble;
-
-			if (!ReadPreamble(preamble_str, preamble))
-				continue; // retry
+			//Throw out garbage at the end of the message (why is this needed?)
+			if(samples)
+				m_transport->ReadReply();
+		}
 
-			timebase = preamble.xincrement * FS_PER_SECOND;	//scope gives sec, not fs
+		//Anything wrong means the queued replies for the remaining pods are suspect too.
+		//Flush the link, then refetch this pod and the rest one at a time.
+		if(samples == NULL)
+		{
+			LogWarning("Pipelined transfer failed, resynchronizing\n");
+			ResynchronizeSCPI();
 
-			//And the acutal data
-			size_t msglen;
-			char* samples = (char*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", msglen);
-			if(samples == NULL)
+			for(; n<podsToFetch.size(); n++)
 			{
-				LogWarning("Didn't get any samples (timeout?)\n");
+				if(!AcquireDigitalPodSerial(podsToFetch[n], pending_waveforms, parseTasks))
+					return false;
+			}
+			break;
+		}
 
-				ResynchronizeSCPI();
+		ProcessDigitalCurve(i, preamble, samples, msglen, pending_waveforms, parseTasks);
+	}
 
-				continue; // retry
-			}
+	//Wait for all background parsing to finish before publishing the waveforms
+	parseTasks.WaitAll();
+	return true;
+}
 
-			if (msglen != (size_t)preamble.nr_pt)
-			{
-				LogWarning("Didn't get the right number of points\n");
+/**
+	@brief Allocates the capture for an analog curve and hands conversion off to the background parser
 
-				ResynchronizeSCPI();
+	Takes ownership of the sample buffer (freed by the parse task).
+ */
+void TektronixOscilloscope::ProcessAnalogCurve(
+	size_t i,
+	const mso56_preamble& preamble,
+	int8_t* samples,
+	size_t nsamples,
+	map<int, vector<WaveformBase*> >& pending_waveforms,
+	AsyncTaskGroup& parseTasks)
+{
+	size_t timebase = preamble.xincrement * FS_PER_SECOND;	//scope gives sec, not fs
+	m_channelOffsets[i] = -preamble.yoff;
+
+	//Set up the capture we're going to store our data into
+	//(no TDC data or fine timestamping available on Tektronix scopes?)
+	auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+	cap->m_timescale = timebase;
+	cap->m_triggerPhase = 0;
+	cap->m_startTimestamp = time(NULL);
+	double t = GetTime();
+	cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
+	cap->Resize(nsamples);
+	cap->PrepareForCpuAccess();
+
+	//Convert in the background while the next channel's transfer runs
+	parseTasks.Submit([cap, samples, preamble, nsamples]()
+	{
+		Convert8BitSamples(
+			cap->m_samples.GetCpuPointer(),
+			samples,
+			preamble.ymult,
+			-preamble.yoff,
+			nsamples);
+
+		cap->MarkSamplesModifiedFromCpu();
+		delete[] samples;
+	});
+
+	//Done, update the data
+	pending_waveforms[i].push_back(cap);
+}
 
-				delete[] samples;
+/**
+	@brief Fetches one analog channel with its own round trips, re-sending format setup and retrying on failure
 
-				continue; // retry
-			}
+	Fallback path for when a pipelined transfer went off the rails and the link had to be resynchronized.
+ */
+bool TektronixOscilloscope::AcquireAnalogChannelSerial(
+	size_t i,
+	map<int, vector<WaveformBase*> >& pending_waveforms,
+	AsyncTaskGroup& parseTasks)
+{
+	for (int retry = 0; retry < 3; retry++)
+	{
+		// Set source (before setting format)
+		m_transport->SendCommandImmediate(string("DAT:SOU ") + GetOscilloscopeChannel(i)->GetHwname());
+		m_transport->SendCommandImmediate("DAT:WID 1");					//8-bit data in NORMAL mode
+		m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
+
+		//Ask for the waveform preamble
+		string preamble_str = m_transport->SendCommandImmediateWithReply("WFMO?", false);
+		mso56_preamble preamble;
+
+		//Process it (grab the whole block, semicolons and all)
+		if (!ReadPreamble(preamble_str, preamble))
+			continue; // retry
+
+		//Read the data block
+		size_t nsamples;
+		int8_t* samples = (int8_t*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", nsamples);
+		if(samples == NULL)
+		{
+			LogWarning("Didn't get any samples (timeout?)\n");
 
-			//Process the data for each channel
-			for(int j=0; j<8; j++)
-			{
-				//Set up the capture we're going to store our data into
-				//(no TDC data or fine timestamping available on Tektronix scopes?)
-				auto cap = new SparseDigitalWaveform;
-				cap->m_timescale = timebase;
-				cap->m_triggerPhase = 0;
-				cap->m_startTimestamp = time(NULL);
-				double t = GetTime();
-				cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
-				cap->Resize(msglen);
-				cap->PrepareForCpuAccess();
+			ResynchronizeSCPI();
 
-				//Extract sample data
-				int mask = (1 << j);
+			continue; // retry
+		}
 
-				bool last = (samples[0] & mask) ? true : false;
+		if (nsamples != (size_t)preamble.nr_pt)
+		{
+			LogWarning("Didn't get the right number of points\n");
 
-				cap->m_offsets[0] = 0;
-				cap->m_durations[0] = 1;
-				cap->m_samples[0] = last;
+			ResynchronizeSCPI();
 
-				size_t k = 0;
+			delete[] samples;
 
-				for(size_t m=1; m<msglen; m++)
-				{
-					bool sample = (samples[m] & mask) ? true : false;
+			continue; // retry
+		}
 
-					//Deduplicate consecutive samples with same value
-					//FIXME: temporary workaround for rendering bugs
-					//if(last == sample)
-					if( (last == sample) && ((m+5) < msglen) && (m > 5))
-						cap->m_durations[k] ++;
+		ProcessAnalogCurve(i, preamble, samples, nsamples, pending_waveforms, parseTasks);
 
-					//Nope, it toggled - store the new value
-					else
-					{
-						k++;
-						cap->m_offsets[k] = m;
-						cap->m_durations[k] = 1;
-						cap->m_samples[k] = sample;
-						last = sample;
-					}
-				}
+		//Throw out garbage at the end of the message (why is this needed?)
+		if (m_transport->ReadReply() != "")
+			LogWarning("Tek has junk after CURV? reply\n");
 
-				//Free space reclaimed by deduplication
-				cap->Resize(k);
-				cap->m_offsets.shrink_to_fit();
-				cap->m_durations.shrink_to_fit();
-				cap->m_samples.shrink_to_fit();
+		return true;
+	}
 
-				cap->MarkSamplesModifiedFromCpu();
-				cap->MarkTimestampsModifiedFromCpu();
+	LogError("Retried too many times acquiring channel\n");
+	return false;
+}
+
+/**
+	@brief Allocates the captures for a digital pod and hands bit extraction off to the background parser
+
+	Takes ownership of the sample buffer (freed by the parse task).
+ */
+void TektronixOscilloscope::ProcessDigitalCurve(
+	size_t i,
+	const mso56_preamble& preamble,
+	char* samples,
+	size_t msglen,
+	map<int, vector<WaveformBase*> >& pending_waveforms,
+	AsyncTaskGroup& parseTasks)
+{
+	size_t timebase = preamble.xincrement * FS_PER_SECOND;	//scope gives sec, not fs
 
-				//Done, update the data
-				pending_waveforms[m_digitalChannelBase + i*8 + j].push_back(cap);
+	//Set up the captures before handing off to the background parser
+	SparseDigitalWaveform* caps[8];
+	for(int j=0; j<8; j++)
+	{
+		//(no TDC data or fine timestamping available on Tektronix scopes?)
+		auto cap = new SparseDigitalWaveform;
+		cap->m_timescale = timebase;
+		cap->m_triggerPhase = 0;
+		cap->m_startTimestamp = time(NULL);
+		double t = GetTime();
+		cap->m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
+		cap->Resize(msglen);
+		cap->PrepareForCpuAccess();
+		caps[j] = cap;
+
+		//Done, update the data
+		pending_waveforms[m_digitalChannelBase + i*8 + j].push_back(cap);
+	}
+
+	//Extract the per-channel sample data in the background while the next pod's transfer runs
+	parseTasks.Submit([caps, samples, msglen]()
+	{
+		for(int j=0; j<8; j++)
+		{
+			auto cap = caps[j];
+
+			//Extract sample data
+			int mask = (1 << j);
+
+			bool last = (samples[0] & mask) ? true : false;
+
+			cap->m_offsets[0] = 0;
+			cap->m_durations[0] = 1;
+			cap->m_samples[0] = last;
+
+			size_t k = 0;
+
+			for(size_t m=1; m<msglen; m++)
+			{
+				bool sample = (samples[m] & mask) ? true : false;
+
+				//Deduplicate consecutive samples with same value
+				//FIXME: temporary workaround for rendering bugs
+				//if(last == sample)
+				if( (last == sample) && ((m+5) < msglen) && (m > 5))
+					cap->m_durations[k] ++;
+
+				//Nope, it toggled - store the new value
+				else
+				{
+					k++;
+					cap->m_offsets[k] = m;
+					cap->m_durations[k] = 1;
+					cap->m_samples[k] = sample;
+					last = sample;
+				}
 			}
 
-			//Done
-			delete[] samples;
+			//Free space reclaimed by deduplication
+			cap->Resize(k);
+			cap->m_offsets.shrink_to_fit();
+			cap->m_durations.shrink_to_fit();
+			cap->m_samples.shrink_to_fit();
 
-			//Throw out garbage at the end of the message (why is this needed?)
-			m_transport->ReadReply();
+			cap->MarkSamplesModifiedFromCpu();
+			cap->MarkTimestampsModifiedFromCpu();
+		}
 
-			succeeded = true;
-			break;
+		//Done
+		delete[] samples;
+	});
+}
+
+/**
+	@brief Fetches one digital pod with its own round trips, re-sending format setup and retrying on failure
+
+	Fallback path for when a pipelined transfer went off the rails and the link had to be resynchronized.
+ */
+bool TektronixOscilloscope::AcquireDigitalPodSerial(
+	size_t i,
+	map<int, vector<WaveformBase*> >& pending_waveforms,
+	AsyncTaskGroup& parseTasks)
+{
+	for (int retry = 0; retry < 3; retry++)
+	{
+		//Set source (before setting format); Ask for all of the data
+		m_transport->SendCommandImmediate(string("DAT:SOU CH") + to_string(i+1) + "_DALL");
+		m_transport->SendCommandImmediate("DAT:WID 1");					//8 data bits per channel
+		m_transport->SendCommandImmediate("DAT:ENC SRI");				//signed, little endian binary
+
+		//Ask for the waveform preamble
+		string preamble_str = m_transport->SendCommandImmediateWithReply("WFMO?", false);
+		mso56_preamble preamble;
+
+		if (!ReadPreamble(preamble_str, preamble))
+			continue; // retry
+
+		//And the acutal data
+		size_t msglen;
+		char* samples = (char*)m_transport->SendCommandImmediateWithRawBlockReply("CURV?", msglen);
+		if(samples == NULL)
+		{
+			LogWarning("Didn't get any samples (timeout?)\n");
+
+			ResynchronizeSCPI();
+
+			continue; // retry
 		}
 
-		if (!succeeded)
+		if (msglen != (size_t)preamble.nr_pt)
 		{
-			LogError("Retried too many times acquiring channel\n");
-			return false;
+			LogWarning("Didn't get the right number of points\n");
+
+			ResynchronizeSCPI();
+
+			delete[] samples;
+
+			continue; // retry
 		}
+
+		ProcessDigitalCurve(i, preamble, samples, msglen, pending_waveforms, parseTasks);
+
+		//Throw out garbage at the end of the message (why is this needed?)
+		m_transport->ReadReply();
+
+		return true;
 	}
-	return true;
+
+	LogError("Retried too many times acquiring channel\n");
+	return false;
 }
 
 /**
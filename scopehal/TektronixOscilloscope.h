@@ -38,6 +38,8 @@
 #ifndef TektronixOscilloscope_h
 #define TektronixOscilloscope_h
 
+#include "AsyncTaskGroup.h"
+
 class EdgeTrigger;
 class PulseWidthTrigger;
 class DropoutTrigger;
@@ -271,6 +273,28 @@ protected:
 	void ResynchronizeSCPI();
 	bool ReadPreamble(std::string& preamble_in, mso56_preamble& preamble_out);
 	bool AcquireDataMSO56(std::map<int, std::vector<WaveformBase*> >& pending_waveforms);
+	void ProcessAnalogCurve(
+		size_t i,
+		const mso56_preamble& preamble,
+		int8_t* samples,
+		size_t nsamples,
+		std::map<int, std::vector<WaveformBase*> >& pending_waveforms,
+		AsyncTaskGroup& parseTasks);
+	bool AcquireAnalogChannelSerial(
+		size_t i,
+		std::map<int, std::vector<WaveformBase*> >& pending_waveforms,
+		AsyncTaskGroup& parseTasks);
+	void ProcessDigitalCurve(
+		size_t i,
+		const mso56_preamble& preamble,
+		char* samples,
+		size_t msglen,
+		std::map<int, std::vector<WaveformBase*> >& pending_waveforms,
+		AsyncTaskGroup& parseTasks);
+	bool AcquireDigitalPodSerial(
+		size_t i,
+		std::map<int, std::vector<WaveformBase*> >& pending_waveforms,
+		AsyncTaskGroup& parseTasks);
 	void DetectProbes();
 
 	///@brief Hardware analog channel count, independent of LA option etc
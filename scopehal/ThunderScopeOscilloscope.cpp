@@ -62,6 +62,7 @@ ThunderScopeOscilloscope::ThunderScopeOscilloscope(SCPITransport* transport)
 	, m_diag_totalWFMs(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS))
 	, m_diag_droppedWFMs(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS))
 	, m_diag_droppedPercent(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_PERCENT))
+	, m_sampleConverter("ThunderScopeOscilloscope")
 {
 	m_analogChannelCount = 4;
 
@@ -120,43 +121,11 @@ ThunderScopeOscilloscope::ThunderScopeOscilloscope(SCPITransport* transport)
 	//Initialize waveform buffers
 	for(size_t i=0; i<m_analogChannelCount; i++)
 	{
-		m_analogRawWaveformBuffers.push_back(std::make_unique<AcceleratorBuffer<int16_t> >());
-		m_analogRawWaveformBuffers[i]->SetCpuAccessHint(AcceleratorBuffer<int16_t>::HINT_LIKELY);
-		m_analogRawWaveformBuffers[i]->SetGpuAccessHint(AcceleratorBuffer<int16_t>::HINT_LIKELY);
+		m_analogRawWaveformBuffers.push_back(std::make_unique<AcceleratorBuffer<int8_t> >());
+		m_analogRawWaveformBuffers[i]->SetCpuAccessHint(AcceleratorBuffer<int8_t>::HINT_LIKELY);
+		m_analogRawWaveformBuffers[i]->SetGpuAccessHint(AcceleratorBuffer<int8_t>::HINT_LIKELY);
 	}
 
-	//Create Vulkan objects for the waveform conversion
-	m_queue = g_vkQueueManager->GetComputeQueue("ThunderScopeOscilloscope.queue");
-	vk::CommandPoolCreateInfo poolInfo(
-		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-		m_queue->m_family );
-	m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
-
-	vk::CommandBufferAllocateInfo bufinfo(**m_pool, vk::CommandBufferLevel::ePrimary, 1);
-	m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
-		std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
-
-	if(g_hasDebugUtils)
-	{
-		string poolname = "ThunderScopeOscilloscope.pool";
-		string bufname = "ThunderScopeOscilloscope.cmdbuf";
-
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eCommandPool,
-				reinterpret_cast<uint64_t>(static_cast<VkCommandPool>(**m_pool)),
-				poolname.c_str()));
-
-		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
-			vk::DebugUtilsObjectNameInfoEXT(
-				vk::ObjectType::eCommandBuffer,
-				reinterpret_cast<uint64_t>(static_cast<VkCommandBuffer>(**m_cmdBuf)),
-				bufname.c_str()));
-	}
-
-	m_conversionPipeline = make_unique<ComputePipeline>(
-		"shaders/Convert8BitSamples.spv", 2, sizeof(ConvertRawSamplesShaderArgs) );
-
 	m_clippingBuffer.resize(1);
 }
 
@@ -269,6 +238,11 @@ Oscilloscope::TriggerMode ThunderScopeOscilloscope::PollTrigger()
 
 bool ThunderScopeOscilloscope::AcquireData()
 {
+	//Start a new trace context for this acquisition so every stage it passes through shares one capture ID
+	auto& tracer = LatencyTracer::GetInstance();
+	tracer.BeginCapture();
+	double tDownload = GetTime();
+
 	const uint8_t r = 'K';
 	m_transport->SendRawData(1, &r);
 
@@ -383,52 +357,24 @@ bool ThunderScopeOscilloscope::AcquireData()
 		}
 	}
 
-	//Prefer GPU path
-	if(g_hasShaderInt8 && g_hasPushDescriptor)
-	{
-		m_cmdBuf->begin({});
-
-		m_conversionPipeline->Bind(*m_cmdBuf);
-
-		for(size_t i=0; i<awfms.size(); i++)
-		{
-			auto cap = awfms[i];
+	tracer.RecordSpan("driver", m_nickname + " download", tDownload, GetTime());
+	double tConvert = GetTime();
 
-			m_conversionPipeline->BindBufferNonblocking(0, cap->m_samples, *m_cmdBuf, true);
-			m_conversionPipeline->BindBufferNonblocking(1, *m_analogRawWaveformBuffers[achans[i]], *m_cmdBuf);
-
-			ConvertRawSamplesShaderArgs args;
-			args.size = cap->size();
-			args.gain = scales[i];
-			args.offset = -offsets[i];
-
-			m_conversionPipeline->DispatchNoRebind(*m_cmdBuf, args, GetComputeBlockCount(cap->size(), 64));
-
-			cap->MarkModifiedFromGpu();
-		}
-
-		m_cmdBuf->end();
-		m_queue->SubmitAndBlock(*m_cmdBuf);
-	}
-
-	//Fallback path if GPU doesn't have suitable integer support
-	else
+	//Convert the raw ADC codes to floats (on the GPU if possible), batching all channels into one submission
+	m_sampleConverter.Begin();
+	for(size_t i=0; i<awfms.size(); i++)
 	{
-		//Process analog captures in parallel
-		#pragma omp parallel for
-		for(size_t i=0; i<awfms.size(); i++)
-		{
-			auto cap = awfms[i];
-			cap->PrepareForCpuAccess();
-			Convert8BitSamples(
-				(float*)&cap->m_samples[0],
-				(int8_t*)m_analogRawWaveformBuffers[achans[i]]->GetCpuPointer(),
-				scales[i],
-				offsets[i],
-				cap->m_samples.size());
-			cap->MarkModifiedFromCpu();
-		}
+		auto cap = awfms[i];
+		m_sampleConverter.Convert8BitSamples(
+			cap->m_samples,
+			*m_analogRawWaveformBuffers[achans[i]],
+			scales[i],
+			-offsets[i],
+			cap->m_samples.size());
 	}
+	m_sampleConverter.End();
+
+	tracer.RecordSpan("driver", m_nickname + " convert", tConvert, GetTime());
 
 	FilterParameter* param = &m_diag_totalWFMs;
 	int total = param->GetIntVal() + 1;
@@ -439,7 +385,7 @@ bool ThunderScopeOscilloscope::AcquireData()
 
 	//Save the waveforms to our queue
 	m_pendingWaveformsMutex.lock();
-	m_pendingWaveforms.push_back(s);
+	AddPendingWaveform(s);
 
 	while (m_pendingWaveforms.size() > 2)
 	{
@@ -38,6 +38,7 @@
 #define ThunderScopeOscilloscope_h
 
 #include "RemoteBridgeOscilloscope.h"
+#include "RawSampleConverter.h"
 #include "../xptools/HzClock.h"
 
 /**
@@ -120,19 +121,10 @@ protected:
 	HzClock m_receiveClock;
 
 	///@brief Buffers for storing raw ADC samples before converting to fp32
-	std::vector<std::unique_ptr<AcceleratorBuffer<int16_t> > > m_analogRawWaveformBuffers;
+	std::vector<std::unique_ptr<AcceleratorBuffer<int8_t> > > m_analogRawWaveformBuffers;
 
-	///@brief Vulkan queue used for sample conversion
-	std::shared_ptr<QueueHandle> m_queue;
-
-	///@brief Command pool from which m_cmdBuf was allocated
-	std::unique_ptr<vk::raii::CommandPool> m_pool;
-
-	///@brief Command buffer for sample conversion
-	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
-
-	///@brief Compute pipeline for converting raw ADC codes to float32 samples
-	std::unique_ptr<ComputePipeline> m_conversionPipeline;
+	///@brief Converter for turning raw ADC codes into float32 samples
+	RawSampleConverter m_sampleConverter;
 
 	///@brief Buffer for storing channel clip state
 	AcceleratorBuffer<uint32_t> m_clippingBuffer;
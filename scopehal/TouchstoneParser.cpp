@@ -35,9 +35,54 @@
  */
 #include "scopehal.h"
 #include <math.h>
+#include <thread>
+#include <sys/stat.h>
+
+#ifdef __cpp_lib_to_chars
+#include <charconv>
+#endif
 
 using namespace std;
 
+///@brief Magic number at the start of a binary S-parameter cache file ("SNPB")
+static const uint32_t SNPBIN_MAGIC = 0x42504e53;
+
+///@brief Version number of the binary S-parameter cache format
+static const uint32_t SNPBIN_VERSION = 1;
+
+///@brief Header of a binary S-parameter cache file
+struct SnpBinHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nports;
+	uint32_t reserved;
+	uint64_t npoints;
+	int64_t srcSize;
+	int64_t srcMtime;
+};
+
+/**
+	@brief Parses a single ASCII float
+
+	Uses the locale-independent std::from_chars if available, since it's several times faster than strtof.
+ */
+static float ParseFloatFast(const char* p, const char* end)
+{
+#ifdef __cpp_lib_to_chars
+	//from_chars doesn't accept a leading '+', which is legal Touchstone
+	if( (p < end) && (*p == '+') )
+		p++;
+
+	float f = 0;
+	from_chars(p, end, f);
+	return f;
+#else
+	(void)end;
+	return strtof(p, nullptr);
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // TouchstoneParser
 
@@ -59,6 +104,10 @@ TouchstoneParser::~TouchstoneParser()
 /**
 	@brief Reads a SxP file
 
+	If a binary side cache (fname + "bin", e.g. foo.s2pbin) exists and matches the source file's size and mtime,
+	it's loaded directly instead of parsing the ASCII. Otherwise the ASCII is parsed (point conversion runs across
+	all cores for large files) and the cache is written for next time.
+
 	@param		fname	Path to the .s*p file
 	@param[out] params	The parsed S-parameters (if successful)
 
@@ -89,6 +138,22 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 		fclose(fp);
 		return false;
 	}
+
+	//If we have an up-to-date binary cache of a previous parse, use it and skip the ASCII entirely
+	struct stat st;
+	int64_t srcSize = 0;
+	int64_t srcMtime = 0;
+	if(0 == stat(fname.c_str(), &st))
+	{
+		srcSize = st.st_size;
+		srcMtime = st.st_mtime;
+	}
+	string cachepath = fname + "bin";
+	if(LoadCache(cachepath, nports, srcSize, srcMtime, params))
+	{
+		fclose(fp);
+		return true;
+	}
 	params.Allocate(nports);
 
 	//Read entire file into working buffer
@@ -104,16 +169,20 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 	}
 	fclose(fp);
 
-	//Main parsing loop
+	//First pass: process comment/option lines and index the start and length of every numeric token.
+	//All whitespace characters are <= 0x20 and all characters that can appear in a number are > 0x20,
+	//so the scan is a single branch-light compare per byte.
 	size_t i = 0;
 	bool ok = true;
 	double unit_scale = 1;
 	bool mag_is_db = false;
 	bool polar = true;			//mag/angle
+	vector<pair<uint64_t, uint32_t>> tokens;
+	tokens.reserve(len / 8);
 	while(i < len)
 	{
 		//Discard whitespace
-		if(isspace(buf[i]))
+		if( (unsigned char)buf[i] <= ' ')
 			i++;
 
 		//! is a comment, ignore everything until the next newline
@@ -173,48 +242,73 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 				i++;
 		}
 
-		//Actual network data
+		//Numeric token: save its bounds for the conversion pass
 		else
 		{
-			//Read the frequency and scale appropriately
-			float freq;
-			if(!ReadFloat(buf, i, len, freq))
+			size_t start = i;
+			while( (i < len) && ((unsigned char)buf[i] > ' ') )
+				i++;
+			tokens.push_back(pair<uint64_t, uint32_t>(start, i - start));
+		}
+	}
+
+	//Each point is one frequency plus a mag/angle or real/imaginary tuple for every matrix element
+	size_t tokensPerPoint = 1 + 2*nports*nports;
+	size_t npoints = tokens.size() / tokensPerPoint;
+	if(ok && (tokens.size() % tokensPerPoint) != 0)
+	{
+		LogError("Malformed Touchstone file (token count %zu is not a multiple of %zu)\n",
+			tokens.size(), tokensPerPoint);
+		ok = false;
+	}
+
+	if(ok)
+	{
+		//Look up the output vector for each matrix position up front, so the hot loop doesn't touch the map.
+		//NOTE! Parameter ordering is different for 2 vs 3+ port
+		//For 2 port, we loop destination inner and source outer (S11 S21 S12 S22)
+		//For 3+ port, we have source inner and destination outer (S11 S12 S13 S21 S22 S23 ...)
+		//See pages 6 and 8 of Touchstone File Specification rev 1.1
+		vector<SParameterVector*> outputs;
+		for(size_t outer=1; outer <= nports; outer ++)
+		{
+			for(size_t inner=1; inner <= nports; inner ++)
 			{
-				ok = false;
-				break;
+				size_t src;
+				size_t dest;
+				if(nports <= 2)
+				{
+					dest = inner;
+					src = outer;
+				}
+				else
+				{
+					dest = outer;
+					src = inner;
+				}
+				outputs.push_back(params.m_params[SPair(dest, src)]);
 			}
-			freq *= unit_scale;
+		}
+		for(auto vec : outputs)
+		{
+			vec->m_points.resize(npoints);
+			vec->m_points.PrepareForCpuAccess();
+		}
 
-			//The actual S-matrix is nports * nports mag/angle or real/imaginary tuples
-			float mag;
-			float angle;
-			for(size_t outer=1; outer <= nports; outer ++)
+		//Second pass: convert tokens to S-parameter points, splitting the file across all cores.
+		//Points are fixed stride in the token array so each thread can work on a disjoint range.
+		const char* bufend = buf + len;
+		auto convert = [&](size_t firstPoint, size_t lastPoint)
+		{
+			for(size_t pt = firstPoint; pt < lastPoint; pt ++)
 			{
-				for(size_t inner=1; inner <= nports; inner ++)
+				auto tok = &tokens[pt * tokensPerPoint];
+				float freq = ParseFloatFast(buf + tok[0].first, bufend) * unit_scale;
+
+				for(size_t el = 0; el < nports*nports; el ++)
 				{
-					//NOTE! Parameter ordering is different for 2 vs 3+ port
-					//For 2 port, we loop destination inner and source outer (S11 S21 S12 S22)
-					//For 3+ port, we have source inner and destination outer (S11 S12 S13 S21 S22 S23 ...)
-					//See pages 6 and 8 of Touchstone File Specification rev 1.1
-					size_t src;
-					size_t dest;
-					if(nports <= 2)
-					{
-						dest = inner;
-						src = outer;
-					}
-					else
-					{
-						dest = outer;
-						src = inner;
-					}
-
-					//Read the inputs
-					if(!ReadFloat(buf, i, len, mag) || !ReadFloat(buf, i, len, angle))
-					{
-						ok = false;
-						break;
-					}
+					float mag = ParseFloatFast(buf + tok[1 + el*2].first, bufend);
+					float angle = ParseFloatFast(buf + tok[2 + el*2].first, bufend);
 
 					//Convert dB magnitudes to absolute magnitudes
 					if(mag_is_db)
@@ -228,26 +322,169 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 					else
 						ComplexToPolar(mag, angle);
 
-					//and save the final results
-					params.m_params[SPair(dest, src)]->m_points.push_back(SParameterPoint(freq, mag, angle));
+					outputs[el]->m_points[pt] = SParameterPoint(freq, mag, angle);
 				}
-				if(!ok)
-					break;
 			}
-			if(!ok)
-				break;
-
-			i++;
+		};
+
+		//Parallelize only if there's enough work to be worth the thread spawns
+		const size_t minPointsPerThread = 512;
+		size_t nthreads = min(
+			(size_t)max(thread::hardware_concurrency(), 1U),
+			(npoints + minPointsPerThread - 1) / minPointsPerThread);
+		if(nthreads <= 1)
+			convert(0, npoints);
+		else
+		{
+			vector<thread> threads;
+			size_t pointsPerThread = (npoints + nthreads - 1) / nthreads;
+			for(size_t t=0; t<nthreads; t++)
+			{
+				threads.push_back(thread(
+					convert,
+					t * pointsPerThread,
+					min((t+1) * pointsPerThread, npoints)));
+			}
+			for(auto& t : threads)
+				t.join();
 		}
-	}
 
+		for(auto vec : outputs)
+			vec->m_points.MarkModifiedFromCpu();
+	}
 
 	delete[] buf;
 	LogTrace("Loaded %zu S-parameter points\n", params.m_params[SPair(1,1)]->m_points.size());
 
+	//Save the binary cache so the next load of this file skips the ASCII parse
+	if(ok)
+		SaveCache(cachepath, nports, srcSize, srcMtime, params);
+
 	return ok;
 }
 
+/**
+	@brief Writes an up-to-date binary cache for a Touchstone file that was just saved
+
+	Called by exporters so that the next import of the file skips the ASCII parse entirely.
+
+	@param	fname	Path to the .s*p file (must already exist on disk)
+	@param	params	The S-parameters the file was written from
+ */
+void TouchstoneParser::WriteCacheFor(const string& fname, SParameters& params)
+{
+	struct stat st;
+	if(0 != stat(fname.c_str(), &st))
+		return;
+
+	SaveCache(fname + "bin", params.GetNumPorts(), st.st_size, st.st_mtime, params);
+}
+
+/**
+	@brief Loads a binary S-parameter cache file, if present and in sync with the source file
+
+	@param	path		Path to the cache file
+	@param	nports		Expected port count (from the source file name)
+	@param	srcSize		Size of the source .s*p file, in bytes
+	@param	srcMtime	Modification time of the source .s*p file
+	@param	params		The parsed S-parameters (if successful)
+
+	@return	True on success, false if the cache is absent, stale, or malformed
+ */
+bool TouchstoneParser::LoadCache(const string& path, size_t nports, int64_t srcSize, int64_t srcMtime, SParameters& params)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+		return false;
+
+	//Reject the cache unless it matches the current source file exactly
+	SnpBinHeader header;
+	if(1 != fread(&header, sizeof(header), 1, fp))
+	{
+		fclose(fp);
+		return false;
+	}
+	if( (header.magic != SNPBIN_MAGIC) ||
+		(header.version != SNPBIN_VERSION) ||
+		(header.nports != nports) ||
+		(header.srcSize != srcSize) ||
+		(header.srcMtime != srcMtime) )
+	{
+		fclose(fp);
+		return false;
+	}
+
+	params.Allocate(nports);
+	for(size_t dest=1; dest <= nports; dest ++)
+	{
+		for(size_t src=1; src <= nports; src ++)
+		{
+			auto& vec = params.m_params[SPair(dest, src)]->m_points;
+			vec.resize(header.npoints);
+			vec.PrepareForCpuAccess();
+			if(header.npoints != fread(&vec[0], sizeof(SParameterPoint), header.npoints, fp))
+			{
+				LogWarning("S-parameter cache %s is truncated, ignoring it\n", path.c_str());
+				params.Clear();
+				fclose(fp);
+				return false;
+			}
+			vec.MarkModifiedFromCpu();
+		}
+	}
+	fclose(fp);
+
+	LogTrace("Loaded %zu S-parameter points from cache %s\n", (size_t)header.npoints, path.c_str());
+	return true;
+}
+
+/**
+	@brief Writes a binary S-parameter cache file next to the source file
+
+	Failure is harmless (e.g. source directory is read-only); we just won't have a cache next time.
+
+	@param	path		Path to the cache file
+	@param	nports		Port count
+	@param	srcSize		Size of the source .s*p file, in bytes
+	@param	srcMtime	Modification time of the source .s*p file
+	@param	params		The S-parameters to save
+ */
+void TouchstoneParser::SaveCache(const string& path, size_t nports, int64_t srcSize, int64_t srcMtime, SParameters& params)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if(!fp)
+		return;
+
+	SnpBinHeader header;
+	header.magic = SNPBIN_MAGIC;
+	header.version = SNPBIN_VERSION;
+	header.nports = nports;
+	header.reserved = 0;
+	header.npoints = params.m_params[SPair(1,1)]->m_points.size();
+	header.srcSize = srcSize;
+	header.srcMtime = srcMtime;
+
+	bool ok = (1 == fwrite(&header, sizeof(header), 1, fp));
+	for(size_t dest=1; ok && (dest <= nports); dest ++)
+	{
+		for(size_t src=1; ok && (src <= nports); src ++)
+		{
+			auto& vec = params.m_params[SPair(dest, src)]->m_points;
+			vec.PrepareForCpuAccess();
+			if(header.npoints != fwrite(&vec[0], sizeof(SParameterPoint), header.npoints, fp))
+				ok = false;
+		}
+	}
+	fclose(fp);
+
+	//Don't leave a half-written cache lying around for the next load to trip over
+	if(!ok)
+	{
+		LogWarning("Failed to write S-parameter cache %s\n", path.c_str());
+		remove(path.c_str());
+	}
+}
+
 /**
 	@brief Reads a single ASCII float from the input buffer
 
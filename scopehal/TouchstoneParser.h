@@ -49,10 +49,15 @@ public:
 
 	bool Load(std::string fname, SParameters& params);
 
+	void WriteCacheFor(const std::string& fname, SParameters& params);
+
 protected:
 	void ComplexToPolar(float& f1, float& f2);
 
 	bool ReadFloat(const char* buf, size_t& i, size_t len, float& f);
+
+	bool LoadCache(const std::string& path, size_t nports, int64_t srcSize, int64_t srcMtime, SParameters& params);
+	void SaveCache(const std::string& path, size_t nports, int64_t srcSize, int64_t srcMtime, SParameters& params);
 };
 
 #endif
@@ -36,6 +36,7 @@
 
 #include "scopehal.h"
 
+#include <charconv>
 #include <cinttypes>
 
 using namespace std;
@@ -227,6 +228,18 @@ string Unit::ToString() const
 	@brief Gets the appropriate SI scaling factor for a number.
  */
 void Unit::GetSIScalingFactor(double num, double& scaleFactor, string& prefix) const
+{
+	const char* p;
+	GetSIScalingFactor(num, scaleFactor, p);
+	prefix = p;
+}
+
+/**
+	@brief Gets the appropriate SI scaling factor for a number (allocation-free version).
+
+	The prefix is returned as a pointer to a string literal so no heap allocation is needed.
+ */
+void Unit::GetSIScalingFactor(double num, double& scaleFactor, const char*& prefix) const
 {
 	scaleFactor = 1;
 	prefix = "";
@@ -306,8 +319,35 @@ void Unit::GetSIScalingFactor(double num, double& scaleFactor, string& prefix) c
 	Note that this function may modify the SI scale factor and prefix
  */
 void Unit::GetUnitSuffix(UnitType type, double num, double& scaleFactor, string& prefix, string& numprefix, string& suffix) const
+{
+	const char* p = prefix.c_str();
+	const char* np;
+	const char* s;
+	GetUnitSuffix(type, num, scaleFactor, p, np, s);
+
+	if(p != prefix.c_str())
+		prefix = p;
+	numprefix = np;
+	suffix = s;
+}
+
+/**
+	@brief Gets the suffix for a unit (allocation-free version).
+
+	Note that this function may modify the SI scale factor and prefix.
+
+	All strings are returned as pointers to string literals so no heap allocation is needed.
+ */
+void Unit::GetUnitSuffix(
+	UnitType type,
+	double num,
+	double& scaleFactor,
+	const char*& prefix,
+	const char*& numprefix,
+	const char*& suffix) const
 {
 	numprefix = "";
+	suffix = "";
 
 	switch(type)
 	{
@@ -589,11 +629,60 @@ string Unit::PrettyPrint(double value, int sigfigs, bool useDisplayLocale) const
 	if(useDisplayLocale)
 		SetPrintingLocale();
 
-	//Figure out scaling, prefix, and suffix
+	string ret = DoPrettyPrint(value, sigfigs, !useDisplayLocale);
+
+	SetDefaultLocale();
+	return ret;
+}
+
+/**
+	@brief Pretty-prints a block of values with a single locale round trip
+
+	Equivalent to calling PrettyPrint() on each value, but the locale is switched once for the whole block rather
+	than per value. This matters for protocol decoders and CSV export which format millions of values: on Windows
+	setlocale() takes a global lock, and even uselocale() adds measurable per-call overhead at that scale.
+
+	@param value				The values to print
+	@param count				Number of values to print
+	@param out					Output string for each value (any previous contents are replaced)
+	@param sigfigs				Number of significant digits to display
+	@param useDisplayLocale		True if the strings are formatted for display (user's locale)
+								False if the strings are formatted for serialization ("C" locale regardless of user pref)
+ */
+void Unit::PrettyPrintVector(
+	const double* values,
+	size_t count,
+	vector<string>& out,
+	int sigfigs,
+	bool useDisplayLocale) const
+{
+	if(useDisplayLocale)
+		SetPrintingLocale();
+
+	out.clear();
+	out.reserve(count);
+	for(size_t i=0; i<count; i++)
+		out.push_back(DoPrettyPrint(values[i], sigfigs, !useDisplayLocale));
+
+	SetDefaultLocale();
+}
+
+/**
+	@brief Shared implementation of PrettyPrint() and PrettyPrintVector()
+
+	The caller is responsible for setting the desired locale before calling and restoring it afterward.
+
+	@param value	The value
+	@param sigfigs	Number of significant digits to display
+	@param cLocale	True if the caller left the "C" locale active, enabling the locale-independent fast path
+ */
+string Unit::DoPrettyPrint(double value, int sigfigs, bool cLocale) const
+{
+	//Figure out scaling, prefix, and suffix (string literals, no allocation)
 	double scaleFactor;
-	string prefix;
-	string numprefix;
-	string suffix;
+	const char* prefix;
+	const char* numprefix;
+	const char* suffix;
 	GetSIScalingFactor(value, scaleFactor, prefix);
 	GetUnitSuffix(m_type, value, scaleFactor, prefix, numprefix, suffix);
 
@@ -637,30 +726,50 @@ string Unit::PrettyPrint(double value, int sigfigs, bool useDisplayLocale) const
 					int rightdigits = sigfigs - leftdigits;
 
 					string format = string("%") + to_string(leftdigits) + "." + to_string(rightdigits) + "f%s%s%s";
-					snprintf(tmp, sizeof(tmp), format.c_str(), value_rescaled, space, prefix.c_str(), suffix.c_str());
+					snprintf(tmp, sizeof(tmp), format.c_str(), value_rescaled, space, prefix, suffix);
 				}
 
 				//If not a round number, add more digits (up to 5)
 				else
 				{
+					int digits = 5;
 					if( fabs(round(value_rescaled) - value_rescaled) < 0.001 )
-						snprintf(tmp, sizeof(tmp), "%.0f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
+						digits = 0;
 					else if(fabs(round(value_rescaled*10) - value_rescaled*10) < 0.001)
-						snprintf(tmp, sizeof(tmp), "%.1f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
+						digits = 1;
 					else if(fabs(round(value_rescaled*100) - value_rescaled*100) < 0.001 )
-						snprintf(tmp, sizeof(tmp), "%.2f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
+						digits = 2;
 					else if(fabs(round(value_rescaled*1000) - value_rescaled*1000) < 0.001 )
-						snprintf(tmp, sizeof(tmp), "%.3f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
+						digits = 3;
 					else if(fabs(round(value_rescaled*10000) - value_rescaled*10000) < 0.001 )
-						snprintf(tmp, sizeof(tmp), "%.4f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
-					else
-						snprintf(tmp, sizeof(tmp), "%.5f%s%s%s", value_rescaled, space, prefix.c_str(), suffix.c_str());
+						digits = 4;
+
+					#ifdef __cpp_lib_to_chars
+					//In the "C" locale std::to_chars produces output identical to printf %.*f, without the
+					//format string parsing or locale lookups. This is the hot path for bulk text generation.
+					if(cLocale)
+					{
+						auto res = to_chars(tmp, tmp + sizeof(tmp) - 1, value_rescaled, chars_format::fixed, digits);
+						*res.ptr = '\0';
+						string ret = numprefix;
+						ret += tmp;
+						ret += space;
+						ret += prefix;
+						ret += suffix;
+						return ret;
+					}
+					#endif
+
+					snprintf(tmp, sizeof(tmp), "%.*f%s%s%s", digits, value_rescaled, space, prefix, suffix);
 				}
 			}
 			break;
 	}
 
-	SetDefaultLocale();
+	#ifndef __cpp_lib_to_chars
+	(void)cLocale;
+	#endif
+
 	return numprefix + string(tmp);
 }
 
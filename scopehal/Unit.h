@@ -117,6 +117,13 @@ public:
 	std::string PrettyPrint(double value, int sigfigs = -1, bool useDisplayLocale = true) const;
 	std::string PrettyPrintInt64(int64_t value, int sigfigs = -1, bool useDisplayLocale = true) const;
 
+	void PrettyPrintVector(
+		const double* values,
+		size_t count,
+		std::vector<std::string>& out,
+		int sigfigs = -1,
+		bool useDisplayLocale = true) const;
+
 	std::string PrettyPrintRange(double pixelMin, double pixelMax, double rangeMin, double rangeMax) const;
 
 	double ParseString(const std::string& str, bool useDisplayLocale = true);
@@ -145,6 +152,18 @@ protected:
 	void GetSIScalingFactor(double num, double& scaleFactor, std::string& prefix) const;
 	void GetUnitSuffix(UnitType type, double num, double& scaleFactor, std::string& prefix, std::string& numprefix, std::string& suffix) const;
 
+	//Allocation-free versions of the scale/prefix lookups, returning pointers to string literals
+	void GetSIScalingFactor(double num, double& scaleFactor, const char*& prefix) const;
+	void GetUnitSuffix(
+		UnitType type,
+		double num,
+		double& scaleFactor,
+		const char*& prefix,
+		const char*& numprefix,
+		const char*& suffix) const;
+
+	std::string DoPrettyPrint(double value, int sigfigs, bool cLocale) const;
+
 #ifdef _WIN32
 	/**
 		@brief String form of m_locale for use on Windows
@@ -275,3 +275,247 @@ void VulkanFFTPlan::AppendReverse(
 
 	dataOut.MarkModifiedFromGpu();
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VulkanFFTConvolutionPlan
+
+/**
+	@brief Creates a new convolution plan
+
+	@param npoints	Number of points in the FFT
+	@param nouts	Number of frequency domain output samples (npoints/2 + 1)
+ */
+VulkanFFTConvolutionPlan::VulkanFFTConvolutionPlan(size_t npoints, size_t nouts)
+	: m_size(npoints)
+	, m_fence(*g_vkComputeDevice, vk::FenceCreateInfo())
+{
+	memset(&m_app, 0, sizeof(m_app));
+	memset(&m_config, 0, sizeof(m_config));
+	memset(&m_kernelApp, 0, sizeof(m_kernelApp));
+	memset(&m_kernelConfig, 0, sizeof(m_kernelConfig));
+
+	//Create a command pool for initialization use
+	vk::CommandPoolCreateInfo poolInfo(
+		vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+		g_vkTransferQueue->m_family );
+	vk::raii::CommandPool pool(*g_vkComputeDevice, poolInfo);
+
+	//Real valued input and output buffers, complex frequency domain scratch / kernel
+	m_isize = npoints * sizeof(float);
+	m_bsize = 2 * nouts * sizeof(float);
+
+	lock_guard<mutex> lock(g_vkTransferMutex);
+	QueueLock queuelock(g_vkTransferQueue);
+
+	//Extract raw handles of all of our Vulkan objects
+	m_physicalDevice = **g_vkComputePhysicalDevice;
+	m_device = **g_vkComputeDevice;
+	VkCommandPool rpool = *pool;
+	VkQueue queue = **queuelock;
+	m_rawfence = *m_fence;
+
+	if(g_hasDebugUtils)
+	{
+		g_vkComputeDevice->setDebugUtilsObjectNameEXT(
+			vk::DebugUtilsObjectNameInfoEXT(
+				vk::ObjectType::eFence,
+				reinterpret_cast<uint64_t>(m_rawfence),
+				"VulkanFFTConvolutionPlan.m_rawfence"));
+	}
+
+	//Kernel transform: forward R2C FFT of the time domain kernel into the library's internal layout
+	string kernelCacheKey = string("VkFFT_CONVKERN_V8_R2C_") + to_string(npoints);
+	m_kernelPipelineCache = **g_pipelineCacheMgr->Lookup(kernelCacheKey + ".spv", VkFFTGetVersion());
+
+	m_kernelConfig.FFTdim = 1;
+	m_kernelConfig.size[0] = npoints;
+	m_kernelConfig.size[1] = 1;
+	m_kernelConfig.size[2] = 1;
+	m_kernelConfig.physicalDevice = &m_physicalDevice;
+	m_kernelConfig.device = &m_device;
+	m_kernelConfig.queue = &queue;
+	m_kernelConfig.commandPool = &rpool;
+	m_kernelConfig.fence = &m_rawfence;
+	m_kernelConfig.isCompilerInitialized = 1;
+	m_kernelConfig.disableSetLocale = 1;
+	m_kernelConfig.pipelineCache = &m_kernelPipelineCache;
+	m_kernelConfig.performR2C = 1;
+	m_kernelConfig.kernelConvolution = 1;
+	m_kernelConfig.coordinateFeatures = 1;
+	m_kernelConfig.makeForwardPlanOnly = 1;
+	m_kernelConfig.isInputFormatted = 1;
+	m_kernelConfig.inputBufferStride[0] = npoints;
+	m_kernelConfig.inputBufferSize = &m_isize;
+	m_kernelConfig.bufferSize = &m_bsize;
+
+	//Load from cache
+	auto kernelCacheBlob = g_pipelineCacheMgr->LookupRaw(kernelCacheKey);
+	if(kernelCacheBlob != nullptr)
+	{
+		m_kernelConfig.loadApplicationFromString = 1;
+		m_kernelConfig.loadApplicationString = &(*kernelCacheBlob)[0];
+	}
+	else
+		m_kernelConfig.saveApplicationToString = 1;
+
+	auto err = initializeVkFFT(&m_kernelApp, m_kernelConfig);
+	if(VKFFT_SUCCESS != err)
+		LogError("Failed to initialize vkFFT kernel transform (code %d)\n", err);
+
+	//Add to cache if it wasn't there already
+	if(kernelCacheBlob == nullptr)
+	{
+		auto vec = make_shared<vector<uint8_t> >();
+		vec->resize(m_kernelApp.applicationStringSize);
+		memcpy(&(*vec)[0], m_kernelApp.saveApplicationString, m_kernelApp.applicationStringSize);
+		g_pipelineCacheMgr->StoreRaw(kernelCacheKey, vec);
+	}
+
+	//Main plan: forward FFT, complex multiply by the kernel, and inverse FFT as one fused operation
+	string cacheKey = string("VkFFT_CONV_V8_R2C_") + to_string(npoints);
+	m_pipelineCache = **g_pipelineCacheMgr->Lookup(cacheKey + ".spv", VkFFTGetVersion());
+
+	m_config.FFTdim = 1;
+	m_config.size[0] = npoints;
+	m_config.size[1] = 1;
+	m_config.size[2] = 1;
+	m_config.physicalDevice = &m_physicalDevice;
+	m_config.device = &m_device;
+	m_config.queue = &queue;
+	m_config.commandPool = &rpool;
+	m_config.fence = &m_rawfence;
+	m_config.isCompilerInitialized = 1;
+	m_config.disableSetLocale = 1;
+	m_config.pipelineCache = &m_pipelineCache;
+	m_config.performR2C = 1;
+	m_config.performConvolution = 1;
+	m_config.symmetricKernel = 0;
+	m_config.coordinateFeatures = 1;
+	m_config.numberKernels = 1;
+	m_config.kernelSize = &m_bsize;
+	m_config.isInputFormatted = 1;
+	m_config.inputBufferStride[0] = npoints;
+	m_config.inputBufferSize = &m_isize;
+	m_config.bufferSize = &m_bsize;
+	m_config.isOutputFormatted = 1;
+	m_config.outputBufferStride[0] = npoints;
+	m_config.outputBufferSize = &m_isize;
+
+	//Load from cache
+	auto cacheBlob = g_pipelineCacheMgr->LookupRaw(cacheKey);
+	if(cacheBlob != nullptr)
+	{
+		m_config.loadApplicationFromString = 1;
+		m_config.loadApplicationString = &(*cacheBlob)[0];
+	}
+	else
+		m_config.saveApplicationToString = 1;
+
+	err = initializeVkFFT(&m_app, m_config);
+	if(VKFFT_SUCCESS != err)
+		LogError("Failed to initialize vkFFT convolution (code %d)\n", err);
+
+	//Add to cache if it wasn't there already
+	if(cacheBlob == nullptr)
+	{
+		auto vec = make_shared<vector<uint8_t> >();
+		vec->resize(m_app.applicationStringSize);
+		memcpy(&(*vec)[0], m_app.saveApplicationString, m_app.applicationStringSize);
+		g_pipelineCacheMgr->StoreRaw(cacheKey, vec);
+	}
+
+	//Done initializing, clear queue pointers to make sure nothing uses it
+	m_config.queue = VK_NULL_HANDLE;
+	m_config.commandPool = VK_NULL_HANDLE;
+	m_kernelConfig.queue = VK_NULL_HANDLE;
+	m_kernelConfig.commandPool = VK_NULL_HANDLE;
+
+	//Allocate GPU-side storage for the transformed kernel
+	m_kernelFreqBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_kernelFreqBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_kernelFreqBuf.resize(2 * nouts);
+}
+
+VulkanFFTConvolutionPlan::~VulkanFFTConvolutionPlan()
+{
+	deleteVkFFT(&m_app);
+	deleteVkFFT(&m_kernelApp);
+}
+
+/**
+	@brief Appends a kernel transform to a command buffer
+
+	Converts a time domain kernel (impulse response) into the library's internal frequency domain layout,
+	ready for use by subsequent AppendConvolution() calls. Only needs to be redone when the kernel changes.
+
+	@param timeDomainKernel		Time domain kernel, npoints real valued samples
+	@param cmdBuf				Command buffer to append the transform to
+ */
+void VulkanFFTConvolutionPlan::AppendKernelTransform(
+	AcceleratorBuffer<float>& timeDomainKernel,
+	vk::raii::CommandBuffer& cmdBuf)
+{
+	timeDomainKernel.PrepareForGpuAccess();
+	m_kernelFreqBuf.PrepareForGpuAccess();
+
+	//Extract raw handles of all of our Vulkan objects
+	VkBuffer inbuf = timeDomainKernel.GetBuffer();
+	VkBuffer outbuf = m_kernelFreqBuf.GetBuffer();
+	VkCommandBuffer cmd = *cmdBuf;
+
+	VkFFTLaunchParams params;
+	memset(&params, 0, sizeof(params));
+	params.inputBuffer = &inbuf;
+	params.buffer = &outbuf;
+	params.commandBuffer = &cmd;
+
+	auto err = VkFFTAppend(&m_kernelApp, -1, &params);
+	if(VKFFT_SUCCESS != err)
+		LogError("Failed to append vkFFT kernel transform (code %d)\n", err);
+
+	m_kernelFreqBuf.MarkModifiedFromGpu();
+}
+
+/**
+	@brief Appends a fused forward FFT + complex multiply + inverse FFT to a command buffer
+
+	The kernel must have been transformed by a previous AppendKernelTransform() call (with appropriate
+	memory barriers in between if both are in the same command buffer).
+
+	@param dataIn	Time domain input, npoints real valued samples
+	@param scratch	Frequency domain scratch buffer, nouts complex (2*nouts float) values
+	@param dataOut	Time domain output, npoints real valued samples (scaled by npoints^2)
+	@param cmdBuf	Command buffer to append the convolution to
+ */
+void VulkanFFTConvolutionPlan::AppendConvolution(
+	AcceleratorBuffer<float>& dataIn,
+	AcceleratorBuffer<float>& scratch,
+	AcceleratorBuffer<float>& dataOut,
+	vk::raii::CommandBuffer& cmdBuf)
+{
+	dataIn.PrepareForGpuAccess();
+	scratch.PrepareForGpuAccess();
+	dataOut.PrepareForGpuAccess();
+	m_kernelFreqBuf.PrepareForGpuAccess();
+
+	//Extract raw handles of all of our Vulkan objects
+	VkBuffer inbuf = dataIn.GetBuffer();
+	VkBuffer workbuf = scratch.GetBuffer();
+	VkBuffer outbuf = dataOut.GetBuffer();
+	VkBuffer kernbuf = m_kernelFreqBuf.GetBuffer();
+	VkCommandBuffer cmd = *cmdBuf;
+
+	VkFFTLaunchParams params;
+	memset(&params, 0, sizeof(params));
+	params.inputBuffer = &inbuf;
+	params.buffer = &workbuf;
+	params.outputBuffer = &outbuf;
+	params.kernel = &kernbuf;
+	params.commandBuffer = &cmd;
+
+	auto err = VkFFTAppend(&m_app, -1, &params);
+	if(VKFFT_SUCCESS != err)
+		LogError("Failed to append vkFFT convolution (code %d)\n", err);
+
+	dataOut.MarkModifiedFromGpu();
+}
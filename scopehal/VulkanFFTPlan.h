@@ -144,6 +144,10 @@ public:
 	size_t size() const
 	{ return m_size; }
 
+	///@brief Return the approximate byte size of the scratch VRAM owned by the plan
+	size_t GetScratchSize() const
+	{ return m_tsize; }
+
 protected:
 
 	///@brief VkFFT application handle
@@ -181,4 +185,83 @@ protected:
 	uint64_t m_isize;
 };
 
+/**
+	@brief RAII wrapper around a VkFFT frequency domain convolution
+	@ingroup core
+
+	Wraps a pair of VkFFT applications which together apply a frequency domain transfer function to a real valued
+	signal: a kernel plan which transforms a time domain kernel into the library's internal frequency domain layout,
+	and a main plan which performs the forward FFT, complex multiply by the kernel, and inverse FFT as a single
+	fused operation. Compared to separate forward / multiply / inverse dispatches this halves VRAM traffic since
+	the frequency domain data never makes a round trip through device memory between passes.
+
+	Neither plan normalizes, so after a kernel transform plus a convolution the output is scaled by npoints^2
+	relative to the mathematical result.
+ */
+class VulkanFFTConvolutionPlan
+{
+public:
+	VulkanFFTConvolutionPlan(size_t npoints, size_t nouts);
+	~VulkanFFTConvolutionPlan();
+
+	void AppendKernelTransform(
+		AcceleratorBuffer<float>& timeDomainKernel,
+		vk::raii::CommandBuffer& cmdBuf);
+
+	void AppendConvolution(
+		AcceleratorBuffer<float>& dataIn,
+		AcceleratorBuffer<float>& scratch,
+		AcceleratorBuffer<float>& dataOut,
+		vk::raii::CommandBuffer& cmdBuf);
+
+	///@brief Return the number of points in the FFT
+	size_t size() const
+	{ return m_size; }
+
+protected:
+
+	///@brief VkFFT application handle for the fused convolution
+	VkFFTApplication m_app;
+
+	///@brief VkFFT configuration state for the fused convolution
+	VkFFTConfiguration m_config;
+
+	///@brief VkFFT application handle for the kernel transform
+	VkFFTApplication m_kernelApp;
+
+	///@brief VkFFT configuration state for the kernel transform
+	VkFFTConfiguration m_kernelConfig;
+
+	///@brief Number of points in the FFT
+	size_t m_size;
+
+	///@brief The kernel, in the library's internal frequency domain layout
+	AcceleratorBuffer<float> m_kernelFreqBuf;
+
+	//this is ugly but apparently we can't take a pointer to the underlying vk:: c++ wrapper objects?
+	///@brief Physical device the FFT is runnning on
+	VkPhysicalDevice m_physicalDevice;
+
+	///@brief Device the FFT is runnning on
+	VkDevice m_device;
+
+	///@brief Pipeline cache for precompiled shader binaries (fused convolution)
+	VkPipelineCache m_pipelineCache;
+
+	///@brief Pipeline cache for precompiled shader binaries (kernel transform)
+	VkPipelineCache m_kernelPipelineCache;
+
+	///@brief Fence for synchronizing FFTs
+	vk::raii::Fence m_fence;
+
+	///@brief The underlying VkFence of m_fence (we need to be able to take a pointer to it)
+	VkFence m_rawfence;
+
+	///@brief Byte size of the real valued input and output buffers
+	uint64_t m_isize;
+
+	///@brief Byte size of the complex frequency domain scratch and kernel buffers
+	uint64_t m_bsize;
+};
+
 #endif
@@ -0,0 +1,152 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of VulkanFFTPlanPool
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "VulkanFFTPlanPool.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+VulkanFFTPlanPool& VulkanFFTPlanPool::GetInstance()
+{
+	static VulkanFFTPlanPool pool;
+	return pool;
+}
+
+VulkanFFTPlanPool::VulkanFFTPlanPool()
+{
+	MemoryPressureManager::GetInstance().Register(this);
+}
+
+VulkanFFTPlanPool::~VulkanFFTPlanPool()
+{
+	MemoryPressureManager::GetInstance().Unregister(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Checkout
+
+/**
+	@brief Checks a plan of the requested geometry out of the pool, creating one if no idle plan matches
+
+	The returned plan belongs exclusively to the caller until the shared_ptr is dropped, at which point it goes
+	back on the idle list for the next borrower. Callers should hold a plan only for the duration of one
+	Refresh() pass (record, submit, and wait for completion), not across refreshes, so that other filters of the
+	same geometry can reuse it.
+ */
+shared_ptr<VulkanFFTPlan> VulkanFFTPlanPool::Acquire(
+	size_t npoints,
+	size_t nouts,
+	VulkanFFTPlan::VulkanFFTPlanDirection dir,
+	size_t numBatches,
+	VulkanFFTPlan::VulkanFFTDataType timeDomainType)
+{
+	PlanKey key(npoints, nouts, dir, numBatches, timeDomainType);
+
+	//Grab an idle plan of matching geometry if we have one
+	VulkanFFTPlan* plan = nullptr;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		auto it = m_idlePlans.find(key);
+		if( (it != m_idlePlans.end()) && !it->second.empty() )
+		{
+			plan = it->second.back().release();
+			it->second.pop_back();
+		}
+	}
+
+	//Creation is slow (shader generation etc.) so don't hold the pool lock while doing it
+	if(!plan)
+		plan = new VulkanFFTPlan(npoints, nouts, dir, numBatches, timeDomainType);
+
+	MemoryPressureManager::GetInstance().Touch(this);
+
+	//When the borrower lets go of the plan, put it back on the idle list rather than destroying it
+	return shared_ptr<VulkanFFTPlan>(
+		plan,
+		[this, key](VulkanFFTPlan* p)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_idlePlans[key].push_back(unique_ptr<VulkanFFTPlan>(p));
+		});
+}
+
+/**
+	@brief Frees all idle plans
+
+	Must be called before Vulkan shutdown (any checked-out plans must have been released first).
+ */
+void VulkanFFTPlanPool::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_idlePlans.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Memory pressure handling
+
+size_t VulkanFFTPlanPool::GetDeviceMemoryUse()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t total = 0;
+	for(auto& it : m_idlePlans)
+	{
+		for(auto& p : it.second)
+			total += p->GetScratchSize();
+	}
+	return total;
+}
+
+size_t VulkanFFTPlanPool::GetHostMemoryUse()
+{
+	//Plans live entirely in device memory (aside from negligible bookkeeping)
+	return 0;
+}
+
+size_t VulkanFFTPlanPool::EvictDeviceMemory()
+{
+	//Idle plans are pure cache: dropping them costs nothing but a rebuild stall on the next acquire
+	size_t freed = GetDeviceMemoryUse();
+	Clear();
+	return freed;
+}
+
+size_t VulkanFFTPlanPool::SpillHostMemory()
+{
+	return 0;
+}
@@ -0,0 +1,98 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of VulkanFFTPlanPool
+	@ingroup core
+ */
+#ifndef VulkanFFTPlanPool_h
+#define VulkanFFTPlanPool_h
+
+#include "VulkanFFTPlan.h"
+#include "MemoryPressureManager.h"
+
+#include <memory>
+#include <tuple>
+
+/**
+	@brief Process-wide pool of VulkanFFTPlan instances shared across filters
+	@ingroup core
+
+	Creating a VkFFT plan is expensive (shader generation and pipeline creation) and every plan owns scratch VRAM
+	proportional to its size, so filters which each build a private plan of identical geometry pay both a creation
+	stall when they are added to the graph and duplicate scratch memory for as long as they exist. In
+	spectrum-heavy sessions with many FFT based filters of the same length this adds up to hundreds of MB.
+
+	Instead of owning plans outright, filters check one out for the duration of a Refresh() via Acquire() and
+	release it (by dropping the returned shared_ptr) once the FFT has completed. A checked-out plan belongs
+	exclusively to its borrower, so two filters of identical geometry executing concurrently still get separate
+	instances; the pool only grows to the high-water mark of concurrent use rather than the total number of
+	filters. Released plans are kept warm for the next borrower and freed when device memory runs short.
+ */
+class VulkanFFTPlanPool : public MemoryPressureClient
+{
+public:
+	static VulkanFFTPlanPool& GetInstance();
+
+	virtual ~VulkanFFTPlanPool();
+
+	std::shared_ptr<VulkanFFTPlan> Acquire(
+		size_t npoints,
+		size_t nouts,
+		VulkanFFTPlan::VulkanFFTPlanDirection dir,
+		size_t numBatches = 1,
+		VulkanFFTPlan::VulkanFFTDataType timeDomainType = VulkanFFTPlan::TYPE_REAL);
+
+	void Clear();
+
+	//MemoryPressureClient
+	virtual size_t GetDeviceMemoryUse() override;
+	virtual size_t GetHostMemoryUse() override;
+	virtual size_t EvictDeviceMemory() override;
+	virtual size_t SpillHostMemory() override;
+
+	virtual MemoryBudgetGroup GetBudgetGroup() override
+	{ return MemoryBudgetGroup::FftScratch; }
+
+protected:
+	VulkanFFTPlanPool();
+
+	///@brief Geometry of a plan (npoints, nouts, direction, batch count, time domain type), used as the pool key
+	typedef std::tuple<size_t, size_t, int, size_t, int> PlanKey;
+
+	///@brief Mutex protecting m_idlePlans
+	std::mutex m_mutex;
+
+	///@brief Plans not currently checked out, grouped by geometry
+	std::map<PlanKey, std::vector<std::unique_ptr<VulkanFFTPlan>>> m_idlePlans;
+};
+
+#endif
@@ -37,6 +37,7 @@
 #include <glslang_c_interface.h>
 #include "PipelineCacheManager.h"
 #include "QueueManager.h"
+#include "VulkanFFTPlanPool.h"
 #include <GLFW/glfw3.h>
 
 //Lots of warnings here, disable them
@@ -123,6 +124,39 @@ uint32_t g_vkPinnedMemoryType;
  */
 uint32_t g_vkLocalMemoryType;
 
+/**
+	@brief Vulkan memory type for GPU-based memory that the CPU can map directly (resizable BAR)
+
+	Only valid if g_hasResizableBar is set.
+
+	@ingroup vksupport
+ */
+uint32_t g_vkBarMemoryType;
+
+///@brief Indicates whether timeline semaphores are available on the device
+bool g_hasTimelineSemaphores = false;
+
+///@brief Queue used for asynchronous (non-blocking) host-GPU transfers
+std::shared_ptr<QueueHandle> g_vkAsyncTransferQueue;
+
+///@brief Command pool for g_vkAsyncTransferCommandBuffers
+std::unique_ptr<vk::raii::CommandPool> g_vkAsyncTransferCommandPool;
+
+///@brief Ring of command buffers for in-flight asynchronous transfers
+std::vector<vk::raii::CommandBuffer> g_vkAsyncTransferCommandBuffers;
+
+///@brief Timeline semaphore signaled as asynchronous transfers complete
+std::unique_ptr<vk::raii::Semaphore> g_vkAsyncTransferSemaphore;
+
+///@brief Semaphore value of the last transfer submitted on each ring slot
+uint64_t g_asyncTransferSlotValues[ASYNC_TRANSFER_SLOTS] = {0};
+
+///@brief Value of the most recently submitted asynchronous transfer
+uint64_t g_asyncTransferCounter = 0;
+
+///@brief Mutex serializing submission of asynchronous transfers
+std::mutex g_asyncTransferMutex;
+
 /**
 	@brief UUID of g_vkComputeDevice
 	@ingroup vksupport
@@ -153,6 +187,22 @@ uint32_t g_vkPinnedMemoryHeap = 0;
  */
 uint32_t g_vkLocalMemoryHeap = 0;
 
+/**
+	@brief Heap from which g_vkBarMemoryType is allocated
+	@ingroup vksupport
+ */
+uint32_t g_vkBarMemoryHeap = 0;
+
+/**
+	@brief Names of all Vulkan physical devices found during init, indexed by enumeration order
+
+	Lets applications show the user what's available (e.g. to populate a device preference setting) without
+	re-enumerating. The active device is not necessarily index 0; see the SCOPEHAL_PREFERRED_GPU override.
+
+	@ingroup vksupport
+ */
+vector<string> g_vkComputeDeviceNames;
+
 bool IsDevicePreferred(const vk::PhysicalDeviceProperties& a, const vk::PhysicalDeviceProperties& b);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -200,6 +250,12 @@ bool g_hasDebugUtils = false;
  */
 bool g_hasMemoryBudget = false;
 
+/**
+	@brief Indicates whether the VK_EXT_memory_priority extension is available
+	@ingroup vksupport
+ */
+bool g_hasMemoryPriority = false;
+
 /**
 	@brief Indicates whether the VK_KHR_push_descriptor extension is available
 	@ingroup vksupport
@@ -219,6 +275,17 @@ bool g_hasPushDescriptor = false;
  */
 bool g_vulkanDeviceHasUnifiedMemory = false;
 
+/**
+	@brief Indicates whether the Vulkan device has a large host-mappable device-local heap (resizable BAR)
+	@ingroup vksupport
+
+	When set, the CPU can write directly into VRAM through a persistent mapping, so buffers that are written
+	by the CPU and consumed by shaders can skip the staging copy entirely.
+
+	Always false on unified memory platforms, where the distinction is meaningless.
+ */
+bool g_hasResizableBar = false;
+
 /**
 	@brief Maximum size of a Vulkan dispatch group for compute shaders, in each axis
 	@ingroup vksupport
@@ -397,8 +464,10 @@ bool VulkanInit(bool skipGLFW)
 				auto memProperties = device.getMemoryProperties();
 				auto limits = properties.limits;
 
+				//Remember the name so applications can enumerate what's available
+				g_vkComputeDeviceNames.push_back(string(&properties.deviceName[0]));
+
 				//See what device to use
-				//TODO: preference to override this
 				if(IsDevicePreferred(devices[bestDevice].getProperties(), devices[i].getProperties()))
 					bestDevice = i;
 
@@ -582,6 +651,49 @@ bool VulkanInit(bool skipGLFW)
 				}
 			}
 
+			//Let the user override the automatic selection, by enumeration index or by a
+			//case-insensitive substring of the device name (useful on multi-GPU hosts where the
+			//heuristic picks the display GPU, or to spread several instances across cards)
+			if(auto pref = getenv("SCOPEHAL_PREFERRED_GPU"))
+			{
+				bool matched = false;
+
+				//Try a numeric index first
+				char* end = nullptr;
+				auto idx = strtoul(pref, &end, 10);
+				if( (end != pref) && (*end == '\0') )
+				{
+					if(idx < devices.size())
+					{
+						bestDevice = idx;
+						matched = true;
+					}
+				}
+
+				//Not a number, try a substring match on the device name
+				else
+				{
+					string lpref = pref;
+					transform(lpref.begin(), lpref.end(), lpref.begin(), ::tolower);
+					for(size_t i=0; i<g_vkComputeDeviceNames.size(); i++)
+					{
+						string lname = g_vkComputeDeviceNames[i];
+						transform(lname.begin(), lname.end(), lname.begin(), ::tolower);
+						if(lname.find(lpref) != string::npos)
+						{
+							bestDevice = i;
+							matched = true;
+							break;
+						}
+					}
+				}
+
+				if(matched)
+					LogDebug("SCOPEHAL_PREFERRED_GPU=\"%s\" matched device %zu\n", pref, bestDevice);
+				else
+					LogWarning("SCOPEHAL_PREFERRED_GPU=\"%s\" does not match any device, using automatic selection\n", pref);
+			}
+
 			LogDebug("Selected device %zu\n", bestDevice);
 			{
 				auto& device = devices[bestDevice];
@@ -701,6 +813,7 @@ bool VulkanInit(bool skipGLFW)
 				vk::PhysicalDevice16BitStorageFeatures features16bit;
 				vk::PhysicalDevice8BitStorageFeatures features8bit;
 				vk::PhysicalDeviceVulkan12Features featuresVulkan12;
+				vk::PhysicalDeviceMemoryPriorityFeaturesEXT featuresMemoryPriority;
 				void* pNext = nullptr;
 				if(device.getFeatures().shaderFloat64)
 				{
@@ -761,6 +874,14 @@ bool VulkanInit(bool skipGLFW)
 							g_hasShaderInt8 = true;
 						}
 
+						//Enable timeline semaphores (used for asynchronous host-GPU transfers)
+						if(vulkan12Features.timelineSemaphore)
+						{
+							featuresVulkan12.timelineSemaphore = true;
+							LogDebug("Enabling timeline semaphore support\n");
+							g_hasTimelineSemaphores = true;
+						}
+
 						featuresVulkan12.pNext = pNext;
 						pNext = &featuresVulkan12;
 					}
@@ -819,6 +940,12 @@ bool VulkanInit(bool skipGLFW)
 						LogDebug("Device has VK_EXT_shader_atomic_float, requesting it\n");
 					}
 
+					if(!strcmp(&ext.extensionName[0], "VK_EXT_memory_priority"))
+					{
+						g_hasMemoryPriority = true;
+						LogDebug("Device has VK_EXT_memory_priority, requesting it\n");
+					}
+
 					if(!strcmp(&ext.extensionName[0], "VK_EXT_memory_budget"))
 					{
 						if(!hasPhysicalDeviceProperties2)
@@ -831,6 +958,14 @@ bool VulkanInit(bool skipGLFW)
 					}
 				}
 
+				//Memory priority is an optional feature that has to be explicitly enabled along with the extension
+				if(g_hasMemoryPriority)
+				{
+					featuresMemoryPriority.memoryPriority = true;
+					featuresMemoryPriority.pNext = pNext;
+					pNext = &featuresMemoryPriority;
+				}
+
 				//Initialize the device
 				vector<const char*> devextensions;
 				devextensions.push_back("VK_KHR_swapchain");
@@ -842,6 +977,8 @@ bool VulkanInit(bool skipGLFW)
 					devextensions.push_back("VK_EXT_shader_atomic_float");
 				if(g_hasMemoryBudget)
 					devextensions.push_back("VK_EXT_memory_budget");
+				if(g_hasMemoryPriority)
+					devextensions.push_back("VK_EXT_memory_priority");
 				if(g_hasPushDescriptor)
 					devextensions.push_back("VK_KHR_push_descriptor");
 				vk::DeviceCreateInfo devinfo(
@@ -933,9 +1070,38 @@ bool VulkanInit(bool skipGLFW)
 					}
 				}
 
+				//Look for a resizable BAR memory type: device-local VRAM that the host can map directly.
+				//Pre-ReBAR cards only expose a 256 MB window of this, so require a heap big enough that
+				//routing full-depth waveforms through it makes sense.
+				//Meaningless on unified memory platforms where everything is host visible anyway.
+				if( (devtype == vk::PhysicalDeviceType::eDiscreteGpu) && !g_vulkanDeviceHasUnifiedMemory)
+				{
+					const vk::DeviceSize minBarHeapSize = 1024ULL * 1024ULL * 1024ULL;
+					for(size_t j=0; j<memProperties.memoryTypeCount; j++)
+					{
+						auto mtype = memProperties.memoryTypes[j];
+						if(
+							(mtype.propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) &&
+							(mtype.propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) &&
+							(mtype.propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) &&
+							(memProperties.memoryHeaps[mtype.heapIndex].size >= minBarHeapSize) )
+						{
+							g_hasResizableBar = true;
+							g_vkBarMemoryType = j;
+							g_vkBarMemoryHeap = mtype.heapIndex;
+							break;
+						}
+					}
+				}
+
 				LogDebug("Using heap %u, type %u for pinned host memory\n", g_vkPinnedMemoryHeap, g_vkPinnedMemoryType);
 				LogDebug("Using heap %u, type %u for card-local memory\n", g_vkLocalMemoryHeap, g_vkLocalMemoryType);
 				if(g_vulkanDeviceHasUnifiedMemory) { LogDebug("Unified memory GPU optimizations are enabled\n"); }
+				if(g_hasResizableBar)
+				{
+					LogDebug("Using heap %u, type %u for host-mappable card-local (resizable BAR) memory\n",
+						g_vkBarMemoryHeap, g_vkBarMemoryType);
+				}
 
 				//Make the queue manager
 				g_vkQueueManager = make_unique<QueueManager>(g_vkComputePhysicalDevice, g_vkComputeDevice);
@@ -953,6 +1119,29 @@ bool VulkanInit(bool skipGLFW)
 				vk::CommandBufferAllocateInfo bufinfo(**g_vkTransferCommandPool, vk::CommandBufferLevel::ePrimary, 1);
 				g_vkTransferCommandBuffer = make_unique<vk::raii::CommandBuffer>(
 					std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+
+				//Make the arena that small GPU buffers are sub-allocated from
+				g_gpuMemoryArena = make_unique<GpuMemoryArena>(g_vkLocalMemoryType);
+
+				//Set up a second transfer queue for asynchronous copies, if we can signal completion of them
+				if(g_hasTimelineSemaphores)
+				{
+					g_vkAsyncTransferQueue = g_vkQueueManager->GetTransferQueue("g_vkAsyncTransferQueue");
+
+					vk::CommandPoolCreateInfo apoolInfo(
+						vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+						g_vkAsyncTransferQueue->m_family );
+					g_vkAsyncTransferCommandPool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, apoolInfo);
+
+					vk::CommandBufferAllocateInfo abufinfo(
+						**g_vkAsyncTransferCommandPool, vk::CommandBufferLevel::ePrimary, ASYNC_TRANSFER_SLOTS);
+					g_vkAsyncTransferCommandBuffers = vk::raii::CommandBuffers(*g_vkComputeDevice, abufinfo);
+
+					vk::SemaphoreTypeCreateInfo stinfo(vk::SemaphoreType::eTimeline, 0);
+					vk::SemaphoreCreateInfo sinfo;
+					sinfo.pNext = &stinfo;
+					g_vkAsyncTransferSemaphore = make_unique<vk::raii::Semaphore>(*g_vkComputeDevice, sinfo);
+				}
 			}
 
 			//Destroy other physical devices that we're not using
@@ -993,6 +1182,9 @@ bool VulkanInit(bool skipGLFW)
 	//Initialize our pipeline cache manager and load existing cache data
 	g_pipelineCacheMgr = make_unique<PipelineCacheManager>();
 
+	//Initialize the filter cost model (persisted through the pipeline cache)
+	g_filterCostModel = make_unique<FilterCostModel>();
+
 	//Print out vkFFT version for debugging
 	int vkfftver = VkFFTGetVersion();
 	int vkfft_major = vkfftver / 10000;
@@ -1059,10 +1251,91 @@ bool IsDevicePreferred(const vk::PhysicalDeviceProperties& a, const vk::Physical
 	@brief Free all global Vulkan resources in the correct order
 	@ingroup vksupport
  */
+/**
+	@brief Kicks off an asynchronous copy between two GPU-visible buffers on the dedicated async transfer queue
+	@ingroup vksupport
+
+	The copy runs concurrently with work on the compute queues; neither buffer may be freed, resized, or accessed
+	on the destination side until the transfer has been waited on.
+
+	@return Handle to pass to WaitForAsyncTransfer() / IsAsyncTransferDone()
+ */
+uint64_t SubmitAsyncTransfer(vk::Buffer src, vk::Buffer dst, size_t size)
+{
+	lock_guard<mutex> lock(g_asyncTransferMutex);
+
+	uint64_t value = ++g_asyncTransferCounter;
+	size_t slot = value % ASYNC_TRANSFER_SLOTS;
+
+	//Wait for the transfer that last used this slot's command buffer to retire before re-recording it
+	WaitForAsyncTransfer(g_asyncTransferSlotValues[slot]);
+
+	auto& cmdbuf = g_vkAsyncTransferCommandBuffers[slot];
+	cmdbuf.begin({});
+	cmdbuf.copyBuffer(src, dst, vk::BufferCopy(0, 0, size));
+	cmdbuf.end();
+
+	//Submit, signaling the timeline semaphore on completion
+	vk::CommandBuffer rawBuf = *cmdbuf;
+	vk::Semaphore sem = **g_vkAsyncTransferSemaphore;
+	vk::TimelineSemaphoreSubmitInfo tsInfo;
+	tsInfo.signalSemaphoreValueCount = 1;
+	tsInfo.pSignalSemaphoreValues = &value;
+	vk::SubmitInfo info;
+	info.commandBufferCount = 1;
+	info.pCommandBuffers = &rawBuf;
+	info.signalSemaphoreCount = 1;
+	info.pSignalSemaphores = &sem;
+	info.pNext = &tsInfo;
+	{
+		QueueLock qlock(g_vkAsyncTransferQueue);
+		(*qlock).submit(info);
+	}
+
+	g_asyncTransferSlotValues[slot] = value;
+	return value;
+}
+
+/**
+	@brief Blocks until the given asynchronous transfer has completed
+	@ingroup vksupport
+ */
+void WaitForAsyncTransfer(uint64_t handle)
+{
+	if(handle == 0)
+		return;
+
+	vk::Semaphore sem = **g_vkAsyncTransferSemaphore;
+	vk::SemaphoreWaitInfo winfo;
+	winfo.semaphoreCount = 1;
+	winfo.pSemaphores = &sem;
+	winfo.pValues = &handle;
+	while(vk::Result::eTimeout == g_vkComputeDevice->waitSemaphores(winfo, 1000 * 1000))
+	{}
+}
+
+/**
+	@brief Checks if the given asynchronous transfer has completed, without blocking
+	@ingroup vksupport
+ */
+bool IsAsyncTransferDone(uint64_t handle)
+{
+	if(handle == 0)
+		return true;
+
+	return g_vkAsyncTransferSemaphore->getCounterValue() >= handle;
+}
+
 void VulkanCleanup()
 {
 	glfwTerminate();
 
+	//Destroy the cost model before the pipeline cache manager so its final save lands in the cache
+	g_filterCostModel = nullptr;
+
+	//Free pooled FFT plans while the device still exists
+	VulkanFFTPlanPool::GetInstance().Clear();
+
 	g_pipelineCacheMgr = nullptr;
 
 	glslang_finalize_process();
@@ -1071,6 +1344,13 @@ void VulkanCleanup()
 	g_vkTransferCommandBuffer = nullptr;
 	g_vkTransferCommandPool = nullptr;
 
+	g_gpuMemoryArena = nullptr;
+
+	g_vkAsyncTransferSemaphore = nullptr;
+	g_vkAsyncTransferCommandBuffers.clear();
+	g_vkAsyncTransferCommandPool = nullptr;
+	g_vkAsyncTransferQueue = nullptr;
+
 	g_vkQueueManager = nullptr;
 
 	g_vkComputeDevice = nullptr;
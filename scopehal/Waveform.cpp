@@ -85,6 +85,171 @@ size_t BinarySearchForGequal(T* buf, size_t len, T value)
 template size_t BinarySearchForGequal<int64_t>(int64_t* buf, size_t len, int64_t value);
 template size_t BinarySearchForGequal<float>(float* buf, size_t len, float value);
 
+/**
+	@brief Rebuilds the time-to-index acceleration structure.
+
+	Caller must hold a current CPU-side copy of m_offsets and guarantee the waveform is nonempty.
+ */
+void SparseWaveformBase::RebuildOffsetIndex()
+{
+	size_t len = size();
+	const int64_t* offsets = m_offsets.GetCpuPointer();
+	int64_t first = offsets[0];
+	int64_t last = offsets[len-1];
+
+	//Cap the bucket count so tiny waveforms don't get an oversized index, while keeping buckets only a few
+	//samples wide for big ones
+	size_t nbuckets = min(len, (size_t)4096);
+
+	m_offsetIndexBase = first;
+	m_offsetIndexStride = max( (int64_t)1, (int64_t)( (last - first + nbuckets) / nbuckets ) );
+
+	//For each bucket, find the index of the first sample at or after the bucket's start time
+	m_offsetIndex.clear();
+	m_offsetIndex.resize(nbuckets + 1);
+	size_t i = 0;
+	for(size_t b = 0; b < nbuckets; b++)
+	{
+		int64_t tstart = m_offsetIndexBase + (int64_t)b * m_offsetIndexStride;
+		while( (i < len) && (offsets[i] < tstart) )
+			i++;
+		m_offsetIndex[b] = i;
+	}
+	m_offsetIndex[nbuckets] = len;
+
+	m_offsetIndexRevision = m_revision;
+}
+
+/**
+	@brief Returns the index of the last sample whose offset is less than or equal to the target timestamp.
+
+	Same semantics as running BinarySearchForGequal over the full offsets array (including the clipping behavior
+	at either end of the waveform), but O(1): the acceleration index narrows the search down to a single bucket
+	spanning only a few samples. The index is built on first use and reused until the waveform's revision number
+	changes, so repeated time-to-index queries from decoders or cursors are cheap.
+
+	@param target	Timestamp to search for, in multiples of m_timescale
+ */
+size_t SparseWaveformBase::FindIndexNearestAtOrBefore(int64_t target)
+{
+	size_t len = size();
+	if(!len)
+		return 0;
+
+	m_offsets.PrepareForCpuAccess();
+	const int64_t* offsets = m_offsets.GetCpuPointer();
+
+	//Clip if out of range
+	if(offsets[0] >= target)
+		return 0;
+	if(offsets[len-1] < target)
+		return len-1;
+
+	//Build the acceleration index if we don't have a current one
+	if( m_offsetIndex.empty() ||
+		(m_offsetIndexRevision != m_revision) ||
+		(m_offsetIndex[m_offsetIndex.size()-1] != len) )
+	{
+		RebuildOffsetIndex();
+	}
+
+	//Find the bucket containing the target
+	size_t nbuckets = m_offsetIndex.size() - 1;
+	size_t bucket = min( (size_t)( (target - m_offsetIndexBase) / m_offsetIndexStride ), nbuckets - 1);
+
+	//The match is within [idx[b]-1, idx[b+1]]: entry b is the first sample at or after the bucket's start time,
+	//so the sample just before it may be the last one at or before a target early in the bucket
+	size_t lo = m_offsetIndex[bucket];
+	if(lo > 0)
+		lo--;
+	size_t hi = m_offsetIndex[bucket+1];
+	if(hi >= len)
+		hi = len-1;
+
+	return lo + BinarySearchForGequal(m_offsets.GetCpuPointer() + lo, (hi - lo) + 1, target);
+}
+
+/**
+	@brief Cursor-cached variant of FindIndexNearestAtOrBefore() for monotonic access patterns.
+
+	When queried with nondecreasing timestamps (the typical cross-stream correlation loop), this walks forward
+	from the previous result instead of searching from scratch, so a full loop of lookups touches each sample
+	at most once. Falls back to the accelerated search if the cursor is stale or the target jumped far ahead.
+	Results are identical to FindIndexNearestAtOrBefore() for any query, monotonic or not.
+
+	@param target	Timestamp to search for, in multiples of m_timescale
+ */
+size_t SparseWaveformBase::FindIndexNearestAtOrBeforeMonotonic(int64_t target)
+{
+	size_t len = size();
+	if(!len)
+		return 0;
+
+	m_offsets.PrepareForCpuAccess();
+	const int64_t* offsets = m_offsets.GetCpuPointer();
+
+	//Fast path: resume from the last result if it's still at or before the target
+	if( (m_searchCursorRevision == m_revision) && (m_searchCursor < len) && (offsets[m_searchCursor] <= target) )
+	{
+		//Step forward a handful of samples; consecutive queries usually land close together
+		size_t i = m_searchCursor;
+		size_t limit = min(len, i + 64);
+		while( ( (i+1) < limit) && (offsets[i+1] <= target) )
+			i++;
+
+		//If we hit the end of the match run (not just the step limit), this is the answer
+		if( ( (i+1) >= len) || (offsets[i+1] > target) )
+		{
+			m_searchCursor = i;
+			return i;
+		}
+	}
+
+	//Cursor was no help, do a full search and reseed it
+	size_t i = FindIndexNearestAtOrBefore(target);
+	m_searchCursor = i;
+	m_searchCursorRevision = m_revision;
+	return i;
+}
+
+/**
+	@brief Returns the index of the first sample whose offset is greater than or equal to the target timestamp.
+
+	Returns size() if every sample begins before the target (i.e. no match), mirroring std::lower_bound.
+
+	@param target	Timestamp to search for, in multiples of m_timescale
+ */
+size_t SparseWaveformBase::LowerBound(int64_t target)
+{
+	size_t len = size();
+	if(!len)
+		return 0;
+
+	m_offsets.PrepareForCpuAccess();
+	const int64_t* offsets = m_offsets.GetCpuPointer();
+
+	if(offsets[len-1] < target)
+		return len;
+
+	size_t i = FindIndexNearestAtOrBefore(target);
+	if(offsets[i] >= target)
+		return i;
+	return i + 1;
+}
+
+/**
+	@brief Returns the index of the first sample whose offset is strictly greater than the target timestamp.
+
+	Returns size() if every sample begins at or before the target (i.e. no match), mirroring std::upper_bound.
+
+	@param target	Timestamp to search for, in multiples of m_timescale
+ */
+size_t SparseWaveformBase::UpperBound(int64_t target)
+{
+	//Offsets are integers, so the first sample after t is the first sample at or after t+1
+	return LowerBound(target + 1);
+}
+
 // Logic to 'step back' one sample is required. Think of the case of a waveform with samples at
 // 0 (duration 2) and 3 (duration 2). If the requested time_fs results in ticks = 1.5, then target
 // = floor(1.5) = 1. Then searching for the index of the offset greater than or equal to 1 yields
@@ -119,10 +284,7 @@ size_t GetIndexNearestAtOrBeforeTimestamp(WaveformBase* wfm, int64_t time_fs, bo
 			return wfm->size() - 1;
 		}
 
-		result = BinarySearchForGequal(
-			swfm->m_offsets.GetCpuPointer(),
-			wfm->size(),
-			target);
+		result = swfm->FindIndexNearestAtOrBefore(target);
 
 		// Unless we found an exact match, step back one sample
 		if (!(swfm->m_offsets[result] <= target))
@@ -250,7 +412,8 @@ optional<string> GetProtocolValueAtTime(WaveformBase* waveform, int64_t time_fs)
 		return {};
 	}
 
-	return waveform->GetText(index);
+	//Cached since tooltips re-query the same sample every frame while hovering
+	return waveform->GetTextCached(index);
 }
 
 //from imgui but we don't want to depend on it here
@@ -326,3 +489,34 @@ void WaveformBase::CacheColors()
 
 	m_protocolColors.MarkModifiedFromCpu();
 }
+
+/**
+	@brief Returns the text of a given protocol sample, caching the result so redraws don't re-format it
+
+	Unlike CacheColors() this is lazy: scrolling through a huge decode only ever formats the events that are
+	actually drawn. The returned strings are interned, since dense decodes repeat the same few strings (hex
+	bytes, ACK/NAK, etc) over and over; the reference stays valid until the waveform is next modified.
+
+	@param i	Sample index
+ */
+const string& WaveformBase::GetTextCached(size_t i)
+{
+	//Invalidate on revision change
+	if( (m_cachedTextRevision != m_revision) || (m_cachedText.size() != size()) )
+	{
+		m_cachedTextRevision = m_revision;
+		m_cachedText.assign(size(), nullptr);
+		m_textInternTable.clear();
+	}
+
+	//Bounds check (can't dereference a null slot for an out of range index)
+	static const string empty;
+	if(i >= m_cachedText.size())
+		return empty;
+
+	//Format and intern the text the first time this event is displayed
+	auto& slot = m_cachedText[i];
+	if(!slot)
+		slot = &*m_textInternTable.insert(GetText(i)).first;
+	return *slot;
+}
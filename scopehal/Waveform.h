@@ -37,12 +37,15 @@
 #ifndef Waveform_h
 #define Waveform_h
 
+#include <memory>
 #include <vector>
 #include <optional>
+#include <set>
 #include <AlignedAllocator.h>
 
 #include "StandardColors.h"
 #include "AcceleratorBuffer.h"
+#include "MinMaxPyramid.h"
 
 /**
 	@brief Base class for all Waveform specializations
@@ -69,7 +72,9 @@ public:
 		, m_triggerPhase(0)
 		, m_flags(0)
 		, m_revision(0)
+		, m_dirtyStartIndex(0)
 		, m_cachedColorRevision(0)
+		, m_cachedTextRevision(0)
 	{
 	}
 
@@ -83,6 +88,8 @@ public:
 		, m_triggerPhase(rhs.m_triggerPhase)
 		, m_flags(rhs.m_flags)
 		, m_revision(rhs.m_revision)
+		, m_dirtyStartIndex(rhs.m_dirtyStartIndex)
+		, m_cachedTextRevision(0)
 	{}
 
 	//empty virtual destructor in case any derived classes need one
@@ -138,6 +145,32 @@ public:
 	 */
 	uint64_t m_revision;
 
+	/**
+		@brief Index of the first sample modified by the most recent revision bump.
+
+		Only meaningful for the update that bumped m_revision to its current value. Producers which append
+		samples to an existing waveform in place (streaming drivers and similar) should call
+		MarkSamplesAppended() for every such update; anything else that modifies the waveform must leave
+		this at zero so consumers fall back to reprocessing the whole record.
+
+		See InputDirtyRegionTracker for the consumer side of this protocol.
+	 */
+	size_t m_dirtyStartIndex;
+
+	/**
+		@brief Records that samples were appended in place, leaving existing samples untouched.
+
+		Bumps m_revision and remembers where the new data starts, so downstream consumers tracking this
+		waveform with an InputDirtyRegionTracker can process only the appended samples.
+
+		@param oldLength	Length of the waveform before the new samples were appended
+	 */
+	void MarkSamplesAppended(size_t oldLength)
+	{
+		m_revision ++;
+		m_dirtyStartIndex = oldLength;
+	}
+
 	///@brief Flags which may apply to m_flags
 	enum WaveformFlags_t
 	{
@@ -176,6 +209,8 @@ public:
 		return "(unimplemented)";
 	}
 
+	const std::string& GetTextCached(size_t i);
+
 	/**
 		@brief Returns the displayed color (in HTML #rrggbb or #rrggbbaa notation) of a given protocol sample.
 
@@ -240,6 +275,45 @@ public:
 	///@brief Returns true if we have at least one buffer resident on the GPU
 	virtual bool HasGpuBuffer() =0;
 
+	/**
+		@brief Builds or refreshes this waveform's min/max pyramid on the GPU.
+
+		The pyramid is optional (allocated on first use) and only available for analog waveforms. Producers
+		which modify sample data on the GPU and expect downstream envelope queries can call this while they
+		still have a command buffer in hand; otherwise the pyramid is built lazily on the CPU by the first
+		GetEnvelope() call and revalidated against m_revision from then on.
+
+		@param cmdBuf	Command buffer for GPU work (must not be in the recording state)
+		@param queue	Queue to submit GPU work to
+
+		@return True on success, false if this waveform type does not support envelope queries
+	 */
+	virtual bool BuildMinMaxPyramid(
+		[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
+		[[maybe_unused]] std::shared_ptr<QueueHandle> queue)
+	{ return false; }
+
+	/**
+		@brief Returns the min and max sample value over an arbitrary range of the waveform.
+
+		Backed by a mipmap-style min/max pyramid so queries run in O(log n) regardless of range size; see
+		MinMaxPyramid for details. Only available for analog waveforms.
+
+		@param start	Index of the first sample in the query range
+		@param len		Number of samples in the query range
+		@param vmin		Output: smallest sample value in the range
+		@param vmax		Output: largest sample value in the range
+
+		@return True on success, false if this waveform type does not support envelope queries or the
+		        query range is empty or out of bounds
+	 */
+	virtual bool GetEnvelope(
+		[[maybe_unused]] size_t start,
+		[[maybe_unused]] size_t len,
+		[[maybe_unused]] float& vmin,
+		[[maybe_unused]] float& vmax)
+	{ return false; }
+
 protected:
 
 	///@brief Cache of packed RGBA32 data with colors for each protocol decode event. Empty for non-protocol waveforms.
@@ -247,6 +321,20 @@ protected:
 
 	///@brief Revision we last cached colors of
 	uint64_t m_cachedColorRevision;
+
+	/**
+		@brief Cache of display text for each protocol decode event, filled lazily by GetTextCached().
+
+		Entries point into m_textInternTable; null means the event has not been formatted yet.
+		Empty for non-protocol waveforms.
+	 */
+	std::vector<const std::string*> m_cachedText;
+
+	///@brief Interned event text (dense decodes repeat the same few strings over and over)
+	std::set<std::string> m_textInternTable;
+
+	///@brief Revision we last cached text of
+	uint64_t m_cachedTextRevision;
 };
 
 template<class S> class SparseWaveform;
@@ -270,6 +358,11 @@ public:
 		@brief Constructs a new empty sparse waveform
 	 */
 	SparseWaveformBase()
+		: m_offsetIndexBase(0)
+		, m_offsetIndexStride(0)
+		, m_offsetIndexRevision(0)
+		, m_searchCursor(0)
+		, m_searchCursorRevision(0)
 	{
 		//Default timestamps to CPU/GPU mirror
 		m_offsets.SetCpuAccessHint(AcceleratorBuffer<int64_t>::HINT_LIKELY);
@@ -327,6 +420,59 @@ public:
 		MarkSamplesModifiedFromGpu();
 		MarkTimestampsModifiedFromGpu();
 	}
+
+	size_t FindIndexNearestAtOrBefore(int64_t target);
+	size_t FindIndexNearestAtOrBeforeMonotonic(int64_t target);
+
+	size_t LowerBound(int64_t target);
+	size_t UpperBound(int64_t target);
+
+	/**
+		@brief Returns the half-open index range [first, last) of samples whose offsets lie within [tstart, tend].
+
+		Iterate with an ordinary index loop: for(size_t i = range.first; i < range.second; i++).
+		The range is empty (first == second) if no samples fall within the window.
+
+		@param tstart	Start of the time window, in multiples of m_timescale
+		@param tend		End of the time window (inclusive), in multiples of m_timescale
+	 */
+	std::pair<size_t, size_t> FindSampleRange(int64_t tstart, int64_t tend)
+	{ return std::pair<size_t, size_t>(LowerBound(tstart), UpperBound(tend)); }
+
+protected:
+	void RebuildOffsetIndex();
+
+	/**
+		@brief Acceleration index for time-to-index lookups, built lazily by the first call to
+		FindIndexNearestAtOrBefore() and cached until the waveform's revision number changes.
+
+		Entry b holds the index of the first sample whose offset is at or after
+		(m_offsetIndexBase + b*m_offsetIndexStride), with one extra entry at the end holding size(). A lookup
+		computes its bucket in O(1) and then only searches the handful of samples the bucket spans, instead of
+		binary searching the whole offsets array with cold cache misses at every probe.
+	 */
+	std::vector<size_t> m_offsetIndex;
+
+	///@brief Timestamp of bucket 0 of the offset index, in multiples of m_timescale
+	int64_t m_offsetIndexBase;
+
+	///@brief Width of each offset index bucket, in multiples of m_timescale
+	int64_t m_offsetIndexStride;
+
+	///@brief Revision we last built the offset index for
+	uint64_t m_offsetIndexRevision;
+
+	/**
+		@brief Index of the most recent FindIndexNearestAtOrBeforeMonotonic() result.
+
+		Correlation loops tend to query timestamps in increasing order with small steps between queries, so the
+		next match is usually within a few samples of the previous one. Starting there turns a whole loop of
+		lookups into a single O(n) walk over the waveform.
+	 */
+	size_t m_searchCursor;
+
+	///@brief Revision the search cursor was last updated for
+	uint64_t m_searchCursorRevision;
 };
 
 /**
@@ -442,6 +588,37 @@ public:
 	virtual void MarkModifiedFromGpu() override
 	{ MarkSamplesModifiedFromGpu(); }
 
+	virtual bool BuildMinMaxPyramid(
+		[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
+		[[maybe_unused]] std::shared_ptr<QueueHandle> queue) override
+	{
+		if constexpr (std::is_same<S, float>::value)
+		{
+			if(!m_minMaxPyramid)
+				m_minMaxPyramid = std::make_unique<MinMaxPyramid>();
+			m_minMaxPyramid->Build(m_samples, m_revision, cmdBuf, queue);
+			return true;
+		}
+		else
+			return false;
+	}
+
+	virtual bool GetEnvelope(
+		[[maybe_unused]] size_t start,
+		[[maybe_unused]] size_t len,
+		[[maybe_unused]] float& vmin,
+		[[maybe_unused]] float& vmax) override
+	{
+		if constexpr (std::is_same<S, float>::value)
+		{
+			if(!m_minMaxPyramid)
+				m_minMaxPyramid = std::make_unique<MinMaxPyramid>();
+			return m_minMaxPyramid->GetEnvelope(m_samples, m_revision, start, len, vmin, vmax);
+		}
+		else
+			return false;
+	}
+
 	/**
 		@brief Passes a hint to the memory allocator about where our sample data is expected to be used
 
@@ -449,6 +626,10 @@ public:
 	 */
 	void SetGpuAccessHint(enum AcceleratorBuffer<S>::UsageHint hint)
 	{ m_samples.SetGpuAccessHint(hint); }
+
+protected:
+	///@brief Multi-resolution min/max reduction of the sample data, allocated on first use (analog only)
+	std::unique_ptr<MinMaxPyramid> m_minMaxPyramid;
 };
 
 /**
@@ -570,6 +751,37 @@ public:
 	virtual void MarkSamplesModifiedFromGpu() override
 	{ m_samples.MarkModifiedFromGpu(); }
 
+	virtual bool BuildMinMaxPyramid(
+		[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
+		[[maybe_unused]] std::shared_ptr<QueueHandle> queue) override
+	{
+		if constexpr (std::is_same<S, float>::value)
+		{
+			if(!m_minMaxPyramid)
+				m_minMaxPyramid = std::make_unique<MinMaxPyramid>();
+			m_minMaxPyramid->Build(m_samples, m_revision, cmdBuf, queue);
+			return true;
+		}
+		else
+			return false;
+	}
+
+	virtual bool GetEnvelope(
+		[[maybe_unused]] size_t start,
+		[[maybe_unused]] size_t len,
+		[[maybe_unused]] float& vmin,
+		[[maybe_unused]] float& vmax) override
+	{
+		if constexpr (std::is_same<S, float>::value)
+		{
+			if(!m_minMaxPyramid)
+				m_minMaxPyramid = std::make_unique<MinMaxPyramid>();
+			return m_minMaxPyramid->GetEnvelope(m_samples, m_revision, start, len, vmin, vmax);
+		}
+		else
+			return false;
+	}
+
 	/**
 		@brief Passes a hint to the memory allocator about where our sample data is expected to be used
 
@@ -581,6 +793,10 @@ public:
 		m_durations.SetGpuAccessHint(static_cast<AcceleratorBuffer<int64_t>::UsageHint>(hint));
 		m_samples.SetGpuAccessHint(hint);
 	}
+
+protected:
+	///@brief Multi-resolution min/max reduction of the sample data, allocated on first use (analog only)
+	std::unique_ptr<MinMaxPyramid> m_minMaxPyramid;
 };
 
 typedef SparseWaveform<bool> 					SparseDigitalWaveform;
@@ -0,0 +1,370 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformCompressor
+	@ingroup datamodel
+ */
+#include "scopehal.h"
+#include "WaveformCompressor.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Top level pack/unpack
+
+/**
+	@brief Compresses a waveform into a CompressedWaveform
+
+	The input waveform is not modified (other than being synced to the CPU if it was GPU resident)
+	and remains owned by the caller.
+
+	@param wfm	The waveform to compress
+
+	@return The compressed waveform, or nullptr if the waveform type is not supported
+ */
+unique_ptr<CompressedWaveform> WaveformCompressor::Compress(WaveformBase* wfm)
+{
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm);
+	auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm);
+	if(!ua && !sa && !ud && !sd)
+		return nullptr;
+
+	wfm->PrepareForCpuAccess();
+
+	auto ret = make_unique<CompressedWaveform>();
+	ret->m_sampleCount = wfm->size();
+	ret->m_timescale = wfm->m_timescale;
+	ret->m_startTimestamp = wfm->m_startTimestamp;
+	ret->m_startFemtoseconds = wfm->m_startFemtoseconds;
+	ret->m_triggerPhase = wfm->m_triggerPhase;
+	ret->m_flags = wfm->m_flags;
+	ret->m_revision = wfm->m_revision;
+
+	if(ua)
+	{
+		ret->m_kind = CompressedWaveform::KIND_UNIFORM_ANALOG;
+		CompressFloats(ua->m_samples.GetCpuPointer(), ua->size(), ret->m_samples);
+	}
+	else if(sa)
+	{
+		ret->m_kind = CompressedWaveform::KIND_SPARSE_ANALOG;
+		CompressFloats(sa->m_samples.GetCpuPointer(), sa->size(), ret->m_samples);
+		CompressInt64s(sa->m_offsets.GetCpuPointer(), sa->size(), ret->m_offsets);
+		CompressInt64s(sa->m_durations.GetCpuPointer(), sa->size(), ret->m_durations);
+	}
+	else if(ud)
+	{
+		ret->m_kind = CompressedWaveform::KIND_UNIFORM_DIGITAL;
+		CompressBools(ud->m_samples.GetCpuPointer(), ud->size(), ret->m_samples);
+	}
+	else
+	{
+		ret->m_kind = CompressedWaveform::KIND_SPARSE_DIGITAL;
+		CompressBools(sd->m_samples.GetCpuPointer(), sd->size(), ret->m_samples);
+		CompressInt64s(sd->m_offsets.GetCpuPointer(), sd->size(), ret->m_offsets);
+		CompressInt64s(sd->m_durations.GetCpuPointer(), sd->size(), ret->m_durations);
+	}
+
+	return ret;
+}
+
+/**
+	@brief Reconstructs a waveform from its compressed form
+
+	@param cwfm	The compressed waveform
+
+	@return A newly allocated waveform, owned by the caller, bitwise identical to the original
+ */
+WaveformBase* WaveformCompressor::Decompress(const CompressedWaveform& cwfm)
+{
+	WaveformBase* ret;
+	size_t count = cwfm.m_sampleCount;
+
+	switch(cwfm.m_kind)
+	{
+		case CompressedWaveform::KIND_UNIFORM_ANALOG:
+			{
+				auto wfm = new UniformAnalogWaveform;
+				wfm->Resize(count);
+				wfm->PrepareForCpuAccess();
+				DecompressFloats(cwfm.m_samples, count, wfm->m_samples.GetCpuPointer());
+				ret = wfm;
+			}
+			break;
+
+		case CompressedWaveform::KIND_SPARSE_ANALOG:
+			{
+				auto wfm = new SparseAnalogWaveform;
+				wfm->Resize(count);
+				wfm->PrepareForCpuAccess();
+				DecompressFloats(cwfm.m_samples, count, wfm->m_samples.GetCpuPointer());
+				DecompressInt64s(cwfm.m_offsets, count, wfm->m_offsets.GetCpuPointer());
+				DecompressInt64s(cwfm.m_durations, count, wfm->m_durations.GetCpuPointer());
+				ret = wfm;
+			}
+			break;
+
+		case CompressedWaveform::KIND_UNIFORM_DIGITAL:
+			{
+				auto wfm = new UniformDigitalWaveform;
+				wfm->Resize(count);
+				wfm->PrepareForCpuAccess();
+				DecompressBools(cwfm.m_samples, count, wfm->m_samples.GetCpuPointer());
+				ret = wfm;
+			}
+			break;
+
+		case CompressedWaveform::KIND_SPARSE_DIGITAL:
+		default:
+			{
+				auto wfm = new SparseDigitalWaveform;
+				wfm->Resize(count);
+				wfm->PrepareForCpuAccess();
+				DecompressBools(cwfm.m_samples, count, wfm->m_samples.GetCpuPointer());
+				DecompressInt64s(cwfm.m_offsets, count, wfm->m_offsets.GetCpuPointer());
+				DecompressInt64s(cwfm.m_durations, count, wfm->m_durations.GetCpuPointer());
+				ret = wfm;
+			}
+			break;
+	}
+
+	ret->m_timescale = cwfm.m_timescale;
+	ret->m_startTimestamp = cwfm.m_startTimestamp;
+	ret->m_startFemtoseconds = cwfm.m_startFemtoseconds;
+	ret->m_triggerPhase = cwfm.m_triggerPhase;
+	ret->m_flags = cwfm.m_flags;
+	ret->m_revision = cwfm.m_revision;
+	ret->MarkModifiedFromCpu();
+
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Field codecs
+
+/**
+	@brief Compresses an array of floats by byte stream splitting plus run length coding
+
+	Byte N of every sample is grouped into a plane, then each plane is run length coded separately.
+	Adjacent samples usually share sign/exponent bits so the high planes compress to long runs.
+ */
+void WaveformCompressor::CompressFloats(const float* din, size_t count, vector<uint8_t>& out)
+{
+	out.clear();
+	auto bytes = reinterpret_cast<const uint8_t*>(din);
+
+	vector<uint8_t> plane;
+	plane.resize(count);
+	for(size_t b = 0; b < sizeof(float); b ++)
+	{
+		for(size_t i = 0; i < count; i ++)
+			plane[i] = bytes[i*sizeof(float) + b];
+		RunLengthEncode(plane.data(), count, out);
+	}
+}
+
+void WaveformCompressor::DecompressFloats(const vector<uint8_t>& din, size_t count, float* dout)
+{
+	auto bytes = reinterpret_cast<uint8_t*>(dout);
+
+	vector<uint8_t> plane;
+	plane.resize(count);
+	size_t pos = 0;
+	for(size_t b = 0; b < sizeof(float); b ++)
+	{
+		pos += RunLengthDecode(din.data() + pos, din.size() - pos, plane.data(), count);
+		for(size_t i = 0; i < count; i ++)
+			bytes[i*sizeof(float) + b] = plane[i];
+	}
+}
+
+/**
+	@brief Compresses an array of int64s by delta coding plus zigzag mapped LEB128 varints
+
+	Sample offsets advance by small strides, so after delta coding most values fit in a single
+	byte rather than eight.
+ */
+void WaveformCompressor::CompressInt64s(const int64_t* din, size_t count, vector<uint8_t>& out)
+{
+	out.clear();
+	out.reserve(count);
+
+	int64_t prev = 0;
+	for(size_t i = 0; i < count; i ++)
+	{
+		int64_t delta = din[i] - prev;
+		prev = din[i];
+
+		//Zigzag map so small negative deltas stay small
+		uint64_t u = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+
+		while(u >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(u) | 0x80);
+			u >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(u));
+	}
+}
+
+void WaveformCompressor::DecompressInt64s(const vector<uint8_t>& din, size_t count, int64_t* dout)
+{
+	size_t pos = 0;
+	int64_t prev = 0;
+	for(size_t i = 0; i < count; i ++)
+	{
+		uint64_t u = 0;
+		int shift = 0;
+		while(pos < din.size())
+		{
+			uint8_t b = din[pos ++];
+			u |= static_cast<uint64_t>(b & 0x7f) << shift;
+			shift += 7;
+			if(!(b & 0x80))
+				break;
+		}
+
+		int64_t delta = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+		prev += delta;
+		dout[i] = prev;
+	}
+}
+
+/**
+	@brief Compresses an array of bools by bit packing plus run length coding
+ */
+void WaveformCompressor::CompressBools(const bool* din, size_t count, vector<uint8_t>& out)
+{
+	out.clear();
+
+	vector<uint8_t> packed;
+	packed.resize( (count + 7) / 8, 0);
+	for(size_t i = 0; i < count; i ++)
+	{
+		if(din[i])
+			packed[i/8] |= (1 << (i & 7));
+	}
+	RunLengthEncode(packed.data(), packed.size(), out);
+}
+
+void WaveformCompressor::DecompressBools(const vector<uint8_t>& din, size_t count, bool* dout)
+{
+	vector<uint8_t> packed;
+	packed.resize( (count + 7) / 8);
+	RunLengthDecode(din.data(), din.size(), packed.data(), packed.size());
+
+	for(size_t i = 0; i < count; i ++)
+		dout[i] = (packed[i/8] >> (i & 7)) & 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Run length coding primitives
+
+/**
+	@brief Run length encodes a byte stream (PackBits format) and appends the result to the output
+
+	Control byte c <= 127 means c+1 literal bytes follow; c >= 129 means the next byte repeats
+	257-c times; 128 is unused.
+ */
+void WaveformCompressor::RunLengthEncode(const uint8_t* din, size_t count, vector<uint8_t>& out)
+{
+	size_t i = 0;
+	while(i < count)
+	{
+		//Measure the run of identical bytes starting here (max 128 per control byte)
+		size_t run = 1;
+		while( (run < 128) && (i + run < count) && (din[i + run] == din[i]) )
+			run ++;
+
+		//Long enough run: emit a repeat
+		if(run >= 3)
+		{
+			out.push_back(static_cast<uint8_t>(257 - run));
+			out.push_back(din[i]);
+			i += run;
+		}
+
+		//Short run: accumulate literals until the next compressible run starts
+		else
+		{
+			size_t start = i;
+			size_t len = 0;
+			while( (len < 128) && (i < count) )
+			{
+				if( (i + 2 < count) && (din[i] == din[i+1]) && (din[i] == din[i+2]) )
+					break;
+				i ++;
+				len ++;
+			}
+			out.push_back(static_cast<uint8_t>(len - 1));
+			out.insert(out.end(), din + start, din + start + len);
+		}
+	}
+}
+
+/**
+	@brief Decodes a run length encoded byte stream
+
+	Stops after producing outlen bytes of output.
+
+	@return Number of input bytes consumed
+ */
+size_t WaveformCompressor::RunLengthDecode(const uint8_t* din, size_t inlen, uint8_t* dout, size_t outlen)
+{
+	size_t pos = 0;
+	size_t written = 0;
+	while( (written < outlen) && (pos < inlen) )
+	{
+		uint8_t c = din[pos ++];
+
+		//Literal run
+		if(c <= 127)
+		{
+			size_t len = min<size_t>(c + 1, outlen - written);
+			memcpy(dout + written, din + pos, len);
+			pos += c + 1;
+			written += len;
+		}
+
+		//Repeat run
+		else if(c >= 129)
+		{
+			size_t len = min<size_t>(257 - c, outlen - written);
+			memset(dout + written, din[pos ++], len);
+			written += len;
+		}
+	}
+
+	return pos;
+}
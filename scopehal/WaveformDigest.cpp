@@ -0,0 +1,334 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformDigest
+	@ingroup core
+ */
+#include "scopehal.h"
+#include "WaveformDigest.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hash primitives
+
+///@brief Murmur3 finalizer: full-avalanche 32-bit mix (must match the shader's Mix32)
+static uint32_t Mix32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6b;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35;
+	x ^= x >> 16;
+	return x;
+}
+
+///@brief Hashes a byte sequence with the same position-mixed additive scheme as the word hash
+static uint64_t HashBytesCpu(const uint8_t* data, size_t n)
+{
+	uint32_t lane1 = 0;
+	uint32_t lane2 = 0;
+	for(size_t i=0; i<n; i++)
+	{
+		uint32_t k = Mix32(data[i] ^ Mix32((uint32_t)i + 1));
+		lane1 += k;
+		lane2 += Mix32(k ^ 0x9e3779b9);
+	}
+	return ( ((uint64_t)lane1) << 32) | lane2;
+}
+
+/**
+	@brief Hashes a sequence of 32-bit words
+
+	Must produce identical results to the WaveformDigest shader: each word's hash is position dependent,
+	but the accumulator lanes combine by addition, so the loop can run in any order (and thus in parallel).
+
+	@param data			The words to hash
+	@param nwords		Number of words
+	@param quantize		True to reinterpret each word as a float and quantize it before hashing
+	@param tolerance	Quantization step size
+
+	@return 64-bit digest of the sequence
+ */
+uint64_t WaveformDigest::HashWordsCpu(const uint32_t* data, size_t nwords, bool quantize, float tolerance)
+{
+	uint32_t lane1 = 0;
+	uint32_t lane2 = 0;
+
+	#pragma omp parallel for reduction(+:lane1, lane2)
+	for(int64_t i=0; i<(int64_t)nwords; i++)
+	{
+		uint32_t q = data[i];
+		if(quantize)
+		{
+			float v;
+			memcpy(&v, &q, sizeof(v));
+			q = (uint32_t)(int32_t)floorf(v / tolerance + 0.5f);
+		}
+
+		uint32_t k = Mix32(q ^ Mix32((uint32_t)i + 1));
+		lane1 += k;
+		lane2 += Mix32(k ^ 0x9e3779b9);
+	}
+
+	return ( ((uint64_t)lane1) << 32) | lane2;
+}
+
+///@brief Folds one digest into another (order dependent)
+uint64_t WaveformDigest::CombineDigests(uint64_t h, uint64_t k)
+{
+	h ^= k + 0x9e3779b97f4a7c15UL + (h << 6) + (h >> 2);
+	return h;
+}
+
+///@brief Hashes the sample count and timebase configuration of a waveform
+uint64_t WaveformDigest::HashMetadata(WaveformBase* wfm)
+{
+	uint64_t h = 0xcbf29ce484222325UL;	//FNV-1a offset basis, as an arbitrary nonzero seed
+	h = CombineDigests(h, wfm->size());
+	h = CombineDigests(h, (uint64_t)wfm->m_timescale);
+	h = CombineDigests(h, (uint64_t)wfm->m_triggerPhase);
+	return h;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformDigest::WaveformDigest()
+	: m_pipeline("shaders/WaveformDigest.spv", 2, sizeof(WaveformDigestArgs))
+{
+	m_partials.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_partials.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GPU path
+
+/**
+	@brief Hashes the contents of an AcceleratorBuffer on the GPU, as a sequence of 32-bit words
+
+	The buffer is used wherever it currently lives; sample data is never downloaded, only the
+	per-workgroup partials (a few kB at most).
+
+	@param buf			The buffer to hash (element size must be a multiple of 4 bytes)
+	@param quantize		True to quantize each word as a float before hashing
+	@param tolerance	Quantization step size
+	@param cmdBuf		Command buffer for GPU work (must not be in the recording state)
+	@param queue		Queue to submit GPU work to
+
+	@return 64-bit digest, bit-identical to HashWordsCpu over the same words
+ */
+template<class T>
+uint64_t WaveformDigest::HashBufferGpu(
+	AcceleratorBuffer<T>& buf,
+	bool quantize,
+	float tolerance,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	size_t nwords = buf.size() * sizeof(T) / sizeof(uint32_t);
+	if(nwords == 0)
+		return 0;
+
+	//One partial per workgroup; don't launch more workgroups than there are full thread blocks of input
+	size_t nblocks = min(MAX_BLOCKS, (size_t)GetComputeBlockCount(nwords, THREADS_PER_BLOCK));
+	m_partials.resize(2 * nblocks);
+
+	cmdBuf.begin({});
+	WaveformDigestArgs args;
+	args.nwords = nwords;
+	args.quantize = quantize ? 1 : 0;
+	args.tolerance = tolerance;
+	m_pipeline.BindBufferNonblocking(0, buf, cmdBuf);
+	m_pipeline.BindBufferNonblocking(1, m_partials, cmdBuf, true);
+	m_pipeline.Dispatch(cmdBuf, args, nblocks);
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	m_partials.MarkModifiedFromGpu();
+
+	//Combine the per-workgroup partials
+	m_partials.PrepareForCpuAccess();
+	uint32_t lane1 = 0;
+	uint32_t lane2 = 0;
+	for(size_t i=0; i<nblocks; i++)
+	{
+		lane1 += m_partials[i*2 + 0];
+		lane2 += m_partials[i*2 + 1];
+	}
+	return ( ((uint64_t)lane1) << 32) | lane2;
+}
+
+/**
+	@brief Computes the content digest of a waveform, using the GPU where the data format allows
+
+	Analog waveforms (the bulk of any large regression corpus) are hashed entirely on the GPU, so the
+	sample data never crosses the PCIe bus. Digital and protocol waveforms delegate to the CPU path;
+	they are small by comparison and their sample types don't map cleanly onto 32-bit words.
+
+	@param wfm			The waveform to digest
+	@param cmdBuf		Command buffer for GPU work (must not be in the recording state)
+	@param queue		Queue to submit GPU work to
+	@param tolerance	Quantization step for analog sample values: captures differing only by noise
+						below this threshold digest identically. Zero hashes exact bit patterns.
+
+	@return 64-bit digest, identical to what ComputeDigestCpu produces for the same waveform
+ */
+uint64_t WaveformDigest::ComputeDigest(
+	WaveformBase* wfm,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	float tolerance)
+{
+	//Small waveforms aren't worth a GPU round trip
+	const size_t minGpuSamples = 32768;
+
+	auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	if(ua && (ua->size() >= minGpuSamples) )
+	{
+		uint64_t h = HashMetadata(wfm);
+		return CombineDigests(h, HashBufferGpu(ua->m_samples, tolerance > 0, tolerance, cmdBuf, queue));
+	}
+
+	auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	if(sa && (sa->size() >= minGpuSamples) )
+	{
+		uint64_t h = HashMetadata(wfm);
+		h = CombineDigests(h, HashBufferGpu(sa->m_samples, tolerance > 0, tolerance, cmdBuf, queue));
+		h = CombineDigests(h, HashBufferGpu(sa->m_offsets, false, 0, cmdBuf, queue));
+		h = CombineDigests(h, HashBufferGpu(sa->m_durations, false, 0, cmdBuf, queue));
+		return h;
+	}
+
+	return ComputeDigestCpu(wfm, tolerance);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPU path
+
+/**
+	@brief Computes the content digest of a waveform on the CPU
+
+	Bit-identical to ComputeDigest() for any waveform, so digests recorded on a machine without a GPU
+	context (or in unit tests) compare cleanly against GPU-computed ones.
+
+	@param wfm			The waveform to digest
+	@param tolerance	Quantization step for analog sample values (see ComputeDigest)
+
+	@return 64-bit digest
+ */
+uint64_t WaveformDigest::ComputeDigestCpu(WaveformBase* wfm, float tolerance)
+{
+	uint64_t h = HashMetadata(wfm);
+
+	if(auto ua = dynamic_cast<UniformAnalogWaveform*>(wfm))
+	{
+		ua->PrepareForCpuAccess();
+		return CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(ua->m_samples.GetCpuPointer()),
+			ua->size(), tolerance > 0, tolerance));
+	}
+
+	if(auto sa = dynamic_cast<SparseAnalogWaveform*>(wfm))
+	{
+		sa->PrepareForCpuAccess();
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sa->m_samples.GetCpuPointer()),
+			sa->size(), tolerance > 0, tolerance));
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sa->m_offsets.GetCpuPointer()),
+			sa->size() * 2, false, 0));
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sa->m_durations.GetCpuPointer()),
+			sa->size() * 2, false, 0));
+		return h;
+	}
+
+	if(auto ud = dynamic_cast<UniformDigitalWaveform*>(wfm))
+	{
+		ud->PrepareForCpuAccess();
+		return CombineDigests(h, HashBytesCpu(
+			reinterpret_cast<const uint8_t*>(ud->m_samples.GetCpuPointer()), ud->size()));
+	}
+
+	if(auto sd = dynamic_cast<SparseDigitalWaveform*>(wfm))
+	{
+		sd->PrepareForCpuAccess();
+		h = CombineDigests(h, HashBytesCpu(
+			reinterpret_cast<const uint8_t*>(sd->m_samples.GetCpuPointer()), sd->size()));
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sd->m_offsets.GetCpuPointer()),
+			sd->size() * 2, false, 0));
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sd->m_durations.GetCpuPointer()),
+			sd->size() * 2, false, 0));
+		return h;
+	}
+
+	//Arbitrary sample types (protocol decodes etc): hash the rendered text of each sample.
+	//Much slower than the binary paths, but protocol waveforms are tiny next to the analog data,
+	//and the text is exactly what a regression suite would otherwise export and diff.
+	wfm->PrepareForCpuAccess();
+	for(size_t i=0; i<wfm->size(); i++)
+	{
+		auto text = wfm->GetText(i);
+		h = CombineDigests(h, HashBytesCpu(
+			reinterpret_cast<const uint8_t*>(text.c_str()), text.length()));
+	}
+	if(auto sb = dynamic_cast<SparseWaveformBase*>(wfm))
+	{
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sb->m_offsets.GetCpuPointer()),
+			sb->size() * 2, false, 0));
+		h = CombineDigests(h, HashWordsCpu(
+			reinterpret_cast<const uint32_t*>(sb->m_durations.GetCpuPointer()),
+			sb->size() * 2, false, 0));
+	}
+	return h;
+}
+
+/**
+	@brief Checks two waveforms for equal content (within an analog tolerance) by comparing digests
+
+	Null waveforms compare equal to each other and unequal to anything else.
+
+	@param a			First waveform
+	@param b			Second waveform
+	@param tolerance	Quantization step for analog sample values (see ComputeDigest)
+
+	@return True if the digests match
+ */
+bool WaveformDigest::CompareWaveforms(WaveformBase* a, WaveformBase* b, float tolerance)
+{
+	if( (a == nullptr) || (b == nullptr) )
+		return (a == b);
+	return ComputeDigestCpu(a, tolerance) == ComputeDigestCpu(b, tolerance);
+}
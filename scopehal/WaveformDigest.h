@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformDigest
+	@ingroup core
+ */
+#ifndef WaveformDigest_h
+#define WaveformDigest_h
+
+#include "AcceleratorBuffer.h"
+#include "ComputePipeline.h"
+
+class QueueHandle;
+class WaveformBase;
+
+/**
+	@brief Arguments to the waveform digest shader
+	@ingroup core
+ */
+struct WaveformDigestArgs
+{
+	///@brief Number of input words
+	uint32_t nwords;
+
+	///@brief Nonzero to quantize input words as floats before hashing, zero to hash raw bits
+	uint32_t quantize;
+
+	///@brief Quantization step size (only meaningful if quantize is set)
+	float tolerance;
+};
+
+/**
+	@brief Fast content digest over waveform sample data, for regression comparison
+	@ingroup core
+
+	Produces a 64-bit digest of a waveform's samples (plus timebase configuration and, for sparse
+	waveforms, the offset/duration arrays) so that large outputs can be compared against goldens, or
+	against each other, without exporting and diffing the raw data.
+
+	Analog sample values can be quantized to a caller-supplied tolerance before hashing, so two captures
+	that differ only by float rounding noise below the tolerance produce the same digest. With zero
+	tolerance the raw bit patterns are hashed.
+
+	The per-word hash is position dependent but the words combine by addition, so the digest can be
+	computed in parallel in any order: the GPU path (ComputeDigest) reduces per-workgroup partials
+	without ever downloading the sample data, while the static CPU path (ComputeDigestCpu) produces
+	bit-identical results for use where no GPU context is available. Protocol waveforms fall back to
+	hashing the rendered text of each sample on the CPU.
+
+	A digest says nothing about *where* two waveforms differ; it is a cheap equality test, not a diff.
+ */
+class WaveformDigest
+{
+public:
+	WaveformDigest();
+
+	uint64_t ComputeDigest(
+		WaveformBase* wfm,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		float tolerance = 0);
+
+	static uint64_t ComputeDigestCpu(WaveformBase* wfm, float tolerance = 0);
+
+	static bool CompareWaveforms(WaveformBase* a, WaveformBase* b, float tolerance = 0);
+
+protected:
+	static uint64_t HashWordsCpu(const uint32_t* data, size_t nwords, bool quantize, float tolerance);
+	static uint64_t HashMetadata(WaveformBase* wfm);
+	static uint64_t CombineDigests(uint64_t h, uint64_t k);
+
+	template<class T>
+	uint64_t HashBufferGpu(
+		AcceleratorBuffer<T>& buf,
+		bool quantize,
+		float tolerance,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue);
+
+	///@brief Number of threads per workgroup (must match the shader's local_size_x)
+	static const size_t THREADS_PER_BLOCK = 256;
+
+	///@brief Maximum number of workgroups (and thus partials combined on the CPU)
+	static const size_t MAX_BLOCKS = 1024;
+
+	ComputePipeline m_pipeline;
+
+	///@brief Per-workgroup partial accumulators (two lanes each)
+	AcceleratorBuffer<uint32_t> m_partials;
+};
+
+#endif
@@ -0,0 +1,681 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of WaveformHistoryStore
+	@ingroup datamodel
+ */
+#include "scopehal.h"
+#include "WaveformHistoryStore.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+///@brief On-disk layout of a spilled waveform (followed by the three compressed arrays)
+struct SpillBlobHeader
+{
+	uint32_t kind;
+	uint32_t flags;
+	uint64_t sampleCount;
+	int64_t timescale;
+	int64_t startTimestamp;
+	int64_t startFemtoseconds;
+	int64_t triggerPhase;
+	uint64_t revision;
+	uint64_t samplesLen;
+	uint64_t offsetsLen;
+	uint64_t durationsLen;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+WaveformHistoryStore::WaveformHistoryStore()
+	: m_ramUsage(0)
+	, m_ramBudget(1024UL * 1024UL * 1024UL)		//1 GB of compressed history in RAM by default
+	, m_spillFile(nullptr)
+	, m_spillSize(0)
+	, m_mapping(nullptr)
+	, m_mapLen(0)
+	, m_hydratedBytes(0)
+	, m_prefetchRadius(0)
+	, m_prefetchPending(false)
+	, m_prefetchExit(false)
+{
+	MemoryPressureManager::GetInstance().Register(this);
+}
+
+WaveformHistoryStore::~WaveformHistoryStore()
+{
+	MemoryPressureManager::GetInstance().Unregister(this);
+
+	//Shut down the prefetch worker before anything it might touch goes away
+	if(m_prefetchThread)
+	{
+		{
+			lock_guard<mutex> lock(m_cacheMutex);
+			m_prefetchExit = true;
+		}
+		m_prefetchWake.notify_all();
+		m_prefetchThread->join();
+	}
+
+	CloseSpillFile();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Insertion and eviction
+
+/**
+	@brief Adds one waveform of an acquisition to the history.
+
+	The waveform is compressed immediately; the caller keeps ownership of the live object. If the RAM budget
+	is exceeded afterwards, the oldest acquisitions spill to the backing file.
+
+	@param when		Trigger timestamp of the acquisition
+	@param stream	Name identifying the source stream (e.g. instrument nickname plus channel name)
+	@param wfm		The waveform to store
+ */
+void WaveformHistoryStore::Add(TimePoint when, const string& stream, WaveformBase* wfm)
+{
+	auto cwfm = WaveformCompressor::Compress(wfm);
+	if(!cwfm)
+		return;
+
+	lock_guard<mutex> lock(m_mutex);
+
+	m_ramUsage += cwfm->GetCompressedSize();
+	auto& sw = m_entries[when][stream];
+	sw.m_resident = std::move(cwfm);
+	sw.m_spillOffset = 0;
+	sw.m_spillLength = 0;
+
+	while(m_ramUsage > m_ramBudget)
+	{
+		size_t before = m_ramUsage;
+		SpillOldest();
+		if(m_ramUsage == before)
+			break;
+	}
+}
+
+/**
+	@brief Spills all resident waveforms of the oldest acquisition that still has any
+ */
+void WaveformHistoryStore::SpillOldest()
+{
+	for(auto& it : m_entries)
+	{
+		bool any = false;
+		for(auto& jt : it.second)
+		{
+			if(jt.second.m_resident)
+				any |= SpillWaveform(jt.second);
+		}
+		if(any)
+			return;
+	}
+}
+
+/**
+	@brief Serializes one resident waveform to the spill file and frees the RAM copy
+
+	@param sw	The waveform to spill
+
+	@return True on success, false if the blob stays resident (e.g. the spill file could not be created)
+ */
+bool WaveformHistoryStore::SpillWaveform(StoredWaveform& sw)
+{
+	//Create the spill file the first time we need it
+	if(!m_spillFile)
+	{
+		if(m_spillPath.empty())
+		{
+			const char* tmpdir = getenv("TMPDIR");
+			#ifdef _WIN32
+			if(!tmpdir)
+				tmpdir = getenv("TEMP");
+			#endif
+			if(!tmpdir)
+				tmpdir = "/tmp";
+			m_spillPath = string(tmpdir) + "/scopehal-history-" + to_string(getpid()) + ".tmp";
+		}
+		m_spillFile = fopen(m_spillPath.c_str(), "w+b");
+		if(!m_spillFile)
+		{
+			LogError("Couldn't create history spill file \"%s\"\n", m_spillPath.c_str());
+			return false;
+		}
+	}
+
+	auto& cwfm = *sw.m_resident;
+	SpillBlobHeader header;
+	header.kind = cwfm.m_kind;
+	header.flags = cwfm.m_flags;
+	header.sampleCount = cwfm.m_sampleCount;
+	header.timescale = cwfm.m_timescale;
+	header.startTimestamp = cwfm.m_startTimestamp;
+	header.startFemtoseconds = cwfm.m_startFemtoseconds;
+	header.triggerPhase = cwfm.m_triggerPhase;
+	header.revision = cwfm.m_revision;
+	header.samplesLen = cwfm.m_samples.size();
+	header.offsetsLen = cwfm.m_offsets.size();
+	header.durationsLen = cwfm.m_durations.size();
+
+	fseek(m_spillFile, 0, SEEK_END);
+	if(fwrite(&header, sizeof(header), 1, m_spillFile) != 1)
+		return false;
+	if(header.samplesLen && (fwrite(&cwfm.m_samples[0], 1, header.samplesLen, m_spillFile) != header.samplesLen) )
+		return false;
+	if(header.offsetsLen && (fwrite(&cwfm.m_offsets[0], 1, header.offsetsLen, m_spillFile) != header.offsetsLen) )
+		return false;
+	if(header.durationsLen && (fwrite(&cwfm.m_durations[0], 1, header.durationsLen, m_spillFile) != header.durationsLen) )
+		return false;
+
+	sw.m_spillOffset = m_spillSize;
+	sw.m_spillLength = sizeof(header) + header.samplesLen + header.offsetsLen + header.durationsLen;
+	m_spillSize += sw.m_spillLength;
+
+	m_ramUsage -= cwfm.GetCompressedSize();
+	sw.m_resident.reset();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lookup and hydration
+
+/**
+	@brief Finds the acquisition whose trigger timestamp is nearest the target
+
+	@param target	Timestamp to seek to
+	@param found	Output: timestamp of the nearest stored acquisition
+
+	@return True if the store is nonempty
+ */
+bool WaveformHistoryStore::FindNearest(TimePoint target, TimePoint& found)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_entries.empty())
+		return false;
+
+	auto it = m_entries.lower_bound(target);
+	if(it == m_entries.begin())
+		found = it->first;
+	else if(it == m_entries.end())
+		found = prev(it)->first;
+	else
+	{
+		//Compare distance to the entries on both sides of the target
+		auto jt = prev(it);
+		double dAfter = (it->first.m_sec - target.m_sec) + (it->first.m_fs - target.m_fs) * SECONDS_PER_FS;
+		double dBefore = (target.m_sec - jt->first.m_sec) + (target.m_fs - jt->first.m_fs) * SECONDS_PER_FS;
+		if(dBefore <= dAfter)
+			found = jt->first;
+		else
+			found = it->first;
+	}
+	return true;
+}
+
+/**
+	@brief Returns the names of all streams stored for an acquisition
+
+	@param when	Trigger timestamp of the acquisition
+ */
+vector<string> WaveformHistoryStore::GetStreams(TimePoint when)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	vector<string> ret;
+	auto it = m_entries.find(when);
+	if(it != m_entries.end())
+	{
+		for(auto& jt : it->second)
+			ret.push_back(jt.first);
+	}
+	return ret;
+}
+
+/**
+	@brief Materializes one stored waveform as a live object.
+
+	Resident waveforms are decompressed directly; spilled ones are read back from the mapping first.
+	The caller owns the returned waveform.
+
+	@param when		Trigger timestamp of the acquisition
+	@param stream	Name of the stream, as passed to Add()
+
+	@return The hydrated waveform, or null if not found
+ */
+WaveformBase* WaveformHistoryStore::Hydrate(TimePoint when, const string& stream)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	auto it = m_entries.find(when);
+	if(it == m_entries.end())
+		return nullptr;
+	auto jt = it->second.find(stream);
+	if(jt == it->second.end())
+		return nullptr;
+
+	if(jt->second.m_resident)
+		return WaveformCompressor::Decompress(*jt->second.m_resident);
+
+	auto cwfm = LoadSpilled(jt->second);
+	if(!cwfm)
+		return nullptr;
+	return WaveformCompressor::Decompress(*cwfm);
+}
+
+/**
+	@brief Reads a spilled waveform's blob back into a CompressedWaveform
+
+	@param sw	The spilled waveform
+
+	@return The deserialized blob, or null on I/O failure
+ */
+unique_ptr<CompressedWaveform> WaveformHistoryStore::LoadSpilled(const StoredWaveform& sw)
+{
+	vector<uint8_t> blob(sw.m_spillLength);
+
+#ifndef _WIN32
+	//Fast path: copy out of the mapping (remapping if the file has grown past it)
+	if( (sw.m_spillOffset + sw.m_spillLength > m_mapLen) && !RemapSpillFile() )
+		return nullptr;
+	memcpy(&blob[0], reinterpret_cast<uint8_t*>(m_mapping) + sw.m_spillOffset, sw.m_spillLength);
+#else
+	//No mmap on this platform, use buffered reads
+	fflush(m_spillFile);
+	fseek(m_spillFile, sw.m_spillOffset, SEEK_SET);
+	if(fread(&blob[0], 1, sw.m_spillLength, m_spillFile) != sw.m_spillLength)
+		return nullptr;
+	fseek(m_spillFile, 0, SEEK_END);
+#endif
+
+	if(blob.size() < sizeof(SpillBlobHeader))
+		return nullptr;
+	SpillBlobHeader header;
+	memcpy(&header, &blob[0], sizeof(header));
+	if(blob.size() != sizeof(header) + header.samplesLen + header.offsetsLen + header.durationsLen)
+		return nullptr;
+
+	auto cwfm = make_unique<CompressedWaveform>();
+	cwfm->m_kind = static_cast<CompressedWaveform::WaveformKind>(header.kind);
+	cwfm->m_flags = header.flags;
+	cwfm->m_sampleCount = header.sampleCount;
+	cwfm->m_timescale = header.timescale;
+	cwfm->m_startTimestamp = header.startTimestamp;
+	cwfm->m_startFemtoseconds = header.startFemtoseconds;
+	cwfm->m_triggerPhase = header.triggerPhase;
+	cwfm->m_revision = header.revision;
+
+	const uint8_t* p = &blob[sizeof(header)];
+	cwfm->m_samples.assign(p, p + header.samplesLen);
+	p += header.samplesLen;
+	cwfm->m_offsets.assign(p, p + header.offsetsLen);
+	p += header.offsetsLen;
+	cwfm->m_durations.assign(p, p + header.durationsLen);
+
+	return cwfm;
+}
+
+/**
+	@brief Extends the read-only mapping to cover the current size of the spill file
+ */
+bool WaveformHistoryStore::RemapSpillFile()
+{
+#ifndef _WIN32
+	if(m_mapping)
+	{
+		munmap(m_mapping, m_mapLen);
+		m_mapping = nullptr;
+		m_mapLen = 0;
+	}
+
+	fflush(m_spillFile);
+	void* mapping = mmap(nullptr, m_spillSize, PROT_READ, MAP_PRIVATE, fileno(m_spillFile), 0);
+	if(mapping == MAP_FAILED)
+	{
+		LogError("Couldn't map history spill file \"%s\"\n", m_spillPath.c_str());
+		return false;
+	}
+	m_mapping = mapping;
+	m_mapLen = m_spillSize;
+	return true;
+#else
+	return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Prefetch and hydrated cache
+
+/**
+	@brief Like Hydrate(), but serves from (and fills) the hydrated cache.
+
+	If the waveform was prefetched, this returns the already-decompressed, GPU-warm copy immediately; otherwise
+	it hydrates on the spot and caches the result so a repeat visit is free. Use this from interactive paths and
+	pair it with Prefetch() on the same acquisition so the neighbors are warm by the time the user scrubs to them.
+
+	@param when		Trigger timestamp of the acquisition
+	@param stream	Name of the stream, as passed to Add()
+
+	@return The hydrated waveform, or null if not found
+ */
+shared_ptr<WaveformBase> WaveformHistoryStore::HydrateCached(TimePoint when, const string& stream)
+{
+	//Fast path: already warm
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_hydrated.find(when);
+		if(it != m_hydrated.end())
+		{
+			auto jt = it->second.find(stream);
+			if(jt != it->second.end())
+			{
+				MemoryPressureManager::GetInstance().Touch(this);
+				return jt->second;
+			}
+		}
+	}
+
+	//Miss: hydrate now (without holding the cache lock, decompression can be slow)
+	shared_ptr<WaveformBase> wfm(Hydrate(when, stream));
+	if(!wfm)
+		return nullptr;
+
+	lock_guard<mutex> lock(m_cacheMutex);
+	auto& slot = m_hydrated[when][stream];
+
+	//The prefetcher might have beaten us to it; prefer its copy (which is already uploaded)
+	if(!slot)
+	{
+		slot = wfm;
+		m_hydratedBytes += EstimateHydratedSize(wfm.get());
+	}
+	MemoryPressureManager::GetInstance().Touch(this);
+	return slot;
+}
+
+/**
+	@brief Requests background warming of the acquisitions around the one being viewed.
+
+	Returns immediately; a worker thread hydrates the center acquisition plus up to radius neighbors on each
+	side and pushes their sample data to the GPU, so scrubbing to an adjacent entry doesn't stall on
+	decompression or upload. Each call supersedes the previous one (only the latest scrub position matters),
+	and warm entries that fall outside the new window are dropped.
+
+	@param center	Trigger timestamp of the currently viewed acquisition
+	@param radius	Number of acquisitions to warm on each side of the center
+ */
+void WaveformHistoryStore::Prefetch(TimePoint center, size_t radius)
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+
+	//Start the worker the first time anybody asks for a prefetch
+	if(!m_prefetchThread)
+		m_prefetchThread = make_unique<thread>(&WaveformHistoryStore::PrefetchWorker, this);
+
+	m_prefetchTarget = center;
+	m_prefetchRadius = radius;
+	m_prefetchPending = true;
+	m_prefetchWake.notify_one();
+}
+
+/**
+	@brief Background loop servicing Prefetch() requests.
+
+	Hydration and GPU upload happen here, off the UI thread. A newer request aborts the current pass between
+	waveforms so rapid scrubbing always chases the latest position rather than draining a backlog.
+ */
+void WaveformHistoryStore::PrefetchWorker()
+{
+	unique_lock<mutex> lock(m_cacheMutex);
+	while(true)
+	{
+		m_prefetchWake.wait(lock, [this]{ return m_prefetchPending || m_prefetchExit; });
+		if(m_prefetchExit)
+			return;
+
+		TimePoint center = m_prefetchTarget;
+		size_t radius = m_prefetchRadius;
+		m_prefetchPending = false;
+		lock.unlock();
+
+		//Figure out which acquisitions are in the window, nearest first
+		vector<TimePoint> window;
+		{
+			lock_guard<mutex> elock(m_mutex);
+			auto it = m_entries.find(center);
+			if(it != m_entries.end())
+			{
+				window.push_back(it->first);
+				auto fwd = next(it);
+				auto back = it;
+				for(size_t i=0; i<radius; i++)
+				{
+					if(fwd != m_entries.end())
+					{
+						window.push_back(fwd->first);
+						++fwd;
+					}
+					if(back != m_entries.begin())
+					{
+						--back;
+						window.push_back(back->first);
+					}
+				}
+			}
+		}
+
+		//Warm anything in the window that isn't already
+		bool superseded = false;
+		for(auto& when : window)
+		{
+			for(auto& stream : GetStreams(when))
+			{
+				{
+					lock_guard<mutex> clock(m_cacheMutex);
+					if(m_prefetchPending || m_prefetchExit)
+					{
+						superseded = true;
+						break;
+					}
+					auto it = m_hydrated.find(when);
+					if( (it != m_hydrated.end()) && (it->second.find(stream) != it->second.end()) )
+						continue;
+				}
+
+				shared_ptr<WaveformBase> wfm(Hydrate(when, stream));
+				if(!wfm)
+					continue;
+
+				//Push the sample data to the GPU now, so the first render of this entry doesn't have to
+				wfm->PrepareForGpuAccess();
+
+				lock_guard<mutex> clock(m_cacheMutex);
+				auto& slot = m_hydrated[when][stream];
+				if(!slot)
+				{
+					slot = wfm;
+					m_hydratedBytes += EstimateHydratedSize(wfm.get());
+				}
+			}
+			if(superseded)
+				break;
+		}
+
+		lock.lock();
+		if(superseded)
+			continue;
+
+		//Drop warm entries that fell out of the window as the user scrubbed away from them
+		set<TimePoint> keep(window.begin(), window.end());
+		for(auto it = m_hydrated.begin(); it != m_hydrated.end(); )
+		{
+			if(keep.find(it->first) == keep.end())
+			{
+				for(auto& jt : it->second)
+					m_hydratedBytes -= min(m_hydratedBytes, EstimateHydratedSize(jt.second.get()));
+				it = m_hydrated.erase(it);
+			}
+			else
+				++it;
+		}
+
+		MemoryPressureManager::GetInstance().Touch(this);
+	}
+}
+
+/**
+	@brief Estimates the in-memory size of a hydrated waveform's sample data
+
+	@param wfm	The waveform to size
+ */
+size_t WaveformHistoryStore::EstimateHydratedSize(WaveformBase* wfm)
+{
+	size_t n = wfm->size();
+	size_t bytes = 0;
+	if(dynamic_cast<SparseWaveformBase*>(wfm) != nullptr)
+		bytes += n * 2 * sizeof(int64_t);		//offsets and durations
+	if( (dynamic_cast<UniformAnalogWaveform*>(wfm) != nullptr) || (dynamic_cast<SparseAnalogWaveform*>(wfm) != nullptr) )
+		bytes += n * sizeof(float);
+	else
+		bytes += n * sizeof(bool);
+	return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Memory pressure handling
+
+///@brief Returns the estimated GPU memory used by warm prefetched waveforms
+size_t WaveformHistoryStore::GetDeviceMemoryUse()
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+	return m_hydratedBytes;
+}
+
+///@brief Returns the compressed size of all resident (non spilled) waveforms
+size_t WaveformHistoryStore::GetHostMemoryUse()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_ramUsage;
+}
+
+/**
+	@brief Drops the hydrated cache, freeing both GPU copies and the decompressed host copies backing them.
+
+	Waveforms currently checked out via HydrateCached() stay alive through their shared_ptr; only the cache's
+	references are released. Everything remains recoverable from the compressed store.
+ */
+size_t WaveformHistoryStore::EvictDeviceMemory()
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+	size_t freed = m_hydratedBytes;
+	m_hydrated.clear();
+	m_hydratedBytes = 0;
+	return freed;
+}
+
+/**
+	@brief Spills roughly half of the resident compressed waveforms to disk, oldest first.
+ */
+size_t WaveformHistoryStore::SpillHostMemory()
+{
+	lock_guard<mutex> lock(m_mutex);
+	size_t before = m_ramUsage;
+	size_t target = before / 2;
+	while(m_ramUsage > target)
+	{
+		size_t prev = m_ramUsage;
+		SpillOldest();
+		if(m_ramUsage == prev)
+			break;
+	}
+	return before - m_ramUsage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Housekeeping
+
+/**
+	@brief Removes all stored acquisitions and deletes the spill file
+ */
+void WaveformHistoryStore::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	m_entries.clear();
+	m_ramUsage = 0;
+	CloseSpillFile();
+
+	lock_guard<mutex> clock(m_cacheMutex);
+	m_hydrated.clear();
+	m_hydratedBytes = 0;
+}
+
+void WaveformHistoryStore::CloseSpillFile()
+{
+#ifndef _WIN32
+	if(m_mapping)
+	{
+		munmap(m_mapping, m_mapLen);
+		m_mapping = nullptr;
+		m_mapLen = 0;
+	}
+#endif
+
+	if(m_spillFile)
+	{
+		fclose(m_spillFile);
+		m_spillFile = nullptr;
+		remove(m_spillPath.c_str());
+	}
+	m_spillSize = 0;
+}
+
+///@brief Returns the number of stored acquisitions
+size_t WaveformHistoryStore::GetEntryCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+///@brief Returns the total compressed size of all resident (non spilled) waveforms
+size_t WaveformHistoryStore::GetRamUsage()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_ramUsage;
+}
@@ -0,0 +1,224 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of WaveformHistoryStore
+	@ingroup datamodel
+ */
+#ifndef WaveformHistoryStore_h
+#define WaveformHistoryStore_h
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "WaveformCompressor.h"
+#include "MemoryPressureManager.h"
+
+/**
+	@brief Timestamp of a single acquisition, with femtosecond resolution
+	@ingroup datamodel
+ */
+class TimePoint
+{
+public:
+	TimePoint(time_t sec = 0, int64_t fs = 0)
+		: m_sec(sec)
+		, m_fs(fs)
+	{}
+
+	///@brief Integer seconds since the epoch
+	time_t m_sec;
+
+	///@brief Femtoseconds since the UTC second
+	int64_t m_fs;
+
+	bool operator<(const TimePoint& rhs) const
+	{
+		if(m_sec != rhs.m_sec)
+			return m_sec < rhs.m_sec;
+		return m_fs < rhs.m_fs;
+	}
+
+	bool operator==(const TimePoint& rhs) const
+	{ return (m_sec == rhs.m_sec) && (m_fs == rhs.m_fs); }
+
+	bool operator!=(const TimePoint& rhs) const
+	{ return !(*this == rhs); }
+};
+
+/**
+	@brief Deep acquisition history indexed by trigger timestamp
+	@ingroup datamodel
+
+	Acquisitions are keyed by TimePoint in an ordered tree, so "the trigger nearest timestamp T" is an
+	O(log n) seek rather than a linear scan. Waveforms are compressed on insertion (see WaveformCompressor)
+	and held in RAM up to a configurable budget; beyond that the oldest entries spill to an mmap-backed
+	scratch file so a day-long rolling capture is bounded only by disk. Nothing is decompressed until
+	Hydrate() is called for a specific acquisition and stream, and hydration of a spilled entry touches only
+	that entry's bytes of the backing file.
+
+	To keep history scrubbing responsive, a background prefetcher (see Prefetch()) hydrates the acquisitions
+	adjacent to the one being viewed and warms their GPU copies ahead of time; HydrateCached() then returns the
+	already-uploaded waveform instead of decompressing on the UI thread. The hydrated cache registers with the
+	MemoryPressureManager so warm copies are the first thing dropped when memory runs short.
+
+	All public methods are thread safe.
+ */
+class WaveformHistoryStore : public MemoryPressureClient
+{
+public:
+	WaveformHistoryStore();
+	~WaveformHistoryStore();
+
+	//not copyable or assignable
+	WaveformHistoryStore(const WaveformHistoryStore&) =delete;
+	WaveformHistoryStore& operator=(const WaveformHistoryStore&) =delete;
+
+	void Add(TimePoint when, const std::string& stream, WaveformBase* wfm);
+	bool FindNearest(TimePoint target, TimePoint& found);
+	std::vector<std::string> GetStreams(TimePoint when);
+	WaveformBase* Hydrate(TimePoint when, const std::string& stream);
+	std::shared_ptr<WaveformBase> HydrateCached(TimePoint when, const std::string& stream);
+	void Prefetch(TimePoint center, size_t radius = 2);
+	void Clear();
+
+	//MemoryPressureClient
+	virtual size_t GetDeviceMemoryUse() override;
+	virtual size_t GetHostMemoryUse() override;
+	virtual size_t EvictDeviceMemory() override;
+	virtual size_t SpillHostMemory() override;
+
+	virtual MemoryBudgetGroup GetBudgetGroup() override
+	{ return MemoryBudgetGroup::Acquisition; }
+
+	size_t GetEntryCount();
+	size_t GetRamUsage();
+
+	/**
+		@brief Sets the maximum RAM (in bytes) used by compressed resident waveforms before spilling to disk
+
+		@param bytes	New RAM budget
+	 */
+	void SetRamBudget(size_t bytes)
+	{ m_ramBudget = bytes; }
+
+	/**
+		@brief Sets the path of the spill file (created lazily on first spill)
+
+		Must be called before anything has spilled. Defaults to a file in the system temp directory.
+
+		@param path	Path to the scratch file
+	 */
+	void SetSpillPath(const std::string& path)
+	{ m_spillPath = path; }
+
+protected:
+
+	///@brief One waveform of one acquisition, either compressed in RAM or spilled to the backing file
+	struct StoredWaveform
+	{
+		///@brief Compressed blob, null if spilled
+		std::unique_ptr<CompressedWaveform> m_resident;
+
+		///@brief Byte offset of the serialized blob in the spill file (only valid if not resident)
+		uint64_t m_spillOffset;
+
+		///@brief Length of the serialized blob in the spill file (only valid if not resident)
+		uint64_t m_spillLength;
+	};
+
+	void SpillOldest();
+	void PrefetchWorker();
+	static size_t EstimateHydratedSize(WaveformBase* wfm);
+	bool SpillWaveform(StoredWaveform& sw);
+	std::unique_ptr<CompressedWaveform> LoadSpilled(const StoredWaveform& sw);
+	bool RemapSpillFile();
+	void CloseSpillFile();
+
+	///@brief All stored acquisitions, ordered by trigger time (one map of streams per trigger)
+	std::map<TimePoint, std::map<std::string, StoredWaveform>> m_entries;
+
+	///@brief Total compressed size of all resident waveforms
+	size_t m_ramUsage;
+
+	///@brief RAM budget before spilling kicks in
+	size_t m_ramBudget;
+
+	///@brief Path of the spill file
+	std::string m_spillPath;
+
+	///@brief Spill file handle (append only), null until the first spill
+	FILE* m_spillFile;
+
+	///@brief Total bytes written to the spill file
+	uint64_t m_spillSize;
+
+	///@brief Read-only mapping of the spill file, null if not mapped
+	void* m_mapping;
+
+	///@brief Length of the current mapping (may lag m_spillSize until remapped)
+	uint64_t m_mapLen;
+
+	///@brief Synchronizes all access to the store
+	std::mutex m_mutex;
+
+	///@brief Hydrated, GPU-warm waveforms for acquisitions near the one being viewed
+	std::map<TimePoint, std::map<std::string, std::shared_ptr<WaveformBase>>> m_hydrated;
+
+	///@brief Estimated bytes of sample data held by m_hydrated
+	size_t m_hydratedBytes;
+
+	///@brief Synchronizes access to the hydrated cache and the prefetch request state
+	std::mutex m_cacheMutex;
+
+	///@brief Wakes the prefetch worker when a new request arrives or at shutdown
+	std::condition_variable m_prefetchWake;
+
+	///@brief Background thread that hydrates and uploads neighbors of the viewed acquisition (started lazily)
+	std::unique_ptr<std::thread> m_prefetchThread;
+
+	///@brief Center of the most recent prefetch request
+	TimePoint m_prefetchTarget;
+
+	///@brief Radius of the most recent prefetch request, in acquisitions per direction
+	size_t m_prefetchRadius;
+
+	///@brief True if a prefetch request is waiting for the worker
+	bool m_prefetchPending;
+
+	///@brief Tells the prefetch worker to exit
+	bool m_prefetchExit;
+};
+
+#endif
@@ -42,6 +42,9 @@
 
 	Allocating and freeing GPU memory can be an expensive operation so it's usually preferable to recycle existing
 	Waveform objects if possible.
+
+	Free waveforms are bucketed by power-of-two size class, so a caller asking for a given number of samples gets a
+	waveform whose buffers are already about the right size and won't need to reallocate when resized.
  */
 class WaveformPool
 {
@@ -50,7 +53,7 @@ public:
 	/**
 		@brief Creates a waveform pool
 
-		@param maxSize	Maximum number of waveforms to store in the pool
+		@param maxSize	Maximum number of waveforms to store in each size-class bucket
 	 */
 	WaveformPool(size_t maxSize = 16)
 	: m_maxSize(maxSize)
@@ -58,15 +61,13 @@ public:
 
 	~WaveformPool()
 	{
-		for(auto w : m_waveforms)
-			delete w;
-		m_waveforms.clear();
+		clear();
 	}
 
 	/**
-		@brief Adds a new waveform to the pool if there's sufficient free slots in the pool.
+		@brief Adds a new waveform to the pool if there's sufficient free slots in its size-class bucket.
 
-		If the pool is already full the waveform is destroyed.
+		If the bucket is already full the waveform is destroyed.
 
 		@param w	The waveform to add
 	 */
@@ -75,14 +76,36 @@ public:
 		std::lock_guard<std::mutex> lock(m_mutex);
 		w->Rename("WaveformPool.freelist");
 
-		if(m_waveforms.size() < m_maxSize)
-			m_waveforms.push_back(w);
+		auto& bucket = m_waveforms[SizeClass(w->size())];
+		if(bucket.size() < m_maxSize)
+			bucket.push_back(w);
 		else
 			delete w;
 	}
 
 	/**
-		@brief Attempts to get a waveform from the pool.
+		@brief Adds a waveform to the pool, bucketing it by an explicitly supplied size.
+
+		Intended for waveform classes (e.g. density plots) whose size() does not reflect their actual buffer size.
+		If the bucket is already full the waveform is destroyed.
+
+		@param w	The waveform to add
+		@param size	Size of the waveform's buffer, in samples or pixels
+	 */
+	void Add(WaveformBase* w, size_t size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		w->Rename("WaveformPool.freelist");
+
+		auto& bucket = m_waveforms[SizeClass(size)];
+		if(bucket.size() < m_maxSize)
+			bucket.push_back(w);
+		else
+			delete w;
+	}
+
+	/**
+		@brief Attempts to get a waveform from the pool, with no constraint on its size.
 
 		@return The waveform, if one is available. Returns nullptr if the pool is empty.
 	 */
@@ -90,15 +113,35 @@ public:
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if(m_waveforms.empty())
-			return nullptr;
+		//Grab from the largest non-empty bucket so small requests don't chew up big buffers unnecessarily
+		for(auto it = m_waveforms.rbegin(); it != m_waveforms.rend(); ++it)
+		{
+			if(!it->second.empty())
+				return GetFromBucket(it->second);
+		}
+		return nullptr;
+	}
 
-		auto ret = *m_waveforms.begin();
-		ret->m_revision ++;
-		m_waveforms.pop_front();
+	/**
+		@brief Attempts to get a waveform from the pool whose buffers are sized for (at least) minSize samples.
 
-		ret->Rename("WaveformPool.allocated");
-		return ret;
+		@param minSize	Minimum number of samples the waveform will be resized to hold
+
+		@return The waveform, if a suitably sized one is available. Returns nullptr otherwise.
+	 */
+	WaveformBase* Get(size_t minSize)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		//Check the exact size class, then the next one up (anything bigger wastes too much memory)
+		size_t sclass = SizeClass(minSize);
+		for(size_t k = sclass; k <= (sclass + 1); k++)
+		{
+			auto it = m_waveforms.find(k);
+			if( (it != m_waveforms.end()) && !it->second.empty() )
+				return GetFromBucket(it->second);
+		}
+		return nullptr;
 	}
 
 	/**
@@ -110,26 +153,51 @@ public:
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
 
-		if(m_waveforms.empty())
-			return false;
-
-		for(auto w : m_waveforms)
-			delete w;
+		bool freed = false;
+		for(auto& it : m_waveforms)
+		{
+			for(auto w : it.second)
+			{
+				delete w;
+				freed = true;
+			}
+		}
 		m_waveforms.clear();
 
-		return true;
+		return freed;
 	}
 
 protected:
 
-	///@brief Maximum number of waveforms to store in the pool
+	///@brief Returns the size class (ceiling log2 of the sample count) a waveform of the given size belongs to
+	static size_t SizeClass(size_t size)
+	{
+		size_t sclass = 0;
+		while( (1UL << sclass) < size)
+			sclass ++;
+		return sclass;
+	}
+
+	///@brief Removes and returns the first waveform of a bucket (assumes m_mutex is locked and bucket is non-empty)
+	WaveformBase* GetFromBucket(std::list<WaveformBase*>& bucket)
+	{
+		auto ret = bucket.front();
+		bucket.pop_front();
+
+		ret->m_revision ++;
+		ret->m_dirtyStartIndex = 0;
+		ret->Rename("WaveformPool.allocated");
+		return ret;
+	}
+
+	///@brief Maximum number of waveforms to store in each size-class bucket
 	size_t m_maxSize;
 
 	///@brief Mutex for synchronizing access to m_waveforms across threads
 	std::mutex m_mutex;
 
-	///@brief The list of free waveforms
-	std::list<WaveformBase*> m_waveforms;
+	///@brief Free waveforms, bucketed by size class
+	std::map<size_t, std::list<WaveformBase*>> m_waveforms;
 };
 
 #endif
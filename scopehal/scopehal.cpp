@@ -112,6 +112,10 @@
 #include <shlobj.h>
 #endif
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 #ifdef __x86_64__
@@ -120,6 +124,7 @@ bool g_hasAvx512DQ = false;
 bool g_hasAvx512VL = false;
 bool g_hasAvx2 = false;
 bool g_hasFMA = false;
+bool g_hasPclmul = false;
 #endif
 
 #ifdef __APPLE__
@@ -132,6 +137,12 @@ bool g_gpuFilterEnabled = false;
 ///@brief True if scope drivers can use GPU acceleration
 bool g_gpuScopeDriverEnabled = false;
 
+///@brief True if the scheduler may merge structurally equivalent filters (shared subexpression elimination)
+bool g_filterDedupEnabled = true;
+
+///@brief Buffer transfer / allocation counters of the current thread, sampled by the filter graph profiler
+thread_local BufferPerfCounters g_bufferPerfCounters;
+
 vector<string> g_searchPaths;
 
 void VulkanCleanup();
@@ -139,6 +150,9 @@ void VulkanCleanup();
 ///@brief List of handlers for low memory registered by various subsystems
 set<MemoryPressureHandler> g_memoryPressureHandlers;
 
+///@brief Preferred NUMA node for memory allocated by the calling thread (-1 = no preference)
+thread_local int g_numaPreferredNode = -1;
+
 /**
 	@brief Static initialization for SCPI transports
  */
@@ -154,11 +168,18 @@ void TransportStaticInit()
 	AddTransportClass(SCPIUARTTransport);
 	AddTransportClass(SCPIHIDTransport);
 	AddTransportClass(SCPINullTransport);
+	AddTransportClass(SCPIRecordingTransport);
+	AddTransportClass(SCPIReplayTransport);
 	AddTransportClass(VICPSocketTransport);
 
-	//SocketCAN is a Linux-specific feature
+	//SocketCAN and the shared memory twinlan variant are Linux-specific features
 #ifdef __linux
 	AddTransportClass(SCPISocketCANTransport);
+	AddTransportClass(SCPITwinLanShmTransport);
+#endif
+
+#ifdef HAS_LIBURING
+	AddTransportClass(SCPIUringTransport);
 #endif
 
 #ifdef HAS_LXI
@@ -184,11 +205,14 @@ void DetectCPUFeatures()
 	g_hasAvx512DQ = __builtin_cpu_supports("avx512dq");
 	g_hasAvx2 = __builtin_cpu_supports("avx2");
 	g_hasFMA = __builtin_cpu_supports("fma");
+	g_hasPclmul = __builtin_cpu_supports("pclmul");
 
 	if(g_hasAvx2)
 		LogDebug("* AVX2\n");
 	if(g_hasFMA)
 		LogDebug("* FMA\n");
+	if(g_hasPclmul)
+		LogDebug("* PCLMULQDQ\n");
 	if(g_hasAvx512F)
 		LogDebug("* AVX512F\n");
 	if(g_hasAvx512DQ)
@@ -208,6 +232,7 @@ void DetectCPUFeatures()
 
 void ScopehalStaticCleanup()
 {
+	g_instrumentCapabilityCache = nullptr;
 	VulkanCleanup();
 }
 
@@ -219,6 +244,8 @@ void DriverStaticInit()
 	InitializeSearchPaths();
 	DetectCPUFeatures();
 
+	g_instrumentCapabilityCache = make_unique<InstrumentCapabilityCache>();
+
 	AddBERTDriverClass(AntikernelLabsTriggerCrossbar);
 	AddBERTDriverClass(MultiLaneBERT);
 
@@ -285,6 +312,56 @@ void DriverStaticInit()
 	AddTriggerClass(WindowTrigger);
 }
 
+/**
+	@brief Connects to and identifies several instruments concurrently
+
+	Bring-up of a single instrument is inherently serial (connect, *IDN?, then capability probing, each
+	waiting on instrument round trips), but separate instruments don't share any state until they're handed
+	to the session, so a rack of a dozen boxes can be brought up in the time of the slowest one instead of
+	the sum of all of them.
+
+	@param requests		One entry per instrument to connect to
+
+	@return One entry per request, in the same order; null for any instrument that failed to connect
+ */
+vector<shared_ptr<Oscilloscope>> CreateOscilloscopesParallel(const vector<OscilloscopeConnectionRequest>& requests)
+{
+	vector<shared_ptr<Oscilloscope>> scopes(requests.size());
+
+	vector<thread> threads;
+	for(size_t i=0; i<requests.size(); i++)
+	{
+		threads.emplace_back([i, &requests, &scopes]
+		{
+			auto& req = requests[i];
+
+			auto transport = SCPITransport::CreateTransport(req.m_transport, req.m_args);
+			if(!transport)
+				return;
+			if(!transport->IsConnected())
+			{
+				LogError("Couldn't connect to %s over %s transport\n", req.m_args.c_str(), req.m_transport.c_str());
+				delete transport;
+				return;
+			}
+
+			//The driver takes ownership of the transport; clean up ourselves only if creation failed
+			auto scope = Oscilloscope::CreateOscilloscope(req.m_driver, transport);
+			if(!scope)
+			{
+				LogError("Couldn't create driver \"%s\"\n", req.m_driver.c_str());
+				delete transport;
+				return;
+			}
+			scopes[i] = scope;
+		});
+	}
+	for(auto& t : threads)
+		t.join();
+
+	return scopes;
+}
+
 string GetDefaultChannelColor(int i)
 {
 	const int NUM_COLORS = 12;
@@ -319,6 +396,170 @@ uint64_t ConvertVectorSignalToScalar(const vector<bool>& bits)
 	return rval;
 }
 
+/**
+	@brief Loads a single plugin module and runs its PluginInit() entry point
+
+	Safe to call multiple times with the same path; the plugin is only loaded and initialized once.
+	(For now, plugins are never unloaded.)
+
+	@return True if the plugin is loaded and initialized (now or previously)
+ */
+bool LoadPlugin(const string& fname)
+{
+	static mutex pluginMutex;
+	static set<string> loadedPlugins;
+
+	lock_guard<mutex> lock(pluginMutex);
+	if(loadedPlugins.find(fname) != loadedPlugins.end())
+		return true;
+
+	typedef void (*PluginInit)();
+
+#ifndef _WIN32
+	void* hlib = dlopen(fname.c_str(), RTLD_NOW);
+	if(hlib == nullptr)
+		return false;
+
+	PluginInit init = (PluginInit)dlsym(hlib, "PluginInit");
+	if(!init)
+		return false;
+#else
+	auto module = LoadLibraryA(fname.c_str());
+	if(module == NULL)
+		return false;
+
+	auto init = reinterpret_cast<PluginInit>(GetProcAddress(module, "PluginInit"));
+	if(init == NULL)
+	{
+		FreeLibrary(module);
+		return false;
+	}
+#endif
+
+	LogDebug("Loading plugin %s\n", fname.c_str());
+	init();
+	loadedPlugins.emplace(fname);
+	return true;
+}
+
+/**
+	@brief Registers lazy-load stubs for a plugin that has a sidecar manifest
+
+	The manifest is the plugin path plus ".manifest", with one "filter <name>" or "driver <name>" line per
+	class the module registers. Unknown kinds are ignored for forward compatibility; # starts a comment.
+
+	@return True if at least one stub was registered (so the module should not be loaded eagerly)
+ */
+static bool RegisterPluginManifest(const string& fname)
+{
+	FILE* fp = fopen((fname + ".manifest").c_str(), "r");
+	if(!fp)
+		return false;
+
+	bool any = false;
+	char line[1024];
+	while(fgets(line, sizeof(line), fp))
+	{
+		auto s = Trim(line);
+		if(s.empty() || (s[0] == '#'))
+			continue;
+
+		if(s.compare(0, 7, "filter ") == 0)
+		{
+			Filter::AddLazyDecoderClass(Trim(s.substr(7)), fname);
+			any = true;
+		}
+		else if(s.compare(0, 7, "driver ") == 0)
+		{
+			Oscilloscope::AddLazyDriverClass(Trim(s.substr(7)), fname);
+			any = true;
+		}
+	}
+	fclose(fp);
+	return any;
+}
+
+/**
+	@brief Writes a sidecar manifest for a freshly loaded plugin, listing the classes it registered
+
+	Failure (read-only plugin directory, etc) is not an error: the next start just loads eagerly again.
+ */
+static void WritePluginManifest(const string& fname, const set<string>& oldFilters, const set<string>& oldDrivers)
+{
+	vector<string> filters;
+	vector<string> drivers;
+	Filter::EnumProtocols(filters);
+	Oscilloscope::EnumDrivers(drivers);
+
+	//Find what this module added
+	vector<string> newFilters;
+	vector<string> newDrivers;
+	for(auto& f : filters)
+	{
+		if(oldFilters.find(f) == oldFilters.end())
+			newFilters.push_back(f);
+	}
+	for(auto& d : drivers)
+	{
+		if(oldDrivers.find(d) == oldDrivers.end())
+			newDrivers.push_back(d);
+	}
+	if(newFilters.empty() && newDrivers.empty())
+		return;
+
+	FILE* fp = fopen((fname + ".manifest").c_str(), "w");
+	if(!fp)
+		return;
+	fprintf(fp, "# Lazy load manifest, delete this file to force a full load of the plugin\n");
+	for(auto& f : newFilters)
+		fprintf(fp, "filter %s\n", f.c_str());
+	for(auto& d : newDrivers)
+		fprintf(fp, "driver %s\n", d.c_str());
+	fclose(fp);
+}
+
+/**
+	@brief Initializes a single plugin module, deferring the actual load if it has a manifest
+ */
+static void InitializePluginFromFile(const string& fname)
+{
+	//Sidecar manifest: register name-to-plugin stubs and skip the expensive load until first use
+	if(RegisterPluginManifest(fname))
+		return;
+
+	//No manifest: load eagerly, recording what was registered beforehand
+	set<string> oldFilters;
+	set<string> oldDrivers;
+	{
+		vector<string> f;
+		vector<string> d;
+		Filter::EnumProtocols(f);
+		Oscilloscope::EnumDrivers(d);
+		oldFilters.insert(f.begin(), f.end());
+		oldDrivers.insert(d.begin(), d.end());
+	}
+
+	if(!LoadPlugin(fname))
+		return;
+
+	//Cache a manifest next to the module (if the directory is writable) so the next cold start can defer it
+	WritePluginManifest(fname, oldFilters, oldDrivers);
+}
+
+#ifndef _WIN32
+/**
+	@brief Checks if a path names a plugin sidecar manifest rather than a loadable module
+
+	(The Windows search pattern only matches *.dll, so no check is needed there.)
+ */
+static bool IsPluginManifest(const string& fname)
+{
+	const string suffix = ".manifest";
+	return (fname.length() >= suffix.length()) &&
+		(fname.compare(fname.length() - suffix.length(), suffix.length(), suffix) == 0);
+}
+#endif
+
 /**
 	@brief Initialize all plugins
  */
@@ -362,22 +603,14 @@ void InitializePlugins()
 			if(pent->d_type == DT_DIR)
 				continue;
 
-			//Try loading it and see if it works.
-			//(for now, never unload the plugins)
+			//Don't try to load sidecar manifests as modules
 			string fname = dir + "/" + pent->d_name;
-			void* hlib = dlopen(fname.c_str(), RTLD_NOW);
-			if(hlib == NULL)
-				continue;
-
-			//If loaded, look for PluginInit()
-			typedef void (*PluginInit)();
-			PluginInit init = (PluginInit)dlsym(hlib, "PluginInit");
-			if(!init)
+			if(IsPluginManifest(fname))
 				continue;
 
-			//If found, it's a valid plugin
-			LogDebug("Loading plugin %s\n", fname.c_str());
-			init();
+			//Register lazy stubs from the manifest if it has one, else load eagerly
+			//(quietly skipping anything that isn't a valid plugin)
+			InitializePluginFromFile(fname);
 		}
 
 		closedir(hdir);
@@ -425,7 +658,6 @@ void InitializePlugins()
 		if(!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
 		{
 			auto fileName = findData.cFileName;
-			auto fileNameCStr = reinterpret_cast<const char*>(fileName);
 
 			// The file name does not contain the full path, which poses a problem since the file is
 			// located in the plugins subdirectory
@@ -437,30 +669,10 @@ void InitializePlugins()
 				return;
 			}
 
-			// Try to open it as a library
-			auto module = LoadLibrary(filePath);
-
-			if(module != NULL)
-			{
-				// Try to retrieve plugin entry point address
-				auto procAddr = GetProcAddress(module, "PluginInit");
-
-				if(procAddr != NULL)
-				{
-					typedef void (*PluginInit)();
-					auto proc = reinterpret_cast<PluginInit>(procAddr);
-					proc();
-				}
-				else
-				{
-					LogWarning("Warning: Found plugin %s, but has no init symbol\n", fileNameCStr);
-					FreeLibrary(module);
-				}
-			}
-			else
-			{
-				LogWarning("Warning: Found plugin %s, but isn't valid library\n", fileNameCStr);
-			}
+			// Register lazy stubs from the manifest if it has one, else load eagerly
+			// (quietly skipping anything that isn't a valid plugin; the *.dll search
+			// pattern already excludes sidecar manifests)
+			InitializePluginFromFile(reinterpret_cast<const char*>(filePath));
 		}
 	}
 	while(0 != FindNextFile(findHandle, &findData));
@@ -904,6 +1116,215 @@ string str_replace(const string& search, const string& replace, const string& su
 	return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Vectorized ASCII block decoding (for instruments stuck in ASCII or hex transfer modes)
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for DecodeHexBlock(): 32 hex characters -> 16 bytes per iteration
+ */
+__attribute__((target("avx2")))
+static size_t DecodeHexBlockAVX2(const char* din, size_t len, uint8_t* dout)
+{
+	size_t end = len - (len % 32);
+
+	const __m256i asciiZero	= _mm256_set1_epi8('0');
+	const __m256i caseBit	= _mm256_set1_epi8(0x20);
+	const __m256i alphaBase	= _mm256_set1_epi8('a' - 10);
+	const __m256i nine		= _mm256_set1_epi8(9);
+
+	//maddubs pairs: high nibble character comes first in the stream, so weight it by 16
+	const __m256i nibbleWeights = _mm256_set1_epi16(0x0110);
+
+	size_t nout = 0;
+	for(size_t k=0; k<end; k += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(din + k));
+
+		//Decode '0'-'9' and (case folded) 'a'-'f' in parallel, then pick whichever is in range.
+		//Garbage input decodes to garbage; the caller is expected to validate framing.
+		__m256i folded = _mm256_or_si256(v, caseBit);
+		__m256i digits = _mm256_sub_epi8(v, asciiZero);
+		__m256i alphas = _mm256_sub_epi8(folded, alphaBase);
+		__m256i isAlpha = _mm256_cmpgt_epi8(digits, nine);
+		__m256i nibbles = _mm256_blendv_epi8(digits, alphas, isAlpha);
+
+		//Combine nibble pairs into bytes, then squeeze the 16-bit results down to 16 packed bytes
+		__m256i bytes16 = _mm256_maddubs_epi16(nibbles, nibbleWeights);
+		__m256i packed = _mm256_packus_epi16(bytes16, bytes16);
+		packed = _mm256_permute4x64_epi64(packed, 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dout + nout), _mm256_castsi256_si128(packed));
+		nout += 16;
+	}
+
+	//Finish the tail with the generic loop
+	for(size_t k=end; k+1 < len; k += 2)
+	{
+		uint8_t hi = din[k];
+		uint8_t lo = din[k+1];
+		hi = (hi <= '9') ? (hi - '0') : ((hi | 0x20) - 'a' + 10);
+		lo = (lo <= '9') ? (lo - '0') : ((lo | 0x20) - 'a' + 10);
+		dout[nout ++] = (hi << 4) | lo;
+	}
+	return nout;
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Generic backend for DecodeHexBlock()
+ */
+static size_t DecodeHexBlockGeneric(const char* din, size_t len, uint8_t* dout)
+{
+	size_t nout = 0;
+	for(size_t k=0; k+1 < len; k += 2)
+	{
+		uint8_t hi = din[k];
+		uint8_t lo = din[k+1];
+		hi = (hi <= '9') ? (hi - '0') : ((hi | 0x20) - 'a' + 10);
+		lo = (lo <= '9') ? (lo - '0') : ((lo | 0x20) - 'a' + 10);
+		dout[nout ++] = (hi << 4) | lo;
+	}
+	return nout;
+}
+
+/**
+	@brief Decodes a block of ASCII hex (upper or lower case, no separators) to raw bytes
+
+	Intended for bulk waveform transfers from instruments whose firmware only offers hex dump formats:
+	decodes 16 bytes per clock tick rather than two library calls per byte. The input is assumed to be
+	valid hex with an even length (any trailing odd character is ignored); the caller is responsible for
+	stripping block headers and validating framing first.
+
+	@param din	Input character data
+	@param len	Number of input characters
+	@param dout	Output buffer, must have room for len/2 bytes
+
+	@return Number of bytes written
+ */
+size_t DecodeHexBlock(const char* din, size_t len, uint8_t* dout)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return DecodeHexBlockAVX2(din, len, dout);
+	#endif
+	return DecodeHexBlockGeneric(din, len, dout);
+}
+
+/**
+	@brief Converts one delimited integer field (no validation beyond stopping at the first non-digit)
+ */
+static int32_t ParseIntField(const char* p, const char* end)
+{
+	bool neg = false;
+	if( (p < end) && (*p == '-') )
+	{
+		neg = true;
+		p ++;
+	}
+	else if( (p < end) && (*p == '+') )
+		p ++;
+
+	int32_t x = 0;
+	for(; p < end; p ++)
+	{
+		char c = *p;
+		if( (c < '0') || (c > '9') )
+			break;
+		x = (x * 10) + (c - '0');
+	}
+	return neg ? -x : x;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 backend for ParseCommaSeparatedInts(): finds delimiters 32 characters at a time
+ */
+__attribute__((target("avx2")))
+static size_t ParseCommaSeparatedIntsAVX2(const char* din, size_t len, int32_t* dout, size_t maxout)
+{
+	const __m256i commas = _mm256_set1_epi8(',');
+
+	size_t nout = 0;
+	size_t fieldStart = 0;
+	size_t base = 0;
+	for(; base + 32 <= len; base += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(din + base));
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, commas));
+		while(mask)
+		{
+			if(nout >= maxout)
+				return nout;
+			size_t pos = base + __builtin_ctz(mask);
+			dout[nout ++] = ParseIntField(din + fieldStart, din + pos);
+			fieldStart = pos + 1;
+			mask &= (mask - 1);
+		}
+	}
+
+	//Tail: fewer than 32 characters left, find remaining delimiters the slow way
+	for(size_t k=base; k<len; k++)
+	{
+		if(din[k] != ',')
+			continue;
+		if(nout >= maxout)
+			return nout;
+		dout[nout ++] = ParseIntField(din + fieldStart, din + k);
+		fieldStart = k + 1;
+	}
+
+	//Last field has no trailing comma
+	if( (fieldStart < len) && (nout < maxout) )
+		dout[nout ++] = ParseIntField(din + fieldStart, din + len);
+	return nout;
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Generic backend for ParseCommaSeparatedInts()
+ */
+static size_t ParseCommaSeparatedIntsGeneric(const char* din, size_t len, int32_t* dout, size_t maxout)
+{
+	size_t nout = 0;
+	size_t fieldStart = 0;
+	for(size_t k=0; k<len; k++)
+	{
+		if(din[k] != ',')
+			continue;
+		if(nout >= maxout)
+			return nout;
+		dout[nout ++] = ParseIntField(din + fieldStart, din + k);
+		fieldStart = k + 1;
+	}
+	if( (fieldStart < len) && (nout < maxout) )
+		dout[nout ++] = ParseIntField(din + fieldStart, din + len);
+	return nout;
+}
+
+/**
+	@brief Parses a block of comma-separated ASCII integers to int32
+
+	Intended for bulk waveform transfers from instruments whose firmware only offers ASCII list formats.
+	Delimiters are located with vector compares 32 characters at a time and each field is converted with a
+	branch-light accumulate, avoiding the locale and errno overhead of one strtol()/sscanf() call per sample.
+	Fields may have a leading '-' or '+'; conversion of a field stops at the first unexpected character.
+
+	@param din		Input character data
+	@param len		Number of input characters
+	@param dout		Output buffer
+	@param maxout	Capacity of the output buffer, in elements
+
+	@return Number of integers written
+ */
+size_t ParseCommaSeparatedInts(const char* din, size_t len, int32_t* dout, size_t maxout)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return ParseCommaSeparatedIntsAVX2(din, len, dout, maxout);
+	#endif
+	return ParseCommaSeparatedIntsGeneric(din, len, dout, maxout);
+}
+
 uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize)
 {
 	uint32_t ret = numGlobal / blockSize;
@@ -965,37 +1386,6 @@ void CreateDirectory(const string& path)
 }
 #endif
 
-/**
-	@brief Calculates a CRC32 checksum using the standard Ethernet polynomial
- */
-uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end)
-{
-	uint32_t poly = 0xedb88320;
-
-	uint32_t crc = 0xffffffff;
-	for(size_t n=start; n <= end; n++)
-	{
-		uint8_t d = bytes[n];
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
-	}
-
-	return ~(	((crc & 0x000000ff) << 24) |
-				((crc & 0x0000ff00) << 8) |
-				((crc & 0x00ff0000) >> 8) |
-				 (crc >> 24) );
-}
-
-uint32_t CRC32(const vector<uint8_t>& bytes)
-{
-	return CRC32(&bytes[0], 0, bytes.size()-1);
-}
-
 /**
 	@brief Returns the library version string (Semantic Version formatted)
  */
@@ -1026,7 +1416,23 @@ bool OnMemoryPressure(MemoryPressureLevel level, MemoryPressureType type, size_t
 		(type == MemoryPressureType::Host) ? "host" : "device",
 		Unit(Unit::UNIT_BYTES).PrettyPrint(requestedSize, 4).c_str());
 
-	bool moreFreed = false;
+	//Free any recycled filter output waveforms first, since they're not serving any immediate purpose
+	bool moreFreed = Filter::ClearWaveformPools();
+
+	//Then drop retained decoder outputs: re-decoding on demand beats dying of memory exhaustion
+	if(Filter::FlushAllOutputCaches())
+		moreFreed = true;
+
+	//Release any completely empty arena slabs back to the driver
+	if( (type == MemoryPressureType::Device) && g_gpuMemoryArena)
+	{
+		if(g_gpuMemoryArena->FreeUnusedSlabs())
+			moreFreed = true;
+	}
+
+	//Run the tiered eviction policy over registered clients (history waveforms etc.), coldest first
+	if(MemoryPressureManager::GetInstance().HandlePressure(level, type, requestedSize))
+		moreFreed = true;
 
 	for(auto handler : g_memoryPressureHandlers)
 	{
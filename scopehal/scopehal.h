@@ -78,11 +78,13 @@ extern bool g_hasAvx512F;
 extern bool g_hasAvx512VL;
 extern bool g_hasAvx512DQ;
 extern bool g_hasAvx2;
+extern bool g_hasPclmul;
 #endif
 
 //Enable flags for various features
 extern bool g_gpuFilterEnabled;
 extern bool g_gpuScopeDriverEnabled;
+extern bool g_filterDedupEnabled;
 extern bool g_hasShaderFloat64;
 extern bool g_hasShaderInt64;
 extern bool g_hasShaderInt16;
@@ -90,6 +92,7 @@ extern bool g_hasShaderInt8;
 extern bool g_hasShaderAtomicFloat;
 extern bool g_hasDebugUtils;
 extern bool g_hasMemoryBudget;
+extern bool g_hasMemoryPriority;
 extern bool g_hasPushDescriptor;
 
 extern size_t g_maxComputeGroupCount[3];
@@ -97,16 +100,22 @@ extern size_t g_maxComputeGroupCount[3];
 #include "Unit.h"
 #include "Bijection.h"
 #include "IDTable.h"
+#include "StringTable.h"
 
 #include "AcceleratorBuffer.h"
 #include "ComputePipeline.h"
+#include "MemoryPressureManager.h"
 
 #include "SCPITransport.h"
 #include "SCPISocketTransport.h"
 #include "SCPITwinLanTransport.h"
+#include "SCPITwinLanShmTransport.h"
+#include "SCPIUringTransport.h"
 #include "SCPILinuxGPIBTransport.h"
 #include "SCPILxiTransport.h"
 #include "SCPINullTransport.h"
+#include "SCPIRecordingTransport.h"
+#include "SCPIReplayTransport.h"
 #include "SCPIUARTTransport.h"
 #include "SCPIHIDTransport.h"
 #include "VICPSocketTransport.h"
@@ -121,6 +130,8 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SCPITMCTransport.h"
 #endif
 
+#include "InstrumentCapabilityCache.h"
+
 #include "FlowGraphNode.h"
 #include "Instrument.h"
 #include "StreamDescriptor.h"
@@ -169,6 +180,7 @@ extern size_t g_maxComputeGroupCount[3];
 #include "IBISParser.h"
 
 #include "FilterParameter.h"
+#include "FilterCostModel.h"
 #include "Filter.h"
 #include "ImportFilter.h"
 #include "PeakDetectionFilter.h"
@@ -177,8 +189,22 @@ extern size_t g_maxComputeGroupCount[3];
 #include "SParameterFilter.h"
 
 #include "FilterGraphExecutor.h"
+#include "FilterGraphOffload.h"
+#include "FilterGraphSweep.h"
+#include "SessionGraphCache.h"
 
+#include "AsyncTaskGroup.h"
+#include "GpuPrimitives.h"
+#include "LevelCrossingIndex.h"
 #include "QueueManager.h"
+#include "SparseWaveformBuilder.h"
+#include "StatisticsEngine.h"
+#include "WaveformCompressor.h"
+#include "WaveformDigest.h"
+#include "FilterSpillEngine.h"
+#include "LatencyTracer.h"
+#include "WaveformHistoryStore.h"
+#include "ColumnarWaveformFile.h"
 
 uint64_t ConvertVectorSignalToScalar(const std::vector<bool>& bits);
 
@@ -197,12 +223,34 @@ void GetTimestampOfFile(std::string path, time_t& timestamp, int64_t& fs);
 std::string to_string_sci(double d);
 std::string to_string_hex(uint64_t n, bool zeropad = false, int len = 0);
 
+size_t DecodeHexBlock(const char* din, size_t len, uint8_t* dout);
+size_t ParseCommaSeparatedInts(const char* din, size_t len, int32_t* dout, size_t maxout);
+
+/**
+	@brief Everything needed to connect to one instrument (see CreateOscilloscopesParallel())
+ */
+struct OscilloscopeConnectionRequest
+{
+	///@brief Registered driver name (e.g. "lecroy")
+	std::string m_driver;
+
+	///@brief Registered transport name (e.g. "lan")
+	std::string m_transport;
+
+	///@brief Transport arguments (typically hostname[:port])
+	std::string m_args;
+};
+
+std::vector<std::shared_ptr<Oscilloscope>> CreateOscilloscopesParallel(
+	const std::vector<OscilloscopeConnectionRequest>& requests);
+
 void TransportStaticInit();
 void DriverStaticInit();
 
 bool VulkanInit(bool skipGLFW = false);
 void InitializeSearchPaths();
 void InitializePlugins();
+bool LoadPlugin(const std::string& path);
 void DetectCPUFeatures();
 std::string GetDirOfCurrentExecutable();
 
@@ -240,18 +288,29 @@ struct ConvertRawSamplesShaderArgs
 	float offset;
 };
 
+struct ConvertInterleavedSamplesShaderArgs
+{
+	uint32_t size;
+	uint32_t stride;
+	uint32_t phase;
+	float gain;
+	float offset;
+};
+
 //Vulkan global stuff
 extern vk::raii::Context g_vkContext;
 extern std::unique_ptr<vk::raii::Instance> g_vkInstance;
 extern uint8_t g_vkComputeDeviceUuid[16];
 extern uint32_t g_vkComputeDeviceDriverVer;
 extern vk::raii::PhysicalDevice* g_vkComputePhysicalDevice;
+extern std::vector<std::string> g_vkComputeDeviceNames;
 extern std::unique_ptr<QueueManager> g_vkQueueManager;
 extern bool g_vulkanDeviceIsIntelMesa;
 extern bool g_vulkanDeviceIsAnyMesa;
 extern bool g_vulkanDeviceIsMoltenVK;
 extern uint32_t g_vkPinnedMemoryHeap;
 extern uint32_t g_vkLocalMemoryHeap;
+extern uint32_t g_vkBarMemoryHeap;
 extern bool g_vulkanDeviceHasUnifiedMemory;
 
 uint32_t GetComputeBlockCount(size_t numGlobal, size_t blockSize);
@@ -269,8 +328,7 @@ void CreateDirectory(const std::string& path);
 #endif
 
 //Checksum helpers
-uint32_t CRC32(const uint8_t* bytes, size_t start, size_t end);
-uint32_t CRC32(const std::vector<uint8_t>& bytes);
+#include "CRC.h"
 
 uint32_t ColorFromString(const std::string& str, unsigned int alpha = 255);
 
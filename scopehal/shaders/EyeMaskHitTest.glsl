@@ -0,0 +1,91 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+//int64 accumulator counts, viewed as (low, high) word pairs so we don't need 64-bit arithmetic support
+layout(std430, binding=0) restrict readonly buffer buf_accum
+{
+	uvec2 accum[];
+};
+
+//Mask coverage per pixel (1 = inside a mask polygon)
+layout(std430, binding=1) restrict readonly buffer buf_mask
+{
+	uint mask[];
+};
+
+//Per-workgroup hit counts as (low, high) word pairs
+layout(std430, binding=2) restrict writeonly buffer buf_partials
+{
+	uvec2 partials[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uvec2 g_partials[256];
+
+//Exact 64-bit addition of (low, high) word pairs
+uvec2 Add64(uvec2 a, uvec2 b)
+{
+	uint carry;
+	uint lo = uaddCarry(a.x, b.x, carry);
+	return uvec2(lo, a.y + b.y + carry);
+}
+
+void main()
+{
+	uint tid = gl_LocalInvocationID.x;
+	uint i = gl_GlobalInvocationID.x;
+
+	//Load the accumulator count if this pixel is inside the mask, otherwise zero
+	uvec2 value = uvec2(0, 0);
+	if( (i < size) && (mask[i] != 0) )
+		value = accum[i];
+	g_partials[tid] = value;
+	barrier();
+
+	//Tree reduction in shared memory
+	for(uint s = 128; s > 0; s >>= 1)
+	{
+		if(tid < s)
+			g_partials[tid] = Add64(g_partials[tid], g_partials[tid + s]);
+		barrier();
+	}
+
+	//Write the final sum for this workgroup
+	if(tid == 0)
+		partials[gl_WorkGroupID.x] = g_partials[0];
+}
@@ -0,0 +1,96 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+//Input: raw samples if firstLevel, else interleaved (min, max) pairs from the previous pyramid level
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Output: one interleaved (min, max) pair per entry
+layout(std430, binding=1) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint outlen;
+	uint inlen;
+	uint firstLevel;
+};
+
+//Number of raw samples covered by each base level entry (must match MinMaxPyramid::BASE_BLOCK)
+#define BASE_BLOCK 64
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= outlen)
+		return;
+
+	float vmin;
+	float vmax;
+
+	//Base level: reduce a block of raw samples
+	if(firstLevel != 0)
+	{
+		uint base = i * BASE_BLOCK;
+		uint end = min(inlen, base + BASE_BLOCK);
+		vmin = din[base];
+		vmax = vmin;
+		for(uint j = base + 1; j < end; j++)
+		{
+			float v = din[j];
+			vmin = min(vmin, v);
+			vmax = max(vmax, v);
+		}
+	}
+
+	//Upper levels: reduce two (min, max) pairs from the level below
+	else
+	{
+		uint base = i * 4;
+		vmin = din[base];
+		vmax = din[base + 1];
+		if(base + 2 < inlen)
+		{
+			vmin = min(vmin, din[base + 2]);
+			vmax = max(vmax, din[base + 3]);
+		}
+	}
+
+	dout[i*2] = vmin;
+	dout[i*2 + 1] = vmax;
+}
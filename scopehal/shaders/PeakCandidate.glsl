@@ -0,0 +1,91 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//One summary per workgroup: index of block max (first in case of ties), block max, block min
+//Layout must match PeakDetector::PeakBlockInfo
+struct BlockInfo
+{
+	uint idx;
+	float vmax;
+	float vmin;
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_blocks
+{
+	BlockInfo blocks[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+shared float smax[64];
+shared uint sidx[64];
+shared float smin[64];
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	uint tid = gl_LocalInvocationID.x;
+
+	float v = (i < npoints) ? din[i] : -3.402823466e38;
+	smax[tid] = v;
+	sidx[tid] = i;
+	smin[tid] = (i < npoints) ? v : 3.402823466e38;
+	barrier();
+
+	//Tree reduction in shared memory (strict compare keeps the leftmost sample on ties)
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		if(tid < s)
+		{
+			if(smax[tid + s] > smax[tid])
+			{
+				smax[tid] = smax[tid + s];
+				sidx[tid] = sidx[tid + s];
+			}
+			smin[tid] = min(smin[tid], smin[tid + s]);
+		}
+		barrier();
+	}
+
+	if(tid == 0)
+		blocks[gl_WorkGroupID.x] = BlockInfo(sidx[0], smax[0], smin[0]);
+}
@@ -0,0 +1,101 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//One partial maximum per workgroup
+layout(std430, binding=1) restrict writeonly buffer buf_partials
+{
+	float partials[];
+};
+
+//Index of each workgroup's partial maximum
+layout(std430, binding=2) restrict writeonly buffer buf_indices
+{
+	uint indices[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared float smax[256];
+shared uint sidx[256];
+
+void main()
+{
+	//Grid stride loop: each thread scans a strided subset of the input
+	//Ties go to the lowest index, matching a serial scan
+	float vmax = -3.4e38;
+	uint imax = 0xffffffff;
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < npoints; i += stride)
+	{
+		if( (din[i] > vmax) || ( (din[i] == vmax) && (i < imax) ) )
+		{
+			vmax = din[i];
+			imax = i;
+		}
+	}
+
+	uint tid = gl_LocalInvocationID.x;
+	smax[tid] = vmax;
+	sidx[tid] = imax;
+
+	//Tree reduction in shared memory
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		barrier();
+		if(tid < s)
+		{
+			if( (smax[tid + s] > smax[tid]) ||
+				( (smax[tid + s] == smax[tid]) && (sidx[tid + s] < sidx[tid]) ) )
+			{
+				smax[tid] = smax[tid + s];
+				sidx[tid] = sidx[tid + s];
+			}
+		}
+	}
+
+	//First thread of each workgroup writes the partial
+	if(tid == 0)
+	{
+		partials[gl_WorkGroupID.x] = smax[0];
+		indices[gl_WorkGroupID.x] = sidx[0];
+	}
+}
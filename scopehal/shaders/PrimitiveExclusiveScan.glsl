@@ -0,0 +1,113 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	uint din[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_dout
+{
+	uint dout[];
+};
+
+//Total of each workgroup's span, for the recursive fixup pass
+layout(std430, binding=2) restrict writeonly buffer buf_blocksums
+{
+	uint blocksums[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+};
+
+//Each workgroup scans SCAN_ELEMENTS elements, two per thread (Blelloch work-efficient scan)
+const uint SCAN_ELEMENTS = 512;
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uint temp[SCAN_ELEMENTS];
+
+void main()
+{
+	uint tid = gl_LocalInvocationID.x;
+	uint base = gl_WorkGroupID.x * SCAN_ELEMENTS;
+	uint ai = base + tid*2;
+
+	//Load two elements per thread, padding past-the-end elements with zeroes
+	temp[tid*2] = (ai < npoints) ? din[ai] : 0;
+	temp[tid*2 + 1] = (ai+1 < npoints) ? din[ai+1] : 0;
+
+	//Upsweep: build partial sums up the tree
+	uint offset = 1;
+	for(uint d = SCAN_ELEMENTS/2; d > 0; d >>= 1)
+	{
+		barrier();
+		if(tid < d)
+		{
+			uint a = offset*(2*tid + 1) - 1;
+			uint b = offset*(2*tid + 2) - 1;
+			temp[b] += temp[a];
+		}
+		offset <<= 1;
+	}
+
+	//Record this workgroup's total and clear the root for the downsweep
+	//(only thread 0 touched the root in the final upsweep step, so no barrier needed here)
+	if(tid == 0)
+	{
+		blocksums[gl_WorkGroupID.x] = temp[SCAN_ELEMENTS - 1];
+		temp[SCAN_ELEMENTS - 1] = 0;
+	}
+
+	//Downsweep: traverse back down, turning the partials into an exclusive scan
+	for(uint d = 1; d < SCAN_ELEMENTS; d <<= 1)
+	{
+		offset >>= 1;
+		barrier();
+		if(tid < d)
+		{
+			uint a = offset*(2*tid + 1) - 1;
+			uint b = offset*(2*tid + 2) - 1;
+			uint t = temp[a];
+			temp[a] = temp[b];
+			temp[b] += t;
+		}
+	}
+	barrier();
+
+	if(ai < npoints)
+		dout[ai] = temp[tid*2];
+	if(ai+1 < npoints)
+		dout[ai+1] = temp[tid*2 + 1];
+}
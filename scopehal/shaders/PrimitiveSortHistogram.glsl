@@ -0,0 +1,72 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_keys
+{
+	uint keys[];
+};
+
+//Digit-major (counts[digit*nblocks + workgroup]) so the exclusive scan of this buffer
+//directly gives every digit/workgroup pair's global scatter base
+layout(std430, binding=1) restrict writeonly buffer buf_counts
+{
+	uint counts[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+	uint nblocks;
+	uint shift;
+};
+
+const uint RADIX_DIGITS = 16;
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uint scounts[RADIX_DIGITS];
+
+void main()
+{
+	uint tid = gl_LocalInvocationID.x;
+	if(tid < RADIX_DIGITS)
+		scounts[tid] = 0;
+	barrier();
+
+	uint i = gl_GlobalInvocationID.x;
+	if(i < npoints)
+		atomicAdd(scounts[(keys[i] >> shift) & (RADIX_DIGITS - 1)], 1);
+	barrier();
+
+	if(tid < RADIX_DIGITS)
+		counts[tid*nblocks + gl_WorkGroupID.x] = scounts[tid];
+}
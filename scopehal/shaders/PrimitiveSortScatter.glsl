@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_src
+{
+	uint src[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer buf_dst
+{
+	uint dst[];
+};
+
+//Exclusive scan of the per-workgroup digit counts from PrimitiveSortHistogram.glsl
+layout(std430, binding=2) restrict readonly buffer buf_bases
+{
+	uint bases[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+	uint nblocks;
+	uint shift;
+};
+
+const uint RADIX_DIGITS = 16;
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uint digits[256];
+
+void main()
+{
+	uint tid = gl_LocalInvocationID.x;
+	uint i = gl_GlobalInvocationID.x;
+
+	uint key = 0;
+	uint digit = 0xffffffffu;
+	if(i < npoints)
+	{
+		key = src[i];
+		digit = (key >> shift) & (RADIX_DIGITS - 1);
+	}
+	digits[tid] = digit;
+	barrier();
+
+	if(i < npoints)
+	{
+		//Stable rank: number of earlier elements in this workgroup's span with the same digit
+		uint rank = 0;
+		for(uint j=0; j<tid; j++)
+		{
+			if(digits[j] == digit)
+				rank ++;
+		}
+
+		dst[bases[digit*nblocks + gl_WorkGroupID.x] + rank] = key;
+	}
+}
@@ -0,0 +1,100 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//One partial per workgroup: min, max, sum, sum of squares
+layout(std430, binding=1) restrict writeonly buffer buf_partials
+{
+	float partials[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint npoints;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared float smin[256];
+shared float smax[256];
+shared float ssum[256];
+shared float ssumsq[256];
+
+void main()
+{
+	//Grid stride loop: each thread accumulates a strided subset of the input
+	float vmin = 3.402823466e38;
+	float vmax = -3.402823466e38;
+	float vsum = 0;
+	float vsumsq = 0;
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < npoints; i += stride)
+	{
+		float v = din[i];
+		vmin = min(vmin, v);
+		vmax = max(vmax, v);
+		vsum += v;
+		vsumsq += v*v;
+	}
+
+	uint tid = gl_LocalInvocationID.x;
+	smin[tid] = vmin;
+	smax[tid] = vmax;
+	ssum[tid] = vsum;
+	ssumsq[tid] = vsumsq;
+
+	//Tree reduction in shared memory
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		barrier();
+		if(tid < s)
+		{
+			smin[tid] = min(smin[tid], smin[tid + s]);
+			smax[tid] = max(smax[tid], smax[tid + s]);
+			ssum[tid] += ssum[tid + s];
+			ssumsq[tid] += ssumsq[tid + s];
+		}
+	}
+
+	//First thread of each workgroup writes the partial
+	if(tid == 0)
+	{
+		partials[gl_WorkGroupID.x*4 + 0] = smin[0];
+		partials[gl_WorkGroupID.x*4 + 1] = smax[0];
+		partials[gl_WorkGroupID.x*4 + 2] = ssum[0];
+		partials[gl_WorkGroupID.x*4 + 3] = ssumsq[0];
+	}
+}
@@ -0,0 +1,110 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal                                                                                                          *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+//Input is declared as raw 32-bit words so that reading back arbitrary bit patterns is lossless
+//(float loads could canonicalize NaN payloads on some hardware)
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	uint din[];
+};
+
+//One partial per workgroup: two accumulator lanes
+layout(std430, binding=1) restrict writeonly buffer buf_partials
+{
+	uint partials[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint nwords;
+	uint quantize;
+	float tolerance;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+shared uint slane1[256];
+shared uint slane2[256];
+
+//Murmur3 finalizer: full-avalanche 32-bit mix
+uint Mix32(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6bu;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35u;
+	x ^= x >> 16;
+	return x;
+}
+
+void main()
+{
+	//Grid stride loop: each thread hashes a strided subset of the input.
+	//Each word's hash is position dependent (the index is mixed in) but the accumulators combine by
+	//addition, which is order independent, so thread/workgroup scheduling does not change the result.
+	//This must produce identical results to WaveformDigest::HashWordsCpu.
+	uint lane1 = 0;
+	uint lane2 = 0;
+	uint stride = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i = gl_GlobalInvocationID.x; i < nwords; i += stride)
+	{
+		uint q = din[i];
+		if(quantize != 0)
+			q = uint(int(floor(uintBitsToFloat(q) / tolerance + 0.5)));
+
+		uint k = Mix32(q ^ Mix32(i + 1));
+		lane1 += k;
+		lane2 += Mix32(k ^ 0x9e3779b9u);
+	}
+
+	uint tid = gl_LocalInvocationID.x;
+	slane1[tid] = lane1;
+	slane2[tid] = lane2;
+
+	//Tree reduction in shared memory
+	for(uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1)
+	{
+		barrier();
+		if(tid < s)
+		{
+			slane1[tid] += slane1[tid + s];
+			slane2[tid] += slane2[tid + s];
+		}
+	}
+
+	//First thread of each workgroup writes the partial
+	if(tid == 0)
+	{
+		partials[gl_WorkGroupID.x*2 + 0] = slane1[0];
+		partials[gl_WorkGroupID.x*2 + 1] = slane2[0];
+	}
+}
@@ -36,26 +36,12 @@ using namespace std;
 // Construction / destruction
 
 ACCoupleFilter::ACCoupleFilter(const string& color)
-	: Filter(color, CAT_MATH)
+	: PointwiseFilter(color, CAT_MATH)
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Factory methods
-
-bool ACCoupleFilter::ValidateChannel(size_t i, StreamDescriptor stream)
-{
-	if(stream.m_channel == NULL)
-		return false;
-
-	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
-		return true;
-
-	return false;
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -67,48 +53,13 @@ string ACCoupleFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void ACCoupleFilter::Refresh()
+PointwiseFilter::PointwiseOp ACCoupleFilter::GetPointwiseOp()
 {
-	//Make sure we've got valid inputs
-	if(!VerifyAllInputsOK())
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
 	auto data = GetInput(0).GetData();
 	auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
 	auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
 
-	//Find the average of our samples (assume data is DC balanced)
+	//Find the average of our samples (assume data is DC balanced) and subtract it out
 	float average = GetAvgVoltage(sdata, udata);
-	auto len = data->size();
-
-	//Set up waveforms
-	float* fsrc;
-	float* fdst;
-	if(sdata)
-	{
-		auto cap = SetupSparseOutputWaveform(sdata, 0, 0, 0);
-		fsrc = sdata->m_samples.GetCpuPointer();
-		fdst = cap->m_samples.GetCpuPointer();
-
-		cap->PrepareForCpuAccess();
-		cap->MarkSamplesModifiedFromCpu();
-		cap->MarkTimestampsModifiedFromCpu();
-	}
-	else
-	{
-		auto cap = SetupEmptyUniformAnalogOutputWaveform(udata, 0);
-		cap->Resize(len);
-		fsrc = udata->m_samples.GetCpuPointer();
-		fdst = cap->m_samples.GetCpuPointer();
-
-		cap->PrepareForCpuAccess();
-		cap->MarkSamplesModifiedFromCpu();
-	}
-
-	//Do the actual subtraction
-	for(size_t i=0; i<len; i++)
-		fdst[i] = fsrc[i] - average;
+	return PointwiseOp(PointwiseOp::OP_ADD, -average);
 }
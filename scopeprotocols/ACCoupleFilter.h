@@ -35,16 +35,16 @@
 #ifndef ACCoupleFilter_h
 #define ACCoupleFilter_h
 
-class ACCoupleFilter : public Filter
+#include "PointwiseFilter.h"
+
+class ACCoupleFilter : public PointwiseFilter
 {
 public:
 	ACCoupleFilter(const std::string& color);
 
-	virtual void Refresh() override;
-
 	static std::string GetProtocolName();
 
-	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+	virtual PointwiseOp GetPointwiseOp() override;
 
 	PROTOCOL_DECODER_INITPROC(ACCoupleFilter)
 
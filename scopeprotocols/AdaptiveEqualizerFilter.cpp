@@ -0,0 +1,233 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "AdaptiveEqualizerFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+AdaptiveEqualizerFilter::AdaptiveEqualizerFilter(const string& color)
+	: Filter(color, CAT_ANALYSIS)
+	, m_ffeTapCountName("FFE Taps")
+	, m_ffePrecursorName("Pre-cursor Taps")
+	, m_dfeTapCountName("DFE Taps")
+	, m_rateName("Adaptation Rate")
+	, m_targetName("Target Amplitude")
+	, m_tapExportName("Current Taps")
+{
+	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+	CreateInput("din");
+	CreateInput("clk");
+
+	m_parameters[m_ffeTapCountName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_ffeTapCountName].SetIntVal(5);
+
+	m_parameters[m_ffePrecursorName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_ffePrecursorName].SetIntVal(1);
+
+	m_parameters[m_dfeTapCountName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_dfeTapCountName].SetIntVal(2);
+
+	m_parameters[m_rateName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_rateName].SetFloatVal(0.01);
+
+	m_parameters[m_targetName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
+	m_parameters[m_targetName].SetFloatVal(0.2);
+
+	//Output only: overwritten after every refresh with the current tap weights
+	m_parameters[m_tapExportName] = FilterParameter(FilterParameter::TYPE_STRING, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_tapExportName].SetStringVal("");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool AdaptiveEqualizerFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+	if( (i == 1) && (stream.GetType() == Stream::STREAM_TYPE_DIGITAL) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string AdaptiveEqualizerFilter::GetProtocolName()
+{
+	return "Adaptive Equalizer";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+///@brief Restarts adaptation from a unit cursor tap
+void AdaptiveEqualizerFilter::ClearSweeps()
+{
+	ResetTaps();
+}
+
+void AdaptiveEqualizerFilter::ResetTaps()
+{
+	size_t nffe = m_parameters[m_ffeTapCountName].GetIntVal();
+	size_t npre = m_parameters[m_ffePrecursorName].GetIntVal();
+	size_t ndfe = m_parameters[m_dfeTapCountName].GetIntVal();
+	if(npre >= nffe)
+		npre = nffe - 1;
+
+	m_ffeTaps.assign(nffe, 0);
+	m_ffeTaps[npre] = 1;
+	m_dfeTaps.assign(ndfe, 0);
+}
+
+///@brief Formats the current tap weights for the export parameter
+string AdaptiveEqualizerFilter::FormatTaps()
+{
+	string ret = "FFE:";
+	char tmp[32];
+	for(auto t : m_ffeTaps)
+	{
+		snprintf(tmp, sizeof(tmp), " %.5f", t);
+		ret += tmp;
+	}
+	ret += " DFE:";
+	for(auto t : m_dfeTaps)
+	{
+		snprintf(tmp, sizeof(tmp), " %.5f", t);
+		ret += tmp;
+	}
+	return ret;
+}
+
+void AdaptiveEqualizerFilter::Refresh()
+{
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Get and sanity check the configuration
+	size_t nffe = m_parameters[m_ffeTapCountName].GetIntVal();
+	nffe = min(max(nffe, (size_t)1), (size_t)64);
+	size_t npre = m_parameters[m_ffePrecursorName].GetIntVal();
+	if(npre >= nffe)
+		npre = nffe - 1;
+	size_t ndfe = m_parameters[m_dfeTapCountName].GetIntVal();
+	ndfe = min(ndfe, (size_t)16);
+	float mu = m_parameters[m_rateName].GetFloatVal();
+	float target = m_parameters[m_targetName].GetFloatVal();
+
+	//Restart adaptation if the equalizer dimensions changed
+	//(a moved pre-cursor point with unchanged sizes just re-adapts, no reset needed)
+	if( (m_ffeTaps.size() != nffe) || (m_dfeTaps.size() != ndfe) )
+		ResetTaps();
+
+	//Sample the input data stream at the recovered clock edges
+	auto din = GetInputWaveform(0);
+	auto clk = GetInputWaveform(1);
+	din->PrepareForCpuAccess();
+	clk->PrepareForCpuAccess();
+
+	SparseAnalogWaveform samples;
+	SampleOnAnyEdgesBaseWithInterpolation(din, clk, samples);
+	samples.PrepareForCpuAccess();
+	size_t len = samples.m_samples.size();
+
+	//Create the output
+	auto cap = new SparseAnalogWaveform;
+	cap->m_timescale = samples.m_timescale;
+	cap->m_startTimestamp = samples.m_startTimestamp;
+	cap->m_startFemtoseconds = samples.m_startFemtoseconds;
+	cap->m_triggerPhase = samples.m_triggerPhase;
+	cap->PrepareForCpuAccess();
+	SetData(cap, 0);
+	cap->Resize(len);
+
+	//Equalize and adapt, one symbol at a time.
+	//The LMS update is a serial recurrence (each symbol's error adjusts the taps used by the next),
+	//but the per-symbol work is only a handful of multiply-accumulates, so a single pass over the
+	//symbol stream replaces an entire parameter sweep of fixed-tap refreshes.
+	const float* x = samples.m_samples.GetCpuPointer();
+	vector<float> dhist(ndfe, 0);
+	for(size_t i=0; i<len; i++)
+	{
+		//Feed-forward sum over the surrounding symbols (out-of-range taps contribute nothing)
+		float y = 0;
+		for(size_t k=0; k<nffe; k++)
+		{
+			int64_t idx = (int64_t)i + (int64_t)k - (int64_t)npre;
+			if( (idx >= 0) && (idx < (int64_t)len) )
+				y += m_ffeTaps[k] * x[idx];
+		}
+
+		//Subtract trailing ISI estimated from past decisions
+		for(size_t j=0; j<ndfe; j++)
+			y -= m_dfeTaps[j] * dhist[j];
+
+		//Slice (NRZ) and compute the decision error
+		float d = (y > 0) ? target : -target;
+		float e = y - d;
+
+		//LMS tap update
+		float step = mu * e;
+		for(size_t k=0; k<nffe; k++)
+		{
+			int64_t idx = (int64_t)i + (int64_t)k - (int64_t)npre;
+			if( (idx >= 0) && (idx < (int64_t)len) )
+				m_ffeTaps[k] -= step * x[idx];
+		}
+		for(size_t j=0; j<ndfe; j++)
+			m_dfeTaps[j] += step * dhist[j];
+
+		//Shift the decision history
+		for(size_t j=ndfe; j>1; j--)
+			dhist[j-1] = dhist[j-2];
+		if(ndfe)
+			dhist[0] = d;
+
+		//Save the equalized sample
+		cap->m_offsets[i] = samples.m_offsets[i];
+		cap->m_durations[i] = samples.m_durations[i];
+		cap->m_samples[i] = y;
+	}
+
+	//Export the converged taps so they can be pasted into a fixed equalizer
+	m_parameters[m_tapExportName].SetStringVal(FormatTaps());
+
+	cap->MarkModifiedFromCpu();
+}
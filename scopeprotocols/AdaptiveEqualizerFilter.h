@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of AdaptiveEqualizerFilter
+ */
+#ifndef AdaptiveEqualizerFilter_h
+#define AdaptiveEqualizerFilter_h
+
+/**
+	@brief Adaptive FFE/DFE equalizer with LMS tap adaptation
+
+	Takes an analog waveform plus a recovered clock, equalizes the symbol-rate sample stream with a feed-forward
+	equalizer and decision feedback equalizer, and adapts both sets of taps toward minimum decision error using
+	sign-based LMS. Tap state persists across acquisitions, so the equalizer keeps converging as new waveforms
+	arrive rather than starting over every trigger. Use ClearSweeps() to restart adaptation from a unit cursor tap.
+
+	The converged taps are exported after every refresh through the read-only "Current Taps" parameter, in a form
+	that can be pasted into fixed equalizers (TappedDelayLineFilter, hardware FFE registers, etc).
+ */
+class AdaptiveEqualizerFilter : public Filter
+{
+public:
+	AdaptiveEqualizerFilter(const std::string& color);
+
+	virtual void Refresh() override;
+	virtual void ClearSweeps() override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	PROTOCOL_DECODER_INITPROC(AdaptiveEqualizerFilter)
+
+	///@brief Returns the current feed-forward tap weights (cursor at the pre-cursor count index)
+	const std::vector<float>& GetFFETaps() const
+	{ return m_ffeTaps; }
+
+	///@brief Returns the current decision-feedback tap weights (most recent decision first)
+	const std::vector<float>& GetDFETaps() const
+	{ return m_dfeTaps; }
+
+protected:
+	void ResetTaps();
+	std::string FormatTaps();
+
+	std::string m_ffeTapCountName;
+	std::string m_ffePrecursorName;
+	std::string m_dfeTapCountName;
+	std::string m_rateName;
+	std::string m_targetName;
+	std::string m_tapExportName;
+
+	///@brief Feed-forward taps, index 0 = earliest pre-cursor
+	std::vector<float> m_ffeTaps;
+
+	///@brief Decision feedback taps, index 0 = most recent past decision
+	std::vector<float> m_dfeTaps;
+};
+
+#endif
@@ -254,3 +254,9 @@ Filter::DataLocation AddFilter::GetInputLocation()
 	//We explicitly manage our input memory and don't care where it is when Refresh() is called
 	return LOC_DONTCARE;
 }
+
+bool AddFilter::IsDeferredSubmitSafe()
+{
+	//The GPU path never reads results back within Refresh(), so the executor may defer our fence wait
+	return true;
+}
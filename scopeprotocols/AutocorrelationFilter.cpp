@@ -37,6 +37,10 @@ using namespace std;
 
 AutocorrelationFilter::AutocorrelationFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_cachedNumPoints(0)
+	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_kernelComputePipeline("shaders/AutocorrelationKernel.spv", 2, sizeof(AutocorrelationKernelArgs))
+	, m_normalizeComputePipeline("shaders/DeEmbedNormalization.spv", 2, sizeof(DeEmbedNormalizationArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
@@ -44,6 +48,18 @@ AutocorrelationFilter::AutocorrelationFilter(const string& color)
 	m_maxDeltaName = "Max offset";
 	m_parameters[m_maxDeltaName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
 	m_parameters[m_maxDeltaName].SetIntVal(1000);
+
+	m_forwardInBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardInBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_forwardOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_forwardOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_reverseOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_reverseOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_kernelBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_kernelBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -68,10 +84,16 @@ string AutocorrelationFilter::GetProtocolName()
 	return "Autocorrelation";
 }
 
+Filter::DataLocation AutocorrelationFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void AutocorrelationFilter::Refresh()
+void AutocorrelationFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOKAndUniformAnalog())
 	{
@@ -93,21 +115,95 @@ void AutocorrelationFilter::Refresh()
 		return;
 	}
 
-	//Set up the output waveform
-	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0, true);
-	cap->PrepareForCpuAccess();
-	din->PrepareForCpuAccess();
-
+	//All lags use the same fixed window of the first (len - range) samples
 	size_t end = len - range;
-	for(size_t delta=1; delta <= range; delta ++)
+
+	//Rather than computing each lag with a separate pass over the input, compute every lag at once as a
+	//cross correlation of that fixed window against the whole input, done in the frequency domain.
+	//Zero pad to the next power of two so the circular convolution can't alias: the largest sample index
+	//any lag touches is (end-1) + range = len-1, which is always less than npoints.
+	const size_t npoints = next_pow2(len);
+	size_t nouts = npoints/2 + 1;
+
+	//Invalidate old vkFFT plan if size has changed
+	if(m_vkConvPlan)
 	{
-		double total = 0;
-		for(size_t i=0; i<end; i++)
-			total += din->m_samples[i] * din->m_samples[i+delta];
+		if(m_vkConvPlan->size() != npoints)
+			m_vkConvPlan = nullptr;
+	}
 
-		cap->m_samples.push_back(total / end);
+	//Allocate buffers if we change point count
+	if(m_cachedNumPoints != npoints)
+	{
+		m_forwardInBuf.resize(npoints);
+		m_forwardOutBuf.resize(2 * nouts);
+		m_reverseOutBuf.resize(npoints);
+		m_kernelBuf.resize(npoints);
+
+		m_cachedNumPoints = npoints;
 	}
 
-	cap->MarkSamplesModifiedFromCpu();
-	SetData(cap, 0);
+	//Set up a new FFT plan
+	if(!m_vkConvPlan)
+		m_vkConvPlan = make_unique<VulkanFFTConvolutionPlan>(npoints, nouts);
+
+	//Set up the output waveform
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0, true);
+	cap->Resize(range);
+
+	//Neither the kernel transform nor the fused convolution normalizes, so the raw sums come back scaled
+	//by npoints^2. Fold the 1/end averaging into the same constant.
+	float scale = 1.0f / (end * (float)npoints * (float)npoints);
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
+	//Build the time-reversed correlation kernel from the first (len - range) input samples.
+	//Unlike a de-embed, the kernel here is derived from the input data itself, so it has to be
+	//re-transformed every refresh.
+	AutocorrelationKernelArgs kargs;
+	kargs.npoints = npoints;
+	kargs.kernlen = end;
+	m_kernelComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_kernelComputePipeline.BindBufferNonblocking(1, m_kernelBuf, cmdBuf, true);
+	m_kernelComputePipeline.Dispatch(cmdBuf, kargs, GetComputeBlockCount(npoints, 64));
+	m_kernelComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_kernelBuf.MarkModifiedFromGpu();
+	m_vkConvPlan->AppendKernelTransform(m_kernelBuf, cmdBuf);
+	m_kernelComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Copy and zero-pad the input as needed
+	WindowFunctionArgs args;
+	args.numActualSamples = len;
+	args.npoints = npoints;
+	args.scale = 0;
+	args.alpha0 = 0;
+	args.alpha1 = 0;
+	args.offsetIn = 0;
+	args.offsetOut = 0;
+	m_rectangularComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_rectangularComputePipeline.BindBufferNonblocking(1, m_forwardInBuf, cmdBuf, true);
+	m_rectangularComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_forwardInBuf.MarkModifiedFromGpu();
+
+	//Forward FFT, complex multiply by the kernel spectrum, and inverse FFT as one fused operation.
+	//Output bin delta now holds the sum of x[i] * x[i+delta] over the fixed window.
+	m_vkConvPlan->AppendConvolution(m_forwardInBuf, m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Extract lags 1 through range and normalize
+	DeEmbedNormalizationArgs nargs;
+	nargs.outlen = range;
+	nargs.istart = 1;
+	nargs.scale = scale;
+	m_normalizeComputePipeline.BindBufferNonblocking(0, m_reverseOutBuf, cmdBuf);
+	m_normalizeComputePipeline.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+	m_normalizeComputePipeline.Dispatch(cmdBuf, nargs, GetComputeBlockCount(range, 64));
+	m_normalizeComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	cap->MarkModifiedFromGpu();
 }
@@ -35,12 +35,19 @@
 #ifndef AutocorrelationFilter_h
 #define AutocorrelationFilter_h
 
+struct AutocorrelationKernelArgs
+{
+	uint32_t npoints;
+	uint32_t kernlen;
+};
+
 class AutocorrelationFilter : public Filter
 {
 public:
 	AutocorrelationFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -50,6 +57,18 @@ public:
 
 protected:
 	std::string m_maxDeltaName;
+
+	size_t m_cachedNumPoints;
+
+	AcceleratorBuffer<float> m_forwardInBuf;
+	AcceleratorBuffer<float> m_forwardOutBuf;
+	AcceleratorBuffer<float> m_reverseOutBuf;
+	AcceleratorBuffer<float> m_kernelBuf;
+
+	ComputePipeline m_rectangularComputePipeline;
+	ComputePipeline m_kernelComputePipeline;
+	ComputePipeline m_normalizeComputePipeline;
+	std::unique_ptr<VulkanFFTConvolutionPlan> m_vkConvPlan;
 };
 
 #endif
@@ -52,7 +52,7 @@ AverageFilter::~AverageFilter()
 {
 }
 
-void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
+void AverageFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	auto din = GetInput(0);
 	if(!din)
@@ -75,7 +75,8 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 		m_streams[3].m_value = m_pastCount;
 	}
 
-	//If input is a vector, process each sample
+	//If input is a vector, reduce it in a single fused pass (on the GPU if possible),
+	//shared with any sibling min/max/average filters watching the same input
 	else
 	{
 		auto data = din.GetData();
@@ -84,25 +85,14 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 			SetData(nullptr, 0);
 			return;
 		}
-		auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
-		auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
-		double total = 0;
 		size_t len = data->size();
 
-		if(udata)
-		{
-			for(auto sample : udata->m_samples)
-				total += sample;
-		}
-		else if(sdata)
-		{
-			for(auto sample : sdata->m_samples)
-				total += sample;
-		}
+		auto stats = GetOrComputeReduction(data, m_statsEngine, cmdBuf, queue);
+
 		m_pastCount += len;
-		m_pastSum += total;
+		m_pastSum += stats.m_sum;
 
-		m_streams[0].m_value = total / len;
+		m_streams[0].m_value = stats.m_sum / len;
 		m_streams[1].m_value = m_pastSum / m_pastCount;
 		m_streams[2].m_value = m_pastCount;
 		m_streams[3].m_value ++;
@@ -111,7 +101,8 @@ void AverageFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 
 Filter::DataLocation AverageFilter::GetInputLocation()
 {
-	return LOC_CPU;
+	//We can process the input wherever it currently is
+	return LOC_DONTCARE;
 }
 
 string AverageFilter::GetProtocolName()
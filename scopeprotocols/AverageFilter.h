@@ -55,6 +55,9 @@ public:
 protected:
 	double m_pastSum;
 	int64_t m_pastCount;
+
+	///@brief GPU reduction engine for summing vector inputs
+	StatisticsEngine m_statsEngine;
 };
 
 #endif
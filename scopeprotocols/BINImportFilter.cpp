@@ -37,6 +37,9 @@ using namespace std;
 
 BINImportFilter::BINImportFilter(const string& color)
 	: ImportFilter(color)
+	, m_samplesLoaded(true)
+	, m_pendingTimestamp(0)
+	, m_pendingStartFemtoseconds(0)
 {
 	m_fpname = "BIN File";
 	m_parameters[m_fpname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
@@ -56,26 +59,42 @@ string BINImportFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Walks the file headers and sets up lazy loading of the sample data
+
+	Only the file, waveform and data headers are read here (a few hundred bytes no matter how big the capture is),
+	seeking past the sample data and checkpointing each buffer's offset. The samples themselves are materialized
+	by the first Refresh() that actually evaluates this filter, so opening a session referencing many large .bin
+	files is fast.
+ */
 void BINImportFilter::OnFileNameChanged()
 {
 	//Wipe anything we may have had in the past
 	ClearStreams();
+	m_waveforms.clear();
+	m_samplesLoaded = true;
 
 	auto fname = m_parameters[m_fpname].ToString();
 	if(fname.empty())
 		return;
 
 	//Set waveform timestamp to file timestamp
-	time_t timestamp = 0;
-	int64_t fs = 0;
-	GetTimestampOfFile(fname, timestamp, fs);
+	GetTimestampOfFile(fname, m_pendingTimestamp, m_pendingStartFemtoseconds);
 
-	string f = ReadFile(fname);
-	uint32_t fpos = 0;
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open BIN file \"%s\"\n", fname.c_str());
+		return;
+	}
 
 	FileHeader fh;
-	f.copy((char*)&fh, sizeof(FileHeader), fpos);
-	fpos += sizeof(FileHeader);
+	if(1 != fread(&fh, sizeof(FileHeader), 1, fp))
+	{
+		LogError("Failed to read file header\n");
+		fclose(fp);
+		return;
+	}
 
 	//Get vendor from file signature
 	string vendor;
@@ -91,6 +110,7 @@ void BINImportFilter::OnFileNameChanged()
 
 		default:
 			LogError("Unknown vendor in file header");
+			fclose(fp);
 			return;
 	}
 	LogDebug("Vendor:    %s\n", vendor.c_str());
@@ -106,9 +126,15 @@ void BINImportFilter::OnFileNameChanged()
 		LogIndenter li_w;
 
 		//Parse waveform header
-		WaveHeader wh;
-		f.copy((char*)&wh, sizeof(WaveHeader), fpos);
-		fpos += sizeof(WaveHeader);
+		WaveformInfo info;
+		auto& wh = info.m_waveHeader;
+		if(1 != fread(&wh, sizeof(WaveHeader), 1, fp))
+		{
+			LogError("Failed to read waveform header\n");
+			fclose(fp);
+			m_waveforms.clear();
+			return;
+		}
 
 		//TODO: make this metadata readable somewhere via properties etc
 		if (i == 0)
@@ -129,10 +155,12 @@ void BINImportFilter::OnFileNameChanged()
 			serial.assign(wh.hardware + idx + 1, 24 - idx);
 		}
 
-		//Create output stream
+		//Name the waveform
 		string name = wh.label;
 		if(name == "")
 			name = string("CH") + to_string(i+1);
+		info.m_name = name;
+		info.m_firstStream = m_streams.size();
 
 		LogDebug("Samples:      %i\n", wh.samples);
 		LogDebug("Buffers:      %i\n", wh.buffers);
@@ -147,75 +175,156 @@ void BINImportFilter::OnFileNameChanged()
 		LogDebug("Label:        %s\n", name.c_str());
 		LogDebug("Serial:       %s\n\n", serial.c_str());
 
-		//Grab the initial data header and figure out what it is
-		DataHeader dh;
-		f.copy((char*)&dh, sizeof(DataHeader), fpos);
+		//Create the output stream(s)
+		//Digital logic waveforms get 8 streams of digital data, one per bit
+		if(wh.type == 6)
+		{
+			for(size_t j=0; j<8; j++)
+				AddStream(Unit(Unit::UNIT_VOLTS), name + "[" + to_string(j) + "]", Stream::STREAM_TYPE_DIGITAL);
+		}
+		else
+			AddStream(Unit(Unit::UNIT_VOLTS), name, Stream::STREAM_TYPE_ANALOG);
+
+		//Checkpoint the data headers and buffer offsets, then seek past the sample data
+		for(size_t j=0; j<wh.buffers; j++)
+		{
+			LogDebug("Buffer %i:\n", (int)j+1);
+			LogIndenter li_b;
+
+			//Parse waveform data header
+			DataHeader dh;
+			if(1 != fread(&dh, sizeof(DataHeader), 1, fp))
+			{
+				LogError("Failed to read data header\n");
+				fclose(fp);
+				m_waveforms.clear();
+				return;
+			}
+
+			LogDebug("Data Type:      %i\n", dh.type);
+			LogDebug("Sample depth:   %i bits\n", dh.depth*8);
+			LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
+
+			info.m_dataHeaders.push_back(dh);
+			info.m_dataOffsets.push_back(ftell(fp));
+			fseek(fp, dh.length, SEEK_CUR);
+		}
+
+		m_waveforms.push_back(info);
+	}
+	fclose(fp);
+
+	//Save the lazy load state; the samples are materialized by the first Refresh() that evaluates us
+	m_pendingFileName = fname;
+	m_samplesLoaded = false;
+
+	m_outputsChangedSignal.emit();
+}
+
+/**
+	@brief Materializes the sample data on first use
+ */
+void BINImportFilter::Refresh()
+{
+	//Waveform data is static once loaded; the only work is faulting in the lazy load
+	if(!m_samplesLoaded)
+		LoadSamples();
+}
+
+/**
+	@brief Reads the file's sample data into the output waveforms, seeking directly to the checkpointed offsets
+ */
+void BINImportFilter::LoadSamples()
+{
+	//One shot: even if loading fails, don't retry every graph evaluation
+	m_samplesLoaded = true;
+
+	if(m_waveforms.empty())
+		return;
+
+	FILE* fp = fopen(m_pendingFileName.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open BIN file \"%s\"\n", m_pendingFileName.c_str());
+		return;
+	}
+
+	double start = GetTime();
+
+	//Chunk size for reads staged through a temporary buffer, in samples
+	const size_t chunkSamples = 4 * 1024 * 1024;
+
+	for(size_t i=0; i<m_waveforms.size(); i++)
+	{
+		auto& info = m_waveforms[i];
+		auto& wh = info.m_waveHeader;
+		size_t nbuffers = info.m_dataOffsets.size();
+		size_t total = nbuffers * wh.samples;
 
-		//Digital logic waveform
+		//Digital logic waveform: unpack each sample byte into 8 streams
 		if(wh.type == 6)
 		{
-			//Create 8 streams of digital data
 			vector<UniformDigitalWaveform*> wfms;
 			for(size_t j=0; j<8; j++)
 			{
-				AddStream(Unit(Unit::UNIT_VOLTS), name + "[" + to_string(j) + "]", Stream::STREAM_TYPE_DIGITAL);
-
 				auto wfm = new UniformDigitalWaveform;
 				wfm->m_timescale = wh.interval * FS_PER_SECOND;
-				wfm->m_startTimestamp = timestamp;
-				wfm->m_startFemtoseconds = fs;
+				wfm->m_startTimestamp = m_pendingTimestamp;
+				wfm->m_startFemtoseconds = m_pendingStartFemtoseconds;
 				wfm->m_triggerPhase = 0;
-				SetData(wfm, m_streams.size()-1);
-				wfms.push_back(wfm);
-
+				SetData(wfm, info.m_firstStream + j);
+				wfm->Resize(total);
 				wfm->PrepareForCpuAccess();
+				wfms.push_back(wfm);
 			}
 
-			for(size_t j=0; j<wh.buffers; j++)
+			for(size_t j=0; j<nbuffers; j++)
 			{
-				LogDebug("Buffer %i:\n", (int)j+1);
-				LogIndenter li_b;
-
-				//Parse waveform data header
-				f.copy((char*)&dh, sizeof(DataHeader), fpos);
-				fpos += sizeof(DataHeader);
+				auto& dh = info.m_dataHeaders[j];
+				if( (dh.type != 5) && (dh.type != 6) )
+				{
+					LogError("Invalid buffer type for logic waveform\n");
+					fclose(fp);
+					return;
+				}
 
-				LogDebug("Data Type:      %i\n", dh.type);
-				LogDebug("Sample depth:   %i bits\n", dh.depth*8);
-				LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
+				fseek(fp, info.m_dataOffsets[j], SEEK_SET);
+				size_t base = j * wh.samples;
 
-				for(size_t k=0; k<wh.samples; k++)
+				//Read the raw samples in chunks so we never need a second copy of a huge capture in RAM
+				vector<uint8_t> buf(min((size_t)wh.samples, chunkSamples) * dh.depth);
+				for(size_t k=0; k<wh.samples; )
 				{
-					uint8_t s = -1;
-
-					//Logic samples (counts 32-bit float data waveforms)
-					if (dh.type == 5)
-					{
-						//Do not violate strict aliasing, compiler will optimize out the memcpy
-						float val;
-						memcpy(&val, f.c_str() + fpos, sizeof(float));
-						s = static_cast<uint8_t>(val);
-					}
-					//Logic samples (digital unsigned 8-bit character data)
-					else if (dh.type == 6)
-					{
-						s = *(uint8_t*)(f.c_str() + fpos);
-					}
-					else
+					size_t n = min(chunkSamples, (size_t)wh.samples - k);
+					if(n != fread(&buf[0], dh.depth, n, fp))
 					{
-						LogDebug("Invalid buffer type for logic waveform\n");
+						LogError("Failed to read sample data\n");
+						fclose(fp);
 						return;
 					}
 
-					for(size_t m=0; m<8; m++)
+					for(size_t m=0; m<n; m++)
 					{
-						if(s & (1 << m) )
-							wfms[m]->m_samples.push_back(true);
+						uint8_t s;
+
+						//Logic samples (counts 32-bit float data waveforms)
+						if(dh.type == 5)
+						{
+							//Do not violate strict aliasing, compiler will optimize out the memcpy
+							float val;
+							memcpy(&val, &buf[m*dh.depth], sizeof(float));
+							s = static_cast<uint8_t>(val);
+						}
+
+						//Logic samples (digital unsigned 8-bit character data)
 						else
-							wfms[m]->m_samples.push_back(false);
+							s = buf[m*dh.depth];
+
+						for(size_t b=0; b<8; b++)
+							wfms[b]->m_samples[base + k + m] = (s & (1 << b)) ? true : false;
 					}
 
-					fpos += dh.depth;
+					k += n;
 				}
 			}
 
@@ -226,46 +335,64 @@ void BINImportFilter::OnFileNameChanged()
 		//Analog waveform
 		else
 		{
-			//Create the stream and a waveform for it
-			AddStream(Unit(Unit::UNIT_VOLTS), name, Stream::STREAM_TYPE_ANALOG);
-
 			auto wfm = new UniformAnalogWaveform;
 			wfm->m_timescale = wh.interval * FS_PER_SECOND;
-			wfm->m_startTimestamp = timestamp;
-			wfm->m_startFemtoseconds = fs;
+			wfm->m_startTimestamp = m_pendingTimestamp;
+			wfm->m_startFemtoseconds = m_pendingStartFemtoseconds;
 			wfm->m_triggerPhase = 0;
+			SetData(wfm, info.m_firstStream);
+			wfm->Resize(total);
 			wfm->PrepareForCpuAccess();
-			SetData(wfm, m_streams.size()-1);
 
-			for(size_t j=0; j<wh.buffers; j++)
+			for(size_t j=0; j<nbuffers; j++)
 			{
-				LogDebug("Buffer %i:\n", (int)j+1);
-				LogIndenter li_b;
-
-				//Parse waveform data header
-				f.copy((char*)&dh, sizeof(DataHeader), fpos);
-				fpos += sizeof(DataHeader);
+				auto& dh = info.m_dataHeaders[j];
+				fseek(fp, info.m_dataOffsets[j], SEEK_SET);
+				size_t base = j * wh.samples;
 
-				LogDebug("Data Type:      %i\n", dh.type);
-				LogDebug("Sample depth:   %i bits\n", dh.depth*8);
-				LogDebug("Buffer length:  %i KB\n\n\n", dh.length/1024);
+				//Fast path: float32 samples can be read directly into the output buffer
+				if(dh.depth == sizeof(float))
+				{
+					if(wh.samples != fread(&wfm->m_samples[base], sizeof(float), wh.samples, fp))
+					{
+						LogError("Failed to read sample data\n");
+						fclose(fp);
+						return;
+					}
+				}
 
-				//Float samples (analog waveforms)
-				for(size_t k=0; k<wh.samples; k++)
+				//Other depths: stage through a temporary buffer and take the float at the start of each sample
+				else
 				{
-					//Do not violate strict aliasing, compiler will optimize out the memcpy
-					float* sample_f;
-					memcpy(&sample_f, f.c_str() + fpos, sizeof(float));
-					wfm->m_samples.push_back(*sample_f);
-					fpos += dh.depth;
+					vector<uint8_t> buf(min((size_t)wh.samples, chunkSamples) * dh.depth);
+					for(size_t k=0; k<wh.samples; )
+					{
+						size_t n = min(chunkSamples, (size_t)wh.samples - k);
+						if(n != fread(&buf[0], dh.depth, n, fp))
+						{
+							LogError("Failed to read sample data\n");
+							fclose(fp);
+							return;
+						}
+
+						for(size_t m=0; m<n; m++)
+						{
+							//Do not violate strict aliasing, compiler will optimize out the memcpy
+							float val;
+							memcpy(&val, &buf[m*dh.depth], sizeof(float));
+							wfm->m_samples[base + k + m] = val;
+						}
+
+						k += n;
+					}
 				}
 			}
 
 			wfm->MarkModifiedFromCpu();
+			AutoscaleVertical(info.m_firstStream);
 		}
-
-		AutoscaleVertical(i);
 	}
+	fclose(fp);
 
-	m_outputsChangedSignal.emit();
+	LogTrace("Materialized %zu waveforms in %.2f ms\n", m_waveforms.size(), (GetTime() - start) * 1000);
 }
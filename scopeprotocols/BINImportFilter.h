@@ -40,6 +40,8 @@ class BINImportFilter : public ImportFilter
 public:
 	BINImportFilter(const std::string& color);
 
+	virtual void Refresh() override;
+
 	static std::string GetProtocolName();
 
 	PROTOCOL_DECODER_INITPROC(BINImportFilter)
@@ -86,6 +88,44 @@ public:
 
 protected:
 	void OnFileNameChanged();
+	void LoadSamples();
+
+	//Lazy load state: OnFileNameChanged() only walks the headers (seeking past the sample data),
+	//samples are materialized by the first Refresh() that actually evaluates this filter
+
+	///@brief Parse checkpoint for one waveform in the file: header plus the offsets of its data buffers
+	struct WaveformInfo
+	{
+		///@brief Waveform header
+		WaveHeader m_waveHeader;
+
+		///@brief Display name of the waveform
+		std::string m_name;
+
+		///@brief Index of our first output stream for this waveform (digital waveforms have 8)
+		size_t m_firstStream;
+
+		///@brief Data header of each buffer
+		std::vector<DataHeader> m_dataHeaders;
+
+		///@brief File offset of each buffer's sample data
+		std::vector<int64_t> m_dataOffsets;
+	};
+
+	///@brief True if the output waveforms hold the current file's samples
+	bool m_samplesLoaded;
+
+	///@brief Path of the file the lazy load state refers to
+	std::string m_pendingFileName;
+
+	///@brief Timestamp of the file
+	time_t m_pendingTimestamp;
+
+	///@brief Fractional second timestamp of the file
+	int64_t m_pendingStartFemtoseconds;
+
+	///@brief Parse checkpoints for each waveform in the file
+	std::vector<WaveformInfo> m_waveforms;
 };
 
 #endif
@@ -71,7 +71,7 @@ string BandwidthMeasurement::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void BandwidthMeasurement::Refresh()
+void BandwidthMeasurement::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Set up input
 	auto in = GetInput(0).GetData();
@@ -83,22 +83,49 @@ void BandwidthMeasurement::Refresh()
 		return;
 	}
 	size_t len = in->size();
-	PrepareForCpuAccess(sin, uin);
 
-	int64_t bw = 0;
 	float threshold = m_parameters[m_reference].GetFloatVal() - 3;
-	for(size_t i=0; i < len; i++)
+
+	//Uniform spectra (the common post-FFT case) can stay GPU resident: find the first bin below the
+	//threshold with a GPU reduction, then convert the index to a frequency on the host.
+	//If BW is off the end of the measurement we report the upper bound.
+	//TODO: interpolate
+	if(uin && (len != 0))
 	{
-		auto cur = GetValue(sin, uin, i);
+		size_t idx = m_primitives.FindFirstBelow(uin->m_samples, threshold, cmdBuf, queue);
+		if(idx >= len)
+			idx = len - 1;
+		m_streams[0].m_value = ::GetOffsetScaled(uin, idx);
+	}
+
+	//Sparse input: scan on the CPU since the offsets are needed anyway
+	else if(sin)
+	{
+		sin->PrepareForCpuAccess();
+
+		int64_t bw = 0;
+		for(size_t i=0; i < len; i++)
+		{
+			auto cur = sin->m_samples[i];
 
-		//Update live each iteration
-		//This way, if BW is off the end of the measurement we will report the upper bound
-		bw = GetOffsetScaled(sin, uin, i);
+			//Update live each iteration
+			//This way, if BW is off the end of the measurement we will report the upper bound
+			bw = ::GetOffsetScaled(sin, i);
 
-		//TODO: interpolate
-		if(cur < threshold)
-			break;
+			//TODO: interpolate
+			if(cur < threshold)
+				break;
+		}
+
+		m_streams[0].m_value = bw;
 	}
 
-	m_streams[0].m_value = bw;
+	else
+		m_streams[0].m_value = 0;
+}
+
+Filter::DataLocation BandwidthMeasurement::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
 }
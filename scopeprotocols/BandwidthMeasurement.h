@@ -40,7 +40,8 @@ class BandwidthMeasurement : public Filter
 public:
 	BandwidthMeasurement(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -50,6 +51,8 @@ public:
 
 protected:
 	std::string m_reference;
+
+	GpuPrimitives m_primitives;
 };
 
 #endif
@@ -78,7 +78,6 @@ void BaseMeasurement::Refresh()
 		SetData(NULL, 0);
 		return;
 	}
-	size_t len = in->size();
 	PrepareForCpuAccess(sin, uin);
 
 	//Make a histogram of the waveform
@@ -111,9 +110,28 @@ void BaseMeasurement::Refresh()
 	cap->m_timescale = 1;
 	cap->PrepareForCpuAccess();
 
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sin)
+		InnerLoop(sin, cap, mid, global_base, range * 0.1, vmin);
+	else
+		InnerLoop(uin, cap, mid, global_base, range * 0.1, vmin);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Per-cycle base voltage loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and value helpers resolve at compile
+	time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void BaseMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float mid, float global_base, float delta, float vmin)
+{
+	size_t len = din->size();
+
 	float last = vmin;
 	int64_t tfall = 0;
-	float delta = range * 0.1;
 
 	float fmax = -FLT_MAX;
 	float fmin =  FLT_MAX;
@@ -125,8 +143,8 @@ void BaseMeasurement::Refresh()
 	for(size_t i=0; i < len; i++)
 	{
 		//Wait for a rising edge (end of the low period)
-		auto cur = GetValue(sin, uin, i);
-		auto tnow = GetOffsetScaled(sin, uin, i);
+		auto cur = din->m_samples[i];
+		auto tnow = GetOffsetScaled(din, i);
 
 		//Find falling edge
 		if( (cur < mid) && (last >= mid) )
@@ -182,6 +200,4 @@ void BaseMeasurement::Refresh()
 
 		last = cur;
 	}
-
-	cap->MarkModifiedFromCpu();
 }
@@ -47,6 +47,10 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
 	PROTOCOL_DECODER_INITPROC(BaseMeasurement)
+
+protected:
+	template<class W>
+	void InnerLoop(W* din, SparseAnalogWaveform* cap, float mid, float global_base, float delta, float vmin);
 };
 
 #endif
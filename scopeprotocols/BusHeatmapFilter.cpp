@@ -163,9 +163,17 @@ void BusHeatmapFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Q
 	auto p = buf.GetCpuPointer();
 	memset(p, 0, len*sizeof(float));
 
-	//Integrate packets
+	//Accumulate raw counts in a scratch buffer, so we can publish normalized snapshots along the way
+	//without losing the running totals
+	m_counts.resize(len);
+	memset(&m_counts[0], 0, len*sizeof(float));
+
+	//Integrate packets, streaming a partial heatmap to the display every so often so deep captures
+	//start showing data long before the full pass completes
 	auto nin = din->m_offsets.size();
 	float nmax = 0;
+	const size_t publishInterval = 1024 * 1024;
+	size_t nextPublish = publishInterval;
 	for(size_t i=0; i<nin; i++)
 	{
 		//Only look at CAN ID packets, ignore anything else
@@ -182,14 +190,26 @@ void BusHeatmapFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Q
 			continue;
 
 		//Increment the bin
-		auto f = p[ybin*nblocks + xbin] ++;
+		auto f = m_counts[ybin*nblocks + xbin] ++;
 		nmax = max(nmax, f);
+
+		//Publish a normalized snapshot of what we've integrated so far
+		if( (i >= nextPublish) && (nmax > 0) )
+		{
+			nextPublish += publishInterval;
+
+			float norm = 1.0 / nmax;
+			for(size_t j=0; j<len; j++)
+				p[j] = m_counts[j] * norm;
+			cap->MarkModifiedFromCpu();
+			PublishPartialResult();
+		}
 	}
 
-	//Normalize
+	//Normalize the final output
 	float norm = 1.0 / nmax;
 	for(size_t i=0; i<len; i++)
-		p[i] *= norm;
+		p[i] = m_counts[i] * norm;
 
 	//Done
 	cap->MarkModifiedFromCpu();
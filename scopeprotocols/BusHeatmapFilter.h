@@ -56,6 +56,9 @@ protected:
 	std::string m_maxAddress;
 	std::string m_yBinSize;
 	std::string m_xBinSize;
+
+	///@brief Scratch buffer of raw bin counts, so partial snapshots can be normalized without losing the counts
+	std::vector<float> m_counts;
 };
 
 #endif
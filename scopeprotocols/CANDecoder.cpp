@@ -148,7 +148,6 @@ void CANDecoder::Refresh()
 	char tmp[128];
 
 	// CRC (http://esd.cs.ucr.edu/webres/can20.pdf page 13)
-	const uint16_t crc_poly = 0x4599;
 	uint16_t crc = 0;
 
 	for(size_t i = 0; i < len; i++)
@@ -243,15 +242,8 @@ void CANDecoder::Refresh()
 				current_field |= 1;
 			nbit ++;
 
-			if (state != STATE_CRC){
-				uint16_t crc_bit_14 = (crc >> 14) & 0x1;
-				uint16_t crc_nxt = sampled_value ^ crc_bit_14;
-				crc = crc << 1;
-
-				if (crc_nxt){
-					crc = crc ^ crc_poly;
-				}
-			}
+			if (state != STATE_CRC)
+				crc = CRC15CANStep(crc, sampled_value);
 
 			switch(state)
 			{
@@ -266,7 +258,7 @@ void CANDecoder::Refresh()
 				case STATE_SOF:
 
 					//Start a new packet
-					pack = new Packet;
+					pack = AllocatePacket();
 					pack->m_offset = off * din->m_timescale;
 					pack->m_len = 0;
 					m_packets.push_back(pack);
@@ -29,6 +29,15 @@
 
 #include "../scopehal/scopehal.h"
 #include "CSVImportFilter.h"
+#include <atomic>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -66,6 +75,31 @@ string CSVImportFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Returns the bounds of the line starting at pos (excluding any trailing CR), advancing pos past the newline
+ */
+static void GetLineBounds(const char* data, size_t end, size_t& pos, const char*& ls, const char*& le)
+{
+	ls = data + pos;
+	size_t i = pos;
+	while( (i < end) && (data[i] != '\n') )
+		i++;
+	le = data + i;
+	if( (le > ls) && (le[-1] == '\r') )
+		le--;
+	pos = (i < end) ? (i + 1) : end;
+}
+
+///@brief Returns true if the line is blank or a comment
+static bool IsBlankOrComment(const char* ls, const char* le)
+{
+	while( (ls < le) && isspace(static_cast<unsigned char>(*ls)) )
+		ls++;
+	if(ls == le)
+		return true;
+	return (*ls == '#');
+}
+
 void CSVImportFilter::OnFileNameChanged()
 {
 	auto fname = m_parameters[m_fpname].ToString();
@@ -83,38 +117,92 @@ void CSVImportFilter::OnFileNameChanged()
 	int64_t fs = 0;
 	GetTimestampOfFile(fname, timestamp, fs);
 
-	FILE* fp = fopen(fname.c_str(), "r");
-	if(!fp)
+	//Map (or, if that fails, read) the entire file so we can parse it in parallel
+	const char* data = nullptr;
+	size_t len = 0;
+	vector<char> filebuf;
+#ifndef _WIN32
+	void* mapping = MAP_FAILED;
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd >= 0)
 	{
-		LogError("Couldn't open CSV file \"%s\"\n", fname.c_str());
-		return;
+		struct stat st;
+		if( (0 == fstat(fd, &st)) && (st.st_size > 0) )
+		{
+			len = st.st_size;
+			mapping = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapping != MAP_FAILED)
+				data = reinterpret_cast<const char*>(mapping);
+		}
+		close(fd);
+	}
+#endif
+	if(!data)
+	{
+		FILE* fp = fopen(fname.c_str(), "rb");
+		if(!fp)
+		{
+			LogError("Couldn't open CSV file \"%s\"\n", fname.c_str());
+			return;
+		}
+		fseek(fp, 0, SEEK_END);
+		len = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		filebuf.resize(len);
+		if( (len > 0) && (len != fread(&filebuf[0], 1, len, fp)) )
+		{
+			LogError("Failed to read CSV file \"%s\"\n", fname.c_str());
+			fclose(fp);
+			return;
+		}
+		fclose(fp);
+		data = filebuf.data();
 	}
 
+	ImportTextBuffer(data, len, timestamp, fs);
+
+#ifndef _WIN32
+	if(mapping != MAP_FAILED)
+		munmap(mapping, len);
+#endif
+}
+
+/**
+	@brief Parses an in-memory CSV file image into output waveforms.
+
+	A short serial prologue handles comments, metadata, the optional header row, and column type detection. The bulk
+	of the file is then split at newline boundaries into one chunk per core and parsed in parallel, each worker
+	writing directly into the output waveform buffers.
+ */
+void CSVImportFilter::ImportTextBuffer(const char* data, size_t len, time_t timestamp, int64_t fs)
+{
 	ClearStreams();
 
-	//Read the file
+	bool xAxisIsSeconds = (m_parameters[m_xunit].GetIntVal() == Unit::UNIT_FS);
+
+	//Serial prologue: handle comments, metadata, and the optional header row, stopping at the first data row
 	vector<string> names;
-	vector< vector<string> > lines;
-	vector<int64_t> timestamps;
-	char line[1024];
-	bool digilentFormat;
-	size_t nrow = 0;
-	size_t ncols = 0;
-	while(!feof(fp))
+	bool digilentFormat = false;
+	size_t pos = 0;
+	size_t dataStart = len;
+	size_t nfields = 0;
+	while(pos < len)
 	{
-		if(!fgets(line, sizeof(line), fp))
-			break;
-
-		nrow ++;
+		size_t linestart = pos;
+		const char* ls;
+		const char* le;
+		GetLineBounds(data, len, pos, ls, le);
 
 		//Discard blank lines
-		string s = Trim(line);
-		if(s.empty())
+		while( (ls < le) && isspace(static_cast<unsigned char>(*ls)) )
+			ls++;
+		if(ls == le)
 			continue;
 
 		//If the line starts with a #, it's a comment. Discard it, but save timestamp metadata if present
-		if(s[0] == '#')
+		if(*ls == '#')
 		{
+			string s(ls, le);
 			if(s == "#Digilent WaveForms Oscilloscope Acquisition")
 			{
 				digilentFormat = true;
@@ -164,124 +252,161 @@ void CSVImportFilter::OnFileNameChanged()
 			continue;
 		}
 
-		//Parse into 2D vector of timestamps and strings
-		string tmp;
-		bool foundTimestamp = false;
-		vector<string> fields;
+		//First non-comment row: see if it's a header row
 		bool headerRow = false;
-		for(size_t i=0; i<s.length(); i++)
+		for(const char* p = ls; p < le; p++)
 		{
-			//End of field
-			if( (s[i] == ',') || (s[i] == '\n') )
+			auto c = *p;
+			if(	!isdigit(c) && !isspace(static_cast<unsigned char>(c)) &&
+				(c != ',') && (c != '.') && (c != '-') && (c != 'e') && (c != '+'))
 			{
-				//If this is the first row, check if it's numeric
-				if(names.empty() && timestamps.empty())
-				{
-					//See if it's a header row
-					for(size_t j=0; (j<sizeof(line)) && (line[j] != '\0'); j++)
-					{
-						auto c = line[j];
-						if(	!isdigit(c) && !isspace(c) &&
-							(c != ',') && (c != '.') && (c != '-') && (c != 'e') && (c != '+'))
-						{
-							headerRow = true;
-							LogTrace("Found header row: %s\n", line);
-							break;
-						}
-					}
+				headerRow = true;
+				break;
+			}
+		}
 
-					//Save the header values
-					if(headerRow)
-						fields.push_back(tmp);
-				}
+		if(headerRow)
+		{
+			LogTrace("Found header row: %.*s\n", static_cast<int>(le - ls), ls);
 
-				//Load timestamp
-				if(!foundTimestamp)
+			//Split into column names, discarding the name of the timestamp column
+			string tmp;
+			vector<string> fields;
+			for(const char* p = ls; p < le; p++)
+			{
+				if(*p == ',')
 				{
-					foundTimestamp = true;
-
-					//Parse time to a float and convert to fs
-					if(m_parameters[m_xunit].GetIntVal() == Unit::UNIT_FS)
-					{
-						double timeSec;
-						if(tmp.find("e") == string::npos)
-							sscanf(tmp.c_str(), "%lf", &timeSec);
-						else
-							sscanf(tmp.c_str(), "%le", &timeSec);
-						timestamps.push_back(FS_PER_SECOND * timeSec);
-					}
-
-					//other units are as-is
-					else
-						timestamps.push_back(stoll(tmp));
+					fields.push_back(tmp);
+					tmp = "";
 				}
-
-				//Data field. Save it
 				else
-					fields.push_back(tmp);
-				tmp = "";
+					tmp += *p;
 			}
-
-			//Add to field
-			else
-				tmp += s[i];
-		}
-		if(tmp != "")
-			fields.push_back(tmp);
-
-		//Header row gets special treatment
-		if(headerRow)
-		{
-			//delete name of timestamp column
+			if(tmp != "")
+				fields.push_back(tmp);
 			fields.erase(fields.begin());
-
 			names = fields;
 			continue;
 		}
 
-		//Sanity check field count
-		if(ncols == 0)
-			ncols = fields.size();
-		else if(ncols != fields.size())
+		//First data row: count fields to get the column count, then hand off to the parallel parser
+		nfields = 1;
+		for(const char* p = ls; p < le; p++)
 		{
-			LogError("Malformed file (line %zu contains %zu fields, but file started with %zu fields)\n",
-				nrow, fields.size(), ncols);
-			break;
+			if(*p == ',')
+				nfields++;
 		}
+		dataStart = linestart;
+		break;
+	}
 
-		lines.push_back(fields);
+	size_t ncols = (nfields > 0) ? (nfields - 1) : 0;
+	if( (ncols == 0) || (dataStart >= len) )
+	{
+		LogTrace("No data rows found\n");
+		return;
+	}
+
+	//Figure out if channels are analog or digital from the first 10 data rows
+	//Assume digital, then change to analog if we see anything other than a 0/1
+	vector<bool> digital(ncols, true);
+	{
+		size_t p = dataStart;
+		size_t nrowsChecked = 0;
+		while( (p < len) && (nrowsChecked < 10) )
+		{
+			const char* ls;
+			const char* le;
+			GetLineBounds(data, len, p, ls, le);
+			if(IsBlankOrComment(ls, le))
+				continue;
+			nrowsChecked++;
+
+			size_t col = 0;
+			const char* fstart = ls;
+			for(const char* q = ls; q <= le; q++)
+			{
+				if( (q == le) || (*q == ',') )
+				{
+					if( (col >= 1) && ((col - 1) < ncols) )
+					{
+						if( ((q - fstart) != 1) || ( (*fstart != '0') && (*fstart != '1') ) )
+							digital[col - 1] = false;
+					}
+					col++;
+					fstart = q + 1;
+				}
+			}
+		}
+	}
+
+	//Split the data region into per-thread chunks, aligned to newline boundaries
+	size_t datalen = len - dataStart;
+	size_t nthreads = thread::hardware_concurrency();
+	if(nthreads == 0)
+		nthreads = 1;
+	//No point spinning up a lot of threads for a small file
+	nthreads = min(nthreads, max(static_cast<size_t>(1), datalen / (1024 * 1024)));
+	vector<size_t> bounds;
+	bounds.push_back(dataStart);
+	for(size_t t=1; t<nthreads; t++)
+	{
+		size_t p = dataStart + (datalen * t) / nthreads;
+		while( (p < len) && (data[p] != '\n') )
+			p++;
+		if(p < len)
+			p++;
+		bounds.push_back(max(p, bounds[t-1]));
 	}
+	bounds.push_back(len);
+
+	//First parallel pass: count the data rows in each chunk, so we can pre-size the output waveforms and give
+	//each worker a disjoint row range to write to
+	vector<size_t> chunkRows(nthreads, 0);
+	{
+		vector<thread> threads;
+		for(size_t t=0; t<nthreads; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				size_t n = 0;
+				size_t p = bounds[t];
+				while(p < bounds[t+1])
+				{
+					const char* ls;
+					const char* le;
+					GetLineBounds(data, bounds[t+1], p, ls, le);
+					if(!IsBlankOrComment(ls, le))
+						n++;
+				}
+				chunkRows[t] = n;
+			});
+		}
+		for(auto& th : threads)
+			th.join();
+	}
+	vector<size_t> rowStart(nthreads, 0);
+	size_t rows = 0;
+	for(size_t t=0; t<nthreads; t++)
+	{
+		rowStart[t] = rows;
+		rows += chunkRows[t];
+	}
+	LogTrace("Initial parsing completed, %zu rows, %zu columns, %zu names\n", rows, ncols, names.size());
 
 	//Assign default names to channels if there's no header row or not enough names
-	LogTrace("Initial parsing completed, %zu lines, %zu columns, %zu names, %zu timestamps\n",
-		lines.size(), ncols, names.size(), timestamps.size());
 	for(size_t i=0; i<ncols; i++)
 	{
 		if(names.size() <= i)
 			names.push_back(string("Field") + to_string(i));
 	}
 
-	//Figure out if channels are analog or digital and create output streams/waveforms
+	//Create output streams/waveforms
 	vector<SparseDigitalWaveform*> digwaves;
 	vector<SparseAnalogWaveform*> anwaves;
 	for(size_t i=0; i<ncols; i++)
 	{
-		LogIndenter li2;
-
-		//Assume digital, then change to analog if we see anything other than a 0/1 in the first 10 lines
-		bool digital = true;
-		for(size_t j=0; j<lines.size() && j<10; j++)
-		{
-			string field = lines[j][i];
-			if( (field != "0") && (field != "1") )
-			{
-				digital = false;
-				break;
-			}
-		}
-
-		//Create the output stream
-		if(digital)
+		if(digital[i])
 		{
 			AddStream(Unit(Unit::UNIT_COUNTS), names[i], Stream::STREAM_TYPE_DIGITAL);
 
@@ -290,7 +415,7 @@ void CSVImportFilter::OnFileNameChanged()
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
-			wfm->Resize(lines.size());
+			wfm->Resize(rows);
 			digwaves.push_back(wfm);
 
 			//no analog waveform
@@ -310,7 +435,7 @@ void CSVImportFilter::OnFileNameChanged()
 			wfm->m_startTimestamp = timestamp;
 			wfm->m_startFemtoseconds = fs;
 			wfm->m_triggerPhase = 0;
-			wfm->Resize(lines.size());
+			wfm->Resize(rows);
 			anwaves.push_back(wfm);
 
 			//no digital waveform
@@ -321,33 +446,134 @@ void CSVImportFilter::OnFileNameChanged()
 
 	m_outputsChangedSignal.emit();
 
-	//Process each actual waveform and figure out how to handle it
-	for(size_t i=0; i<ncols; i++)
+	//Second parallel pass: parse sample data, each worker writing directly into its own slice of the waveforms.
+	//strtof and friends parse in place from the mapped file, so no per-field string temporaries are created.
+	atomic<size_t> firstBadRow(rows);
 	{
-		if(digwaves[i])
+		vector<thread> threads;
+		for(size_t t=0; t<nthreads; t++)
 		{
-			auto wfm = digwaves[i];
-
-			//Read the sample data
-			auto nlines = min(lines.size(), timestamps.size());
-			for(size_t j=0; j<nlines; j++)
+			threads.emplace_back([&, t]()
 			{
-				wfm->m_offsets[j] = timestamps[j];
+				size_t row = rowStart[t];
+				size_t p = bounds[t];
+				char tail[128];
+				while(p < bounds[t+1])
+				{
+					const char* ls;
+					const char* le;
+					GetLineBounds(data, bounds[t+1], p, ls, le);
+					if(IsBlankOrComment(ls, le))
+						continue;
+
+					size_t col = 0;
+					int64_t ts = 0;
+					const char* fstart = ls;
+					for(const char* q = ls; q <= le; q++)
+					{
+						if( (q == le) || (*q == ',') )
+						{
+							//If the field butts up against the end of the mapping (last line with no trailing
+							//newline), copy it to a terminated buffer so the parse can't run past it.
+							//Everywhere else the parse stops at the ',' or line ending.
+							const char* f = fstart;
+							if(q == (data + len))
+							{
+								size_t flen = min(static_cast<size_t>(q - fstart), sizeof(tail) - 1);
+								memcpy(tail, fstart, flen);
+								tail[flen] = '\0';
+								f = tail;
+							}
+
+							//Parse time to a float and convert to fs, other units are as-is
+							if(col == 0)
+							{
+								if(xAxisIsSeconds)
+									ts = FS_PER_SECOND * strtod(f, nullptr);
+								else
+									ts = strtoll(f, nullptr, 10);
+							}
+
+							//Data field
+							else if((col - 1) < ncols)
+							{
+								size_t i = col - 1;
+								if(digwaves[i])
+									digwaves[i]->m_samples[row] = ( ((q - fstart) == 1) && (*fstart == '1') );
+								else
+									anwaves[i]->m_samples[row] = strtof(f, nullptr);
+							}
+							col++;
+							fstart = q + 1;
+						}
+					}
 
-				//Last one? copy previous sample duration
-				if(j+1 == lines.size())
-					wfm->m_durations[j] = wfm->m_durations[j-1];
+					//All columns share the same timestamp
+					for(size_t i=0; i<ncols; i++)
+					{
+						if(digwaves[i])
+							digwaves[i]->m_offsets[row] = ts;
+						else
+							anwaves[i]->m_offsets[row] = ts;
+					}
 
-				//Set sample duration of previous sample
-				if(j > 0)
-					wfm->m_durations[j-1] = wfm->m_offsets[j] - wfm->m_offsets[j-1];
+					//Sanity check field count, remembering the first malformed row
+					if(col != nfields)
+					{
+						size_t expected = firstBadRow.load();
+						while( (row < expected) && !firstBadRow.compare_exchange_weak(expected, row) )
+						{}
+					}
 
-				//Read waveform data
-				if(lines[j][i] == "1")
-					wfm->m_samples[j] = true;
-				else
-					wfm->m_samples[j] = false;
-			}
+					row++;
+				}
+			});
+		}
+		for(auto& th : threads)
+			th.join();
+	}
+
+	//On a malformed row, keep everything before it (like the old line-at-a-time parser did)
+	size_t nrows = rows;
+	if(firstBadRow < rows)
+	{
+		LogError("Malformed file (row %zu contains the wrong number of fields, but file started with %zu fields)\n",
+			firstBadRow.load(), nfields);
+		nrows = firstBadRow;
+		for(size_t i=0; i<ncols; i++)
+		{
+			if(digwaves[i])
+				digwaves[i]->Resize(nrows);
+			else
+				anwaves[i]->Resize(nrows);
+		}
+	}
+
+	//Calculate sample durations now that all of the timestamps are in place
+	for(size_t i=0; i<ncols; i++)
+	{
+		SparseWaveformBase* wfm;
+		if(digwaves[i])
+			wfm = digwaves[i];
+		else
+			wfm = anwaves[i];
+
+		for(size_t j=1; j<nrows; j++)
+			wfm->m_durations[j-1] = wfm->m_offsets[j] - wfm->m_offsets[j-1];
+
+		//Last sample gets a copy of the previous sample's duration
+		if(nrows > 1)
+			wfm->m_durations[nrows-1] = wfm->m_durations[nrows-2];
+		else if(nrows == 1)
+			wfm->m_durations[0] = 0;
+	}
+
+	//Process each actual waveform and figure out how to handle it
+	for(size_t i=0; i<ncols; i++)
+	{
+		if(digwaves[i])
+		{
+			auto wfm = digwaves[i];
 
 			if(TryNormalizeTimebase(wfm))
 			{
@@ -370,30 +596,6 @@ void CSVImportFilter::OnFileNameChanged()
 		{
 			auto wfm = anwaves[i];
 
-			//Read the sample data
-			auto nlines = min(lines.size(), timestamps.size());
-			for(size_t j=0; j<nlines; j++)
-			{
-				wfm->m_offsets[j] = timestamps[j];
-
-				//Last one? copy previous sample duration
-				if(j+1 == lines.size())
-					wfm->m_durations[j] = wfm->m_durations[j-1];
-
-				//Set sample duration of previous sample
-				if(j > 0)
-					wfm->m_durations[j-1] = wfm->m_offsets[j] - wfm->m_offsets[j-1];
-
-				//Read waveform data
-				float v;
-				auto tmp = lines[j][i];
-				if(tmp.find("e") == string::npos)
-					sscanf(tmp.c_str(), "%f", &v);
-				else
-					sscanf(tmp.c_str(), "%e", &v);
-				wfm->m_samples[j] = v;
-			}
-
 			if(TryNormalizeTimebase(wfm))
 			{
 				auto dense = new UniformAnalogWaveform(*wfm);
@@ -405,7 +607,7 @@ void CSVImportFilter::OnFileNameChanged()
 				wfm->MarkModifiedFromCpu();
 
 				//If we end up with zero length samples due to invalid configuration, nuke the channel
-				if(wfm->m_durations[0] == 0)
+				if(wfm->empty() || (wfm->m_durations[0] == 0) )
 					SetData(nullptr, i);
 			}
 		}
@@ -46,6 +46,7 @@ public:
 
 protected:
 	void OnFileNameChanged();
+	void ImportTextBuffer(const char* data, size_t len, time_t timestamp, int64_t fs);
 
 	std::string m_xunit;
 	std::string m_yunit0;
@@ -36,7 +36,7 @@ using namespace std;
 // Construction / destruction
 
 ClipFilter::ClipFilter(const string& color)
-	: Filter(color, CAT_MATH)
+	: PointwiseFilter(color, CAT_MATH)
 	, m_clipAboveName("Behavior")
 	, m_clipLevelName("Level")
 {
@@ -52,20 +52,6 @@ ClipFilter::ClipFilter(const string& color)
 	m_parameters[m_clipLevelName].SetFloatVal(0);
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Factory methods
-
-bool ClipFilter::ValidateChannel(size_t i, StreamDescriptor stream)
-{
-	if(stream.m_channel == NULL)
-		return false;
-
-	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
-		return true;
-
-	return false;
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -77,67 +63,11 @@ string ClipFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void ClipFilter::Refresh()
+PointwiseFilter::PointwiseOp ClipFilter::GetPointwiseOp()
 {
-	//Make sure we've got valid inputs
-	if(!VerifyAllInputsOK())
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	auto din = GetInputWaveform(0);
-	size_t len = din->size();
-
-	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
-	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
-
-	bool clipAbove = m_parameters[m_clipAboveName].GetIntVal();
 	float clipLevel = m_parameters[m_clipLevelName].GetFloatVal();
-
-	if(sdin)
-	{
-		//Negate each sample
-		auto cap = SetupSparseOutputWaveform(sdin, 0, 0, 0);
-		cap->PrepareForCpuAccess();
-		float* out = (float*)__builtin_assume_aligned(&cap->m_samples[0], 16);
-		float* a = (float*)__builtin_assume_aligned(&sdin->m_samples[0], 16);
-		for(size_t i=0; i<len; i++)
-		{
-			float d = a[i];
-
-			if (( clipAbove && d > clipLevel) ||
-				(!clipAbove && d < clipLevel))
-			{
-				d = clipLevel;
-			}
-
-			out[i] = d;
-		}
-
-		cap->MarkModifiedFromCpu();
-	}
-	else if(udin)
-	{
-		//Negate each sample
-		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
-		cap->Resize(len);
-		cap->PrepareForCpuAccess();
-		float* out = (float*)__builtin_assume_aligned(&cap->m_samples[0], 16);
-		float* a = (float*)__builtin_assume_aligned(&udin->m_samples[0], 16);
-		for(size_t i=0; i<len; i++)
-		{
-			float d = a[i];
-			
-			if (( clipAbove && d > clipLevel) ||
-				(!clipAbove && d < clipLevel))
-			{
-				d = clipLevel;
-			}
-			
-			out[i] = d;
-		}
-
-		cap->MarkModifiedFromCpu();
-	}
+	if(m_parameters[m_clipAboveName].GetIntVal())
+		return PointwiseOp(PointwiseOp::OP_CLIP_HI, clipLevel);
+	else
+		return PointwiseOp(PointwiseOp::OP_CLIP_LO, clipLevel);
 }
@@ -35,16 +35,16 @@
 #ifndef ClipFilter_h
 #define ClipFilter_h
 
-class ClipFilter : public Filter
+#include "PointwiseFilter.h"
+
+class ClipFilter : public PointwiseFilter
 {
 public:
 	ClipFilter(const std::string& color);
 
-	virtual void Refresh() override;
-
 	static std::string GetProtocolName();
 
-	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+	virtual PointwiseOp GetPointwiseOp() override;
 
 	PROTOCOL_DECODER_INITPROC(ClipFilter)
 
@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "ClockRecoveryFilter.h"
+#include <omp.h>
 
 using namespace std;
 
@@ -39,6 +40,8 @@ using namespace std;
 
 ClockRecoveryFilter::ClockRecoveryFilter(const string& color)
 	: Filter(color, CAT_CLOCK)
+	, m_warmStartPeriod(0)
+	, m_warmStartNominal(0)
 {
 	AddDigitalStream("data");
 	CreateInput("IN");
@@ -141,7 +144,20 @@ void ClockRecoveryFilter::Refresh()
 	//Get nominal period used for the first cycle of the NCO
 	int64_t initialPeriod = round(FS_PER_SECOND / m_parameters[m_baudname].GetFloatVal());
 	int64_t halfPeriod = initialPeriod / 2;
+
+	//Warm-start the NCO from the previous refresh's lock state if it's still applicable: same input stream,
+	//same nominal symbol rate, and the saved period within 1% of nominal. In free-run monitoring the actual
+	//frequency barely drifts between triggers, so this cuts re-lock time to near zero; a bigger delta means
+	//the signal changed and we're better off re-acquiring from the nominal rate.
 	int64_t period = initialPeriod;
+	if( (m_warmStartPeriod != 0) &&
+		(m_warmStartInput == GetInput(0)) &&
+		(m_warmStartNominal == initialPeriod) &&
+		(llabs(m_warmStartPeriod - initialPeriod) < initialPeriod / 100) )
+	{
+		period = m_warmStartPeriod;
+	}
+	m_warmStartPeriod = 0;
 
 	//Disallow frequencies higher than Nyquist of the input
 	auto fnyquist = 2*din->m_timescale;
@@ -163,6 +179,18 @@ void ClockRecoveryFilter::Refresh()
 	else
 		tend = GetOffsetScaled(sddin, uddin, din->size()-1);
 
+	//Long ungated captures get processed block-parallel: each block of edges runs its own PLL instance, warmed
+	//up on edges before its output window, and the resulting clock segments are stitched back together.
+	//The gated path has serial feedback through the re-lock logic so it stays on the single loop below.
+	//(PLL debug output streams only make sense with a single PLL instance, so they force the serial path too.)
+	#ifndef PLL_DEBUG_OUTPUTS
+	if( (gate == nullptr) && (edges.size() >= PLL_PARALLEL_THRESHOLD) )
+	{
+		RefreshParallel(edges, tend, initialPeriod, period, fnyquist, cap);
+		return;
+	}
+	#endif
+
 	#ifdef PLL_DEBUG_OUTPUTS
 	auto debugPeriod = SetupEmptySparseAnalogOutputWaveform(cap, 1);
 	auto debugPhase = SetupEmptySparseAnalogOutputWaveform(cap, 2);
@@ -357,7 +385,215 @@ void ClockRecoveryFilter::Refresh()
 	total_error /= edges.size();
 	//LogTrace("average phase error %zu\n", total_error);
 
+	//Save the lock state so the next refresh on the same signal can warm-start
+	m_warmStartPeriod = period;
+	m_warmStartInput = GetInput(0);
+	m_warmStartNominal = initialPeriod;
+
 	SetData(cap, 0);
 
 	cap->MarkModifiedFromCpu();
 }
+
+/**
+	@brief Block-parallel PLL for long ungated captures
+
+	Carves the edge list into contiguous blocks and runs an independent PLL instance over each one. Every block
+	except the first warms up on PLL_BLOCK_WARMUP edges before its output window so the loop has converged by the
+	time it starts emitting; the per-block clock segments are then polarity-reconciled at the seams and
+	concatenated. Output is not bit identical to the serial loop (each block re-acquires lock from the nominal
+	symbol rate) but any difference is confined to sub-UI phase wander at block boundaries.
+ */
+void ClockRecoveryFilter::RefreshParallel(
+	const vector<int64_t>& edges,
+	int64_t tend,
+	int64_t initialPeriod,
+	int64_t startPeriod,
+	int64_t fnyquist,
+	SparseDigitalWaveform* cap)
+{
+	//Use a few blocks per thread for load balancing, but keep blocks much longer than the warm-up region
+	//so the duplicated work stays negligible
+	size_t nblocks = min(4 * (size_t)omp_get_max_threads(), edges.size() / (PLL_BLOCK_WARMUP * 8));
+	nblocks = max(nblocks, (size_t)1);
+	size_t edgesPerBlock = edges.size() / nblocks;
+
+	vector<vector<int64_t>> offsets(nblocks);
+	vector<vector<int64_t>> durations(nblocks);
+	vector<vector<uint8_t>> samples(nblocks);
+	vector<uint8_t> lockOK(nblocks, 1);
+	vector<int64_t> finalPeriods(nblocks, 0);
+
+	#pragma omp parallel for
+	for(size_t b=0; b<nblocks; b++)
+	{
+		//Each block owns the time range [first edge of block, first edge of next block)
+		size_t istart = b * edgesPerBlock;
+		size_t warmStart = (b == 0) ? 1 : (istart - PLL_BLOCK_WARMUP);
+		int64_t temit = edges[istart];
+		int64_t tstop = (b+1 == nblocks) ? tend : edges[(b+1) * edgesPerBlock];
+
+		offsets[b].reserve(edgesPerBlock);
+		durations[b].reserve(edgesPerBlock);
+		samples[b].reserve(edgesPerBlock);
+
+		lockOK[b] = RunPLL(
+			edges, warmStart, edges[warmStart-1], temit, tstop, initialPeriod, startPeriod, fnyquist,
+			offsets[b], durations[b], samples[b], finalPeriods[b]);
+	}
+
+	//If a block tried to lock above Nyquist, keep everything up to and including its partial output
+	//and drop the rest (the serial loop stops decoding at that point too)
+	size_t nkeep = nblocks;
+	for(size_t b=0; b<nblocks; b++)
+	{
+		if(!lockOK[b])
+		{
+			nkeep = b + 1;
+			break;
+		}
+	}
+
+	//Each block starts with an arbitrary clock polarity. Flip entire blocks as needed so the
+	//recovered clock keeps toggling across the seams.
+	int lastValue = -1;
+	for(size_t b=0; b<nkeep; b++)
+	{
+		if(samples[b].empty())
+			continue;
+		if(samples[b].front() == lastValue)
+		{
+			for(auto& s : samples[b])
+				s ^= 1;
+		}
+		lastValue = samples[b].back();
+	}
+
+	//Concatenate the blocks into the output waveform
+	size_t total = 0;
+	vector<size_t> blockStart(nkeep);
+	for(size_t b=0; b<nkeep; b++)
+	{
+		blockStart[b] = total;
+		total += offsets[b].size();
+	}
+	cap->Resize(total);
+
+	#pragma omp parallel for
+	for(size_t b=0; b<nkeep; b++)
+	{
+		size_t base = blockStart[b];
+		for(size_t i=0; i<offsets[b].size(); i++)
+		{
+			cap->m_offsets[base + i] = offsets[b][i];
+			cap->m_durations[base + i] = durations[b][i];
+			cap->m_samples[base + i] = (samples[b][i] != 0);
+		}
+	}
+
+	//Save the last block's lock state so the next refresh on the same signal can warm-start
+	if(lockOK[nkeep-1])
+	{
+		m_warmStartPeriod = finalPeriods[nkeep-1];
+		m_warmStartInput = GetInput(0);
+		m_warmStartNominal = initialPeriod;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Runs the PLL NCO over part of the edge list, appending recovered clock cycles to the supplied buffers
+
+	Same control loop as the ungated serial path in Refresh(). Emission is suppressed until edgepos reaches temit,
+	letting a block warm up on edges owned by its predecessor.
+
+	@return false if the PLL attempted to lock at or above Nyquist (decoding stops at that point)
+ */
+bool ClockRecoveryFilter::RunPLL(
+	const vector<int64_t>& edges,
+	size_t nedge,
+	int64_t edgepos,
+	int64_t temit,
+	int64_t tstop,
+	int64_t initialPeriod,
+	int64_t startPeriod,
+	int64_t fnyquist,
+	vector<int64_t>& offsets,
+	vector<int64_t>& durations,
+	vector<uint8_t>& samples,
+	int64_t& finalPeriod)
+{
+	int64_t halfPeriod = initialPeriod / 2;
+	int64_t period = startPeriod;
+	bool value = false;
+	int64_t tlast = 0;
+
+	for(; (edgepos < tstop) && (nedge < edges.size()-1); edgepos += period)
+	{
+		float center = period/2;
+
+		//See if the next edge occurred in this UI.
+		//If not, just run the NCO open loop.
+		//Allow multiple edges in the UI if the frequency is way off.
+		int64_t tnext = edges[nedge];
+		while( (tnext + center < edgepos) && (nedge+1 < edges.size()) )
+		{
+			//Find phase error
+			int64_t dphase = (edgepos - tnext) - period;
+
+			//If we're more than half a UI off, assume this is actually part of the next UI
+			if(dphase > halfPeriod)
+				dphase -= period;
+			if(dphase < -halfPeriod)
+				dphase += period;
+
+			//Find frequency error
+			int64_t uiLen = (tnext - tlast);
+			float numUIs = round(uiLen * 1.0 / initialPeriod);
+			if(numUIs < 0.1)		//Sanity check: no correction if we have a glitch
+				uiLen = period;
+			else
+				uiLen /= numUIs;
+			int64_t dperiod = period - uiLen;
+
+			if(tlast != 0)
+			{
+				//Frequency error term
+				period -= dperiod * 0.006;
+
+				//Phase error term
+				period -= dphase * 0.002;
+
+				//HACK: immediate bang-bang phase shift
+				if(dphase > 0)
+					edgepos -= period / 400;
+				else
+					edgepos += period / 400;
+
+				if(period < fnyquist)
+				{
+					LogWarning("PLL attempted to lock to frequency near or above Nyquist\n");
+					finalPeriod = period;
+					return false;
+				}
+			}
+
+			tlast = tnext;
+			tnext = edges[++nedge];
+		}
+
+		//Add the sample (90 deg phase offset from the internal NCO), unless we're still warming up
+		if(edgepos >= temit)
+		{
+			value = !value;
+			offsets.push_back(edgepos + period/2);
+			durations.push_back(period);
+			samples.push_back(value);
+		}
+	}
+
+	finalPeriod = period;
+	return true;
+}
@@ -50,6 +50,43 @@ public:
 	PROTOCOL_DECODER_INITPROC(ClockRecoveryFilter)
 
 protected:
+	void RefreshParallel(
+		const std::vector<int64_t>& edges,
+		int64_t tend,
+		int64_t initialPeriod,
+		int64_t startPeriod,
+		int64_t fnyquist,
+		SparseDigitalWaveform* cap);
+
+	bool RunPLL(
+		const std::vector<int64_t>& edges,
+		size_t nedge,
+		int64_t edgepos,
+		int64_t temit,
+		int64_t tstop,
+		int64_t initialPeriod,
+		int64_t startPeriod,
+		int64_t fnyquist,
+		std::vector<int64_t>& offsets,
+		std::vector<int64_t>& durations,
+		std::vector<uint8_t>& samples,
+		int64_t& finalPeriod);
+
+	///@brief Number of warm-up edges each parallel PLL block consumes before its output window begins
+	static const size_t PLL_BLOCK_WARMUP = 4096;
+
+	///@brief Minimum edge count before Refresh() switches to the block-parallel PLL
+	static const size_t PLL_PARALLEL_THRESHOLD = 262144;
+
+	///@brief PLL period at the end of the previous refresh, for warm-starting the next one (0 = none saved)
+	int64_t m_warmStartPeriod;
+
+	///@brief Input stream the saved lock state was acquired from
+	StreamDescriptor m_warmStartInput;
+
+	///@brief Nominal period the saved lock state was acquired at
+	int64_t m_warmStartNominal;
+
 	std::string m_baudname;
 	std::string m_threshname;
 };
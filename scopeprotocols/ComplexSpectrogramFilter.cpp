@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "../scopehal/AlignedAllocator.h"
+#include "../scopehal/VulkanFFTPlanPool.h"
 #include "ComplexSpectrogramFilter.h"
 #include "FFTFilter.h"
 
@@ -50,11 +51,18 @@ ComplexSpectrogramFilter::ComplexSpectrogramFilter(const string& color)
 	CreateInput("Q");
 
 	m_blackmanHarrisComputePipeline.Reinitialize(
-		"shaders/ComplexBlackmanHarrisWindow.spv", 3, sizeof(WindowFunctionArgs));
+		"shaders/BatchedComplexBlackmanHarrisWindow.spv", 3, sizeof(BatchedWindowFunctionArgs));
 	m_rectangularComputePipeline.Reinitialize(
-		"shaders/ComplexRectangularWindow.spv", 3, sizeof(WindowFunctionArgs));
-	m_cosineSumComputePipeline.Reinitialize(
-		"shaders/CosineSumWindow.spv", 3, sizeof(WindowFunctionArgs));
+		"shaders/BatchedComplexRectangularWindow.spv", 3, sizeof(BatchedWindowFunctionArgs));
+	m_hannComputePipeline.Reinitialize(
+		"shaders/BatchedComplexCosineSumWindow.spv", 3, sizeof(BatchedWindowFunctionArgs));
+	m_hammingComputePipeline.Reinitialize(
+		"shaders/BatchedComplexCosineSumWindow.spv", 3, sizeof(BatchedWindowFunctionArgs));
+
+	//Reinitialize() cleared the baked-in window coefficients, so set them again
+	const float hammingAlpha0 = 25.0f / 46;
+	m_hannComputePipeline.SetSpecializationConstants(vector<float>{0.5f, 0.5f});
+	m_hammingComputePipeline.SetSpecializationConstants(vector<float>{hammingAlpha0, 1 - hammingAlpha0});
 
 	m_postprocessComputePipeline.Reinitialize(
 		"shaders/ComplexSpectrogramPostprocess.spv", 2, sizeof(SpectrogramPostprocessArgs));
@@ -97,18 +105,6 @@ void ComplexSpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	m_cachedFFTLength = fftlen;
 	m_cachedFFTNumBlocks = nblocks;
 
-	size_t nouts = fftlen;
-	if(m_vkPlan)
-	{
-		if(m_vkPlan->size() != fftlen)
-			m_vkPlan = nullptr;
-	}
-	if(!m_vkPlan)
-	{
-		m_vkPlan = make_unique<VulkanFFTPlan>(
-			fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks, VulkanFFTPlan::TYPE_COMPLEX);
-	}
-
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
@@ -209,25 +205,17 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	}
 
 	//Configure the window
-	WindowFunctionArgs args;
-	args.numActualSamples = fftlen;
+	//All blocks are fully populated (the trailing partial block, if any, was truncated)
+	//so we can window every block in a single 2D dispatch
+	BatchedWindowFunctionArgs args;
 	args.npoints = fftlen;
+	args.nblocks = nblocks;
+	args.ygrid = min(g_maxComputeGroupCount[2], nblocks);
 	args.scale = 2 * M_PI / fftlen;
-	switch(window)
-	{
-		case FFTFilter::WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
 
-		case FFTFilter::WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
-	}
-	args.alpha1 = 1 - args.alpha0;
+	//Cosine-sum coefficients are baked into the specialized pipelines, so nothing window specific goes here
+	args.alpha0 = 0;
+	args.alpha1 = 0;
 
 	//Figure out which window shader to use
 	ComputePipeline* wpipe = nullptr;
@@ -238,8 +226,11 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 			break;
 
 		case FFTFilter::WINDOW_HANN:
+			wpipe = &m_hannComputePipeline;
+			break;
+
 		case FFTFilter::WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
+			wpipe = &m_hammingComputePipeline;
 			break;
 
 		default:
@@ -260,31 +251,31 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
-	//Grab the input and apply the window function
+	//Grab the input and apply the window function to all blocks in one dispatch
 	wpipe->BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
 	wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
 	wpipe->BindBufferNonblocking(2, din_q->m_samples, cmdBuf);
-	for(size_t block=0; block<nblocks; block++)
-	{
-		args.offsetIn = block*fftlen;
-		args.offsetOut = block*fftlen;
-
-		if(block == 0)
-			wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-		else
-			wpipe->DispatchNoRebind(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-	}
+	wpipe->Dispatch(
+		cmdBuf,
+		args,
+		GetComputeBlockCount(fftlen, 64),
+		ceil(nblocks * 1.0 / args.ygrid),
+		args.ygrid
+		);
 	wpipe->AddComputeMemoryBarrier(cmdBuf);
 
 	//Do the actual FFT
-	m_vkPlan->AppendForward(
+	//(the plan is checked out of the shared pool until we've finished waiting on the GPU below)
+	auto plan = VulkanFFTPlanPool::GetInstance().Acquire(
+		fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks, VulkanFFTPlan::TYPE_COMPLEX);
+	plan->AppendForward(
 		m_rdinbuf,
 		m_rdoutbuf,
 		cmdBuf);
 
-	//Postprocess the output
-	//TODO: really deep waveforms might generate a lot of blocks here (enough to exceed the max block count in Y)
-	//so do multiple dispatches in that case?
+	//Postprocess the output. This is a transpose (FFT output is one row per block, the spectrogram is one
+	//column per block), so the shader stages 32x32 tiles through shared memory to keep both sides coalesced;
+	//each workgroup covers one tile.
 	const float impedance = 50;
 	SpectrogramPostprocessArgs postargs;
 	postargs.nblocks = nblocks;
@@ -293,16 +284,15 @@ void ComplexSpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_p
 	postargs.impscale = scale*scale / impedance;
 	postargs.minscale = minscale;
 	postargs.irange = 1.0 / range;
-	postargs.ygrid = min(g_maxComputeGroupCount[2], nblocks);
+	postargs.ygrid = 0;	//unused by the tiled shader
 	m_postprocessComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 	m_postprocessComputePipeline.BindBufferNonblocking(0, m_rdoutbuf, cmdBuf);
 	m_postprocessComputePipeline.BindBufferNonblocking(1, cap->GetOutData(), cmdBuf, true);
 	m_postprocessComputePipeline.Dispatch(
 		cmdBuf,
 		postargs,
-		GetComputeBlockCount(nouts, 64),
-		ceil(nblocks * 1.0 / postargs.ygrid),
-		postargs.ygrid
+		GetComputeBlockCount(nouts, 32),
+		GetComputeBlockCount(nblocks, 32)
 		);
 
 	//Done, block until the compute operations finish
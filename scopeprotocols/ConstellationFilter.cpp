@@ -29,11 +29,14 @@
 
 #include "../scopehal/scopehal.h"
 #include "ConstellationFilter.h"
+#include "IQDemuxFilter.h"
 #include <algorithm>
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
 
+#include <omp.h>
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -139,16 +142,45 @@ void ConstellationFilter::Refresh(
 	auto din_q = GetInputWaveform(1);
 	auto clk = GetInputWaveform(2);
 
+	//The accumulator is persistent across triggers. If none of the inputs have changed since our last refresh,
+	//these symbols are already integrated - don't count them twice.
+	if( GetData(0) && (m_inputKeyI == din_i) && (m_inputKeyQ == din_q) && (m_inputKeyClk == clk) )
+		return;
+
 	//Recompute the nominal constellation point locations
 	RecomputeNominalPoints();
 
-	//Sample the I/Q input
+	//Sample the I/Q input.
+	//Fused fast path: if I and Q come straight from the same IQ demux, its outputs are already sampled at
+	//symbol rate with matching timestamps (and the clock is just the demux's toggle output), so re-sampling
+	//them against that clock would reproduce the input verbatim. Use the symbol values directly instead.
 	SparseAnalogWaveform samples_i;
 	SparseAnalogWaveform samples_q;
-	SampleOnAnyEdgesBase(din_i, clk, samples_i);
-	SampleOnAnyEdgesBase(din_q, clk, samples_q);
-
-	size_t inlen = min(samples_i.size(), samples_q.size());
+	const float* ivals = nullptr;
+	const float* qvals = nullptr;
+	size_t inlen = 0;
+
+	auto demux = dynamic_cast<IQDemuxFilter*>(m_inputs[0].m_channel);
+	auto sparse_i = dynamic_cast<SparseAnalogWaveform*>(din_i);
+	auto sparse_q = dynamic_cast<SparseAnalogWaveform*>(din_q);
+	if( demux && (m_inputs[1].m_channel == demux) &&
+		(m_inputs[0].m_stream == 0) && (m_inputs[1].m_stream == 1) &&
+		sparse_i && sparse_q )
+	{
+		sparse_i->PrepareForCpuAccess();
+		sparse_q->PrepareForCpuAccess();
+		ivals = sparse_i->m_samples.GetCpuPointer();
+		qvals = sparse_q->m_samples.GetCpuPointer();
+		inlen = min(sparse_i->size(), sparse_q->size());
+	}
+	else
+	{
+		SampleOnAnyEdgesBase(din_i, clk, samples_i);
+		SampleOnAnyEdgesBase(din_q, clk, samples_q);
+		ivals = samples_i.m_samples.GetCpuPointer();
+		qvals = samples_q.m_samples.GetCpuPointer();
+		inlen = min(samples_i.size(), samples_q.size());
+	}
 
 	//Generate the output waveform
 	auto cap = dynamic_cast<ConstellationWaveform*>(GetData(0));
@@ -162,41 +194,100 @@ void ConstellationFilter::Refresh(
 	float yscale = m_height / GetVoltageRange(0);
 	float ymid = m_height / 2;
 
-	//Actual integration loop
-	//TODO: vectorize, GPU, or both?
-	auto data = cap->GetAccumData();
-	for(size_t i=0; i<inlen; i++)
+	//Hoist the nominal point coordinates out of the hot loop (m_xval is stored in uV)
+	size_t npoints = m_points.size();
+	vector<float> pxvals(npoints);
+	vector<float> pyvals(npoints);
+	for(size_t j=0; j<npoints; j++)
 	{
-		float ival = samples_i.m_samples[i];
-		float qval = samples_q.m_samples[i];
+		pxvals[j] = m_points[j].m_xval * 1e-6;
+		pyvals[j] = m_points[j].m_yval;
+	}
 
-		ssize_t x = static_cast<ssize_t>(round(xmid + xscale * ival));
-		ssize_t y = static_cast<ssize_t>(round(ymid + yscale * qval));
+	//Actual integration loop, sharded across threads with a private density grid per shard.
+	//Shards only touch their own grid so no atomics are needed; the grids are merged at the end.
+	auto data = cap->GetAccumData();
+	size_t gridsize = m_width * m_height;
+	const size_t minShardSize = 256 * 1024;
+	size_t nshards = min((inlen + minShardSize - 1) / minShardSize, (size_t)omp_get_max_threads());
+	nshards = max(nshards, (size_t)1);
+	size_t shardSize = (inlen + nshards - 1) / nshards;
+
+	vector<vector<int64_t>> shardGrids(nshards);
+	vector<double> shardEvmSum(nshards, 0);
+	vector<int64_t> shardEvmCount(nshards, 0);
+
+	#pragma omp parallel for
+	for(size_t shard=0; shard<nshards; shard++)
+	{
+		size_t start = shard * shardSize;
+		size_t end = min(start + shardSize, inlen);
 
-		//bounds check
-		if( (x < 0) || (x >= (ssize_t)m_width) || (y < 0) || (y >= (ssize_t)m_height) )
-			continue;
+		//Small captures get a single shard which writes the output grid directly, skipping the
+		//private-grid allocation and merge pass
+		int64_t* grid = data;
+		if(nshards > 1)
+		{
+			shardGrids[shard].resize(gridsize, 0);
+			grid = shardGrids[shard].data();
+		}
 
-		//fill
-		data[y*m_width + x] ++;
+		double evmSum = 0;
+		int64_t evmCount = 0;
 
-		//Compute error vector
-		if(m_points.size())
+		for(size_t i=start; i<end; i++)
 		{
-			//TODO: this can definitely be made more efficient!!!
-			float minvec = FLT_MAX;
-			for(auto p : m_points)
+			float ival = ivals[i];
+			float qval = qvals[i];
+
+			ssize_t x = static_cast<ssize_t>(round(xmid + xscale * ival));
+			ssize_t y = static_cast<ssize_t>(round(ymid + yscale * qval));
+
+			//bounds check
+			if( (x < 0) || (x >= (ssize_t)m_width) || (y < 0) || (y >= (ssize_t)m_height) )
+				continue;
+
+			//fill
+			grid[y*m_width + x] ++;
+
+			//Compute error vector
+			if(npoints)
 			{
-				float dx = (p.m_xval * 1e-6) - ival;
-				float dy = p.m_yval - qval;
-				float dsq = dx*dx + dy*dy;
-				minvec = min(minvec, dsq);
+				float minvec = FLT_MAX;
+				for(size_t j=0; j<npoints; j++)
+				{
+					float dx = pxvals[j] - ival;
+					float dy = pyvals[j] - qval;
+					float dsq = dx*dx + dy*dy;
+					minvec = min(minvec, dsq);
+				}
+
+				evmCount ++;
+				evmSum += sqrt(minvec);
 			}
+		}
 
-			m_evmCount ++;
-			m_evmSum += sqrt(minvec);
+		shardEvmSum[shard] = evmSum;
+		shardEvmCount[shard] = evmCount;
+	}
+
+	//Merge the shard grids into the persistent accumulator
+	if(nshards > 1)
+	{
+		#pragma omp parallel for
+		for(size_t i=0; i<gridsize; i++)
+		{
+			int64_t total = 0;
+			for(size_t shard=0; shard<nshards; shard++)
+				total += shardGrids[shard][i];
+			data[i] += total;
 		}
 	}
+	for(size_t shard=0; shard<nshards; shard++)
+	{
+		m_evmSum += shardEvmSum[shard];
+		m_evmCount += shardEvmCount[shard];
+	}
 
 	double evmRaw = m_evmSum / m_evmCount;
 	double evmNorm = evmRaw / m_parameters[m_nomr].GetFloatVal();
@@ -207,6 +298,11 @@ void ConstellationFilter::Refresh(
 	//Count total number of symbols we've integrated
 	cap->IntegrateSymbols(inlen);
 	cap->Normalize();
+
+	//Remember what we integrated so a refresh without new data doesn't double-count
+	m_inputKeyI = din_i;
+	m_inputKeyQ = din_q;
+	m_inputKeyClk = clk;
 }
 
 void ConstellationFilter::RecomputeNominalPoints()
@@ -337,12 +433,35 @@ void ConstellationFilter::RecomputeNominalPoints()
 
 ConstellationWaveform* ConstellationFilter::ReallocateWaveform()
 {
-	auto cap = new ConstellationWaveform(m_width, m_height);
+	//Try to recycle a pooled constellation of suitable size before allocating a new one
+	auto cap = dynamic_cast<ConstellationWaveform*>(m_constellationWaveformPool.Get(m_width * m_height));
+	if(cap)
+		cap->Resize(m_width, m_height);
+	else
+		cap = new ConstellationWaveform(m_width, m_height);
 	cap->m_timescale = 1;
 	SetData(cap, 0);
 	return cap;
 }
 
+/**
+	@brief Resizes the current output waveform in place after a plot dimension change
+
+	Resizing the existing accumulator avoids freeing and reallocating the bitmap every time the user drags
+	the plot size, at the cost of restarting integration (which a dimension change forces anyway).
+ */
+void ConstellationFilter::ResizeWaveform()
+{
+	auto cap = dynamic_cast<ConstellationWaveform*>(GetData(0));
+	if(cap)
+		cap->Resize(m_width, m_height);
+
+	//Invalidate the input cache keys so the next refresh re-integrates into the now-blank bitmap
+	m_inputKeyI = WaveformCacheKey();
+	m_inputKeyQ = WaveformCacheKey();
+	m_inputKeyClk = WaveformCacheKey();
+}
+
 vector<string> ConstellationFilter::EnumActions()
 {
 	vector<string> ret;
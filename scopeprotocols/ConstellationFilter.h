@@ -84,13 +84,14 @@ public:
 	virtual bool PerformAction(const std::string& id) override;
 
 	ConstellationWaveform* ReallocateWaveform();
+	void ResizeWaveform();
 
 	void SetWidth(size_t width)
 	{
 		if(m_width != width)
 		{
-			SetData(NULL, 0);
 			m_width = width;
+			ResizeWaveform();
 		}
 	}
 
@@ -98,8 +99,8 @@ public:
 	{
 		if(m_height != height)
 		{
-			SetData(NULL, 0);
 			m_height = height;
+			ResizeWaveform();
 		}
 	}
 
@@ -155,6 +156,15 @@ protected:
 	double m_evmSum;
 	int64_t m_evmCount;
 
+	///@brief Revision of the I input as of our last refresh, so we don't integrate the same symbols twice
+	WaveformCacheKey m_inputKeyI;
+
+	///@brief Revision of the Q input as of our last refresh
+	WaveformCacheKey m_inputKeyQ;
+
+	///@brief Revision of the clock input as of our last refresh
+	WaveformCacheKey m_inputKeyClk;
+
 	///@brief Nominal locations of each constellation point
 	std::vector<ConstellationPoint> m_points;
 };
@@ -238,23 +238,23 @@ void CouplerDeEmbedFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Q
 	auto dmag = GetInput(2).GetData();
 	auto dang = GetInput(3).GetData();
 	if(sizechange || clipchange || m_forwardCoupledParams.NeedUpdate(dmag, dang, bin_hz) )
-		m_forwardCoupledParams.Refresh(dmag, dang, bin_hz, true, nouts, maxGain, dinFwd->m_timescale, npoints);
+		m_forwardCoupledParams.Refresh(dmag, dang, bin_hz, true, nouts, maxGain, dinFwd->m_timescale, npoints, sizechange || clipchange);
 
 	dmag = GetInput(4).GetData();
 	dang = GetInput(5).GetData();
 	if(sizechange || clipchange || m_reverseCoupledParams.NeedUpdate(dmag, dang, bin_hz))
-		m_reverseCoupledParams.Refresh(dmag, dang, bin_hz, true, nouts, maxGain, dinFwd->m_timescale, npoints);
+		m_reverseCoupledParams.Refresh(dmag, dang, bin_hz, true, nouts, maxGain, dinFwd->m_timescale, npoints, sizechange || clipchange);
 
 	//Leakage paths
 	dmag = GetInput(6).GetData();
 	dang = GetInput(7).GetData();
 	if(sizechange || clipchange || m_forwardLeakageParams.NeedUpdate(dmag, dang, bin_hz))
-		m_forwardLeakageParams.Refresh(dmag, dang, bin_hz, false, nouts, maxGain, dinFwd->m_timescale, npoints);
+		m_forwardLeakageParams.Refresh(dmag, dang, bin_hz, false, nouts, maxGain, dinFwd->m_timescale, npoints, sizechange || clipchange);
 
 	dmag = GetInput(8).GetData();
 	dang = GetInput(9).GetData();
 	if(sizechange || clipchange || m_reverseLeakageParams.NeedUpdate(dmag, dang, bin_hz))
-		m_reverseLeakageParams.Refresh(dmag, dang, bin_hz, false, nouts, maxGain, dinFwd->m_timescale, npoints);
+		m_reverseLeakageParams.Refresh(dmag, dang, bin_hz, false, nouts, maxGain, dinFwd->m_timescale, npoints, sizechange || clipchange);
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -518,12 +518,31 @@ int64_t CouplerSParameters::GetGroupDelay()
 	return max_delay * FS_PER_SECOND;
 }
 
+/**
+	@brief Updates m_cachedSparams in place from mag/angle waveforms
+
+	@return Bitwise OR of SParameterVector::UpdateFlags values describing what, if anything, changed
+ */
+int CouplerSParameters::UpdateCachedSparameters(WaveformBase* wmag, WaveformBase* wang)
+{
+	wmag->PrepareForCpuAccess();
+	wang->PrepareForCpuAccess();
+
+	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
+	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
+	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
+	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
+
+	if(smag && sang)
+		return m_cachedSparams.UpdateFromWaveforms(smag, sang);
+	else
+		return m_cachedSparams.UpdateFromWaveforms(umag, uang);
+}
+
 /**
 	@brief Recalculate the cached S-parameters (and clamp gain if requested)
  */
 void CouplerSParameters::InterpolateSparameters(
-	WaveformBase* wmag,
-	WaveformBase* wang,
 	float bin_hz,
 	bool invert,
 	size_t nouts,
@@ -531,25 +550,12 @@ void CouplerSParameters::InterpolateSparameters(
 {
 	m_cachedBinSize = bin_hz;
 
-	wmag->PrepareForCpuAccess();
-	wang->PrepareForCpuAccess();
-
 	m_resampledSparamSines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamSines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
 	m_resampledSparamCosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamCosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
-	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
-	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
-	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
-	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
-
-	if(smag && sang)
-		m_cachedSparams.ConvertFromWaveforms(smag, sang);
-	else
-		m_cachedSparams.ConvertFromWaveforms(umag, uang);
-
 	m_resampledSparamSines.resize(nouts);
 	m_resampledSparamCosines.resize(nouts);
 
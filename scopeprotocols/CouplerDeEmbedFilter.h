@@ -62,6 +62,9 @@ public:
 
 	/**
 		@brief Refresh the cached data
+
+		If force is false, the resampled response is reused when the S-parameter content and bin size are unchanged
+		(e.g. continuous sweeps of a stable DUT producing new waveform objects with identical data).
 	 */
 	void Refresh(
 		WaveformBase* wmag,
@@ -71,15 +74,26 @@ public:
 		size_t nouts,
 		float maxGain,
 		int64_t timescale,
-		size_t npoints)
+		size_t npoints,
+		bool force)
 	{
 		//Update cache keys to reflect the current waveforms we're processing
 		m_magKey = wmag;
 		m_angleKey = wang;
 
+		//Pull the new data into the cached copy in place, then bail if nothing actually changed
+		int flags = UpdateCachedSparameters(wmag, wang);
+		if( !force &&
+			(flags == SParameterVector::UPDATE_FLAG_NONE) &&
+			(fabs(m_cachedBinSize - bin_hz) <= FLT_EPSILON) &&
+			!m_resampledSparamSines.empty() )
+		{
+			return;
+		}
+
 		m_resampledSparamCosines.clear();
 		m_resampledSparamSines.clear();
-		InterpolateSparameters(wmag, wang, bin_hz, invert, nouts, maxGain);
+		InterpolateSparameters(bin_hz, invert, nouts, maxGain);
 
 		m_groupDelayFs = GetGroupDelay();
 		m_groupDelaySamples = ceil( m_groupDelayFs / timescale );
@@ -93,9 +107,9 @@ public:
 		}
 	}
 
+	int UpdateCachedSparameters(WaveformBase* wmag, WaveformBase* wang);
+
 	void InterpolateSparameters(
-		WaveformBase* wmag,
-		WaveformBase* wang,
 		float bin_hz,
 		bool invert,
 		size_t nouts,
@@ -92,20 +92,16 @@ void DDR3Decoder::Refresh()
 		caps[i]->PrepareForCpuAccess();
 	}
 
-	//Sample all of the inputs
+	//Sample all of the inputs, sharing a single clock edge extraction pass across the control lines
 	auto cclk = caps[0];
-	SparseDigitalWaveform we;
-	SparseDigitalWaveform ras;
-	SparseDigitalWaveform cas;
-	SparseDigitalWaveform cs;
-	SparseDigitalWaveform a12;
-	SparseDigitalWaveform a10;
-	SampleOnRisingEdgesBase(caps[1], cclk, we);
-	SampleOnRisingEdgesBase(caps[2], cclk, ras);
-	SampleOnRisingEdgesBase(caps[3], cclk, cas);
-	SampleOnRisingEdgesBase(caps[4], cclk, cs);
-	SampleOnRisingEdgesBase(caps[5], cclk, a12);
-	SampleOnRisingEdgesBase(caps[6], cclk, a10);
+	SparseDigitalWaveform ctl[6];
+	size_t len = SampleControlLines(cclk, &caps[1], ctl, 6);
+	auto& we = ctl[0];
+	auto& ras = ctl[1];
+	auto& cas = ctl[2];
+	auto& cs = ctl[3];
+	auto& a12 = ctl[4];
+	auto& a10 = ctl[5];
 
 	//Create the capture
 	auto cap = new SDRAMWaveform;
@@ -114,13 +110,12 @@ void DDR3Decoder::Refresh()
 	cap->m_startFemtoseconds = 0;
 	cap->PrepareForCpuAccess();
 
-	//Loop over the data and look for events on clock edges
-	size_t len = we.size();
-	len = min(len, ras.size());
-	len = min(len, cas.size());
-	len = min(len, cs.size());
-	len = min(len, a12.size());
-	len = min(len, a10.size());
+	//First pass: decode each clock edge.
+	//Once the control lines are sampled, decode of a given edge is independent of all others,
+	//so the edge range can be split across threads.
+	vector<SDRAMSymbol> symbols(len);
+	vector<uint8_t> valid(len, 0);
+	#pragma omp parallel for
 	for(size_t i=0; i<len; i++)
 	{
 		bool swe = we.m_samples[i];
@@ -168,12 +163,23 @@ void DDR3Decoder::Refresh()
 			else
 				LogDebug("[%zu] Unknown command (RAS=%d, CAS=%d, WE=%d, A12=%d, A10=%d)\n", i, sras, scas, swe, sa12, sa10);
 
-			//Create the symbol
-			cap->m_offsets.push_back(we.m_offsets[i]);
-			cap->m_durations.push_back(we.m_durations[i]);
-			cap->m_samples.push_back(sym);
+			symbols[i] = sym;
+			valid[i] = 1;
 		}
 	}
+
+	//Second pass: concatenate the decoded commands in edge order.
+	//This is where cross-command state (bank tracking etc) would be reconciled if we tracked any;
+	//the decode is currently stateless so it's a simple compaction.
+	for(size_t i=0; i<len; i++)
+	{
+		if(!valid[i])
+			continue;
+
+		cap->m_offsets.push_back(we.m_offsets[i]);
+		cap->m_durations.push_back(we.m_durations[i]);
+		cap->m_samples.push_back(symbols[i]);
+	}
 	SetData(cap, 0);
 	cap->MarkModifiedFromCpu();
 }
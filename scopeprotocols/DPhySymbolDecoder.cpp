@@ -35,9 +35,30 @@
 
 #include "../scopehal/scopehal.h"
 #include "DPhySymbolDecoder.h"
+#include <omp.h>
 
 using namespace std;
 
+///@brief Packed threshold comparison codes produced by the parallel classification pass
+enum DPhyLevelCode : uint8_t
+{
+	//Single-ended (Dp only) codes
+	DPHY_SE_GT_880		= 0x01,	//Dp > 880 mV
+	DPHY_SE_GT_210		= 0x02,	//Dp > 210 mV
+	DPHY_SE_LT_160		= 0x04,	//Dp < 160 mV
+	DPHY_SE_GT_125		= 0x08,	//Dp > 125 mV
+	DPHY_SE_LT_25		= 0x10,	//Dp < 25 mV
+
+	//Differential codes
+	DPHY_DIFF_BOTH_LOW	= 0x01,	//Dp < 550 mV and Dn < 550 mV
+	DPHY_DIFF_HS0		= 0x02,	//differential voltage < -50 mV
+	DPHY_DIFF_HS1		= 0x04,	//differential voltage > +50 mV
+	DPHY_DIFF_LP00		= 0x08,	//Dp < 150 mV and Dn < 150 mV
+	DPHY_DIFF_LP01		= 0x10,	//Dp < 550 mV and Dn > 800 mV
+	DPHY_DIFF_LP10		= 0x20,	//Dp > 800 mV and Dn < 550 mV
+	DPHY_DIFF_LP11		= 0x40	//Dp > 800 mV and Dn > 800 mV
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -121,39 +142,96 @@ void DPhySymbolDecoder::Refresh()
 	DPhySymbol::type nextstate = state;
 	cap->PrepareForCpuAccess();
 
-	for(size_t i=0; i<len; i++)
-	{
-		float v = GetValue(sdp, udp, i);
-		int64_t start = GetOffsetScaled(sdp, udp, i);
-		int64_t dur = GetDurationScaled(sdp, udp, i);
+	/*
+		If we have Dp only, we can decode a restricted subset of line states by cheating a bit.
+		This isn't truly spec compliant but allows for protocol decoding with only one probe.
+
+			HS-1
+				Dp > 225 mV
+				Dp < 880 mV
+
+			HS-0
+				Dp > 50 mV
+				Dp < 175 mV
+
+			LP-00 or LP-01 (decode as LP-00)
+				Dp < 50 mV
 
-		/*
-			If we have Dp only, we can decode a restricted subset of line states by cheating a bit.
-			This isn't truly spec compliant but allows for protocol decoding with only one probe.
+			LP-10 or LP-11 (decode as LP-11)
+				Dp > 880 mV
+	*/
 
-				HS-1
-					Dp > 225 mV
-					Dp < 880 mV
+	//Classification pass: pack the threshold comparisons for each sample into compact state codes.
+	//This loop has no cross-sample dependencies (which comparisons *apply* depends on the line state, but the
+	//comparisons themselves don't), so it runs parallel and vectorized; the serial state machine below then
+	//works on integer codes instead of re-deriving float compares on two channels every sample.
+	vector<uint8_t> codes(len);
+	if(!dn)
+	{
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			float v = GetValue(sdp, udp, i);
+			uint8_t code = 0;
+			if(v > 0.88)
+				code |= DPHY_SE_GT_880;
+			if(v > 0.21)
+				code |= DPHY_SE_GT_210;
+			if(v < 0.16)
+				code |= DPHY_SE_LT_160;
+			if(v > 0.125)
+				code |= DPHY_SE_GT_125;
+			if(v < 0.025)
+				code |= DPHY_SE_LT_25;
+			codes[i] = code;
+		}
+	}
+	else
+	{
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			float vp = GetValue(sdp, udp, i);
+			float vn = GetValue(sdn, udn, i);
+			float vd = vp - vn;
 
-				HS-0
-					Dp > 50 mV
-					Dp < 175 mV
+			uint8_t code = 0;
+			if( (vp < 0.55) && (vn < 0.55) )
+			{
+				code |= DPHY_DIFF_BOTH_LOW;
+				if(vd < -0.05)
+					code |= DPHY_DIFF_HS0;
+				else if(vd > 0.05)
+					code |= DPHY_DIFF_HS1;
+				if( (vp < 0.15) && (vn < 0.15) )
+					code |= DPHY_DIFF_LP00;
+			}
+			else if( (vp < 0.55) && (vn > 0.80) )
+				code |= DPHY_DIFF_LP01;
+			else if( (vp > 0.80) && (vn < 0.55) )
+				code |= DPHY_DIFF_LP10;
+			else if( (vp > 0.80) && (vn > 0.80) )
+				code |= DPHY_DIFF_LP11;
+			codes[i] = code;
+		}
+	}
 
-				LP-00 or LP-01 (decode as LP-00)
-					Dp < 50 mV
+	for(size_t i=0; i<len; i++)
+	{
+		uint8_t code = codes[i];
+		int64_t start = GetOffsetScaled(sdp, udp, i);
+		int64_t dur = GetDurationScaled(sdp, udp, i);
 
-				LP-10 or LP-11 (decode as LP-11)
-					Dp > 880 mV
-		*/
+		//Single-ended decode (see comment above for the line state subset)
 		if(!dn)
 		{
 			//Can only go to a HS state from another HS state or LP00
 			if( (state == DPhySymbol::STATE_HS0) ||
 				(state == DPhySymbol::STATE_HS1) )
 			{
-				if(v > 0.88)
+				if(code & DPHY_SE_GT_880)
 					nextstate = DPhySymbol::STATE_LP11;
-				else if(v > 0.21)
+				else if(code & DPHY_SE_GT_210)
 				{
 					//Interpolate the toggle time to sub-sample precision
 					if(i != 0)
@@ -161,7 +239,7 @@ void DPhySymbolDecoder::Refresh()
 
 					nextstate = DPhySymbol::STATE_HS1;
 				}
-				else if(v < 0.16)
+				else if(code & DPHY_SE_LT_160)
 				{
 					if(i != 0)
 						start += dp->m_timescale * InterpolateTime(sdp, udp, i-1, 0.16);
@@ -172,18 +250,18 @@ void DPhySymbolDecoder::Refresh()
 			//LP00 can go to HS0 or stay in LP00
 			else if(state == DPhySymbol::STATE_LP00)
 			{
-				if(v > 0.125)
+				if(code & DPHY_SE_GT_125)
 					nextstate = DPhySymbol::STATE_HS0;
-				else if(v < 0.025)
+				else if(code & DPHY_SE_LT_25)
 					nextstate = DPhySymbol::STATE_LP00;
 			}
 
 			//Otherwise, only consider other LP states
 			else
 			{
-				if(v > 0.88)
+				if(code & DPHY_SE_GT_880)
 					nextstate = DPhySymbol::STATE_LP11;
-				else if(v < 0.025)
+				else if(code & DPHY_SE_LT_25)
 					nextstate = DPhySymbol::STATE_LP00;
 			}
 		}
@@ -191,24 +269,20 @@ void DPhySymbolDecoder::Refresh()
 		//Full differential decode
 		else
 		{
-			float vp = v;
-			float vn = GetValue(sdn, udn, i);
-			float vd = vp - vn;
-
-			if( (vp < 0.55) && (vn < 0.55) )
+			if(code & DPHY_DIFF_BOTH_LOW)
 			{
 				//Can only go to a HS state from another HS state or LP-00
 				if( (state == DPhySymbol::STATE_HS0) ||
 					(state == DPhySymbol::STATE_HS1) ||
 					(state == DPhySymbol::STATE_LP00) )
 				{
-					if(vd < -0.05)
+					if(code & DPHY_DIFF_HS0)
 					{
 						nextstate = DPhySymbol::STATE_HS0;
 						if(i != 0)
 							start += dp->m_timescale * InterpolateTime(sdp, udp, sdn, udn, i-1, -0.05);
 					}
-					else if(vd > 0.05)
+					else if(code & DPHY_DIFF_HS1)
 					{
 						nextstate = DPhySymbol::STATE_HS1;
 						if(i != 0)
@@ -219,15 +293,15 @@ void DPhySymbolDecoder::Refresh()
 				//Can only go to LP-00 from another LP state
 				if( (state != DPhySymbol::STATE_HS0) && (state != DPhySymbol::STATE_HS1) )
 				{
-					if( (vp < 0.15) && (vn < 0.15) )
+					if(code & DPHY_DIFF_LP00)
 						nextstate = DPhySymbol::STATE_LP00;
 				}
 			}
-			else if( (vp < 0.55) && (vn > 0.80) )
+			else if(code & DPHY_DIFF_LP01)
 				nextstate = DPhySymbol::STATE_LP01;
-			else if( (vp > 0.80) && (vn < 0.55) )
+			else if(code & DPHY_DIFF_LP10)
 				nextstate = DPhySymbol::STATE_LP10;
-			else if( (vp > 0.80) && (vn > 0.80) )
+			else if(code & DPHY_DIFF_LP11)
 				nextstate = DPhySymbol::STATE_LP11;
 		}
 
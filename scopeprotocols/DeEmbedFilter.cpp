@@ -38,7 +38,6 @@ using namespace std;
 DeEmbedFilter::DeEmbedFilter(const string& color)
 	: Filter(color, CAT_ANALYSIS)
 	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_deEmbedComputePipeline("shaders/DeEmbedFilter.spv", 3, sizeof(uint32_t))
 	, m_normalizeComputePipeline("shaders/DeEmbedNormalization.spv", 2, sizeof(DeEmbedNormalizationArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
@@ -61,6 +60,7 @@ DeEmbedFilter::DeEmbedFilter(const string& color)
 	m_parameters[m_groupDelayTruncModeName].SetIntVal(TRUNC_AUTO);
 
 	m_cachedBinSize = 0;
+	m_sparamsDirty = true;
 
 	m_cachedNumPoints = 0;
 	m_cachedMaxGain = 0;
@@ -76,6 +76,8 @@ DeEmbedFilter::DeEmbedFilter(const string& color)
 	m_reverseOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_reverseOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
+	m_rawKernelBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_rawKernelBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 DeEmbedFilter::~DeEmbedFilter()
@@ -164,10 +166,10 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	size_t nouts = npoints/2 + 1;
 
 	//Invalidate old vkFFT plans if size has changed
-	if(m_vkForwardPlan)
+	if(m_vkConvPlan)
 	{
-		if(m_vkForwardPlan->size() != npoints)
-			m_vkForwardPlan = nullptr;
+		if(m_vkConvPlan->size() != npoints)
+			m_vkConvPlan = nullptr;
 	}
 	if(m_vkReversePlan)
 	{
@@ -188,8 +190,9 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	}
 
 	//Set up new FFT plans
-	if(!m_vkForwardPlan)
-		m_vkForwardPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	//The reverse plan is only used to turn the frequency domain response into a time domain kernel
+	if(!m_vkConvPlan)
+		m_vkConvPlan = make_unique<VulkanFFTConvolutionPlan>(npoints, nouts);
 	if(!m_vkReversePlan)
 		m_vkReversePlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_REVERSE);
 
@@ -208,7 +211,7 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 		ClearSweeps();
 	}
 
-	//Waveform object changed? Input parameters are no longer valid
+	//Waveform object changed? Input parameters may no longer be valid
 	//We need check for input count because CTLE filter generates S-params internally (and deletes the mag/angle inputs)
 	//TODO: would it be cleaner to generate filter response then channel-emulate it?
 	bool inchange = false;
@@ -219,7 +222,11 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 		if( (m_magKey != dmag) ||
 			(m_angleKey != dang) )
 		{
-			inchange = true;
+			//New waveform object or revision, but possibly identical content: a VNA in continuous sweep mode
+			//re-measures the same frequency grid every trigger, and a stable DUT returns the same values.
+			//Update the cached copy in place and only rebuild the kernel if the data actually changed.
+			if(RefreshCachedSparameters() != SParameterVector::UPDATE_FLAG_NONE)
+				inchange = true;
 
 			m_magKey = dmag;
 			m_angleKey = dang;
@@ -228,11 +235,24 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 
 	//Resample our parameter to our FFT bin size if needed.
 	//Cache trig function output because there's no AVX instructions for this.
-	if( (fabs(m_cachedBinSize - bin_hz) > FLT_EPSILON) || sizechange || clipchange || inchange)
+	bool kernelChanged =
+		(fabs(m_cachedBinSize - bin_hz) > FLT_EPSILON) || sizechange || clipchange || inchange;
+	if(kernelChanged)
 	{
 		m_resampledSparamCosines.clear();
 		m_resampledSparamSines.clear();
 		InterpolateSparameters(bin_hz, invert, nouts);
+
+		//Pack the response into interleaved complex format for the convolution kernel transform
+		m_rawKernelBuf.resize(2 * nouts);
+		m_resampledSparamSines.PrepareForCpuAccess();
+		m_resampledSparamCosines.PrepareForCpuAccess();
+		for(size_t i=0; i<nouts; i++)
+		{
+			m_rawKernelBuf[i*2 + 0] = m_resampledSparamCosines[i];
+			m_rawKernelBuf[i*2 + 1] = m_resampledSparamSines[i];
+		}
+		m_rawKernelBuf.MarkModifiedFromCpu();
 	}
 
 	//Calculate maximum group delay for the first few S-parameter bins (approx propagation delay of the channel)
@@ -267,7 +287,8 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 		cap->m_triggerPhase = -groupdelay_fs;
 	else
 		cap->m_triggerPhase = groupdelay_fs;
-	float scale = 1.0f / npoints;
+	//The kernel transform and the fused convolution are both unnormalized, so the output is scaled by npoints^2
+	float scale = 1.0f / ((float)npoints * (float)npoints);
 	size_t outlen = iend - istart;
 	cap->Resize(outlen);
 	m_cachedOutLen = outlen;
@@ -275,6 +296,17 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
+	//If the frequency response changed, re-transform the convolution kernel: inverse FFT to get the time
+	//domain impulse response, then the kernel plan converts that to vkFFT's internal frequency layout.
+	//This only happens when the sample rate, depth, gain, or S-parameters themselves change.
+	if(kernelChanged)
+	{
+		m_vkReversePlan->AppendReverse(m_rawKernelBuf, m_reverseOutBuf, cmdBuf);
+		m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		m_vkConvPlan->AppendKernelTransform(m_reverseOutBuf, cmdBuf);
+		m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	}
+
 	//Copy and zero-pad the input as needed
 	WindowFunctionArgs args;
 	args.numActualSamples = npoints_raw;
@@ -290,19 +322,9 @@ void DeEmbedFilter::DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, shar
 	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 	m_forwardInBuf.MarkModifiedFromGpu();
 
-	//Do the actual FFT operation
-	m_vkForwardPlan->AppendForward(m_forwardInBuf, m_forwardOutBuf, cmdBuf);
-
-	//Apply the interpolated S-parameters
-	m_deEmbedComputePipeline.BindBufferNonblocking(0, m_forwardOutBuf, cmdBuf);
-	m_deEmbedComputePipeline.BindBufferNonblocking(1, m_resampledSparamSines, cmdBuf);
-	m_deEmbedComputePipeline.BindBufferNonblocking(2, m_resampledSparamCosines, cmdBuf);
-	m_deEmbedComputePipeline.Dispatch(cmdBuf, (uint32_t)nouts, GetComputeBlockCount(npoints, 64));
-	m_deEmbedComputePipeline.AddComputeMemoryBarrier(cmdBuf);
-	m_forwardOutBuf.MarkModifiedFromGpu();
-
-	//Do the actual FFT operation
-	m_vkReversePlan->AppendReverse(m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+	//Forward FFT, complex multiply by the S-parameter kernel, and inverse FFT as one fused operation
+	m_vkConvPlan->AppendConvolution(m_forwardInBuf, m_forwardOutBuf, m_reverseOutBuf, cmdBuf);
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
 
 	//Copy and normalize output
 	//TODO: is there any way to fold this into vkFFT? They can normalize, but offset might be tricky...
@@ -339,6 +361,33 @@ int64_t DeEmbedFilter::GetGroupDelay()
 	return max_delay * FS_PER_SECOND;
 }
 
+/**
+	@brief Updates m_cachedSparams in place from the mag/angle inputs
+
+	@return Bitwise OR of SParameterVector::UpdateFlags values describing what, if anything, changed
+ */
+int DeEmbedFilter::RefreshCachedSparameters()
+{
+	auto wmag = GetInputWaveform(1);
+	auto wang = GetInputWaveform(2);
+	wmag->PrepareForCpuAccess();
+	wang->PrepareForCpuAccess();
+
+	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
+	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
+	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
+	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
+
+	int flags;
+	if(smag && sang)
+		flags = m_cachedSparams.UpdateFromWaveforms(smag, sang);
+	else
+		flags = m_cachedSparams.UpdateFromWaveforms(umag, uang);
+
+	m_sparamsDirty = false;
+	return flags;
+}
+
 /**
 	@brief Recalculate the cached S-parameters (and clamp gain if requested)
 
@@ -350,11 +399,10 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 
 	float maxGain = pow(10, m_parameters[m_maxGainName].GetFloatVal()/20);
 
-	//Extract the S-parameters
-	auto wmag = GetInputWaveform(1);
-	auto wang = GetInputWaveform(2);
-	wmag->PrepareForCpuAccess();
-	wang->PrepareForCpuAccess();
+	//Extract the S-parameters, but only if the underlying mag/angle inputs actually changed.
+	//DoRefresh() normally keeps the cache in sync, but subclasses can dirty it explicitly.
+	if(m_sparamsDirty || (m_cachedSparams.size() == 0))
+		RefreshCachedSparameters();
 
 	m_resampledSparamSines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamSines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -362,52 +410,67 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 	m_resampledSparamCosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamCosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
-	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
-	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
-	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
-	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
-
-	if(smag && sang)
-		m_cachedSparams.ConvertFromWaveforms(smag, sang);
-	else
-		m_cachedSparams.ConvertFromWaveforms(umag, uang);
-
 	m_resampledSparamSines.resize(nouts);
 	m_resampledSparamCosines.resize(nouts);
 
-	//De-embedding
-	if(invert)
+	//Resample one contiguous range of bins (InterpolatePoint is read-only so this is thread safe)
+	auto resample = [this, bin_hz, invert, maxGain] (size_t begin, size_t end)
 	{
-		for(size_t i=0; i<nouts; i++)
+		//De-embedding
+		if(invert)
 		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			float amp = 0;
-			if(fabs(mag) > FLT_EPSILON)
-				amp = 1.0f / mag;
-			amp = min(amp, maxGain);
-
-			m_resampledSparamSines[i] = sin(-ang) * amp;
-			m_resampledSparamCosines[i] = cos(-ang) * amp;
+			for(size_t i=begin; i<end; i++)
+			{
+				float freq = bin_hz * i;
+				auto pt = m_cachedSparams.InterpolatePoint(freq);
+				float mag = pt.m_amplitude;
+				float ang = pt.m_phase;
+
+				float amp = 0;
+				if(fabs(mag) > FLT_EPSILON)
+					amp = 1.0f / mag;
+				amp = min(amp, maxGain);
+
+				m_resampledSparamSines[i] = sin(-ang) * amp;
+				m_resampledSparamCosines[i] = cos(-ang) * amp;
+			}
 		}
-	}
 
-	//Channel emulation
+		//Channel emulation
+		else
+		{
+			for(size_t i=begin; i<end; i++)
+			{
+				float freq = bin_hz * i;
+				auto pt = m_cachedSparams.InterpolatePoint(freq);
+				float mag = pt.m_amplitude;
+				float ang = pt.m_phase;
+
+				m_resampledSparamSines[i] = sin(ang) * mag;
+				m_resampledSparamCosines[i] = cos(ang) * mag;
+			}
+		}
+	};
+
+	//Split the work across threads for large FFTs, since there's no AVX sin/cos and the
+	//per-bin trig dominates the runtime
+	const size_t minBinsPerThread = 65536;
+	size_t nthreads = max<size_t>(thread::hardware_concurrency(), 1);
+	nthreads = min(nthreads, nouts / minBinsPerThread);
+	if(nthreads <= 1)
+		resample(0, nouts);
 	else
 	{
-		for(size_t i=0; i<nouts; i++)
+		size_t binsPerThread = (nouts + nthreads - 1) / nthreads;
+		vector<thread> threads;
+		for(size_t t=0; t<nthreads; t++)
 		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			m_resampledSparamSines[i] = sin(ang) * mag;
-			m_resampledSparamCosines[i] = cos(ang) * mag;
+			size_t begin = t * binsPerThread;
+			size_t end = min(begin + binsPerThread, nouts);
+			threads.emplace_back([&resample, begin, end] { resample(begin, end); });
 		}
+		for(auto& t : threads)
+			t.join();
 	}
 
 	m_resampledSparamSines.MarkModifiedFromCpu();
@@ -76,6 +76,7 @@ protected:
 	virtual int64_t GetGroupDelay();
 	void DoRefresh(bool invert, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 	virtual void InterpolateSparameters(float bin_hz, bool invert, size_t nouts);
+	int RefreshCachedSparameters();
 
 	std::string m_maxGainName;
 	std::string m_groupDelayTruncModeName;
@@ -89,6 +90,9 @@ protected:
 
 	float m_cachedMaxGain;
 
+	///@brief True if m_cachedSparams needs to be rebuilt from the mag/angle inputs
+	bool m_sparamsDirty;
+
 	double m_cachedBinSize;
 	AcceleratorBuffer<float> m_resampledSparamSines;
 	AcceleratorBuffer<float> m_resampledSparamCosines;
@@ -106,11 +110,13 @@ protected:
 
 	SParameterVector m_cachedSparams;
 
+	///@brief Interleaved complex frequency response, fed to the kernel transform when the response changes
+	AcceleratorBuffer<float> m_rawKernelBuf;
+
 	ComputePipeline m_rectangularComputePipeline;
-	ComputePipeline m_deEmbedComputePipeline;
 	ComputePipeline m_normalizeComputePipeline;
-	std::unique_ptr<VulkanFFTPlan> m_vkForwardPlan;
 	std::unique_ptr<VulkanFFTPlan> m_vkReversePlan;
+	std::unique_ptr<VulkanFFTConvolutionPlan> m_vkConvPlan;
 };
 
 #endif
@@ -28,6 +28,7 @@
 ***********************************************************************************************************************/
 
 #include "../scopehal/scopehal.h"
+#include "AutocorrelationFilter.h"
 #include "DeskewFilter.h"
 
 using namespace std;
@@ -37,13 +38,29 @@ using namespace std;
 
 DeskewFilter::DeskewFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_cachedNumPoints(0)
+	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_kernelComputePipeline("shaders/AutocorrelationKernel.spv", 2, sizeof(AutocorrelationKernelArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
+	CreateInput("ref");
 
 	m_skewname = "Skew";
 	m_parameters[m_skewname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_FS));
 	m_parameters[m_skewname].SetFloatVal(0);
+
+	m_corrInBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_corrInBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_corrOutBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_corrOutBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_corrRevBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_corrRevBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_kernelBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_kernelBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,7 +71,7 @@ bool DeskewFilter::ValidateChannel(size_t i, StreamDescriptor stream)
 	if(stream.m_channel == NULL)
 		return false;
 
-	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+	if( (i < 2) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
 		return true;
 
 	return false;
@@ -68,12 +85,28 @@ string DeskewFilter::GetProtocolName()
 	return "Deskew";
 }
 
+vector<string> DeskewFilter::EnumActions()
+{
+	vector<string> ret;
+	ret.push_back("Align");
+	return ret;
+}
+
+bool DeskewFilter::PerformAction(const string& id)
+{
+	if(id == "Align")
+		AutoAlign();
+
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
 void DeskewFilter::Refresh()
 {
-	if(!VerifyAllInputsOK())
+	//Only the signal input is needed to apply the skew; the reference is just for automatic alignment
+	if(!VerifyInputOK(0))
 	{
 		SetData(NULL, 0);
 		return;
@@ -102,3 +135,149 @@ void DeskewFilter::Refresh()
 		cap->m_triggerPhase += offset;
 	}
 }
+
+/**
+	@brief Measures the skew between the signal and the reference input, and sets the skew parameter to cancel it
+
+	The lag is found as the peak of the cross-correlation of the two records, computed in the frequency domain,
+	then refined to sub-sample resolution with a parabolic fit around the peak.
+ */
+void DeskewFilter::AutoAlign()
+{
+	//Need both the signal and the reference connected and populated
+	if(!VerifyInputOK(0) || !VerifyInputOK(1))
+	{
+		LogWarning("DeskewFilter: automatic alignment needs both the signal and reference inputs connected\n");
+		return;
+	}
+
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	auto ref = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(1));
+	if(!din || !ref)
+	{
+		LogWarning("DeskewFilter: automatic alignment requires uniformly sampled inputs\n");
+		return;
+	}
+	if(din->m_timescale != ref->m_timescale)
+	{
+		LogWarning("DeskewFilter: automatic alignment requires both inputs at the same sample rate\n");
+		return;
+	}
+
+	size_t dlen = din->size();
+	size_t rlen = ref->size();
+
+	//Zero pad far enough that positive and negative lags can't wrap into each other
+	const size_t npoints = next_pow2(dlen + rlen);
+	size_t nouts = npoints/2 + 1;
+
+	//Alignment runs from a UI action, not the filter graph dispatch path, so we bring our own
+	//queue and command buffer rather than getting one handed to us by the executor
+	if(!m_queue)
+	{
+		m_queue = g_vkQueueManager->GetComputeQueue("DeskewFilter.queue");
+		vk::CommandPoolCreateInfo poolInfo(
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+			m_queue->m_family );
+		m_pool = make_unique<vk::raii::CommandPool>(*g_vkComputeDevice, poolInfo);
+
+		vk::CommandBufferAllocateInfo bufinfo(**m_pool, vk::CommandBufferLevel::ePrimary, 1);
+		m_cmdBuf = make_unique<vk::raii::CommandBuffer>(
+			std::move(vk::raii::CommandBuffers(*g_vkComputeDevice, bufinfo).front()));
+	}
+
+	//Invalidate old vkFFT plan if size has changed
+	if(m_vkConvPlan)
+	{
+		if(m_vkConvPlan->size() != npoints)
+			m_vkConvPlan = nullptr;
+	}
+
+	//Allocate buffers if we change point count
+	if(m_cachedNumPoints != npoints)
+	{
+		m_corrInBuf.resize(npoints);
+		m_corrOutBuf.resize(2 * nouts);
+		m_corrRevBuf.resize(npoints);
+		m_kernelBuf.resize(npoints);
+
+		m_cachedNumPoints = npoints;
+	}
+
+	//Set up a new FFT plan
+	if(!m_vkConvPlan)
+		m_vkConvPlan = make_unique<VulkanFFTConvolutionPlan>(npoints, nouts);
+
+	auto& cmdBuf = *m_cmdBuf;
+	cmdBuf.begin({});
+
+	//Time reverse the reference into a correlation kernel, so the fused convolution
+	//becomes a cross-correlation against the signal
+	AutocorrelationKernelArgs kargs;
+	kargs.npoints = npoints;
+	kargs.kernlen = rlen;
+	m_kernelComputePipeline.BindBufferNonblocking(0, ref->m_samples, cmdBuf);
+	m_kernelComputePipeline.BindBufferNonblocking(1, m_kernelBuf, cmdBuf, true);
+	m_kernelComputePipeline.Dispatch(cmdBuf, kargs, GetComputeBlockCount(npoints, 64));
+	m_kernelComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_kernelBuf.MarkModifiedFromGpu();
+	m_vkConvPlan->AppendKernelTransform(m_kernelBuf, cmdBuf);
+	m_kernelComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Copy and zero-pad the signal
+	WindowFunctionArgs args;
+	args.numActualSamples = dlen;
+	args.npoints = npoints;
+	args.scale = 0;
+	args.alpha0 = 0;
+	args.alpha1 = 0;
+	args.offsetIn = 0;
+	args.offsetOut = 0;
+	m_rectangularComputePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_rectangularComputePipeline.BindBufferNonblocking(1, m_corrInBuf, cmdBuf, true);
+	m_rectangularComputePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(npoints, 64));
+	m_rectangularComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_corrInBuf.MarkModifiedFromGpu();
+
+	//Forward FFT, complex multiply by the reference spectrum, and inverse FFT as one fused operation
+	m_vkConvPlan->AppendConvolution(m_corrInBuf, m_corrOutBuf, m_corrRevBuf, cmdBuf);
+
+	cmdBuf.end();
+	m_queue->SubmitAndBlock(cmdBuf);
+	m_corrRevBuf.MarkModifiedFromGpu();
+
+	//Find the correlation peak (we don't care about the absolute magnitude, so no need to normalize first)
+	m_corrRevBuf.PrepareForCpuAccess();
+	size_t imax = 0;
+	float vmax = -FLT_MAX;
+	for(size_t i=0; i<npoints; i++)
+	{
+		if(m_corrRevBuf[i] > vmax)
+		{
+			vmax = m_corrRevBuf[i];
+			imax = i;
+		}
+	}
+
+	//Refine to sub-sample resolution with a parabolic fit through the peak and its neighbors
+	float c0 = m_corrRevBuf[(imax + npoints - 1) % npoints];
+	float c2 = m_corrRevBuf[(imax + 1) % npoints];
+	float denom = c0 - 2*vmax + c2;
+	float frac = 0;
+	if(fabs(denom) > FLT_EPSILON)
+		frac = 0.5f * (c0 - c2) / denom;
+
+	//Bins past the midpoint are negative lags
+	double lag = imax;
+	if(imax > npoints/2)
+		lag -= npoints;
+	lag += frac;
+
+	//A peak at lag N means the signal's features occur N samples later than the reference's.
+	//Fold in the difference in trigger phase so records captured with different trigger alignment
+	//deskew correctly too.
+	double skew = (ref->m_triggerPhase - din->m_triggerPhase) - lag * din->m_timescale;
+	m_parameters[m_skewname].SetFloatVal(skew);
+
+	LogTrace("DeskewFilter: aligned at lag %.3f samples, skew %.0f fs\n", lag, skew);
+}
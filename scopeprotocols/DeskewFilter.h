@@ -35,7 +35,11 @@
 #ifndef DeskewFilter_h
 #define DeskewFilter_h
 
-class DeskewFilter : public Filter
+#include "../scopehal/ActionProvider.h"
+
+class DeskewFilter
+	: public Filter
+	, public ActionProvider
 {
 public:
 	DeskewFilter(const std::string& color);
@@ -46,10 +50,31 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
+	virtual std::vector<std::string> EnumActions() override;
+	virtual bool PerformAction(const std::string& id) override;
+
 	PROTOCOL_DECODER_INITPROC(DeskewFilter)
 
 protected:
+	void AutoAlign();
+
 	std::string m_skewname;
+
+	size_t m_cachedNumPoints;
+
+	AcceleratorBuffer<float> m_corrInBuf;
+	AcceleratorBuffer<float> m_corrOutBuf;
+	AcceleratorBuffer<float> m_corrRevBuf;
+	AcceleratorBuffer<float> m_kernelBuf;
+
+	ComputePipeline m_rectangularComputePipeline;
+	ComputePipeline m_kernelComputePipeline;
+	std::unique_ptr<VulkanFFTConvolutionPlan> m_vkConvPlan;
+
+	///@brief Queue for running the alignment outside the normal filter graph dispatch path
+	std::shared_ptr<QueueHandle> m_queue;
+	std::unique_ptr<vk::raii::CommandPool> m_pool;
+	std::unique_ptr<vk::raii::CommandBuffer> m_cmdBuf;
 };
 
 #endif
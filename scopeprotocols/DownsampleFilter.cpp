@@ -37,6 +37,7 @@ using namespace std;
 
 DownsampleFilter::DownsampleFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_computePipeline("shaders/DownsampleFilter.spv", 3, sizeof(DownsampleFilterArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("RF");
@@ -48,6 +49,13 @@ DownsampleFilter::DownsampleFilter(const string& color)
 	m_aaname = "Antialiasing Filter";
 	m_parameters[m_aaname] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
 	m_parameters[m_aaname].SetBoolVal(1);
+
+	m_cachedKernelFactor = 0;
+	m_cachedFactor = 0;
+	m_cachedAA = false;
+
+	m_kernel.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_kernel.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -72,10 +80,22 @@ string DownsampleFilter::GetProtocolName()
 	return "Downsample";
 }
 
+Filter::DataLocation DownsampleFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
+bool DownsampleFilter::IsDeferredSubmitSafe()
+{
+	//The GPU path never reads results back within Refresh(), so the executor may defer our fence wait
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void DownsampleFilter::Refresh()
+void DownsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOKAndUniformAnalog())
 	{
@@ -97,66 +117,127 @@ void DownsampleFilter::Refresh()
 		// Occurs momentarily while editing the value sometimes in glscopeclient
 		return;
 	}
+	bool aa = m_parameters[m_aaname].GetBoolVal();
+
+	//If the input waveform and our configuration are unchanged since the last refresh, the output is still
+	//valid and there's nothing to do. This makes chained downsample stages (/10 into /10 etc) free when only
+	//later parts of the graph changed.
+	if( (GetData(0) != nullptr) && (m_inputKey == din) && (m_cachedFactor == factor) && (m_cachedAA == aa) )
+		return;
 
 	size_t outlen = len / factor;
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
 	cap->Resize(outlen);
 
-	cap->PrepareForCpuAccess();
-	din->PrepareForCpuAccess();
-
 	//Default path with antialiasing filter
-	if(m_parameters[m_aaname].GetBoolVal())
+	if(aa)
 	{
-		//Cut off all frequencies shorter than our decimation factor
+		//Cut off all frequencies shorter than our decimation factor.
+		//Regenerate the Gaussian kernel only when the factor changes, so the tap buffer stays resident on
+		//the GPU across refreshes rather than being rebuilt and re-uploaded every waveform.
 		float cutoff_period = factor;
 		float sigma = cutoff_period / sqrt(2 * log(2));
 		int kernel_radius = ceil(3*sigma);
-
-		//Generate the actual Gaussian kernel
 		int kernel_size = kernel_radius*2 + 1;
-		vector<float> kernel;
-		kernel.resize(kernel_size);
-		float alpha = 1.0f / (sigma * sqrt(2*M_PI));
-		for(int x=0; x < kernel_size; x++)
+		if(m_cachedKernelFactor != factor)
 		{
-			int delta = (x - kernel_radius);
-			kernel[x] = alpha * exp(-delta*delta/(2*sigma));
+			m_kernel.resize(kernel_size);
+			m_kernel.PrepareForCpuAccess();
+			float alpha = 1.0f / (sigma * sqrt(2*M_PI));
+			for(int x=0; x < kernel_size; x++)
+			{
+				int delta = (x - kernel_radius);
+				m_kernel[x] = alpha * exp(-delta*delta/(2*sigma));
+			}
+			float sum = 0;
+			for(int i=0; i<kernel_size; i++)
+				sum += m_kernel[i];
+			for(int i=0; i<kernel_size; i++)
+				m_kernel[i] /= sum;
+			m_kernel.MarkModifiedFromCpu();
+
+			m_cachedKernelFactor = factor;
 		}
-		float sum = 0;
-		for(auto k : kernel)
-			sum += k;
-		for(int i=0; i<kernel_size; i++)
-			kernel[i] /= sum;
 
 		//Do the actual downsampling.
-		for(size_t i=0; i<outlen; i++)
+		//The convolution is polyphase: it's only evaluated at the decimated output positions, never at the
+		//input samples we're about to discard, so total work is O(input length) for any factor.
+		if(g_gpuFilterEnabled)
 		{
-			//Do the convolution
-			float conv = 0;
-			ssize_t base = i*factor;
-			for(ssize_t delta = -kernel_radius; delta <= kernel_radius; delta ++)
+			//Cap the amount of work in each submit so huge records can't stall the GPU long enough to trip
+			//the OS watchdog (2 seconds by default on Windows) and get the device reset out from under us.
+			//This also keeps us under the workgroup count limit of drivers with a small maxComputeWorkGroupCount.
+			const size_t maxBlocksPerDispatch = 32768;
+			const size_t tilesize = maxBlocksPerDispatch * 64;
+
+			DownsampleFilterArgs args;
+			args.end = outlen;
+			args.inlen = len;
+			args.factor = factor;
+			args.radius = kernel_radius;
+
+			for(size_t offset = 0; offset < outlen; offset += tilesize)
 			{
-				ssize_t pos = base + delta;
-				if( (pos < 0) || (pos >= (ssize_t)len) )
-					continue;
+				size_t tilelen = min(outlen - offset, tilesize);
+				args.offset = offset;
+
+				cmdBuf.begin({});
+				m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+				m_computePipeline.BindBufferNonblocking(1, m_kernel, cmdBuf);
+				m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
+				m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(tilelen, 64));
+				cmdBuf.end();
+				queue->SubmitAndBlock(cmdBuf);
+			}
+
+			cap->m_samples.MarkModifiedFromGpu();
+		}
 
-				conv += din->m_samples[pos] * kernel[delta + kernel_radius];
+		else
+		{
+			din->PrepareForCpuAccess();
+			cap->PrepareForCpuAccess();
+			m_kernel.PrepareForCpuAccess();
+
+			for(size_t i=0; i<outlen; i++)
+			{
+				//Do the convolution
+				float conv = 0;
+				ssize_t base = i*factor;
+				for(ssize_t delta = -kernel_radius; delta <= kernel_radius; delta ++)
+				{
+					ssize_t pos = base + delta;
+					if( (pos < 0) || (pos >= (ssize_t)len) )
+						continue;
+
+					conv += din->m_samples[pos] * m_kernel[delta + kernel_radius];
+				}
+
+				//Do the actual decimation
+				cap->m_samples[i] 	= conv;
 			}
 
-			//Do the actual decimation
-			cap->m_samples[i] 	= conv;
+			cap->MarkModifiedFromCpu();
 		}
 	}
 
 	//Optimized path with no AA if the input is known to not contain any higher frequency content
 	else
 	{
+		din->PrepareForCpuAccess();
+		cap->PrepareForCpuAccess();
+
 		for(size_t i=0; i<outlen; i++)
 			cap->m_samples[i]	= din->m_samples[i*factor];
+
+		cap->MarkModifiedFromCpu();
 	}
 
 	//Copy our time scales from the input
 	cap->m_timescale = din->m_timescale * factor;
-	cap->MarkModifiedFromCpu();
+
+	//Remember what this output was computed from
+	m_inputKey = WaveformCacheKey(din);
+	m_cachedFactor = factor;
+	m_cachedAA = aa;
 }
@@ -35,15 +35,31 @@
 #ifndef DownsampleFilter_h
 #define DownsampleFilter_h
 
+struct DownsampleFilterArgs
+{
+	uint32_t end;
+	uint32_t inlen;
+	uint32_t factor;
+	uint32_t radius;
+	uint32_t offset;
+};
+
 /**
 	@brief Downsample - low-pass filter and decimate a signal
+
+	The anti-alias convolution is polyphase: it's only evaluated at the output sample positions, so the total
+	work is proportional to the input length regardless of the decimation factor. When the input waveform and
+	configuration are unchanged since the last refresh (common when chained behind another downsample stage),
+	the previous output is reused without recomputing.
  */
 class DownsampleFilter : public Filter
 {
 public:
 	DownsampleFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
+	virtual bool IsDeferredSubmitSafe() override;
 
 	static std::string GetProtocolName();
 
@@ -54,6 +70,23 @@ public:
 protected:
 	std::string m_factorname;
 	std::string m_aaname;
+
+	ComputePipeline m_computePipeline;
+
+	///@brief Gaussian anti-alias kernel, cached on the GPU across refreshes
+	AcceleratorBuffer<float> m_kernel;
+
+	///@brief Decimation factor m_kernel was generated for (0 = not yet generated)
+	int64_t m_cachedKernelFactor;
+
+	///@brief Input waveform the current output was computed from
+	WaveformCacheKey m_inputKey;
+
+	///@brief Decimation factor the current output was computed with
+	int64_t m_cachedFactor;
+
+	///@brief Anti-alias setting the current output was computed with
+	bool m_cachedAA;
 };
 
 #endif
@@ -94,13 +94,18 @@ vector<string> ESPIDecoder::GetHeaders()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void ESPIDecoder::Refresh()
+bool ESPIDecoder::IsRefreshIncomplete()
 {
-	ClearPackets();
+	return m_state != nullptr;
+}
 
+void ESPIDecoder::Refresh()
+{
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
+		m_state = nullptr;
 		SetData(NULL, 0);
 		return;
 	}
@@ -142,102 +147,70 @@ void ESPIDecoder::Refresh()
 		data3->size()
 	};
 
-	//Figure out the bus width to use for protocol decoding
-	auto busWidthMode = static_cast<BusWidth>(m_parameters[m_busWidthName].GetIntVal());
-	BusWidth busWidthModeNext = busWidthMode;
-	bool busWidthModeChanged = false;
-
-	size_t ics			= 0;
-	size_t iclk			= 0;
-	size_t idata[4]		= {0};
-	int64_t timestamp	= 0;
-
-	//Create the waveform. Call SetData() early on so we can use GetText() in the packet decode
-	auto cap = new ESPIWaveform;
-	cap->m_timescale = clk->m_timescale;
-	cap->m_startTimestamp = clk->m_startTimestamp;
-	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
-	cap->m_triggerPhase = clk->m_triggerPhase;
-	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
-
-	ESPISymbol samp;
-	enum
+	//Starting a fresh decode? Create the output waveform and a clean state machine.
+	//If m_state is non-null, the previous Refresh() ran out of its time slice and we pick up where it left off.
+	ESPIWaveform* cap;
+	if(!m_state)
 	{
-		LINK_STATE_DESELECTED,
-		LINK_STATE_SELECTED_CLKLO,
-		LINK_STATE_SELECTED_CLKHI
-
-	} link_state = LINK_STATE_DESELECTED;
-
-	enum
+		ClearPackets();
+
+		//Create the waveform. Call SetData() early on so we can use GetText() in the packet decode
+		cap = new ESPIWaveform;
+		cap->m_timescale = clk->m_timescale;
+		cap->m_startTimestamp = clk->m_startTimestamp;
+		cap->m_startFemtoseconds = clk->m_startFemtoseconds;
+		cap->m_triggerPhase = clk->m_triggerPhase;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+
+		m_state = make_unique<DecodeState>();
+
+		//Figure out the bus width to use for protocol decoding
+		m_state->m_busWidthMode = static_cast<BusWidth>(m_parameters[m_busWidthName].GetIntVal());
+		m_state->m_busWidthModeNext = m_state->m_busWidthMode;
+	}
+	else
 	{
-		TXN_STATE_IDLE,
-
-		TXN_STATE_OPCODE,
-		TXN_STATE_CONFIG_ADDRESS,
-		TXN_STATE_CONFIG_DATA,
-		TXN_STATE_COMMAND_CRC8,
-
-		TXN_STATE_RESPONSE,
-		TXN_STATE_RESPONSE_DATA,
-		TXN_STATE_STATUS,
-		TXN_STATE_RESPONSE_CRC8,
-
-		TXN_STATE_VWIRE_COUNT,
-		TXN_STATE_VWIRE_INDEX,
-		TXN_STATE_VWIRE_DATA,
-
-		TXN_STATE_FLASH_TYPE,
-		TXN_STATE_FLASH_TAG_LENHI,
-		TXN_STATE_FLASH_LENLO,
-		TXN_STATE_FLASH_ADDR,
-		TXN_STATE_FLASH_DATA,
-
-		TXN_STATE_SMBUS_TYPE,
-		TXN_STATE_SMBUS_TAG_LENHI,
-		TXN_STATE_SMBUS_LENLO,
-		TXN_STATE_SMBUS_ADDR,
-		TXN_STATE_SMBUS_DATA,
-
-		TXN_STATE_IOWR_ADDR,
-		TXN_STATE_IOWR_DATA,
-
-		TXN_STATE_IORD_ADDR,
-
-		TXN_STATE_COMPLETION_TYPE,
-		TXN_STATE_COMPLETION_TAG_LENHI,
-		TXN_STATE_COMPLETION_LENLO,
-		TXN_STATE_COMPLETION_DATA
-
-	} txn_state = TXN_STATE_IDLE;
-
-	ESPISymbol::ESpiCommand current_cmd = ESPISymbol::COMMAND_RESET;
-	Packet* pack = NULL;
+		cap = dynamic_cast<ESPIWaveform*>(GetData(0));
+		cap->PrepareForCpuAccess();
+	}
 
-	enum
-	{
-		READ_SI,
-		READ_SO,
-		READ_QUAD_RISING,
-		READ_QUAD_FALLING
-	} read_mode = READ_SI;
-
-	size_t count = 0;
-	size_t tstart = 0;
-	uint8_t crc = 0;
-	uint64_t data = 0;
-	uint64_t addr = 0;
-	size_t payload_len = 0;
-
-	int skip_bits			= 0;
-	bool skip_next_falling	= false;
-	int bitcount			= 0;
-	int64_t bytestart		= 0;
-	uint8_t current_byte	= 0;
-	bool byte_valid_next	= false;
-	ESPISymbol::ESpiCompletion completion_type	= ESPISymbol::COMPLETION_NONE;
-	ESPISymbol::ESpiCycleType cycle_type = ESPISymbol::CYCLE_READ;
+	//Alias the saved state machine so the decode loop can refer to it by the original variable names
+	DecodeState& s = *m_state;
+	auto& busWidthMode = s.m_busWidthMode;
+	auto& busWidthModeNext = s.m_busWidthModeNext;
+	auto& busWidthModeChanged = s.m_busWidthModeChanged;
+	auto& ics = s.m_ics;
+	auto& iclk = s.m_iclk;
+	auto& idata = s.m_idata;
+	auto& timestamp = s.m_timestamp;
+	auto& samp = s.m_samp;
+	auto& link_state = s.m_linkState;
+	auto& txn_state = s.m_txnState;
+	auto& current_cmd = s.m_currentCmd;
+	auto& pack = s.m_pack;
+	auto& read_mode = s.m_readMode;
+	auto& count = s.m_count;
+	auto& tstart = s.m_tstart;
+	auto& crc = s.m_crc;
+	auto& data = s.m_data;
+	auto& addr = s.m_addr;
+	auto& payload_len = s.m_payloadLen;
+	auto& skip_bits = s.m_skipBits;
+	auto& skip_next_falling = s.m_skipNextFalling;
+	auto& bitcount = s.m_bitcount;
+	auto& bytestart = s.m_bytestart;
+	auto& current_byte = s.m_currentByte;
+	auto& byte_valid_next = s.m_byteValidNext;
+	auto& completion_type = s.m_completionType;
+	auto& cycle_type = s.m_cycleType;
+
+	//Decode in bounded time slices so one deep capture doesn't monopolize an executor thread: if we run out
+	//of time, keep the state machine around, publish what we have so far, and finish on the next Refresh()
+	const double sliceStart = GetTime();
+	const double maxSliceTime = 0.05;
+	size_t iterations = 0;
+	bool outOfTime = false;
 	while(true)
 	{
 		bool cur_cs = GetValue(scsn, ucsn, ics);
@@ -402,7 +375,7 @@ void ESPIDecoder::Refresh()
 				case TXN_STATE_OPCODE:
 
 					//Create a new packet
-					pack = new Packet;
+					pack = AllocatePacket();
 					pack->m_len = 0;
 					m_packets.push_back(pack);
 
@@ -1440,27 +1413,27 @@ void ESPIDecoder::Refresh()
 		AdvanceToTimestamp(sdata1, udata1, idata[1], datalen[1], timestamp);
 		AdvanceToTimestamp(sdata2, udata2, idata[2], datalen[2], timestamp);
 		AdvanceToTimestamp(sdata3, udata3, idata[3], datalen[3], timestamp);
+
+		//Yield if we've used up our time slice (check periodically, GetTime() is too costly to call every sample)
+		iterations ++;
+		if( ( (iterations & 0xffff) == 0) && ( (GetTime() - sliceStart) > maxSliceTime) )
+		{
+			outOfTime = true;
+			break;
+		}
 	}
 
 	cap->MarkModifiedFromCpu();
+
+	//Reached the end of the capture? Discard the resume state so the next Refresh() starts a fresh decode
+	if(!outOfTime)
+		m_state = nullptr;
 }
 
 uint8_t ESPIDecoder::UpdateCRC8(uint8_t crc, uint8_t data)
 {
 	//CRC runs MSB first using polynomial x^8 + x^2 + x + 1
-	for(int i=7; i>=0; i--)
-	{
-		//Shift CRC left and save the high bit
-		uint8_t hi = crc >> 7;
-		crc = (crc << 1);
-
-		//Mix in the new data bit
-		hi ^= ( (data >> i) & 1);
-		if(hi)
-			crc ^= 0x7;
-	}
-
-	return crc;
+	return CRC8ATMUpdate(crc, data);
 }
 
 std::string ESPIWaveform::GetColor(size_t i)
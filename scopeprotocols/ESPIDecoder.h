@@ -204,6 +204,7 @@ public:
 	ESPIDecoder(const std::string& color);
 
 	virtual void Refresh() override;
+	virtual bool IsRefreshIncomplete() override;
 
 	std::vector<std::string> GetHeaders() override;
 
@@ -226,6 +227,135 @@ protected:
 		BUS_WIDTH_X4
 	};
 
+	enum LinkState
+	{
+		LINK_STATE_DESELECTED,
+		LINK_STATE_SELECTED_CLKLO,
+		LINK_STATE_SELECTED_CLKHI
+	};
+
+	enum TxnState
+	{
+		TXN_STATE_IDLE,
+
+		TXN_STATE_OPCODE,
+		TXN_STATE_CONFIG_ADDRESS,
+		TXN_STATE_CONFIG_DATA,
+		TXN_STATE_COMMAND_CRC8,
+
+		TXN_STATE_RESPONSE,
+		TXN_STATE_RESPONSE_DATA,
+		TXN_STATE_STATUS,
+		TXN_STATE_RESPONSE_CRC8,
+
+		TXN_STATE_VWIRE_COUNT,
+		TXN_STATE_VWIRE_INDEX,
+		TXN_STATE_VWIRE_DATA,
+
+		TXN_STATE_FLASH_TYPE,
+		TXN_STATE_FLASH_TAG_LENHI,
+		TXN_STATE_FLASH_LENLO,
+		TXN_STATE_FLASH_ADDR,
+		TXN_STATE_FLASH_DATA,
+
+		TXN_STATE_SMBUS_TYPE,
+		TXN_STATE_SMBUS_TAG_LENHI,
+		TXN_STATE_SMBUS_LENLO,
+		TXN_STATE_SMBUS_ADDR,
+		TXN_STATE_SMBUS_DATA,
+
+		TXN_STATE_IOWR_ADDR,
+		TXN_STATE_IOWR_DATA,
+
+		TXN_STATE_IORD_ADDR,
+
+		TXN_STATE_COMPLETION_TYPE,
+		TXN_STATE_COMPLETION_TAG_LENHI,
+		TXN_STATE_COMPLETION_LENLO,
+		TXN_STATE_COMPLETION_DATA
+	};
+
+	enum ReadMode
+	{
+		READ_SI,
+		READ_SO,
+		READ_QUAD_RISING,
+		READ_QUAD_FALLING
+	};
+
+	/**
+		@brief Saved state of the decode state machine, letting Refresh() resume where the last time slice left off
+
+		Allocated when a decode begins and freed when the capture has been fully processed. A non-null m_state after
+		Refresh() returns means the decode ran out of its time slice partway through and needs another run to finish.
+	 */
+	class DecodeState
+	{
+	public:
+		DecodeState()
+			: m_busWidthMode(BUS_WIDTH_AUTO)
+			, m_busWidthModeNext(BUS_WIDTH_AUTO)
+			, m_busWidthModeChanged(false)
+			, m_ics(0)
+			, m_iclk(0)
+			, m_idata{0}
+			, m_timestamp(0)
+			, m_linkState(LINK_STATE_DESELECTED)
+			, m_txnState(TXN_STATE_IDLE)
+			, m_currentCmd(ESPISymbol::COMMAND_RESET)
+			, m_pack(NULL)
+			, m_readMode(READ_SI)
+			, m_count(0)
+			, m_tstart(0)
+			, m_crc(0)
+			, m_data(0)
+			, m_addr(0)
+			, m_payloadLen(0)
+			, m_skipBits(0)
+			, m_skipNextFalling(false)
+			, m_bitcount(0)
+			, m_bytestart(0)
+			, m_currentByte(0)
+			, m_byteValidNext(false)
+			, m_completionType(ESPISymbol::COMPLETION_NONE)
+			, m_cycleType(ESPISymbol::CYCLE_READ)
+		{}
+
+		BusWidth m_busWidthMode;
+		BusWidth m_busWidthModeNext;
+		bool m_busWidthModeChanged;
+
+		size_t m_ics;
+		size_t m_iclk;
+		size_t m_idata[4];
+		int64_t m_timestamp;
+
+		ESPISymbol m_samp;
+		LinkState m_linkState;
+		TxnState m_txnState;
+		ESPISymbol::ESpiCommand m_currentCmd;
+		Packet* m_pack;
+		ReadMode m_readMode;
+
+		size_t m_count;
+		size_t m_tstart;
+		uint8_t m_crc;
+		uint64_t m_data;
+		uint64_t m_addr;
+		size_t m_payloadLen;
+
+		int m_skipBits;
+		bool m_skipNextFalling;
+		int m_bitcount;
+		int64_t m_bytestart;
+		uint8_t m_currentByte;
+		bool m_byteValidNext;
+		ESPISymbol::ESpiCompletion m_completionType;
+		ESPISymbol::ESpiCycleType m_cycleType;
+	};
+
+	std::unique_ptr<DecodeState> m_state;
+
 	std::string m_busWidthName;
 };
 
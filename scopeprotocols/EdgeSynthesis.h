@@ -0,0 +1,128 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Shared structures for the EdgeSynthesis compute shader
+ */
+#ifndef EdgeSynthesis_h
+#define EdgeSynthesis_h
+
+/**
+	@brief Push constants for the EdgeSynthesis shader.
+
+	The shader synthesizes a uniform analog waveform from a list of edge segments. Each output sample looks up
+	the most recent segment, computes the time elapsed since that segment's edge, interpolates the segment's
+	shape table at that time, then blends between the segment's start and end voltage levels.
+
+	Up to two shape tables (typically rising and falling edges) are packed into a single buffer of
+	(time, value) pairs; offsets and lengths here are in units of pairs.
+ */
+struct EdgeSynthesisArgs
+{
+	uint32_t nsamples;
+	uint32_t nsegments;
+	float samplePeriodSec;
+	uint32_t shapeOffset0;
+	uint32_t shapeLen0;
+	uint32_t shapeOffset1;
+	uint32_t shapeLen1;
+};
+
+///@brief One edge segment for the EdgeSynthesis shader (must match the GLSL struct layout)
+struct EdgeSynthesisSegment
+{
+	///@brief Time from the segment's first output sample back to the edge itself, in seconds
+	float residualSec;
+
+	///@brief Voltage at shape value 0
+	float vStart;
+
+	///@brief Voltage at shape value 1
+	float vEnd;
+
+	///@brief Which shape table this segment uses (0 or 1)
+	uint32_t shapeIndex;
+};
+
+/**
+	@brief Software fallback for the EdgeSynthesis shader, using identical math.
+
+	Parallelizes across segments; within a segment the shape table is walked with a monotonic cursor since
+	elapsed time only increases.
+ */
+inline void SynthesizeEdgesCpu(
+	AcceleratorBuffer<float>& dout,
+	AcceleratorBuffer<uint32_t>& segStarts,
+	AcceleratorBuffer<EdgeSynthesisSegment>& segments,
+	AcceleratorBuffer<float>& shapes,
+	const EdgeSynthesisArgs& args)
+{
+	const float* shapedata = shapes.GetCpuPointer();
+
+	#pragma omp parallel for
+	for(int64_t j=0; j<(int64_t)args.nsegments; j++)
+	{
+		size_t istart = segStarts[j];
+		size_t iend = ((j+1) < (int64_t)args.nsegments) ? segStarts[j+1] : args.nsamples;
+		const EdgeSynthesisSegment& seg = segments[j];
+
+		uint32_t off = (seg.shapeIndex == 0) ? args.shapeOffset0 : args.shapeOffset1;
+		uint32_t len = (seg.shapeIndex == 0) ? args.shapeLen0 : args.shapeLen1;
+		const float* shape = shapedata + off*2;
+
+		size_t cursor = 0;
+		for(size_t i=istart; i<iend; i++)
+		{
+			float trel = (i - istart) * args.samplePeriodSec + seg.residualSec;
+
+			//Interpolate the shape table at trel, clipping at either end
+			float frac;
+			if(trel <= shape[0])
+				frac = shape[1];
+			else if(trel >= shape[2*(len-1)])
+				frac = shape[2*(len-1) + 1];
+			else
+			{
+				while(shape[2*(cursor+1)] <= trel)
+					cursor ++;
+
+				float t0 = shape[2*cursor];
+				float t1 = shape[2*(cursor+1)];
+				float f = (trel - t0) / (t1 - t0);
+				frac = shape[2*cursor + 1] + (shape[2*(cursor+1) + 1] - shape[2*cursor + 1]) * f;
+			}
+
+			dout[i] = seg.vStart + (seg.vEnd - seg.vStart)*frac;
+		}
+	}
+}
+
+#endif
@@ -71,6 +71,11 @@ void Ethernet10BaseTDecoder::Refresh()
 	size_t len = din->size();
 	din->PrepareForCpuAccess();
 
+	//Find every sample beyond the differential thresholds up front, in one parallel pass.
+	//The Manchester recovery below then advances edge to edge with binary searches over the index instead
+	//of rescanning the record sample by sample, so the serial state machine runs at edge rate.
+	m_edgeIndex.Build(din, 1, -1);
+
 	//Copy our time scales from the input
 	auto cap = new EthernetWaveform;
 	cap->m_timescale = din->m_timescale;
@@ -231,36 +236,12 @@ void Ethernet10BaseTDecoder::Refresh()
 	cap->MarkModifiedFromCpu();
 }
 
-bool Ethernet10BaseTDecoder::FindFallingEdge(size_t& i, UniformAnalogWaveform* cap)
+bool Ethernet10BaseTDecoder::FindFallingEdge(size_t& i, UniformAnalogWaveform* /*cap*/)
 {
-	size_t j = i;
-	size_t len = cap->m_samples.size();
-	while(j < len)
-	{
-		if(cap->m_samples[j] < -1)
-		{
-			i = j;
-			return true;
-		}
-		j++;
-	}
-
-	return false;	//not found
+	return m_edgeIndex.NextBelow(i, i);
 }
 
-bool Ethernet10BaseTDecoder::FindRisingEdge(size_t& i, UniformAnalogWaveform* cap)
+bool Ethernet10BaseTDecoder::FindRisingEdge(size_t& i, UniformAnalogWaveform* /*cap*/)
 {
-	size_t j = i;
-	size_t len = cap->m_samples.size();
-	while(j < len)
-	{
-		if(cap->m_samples[j] > 1)
-		{
-			i = j;
-			return true;
-		}
-		j++;
-	}
-
-	return false;	//not found
+	return m_edgeIndex.NextAbove(i, i);
 }
@@ -57,6 +57,9 @@ protected:
 		else
 			return FindFallingEdge(i, cap);
 	}
+
+	///@brief Index of samples beyond the differential thresholds, built once per refresh
+	LevelCrossingIndex m_edgeIndex;
 };
 
 #endif
@@ -97,33 +97,114 @@ void Ethernet64b66bDecoder::Refresh()
 	SparseDigitalWaveform data;
 	SampleOnAnyEdgesBase(din, clkin, data);
 
-	//Look at each phase and figure out block alignment
+	//Look at each phase and figure out block alignment.
+	//Each candidate phase is independent, so check several on each thread for deep captures.
 	size_t end = data.size() - 66;
 	size_t best_offset = 0;
 	size_t best_errors = end;
+	size_t phaseErrors[66] = {0};
+	{
+		size_t nthreads = max<size_t>(thread::hardware_concurrency(), 1);
+		nthreads = min(nthreads, (size_t)66);
+		if(end < 66*1024)
+			nthreads = 1;
+
+		vector<thread> threads;
+		for(size_t t=0; t<nthreads; t++)
+		{
+			threads.emplace_back(
+				[t, nthreads, end, &data, &phaseErrors]
+				{
+					for(size_t offset=t; offset < 66; offset += nthreads)
+					{
+						size_t errors = 0;
+						for(size_t i=offset; i<end; i+= 66)
+						{
+							if(data.m_samples[i] == data.m_samples[i+1])
+								errors ++;
+						}
+						phaseErrors[offset] = errors;
+					}
+				});
+		}
+		for(auto& t : threads)
+			t.join();
+	}
 	for(size_t offset=0; offset < 66; offset ++)
 	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 66)
+		if(phaseErrors[offset] < best_errors)
 		{
-			if(data.m_samples[i] == data.m_samples[i+1])
-				errors ++;
+			best_offset = offset;
+			best_errors = phaseErrors[offset];
 		}
+	}
 
-		if(errors < best_errors)
+	//Decode the actual data.
+	//The scrambler is multiplicative (x^58 + x^39 + 1) and thus self synchronizing: its state at any block
+	//boundary is just the previous 58 payload bits. So once we have block lock, any span of blocks can be
+	//decoded independently by seeding the LFSR from the tail of the preceding block, and the decode
+	//parallelizes cleanly across cores.
+	//The first block only primes the scrambler and produces no output, matching the sequential decode.
+	size_t nblocks = 0;
+	if(end > best_offset)
+		nblocks = (end - best_offset + 65) / 66;
+	if(nblocks > 1)
+	{
+		size_t nsyms = nblocks - 1;
+		cap->m_offsets.resize(nsyms);
+		cap->m_durations.resize(nsyms);
+		cap->m_samples.resize(nsyms);
+
+		//No point in spawning threads unless each one gets a reasonable chunk of work
+		const size_t minBlocksPerThread = 16384;
+		size_t nthreads = max<size_t>(thread::hardware_concurrency(), 1);
+		nthreads = min(nthreads, (nsyms + minBlocksPerThread - 1) / minBlocksPerThread);
+		if(nthreads <= 1)
+			DecodeBlocks(data, best_offset, 1, nblocks, cap);
+		else
 		{
-			best_offset = offset;
-			best_errors = errors;
+			size_t blocksPerThread = (nsyms + nthreads - 1) / nthreads;
+			vector<thread> threads;
+			for(size_t t=0; t<nthreads; t++)
+			{
+				size_t begin = 1 + t*blocksPerThread;
+				size_t bend = min(begin + blocksPerThread, nblocks);
+				threads.emplace_back(
+					[this, &data, best_offset, begin, bend, cap]
+					{ DecodeBlocks(data, best_offset, begin, bend, cap); });
+			}
+			for(auto& t : threads)
+				t.join();
 		}
 	}
 
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
 
-	//Decode the actual data
-	bool first		= true;
-	uint64_t lfsr	= 0;
+/**
+	@brief Descramble and decode a contiguous range of 66-bit blocks
+
+	The scrambler state is seeded from the last 58 payload bits of the block before blockBegin, so ranges
+	decoded by separate threads produce output identical to a single sequential pass over the whole capture.
+ */
+void Ethernet64b66bDecoder::DecodeBlocks(
+	SparseDigitalWaveform& data,
+	size_t bitOffset,
+	size_t blockBegin,
+	size_t blockEnd,
+	Ethernet64b66bWaveform* cap)
+{
+	//Seed the LFSR with the trailing 58 payload bits of the previous block
+	uint64_t lfsr = 0;
+	size_t iprev = bitOffset + (blockBegin-1)*66;
+	for(size_t j=6; j<64; j++)
+		lfsr = (lfsr << 1) | (data.m_samples[iprev + 2 + j] ? 1 : 0);
 
-	for(size_t i=best_offset; i<end; i += 66)
+	for(size_t block=blockBegin; block<blockEnd; block++)
 	{
+		size_t i = bitOffset + block*66;
+
 		//Extract the header bits
 		uint8_t header =
 			(data.m_samples[i] ? 2 : 0) |
@@ -165,21 +246,11 @@ void Ethernet64b66bDecoder::Refresh()
 			(bytes[1] << 8) |
 			bytes[0];
 
-		//Just prime the scrambler, we can't decode yet
-		if(first)
-			first = false;
-
 		//Process descrambled data
-		else
-		{
-			cap->m_offsets.push_back(data.m_offsets[i] - data.m_durations[i]/2);
-			cap->m_durations.push_back(data.m_offsets[i+66] - data.m_offsets[i]);
-			cap->m_samples.push_back(Ethernet64b66bSymbol(header, codeword));
-		}
+		cap->m_offsets[block-1] = data.m_offsets[i] - data.m_durations[i]/2;
+		cap->m_durations[block-1] = data.m_offsets[i+66] - data.m_offsets[i];
+		cap->m_samples[block-1] = Ethernet64b66bSymbol(header, codeword);
 	}
-
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
 }
 
 std::string Ethernet64b66bWaveform::GetColor(size_t i)
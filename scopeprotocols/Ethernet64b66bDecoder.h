@@ -78,6 +78,12 @@ public:
 	PROTOCOL_DECODER_INITPROC(Ethernet64b66bDecoder)
 
 protected:
+	void DecodeBlocks(
+		SparseDigitalWaveform& data,
+		size_t bitOffset,
+		size_t blockBegin,
+		size_t blockEnd,
+		Ethernet64b66bWaveform* cap);
 };
 
 #endif
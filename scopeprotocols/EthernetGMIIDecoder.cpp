@@ -102,13 +102,14 @@ void EthernetGMIIDecoder::Refresh()
 	auto en = GetInputWaveform(2);
 	auto er = GetInputWaveform(3);
 
-	//Sample everything on the clock edges
+	//Sample everything on the clock edges.
+	//The data bus is packed into one word per sample so the byte extraction below is a single load.
 	SparseDigitalWaveform den;
 	SparseDigitalWaveform der;
-	SparseDigitalBusWaveform ddata;
+	SparseWaveform<uint16_t> ddata;
 	SampleOnRisingEdgesBase(en, clk, den);
 	SampleOnRisingEdgesBase(er, clk, der);
-	SampleOnRisingEdgesBase(data, clk, ddata);
+	SampleDigitalBusOnRisingEdgesPackedBase(data, clk, ddata);
 
 	//Create the output capture
 	auto cap = new EthernetWaveform;
@@ -133,15 +134,7 @@ void EthernetGMIIDecoder::Refresh()
 		//TODO: handle error signal (ignored for now)
 		while( (i < len) && (den.m_samples[i]) )
 		{
-			//Convert bits to bytes
-			uint8_t dval = 0;
-			for(size_t j=0; j<8; j++)
-			{
-				if(ddata.m_samples[i][j])
-					dval |= (1 << j);
-			}
-
-			bytes.push_back(dval);
+			bytes.push_back(ddata.m_samples[i] & 0xff);
 			starts.push_back(ddata.m_offsets[i]);
 			ends.push_back(ddata.m_offsets[i] + ddata.m_durations[i]);
 			i++;
@@ -99,11 +99,12 @@ void EthernetRGMIIDecoder::Refresh()
 	auto clk = GetInputWaveform(1);
 	auto ctl = GetInputWaveform(2);
 
-	//Sample everything on the clock edges
+	//Sample everything on the clock edges.
+	//The data bus is packed into one word per sample so the nibble extraction below is a single load.
 	SparseDigitalWaveform dctl;
-	SparseDigitalBusWaveform ddata;
+	SparseWaveform<uint16_t> ddata;
 	SampleOnAnyEdgesBase(ctl, clk, dctl);
-	SampleOnAnyEdgesBase(data, clk, ddata);
+	SampleDigitalBusOnAnyEdgesPackedBase(data, clk, ddata);
 
 	dctl.PrepareForCpuAccess();
 	ddata.PrepareForCpuAccess();
@@ -132,12 +133,7 @@ void EthernetRGMIIDecoder::Refresh()
 		if(!dctl.m_samples[i])
 		{
 			//Extract in-band status
-			uint8_t status = 0;
-			for(size_t j=0; j<4; j++)
-			{
-				if(ddata.m_samples[i][j])
-					status |= (1 << j);
-			}
+			uint8_t status = ddata.m_samples[i] & 0xf;
 
 			//Same status? Merge samples
 			bool extend = false;
@@ -187,19 +183,8 @@ void EthernetRGMIIDecoder::Refresh()
 
 			if(ddr)
 			{
-				//Convert bits to bytes
-				uint8_t dval = 0;
-				for(size_t j=0; j<8; j++)
-				{
-					if(j < 4)
-					{
-						if(ddata.m_samples[i][j])
-							dval |= (1 << j);
-					}
-					else if(ddata.m_samples[i+1][j-4])
-						dval |= (1 << j);
-				}
-				bytes.push_back(dval);
+				//Low nibble on the rising edge, high nibble on the falling edge
+				bytes.push_back( (ddata.m_samples[i] & 0xf) | ( (ddata.m_samples[i+1] & 0xf) << 4) );
 
 				ends.push_back(ddata.m_offsets[i+1] + ddata.m_durations[i+1]);
 				i += 2;
@@ -207,19 +192,8 @@ void EthernetRGMIIDecoder::Refresh()
 
 			else
 			{
-				//Convert bits to bytes
-				uint8_t dval = 0;
-				for(size_t j=0; j<8; j++)
-				{
-					if(j < 4)
-					{
-						if(ddata.m_samples[i][j])
-							dval |= (1 << j);
-					}
-					else if(ddata.m_samples[i+2][j-4])
-						dval |= (1 << j);
-				}
-				bytes.push_back(dval);
+				//SDR: the high nibble shows up a full clock cycle (two edges) later
+				bytes.push_back( (ddata.m_samples[i] & 0xf) | ( (ddata.m_samples[i+2] & 0xf) << 4) );
 
 				ends.push_back(ddata.m_offsets[i+3] + ddata.m_durations[i+3]);
 				i += 4;
@@ -93,17 +93,13 @@ void EthernetRMIIDecoder::Refresh()
 	auto d0 = GetInputWaveform(2);
 	auto d1 = GetInputWaveform(3);
 
-	//Sample everything on the clock edges
-	SparseDigitalWaveform dctl;
-	SparseDigitalWaveform dd0;
-	SparseDigitalWaveform dd1;
-	SampleOnRisingEdgesBase(ctl, clk, dctl);
-	SampleOnRisingEdgesBase(d0, clk, dd0);
-	SampleOnRisingEdgesBase(d1, clk, dd1);
+	//Sample all three lanes at the clock edges in a single shared pass over the clock:
+	//bit 0 = ctl, bit 1 = d0, bit 2 = d1
+	SparseWaveform<uint16_t> dbus;
+	SampleDigitalLanesOnRisingEdgesBase({ctl, d0, d1}, clk, dbus);
 
 	//Need a reasonable number of samples or there's no point in decoding.
-	size_t len = min(dctl.size(), dd0.size());
-	len = min(len, dd1.size());
+	size_t len = dbus.size();
 	if(len < 100)
 	{
 		SetData(NULL, 0);
@@ -122,11 +118,11 @@ void EthernetRMIIDecoder::Refresh()
 	for(size_t i=2; i < len; i++)
 	{
 		//If ctl is 0, nothing happening
-		if(!dctl.m_samples[i])
+		if(!(dbus.m_samples[i] & 1))
 			continue;
 
 		//No preamble (ctl high, d0 high, d1 low) yet
-		if(!dd0.m_samples[i])
+		if(!(dbus.m_samples[i] & 2))
 			continue;
 
 		//Set of recovered bytes and timestamps
@@ -136,23 +132,21 @@ void EthernetRMIIDecoder::Refresh()
 
 		//TODO: handle error signal (ignored for now)
 		bool err = false;
-		while( (i < len) && (dctl.m_samples[i]) )
+		while( (i < len) && (dbus.m_samples[i] & 1) )
 		{
 			//Timestamps
-			starts.push_back(dd0.m_offsets[i]);
-			ends.push_back(dd0.m_offsets[i+3] + dd0.m_durations[i+3]);
+			starts.push_back(dbus.m_offsets[i]);
+			ends.push_back(dbus.m_offsets[i+3] + dbus.m_durations[i+3]);
 
 			//Convert di-bits to bytes
 			//We send LSB first, MSB last
 			uint8_t dval = 0;
 			for(size_t j=0; j<4; j ++)
 			{
-				if(dd0.m_samples[i+j])
-					dval |= (1 << j*2);
-				if(dd1.m_samples[i+j])
-					dval |= (2 << j*2);
+				auto word = dbus.m_samples[i+j];
+				dval |= ( (word >> 1) & 3) << (j*2);
 
-				if(!dctl.m_samples[i+j])
+				if(!(word & 1))
 				{
 					LogDebug("ctl ended partway through a byte at i=%zu, j=%zu)\n", i, j);
 					err = true;
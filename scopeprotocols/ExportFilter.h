@@ -53,6 +53,10 @@ public:
 	virtual std::vector<std::string> EnumActions() override;
 	virtual bool PerformAction(const std::string& id) override;
 
+	//Export filters write to files as a side effect, so they must run every graph execution
+	virtual bool ShouldMemoize() override
+	{ return false; }
+
 protected:
 
 	/**
@@ -148,8 +148,8 @@ void EyePattern::ClearSweeps()
 }
 
 void EyePattern::Refresh(
-	[[maybe_unused]] vk::raii::CommandBuffer& cmdBuf,
-	[[maybe_unused]] shared_ptr<QueueHandle> queue)
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
 {
 	LogIndenter li;
 
@@ -275,13 +275,27 @@ void EyePattern::Refresh(
 
 	//Count total number of UIs we've integrated
 	cap->IntegrateUIs(clock_edges.size(), waveform->size());
-	cap->Normalize();
 	m_streams[2].m_value = cap->GetTotalUIs();
 	m_streams[3].m_value = cap->GetTotalSamples();
 
-	//If we have an eye mask, prepare it for processing
+	//Defer normalization until the display (or a measurement) actually reads the eye,
+	//so free-running integration doesn't touch the output buffer every trigger.
+	//The rows we touched are bounded by the min/max voltage of this record (plotting interpolates between
+	//adjacent samples, so intermediate values can't go outside that range); report them so normalization
+	//only re-scans those rows. One extra margin row each side covers rounding and the antialiasing spill.
+	cap->GetAccumBuffer().MarkModifiedFromCpu();
+	float vmin = GetMinVoltage(swfm, uwfm);
+	float vmax = GetMaxVoltage(swfm, uwfm);
+	int64_t rowmin = static_cast<int64_t>(floor(vmin*yscale + yoff)) - 1;
+	int64_t rowmax = static_cast<int64_t>(floor(vmax*yscale + yoff)) + 2;
+	rowmin = min(max(rowmin, (int64_t)0), (int64_t)(m_height - 1));
+	rowmax = min(max(rowmax, (int64_t)0), (int64_t)(m_height - 1));
+	cap->MarkNormalizationDirty(rowmin, rowmax);
+
+	//If we have an eye mask, test the accumulated data against it
+	//(the GPU hit test reads the raw accumulator, so no normalization is needed here)
 	if(m_mask.GetFileName() != "")
-		DoMaskTest(cap);
+		DoMaskTest(cap, cmdBuf, queue);
 }
 
 #ifdef __x86_64__
@@ -619,12 +633,33 @@ void EyePattern::SparsePackedInnerLoop(
 
 EyeWaveform* EyePattern::ReallocateWaveform()
 {
-	auto cap = new EyeWaveform(m_width, m_height, m_parameters[m_centerName].GetFloatVal(), EyeWaveform::EYE_NORMAL);
+	//Try to recycle a pooled eye of suitable size before allocating a new one
+	auto cap = dynamic_cast<EyeWaveform*>(m_eyeWaveformPool.Get(m_width * m_height));
+	if(cap)
+	{
+		cap->Resize(m_width, m_height);
+		cap->Reinitialize(m_parameters[m_centerName].GetFloatVal(), EyeWaveform::EYE_NORMAL);
+	}
+	else
+		cap = new EyeWaveform(m_width, m_height, m_parameters[m_centerName].GetFloatVal(), EyeWaveform::EYE_NORMAL);
 	cap->m_timescale = 1;
 	SetData(cap, 0);
 	return cap;
 }
 
+/**
+	@brief Resizes the current output waveform in place after a plot dimension change
+
+	Resizing the existing accumulator avoids freeing and reallocating the bitmap every time the user drags
+	the plot size, at the cost of restarting integration (which a dimension change forces anyway).
+ */
+void EyePattern::ResizeWaveform()
+{
+	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
+	if(cap)
+		cap->Resize(m_width, m_height);
+}
+
 void EyePattern::RecalculateUIWidth()
 {
 	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
@@ -691,7 +726,7 @@ void EyePattern::RecalculateUIWidth()
 /**
 	@brief Checks the current capture against the eye mask
  */
-void EyePattern::DoMaskTest(EyeWaveform* cap)
+void EyePattern::DoMaskTest(EyeWaveform* cap, vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	auto rate = m_mask.CalculateHitRate(
 		cap,
@@ -699,7 +734,9 @@ void EyePattern::DoMaskTest(EyeWaveform* cap)
 		m_height,
 		GetVoltageRange(0),
 		m_xscale,
-		m_xoff);
+		m_xoff,
+		cmdBuf,
+		queue);
 
 	m_streams[1].m_value = rate;
 	cap->SetMaskHitRate(rate);
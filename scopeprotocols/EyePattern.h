@@ -57,13 +57,14 @@ public:
 
 	void RecalculateUIWidth();
 	EyeWaveform* ReallocateWaveform();
+	void ResizeWaveform();
 
 	void SetWidth(size_t width)
 	{
 		if(m_width != width)
 		{
-			SetData(NULL, 0);
 			m_width = width;
+			ResizeWaveform();
 		}
 	}
 
@@ -71,8 +72,8 @@ public:
 	{
 		if(m_height != height)
 		{
-			SetData(NULL, 0);
 			m_height = height;
+			ResizeWaveform();
 		}
 	}
 
@@ -119,7 +120,7 @@ public:
 	PROTOCOL_DECODER_INITPROC(EyePattern)
 
 protected:
-	void DoMaskTest(EyeWaveform* cap);
+	void DoMaskTest(EyeWaveform* cap, vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue);
 
 	void SparsePackedInnerLoop(
 		SparseAnalogWaveform* waveform,
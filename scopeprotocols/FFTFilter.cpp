@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "../scopehal/AlignedAllocator.h"
+#include "../scopehal/VulkanFFTPlanPool.h"
 #include "FFTFilter.h"
 
 using namespace std;
@@ -40,12 +41,23 @@ FFTFilter::FFTFilter(const string& color)
 	: PeakDetectionFilter(color, CAT_RF)
 	, m_windowName("Window")
 	, m_roundingName("Length Rounding")
+	, m_maxLengthName("Max FFT Points")
 	, m_blackmanHarrisComputePipeline("shaders/BlackmanHarrisWindow.spv", 2, sizeof(WindowFunctionArgs))
 	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_cosineSumComputePipeline("shaders/CosineSumWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_hannComputePipeline("shaders/CosineSumWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_hammingComputePipeline("shaders/CosineSumWindow.spv", 2, sizeof(WindowFunctionArgs))
 	, m_complexToMagnitudeComputePipeline("shaders/ComplexToMagnitude.spv", 2, sizeof(ComplexToMagnitudeArgs))
 	, m_complexToLogMagnitudeComputePipeline("shaders/ComplexToLogMagnitude.spv", 2, sizeof(ComplexToMagnitudeArgs))
+	, m_powerAccumulateComputePipeline("shaders/FFTPowerAccumulate.spv", 2, sizeof(ComplexToMagnitudeArgs))
+	, m_powerToMagnitudeComputePipeline("shaders/FFTPowerToMagnitude.spv", 2, sizeof(ComplexToMagnitudeArgs))
+	, m_powerToLogMagnitudeComputePipeline("shaders/FFTPowerToLogMagnitude.spv", 2, sizeof(ComplexToMagnitudeArgs))
 {
+	//Bake the cosine-sum window coefficients in as specialization constants, one pipeline per window type,
+	//so they're compile time constants in the shader rather than per-invocation push constant loads
+	const float hammingAlpha0 = 25.0f / 46;
+	m_hannComputePipeline.SetSpecializationConstants(vector<float>{0.5f, 0.5f});
+	m_hammingComputePipeline.SetSpecializationConstants(vector<float>{hammingAlpha0, 1 - hammingAlpha0});
+
 	m_xAxisUnit = Unit(Unit::UNIT_HZ);
 	AddStream(Unit(Unit::UNIT_DBM), "data", Stream::STREAM_TYPE_ANALOG);
 
@@ -71,6 +83,11 @@ FFTFilter::FFTFilter(const string& color)
 	m_parameters[m_roundingName].AddEnumValue("Down (Truncate)", ROUND_TRUNCATE);
 	m_parameters[m_roundingName].AddEnumValue("Up (Zero Pad)", ROUND_ZERO_PAD);
 	m_parameters[m_roundingName].SetIntVal(ROUND_TRUNCATE);
+
+	//Inputs longer than this are split into overlapping segments of this length whose power spectra are
+	//averaged, bounding GPU memory use for arbitrarily long captures
+	m_parameters[m_maxLengthName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
+	m_parameters[m_maxLengthName].SetIntVal(67108864);	//2^26
 }
 
 FFTFilter::~FFTFilter()
@@ -135,20 +152,11 @@ void FFTFilter::ReallocateBuffers(size_t npoints_raw, size_t npoints, size_t nou
 	if(m_cachedNumPointsFFT != npoints)
 		m_cachedNumPointsFFT = npoints;
 
-	//Update our FFT plan if it's out of date
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdoutbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
-	if(m_vkPlan)
-	{
-		if(m_vkPlan->size() != npoints)
-			m_vkPlan = nullptr;
-	}
-	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
-
 	m_rdinbuf.resize(npoints);
 	m_rdoutbuf.resize(2*nouts);
 }
@@ -172,10 +180,26 @@ void FFTFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	LogTrace("FFTFilter: processing %zu raw points\n", npoints_raw);
 	LogTrace("Rounded to %zu\n", npoints);
 
+	//If the input is longer than our memory budget, stream it through a bounded-size FFT in overlapping
+	//segments and average the resulting power spectra (Welch's method) rather than transforming in one shot
+	size_t maxpoints = prev_pow2(max((int64_t)2, m_parameters[m_maxLengthName].GetIntVal()));
+	if(npoints > maxpoints)
+	{
+		const size_t seglen = maxpoints;
+		const size_t segouts = seglen/2 + 1;
+		m_cachedNumOuts = segouts;
+		if( (m_cachedNumPoints != npoints_raw) || (m_cachedNumPointsFFT != seglen) )
+			ReallocateBuffers(npoints_raw, seglen, segouts);
+		LogTrace("Output: %zu (segmented, %zu points per segment)\n", segouts, seglen);
+
+		DoSegmentedRefresh(din, din->m_samples, din->m_timescale, npoints_raw, seglen, segouts, true, cmdBuf, queue);
+		return;
+	}
+
 	//Reallocate buffers if size has changed
 	const size_t nouts = npoints/2 + 1;
 	m_cachedNumOuts = nouts;
-	if(m_cachedNumPoints != npoints_raw)
+	if( (m_cachedNumPoints != npoints_raw) || (m_cachedNumPointsFFT != npoints) )
 		ReallocateBuffers(npoints_raw, npoints, nouts);
 	LogTrace("Output: %zu\n", nouts);
 
@@ -237,21 +261,9 @@ void FFTFilter::DoRefresh(
 	args.scale = 2 * M_PI / numActualSamples;
 	args.offsetIn = 0;
 	args.offsetOut = 0;
-	switch(window)
-	{
-		case WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
-
-		case WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
-	}
-	args.alpha1 = 1 - args.alpha0;
+	//Cosine-sum coefficients are baked into the specialized pipelines, so nothing window specific goes here
+	args.alpha0 = 0;
+	args.alpha1 = 0;
 
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
@@ -265,8 +277,11 @@ void FFTFilter::DoRefresh(
 			break;
 
 		case WINDOW_HANN:
+			wpipe = &m_hannComputePipeline;
+			break;
+
 		case WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
+			wpipe = &m_hammingComputePipeline;
 			break;
 
 		default:
@@ -281,7 +296,9 @@ void FFTFilter::DoRefresh(
 	m_rdinbuf.MarkModifiedFromGpu();
 
 	//Do the actual FFT operation
-	m_vkPlan->AppendForward(m_rdinbuf, m_rdoutbuf, cmdBuf);
+	//(the plan is checked out of the shared pool until we've finished waiting on the GPU below)
+	auto plan = VulkanFFTPlanPool::GetInstance().Acquire(npoints, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+	plan->AppendForward(m_rdinbuf, m_rdoutbuf, cmdBuf);
 
 	//Convert complex to real
 	ComputePipeline& pipe = log_output ?
@@ -309,3 +326,160 @@ void FFTFilter::DoRefresh(
 	//Peak search (for now this runs on the CPU)
 	FindPeaks(cap);
 }
+
+/**
+	@brief Streaming FFT for inputs too large to transform in one shot
+
+	Slides a window of seglen points across the input with 50% overlap, transforming each segment through a
+	single bounded-size FFT plan and accumulating the power spectra on the GPU. The average of the per-segment
+	power spectra (Welch's method) is then converted to the requested output format. Working set is O(seglen)
+	regardless of input length, at the cost of reduced frequency resolution vs a full-length transform.
+ */
+void FFTFilter::DoSegmentedRefresh(
+	WaveformBase* din,
+	AcceleratorBuffer<float>& data,
+	double fs_per_sample,
+	size_t npoints_raw,
+	size_t seglen,
+	size_t nouts,
+	bool log_output,
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue)
+{
+	//Look up some parameters
+	double sample_ghz = 1e6 / fs_per_sample;
+	double bin_hz = round((0.5f * sample_ghz * 1e9f) / nouts);
+	auto window = static_cast<WindowFunction>(m_parameters[m_windowName].GetIntVal());
+	LogTrace("bin_hz: %f\n", bin_hz);
+
+	//Segments overlap by 50% so samples attenuated at the edge of one window are near the center of the next
+	const size_t stride = seglen / 2;
+	const size_t nsegments = ((npoints_raw - seglen) / stride) + 1;
+	LogTrace("Averaging %zu segments\n", nsegments);
+
+	//Set up output and copy time scales / configuration
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
+	cap->m_triggerPhase = 1*bin_hz;
+	cap->m_timescale = bin_hz;
+	cap->Resize(nouts);
+
+	//Output scale is based on the segment length (every segment is fully populated, no zero padding here)
+	float scale = sqrt(2.0) / seglen;
+
+	//We also need to adjust the scale by the coherent power gain of the window function
+	switch(window)
+	{
+		case WINDOW_HAMMING:
+			scale *= 1.862;
+			break;
+
+		case WINDOW_HANN:
+			scale *= 2.013;
+			break;
+
+		case WINDOW_BLACKMAN_HARRIS:
+			scale *= 2.805;
+			break;
+
+		//unit
+		case WINDOW_RECTANGULAR:
+		default:
+			break;
+	}
+
+	//Configure the window
+	WindowFunctionArgs args;
+	args.numActualSamples = seglen;
+	args.npoints = seglen;
+	args.scale = 2 * M_PI / seglen;
+	args.offsetIn = 0;
+	args.offsetOut = 0;
+	//Cosine-sum coefficients are baked into the specialized pipelines, so nothing window specific goes here
+	args.alpha0 = 0;
+	args.alpha1 = 0;
+
+	ComputePipeline* wpipe = nullptr;
+	switch(window)
+	{
+		case WINDOW_BLACKMAN_HARRIS:
+			wpipe = &m_blackmanHarrisComputePipeline;
+			break;
+
+		case WINDOW_HANN:
+			wpipe = &m_hannComputePipeline;
+			break;
+
+		case WINDOW_HAMMING:
+			wpipe = &m_hammingComputePipeline;
+			break;
+
+		default:
+		case WINDOW_RECTANGULAR:
+			wpipe = &m_rectangularComputePipeline;
+			break;
+	}
+
+	//Zero the power accumulator
+	m_accumbuf.resize(nouts);
+	m_accumbuf.PrepareForCpuAccess();
+	memset(m_accumbuf.GetCpuPointer(), 0, nouts * sizeof(float));
+	m_accumbuf.MarkModifiedFromCpu();
+
+	//Check a bounded-size FFT plan out of the shared pool until we've finished waiting on the GPU below
+	auto plan = VulkanFFTPlanPool::GetInstance().Acquire(seglen, nouts, VulkanFFTPlan::DIRECTION_FORWARD);
+
+	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
+	cmdBuf.begin({});
+
+	ComplexToMagnitudeArgs aargs;
+	aargs.npoints = nouts;
+	aargs.scale = 1;
+
+	for(size_t seg=0; seg<nsegments; seg++)
+	{
+		//Window the current segment into the FFT input buffer
+		args.offsetIn = seg * stride;
+		wpipe->BindBufferNonblocking(0, data, cmdBuf);
+		wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
+		wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(seglen, 64));
+		wpipe->AddComputeMemoryBarrier(cmdBuf);
+		m_rdinbuf.MarkModifiedFromGpu();
+
+		//Transform it
+		plan->AppendForward(m_rdinbuf, m_rdoutbuf, cmdBuf);
+
+		//Accumulate power into the running total
+		m_powerAccumulateComputePipeline.BindBufferNonblocking(0, m_rdoutbuf, cmdBuf);
+		m_powerAccumulateComputePipeline.BindBufferNonblocking(1, m_accumbuf, cmdBuf);
+		m_powerAccumulateComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		m_powerAccumulateComputePipeline.Dispatch(cmdBuf, aargs, GetComputeBlockCount(nouts, 64));
+		m_powerAccumulateComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+		m_accumbuf.MarkModifiedFromGpu();
+	}
+
+	//Convert the averaged power spectrum to the output format
+	ComputePipeline& pipe = log_output ?
+		m_powerToLogMagnitudeComputePipeline : m_powerToMagnitudeComputePipeline;
+	ComplexToMagnitudeArgs cargs;
+	cargs.npoints = nouts;
+	if(log_output)
+	{
+		const float impedance = 50;
+		cargs.scale = scale * scale / (impedance * nsegments);
+	}
+	else
+		cargs.scale = scale * scale / nsegments;
+	pipe.BindBufferNonblocking(0, m_accumbuf, cmdBuf);
+	pipe.BindBufferNonblocking(1, cap->m_samples, cmdBuf, true);
+	pipe.AddComputeMemoryBarrier(cmdBuf);
+	pipe.Dispatch(cmdBuf, cargs, GetComputeBlockCount(nouts, 64));
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	cap->MarkModifiedFromGpu();
+
+	//Peak search (for now this runs on the CPU)
+	FindPeaks(cap);
+}
@@ -105,25 +105,43 @@ protected:
 		std::shared_ptr<QueueHandle> queue
 		);
 
+	void DoSegmentedRefresh(
+		WaveformBase* din,
+		AcceleratorBuffer<float>& data,
+		double fs_per_sample,
+		size_t npoints_raw,
+		size_t seglen,
+		size_t nouts,
+		bool log_output,
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue
+		);
+
 	size_t m_cachedNumPoints;
 	size_t m_cachedNumPointsFFT;
 	size_t m_cachedNumOuts;
 	AcceleratorBuffer<float> m_rdinbuf;
 	AcceleratorBuffer<float> m_rdoutbuf;
 
+	///@brief Power spectrum accumulator for segmented (streamed) operation
+	AcceleratorBuffer<float> m_accumbuf;
+
 	float m_range;
 	float m_offset;
 
 	std::string m_windowName;
 	std::string m_roundingName;
-
-	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
+	std::string m_maxLengthName;
 
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
-	ComputePipeline m_cosineSumComputePipeline;
+	ComputePipeline m_hannComputePipeline;
+	ComputePipeline m_hammingComputePipeline;
 	ComputePipeline m_complexToMagnitudeComputePipeline;
 	ComputePipeline m_complexToLogMagnitudeComputePipeline;
+	ComputePipeline m_powerAccumulateComputePipeline;
+	ComputePipeline m_powerToMagnitudeComputePipeline;
+	ComputePipeline m_powerToLogMagnitudeComputePipeline;
 };
 
 #endif
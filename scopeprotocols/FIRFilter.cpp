@@ -69,6 +69,13 @@ FIRFilter::FIRFilter(const string& color)
 	m_parameters[m_freqHighName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
 	m_parameters[m_freqHighName].SetFloatVal(100e6);
 
+	m_cachedTapCount = 0;
+	m_cachedFlo = 0;
+	m_cachedFhi = 0;
+	m_cachedAtten = 0;
+	m_cachedNyquist = 0;
+	m_cachedType = FILTER_TYPE_LOWPASS;
+
 	m_coefficients.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_coefficients.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
@@ -138,6 +145,12 @@ Filter::DataLocation FIRFilter::GetInputLocation()
 	return LOC_DONTCARE;
 }
 
+bool FIRFilter::IsDeferredSubmitSafe()
+{
+	//The GPU path never reads results back within Refresh(), so the executor may defer our fence wait
+	return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -200,9 +213,25 @@ void FIRFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 		return;
 	}
 
-	//Create the filter coefficients (TODO: cache this)
-	m_coefficients.resize(filterlen);
-	CalculateFilterCoefficients(flo / nyquist, fhi / nyquist, atten, type);
+	//Create the filter coefficients, but only if the configuration changed since the last refresh.
+	//The buffer then stays resident on the GPU rather than being re-uploaded every waveform.
+	if( (m_cachedTapCount != filterlen) ||
+		(m_cachedFlo != flo) ||
+		(m_cachedFhi != fhi) ||
+		(m_cachedAtten != atten) ||
+		(m_cachedNyquist != nyquist) ||
+		(m_cachedType != type) )
+	{
+		m_coefficients.resize(filterlen);
+		CalculateFilterCoefficients(flo / nyquist, fhi / nyquist, atten, type);
+
+		m_cachedTapCount = filterlen;
+		m_cachedFlo = flo;
+		m_cachedFhi = fhi;
+		m_cachedAtten = atten;
+		m_cachedNyquist = nyquist;
+		m_cachedType = type;
+	}
 
 	//Set up output
 	m_xAxisUnit = m_inputs[0].m_channel->GetXAxisUnits();
@@ -224,21 +253,39 @@ void FIRFilter::DoFilterKernel(
 	UniformAnalogWaveform* din,
 	UniformAnalogWaveform* cap)
 {
-	if(g_gpuFilterEnabled)
+	//Pick the path predicted to be faster for this input size on this machine
+	bool gpu = g_gpuFilterEnabled;
+	if(gpu && g_filterCostModel)
+		gpu = g_filterCostModel->PreferGpu("FIRFilter", din->size());
+	double tstart = GetTime();
+
+	if(gpu)
 	{
-		cmdBuf.begin({});
+		size_t npoints = din->size() - m_coefficients.size();
+
+		//Cap the amount of work in each submit so huge records can't stall the GPU long enough to trip
+		//the OS watchdog (2 seconds by default on Windows) and get the device reset out from under us.
+		//This also keeps us under the workgroup count limit of drivers with a small maxComputeWorkGroupCount.
+		const size_t maxBlocksPerDispatch = 32768;
+		const size_t tilesize = maxBlocksPerDispatch * 64;
 
 		FIRFilterArgs args;
-		args.end = din->size() - m_coefficients.size();
+		args.end = npoints;
 		args.filterlen = m_coefficients.size();
 
-		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(1, m_coefficients, cmdBuf);
-		m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
-		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.end, 64));
-
-		cmdBuf.end();
-		queue->SubmitAndBlock(cmdBuf);
+		for(size_t offset = 0; offset < npoints; offset += tilesize)
+		{
+			size_t tilelen = min(npoints - offset, tilesize);
+			args.offset = offset;
+
+			cmdBuf.begin({});
+			m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(1, m_coefficients, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(2, cap->m_samples, cmdBuf, true);
+			m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(tilelen, 64));
+			cmdBuf.end();
+			queue->SubmitAndBlock(cmdBuf);
+		}
 
 		cap->m_samples.MarkModifiedFromGpu();
 	}
@@ -259,6 +306,9 @@ void FIRFilter::DoFilterKernel(
 
 		cap->MarkModifiedFromCpu();
 	}
+
+	if(g_filterCostModel)
+		g_filterCostModel->RecordSample("FIRFilter", gpu, din->size(), GetTime() - tstart);
 }
 
 /**
@@ -39,6 +39,7 @@ struct FIRFilterArgs
 {
 	uint32_t end;
 	uint32_t filterlen;
+	uint32_t offset;
 };
 
 /**
@@ -51,6 +52,7 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
+	virtual bool IsDeferredSubmitSafe() override;
 
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
@@ -114,6 +116,14 @@ protected:
 	ComputePipeline m_computePipeline;
 
 	AcceleratorBuffer<float> m_coefficients;
+
+	//Configuration the cached coefficients were generated with
+	size_t m_cachedTapCount;
+	float m_cachedFlo;
+	float m_cachedFhi;
+	float m_cachedAtten;
+	float m_cachedNyquist;
+	FilterType m_cachedType;
 };
 
 #endif
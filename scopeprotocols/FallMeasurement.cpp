@@ -91,7 +91,6 @@ void FallMeasurement::Refresh()
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 	din->PrepareForCpuAccess();
-	size_t len = din->size();
 
 	//Get the base/top (we use these for calculating percentages)
 	float base = GetBaseVoltage(sdin, udin);
@@ -107,6 +106,28 @@ void FallMeasurement::Refresh()
 	cap->PrepareForCpuAccess();
 	cap->m_timescale = 1;
 
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sdin)
+		InnerLoop(sdin, cap, vstart, vend);
+	else
+		InnerLoop(udin, cap, vstart, vend);
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Edge timing loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and interpolation helpers resolve at
+	compile time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void FallMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float vstart, float vend)
+{
+	size_t len = din->size();
+
 	float last = -1e20;
 	double tedge = 0;
 
@@ -118,15 +139,15 @@ void FallMeasurement::Refresh()
 	int64_t num = 0;
 	for(size_t i=0; i < len; i++)
 	{
-		float cur = GetValue(sdin, udin, i);
-		int64_t tnow = ::GetOffset(sdin, udin, i) * din->m_timescale;
+		float cur = din->m_samples[i];
+		int64_t tnow = ::GetOffset(din, i) * din->m_timescale;
 
 		//Find start of edge
 		if(state == 0)
 		{
 			if( (cur < vstart) && (last >= vstart) )
 			{
-				tedge = tnow - din->m_timescale + InterpolateTime(sdin, udin, i-1, vstart)*din->m_timescale;
+				tedge = tnow - din->m_timescale + InterpolateTime(din, i-1, vstart)*din->m_timescale;
 				state = 1;
 			}
 		}
@@ -136,7 +157,7 @@ void FallMeasurement::Refresh()
 		{
 			if( (cur < vend) && (last >= vend) )
 			{
-				double dt = InterpolateTime(sdin, udin, i-1, vend)*din->m_timescale + tnow - din->m_timescale - tedge;
+				double dt = InterpolateTime(din, i-1, vend)*din->m_timescale + tnow - din->m_timescale - tedge;
 
 				cap->m_offsets.push_back(tlast);
 				cap->m_durations.push_back(tnow - tlast);
@@ -153,9 +174,5 @@ void FallMeasurement::Refresh()
 		last = cur;
 	}
 
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
-
 	m_streams[1].m_value = sum / num;
 }
@@ -49,6 +49,8 @@ public:
 	PROTOCOL_DECODER_INITPROC(FallMeasurement)
 
 protected:
+	template<class W> void InnerLoop(W* din, SparseAnalogWaveform* cap, float vstart, float vend);
+
 	std::string m_startname;
 	std::string m_endname;
 };
@@ -38,6 +38,8 @@ using namespace std;
 GateFilter::GateFilter(const string& color)
 	: Filter(color, CAT_MATH)
 	, m_mode("Mode")
+	, m_start("Window Start")
+	, m_duration("Window Duration")
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "out", Stream::STREAM_TYPE_ANALOG);
 
@@ -46,6 +48,12 @@ GateFilter::GateFilter(const string& color)
 	m_parameters[m_mode].AddEnumValue("Latch", MODE_LATCH);
 	m_parameters[m_mode].SetIntVal(MODE_LATCH);
 
+	m_parameters[m_start] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_start].SetIntVal(0);
+
+	m_parameters[m_duration] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_duration].SetIntVal(0);
+
 	CreateInput("data");
 	CreateInput("enable");
 }
@@ -104,17 +112,44 @@ void GateFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Qu
 	{
 		if(mode == MODE_GATE)
 			SetData(nullptr, 0);
-		//else if latch keep existing data
+
+		//If latching, keep the existing data. But the held waveform may be a view of the input's sample
+		//buffer, which keeps updating (or gets reallocated) while we hold - so pin it down with a private
+		//copy before letting go of the input.
+		else
+		{
+			auto cap = dynamic_cast<UniformAnalogWaveform*>(GetData(0));
+			if(cap)
+				cap->m_samples.Detach();
+		}
+		return;
+	}
+
+	//Figure out the window bounds, in samples, clamped to the source record.
+	//A zero or negative duration means "everything from the start point to the end of the record".
+	size_t len = udin->m_samples.size();
+	int64_t start = m_parameters[m_start].GetIntVal();
+	int64_t dur = m_parameters[m_duration].GetIntVal();
+	int64_t first = (start - udin->m_triggerPhase) / udin->m_timescale;
+	first = min(max(first, (int64_t)0), (int64_t)len);
+	size_t nsamples = len - first;
+	if(dur > 0)
+		nsamples = min(nsamples, (size_t)( (dur + udin->m_timescale - 1) / udin->m_timescale ));
+	if(nsamples == 0)
+	{
+		SetData(nullptr, 0);
 		return;
 	}
 
-	//Not gating, echo input to output
+	//Not gating: output the windowed region of the input as a zero-copy view.
+	//No sample data is copied regardless of how large the source record is; downstream filters see an
+	//ordinary waveform whose trigger phase accounts for the window position.
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
 	cap->m_timescale = udin->m_timescale;
 	cap->m_startTimestamp = udin->m_startTimestamp;
 	cap->m_startFemtoseconds = udin->m_startFemtoseconds;
-	cap->m_triggerPhase = udin->m_triggerPhase;
+	cap->m_triggerPhase = udin->m_triggerPhase + first*udin->m_timescale;
 	cap->m_flags = udin->m_flags;
 	cap->m_revision ++;
-	cap->m_samples.CopyFrom(udin->m_samples);
+	cap->m_samples.Borrow(udin->m_samples, first, nsamples);
 }
@@ -35,6 +35,13 @@
 #ifndef GateFilter_h
 #define GateFilter_h
 
+/**
+	@brief Passes a waveform through unchanged when enabled, optionally restricted to a time window
+
+	The output is a zero-copy view of the input's sample buffer (see AcceleratorBuffer::Borrow), so gating a
+	multi-gigapoint record down to a short region of interest costs nothing per refresh and lets measurement
+	filters downstream run on just that region.
+ */
 class GateFilter : public Filter
 {
 public:
@@ -57,6 +64,8 @@ protected:
 	};
 
 	std::string m_mode;
+	std::string m_start;
+	std::string m_duration;
 };
 
 #endif
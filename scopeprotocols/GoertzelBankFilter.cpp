@@ -0,0 +1,247 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "GoertzelBankFilter.h"
+
+#include <omp.h>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+GoertzelBankFilter::GoertzelBankFilter(const string& color)
+	: Filter(color, CAT_RF)
+	, m_freqsname("Frequencies")
+	, m_windowname("Window")
+	, m_stridename("Update interval")
+	, m_computePipeline("shaders/GoertzelBankFilter.spv", 3, sizeof(GoertzelBankArgs))
+{
+	CreateInput("din");
+
+	m_parameters[m_freqsname] = FilterParameter(FilterParameter::TYPE_STRING, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_freqsname].SetStringVal("1 kHz, 10 kHz");
+	m_parameters[m_freqsname].signal_changed().connect(sigc::mem_fun(*this, &GoertzelBankFilter::OnFrequenciesChanged));
+
+	m_parameters[m_windowname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_windowname].SetIntVal(1000 * 1000 * 1000 * 1000LL);	//1 ms
+
+	m_parameters[m_stridename] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_stridename].SetIntVal(100 * 1000 * 1000 * 1000LL);	//100 us
+
+	m_tonePhases.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_tonePhases.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	m_magnitudes.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_magnitudes.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
+	OnFrequenciesChanged();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool GoertzelBankFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string GoertzelBankFilter::GetProtocolName()
+{
+	return "Goertzel Bank";
+}
+
+Filter::DataLocation GoertzelBankFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+/**
+	@brief Reparses the frequency list and rebuilds the output streams, one per tone
+ */
+void GoertzelBankFilter::OnFrequenciesChanged()
+{
+	m_freqs.clear();
+
+	Unit hz(Unit::UNIT_HZ);
+	auto tones = explode(m_parameters[m_freqsname].ToString(), ',');
+	for(auto& tone : tones)
+	{
+		auto str = Trim(tone);
+		if(str.empty())
+			continue;
+
+		double freq = hz.ParseString(str);
+		if(freq > 0)
+			m_freqs.push_back(freq);
+	}
+
+	ClearStreams();
+	for(auto freq : m_freqs)
+		AddStream(Unit(Unit::UNIT_VOLTS), hz.PrettyPrint(freq), Stream::STREAM_TYPE_ANALOG);
+}
+
+void GoertzelBankFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	//Make sure we've got valid inputs
+	if(!VerifyAllInputsOKAndUniformAnalog())
+	{
+		for(size_t t=0; t<m_streams.size(); t++)
+			SetData(NULL, t);
+		return;
+	}
+	auto din = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
+	size_t len = din->size();
+
+	size_t ntones = m_freqs.size();
+	if(!ntones)
+		return;
+
+	//Convert the window and stride to samples
+	size_t window = max((int64_t)1, m_parameters[m_windowname].GetIntVal() / din->m_timescale);
+	size_t stride = max((int64_t)1, m_parameters[m_stridename].GetIntVal() / din->m_timescale);
+	if(len < window)
+	{
+		for(size_t t=0; t<m_streams.size(); t++)
+			SetData(NULL, t);
+		return;
+	}
+	size_t nout = ((len - window) / stride) + 1;
+
+	//Normalized phase increment of each tone, in radians per sample
+	m_tonePhases.resize(ntones);
+	for(size_t t=0; t<ntones; t++)
+		m_tonePhases[t] = 2 * M_PI * m_freqs[t] * din->m_timescale / FS_PER_SECOND;
+	m_tonePhases.MarkModifiedFromCpu();
+
+	//One row of output per tone
+	m_magnitudes.resize(ntones * nout);
+
+	GoertzelBankArgs args;
+	args.numTones = ntones;
+	args.window = window;
+	args.stride = stride;
+	args.nout = nout;
+	args.scale = 2.0f / window;	//convert accumulated power to peak amplitude
+
+	size_t npoints = ntones * nout;
+
+	//Pick the path predicted to be faster for this machine (work scales with points * window length)
+	bool gpu = g_gpuFilterEnabled;
+	if(gpu && g_filterCostModel)
+		gpu = g_filterCostModel->PreferGpu("GoertzelBankFilter", npoints * window);
+	double tstart = GetTime();
+
+	if(gpu)
+	{
+		//Cap the amount of work in each submit so huge records can't stall the GPU long enough to trip
+		//the OS watchdog, and to stay under the workgroup count limit of some drivers
+		const size_t maxBlocksPerDispatch = 32768;
+		const size_t tilesize = maxBlocksPerDispatch * 64;
+
+		for(size_t offset = 0; offset < npoints; offset += tilesize)
+		{
+			size_t tilelen = min(npoints - offset, tilesize);
+			args.offset = offset;
+
+			cmdBuf.begin({});
+			m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(1, m_tonePhases, cmdBuf);
+			m_computePipeline.BindBufferNonblocking(2, m_magnitudes, cmdBuf, true);
+			m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(tilelen, 64));
+			cmdBuf.end();
+			queue->SubmitAndBlock(cmdBuf);
+		}
+
+		m_magnitudes.MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		din->PrepareForCpuAccess();
+		float* samples = din->m_samples.GetCpuPointer();
+		float* mags = m_magnitudes.GetCpuPointer();
+
+		#pragma omp parallel for
+		for(size_t n=0; n<npoints; n++)
+		{
+			size_t t = n / nout;
+			size_t k = n % nout;
+			size_t start = k * stride;
+
+			float coeff = 2 * cos(m_tonePhases[t]);
+			float s1 = 0;
+			float s2 = 0;
+			for(size_t j=0; j<window; j++)
+			{
+				float s0 = samples[start + j] + coeff*s1 - s2;
+				s2 = s1;
+				s1 = s0;
+			}
+
+			float power = s1*s1 + s2*s2 - coeff*s1*s2;
+			mags[n] = sqrt(max(power, 0.0f)) * args.scale;
+		}
+
+		m_magnitudes.MarkModifiedFromCpu();
+	}
+
+	if(g_filterCostModel)
+		g_filterCostModel->RecordSample("GoertzelBankFilter", gpu, npoints * window, GetTime() - tstart);
+
+	//Split the packed magnitude buffer into one output waveform per tone
+	m_magnitudes.PrepareForCpuAccess();
+	for(size_t t=0; t<ntones; t++)
+	{
+		auto cap = SetupEmptyUniformAnalogOutputWaveform(din, t);
+		cap->m_timescale = din->m_timescale * stride;
+
+		//Each output sample is timestamped at the center of its analysis window
+		cap->m_triggerPhase = din->m_triggerPhase + (window/2) * din->m_timescale;
+
+		cap->Resize(nout);
+		cap->PrepareForCpuAccess();
+		memcpy(cap->m_samples.GetCpuPointer(), m_magnitudes.GetCpuPointer() + t*nout, nout * sizeof(float));
+		cap->MarkModifiedFromCpu();
+	}
+}
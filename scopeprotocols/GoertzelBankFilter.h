@@ -0,0 +1,89 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of GoertzelBankFilter
+ */
+#ifndef GoertzelBankFilter_h
+#define GoertzelBankFilter_h
+
+struct GoertzelBankArgs
+{
+	uint32_t numTones;
+	uint32_t window;
+	uint32_t stride;
+	uint32_t nout;
+	uint32_t offset;
+	float scale;
+};
+
+/**
+	@brief Bank of Goertzel filters tracking the amplitude of a configurable list of tones over time
+
+	Far cheaper than a full FFT when only a handful of bins matter: each tone costs one multiply-add
+	recurrence per input sample, evaluated over a sliding window so the output updates continuously
+	rather than once per FFT block. One output stream per tone.
+ */
+class GoertzelBankFilter : public Filter
+{
+public:
+	GoertzelBankFilter(const std::string& color);
+
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	virtual DataLocation GetInputLocation() override;
+
+	PROTOCOL_DECODER_INITPROC(GoertzelBankFilter)
+
+protected:
+	void OnFrequenciesChanged();
+
+	std::string m_freqsname;
+	std::string m_windowname;
+	std::string m_stridename;
+
+	///@brief Tone frequencies, in Hz, parsed from the frequency list parameter
+	std::vector<double> m_freqs;
+
+	///@brief Normalized phase increment (radians per sample) of each tone, bound to the compute shader
+	AcceleratorBuffer<float> m_tonePhases;
+
+	///@brief Output magnitudes, one row of nout samples per tone
+	AcceleratorBuffer<float> m_magnitudes;
+
+	ComputePipeline m_computePipeline;
+};
+
+#endif
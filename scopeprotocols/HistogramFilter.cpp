@@ -40,7 +40,8 @@ HistogramFilter::HistogramFilter(const string& color)
 	  m_autorangeName("Autorange?"),
 	  m_minName("Min Value"),
 	  m_maxName("Max Value"),
-	  m_binSizeName("Bin Size")
+	  m_binSizeName("Bin Size"),
+	  m_computePipeline("shaders/HistogramFilter.spv", 2, sizeof(HistogramFilterArgs))
 {
 	AddStream(Unit(Unit::UNIT_COUNTS_SCI), "data", Stream::STREAM_TYPE_ANALOG);
 
@@ -67,6 +68,9 @@ HistogramFilter::HistogramFilter(const string& color)
 	m_midpoint = 0.5;
 	m_range = 1;
 
+	m_gpuHist.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_gpuHist.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+
 	ClearSweeps();
 }
 
@@ -133,7 +137,7 @@ void HistogramFilter::ClearSweeps()
 	SetData(NULL, 0);
 }
 
-void HistogramFilter::Refresh()
+void HistogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
@@ -233,7 +237,13 @@ void HistogramFilter::Refresh()
 	LogTrace("Final configuration: %zu bins of %s\n", bins, xunit.PrettyPrint(binsize).c_str());
 
 	//Calculate histogram for our incoming data
-	auto data = MakeHistogram(sdin, udin, m_min, m_max, bins);
+	//Bin on the GPU if we can, falling back to the generic CPU path for sparse inputs
+	bool gpuBin = g_gpuFilterEnabled && (udin != nullptr);
+	vector<size_t> data;
+	if(gpuBin)
+		MakeHistogramGpu(cmdBuf, queue, udin, m_min, m_max, bins);
+	else
+		data = MakeHistogram(sdin, udin, m_min, m_max, bins);
 
 	//Reallocate the histogram if we changed it
 	if(reallocate)
@@ -259,7 +269,7 @@ void HistogramFilter::Refresh()
 	size_t vmax = 0;
 	for(size_t i=0; i<bins; i++)
 	{
-		m_histogram[i] += data[i];
+		m_histogram[i] += gpuBin ? m_gpuHist[i] : data[i];
 		vmax = max(vmax, m_histogram[i]);
 	}
 
@@ -275,3 +285,46 @@ void HistogramFilter::Refresh()
 
 	cap->MarkModifiedFromCpu();
 }
+
+/**
+	@brief Bins the input waveform on the GPU, leaving per-bin counts for this refresh in m_gpuHist.
+
+	Each workgroup accumulates into private shared-memory bins, then atomically merges them into the global histogram,
+	so global atomic traffic scales with the bin count rather than the sample count.
+ */
+void HistogramFilter::MakeHistogramGpu(
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	UniformAnalogWaveform* din,
+	float low,
+	float high,
+	size_t bins)
+{
+	//Zero the output bins (tiny compared to the input, so a CPU-side clear and upload is fine)
+	m_gpuHist.resize(bins);
+	m_gpuHist.PrepareForCpuAccess();
+	memset(m_gpuHist.GetCpuPointer(), 0, bins * sizeof(uint32_t));
+	m_gpuHist.MarkModifiedFromCpu();
+
+	HistogramFilterArgs args;
+	args.size = din->size();
+	args.nbins = bins;
+	args.low = low;
+	args.delta = high - low;
+
+	cmdBuf.begin({});
+
+	m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+	m_computePipeline.BindBufferNonblocking(1, m_gpuHist, cmdBuf);
+
+	//Cap the workgroup count: the shader uses a grid-stride loop, so each workgroup's shared-memory bins
+	//amortize over many samples rather than being merged once per 256 samples
+	uint32_t numGroups = min(GetComputeBlockCount(args.size, 256), 1024u);
+	m_computePipeline.Dispatch(cmdBuf, args, numGroups);
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+
+	m_gpuHist.MarkModifiedFromGpu();
+	m_gpuHist.PrepareForCpuAccess();
+}
@@ -35,12 +35,20 @@
 #ifndef HistogramFilter_h
 #define HistogramFilter_h
 
+struct HistogramFilterArgs
+{
+	uint32_t size;
+	uint32_t nbins;
+	float low;
+	float delta;
+};
+
 class HistogramFilter : public Filter
 {
 public:
 	HistogramFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
@@ -58,6 +66,14 @@ public:
 	PROTOCOL_DECODER_INITPROC(HistogramFilter)
 
 protected:
+	void MakeHistogramGpu(
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		UniformAnalogWaveform* din,
+		float low,
+		float high,
+		size_t bins);
+
 	std::string m_autorangeName;
 	std::string m_minName;
 	std::string m_maxName;
@@ -70,6 +86,11 @@ protected:
 	float m_max;
 
 	std::vector<size_t> m_histogram;
+
+	ComputePipeline m_computePipeline;
+
+	///@brief Per-refresh bin counts from the GPU binning kernel
+	AcceleratorBuffer<uint32_t> m_gpuHist;
 };
 
 #endif
@@ -43,11 +43,20 @@ IBISDriverFilter::IBISDriverFilter(const string& color)
 	, m_modelName("Model Name")
 	, m_cornerName("Corner")
 	, m_termName("Termination")
+	, m_computePipeline("shaders/EdgeSynthesis.spv", 4, sizeof(EdgeSynthesisArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("data");
 	CreateInput("clk");
 
+	//Use pinned memory for synthesis inputs
+	m_segStarts.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segStarts.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segments.SetCpuAccessHint(AcceleratorBuffer<EdgeSynthesisSegment>::HINT_LIKELY);
+	m_segments.SetGpuAccessHint(AcceleratorBuffer<EdgeSynthesisSegment>::HINT_LIKELY);
+	m_shapes.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_shapes.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
 	m_parameters[m_sampleRate] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLERATE));
 	m_parameters[m_sampleRate].SetIntVal(100 * INT64_C(1000) * INT64_C(1000) * INT64_C(1000));	//100 Gsps
 
@@ -143,7 +152,7 @@ void IBISDriverFilter::OnModelChanged()
 	}
 }
 
-void IBISDriverFilter::Refresh()
+void IBISDriverFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//If we don't have a model, nothing to do
 	if(!VerifyAllInputsOK() || !m_model)
@@ -227,41 +236,111 @@ void IBISDriverFilter::Refresh()
 		return;
 	}
 
-	//Generate output samples at uniform intervals
-	size_t iedge = 0;
-	for(size_t i=0; i<caplen; i++)
+	//Upload the V/T curves for the active corner as shape tables
+	//(absolute voltages, so the segment level blend is an identity)
+	auto& rcurve = rising.m_curves[corner];
+	auto& fcurve = falling.m_curves[corner];
+	if(rcurve.empty() || fcurve.empty())
 	{
-		//Timestamp of the current output sample
-		int64_t tnow = cap->m_timescale*i + cap->m_triggerPhase;
-
-		//Find timestamp of the next edge (including buffer propagation delay)
-		if( (iedge + 1) < edgeTimestamps.size())
+		SetData(NULL, 0);
+		return;
+	}
+	m_shapes.resize(2 * (rcurve.size() + fcurve.size()) );
+	m_shapes.PrepareForCpuAccess();
+	for(size_t i=0; i<rcurve.size(); i++)
+	{
+		m_shapes[i*2] = rcurve[i].m_time;
+		m_shapes[i*2 + 1] = rcurve[i].m_voltage;
+	}
+	size_t fbase = 2 * rcurve.size();
+	for(size_t i=0; i<fcurve.size(); i++)
+	{
+		m_shapes[fbase + i*2] = fcurve[i].m_time;
+		m_shapes[fbase + i*2 + 1] = fcurve[i].m_voltage;
+	}
+	m_shapes.MarkModifiedFromCpu();
+
+	//Build one synthesis segment per edge. A segment becomes active once we're past the delayed start of
+	//its edge (propagation delay of the buffer), but elapsed time within the segment is always measured
+	//from the nominal edge timestamp, matching the original sample loop.
+	size_t nedges = edgeTimestamps.size();
+	m_segStarts.resize(nedges);
+	m_segments.resize(nedges);
+	m_segStarts.PrepareForCpuAccess();
+	m_segments.PrepareForCpuAccess();
+
+	int64_t capstartSample = 0;
+	uint32_t nsegments = 0;
+	for(size_t j=0; j<nedges; j++)
+	{
+		//First edge is active from the start of the capture
+		int64_t s;
+		if(j == 0)
+			s = 0;
+		else
 		{
-			//Nominal timestamp of the edge
-			int64_t tnextedge = edgeTimestamps[iedge+1];
-
-			//Shift by the buffer delay
-			int64_t tdelayed = tnextedge;
-			if(edgeDirections[iedge+1])
+			int64_t tdelayed = edgeTimestamps[j];
+			if(edgeDirections[j])
 				tdelayed += rising_delay;
 			else
 				tdelayed += falling_delay;
 
-			//Move to the next edge if we're past the initial propagation delay of the upcoming edge
-			if(tnow >= tdelayed)
-				iedge ++;
+			//First sample at or after the delayed edge, monotonic even if delays differ between edges
+			s = (tdelayed - capstart + (int64_t)samplePeriod - 1) / (int64_t)samplePeriod;
+			s = max(s, capstartSample);
 		}
+		if(s >= (int64_t)caplen)
+			break;
+		capstartSample = s;
 
-		//Time since the edge started
-		int64_t relative_timestamp = tnow - edgeTimestamps[iedge];
-		float rel_sec = relative_timestamp * SECONDS_PER_FS;
-		float v;
-		if(edgeDirections[iedge])
-			v = rising.InterpolateVoltage(corner, rel_sec);
-		else
-			v = falling.InterpolateVoltage(corner, rel_sec);
-		cap->m_samples[i] = v;
+		EdgeSynthesisSegment seg;
+		seg.residualSec = (s * (int64_t)samplePeriod + capstart - edgeTimestamps[j]) * SECONDS_PER_FS;
+		seg.vStart = 0;
+		seg.vEnd = 1;
+		seg.shapeIndex = edgeDirections[j] ? 0 : 1;
+
+		m_segStarts[nsegments] = s;
+		m_segments[nsegments] = seg;
+		nsegments ++;
 	}
+	m_segStarts.MarkModifiedFromCpu();
+	m_segments.MarkModifiedFromCpu();
 
-	cap->MarkModifiedFromCpu();
+	if( (nsegments == 0) || (caplen == 0) )
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	EdgeSynthesisArgs args;
+	args.nsamples = caplen;
+	args.nsegments = nsegments;
+	args.samplePeriodSec = samplePeriod * SECONDS_PER_FS;
+	args.shapeOffset0 = 0;
+	args.shapeLen0 = rcurve.size();
+	args.shapeOffset1 = rcurve.size();
+	args.shapeLen1 = fcurve.size();
+
+	if(g_gpuFilterEnabled)
+	{
+		cmdBuf.begin({});
+
+		m_computePipeline.BindBufferNonblocking(0, cap->m_samples, cmdBuf, true);
+		m_computePipeline.BindBufferNonblocking(1, m_segStarts, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(2, m_segments, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(3, m_shapes, cmdBuf);
+
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(caplen, 64));
+
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+		cap->MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		cap->PrepareForCpuAccess();
+		SynthesizeEdgesCpu(cap->m_samples, m_segStarts, m_segments, m_shapes, args);
+		cap->MarkModifiedFromCpu();
+	}
 }
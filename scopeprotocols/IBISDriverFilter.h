@@ -35,6 +35,8 @@
 #ifndef IBISDriverFilter_h
 #define IBISDriverFilter_h
 
+#include "EdgeSynthesis.h"
+
 class IBISDriverFilter : public Filter
 {
 public:
@@ -44,7 +46,7 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	virtual void LoadParameters(const YAML::Node& node, IDTable& table) override;
 
@@ -62,6 +64,18 @@ protected:
 	std::string m_modelName;
 	std::string m_cornerName;
 	std::string m_termName;
+
+	///@brief Compute pipeline for output sample synthesis
+	ComputePipeline m_computePipeline;
+
+	///@brief Output sample index at which each edge segment begins
+	AcceleratorBuffer<uint32_t> m_segStarts;
+
+	///@brief Edge segment descriptors for the synthesis shader
+	AcceleratorBuffer<EdgeSynthesisSegment> m_segments;
+
+	///@brief Rising and falling V/T curves for the active corner, packed as (time, voltage) pairs
+	AcceleratorBuffer<float> m_shapes;
 };
 
 #endif
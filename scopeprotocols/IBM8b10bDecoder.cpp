@@ -63,6 +63,9 @@ FilterParameter IBM8b10bDecoder::MakeIBM8b10bDisplayFormatParameter()
 	f.AddEnumValue("Hex (K.bc b5)", FORMAT_HEX);
 	f.SetIntVal(FORMAT_DOTTED);
 
+	//Only read by IBM8b10bWaveform::GetText() at render time, so no need to re-decode when it changes
+	f.MarkPresentationOnly();
+
 	return f;
 }
 
@@ -119,13 +122,16 @@ void IBM8b10bDecoder::Refresh()
 	SampleOnAnyEdgesBase(din, clkin, data);
 	data.PrepareForCpuAccess();
 
-	//Decode the actual data
-	int last_disp = -1;
+	//First pass: find symbol boundaries, realignment points, and squelch gaps.
+	//This is inherently sequential, but only looks at edge timing (plus comma placement when realigning)
+	//so it's cheap compared to the full decode.
 	bool first = true;
 	size_t dlen = data.m_samples.size() - 11;
 	int64_t lastSymbolLength = 0;
 	int64_t lastSymbolEnd = 0;
 	int64_t lastSymbolStart = 0;
+	vector<size_t> symbolIndexes;
+	vector<bool> resetDisparity;
 	for(size_t i=0; i<dlen;i+=10)
 	{
 		//Re-synchronize at start of waveform or if squelch is reopening
@@ -140,8 +146,203 @@ void IBM8b10bDecoder::Refresh()
 			Align(data, i);
 		}
 
-		//5b/6b decode
+		//Horizontally shift the decoded symbol back by half a UI
+		//since the recovered clock edge is in the middle of the UI.
+		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
+		auto symbolStart = data.m_offsets[i] - data.m_durations[i]/2;
+		auto symbolLength = data.m_offsets[i+10] - data.m_offsets[i];
+		if( (symbolStart - lastSymbolStart) > 5*symbolLength)
+		{
+			LogTrace("Sync lost (big gap)\n");
+			first = true;
+		}
+		else
+		{
+			cap->m_offsets.push_back(symbolStart);
+			cap->m_durations.push_back(lastSymbolLength);
+			symbolIndexes.push_back(i);
+			resetDisparity.push_back(first);
+			first = false;
+		}
+
+		lastSymbolLength = symbolLength;
+		lastSymbolEnd = symbolStart + lastSymbolEnd;
+		lastSymbolStart = symbolStart;
+	}
+
+	//Second pass: the actual 5b/6b and 3b/4b decode.
+	//With block boundaries known, each symbol is an independent table lookup, so fan out across threads
+	//for long captures.
+	size_t nsyms = symbolIndexes.size();
+	cap->m_samples.resize(nsyms);
+	vector<int> totalDisparities(nsyms);
+
+	//No point in spawning threads unless each one gets a reasonable chunk of work
+	const size_t minSymbolsPerThread = 65536;
+	size_t nthreads = max<size_t>(thread::hardware_concurrency(), 1);
+	nthreads = min(nthreads, (nsyms + minSymbolsPerThread - 1) / minSymbolsPerThread);
+	if(nthreads <= 1)
+		DecodeSymbols(data, symbolIndexes, 0, nsyms, cap, totalDisparities);
+	else
+	{
+		size_t symbolsPerThread = (nsyms + nthreads - 1) / nthreads;
+		vector<thread> threads;
+		for(size_t t=0; t<nthreads; t++)
+		{
+			size_t begin = t * symbolsPerThread;
+			size_t end = min(begin + symbolsPerThread, nsyms);
+			threads.emplace_back(
+				[this, &data, &symbolIndexes, begin, end, cap, &totalDisparities]
+				{ DecodeSymbols(data, symbolIndexes, begin, end, cap, totalDisparities); });
+		}
+		for(auto& t : threads)
+			t.join();
+	}
+
+	//Final pass: running disparity tracking.
+	//This is sequential again, but just a couple of adds and compares per symbol.
+	int last_disp = -1;
+	for(size_t k=0; k<nsyms; k++)
+	{
+		int total_disp = totalDisparities[k];
+		if(resetDisparity[k])
+		{
+			if(total_disp < 0)
+				last_disp = 1;
+			else
+				last_disp = -1;
+		}
+
+		auto& s = cap->m_samples[k];
+		if(total_disp > 0 && last_disp > 0)
+		{
+			s.m_errorDisp = true;
+			last_disp = 1;
+		}
+		else if(total_disp < 0 && last_disp < 0)
+		{
+			s.m_errorDisp = true;
+			last_disp = -1;
+		}
+		else
+			last_disp += total_disp;
+		s.m_disparity = last_disp;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Decode a range of symbols, writing everything but the running disparity fields
+
+	Symbols are independent here, so multiple threads can decode disjoint ranges concurrently.
+	Per-symbol disparity contributions are written to totalDisparities for the sequential tracking pass.
+ */
+void IBM8b10bDecoder::DecodeSymbols(
+	SparseDigitalWaveform& data,
+	const vector<size_t>& symbolIndexes,
+	size_t begin,
+	size_t end,
+	IBM8b10bWaveform* cap,
+	vector<int>& totalDisparities)
+{
+	static const int code5_table[64] =
+	{
+		 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
+		 0, 27,  4, 20, 24, 12, 28, 28, //08-0f
+		 0, 29,  2, 18, 31, 10, 26, 15, //10-17
+		 0,  6, 22, 16, 14,  1, 30,  0,	//18-1f
+		 0, 30, 1,  17, 16,  9, 25,  0,	//20-27
+		15,  5, 21, 31, 13,  2, 29,  0,	//28-2f
+		28,  3, 19, 24, 11,  4, 27,  0,	//30-37
+		 7,  8, 23,  0,  0,  0,  0,  0  //38-3f
+	};
+
+	static const int disp5_table[64] =
+	{
+		 0,  0,  0, 0,  0, -2, -2, 0,	//00-07
+		 0, -2, -2, 0, -2,  0,  0, 2,	//08-0f
+		 0, -2, -2, 0, -2,  0,  0, 2,	//10-17
+		-2,  0,  0, 2,  0,  2,  2, 0,	//18-1f
+		 0, -2, -2, 0, -2,  0,  0, 2,	//20-27
+		-2,  0,  0, 2,  0,  2,  2, 0,	//28-2f
+		-2,  0,  0, 2,  0,  2,  2, 0,	//30-37
+		 0,  2,  2, 0,  0,  0,  0, 0 	//38-3f
+	};
+
+	static const bool err5_table[64] =
+	{
+		 true,  true,  true,  true,  true, false, false, false,	//00-07
+		 true, false, false, false, false, false, false, false, //08-0f
+		 true, false, false, false, false, false, false, false, //10-17
+		false, false, false, false, false, false, false,  true,	//18-1f
+		 true, false, false, false, false, false, false, false,	//20-27
+		false, false, false, false, false, false, false,  true,	//28-2f
+		false, false, false, false, false, false, false,  true,	//30-37
+		false, false, false,  true,  true,  true,  true,  true  //38-3f
+	};
+
+	static const bool ctl5_table[64] =
+	{
+		false, false, false, false, false, false, false, false,	//00-07
+		false, false, false, false, false, false, false, true,  //08-0f
+		false, false, false, false, false, false, false, false, //10-17
+		false, false, false, false, false, false, false, false,	//18-1f
+		false, false, false, false, false, false, false, false,	//20-27
+		false, false, false, false, false, false, false, false,	//28-2f
+		true,  false, false, false, false, false, false, false,	//30-37
+		false, false, false, false, false, false, false, false  //38-3f
+	};
+
+	static const bool err3_ctl_table[16] =
+	{
+		 true,  true, false, false, false, false, false, false,
+		false, false, false, false, false, false,  true,  true
+	};
+
+	static const int code3_pos_ctl_table[16] =	//if disp5 positive
+	{
+		0, 0, 4, 3, 0, 2, 6, 7,
+		7, 1, 5, 0, 3, 4, 0, 0,
+	};
+
+	static const int code3_neg_ctl_table[16] =	//if disp5 negative
+	{
+		0, 0, 4, 3, 0, 5, 1, 7,
+		7, 6, 2, 0, 3, 4, 0, 0
+	};
+
+	static const bool err3_table[16] =
+	{
+		 true,  false, false, false, false, false, false, false,
+		false, false, false, false, false, false, false,  true
+	};
 
+	static const int code3_table[16] =
+	{
+		0, 7, 4, 3, 0, 2, 6, 7,
+		7, 1, 5, 0, 3, 4, 7, 0
+	};
+
+	static const int disp3_table[16] =
+	{
+		 0, -2, -2, 0, -2, 0, 0, 2,
+		-2, 0,  0, 2,  0, 2, 2, 0
+	};
+
+	//true only for Dx.A7
+	static const bool alt3_table[16] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 1,
+		1, 0, 0, 0, 0, 0, 0, 0
+	};
+
+	for(size_t k=begin; k<end; k++)
+	{
+		size_t i = symbolIndexes[k];
+
+		//5b/6b decode
 		uint8_t code6 =
 			(data.m_samples[i+0] ? 32 : 0) |
 			(data.m_samples[i+1] ? 16 : 0) |
@@ -150,54 +351,6 @@ void IBM8b10bDecoder::Refresh()
 			(data.m_samples[i+4] ? 2 : 0) |
 			(data.m_samples[i+5] ? 1 : 0);
 
-		static const int code5_table[64] =
-		{
-			 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
-			 0, 27,  4, 20, 24, 12, 28, 28, //08-0f
-			 0, 29,  2, 18, 31, 10, 26, 15, //10-17
-			 0,  6, 22, 16, 14,  1, 30,  0,	//18-1f
-			 0, 30, 1,  17, 16,  9, 25,  0,	//20-27
-			15,  5, 21, 31, 13,  2, 29,  0,	//28-2f
-			28,  3, 19, 24, 11,  4, 27,  0,	//30-37
-			 7,  8, 23,  0,  0,  0,  0,  0  //38-3f
-		};
-
-		static const int disp5_table[64] =
-		{
-			 0,  0,  0, 0,  0, -2, -2, 0,	//00-07
-			 0, -2, -2, 0, -2,  0,  0, 2,	//08-0f
-			 0, -2, -2, 0, -2,  0,  0, 2,	//10-17
-			-2,  0,  0, 2,  0,  2,  2, 0,	//18-1f
-			 0, -2, -2, 0, -2,  0,  0, 2,	//20-27
-			-2,  0,  0, 2,  0,  2,  2, 0,	//28-2f
-			-2,  0,  0, 2,  0,  2,  2, 0,	//30-37
-			 0,  2,  2, 0,  0,  0,  0, 0 	//38-3f
-		};
-
-		static const bool err5_table[64] =
-		{
-			 true,  true,  true,  true,  true, false, false, false,	//00-07
-			 true, false, false, false, false, false, false, false, //08-0f
-			 true, false, false, false, false, false, false, false, //10-17
-			false, false, false, false, false, false, false,  true,	//18-1f
-			 true, false, false, false, false, false, false, false,	//20-27
-			false, false, false, false, false, false, false,  true,	//28-2f
-			false, false, false, false, false, false, false,  true,	//30-37
-			false, false, false,  true,  true,  true,  true,  true  //38-3f
-		};
-
-		static const bool ctl5_table[64] =
-		{
-			false, false, false, false, false, false, false, false,	//00-07
-			false, false, false, false, false, false, false, true,  //08-0f
-			false, false, false, false, false, false, false, false, //10-17
-			false, false, false, false, false, false, false, false,	//18-1f
-			false, false, false, false, false, false, false, false,	//20-27
-			false, false, false, false, false, false, false, false,	//28-2f
-			true,  false, false, false, false, false, false, false,	//30-37
-			false, false, false, false, false, false, false, false  //38-3f
-		};
-
 		int code5 = code5_table[code6];
 		int disp5 = disp5_table[code6];
 		bool err5 = err5_table[code6];
@@ -210,49 +363,6 @@ void IBM8b10bDecoder::Refresh()
 			(data.m_samples[i+8] ? 2 : 0) |
 			(data.m_samples[i+9] ? 1 : 0);
 
-		static const bool err3_ctl_table[16] =
-		{
-			 true,  true, false, false, false, false, false, false,
-			false, false, false, false, false, false,  true,  true
-		};
-
-		static const int code3_pos_ctl_table[16] =	//if disp5 positive
-		{
-			0, 0, 4, 3, 0, 2, 6, 7,
-			7, 1, 5, 0, 3, 4, 0, 0,
-		};
-
-		static const int code3_neg_ctl_table[16] =	//if disp5 negative
-		{
-			0, 0, 4, 3, 0, 5, 1, 7,
-			7, 6, 2, 0, 3, 4, 0, 0
-		};
-
-		static const bool err3_table[16] =
-		{
-			 true,  false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false,  true
-		};
-
-		static const int code3_table[16] =
-		{
-			0, 7, 4, 3, 0, 2, 6, 7,
-			7, 1, 5, 0, 3, 4, 7, 0
-		};
-
-		static const int disp3_table[16] =
-		{
-			 0, -2, -2, 0, -2, 0, 0, 2,
-			-2, 0,  0, 2,  0, 2, 2, 0
-		};
-
-		//true only for Dx.A7
-		const bool alt3_table[16] =
-		{
-			0, 0, 0, 0, 0, 0, 0, 1,
-			1, 0, 0, 0, 0, 0, 0, 0
-		};
-
 		int code3 = false;
 		int disp3 = 0;
 		int err3 = false;
@@ -271,31 +381,6 @@ void IBM8b10bDecoder::Refresh()
 		}
 		disp3 = disp3_table[code4];
 
-		//Disparity tracking
-		int total_disp = disp3 + disp5;
-		if(first)
-		{
-			if(total_disp < 0)
-				last_disp = 1;
-			else
-				last_disp = -1;
-			first = false;
-		}
-
-		bool disperr = false;
-		if(total_disp > 0 && last_disp > 0)
-		{
-			disperr = true;
-			last_disp = 1;
-		}
-		else if(total_disp < 0 && last_disp < 0)
-		{
-			disperr = true;
-			last_disp = -1;
-		}
-		else
-			last_disp += total_disp;
-
 		//Special processing for a few control codes that use the .A7 format
 		bool alt = alt3_table[code4];
 		if(alt)
@@ -304,30 +389,10 @@ void IBM8b10bDecoder::Refresh()
 				ctl5 = true;
 		}
 
-		//Horizontally shift the decoded symbol back by half a UI
-		//since the recovered clock edge is in the middle of the UI.
-		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
-		auto symbolStart = data.m_offsets[i] - data.m_durations[i]/2;
-		auto symbolLength = data.m_offsets[i+10] - data.m_offsets[i];
-		if( (symbolStart - lastSymbolStart) > 5*symbolLength)
-		{
-			LogTrace("Sync lost (big gap)\n");
-			first = true;
-		}
-		else
-		{
-			cap->m_offsets.push_back(symbolStart);
-			cap->m_durations.push_back(lastSymbolLength);
-			cap->m_samples.push_back(IBM8b10bSymbol(ctl5, err5, err3, disperr, (code3 << 5) | code5, last_disp));
-		}
-
-		lastSymbolLength = symbolLength;
-		lastSymbolEnd = symbolStart + lastSymbolEnd;
-		lastSymbolStart = symbolStart;
+		//Disparity error checking and the final disparity value are filled in by the sequential pass
+		cap->m_samples[k] = IBM8b10bSymbol(ctl5, err5, err3, false, (code3 << 5) | code5, 0);
+		totalDisparities[k] = disp3 + disp5;
 	}
-
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
 }
 
 void IBM8b10bDecoder::Align(SparseDigitalWaveform& data, size_t& i)
@@ -106,6 +106,14 @@ protected:
 	std::string m_commaSearchWindow;
 
 	void Align(SparseDigitalWaveform& data, size_t& i);
+
+	void DecodeSymbols(
+		SparseDigitalWaveform& data,
+		const std::vector<size_t>& symbolIndexes,
+		size_t begin,
+		size_t end,
+		IBM8b10bWaveform* cap,
+		std::vector<int>& totalDisparities);
 };
 
 #endif
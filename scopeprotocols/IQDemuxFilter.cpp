@@ -170,36 +170,36 @@ void IQDemuxFilter::Refresh(
 		}
 	}
 
-	//Synthesize the output
-	bool clkval = false;
-	for(size_t i=istart; i+1 < len; i += 2)
-	{
-		int64_t tnow = sampled.m_offsets[i];
-
-		//Extend previous sample, if any
-		size_t outlen = iout->m_offsets.size();
-		if(outlen)
-		{
-			int64_t dur = tnow - iout->m_offsets[outlen-1];
-			iout->m_durations[outlen-1] = dur;
-			qout->m_durations[outlen-1] = dur;
-			clkout->m_durations[outlen-1] = dur;
-		}
-
-		//Add this sample
-		iout->m_offsets.push_back(tnow);
-		qout->m_offsets.push_back(tnow);
-		clkout->m_offsets.push_back(tnow);
+	//Synthesize the output in a single pass, with all buffers sized up front so the hot loop is just
+	//strided scatter writes instead of six push_backs per symbol
+	size_t nout = 0;
+	if(len > istart)
+		nout = (len - istart) / 2;
 
-		iout->m_durations.push_back(1);
-		qout->m_durations.push_back(1);
-		clkout->m_durations.push_back(1);
+	iout->Resize(nout);
+	qout->Resize(nout);
+	clkout->Resize(nout);
 
-		iout->m_samples.push_back(sampled.m_samples[i]);
-		qout->m_samples.push_back(sampled.m_samples[i+1]);
-		clkout->m_samples.push_back(clkval);
+	for(size_t k=0; k<nout; k++)
+	{
+		size_t i = istart + k*2;
+		int64_t tnow = sampled.m_offsets[i];
 
-		clkval = !clkval;
+		iout->m_offsets[k] = tnow;
+		qout->m_offsets[k] = tnow;
+		clkout->m_offsets[k] = tnow;
+
+		//Each symbol lasts until the start of the next one (placeholder duration for the last)
+		int64_t dur = 1;
+		if(i + 3 < len)
+			dur = sampled.m_offsets[i+2] - tnow;
+		iout->m_durations[k] = dur;
+		qout->m_durations[k] = dur;
+		clkout->m_durations[k] = dur;
+
+		iout->m_samples[k] = sampled.m_samples[i];
+		qout->m_samples[k] = sampled.m_samples[i+1];
+		clkout->m_samples[k] = (k & 1) ? true : false;
 	}
 
 	iout->MarkModifiedFromCpu();
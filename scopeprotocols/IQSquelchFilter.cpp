@@ -37,6 +37,8 @@ using namespace std;
 
 IQSquelchFilter::IQSquelchFilter(const string& color)
 	: Filter(color, CAT_RF)
+	, m_blockMaxComputePipeline("shaders/IQSquelchBlockMax.spv", 3, sizeof(IQSquelchBlockMaxArgs))
+	, m_applyComputePipeline("shaders/IQSquelchApply.spv", 5, sizeof(IQSquelchApplyArgs))
 {
 	//Set up channels
 	CreateInput("I");
@@ -52,6 +54,9 @@ IQSquelchFilter::IQSquelchFilter(const string& color)
 	m_holdtimename = "Hold time";
 	m_parameters[m_holdtimename] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
 	m_parameters[m_holdtimename].SetIntVal(1e6);
+
+	m_blockMaxBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+	m_blockMaxBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -76,10 +81,16 @@ string IQSquelchFilter::GetProtocolName()
 	return "IQ Squelch";
 }
 
+Filter::DataLocation IQSquelchFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void IQSquelchFilter::Refresh()
+void IQSquelchFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOKAndUniformAnalog())
@@ -90,8 +101,6 @@ void IQSquelchFilter::Refresh()
 
 	auto din_i = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(0));
 	auto din_q = dynamic_cast<UniformAnalogWaveform*>(GetInputWaveform(1));
-	din_i->PrepareForCpuAccess();
-	din_q->PrepareForCpuAccess();
 
 	size_t len = min(din_i->size(), din_q->size());
 
@@ -99,47 +108,46 @@ void IQSquelchFilter::Refresh()
 	auto holdtime_fs = m_parameters[m_holdtimename].GetIntVal();
 	size_t holdtime_samples = holdtime_fs / din_i->m_timescale;
 
-	auto dout_i = SetupEmptyUniformAnalogOutputWaveform(din_i, 0);
-	auto dout_q = SetupEmptyUniformAnalogOutputWaveform(din_q, 1);
+	auto dout_i = SetupEmptyUniformAnalogOutputWaveform(din_i, 0, true);
+	auto dout_q = SetupEmptyUniformAnalogOutputWaveform(din_q, 1, true);
 	dout_i->Resize(len);
 	dout_q->Resize(len);
-	dout_i->PrepareForCpuAccess();
-	dout_q->PrepareForCpuAccess();
-
-	bool open = false;
-	float tsq = threshold * threshold;
-	size_t topen = 0;
-	for(size_t i=0; i<len; i++)
-	{
-		//Find I/Q magnitude (do comparison on squared mag to avoid a ton of sqrts)
-		float vi = din_i->m_samples[i];
-		float vq = din_q->m_samples[i];
-		float msq = vi*vi + vq*vq;
-
-		//Signal amplitude is above threshold - open squelch immediately
-		//TODO: attack time?
-		if(msq > tsq)
-		{
-			open = true;
-			topen = i;
-		}
-
-		//Signal amplitude below threshold - close squelch after hold time elapses
-		else if(open && ( (i - topen) > holdtime_samples) )
-			open = false;
-
-		if(open)
-		{
-			dout_i->m_samples[i] = din_i->m_samples[i];
-			dout_q->m_samples[i] = din_q->m_samples[i];
-		}
-		else
-		{
-			dout_i->m_samples[i] = 0.0f;
-			dout_q->m_samples[i] = 0.0f;
-		}
-	}
 
-	dout_i->MarkModifiedFromCpu();
-	dout_q->MarkModifiedFromCpu();
+	//The sequential open/close state machine (open when squared magnitude crosses threshold, close once it has
+	//been below threshold for the hold time) is equivalent to asking "did any sample in the trailing hold window
+	//cross the threshold?". That reformulation has no cross-sample state, so the whole squelch runs as two GPU
+	//dispatches in one submit: a coarse per-block maximum, then a fused threshold + gate pass that tests full
+	//blocks of its window against the maxima and only touches raw samples at the window edges.
+	size_t nblocks = GetComputeBlockCount(len, SQUELCH_BLOCK_SIZE);
+	m_blockMaxBuf.resize(nblocks);
+
+	cmdBuf.begin({});
+
+	IQSquelchBlockMaxArgs bargs;
+	bargs.len = len;
+	bargs.nblocks = nblocks;
+	m_blockMaxComputePipeline.BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
+	m_blockMaxComputePipeline.BindBufferNonblocking(1, din_q->m_samples, cmdBuf);
+	m_blockMaxComputePipeline.BindBufferNonblocking(2, m_blockMaxBuf, cmdBuf, true);
+	m_blockMaxComputePipeline.Dispatch(cmdBuf, bargs, GetComputeBlockCount(nblocks, 64));
+	m_blockMaxComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+	m_blockMaxBuf.MarkModifiedFromGpu();
+
+	IQSquelchApplyArgs aargs;
+	aargs.len = len;
+	aargs.holdtime = min(holdtime_samples, len);	//clamp so it fits a uint32, window never extends past the record
+	aargs.tsq = threshold * threshold;
+	m_applyComputePipeline.BindBufferNonblocking(0, din_i->m_samples, cmdBuf);
+	m_applyComputePipeline.BindBufferNonblocking(1, din_q->m_samples, cmdBuf);
+	m_applyComputePipeline.BindBufferNonblocking(2, m_blockMaxBuf, cmdBuf);
+	m_applyComputePipeline.BindBufferNonblocking(3, dout_i->m_samples, cmdBuf, true);
+	m_applyComputePipeline.BindBufferNonblocking(4, dout_q->m_samples, cmdBuf, true);
+	m_applyComputePipeline.Dispatch(cmdBuf, aargs, GetComputeBlockCount(len, 64));
+	m_applyComputePipeline.AddComputeMemoryBarrier(cmdBuf);
+
+	//Done, block until the compute operations finish
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	dout_i->MarkModifiedFromGpu();
+	dout_q->MarkModifiedFromGpu();
 }
@@ -35,12 +35,28 @@
 #ifndef IQSquelchFilter_h
 #define IQSquelchFilter_h
 
+///@brief Arguments to the per-block maximum pass of the squelch gate
+struct IQSquelchBlockMaxArgs
+{
+	uint32_t len;
+	uint32_t nblocks;
+};
+
+///@brief Arguments to the fused threshold / gate pass of the squelch
+struct IQSquelchApplyArgs
+{
+	uint32_t len;
+	uint32_t holdtime;
+	float tsq;
+};
+
 class IQSquelchFilter : public Filter
 {
 public:
 	IQSquelchFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
 
 	static std::string GetProtocolName();
 
@@ -51,6 +67,14 @@ public:
 protected:
 	std::string m_thresholdname;
 	std::string m_holdtimename;
+
+	///@brief Samples per coarse block, must match IQSquelchBlockMax.glsl / IQSquelchApply.glsl
+	static const size_t SQUELCH_BLOCK_SIZE = 64;
+
+	AcceleratorBuffer<float> m_blockMaxBuf;
+
+	ComputePipeline m_blockMaxComputePipeline;
+	ComputePipeline m_applyComputePipeline;
 };
 
 #endif
@@ -36,26 +36,12 @@ using namespace std;
 // Construction / destruction
 
 InvertFilter::InvertFilter(const string& color)
-	: Filter(color, CAT_MATH)
+	: PointwiseFilter(color, CAT_MATH)
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("din");
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Factory methods
-
-bool InvertFilter::ValidateChannel(size_t i, StreamDescriptor stream)
-{
-	if(stream.m_channel == NULL)
-		return false;
-
-	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
-		return true;
-
-	return false;
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Accessors
 
@@ -75,44 +61,7 @@ void InvertFilter::SetDefaultName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void InvertFilter::Refresh()
+PointwiseFilter::PointwiseOp InvertFilter::GetPointwiseOp()
 {
-	//Make sure we've got valid inputs
-	if(!VerifyAllInputsOK())
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	auto din = GetInputWaveform(0);
-	size_t len = din->size();
-
-	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
-	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
-
-	if(sdin)
-	{
-		//Negate each sample
-		auto cap = SetupSparseOutputWaveform(sdin, 0, 0, 0);
-		cap->PrepareForCpuAccess();
-		float* out = (float*)__builtin_assume_aligned(&cap->m_samples[0], 16);
-		float* a = (float*)__builtin_assume_aligned(&sdin->m_samples[0], 16);
-		for(size_t i=0; i<len; i++)
-			out[i] = -a[i];
-
-		cap->MarkModifiedFromCpu();
-	}
-	else if(udin)
-	{
-		//Negate each sample
-		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
-		cap->Resize(len);
-		cap->PrepareForCpuAccess();
-		float* out = (float*)__builtin_assume_aligned(&cap->m_samples[0], 16);
-		float* a = (float*)__builtin_assume_aligned(&udin->m_samples[0], 16);
-		for(size_t i=0; i<len; i++)
-			out[i] = -a[i];
-
-		cap->MarkModifiedFromCpu();
-	}
+	return PointwiseOp(PointwiseOp::OP_NEGATE);
 }
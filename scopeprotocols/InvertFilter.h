@@ -35,17 +35,17 @@
 #ifndef InvertFilter_h
 #define InvertFilter_h
 
-class InvertFilter : public Filter
+#include "PointwiseFilter.h"
+
+class InvertFilter : public PointwiseFilter
 {
 public:
 	InvertFilter(const std::string& color);
 
-	virtual void Refresh() override;
-
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
 
-	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+	virtual PointwiseOp GetPointwiseOp() override;
 
 	PROTOCOL_DECODER_INITPROC(InvertFilter)
 };
@@ -127,15 +127,13 @@ void J1939SourceMatchFilter::Refresh()
 	auto starget = to_string(target);
 
 	//Filter the packet stream separately from the timeline stream
-	auto& srcPackets = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel)->GetPackets();
-	for(auto p : srcPackets)
+	//(indexed lookup rather than a linear scan over every packet in the capture)
+	auto srcDecoder = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel);
+	for(auto p : srcDecoder->FindPackets("Source", starget))
 	{
-		if(p->m_headers["Source"] == starget)
-		{
-			auto np = new Packet;
-			*np = *p;
-			m_packets.push_back(np);
-		}
+		auto np = new Packet;
+		*np = *p;
+		m_packets.push_back(np);
 	}
 
 	//Process the J1939 packet stream
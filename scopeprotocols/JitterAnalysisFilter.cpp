@@ -0,0 +1,301 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "JitterAnalysisFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+JitterAnalysisFilter::JitterAnalysisFilter(const string& color)
+	: Filter(color, CAT_ANALYSIS)
+	, m_threshname("Threshold")
+	, m_skipname("Skip Start")
+{
+	AddStream(Unit(Unit::UNIT_FS), "TIE", Stream::STREAM_TYPE_ANALOG);
+	AddStream(Unit(Unit::UNIT_FS), "RjBUj", Stream::STREAM_TYPE_ANALOG);
+	AddStream(Unit(Unit::UNIT_FS), "DDJ", Stream::STREAM_TYPE_ANALOG_SCALAR);
+
+	//Set up channels
+	CreateInput("Clock");
+	CreateInput("Golden");
+	CreateInput("Threshold");
+
+	m_parameters[m_threshname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
+	m_parameters[m_threshname].SetFloatVal(0);
+
+	m_parameters[m_skipname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_skipname].SetIntVal(0);
+
+	for(int i=0; i<256; i++)
+		m_table[i] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool JitterAnalysisFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_DIGITAL) )	//allow digital clocks
+		return true;
+	if( (i <= 2) && (stream.GetType() == Stream::STREAM_TYPE_DIGITAL) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string JitterAnalysisFilter::GetProtocolName()
+{
+	return "Jitter Analysis";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void JitterAnalysisFilter::Refresh()
+{
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		SetData(NULL, 1);
+		m_streams[2].m_value = NAN;
+		return;
+	}
+
+	//Get the input data
+	auto clk = GetInputWaveform(0);
+	auto uaclk = dynamic_cast<UniformAnalogWaveform*>(clk);
+	auto saclk = dynamic_cast<SparseAnalogWaveform*>(clk);
+	auto udclk = dynamic_cast<UniformDigitalWaveform*>(clk);
+	auto sdclk = dynamic_cast<SparseDigitalWaveform*>(clk);
+	auto golden = GetInputWaveform(1);
+	auto sgolden = dynamic_cast<SparseDigitalWaveform*>(golden);
+	auto ugolden = dynamic_cast<UniformDigitalWaveform*>(golden);
+	auto thresh = GetInputWaveform(2);
+	size_t len = min(clk->size(), golden->size());
+
+	clk->PrepareForCpuAccess();
+	golden->PrepareForCpuAccess();
+	thresh->PrepareForCpuAccess();
+
+	//Create the TIE output
+	auto capTie = SetupEmptySparseAnalogOutputWaveform(clk, 0);
+	capTie->m_timescale = 1;
+	capTie->m_triggerPhase = 0;
+	capTie->PrepareForCpuAccess();
+
+	//Timestamps of the edges (shared by everything downstream)
+	vector<int64_t> edges;
+	if(uaclk || saclk)
+		FindZeroCrossings(saclk, uaclk, m_parameters[m_threshname].GetFloatVal(), edges);
+	else
+		FindZeroCrossings(sdclk, udclk, edges);
+
+	//Ignore edges before things have stabilized
+	int64_t skip_time = m_parameters[m_skipname].GetIntVal();
+
+	//Pass 1: TIE. For each input clock edge, find the closest recovered clock edge.
+	//Same algorithm as TIEMeasurement.
+	size_t iedge = 0;
+	size_t tlast = 0;
+	for(auto atime : edges)
+	{
+		if(iedge >= len)
+			break;
+
+		int64_t prev_edge = ::GetOffsetScaled(sgolden, ugolden, iedge);
+		int64_t next_edge = prev_edge;
+		size_t jedge = iedge;
+
+		bool hit = false;
+
+		//Look for a pair of edges bracketing our edge
+		while(true)
+		{
+			prev_edge = next_edge;
+			next_edge = ::GetOffsetScaled(sgolden, ugolden, jedge);
+
+			//First golden edge is after this signal edge
+			if(prev_edge > atime)
+				break;
+
+			//Bracketed
+			if( (prev_edge < atime) && (next_edge > atime) )
+			{
+				hit = true;
+				break;
+			}
+
+			//No, keep looking
+			jedge ++;
+
+			//End of capture
+			if(jedge >= len)
+				break;
+		}
+
+		//No interval error possible without a reference clock edge.
+		if(!hit)
+			continue;
+
+		//Hit! We're bracketed. Start the next search from this edge
+		iedge = jedge;
+
+		//Since the CDR filter adds a 90 degree phase offset for sampling in the middle of the data eye,
+		//we need to use the *midpoint* of the golden clock cycle as the nominal position of the clock
+		//edge for TIE measurements.
+		int64_t golden_period = next_edge - prev_edge;
+		int64_t golden_center = prev_edge + golden_period/2;
+		int64_t tie = atime - golden_center;
+
+		//Ignore edges before things have stabilized
+		if(prev_edge < skip_time)
+		{}
+
+		else
+		{
+			//Update the last sample
+			size_t end = capTie->size();
+			if(end)
+				capTie->m_durations[end-1] = atime - tlast;
+
+			capTie->m_offsets.push_back(golden_center);
+			capTie->m_durations.push_back(0);
+			capTie->m_samples.push_back(tie);
+		}
+
+		tlast = golden_center;
+	}
+
+	SetData(capTie, 0);
+	capTie->MarkModifiedFromCpu();
+
+	if(capTie->size() == 0)
+	{
+		SetData(NULL, 1);
+		m_streams[2].m_value = NAN;
+		return;
+	}
+
+	//Sample the thresholded data on the recovered clock, once for both DDJ and Rj+BUj
+	//(the separate filters each did this over the full capture)
+	SparseDigitalWaveform samples;
+	SampleOnAnyEdgesBase(thresh, golden, samples);
+	samples.PrepareForCpuAccess();
+
+	//Pass 2: align each sampled bit with its TIE sample, accumulating the DDJ history table and remembering
+	//the matches so the Rj+BUj pass below doesn't have to redo the walk. Same algorithm as DDJMeasurement.
+	uint8_t window = 0;
+	vector<size_t> num_table(256, 0);
+	vector<float> sum_table(256, 0);
+	vector<pair<size_t, uint8_t>> matches;
+	matches.reserve(capTie->size());
+
+	size_t tielen = capTie->size();
+	size_t samplen = samples.size();
+
+	size_t itie = 0;
+	size_t nbits = 0;
+	int64_t tfirst = GetOffsetScaled(capTie, 0);
+	for(size_t idata=0; idata < samplen; idata ++)
+	{
+		//Sample the next bit in the thresholded waveform
+		window = (window >> 1);
+		if(samples.m_samples[idata])
+			window |= 0x80;
+		nbits ++;
+
+		//need 8 in last_window, plus one more for the current bit
+		if(nbits < 9)
+			continue;
+
+		//If we're still before the first TIE sample, nothing to do
+		int64_t tstart = samples.m_offsets[idata];
+		if(tstart < tfirst)
+			continue;
+
+		//Advance TIE samples if needed
+		int64_t target = 0;
+		while( (target < tfirst) && (itie < tielen) )
+		{
+			target = GetOffsetScaled(capTie, itie);
+
+			if(target < tstart)
+				itie ++;
+		}
+		if(itie >= tielen)
+			break;
+
+		//If the TIE sample is after this bit, don't do anything.
+		//We need edges within this UI.
+		int64_t tend = tstart + samples.m_durations[idata];
+		if(target > tend)
+			continue;
+
+		//Save the info in the DDJ table
+		num_table[window] ++;
+		sum_table[window] += capTie->m_samples[itie];
+		matches.push_back(pair<size_t, uint8_t>(itie, window));
+	}
+
+	//Calculate DDJ
+	float ddjmin =  FLT_MAX;
+	float ddjmax = 0;
+	for(size_t i=0; i<256; i++)
+	{
+		if(num_table[i] != 0)
+		{
+			float jitter = sum_table[i] * 1.0 / num_table[i];
+			m_table[i] = jitter;
+			ddjmin = min(ddjmin, jitter);
+			ddjmax = max(ddjmax, jitter);
+		}
+		else
+			m_table[i] = 0;
+	}
+	m_streams[2].m_value = ddjmax - ddjmin;
+
+	//Pass 3: subtract the averaged DDJ from TIE to get the uncorrelated jitter (Rj + BUj),
+	//replaying the saved matches instead of re-walking the capture
+	auto capUj = SetupSparseOutputWaveform(capTie, 1, 0, 0);
+	capUj->PrepareForCpuAccess();
+	for(auto& m : matches)
+		capUj->m_samples[m.first] = capTie->m_samples[m.first] - m_table[m.second];
+	capUj->MarkModifiedFromCpu();
+}
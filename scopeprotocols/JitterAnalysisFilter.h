@@ -0,0 +1,74 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of JitterAnalysisFilter
+ */
+#ifndef JitterAnalysisFilter_h
+#define JitterAnalysisFilter_h
+
+/**
+	@brief Fused jitter decomposition engine
+
+	Computes TIE, the DDJ history table, and the uncorrelated (Rj + BUj) jitter stream in a single filter, sharing
+	the edge list, the thresholded data sampling, and the TIE-to-bit alignment between all three outputs. Running
+	the equivalent TIEMeasurement -> DDJMeasurement -> RjBUjFilter graph repeats the sampling and alignment passes
+	once per consumer; here each pass over the capture happens exactly once.
+
+	All output streams are time domain, so the jitter spectrum (frequency domain x axis) cannot live on this
+	channel; feed a JitterSpectrumFilter from the TIE stream to complete the decomposition. That adds no redundant
+	work since the spectrum consumes the TIE waveform directly.
+ */
+class JitterAnalysisFilter : public Filter
+{
+public:
+	JitterAnalysisFilter(const std::string& color);
+
+	virtual void Refresh() override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	PROTOCOL_DECODER_INITPROC(JitterAnalysisFilter)
+
+	float* GetDDJTable()
+	{ return m_table; }
+
+protected:
+	///@brief Average jitter indexed by the last 8 bits of data history
+	float m_table[256];
+
+	std::string m_threshname;
+	std::string m_skipname;
+};
+
+#endif
@@ -42,6 +42,10 @@ public:
 
 	virtual void Refresh() override;
 
+	//Injected jitter is randomized per run, so identical inputs still produce new output
+	virtual bool ShouldMemoize() override
+	{ return false; }
+
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
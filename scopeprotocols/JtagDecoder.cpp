@@ -152,6 +152,154 @@ void JtagDecoder::Refresh()
 	cap->m_startFemtoseconds = tck->m_startFemtoseconds;
 	cap->PrepareForCpuAccess();
 
+	size_t len = dtms.size();
+	len = min(len, dtdi.size());
+	len = min(len, dtdo.size());
+
+	//The TAP state machine is serial, but five consecutive clocks with TMS high force it into Test-Logic-Reset
+	//from any state. For long captures, find those re-sync points up front, decode the stretches between them in
+	//parallel, then stitch the outputs (and the IR value carried across the seams) back together in order.
+	const size_t MIN_BLOCK = 1000000;
+	vector<size_t> starts;
+	starts.push_back(0);
+	if(len >= 2*MIN_BLOCK)
+	{
+		vector<size_t> resets;
+		FindResetPoints(dtms, len, resets);
+
+		//Keep blocks comfortably large so per-block overhead stays negligible
+		for(auto r : resets)
+		{
+			if(r >= starts.back() + MIN_BLOCK)
+				starts.push_back(r);
+		}
+	}
+
+	//Decode each block independently (every block but the first begins in Test-Logic-Reset)
+	size_t nblocks = starts.size();
+	vector<vector<int64_t>> offsets(nblocks);
+	vector<vector<int64_t>> durations(nblocks);
+	vector<vector<JtagSymbol>> symbols(nblocks);
+	vector<vector<Packet*>> packets(nblocks);
+	vector<size_t> nUnknownIrPackets(nblocks, 0);
+	vector<string> finalIr(nblocks);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(size_t b=0; b<nblocks; b++)
+	{
+		size_t iend = (b+1 < nblocks) ? starts[b+1] : len;
+		DecodeRange(
+			dtdi, dtdo, dtms, starts[b], iend, (b == 0), (b+1 < nblocks),
+			offsets[b], durations[b], symbols[b], packets[b], nUnknownIrPackets[b], finalIr[b]);
+	}
+
+	//Stitch the per-block output together in order
+	string runningIr = "??";
+	for(size_t b=0; b<nblocks; b++)
+	{
+		//Packets decoded before a block saw its first IR shift get the IR value carried over from earlier blocks
+		for(size_t i=0; i<nUnknownIrPackets[b]; i++)
+			packets[b][i]->m_headers["IR"] = runningIr;
+		for(auto p : packets[b])
+			m_packets.push_back(p);
+		if(!finalIr[b].empty())
+			runningIr = finalIr[b];
+
+		for(size_t i=0; i<offsets[b].size(); i++)
+		{
+			//Both sides of a block seam are in Test-Logic-Reset: merge the flushed tail of the previous block
+			//into the first symbol of this one instead of emitting two back-to-back TLR samples
+			size_t n = cap->m_samples.size();
+			if( (i == 0) && (n > 0) &&
+				(cap->m_samples[n-1].m_state == JtagSymbol::TEST_LOGIC_RESET) &&
+				(symbols[b][i].m_state == JtagSymbol::TEST_LOGIC_RESET) )
+			{
+				cap->m_durations[n-1] += durations[b][i];
+				continue;
+			}
+
+			cap->m_offsets.push_back(offsets[b][i]);
+			cap->m_durations.push_back(durations[b][i]);
+			cap->m_samples.push_back(symbols[b][i]);
+		}
+	}
+
+	//LogDebug("%zu packets\n", m_packets.size());
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Finds all of the points where the TAP is forced into Test-Logic-Reset by five consecutive clocks with TMS high
+
+	Reported indices are the first clock cycle *after* the five TMS=1 cycles, i.e. the first cycle decoded in TLR.
+ */
+void JtagDecoder::FindResetPoints(SparseDigitalWaveform& dtms, size_t len, vector<size_t>& starts)
+{
+	//Five consecutive clocks with TMS high reach TLR from any TAP state
+	const size_t TMS_RESET_CLOCKS = 5;
+
+	const size_t CHUNK = 1024 * 1024;
+	size_t nchunks = (len + CHUNK - 1) / CHUNK;
+	vector<vector<size_t>> found(nchunks);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(size_t c=0; c<nchunks; c++)
+	{
+		size_t cstart = c * CHUNK;
+		size_t cend = min(cstart + CHUNK, len);
+		for(size_t i=cstart; i<cend; i++)
+		{
+			//Only consider the first cycle of a maximal run of TMS=1
+			//(runs may extend past the end of our chunk, which is fine: the input is shared and read only)
+			if(!dtms.m_samples[i])
+				continue;
+			if( (i > 0) && dtms.m_samples[i-1])
+				continue;
+
+			size_t run = 0;
+			while( ((i + run) < len) && (run < TMS_RESET_CLOCKS) && dtms.m_samples[i + run])
+				run++;
+			if( (run >= TMS_RESET_CLOCKS) && ((i + TMS_RESET_CLOCKS) < len) )
+				found[c].push_back(i + TMS_RESET_CLOCKS);
+		}
+	}
+
+	for(size_t c=0; c<nchunks; c++)
+	{
+		for(auto f : found[c])
+			starts.push_back(f);
+	}
+}
+
+/**
+	@brief Runs the TAP state machine over part of the sampled bitstream, appending decoded symbols and packets to the supplied buffers
+
+	A range must start either at the beginning of the capture (where we assume Run-Test-Idle) or immediately after
+	five TMS=1 clocks (where the TAP is in Test-Logic-Reset regardless of what preceded them). The IR value is only
+	known within a block once it has seen an IR shift; nUnknownIrPackets returns how many packets at the start of
+	the block were emitted before that point, so the caller can patch in the value carried over from the previous
+	block. finalIr returns the last IR value shifted within the block, or the empty string if there was none.
+
+	If flushAtEnd is set, the state in progress when the block ends is emitted as a final symbol so the caller can
+	stitch it to the next block's output.
+ */
+void JtagDecoder::DecodeRange(
+	SparseDigitalWaveform& dtdi,
+	SparseDigitalWaveform& dtdo,
+	SparseDigitalWaveform& dtms,
+	size_t ibegin,
+	size_t iend,
+	bool firstBlock,
+	bool flushAtEnd,
+	vector<int64_t>& offsets,
+	vector<int64_t>& durations,
+	vector<JtagSymbol>& symbols,
+	vector<Packet*>& packets,
+	size_t& nUnknownIrPackets,
+	string& finalIr)
+{
 	//Table for state transitions
 	JtagSymbol::JtagState state_if_tms_high[] =
 	{
@@ -206,20 +354,18 @@ void JtagDecoder::Refresh()
 	};
 
 	//Main decode loop
-	//Assume we're in RTI before we get any TMS edges
-	JtagSymbol::JtagState state = JtagSymbol::RUN_TEST_IDLE;
-	size_t istart = 0;
-	size_t packstart = 0;
+	//The first block assumes we're in RTI before we get any TMS edges; every other block starts in TLR
+	JtagSymbol::JtagState state = firstBlock ? JtagSymbol::RUN_TEST_IDLE : JtagSymbol::TEST_LOGIC_RESET;
+	size_t istart = ibegin;
+	size_t packstart = ibegin;
 	size_t nbits = 0;
 	uint8_t idata = 0;
 	uint8_t odata = 0;
 	vector<uint8_t> ibytes;
 	vector<uint8_t> obytes;
 	string irval = "??";
-	size_t len = dtms.size();
-	len = min(len, dtdi.size());
-	len = min(len, dtdo.size());
-	for(size_t i=0; i<len; i++)
+	bool irKnown = false;
+	for(size_t i=ibegin; i<iend; i++)
 	{
 		//Update the state
 		JtagSymbol::JtagState next_state;
@@ -242,9 +388,9 @@ void JtagDecoder::Refresh()
 		if(next_state != state)
 		{
 			//Add a sample for the previous state
-			cap->m_offsets.push_back(dtms.m_offsets[istart]);
-			cap->m_durations.push_back(dtms.m_offsets[i] - dtms.m_offsets[istart]);
-			cap->m_samples.push_back(JtagSymbol(state, idata, odata, nbits));
+			offsets.push_back(dtms.m_offsets[istart]);
+			durations.push_back(dtms.m_offsets[i] - dtms.m_offsets[istart]);
+			symbols.push_back(JtagSymbol(state, idata, odata, nbits));
 
 			//Add packets for the IR/DR change
 			char tmp[128];
@@ -268,7 +414,7 @@ void JtagDecoder::Refresh()
 				pack->m_headers["Bits"] = tmp;
 				pack->m_data = ibytes;
 				pack->m_len = dtms.m_offsets[i] - pack->m_offset;
-				m_packets.push_back(pack);
+				packets.push_back(pack);
 
 				//Read side
 				pack = new Packet;
@@ -282,7 +428,7 @@ void JtagDecoder::Refresh()
 				pack->m_headers["Bits"] = tmp;
 				pack->m_data = obytes;
 				pack->m_len = dtms.m_offsets[i] - pack->m_offset;
-				m_packets.push_back(pack);
+				packets.push_back(pack);
 
 				//Update current IR
 				if(state == JtagSymbol::SHIFT_IR)
@@ -293,6 +439,15 @@ void JtagDecoder::Refresh()
 						snprintf(tmp, sizeof(tmp), "%02x ", b);
 						irval += tmp;
 					}
+
+					//Everything up to and including this shift was decoded with the placeholder IR value
+					//(for the first block that's genuinely unknown, for later blocks the caller patches in
+					//the value carried over from the previous block)
+					if(!irKnown)
+					{
+						irKnown = true;
+						nUnknownIrPackets = packets.size();
+					}
 				}
 
 				ibytes.clear();
@@ -314,9 +469,9 @@ void JtagDecoder::Refresh()
 		{
 			if(nbits == 8)
 			{
-				cap->m_offsets.push_back(dtms.m_offsets[istart]);
-				cap->m_durations.push_back(dtms.m_offsets[i] - dtms.m_offsets[istart]);
-				cap->m_samples.push_back(JtagSymbol(state, idata, odata, 8));
+				offsets.push_back(dtms.m_offsets[istart]);
+				durations.push_back(dtms.m_offsets[i] - dtms.m_offsets[istart]);
+				symbols.push_back(JtagSymbol(state, idata, odata, 8));
 
 				ibytes.push_back(idata);
 				obytes.push_back(odata);
@@ -327,10 +482,20 @@ void JtagDecoder::Refresh()
 		}
 	}
 
-	//LogDebug("%zu packets\n", m_packets.size());
+	//Flush the state in progress when the block ends so the stitching pass can merge it with the next block's
+	//output. At an interior block boundary we're always in TLR (five TMS=1 clocks immediately precede it),
+	//which is exactly where the next block starts decoding.
+	if(flushAtEnd && (iend > ibegin))
+	{
+		offsets.push_back(dtms.m_offsets[istart]);
+		durations.push_back(dtms.m_offsets[iend] - dtms.m_offsets[istart]);
+		symbols.push_back(JtagSymbol(state, idata, odata, nbits));
+	}
 
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
+	if(!irKnown)
+		nUnknownIrPackets = packets.size();
+	else
+		finalIr = irval;
 }
 
 std::string JtagWaveform::GetColor(size_t i)
@@ -118,6 +118,22 @@ public:
 	PROTOCOL_DECODER_INITPROC(JtagDecoder)
 
 protected:
+	static void FindResetPoints(SparseDigitalWaveform& dtms, size_t len, std::vector<size_t>& starts);
+
+	void DecodeRange(
+		SparseDigitalWaveform& dtdi,
+		SparseDigitalWaveform& dtdo,
+		SparseDigitalWaveform& dtms,
+		size_t ibegin,
+		size_t iend,
+		bool firstBlock,
+		bool flushAtEnd,
+		std::vector<int64_t>& offsets,
+		std::vector<int64_t>& durations,
+		std::vector<JtagSymbol>& symbols,
+		std::vector<Packet*>& packets,
+		size_t& nUnknownIrPackets,
+		std::string& finalIr);
 };
 
 #endif
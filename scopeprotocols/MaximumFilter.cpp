@@ -52,7 +52,7 @@ MaximumFilter::~MaximumFilter()
 {
 }
 
-void MaximumFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
+void MaximumFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	auto din = GetInput(0);
 	if(!din)
@@ -73,28 +73,19 @@ void MaximumFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 		m_streams[3].m_value ++;
 	}
 
-	//If input is a vector, process each sample
+	//If input is a vector, reduce it in a single fused pass (on the GPU if possible),
+	//shared with any sibling min/max/average filters watching the same input
 	else
 	{
 		auto data = din.GetData();
-		auto udata = dynamic_cast<UniformAnalogWaveform*>(data);
-		auto sdata = dynamic_cast<SparseAnalogWaveform*>(data);
-		float total = -FLT_MAX;
+		if(!data)
+			return;
 		size_t len = data->size();
 
-		if(udata)
-		{
-			for(auto sample : udata->m_samples)
-				total = max(total, sample);
-		}
-		else if(sdata)
-		{
-			for(auto sample : sdata->m_samples)
-				total = max(total, sample);
-		}
-
-		m_streams[0].m_value = total;
-		m_streams[1].m_value = max((double)total, m_streams[1].m_value);
+		auto stats = GetOrComputeReduction(data, m_statsEngine, cmdBuf, queue);
+
+		m_streams[0].m_value = stats.m_max;
+		m_streams[1].m_value = max((double)stats.m_max, m_streams[1].m_value);
 		m_streams[2].m_value += len;
 		m_streams[3].m_value ++;
 	}
@@ -102,7 +93,8 @@ void MaximumFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<Queu
 
 Filter::DataLocation MaximumFilter::GetInputLocation()
 {
-	return LOC_CPU;
+	//We can process the input wherever it currently is
+	return LOC_DONTCARE;
 }
 
 string MaximumFilter::GetProtocolName()
@@ -79,6 +79,97 @@ vector<string> MilStd1553Decoder::GetHeaders()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Thresholds the entire input capture in a single vectorizable pass
+
+	Output is +1 for a valid logic high, -1 for a valid logic low, and 0 for anything in between.
+	The comparisons are branch free so the compiler can vectorize the inner loop, rather than doing
+	two scalar compares per sample inside the decode state machine.
+ */
+void MilStd1553Decoder::ClassifyLineStates(
+	SparseAnalogWaveform* sdin,
+	UniformAnalogWaveform* udin,
+	float high,
+	float low,
+	vector<int8_t>& levels)
+{
+	auto& samples = sdin ? sdin->m_samples : udin->m_samples;
+	int64_t len = samples.size();
+	levels.resize(len);
+
+	const float* pin = samples.GetCpuPointer();
+	int8_t* pout = levels.data();
+
+	#pragma omp parallel for
+	for(int64_t i=0; i<len; i++)
+		pout[i] = (pin[i] > high) - (pin[i] < low);
+}
+
+/**
+	@brief Finds the samples where the thresholded line state can affect the decode state machine
+
+	Candidate events are valid samples whose polarity differs from the previous valid sample, plus the first
+	valid sample after a run of undefined levels. Between consecutive events the line is either undefined or
+	holding a constant valid level, so the only thing the state machine can act on is a pending timeout.
+ */
+void MilStd1553Decoder::FindCandidateEvents(const vector<int8_t>& levels, vector<size_t>& events)
+{
+	size_t len = levels.size();
+	int8_t lastValidLevel = 0;
+	bool lastWasValid = false;
+	for(size_t i=0; i<len; i++)
+	{
+		int8_t cur = levels[i];
+		if(cur == 0)
+		{
+			lastWasValid = false;
+			continue;
+		}
+
+		if(!lastWasValid || (cur != lastValidLevel) )
+			events.push_back(i);
+
+		lastValidLevel = cur;
+		lastWasValid = true;
+	}
+}
+
+/**
+	@brief Returns the index of the first sample at or after the given timestamp (in timebase ticks)
+
+	Used to jump the decoder directly to the point where a pending timeout can fire, rather than walking
+	every sample in between. Never returns less than i+1, so the caller always makes forward progress.
+ */
+size_t MilStd1553Decoder::FindTimeoutIndex(
+	SparseAnalogWaveform* sdin,
+	UniformAnalogWaveform* udin,
+	size_t i,
+	int64_t target)
+{
+	//Uniform waveforms have offset == index so no search needed
+	if(udin)
+	{
+		size_t len = udin->size();
+		if(target < (int64_t)(i+1))
+			return i + 1;
+		return min(len, (size_t)target);
+	}
+
+	//Sparse path: binary search the offsets
+	size_t len = sdin->size();
+	size_t lo = i + 1;
+	size_t hi = len;
+	while(lo < hi)
+	{
+		size_t mid = lo + (hi - lo)/2;
+		if(sdin->m_offsets[mid] < target)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 void MilStd1553Decoder::Refresh()
 {
 	ClearPackets();
@@ -147,6 +238,15 @@ void MilStd1553Decoder::Refresh()
 	int64_t data_len_samples	= data_len_fs / din->m_timescale;
 	int64_t ifg_len_samples		= ifg_len_fs / din->m_timescale;
 
+	//Threshold the whole capture up front, then find the candidate decode events.
+	//The state machine below only has to visit those (plus pending timeouts) instead of every sample,
+	//which is a huge win on long captures that are mostly bus idle time.
+	vector<int8_t> levels;
+	ClassifyLineStates(sdin, udin, high, low, levels);
+	vector<size_t> events;
+	FindCandidateEvents(levels, events);
+	size_t ievent = 0;
+
 	bool last_bit = false;
 	int64_t tbitstart = 0;
 	vector<int64_t> bitstarts;
@@ -161,19 +261,13 @@ void MilStd1553Decoder::Refresh()
 		int64_t timestamp = ::GetOffset(sdin, udin, i);
 		int64_t duration = timestamp - tbitstart;
 
-		//Determine the current line state
+		//Determine the current line state (from the precomputed threshold pass)
 		bool current_bit = last_bit;
-		bool valid = false;
-		if(GetValue(sdin, udin, i) > high)
-		{
+		bool valid = (levels[i] != 0);
+		if(levels[i] > 0)
 			current_bit = true;
-			valid = true;
-		}
-		else if(GetValue(sdin, udin, i) < low)
-		{
+		else if(levels[i] < 0)
 			current_bit = false;
-			valid = true;
-		}
 
 		//Words time out after the parity bit completes
 		bool word_valid = false;
@@ -677,6 +771,32 @@ void MilStd1553Decoder::Refresh()
 		}
 
 		last_bit = current_bit;
+
+		//Fast path: nothing can happen until the next candidate event, except a pending timeout.
+		//Jump directly to whichever comes first instead of walking every sample in between.
+		while( (ievent < events.size()) && (events[ievent] <= i) )
+			ievent ++;
+		size_t inext = (ievent < events.size()) ? events[ievent] : len;
+		if( (inext > (i+1)) && ((i+1) < len) )
+		{
+			size_t itimeout = len;
+
+			//Word timeout fires on any sample, valid or not
+			if(bitcount == 16)
+				itimeout = FindTimeoutIndex(sdin, udin, i, tbitstart + 2*data_len_samples);
+
+			//Turnaround only ends on a valid sample, so if the line is undefined only the next event matters
+			else if( (state == STATE_TURNAROUND) && (levels[i+1] != 0) )
+				itimeout = FindTimeoutIndex(sdin, udin, i, tbitstart + ifg_len_samples + 1);
+
+			//Idle acts on the next valid sample no matter what, so we can only skip undefined stretches
+			else if( (state == STATE_IDLE) && (levels[i+1] != 0) )
+				itimeout = i + 1;
+
+			size_t istop = min(inext, itimeout);
+			if(istop > (i+1))
+				i = istop - 1;	//loop increment brings us to the stop point
+		}
 	}
 
 	cap->MarkModifiedFromCpu();
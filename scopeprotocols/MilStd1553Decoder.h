@@ -114,6 +114,22 @@ public:
 	std::vector<std::string> GetHeaders() override;
 
 	PROTOCOL_DECODER_INITPROC(MilStd1553Decoder)
+
+protected:
+	static void ClassifyLineStates(
+		SparseAnalogWaveform* sdin,
+		UniformAnalogWaveform* udin,
+		float high,
+		float low,
+		std::vector<int8_t>& levels);
+
+	static void FindCandidateEvents(const std::vector<int8_t>& levels, std::vector<size_t>& events);
+
+	static size_t FindTimeoutIndex(
+		SparseAnalogWaveform* sdin,
+		UniformAnalogWaveform* udin,
+		size_t i,
+		int64_t target);
 };
 
 #endif
@@ -51,6 +51,10 @@ public:
 	virtual void ClearSweeps() override;
 
 	PROTOCOL_DECODER_INITPROC(MinimumFilter)
+
+protected:
+	///@brief GPU reduction engine for vector inputs
+	StatisticsEngine m_statsEngine;
 };
 
 #endif
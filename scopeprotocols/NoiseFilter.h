@@ -44,6 +44,10 @@ public:
 
 	virtual void Refresh() override;
 
+	//Each run synthesizes fresh random noise, so the output is never a pure function of the input
+	virtual bool ShouldMemoize() override
+	{ return false; }
+
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
@@ -79,7 +79,6 @@ void OvershootMeasurement::Refresh()
 	//Get the input data
 	auto din = GetInputWaveform(0);
 	din->PrepareForCpuAccess();
-	size_t len = din->size();
 
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
@@ -93,6 +92,28 @@ void OvershootMeasurement::Refresh()
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0);
 	cap->PrepareForCpuAccess();
 
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sdin)
+		InnerLoop(sdin, cap, midpoint, top);
+	else
+		InnerLoop(udin, cap, midpoint, top);
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Per-cycle peak search loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and value helpers resolve at compile
+	time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void OvershootMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float midpoint, float top)
+{
+	size_t len = din->size();
+
 	int64_t		tmax = 0;
 	float		vmax = 0;
 
@@ -100,7 +121,7 @@ void OvershootMeasurement::Refresh()
 	for(size_t i=0; i < len; i++)
 	{
 		//If we're below the midpoint, reset everything and add a new sample
-		float v = GetValue(sdin, udin, i);
+		float v = din->m_samples[i];
 		if(v < midpoint)
 		{
 			//Add a sample for the current value (if any)
@@ -127,12 +148,9 @@ void OvershootMeasurement::Refresh()
 		{
 			if(v > vmax)
 			{
-				tmax = ::GetOffset(sdin, udin, i);
+				tmax = ::GetOffset(din, i);
 				vmax = v;
 			}
 		}
 	}
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
 }
@@ -47,6 +47,9 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
 	PROTOCOL_DECODER_INITPROC(OvershootMeasurement)
+
+protected:
+	template<class W> void InnerLoop(W* din, SparseAnalogWaveform* cap, float midpoint, float top);
 };
 
 #endif
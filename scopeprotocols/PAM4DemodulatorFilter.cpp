@@ -40,6 +40,7 @@ PAM4DemodulatorFilter::PAM4DemodulatorFilter(const string& color)
 	, m_lowerThreshName("Lower Threshold")
 	, m_midThreshName("Middle Threshold")
 	, m_upperThreshName("Upper Threshold")
+	, m_computePipeline("shaders/PAM4Slice.spv", 2, sizeof(PAM4SliceArgs))
 {
 	AddDigitalStream("data");
 	AddDigitalStream("clk");
@@ -83,7 +84,7 @@ string PAM4DemodulatorFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void PAM4DemodulatorFilter::Refresh()
+void PAM4DemodulatorFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK())
 	{
@@ -116,7 +117,6 @@ void PAM4DemodulatorFilter::Refresh()
 	dcap->m_startTimestamp = din->m_startTimestamp;
 	dcap->m_startFemtoseconds = din->m_startFemtoseconds;
 	dcap->m_triggerPhase = 0;
-	dcap->PrepareForCpuAccess();
 	SetData(dcap, 0);
 
 	auto ccap = new SparseDigitalWaveform;
@@ -127,9 +127,15 @@ void PAM4DemodulatorFilter::Refresh()
 	ccap->PrepareForCpuAccess();
 	SetData(ccap, 1);
 
-	//Decode the input data, one symbol (two output bits) at a time
+	//Each input sample is one symbol, which decodes to two output bits
 	dcap->Resize(len*2);
 	ccap->Resize(len*2);
+
+	//Timestamps and the recovered clock are cheap bookkeeping, filled on the CPU.
+	//Each entry depends only on samples i and i-1 so the loop parallelizes cleanly.
+	dcap->m_offsets.PrepareForCpuAccess();
+	dcap->m_durations.PrepareForCpuAccess();
+	#pragma omp parallel for
 	for(size_t i=0; i<len; i++)
 	{
 		//Duration and offset get split in half
@@ -144,7 +150,13 @@ void PAM4DemodulatorFilter::Refresh()
 
 		ccap->m_offsets[i*2] = off + qdur;
 		if(i > 0)
-			ccap->m_durations[i*2] = ccap->m_offsets[i*2] - (ccap->m_offsets[i*2 - 1] + ccap->m_durations[i*2 - 1]);
+		{
+			//Stretch the clock-low period back to the end of the previous symbol's clock-high period
+			int64_t prevoff = samples.m_offsets[i-1];
+			int64_t prevhalf = samples.m_durations[i-1] / 2;
+			int64_t prevq = prevhalf / 2;
+			ccap->m_durations[i*2] = ccap->m_offsets[i*2] - (prevoff + prevhalf + prevq + prevhalf);
+		}
 		else
 			ccap->m_durations[i*2] = halfdur;
 
@@ -158,32 +170,51 @@ void PAM4DemodulatorFilter::Refresh()
 		//Fill clock
 		ccap->m_samples[i*2] = 0;
 		ccap->m_samples[i*2 + 1] = 1;
+	}
+	dcap->m_offsets.MarkModifiedFromCpu();
+	dcap->m_durations.MarkModifiedFromCpu();
+	ccap->MarkModifiedFromCpu();
 
-		//Fill data bits
-		//(note gray coding, levels are 00, 01, 11, 10)
-		float v = samples.m_samples[i];
-		if(v < thresholds[0])
-		{
-			dcap->m_samples[i*2] = 0;
-			dcap->m_samples[i*2 + 1] = 0;
-		}
-		else if(v < thresholds[1])
-		{
-			dcap->m_samples[i*2] = 0;
-			dcap->m_samples[i*2 + 1] = 1;
-		}
-		else if(v < thresholds[2])
-		{
-			dcap->m_samples[i*2] = 1;
-			dcap->m_samples[i*2 + 1] = 1;
-		}
-		else
+	//Slice the symbols and gray decode on the GPU if we can, staying GPU resident for downstream filters
+	if(g_gpuFilterEnabled)
+	{
+		//Make sure the word-granular shader can't write past the end of the buffer
+		size_t roundedlen = (len*2 + 3) & ~3ull;
+		if(roundedlen > dcap->m_samples.capacity())
+			dcap->m_samples.reserve(roundedlen);
+
+		PAM4SliceArgs args;
+		args.nsymbols = len;
+		args.vlow = thresholds[0];
+		args.vmid = thresholds[1];
+		args.vhigh = thresholds[2];
+
+		cmdBuf.begin({});
+
+		m_computePipeline.BindBufferNonblocking(0, dcap->m_samples, cmdBuf, true);
+		m_computePipeline.BindBufferNonblocking(1, samples.m_samples, cmdBuf);
+
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(roundedlen / 4, 64));
+
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+		dcap->m_samples.MarkModifiedFromGpu();
+	}
+
+	//Software fallback
+	else
+	{
+		dcap->m_samples.PrepareForCpuAccess();
+
+		//Slice and gray decode (levels are 00, 01, 11, 10 from lowest to highest)
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
 		{
-			dcap->m_samples[i*2] = 1;
-			dcap->m_samples[i*2 + 1] = 0;
+			float v = samples.m_samples[i];
+			dcap->m_samples[i*2] = (v >= thresholds[1]);
+			dcap->m_samples[i*2 + 1] = (v >= thresholds[0]) && (v < thresholds[2]);
 		}
-	}
 
-	ccap->MarkModifiedFromCpu();
-	dcap->MarkModifiedFromCpu();
+		dcap->m_samples.MarkModifiedFromCpu();
+	}
 }
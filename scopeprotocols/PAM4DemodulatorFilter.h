@@ -35,12 +35,28 @@
 #ifndef PAM4DemodulatorFilter_h
 #define PAM4DemodulatorFilter_h
 
+///@brief Push constants for the PAM4Slice compute shader
+struct PAM4SliceArgs
+{
+	///@brief Number of input symbols
+	uint32_t nsymbols;
+
+	///@brief Threshold between the 00 and 01 levels
+	float vlow;
+
+	///@brief Threshold between the 01 and 11 levels
+	float vmid;
+
+	///@brief Threshold between the 11 and 10 levels
+	float vhigh;
+};
+
 class PAM4DemodulatorFilter : public Filter
 {
 public:
 	PAM4DemodulatorFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -52,6 +68,9 @@ protected:
 	std::string m_lowerThreshName;
 	std::string m_midThreshName;
 	std::string m_upperThreshName;
+
+	///@brief Compute pipeline for the symbol slicer
+	ComputePipeline m_computePipeline;
 };
 
 #endif
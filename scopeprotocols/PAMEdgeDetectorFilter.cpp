@@ -29,6 +29,9 @@
 
 #include "../scopehal/scopehal.h"
 #include "PAMEdgeDetectorFilter.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -99,6 +102,14 @@ void PAMEdgeDetectorFilter::Refresh(
 	int64_t ui = round(FS_PER_SECOND / m_parameters[m_baudname].GetIntVal());
 	size_t order = m_parameters[m_order].GetIntVal();
 
+	//Sample classification packs threshold counts into nibbles, so cap the modulation order
+	if(order > 16)
+	{
+		LogError("PAM orders above 16 are not supported\n");
+		SetData(nullptr, 0);
+		return;
+	}
+
 	//Extract parameter values for input thresholds
 	vector<float> levels;
 	for(size_t i=0; i<order; i++)
@@ -135,6 +146,9 @@ void PAMEdgeDetectorFilter::Refresh(
 
 	//Find *all* level crossings
 	//This will double-count some edges (e.g. a +1 to -1 edge will show up as +1 to 0 and 0 to -1)
+	//Rather than a branchy per-sample scan over every threshold, classify each sample into a byte packing
+	//two counts (thresholds it is strictly above in the low nibble, at-or-above in the high nibble) with a
+	//SIMD-friendly compare-and-count kernel, then look for changes in classification between adjacent samples.
 	struct edge_t
 	{
 		size_t index;
@@ -142,40 +156,64 @@ void PAMEdgeDetectorFilter::Refresh(
 		bool rising;
 	};
 	vector<edge_t> levelCrossings;
-	for(size_t i=1; i<len-1; i++)
+	const float* samples = din->m_samples.GetCpuPointer();
+
+	//Classify in bounded chunks so huge captures don't need a second gigabyte-scale scratch buffer
+	const size_t chunkSamples = 1024 * 1024;
+	vector<uint8_t> classes(min(len, chunkSamples));
+	uint8_t pc = 0;
+	for(size_t base = 0; base < len; base += chunkSamples)
 	{
-		//Check against each threshold for both rising and falling edges
-		float prev = din->m_samples[i-1];
-		float cur = din->m_samples[i];
+		size_t n = min(chunkSamples, len - base);
 
-		//Prepare to make a new edge
-		edge_t edge;
-		edge.index = i;
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ClassifySamplesAVX2(samples + base, n, sthresholds, &classes[0]);
+		else
+		#endif
+			ClassifySamplesGeneric(samples + base, n, sthresholds, &classes[0]);
 
-		for(size_t j=0; j<sthresholds.size(); j++)
+		//Scan for classification changes (starting at sample 1 and stopping before the last sample,
+		//matching the bounds of the original per-sample threshold scan)
+		size_t jstart = 0;
+		if(base == 0)
 		{
-			float t = sthresholds[j];
-
-			//Check for rising edge
-			if( (prev <= t) && (cur > t) )
-			{
-				edge.rising = true;
-				edge.value = j+1;
-				levelCrossings.push_back(edge);
-				break;
-			}
-
-			//Check for falling edge
-			else if( (prev >= t) && (cur < t) )
+			pc = classes[0];
+			jstart = 1;
+		}
+		size_t jend = min(n, len - 1 - base);
+		for(size_t j=jstart; j<jend; j++)
+		{
+			uint8_t cc = classes[j];
+			if(cc != pc)
 			{
-				edge.rising = false;
-				edge.value = j;
-				levelCrossings.push_back(edge);
-				break;
+				edge_t edge;
+				edge.index = base + j;
+
+				//Rising edge: now strictly above a threshold we were at or below.
+				//The lowest such threshold is the one the original (prev <= t) && (cur > t) scan hit first.
+				if( (cc & 0xf) > (pc & 0xf) )
+				{
+					edge.rising = true;
+					edge.value = (pc & 0xf) + 1;
+					levelCrossings.push_back(edge);
+				}
+
+				//Falling edge: now strictly below a threshold we were at or above.
+				//The lowest such threshold is the one the original (prev >= t) && (cur < t) scan hit first.
+				else if( (cc >> 4) < (pc >> 4) )
+				{
+					edge.rising = false;
+					edge.value = cc >> 4;
+					levelCrossings.push_back(edge);
+				}
+
+				//else the classification changed without crossing a threshold
+				//(sample landed exactly on one): not a level crossing
 			}
-
-			//else not a level crossing
+			pc = cc;
 		}
+		pc = classes[n-1];
 	}
 	LogTrace("First pass: Found %zu level crossings\n", levelCrossings.size());
 
@@ -263,6 +301,85 @@ void PAMEdgeDetectorFilter::Refresh(
 	cap->MarkModifiedFromCpu();
 }
 
+/**
+	@brief Classifies samples against the symbol decision thresholds
+
+	Writes one byte per sample: the number of thresholds the sample is strictly above in the low nibble,
+	and the number it is at or above in the high nibble.
+ */
+void PAMEdgeDetectorFilter::ClassifySamplesGeneric(
+	const float* samples,
+	size_t len,
+	const vector<float>& thresholds,
+	uint8_t* classes)
+{
+	size_t nthresh = thresholds.size();
+	for(size_t i=0; i<len; i++)
+	{
+		float v = samples[i];
+		uint8_t cgt = 0;
+		uint8_t cge = 0;
+		for(size_t j=0; j<nthresh; j++)
+		{
+			if(v > thresholds[j])
+				cgt ++;
+			if(v >= thresholds[j])
+				cge ++;
+		}
+		classes[i] = cgt | (cge << 4);
+	}
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 version of ClassifySamplesGeneric, classifying eight samples per iteration
+ */
+__attribute__((target("avx2")))
+void PAMEdgeDetectorFilter::ClassifySamplesAVX2(
+	const float* samples,
+	size_t len,
+	const vector<float>& thresholds,
+	uint8_t* classes)
+{
+	size_t nthresh = thresholds.size();
+	size_t end = len - (len % 8);
+
+	//Broadcast the thresholds once outside the hot loop (nibble packing caps us at 15)
+	__m256 tv[15];
+	for(size_t j=0; j<nthresh; j++)
+		tv[j] = _mm256_set1_ps(thresholds[j]);
+
+	//Shuffle masks for squashing the low byte of each 32-bit lane down to 8 packed bytes
+	const __m256i bytemask = _mm256_setr_epi8(
+		0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m256i dwordmask = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(samples + i);
+
+		//Count thresholds we're above (the compare masks are all-ones when true, so subtract to count up)
+		__m256i cgt = _mm256_setzero_si256();
+		__m256i cge = _mm256_setzero_si256();
+		for(size_t j=0; j<nthresh; j++)
+		{
+			cgt = _mm256_sub_epi32(cgt, _mm256_castps_si256(_mm256_cmp_ps(v, tv[j], _CMP_GT_OQ)));
+			cge = _mm256_sub_epi32(cge, _mm256_castps_si256(_mm256_cmp_ps(v, tv[j], _CMP_GE_OQ)));
+		}
+
+		//Pack the two counts into one byte per sample and store
+		__m256i packed = _mm256_or_si256(cgt, _mm256_slli_epi32(cge, 4));
+		packed = _mm256_shuffle_epi8(packed, bytemask);
+		packed = _mm256_permutevar8x32_epi32(packed, dwordmask);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(classes + i), _mm256_castsi256_si128(packed));
+	}
+
+	//Do last few samples
+	ClassifySamplesGeneric(samples + end, len - end, thresholds, classes + end);
+}
+#endif
+
 vector<string> PAMEdgeDetectorFilter::EnumActions()
 {
 	vector<string> ret;
@@ -288,8 +405,10 @@ void PAMEdgeDetectorFilter::AutoLevel(UniformAnalogWaveform* din)
 {
 	size_t order = m_parameters[m_order].GetIntVal();
 
+	//Use the min/max pyramid when available (O(log n)), falling back to a full scan
 	float vmin, vmax;
-	GetMinMaxVoltage(din, vmin, vmax);
+	if(!din->GetEnvelope(0, din->size(), vmin, vmax))
+		GetMinMaxVoltage(din, vmin, vmax);
 	Unit yunit(Unit::UNIT_VOLTS);
 	LogTrace("Bounds are %s to %s\n", yunit.PrettyPrint(vmin).c_str(), yunit.PrettyPrint(vmax).c_str());
 
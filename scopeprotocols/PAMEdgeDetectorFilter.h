@@ -59,6 +59,20 @@ public:
 protected:
 	void AutoLevel(UniformAnalogWaveform* din);
 
+	void ClassifySamplesGeneric(
+		const float* samples,
+		size_t len,
+		const std::vector<float>& thresholds,
+		uint8_t* classes);
+
+#ifdef __x86_64__
+	void ClassifySamplesAVX2(
+		const float* samples,
+		size_t len,
+		const std::vector<float>& thresholds,
+		uint8_t* classes);
+#endif
+
 	std::string m_order;
 	std::string m_baudname;
 };
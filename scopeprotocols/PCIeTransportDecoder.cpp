@@ -187,7 +187,7 @@ void PCIeTransportDecoder::Refresh()
 				if(sym.m_type == PCIeDataLinkSymbol::TYPE_TLP_SEQUENCE)
 				{
 					//Create the packet
-					pack = new Packet;
+					pack = AllocatePacket();
 					m_packets.push_back(pack);
 					pack->m_offset = off * cap->m_timescale;
 					pack->m_len = 0;
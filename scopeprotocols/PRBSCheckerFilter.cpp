@@ -30,9 +30,105 @@
 #include "../scopehal/scopehal.h"
 #include "PRBSCheckerFilter.h"
 #include "PRBSGeneratorFilter.h"
+#include <omp.h>
 
 using namespace std;
 
+///@brief Minimum number of data bits before Refresh() switches to the block-parallel checker
+static const size_t PRBS_PARALLEL_THRESHOLD = 1024 * 1024;
+
+/**
+	@brief Advances a PRBS LFSR by an arbitrary number of steps in O(log n) time
+
+	The LFSR state after N steps is a linear function (over GF(2)) of the current state, so we raise the
+	single-step transition matrix to the Nth power by square-and-multiply and apply it once. This lets each
+	block of a parallel check seed its LFSR with the exact state the serial checker would have reached,
+	without replaying all the preceding bits.
+
+	Matrices are bit-packed: row r holds the mask of input state bits XORed together to form output bit r.
+ */
+static void LeapfrogPRBS(uint32_t& state, PRBSGeneratorFilter::Polynomials poly, uint64_t count)
+{
+	size_t statesize = poly;
+
+	//Second feedback tap for each polynomial (the first is always the MSB of the state, see RunPRBS)
+	size_t tap;
+	switch(poly)
+	{
+		case PRBSGeneratorFilter::POLY_PRBS7:
+			tap = 5;
+			break;
+
+		case PRBSGeneratorFilter::POLY_PRBS9:
+			tap = 4;
+			break;
+
+		case PRBSGeneratorFilter::POLY_PRBS11:
+			tap = 8;
+			break;
+
+		case PRBSGeneratorFilter::POLY_PRBS15:
+			tap = 13;
+			break;
+
+		case PRBSGeneratorFilter::POLY_PRBS23:
+			tap = 17;
+			break;
+
+		case PRBSGeneratorFilter::POLY_PRBS31:
+		default:
+			tap = 27;
+			break;
+	}
+
+	//out[r] = XOR of b's rows selected by the bits of a's row r (i.e. apply b, then a)
+	auto matmul = [statesize](const uint32_t* a, const uint32_t* b, uint32_t* out)
+	{
+		for(size_t r=0; r<statesize; r++)
+		{
+			uint32_t m = 0;
+			uint32_t bits = a[r];
+			while(bits)
+			{
+				m ^= b[__builtin_ctz(bits)];
+				bits &= bits - 1;
+			}
+			out[r] = m;
+		}
+	};
+
+	//Single-step transition matrix: new bit 0 is the feedback XOR, everything else shifts up
+	uint32_t base[32];
+	base[0] = (1u << (statesize-1)) | (1u << tap);
+	for(size_t r=1; r<statesize; r++)
+		base[r] = 1u << (r-1);
+
+	//Identity accumulator
+	uint32_t acc[32];
+	for(size_t r=0; r<statesize; r++)
+		acc[r] = 1u << r;
+
+	//Square-and-multiply
+	uint32_t tmp[32];
+	while(count)
+	{
+		if(count & 1)
+		{
+			matmul(base, acc, tmp);
+			memcpy(acc, tmp, statesize * sizeof(uint32_t));
+		}
+		matmul(base, base, tmp);
+		memcpy(base, tmp, statesize * sizeof(uint32_t));
+		count >>= 1;
+	}
+
+	//Apply the composite matrix to the state
+	uint32_t out = 0;
+	for(size_t r=0; r<statesize; r++)
+		out |= static_cast<uint32_t>(__builtin_popcount(acc[r] & state) & 1) << r;
+	state = out;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -167,13 +263,43 @@ void PRBSCheckerFilter::Refresh()
 	}
 
 	//Start checking actual data bits
-	for(size_t i=statesize; i<len; i++)
+	size_t nbits = len - statesize;
+	if(nbits >= PRBS_PARALLEL_THRESHOLD)
 	{
-		dout->m_offsets[i] = data.m_offsets[i];
-		dout->m_durations[i] = data.m_durations[i];
-
-		bool value = PRBSGeneratorFilter::RunPRBS(prbs, poly);
-		dout->m_samples[i] = (value != data.m_samples[i]);
+		//Block-parallel check: leapfrog-seed each block with the exact LFSR state the serial checker
+		//would have reached at its first bit, then run the blocks independently
+		size_t nblocks = omp_get_max_threads();
+		size_t bitsPerBlock = (nbits + nblocks - 1) / nblocks;
+
+		#pragma omp parallel for
+		for(size_t b=0; b<nblocks; b++)
+		{
+			size_t istart = statesize + b*bitsPerBlock;
+			size_t iend = min(istart + bitsPerBlock, len);
+
+			uint32_t state = prbs;
+			LeapfrogPRBS(state, poly, b*bitsPerBlock);
+
+			for(size_t i=istart; i<iend; i++)
+			{
+				dout->m_offsets[i] = data.m_offsets[i];
+				dout->m_durations[i] = data.m_durations[i];
+
+				bool value = PRBSGeneratorFilter::RunPRBS(state, poly);
+				dout->m_samples[i] = (value != data.m_samples[i]);
+			}
+		}
+	}
+	else
+	{
+		for(size_t i=statesize; i<len; i++)
+		{
+			dout->m_offsets[i] = data.m_offsets[i];
+			dout->m_durations[i] = data.m_durations[i];
+
+			bool value = PRBSGeneratorFilter::RunPRBS(prbs, poly);
+			dout->m_samples[i] = (value != data.m_samples[i]);
+		}
 	}
 
 	dout->MarkModifiedFromCpu();
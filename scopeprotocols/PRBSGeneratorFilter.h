@@ -42,6 +42,10 @@ public:
 
 	virtual void Refresh() override;
 
+	//The generator advances its sequence every run, so output changes even with identical settings
+	virtual bool ShouldMemoize() override
+	{ return false; }
+
 	static std::string GetProtocolName();
 	virtual void SetDefaultName() override;
 
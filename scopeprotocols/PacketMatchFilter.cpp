@@ -0,0 +1,116 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "PacketMatchFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PacketMatchFilter::PacketMatchFilter(const string& color)
+	: PacketDecoder(color, CAT_BUS)
+	, m_exprname("Expression")
+	, m_cachedExprValid(false)
+{
+	CreateInput("din");
+
+	m_parameters[m_exprname] = FilterParameter(FilterParameter::TYPE_STRING, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exprname].SetStringVal("");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool PacketMatchFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == nullptr)
+		return false;
+
+	//Accept the packet stream of any packet producing decoder
+	if( (i == 0) && (dynamic_cast<PacketDecoder*>(stream.m_channel) != nullptr) )
+		return true;
+
+	return false;
+}
+
+vector<string> PacketMatchFilter::GetHeaders()
+{
+	//Our columns are whatever the upstream decoder produces
+	auto src = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel);
+	if(src)
+		return src->GetHeaders();
+	return {};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string PacketMatchFilter::GetProtocolName()
+{
+	return "Packet Match";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void PacketMatchFilter::Refresh()
+{
+	ClearPackets();
+
+	//We only filter the packet stream; there's no generic way to reconstruct an arbitrary upstream decoder's
+	//timeline waveform, so we don't emit one
+	SetData(nullptr, 0);
+
+	auto src = dynamic_cast<PacketDecoder*>(GetInput(0).m_channel);
+	if(!src)
+		return;
+
+	//Recompile only when the expression text changes (warn once per edit, not once per refresh)
+	auto expr = m_parameters[m_exprname].ToString();
+	if(!m_cachedExprValid || (expr != m_cachedExprString) )
+	{
+		if(!m_expr.Compile(expr) && !expr.empty())
+			LogWarning("PacketMatchFilter: %s\n", m_expr.GetError().c_str());
+		m_cachedExprString = expr;
+		m_cachedExprValid = true;
+	}
+	if(!m_expr.IsValid())
+		return;
+
+	//Single pass over the upstream packets (seeded from the inverted header index when the expression
+	//contains a string equality term)
+	for(auto p : m_expr.Evaluate(src))
+	{
+		auto np = new Packet;
+		*np = *p;
+		m_packets.push_back(np);
+	}
+}
@@ -113,11 +113,25 @@ void ParallelBus::Refresh()
 	cap->PrepareForCpuAccess();
 	cap->Resize(len);
 	cap->CopyTimestamps(inputs[0]);
+
+	//Process in tiles: each input line is read sequentially and the output tile stays cache resident, rather
+	//than striding across every input array for each sample
+	const size_t tilesize = 4096;
 	#pragma omp parallel for
-	for(size_t i=0; i<len; i++)
+	for(size_t base=0; base<len; base += tilesize)
 	{
+		size_t end = min(base + tilesize, len);
+
+		//Size each sample's bit vector once, rather than growing it bit by bit
+		for(size_t i=base; i<end; i++)
+			cap->m_samples[i].resize(width);
+
 		for(int j=0; j<width; j++)
-			cap->m_samples[i].push_back(inputs[j]->m_samples[i]);
+		{
+			auto& insamples = inputs[j]->m_samples;
+			for(size_t i=base; i<end; i++)
+				cap->m_samples[i][j] = insamples[i];
+		}
 	}
 	SetData(cap, 0);
 
@@ -46,6 +46,8 @@ using namespace std;
 
 PcapngExportFilter::PcapngExportFilter(const string& color)
 	: ExportFilter(color)
+	, m_pendingOffset(0)
+	, m_inFrame(false)
 {
 	m_parameters[m_fname].m_fileFilterMask = "*.pcapng";
 	m_parameters[m_fname].m_fileFilterName = "PcapNG files (*.pcapng)";
@@ -111,12 +113,21 @@ void PcapngExportFilter::Export()
 			return;
 		}
 
+		//Use a large stdio buffer so long streaming runs aren't bottlenecked on tiny writes
+		setvbuf(m_fp, nullptr, _IOFBF, 1024 * 1024);
+
 		//See if file is empty. If so, write header
 		fseek(m_fp, 0, SEEK_END);
 		if(ftell(m_fp) == 0)
 		{
 			LogTrace("File was empty, writing SHB\n");
 
+			//Starting a fresh file (new or just truncated), so forget any streaming state and
+			//export the entire current input below
+			m_exportedRegion.Reset();
+			m_pendingBytes.clear();
+			m_inFrame = false;
+
 			////////////////////////////////////////////////////////////////////////////////////////////////////////////
 			// Write the SHB
 
@@ -217,27 +228,45 @@ void PcapngExportFilter::Export()
 	auto stream = GetInput(0);
 	auto wfm = dynamic_cast<EthernetWaveform*>(stream.m_channel->GetData(0));
 	if(wfm)
-		ExportEthernet(wfm);
+	{
+		//Resume from our high-water mark if the input has only had frames appended since the last refresh.
+		//Anything else (new waveform, rewrite in place) starts over from the beginning of the new record;
+		//in append mode the previously written packets stay in the file untouched either way.
+		size_t start = 0;
+		if(m_exportedRegion.IsAppendOnly(wfm))
+			start = m_exportedRegion.GetCommittedLength();
+		else
+		{
+			m_pendingBytes.clear();
+			m_inFrame = false;
+		}
+
+		ExportEthernet(wfm, start);
+		m_exportedRegion.Commit(wfm);
+	}
 
 	fflush(m_fp);
 }
 
 /**
 	@brief Export Ethernet frames to a PCAPNG file
+
+	Serializes frames beginning at sample index start; earlier samples are already in the output file. A frame
+	which is still in progress at the end of the waveform is carried over in m_pendingBytes so it gets written
+	once its FCS arrives on a later refresh.
  */
-void PcapngExportFilter::ExportEthernet(EthernetWaveform* wfm)
+void PcapngExportFilter::ExportEthernet(EthernetWaveform* wfm, size_t start)
 {
-	vector<uint8_t> bytes;
-	int64_t offset = 0;
-	for(size_t i=0; i<wfm->m_samples.size(); i++)
+	for(size_t i=start; i<wfm->m_samples.size(); i++)
 	{
 		auto& samp = wfm->m_samples[i];
 		switch(samp.m_type)
 		{
 			//Start a new frame, clear out anything else
 			case EthernetFrameSegment::TYPE_SFD:
-				bytes.clear();
-				offset = wfm->m_offsets[i] * wfm->m_timescale + wfm->m_triggerPhase;
+				m_pendingBytes.clear();
+				m_pendingOffset = wfm->m_offsets[i] * wfm->m_timescale + wfm->m_triggerPhase;
+				m_inFrame = true;
 				break;
 
 			//Frame data
@@ -247,20 +276,25 @@ void PcapngExportFilter::ExportEthernet(EthernetWaveform* wfm)
 			case EthernetFrameSegment::TYPE_VLAN_TAG:
 			case EthernetFrameSegment::TYPE_PAYLOAD:
 				{
+					if(!m_inFrame)
+						break;
 					for(size_t j=0; j<samp.m_data.size(); j++)
-						bytes.push_back(samp.m_data[j]);
+						m_pendingBytes.push_back(samp.m_data[j]);
 				}
 				break;
 
 			//Good checksum, save the packet to the file
 			case EthernetFrameSegment::TYPE_FCS_GOOD:
-				ExportPacket(bytes, wfm->m_startTimestamp, wfm->m_startFemtoseconds + offset);
-				bytes.clear();
+				if(m_inFrame)
+					ExportPacket(m_pendingBytes, wfm->m_startTimestamp, wfm->m_startFemtoseconds + m_pendingOffset);
+				m_pendingBytes.clear();
+				m_inFrame = false;
 				break;
 
 			//bad checksum, drop the packet
 			case EthernetFrameSegment::TYPE_FCS_BAD:
-				bytes.clear();
+				m_pendingBytes.clear();
+				m_inFrame = false;
 				break;
 
 			//ignore anything else
@@ -275,56 +309,55 @@ void PcapngExportFilter::ExportPacket(vector<uint8_t>& packet, time_t timestamp,
 	//Canonicalize the timestamp to a single 64-bit nanosecond resolution quantity
 	int64_t ns = (1e9 * timestamp) + (fs * 1e-6);
 
+	//Assemble the whole enhanced packet block in memory, then write it with a single call
+	m_blockBuf.clear();
+	auto append = [this](const void* p, size_t len)
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(p);
+		m_blockBuf.insert(m_blockBuf.end(), bytes, bytes + len);
+	};
+
 	//Block type
 	uint32_t blocktype = 6;
-	if(!fwrite(&blocktype, sizeof(blocktype), 1, m_fp))
-		LogError("file write failure\n");
+	append(&blocktype, sizeof(blocktype));
 
 	//Block length (padded up to next 32 bit boundary)
 	uint32_t blocklen = 36 + packet.size();
 	uint32_t paddinglen = 4 - (blocklen % 4);
 	if(paddinglen == 4)
 		paddinglen = 0;
-	if(!fwrite(&blocklen, sizeof(blocklen), 1, m_fp))
-		LogError("file write failure\n");
+	append(&blocklen, sizeof(blocklen));
 
 	//Interface ID
 	uint32_t iface = 0;
-	if(!fwrite(&iface, sizeof(iface), 1, m_fp))
-		LogError("file write failure\n");
+	append(&iface, sizeof(iface));
 
 	//Timestamp
 	uint32_t tshi = (ns >> 32);
 	uint32_t tslo = (ns & 0xffffffff);
-	if(!fwrite(&tshi, sizeof(tshi), 1, m_fp))
-		LogError("file write failure\n");
-	if(!fwrite(&tslo, sizeof(tslo), 1, m_fp))
-		LogError("file write failure\n");
+	append(&tshi, sizeof(tshi));
+	append(&tslo, sizeof(tslo));
 
 	//Packet length repeated twice (original + captured, both always equal for us)
 	uint32_t packetlen = packet.size();
-	if(!fwrite(&packetlen, sizeof(packetlen), 1, m_fp))
-		LogError("file write failure\n");
-	if(!fwrite(&packetlen, sizeof(packetlen), 1, m_fp))
-		LogError("file write failure\n");
+	append(&packetlen, sizeof(packetlen));
+	append(&packetlen, sizeof(packetlen));
 
 	//Packet data
-	if(!fwrite(&packet[0], packet.size(), 1, m_fp))
-		LogError("file write failure\n");
+	append(&packet[0], packet.size());
 
 	//Pad out to 32 bit boundary
 	uint8_t padbuf[4] = {0};
-	if(!fwrite(&padbuf[0], paddinglen, 1, m_fp))
-		LogError("file write failure\n");
+	append(&padbuf[0], paddinglen);
 
 	//Option endofopt (total 4 bytes)
 	uint16_t pad = 0;
-	if(!fwrite(&pad, sizeof(pad), 1, m_fp))
-		LogError("file write failure\n");
-	if(!fwrite(&pad, sizeof(pad), 1, m_fp))
-		LogError("file write failure\n");
+	append(&pad, sizeof(pad));
+	append(&pad, sizeof(pad));
 
 	//Repeat block length
-	if(!fwrite(&blocklen, sizeof(blocklen), 1, m_fp))
+	append(&blocklen, sizeof(blocklen));
+
+	if(!fwrite(&m_blockBuf[0], m_blockBuf.size(), 1, m_fp))
 		LogError("file write failure\n");
 }
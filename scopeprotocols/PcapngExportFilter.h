@@ -53,8 +53,23 @@ public:
 protected:
 	virtual void Export() override;
 
-	void ExportEthernet(EthernetWaveform* wfm);
+	void ExportEthernet(EthernetWaveform* wfm, size_t start);
 	void ExportPacket(std::vector<uint8_t>& packet, time_t timestamp, int64_t fs);
+
+	///@brief High-water mark on our input, so each refresh serializes only newly appended frames
+	InputDirtyRegionTracker m_exportedRegion;
+
+	///@brief Data bytes of a frame that was still in progress at the end of the previous refresh
+	std::vector<uint8_t> m_pendingBytes;
+
+	///@brief Trigger-relative timestamp of the in-progress frame
+	int64_t m_pendingOffset;
+
+	///@brief True if the previous refresh ended mid-frame (SFD seen, FCS not yet)
+	bool m_inFrame;
+
+	///@brief Scratch buffer for assembling one enhanced packet block before writing it in a single call
+	std::vector<uint8_t> m_blockBuf;
 };
 
 #endif
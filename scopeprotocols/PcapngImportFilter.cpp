@@ -31,8 +31,31 @@
 #include "CANDecoder.h"
 #include "PcapngImportFilter.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
+//The SHB magic validated the file as little endian, so plain byte copies read scalar fields correctly
+//on every platform we support (and avoid unaligned access problems on the mapped file)
+static uint32_t ReadU32(const uint8_t* p)
+{
+	uint32_t tmp;
+	memcpy(&tmp, p, sizeof(tmp));
+	return tmp;
+}
+
+static uint16_t ReadU16(const uint8_t* p)
+{
+	uint16_t tmp;
+	memcpy(&tmp, p, sizeof(tmp));
+	return tmp;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -166,283 +189,275 @@ void PcapngImportFilter::OnFileNameChanged()
 		return;
 	}
 
-	//Move back to the start of the EPB
+	//Block boundaries are self-describing, so the packet blocks can be parsed in parallel from a memory
+	//mapping rather than one stdio read at a time. Drop the stdio handle now that the headers are done.
 	LogTrace("Ready to start reading frame data\n");
-	fseek(fp, blockstart, SEEK_SET);
+	fclose(fp);
+
+	const uint8_t* base;
+	size_t filelen;
+#ifndef _WIN32
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		LogError("Couldn't open PcapNG file \"%s\"\n", fname.c_str());
+		return;
+	}
+	struct stat st;
+	if(0 != fstat(fd, &st))
+	{
+		close(fd);
+		return;
+	}
+	filelen = st.st_size;
+	base = reinterpret_cast<const uint8_t*>(mmap(nullptr, filelen, PROT_READ, MAP_PRIVATE, fd, 0));
+	if(base == MAP_FAILED)
+	{
+		LogError("Couldn't map PcapNG file \"%s\"\n", fname.c_str());
+		close(fd);
+		return;
+	}
+#else
+	//No mmap on Windows for now, read the whole file into RAM instead
+	vector<uint8_t> filebuf;
+	FILE* fdata = fopen(fname.c_str(), "rb");
+	if(!fdata)
+	{
+		LogError("Couldn't open PcapNG file \"%s\"\n", fname.c_str());
+		return;
+	}
+	fseek(fdata, 0, SEEK_END);
+	filelen = ftell(fdata);
+	fseek(fdata, 0, SEEK_SET);
+	filebuf.resize(filelen);
+	if(filelen != fread(&filebuf[0], 1, filelen, fdata))
+	{
+		LogError("Couldn't read PcapNG file \"%s\"\n", fname.c_str());
+		fclose(fdata);
+		return;
+	}
+	fclose(fdata);
+	base = &filebuf[0];
+#endif
 
 	switch(m_linkType)
 	{
 		case LINK_TYPE_SOCKETCAN:
-			LoadSocketCAN(fp);
+			LoadSocketCAN(base, filelen, blockstart);
 			break;
 
 		case LINK_TYPE_LINUX_COOKED:
 			//Linux cooked encapsulation is special: we don't know the output data format initially
 			//and there can be a mix of several which we don't currently implement!
-			LoadLinuxCooked(fp);
+			LoadLinuxCooked(base, filelen, blockstart);
 			break;
 
 		default:
 			break;
 	}
 
-	fclose(fp);
+#ifndef _WIN32
+	munmap(const_cast<uint8_t*>(base), filelen);
+	close(fd);
+#endif
 }
 
-//TODO: this shares a lot in common with LoadCANLinuxCooked, how can we share more?
-bool PcapngImportFilter::LoadSocketCAN(FILE* fp)
-{
-	LogTrace("Loading SocketCAN packets\n");
-	LogIndenter li;
-
-	//Create output waveform
-	auto cap = new CANWaveform;
-	cap->m_timescale = 1;
-	cap->m_triggerPhase = 0;
-	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
-
-	bool first = true;
-	int64_t baseTimestamp = 0;
-
-	//Calculate length of a single bit on the bus
-	int64_t baud = m_parameters[m_datarate].GetIntVal();
-	int64_t ui = FS_PER_SECOND / baud;
+/**
+	@brief Walks the block list and returns the offsets of all Enhanced Packet Blocks
 
-	uint32_t blocktype;
-	uint32_t blocklen;
-	int64_t tend = 0;
-	while(!feof(fp))
+	Every block carries its own type and length, so this is a pure pointer chase over headers and runs at
+	memory bandwidth even for multi-GB captures.
+ */
+vector<size_t> PcapngImportFilter::ScanPacketBlocks(const uint8_t* base, size_t len, size_t start)
+{
+	vector<size_t> ret;
+	size_t off = start;
+	while(off + 8 <= len)
 	{
-		auto blockstart = ftell(fp);
+		uint32_t blocktype = ReadU32(base + off);
+		uint32_t blocklen = ReadU32(base + off + 4);
 
-		if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
-			return false;
-		if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-			return false;
+		//Truncated or corrupted block, stop here
+		if( (blocklen < 12) || (blocklen > (len - off)) )
+			break;
 
-		//Should be an EPB, ignore anything else
 		switch(blocktype)
 		{
+			//Interface Statistics Block, skip
 			case 5:
-				LogTrace("Found Block Statistics (%d bytes)\n", blocklen);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
+				break;
 
+			//Enhanced Packet Block
 			case 6:
-				//LogTrace("Found EPB (%d bytes)\n", blocklen);
+				ret.push_back(off);
 				break;
 
+			//unknown type, wut?
 			default:
-				//unknown type, wut?
 				LogWarning("unknown block type %d\n", blocktype);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
-		}
-		LogIndenter li2;
-
-		////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		// PCAPNG EPB headers
-
-		//For now, ignore interface number since we don't support mixed captures or multiple output streams yet
-		uint32_t ifacenum;
-		if(1 != fread(&ifacenum, sizeof(ifacenum), 1, fp))
-			return false;
-		//LogTrace("Interface %u\n", ifacenum);
-
-		//Timestamp
-		uint32_t tstamp[2];
-		if(2 != fread(tstamp, sizeof(uint32_t), 2, fp))
-			return false;
-
-		//Convert from packed format in native units to a single 64-bit integer
-		int64_t stamp = tstamp[0];
-		stamp = (stamp << 32) | tstamp[1];
-
-		//If this is the FIRST packet in the capture, it's the base timestamp and we measure offsets from that
-		if(first)
-		{
-			baseTimestamp = stamp;
-			stamp = 0;
-			first = false;
-
-			//Convert base timestamp to seconds and fs
-			int64_t ticks_per_fs = FS_PER_SECOND / m_timestampScale;
-			cap->m_startTimestamp = baseTimestamp / ticks_per_fs;
-			cap->m_startFemtoseconds = m_timestampScale * (baseTimestamp % ticks_per_fs);
-		}
-
-		//Not first, use relative offset
-		else
-			stamp -= baseTimestamp;
-
-		//Convert from native units to fs
-		stamp *= m_timestampScale;
-
-		//Actual as-captured packet length
-		uint32_t packlen;
-		if(1 != fread(&packlen, sizeof(packlen), 1, fp))
-			return false;
-		if(packlen < 16)
-		{
-			LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		//Original packet length (might have been truncated, but ignore this)
-		uint32_t origlen;
-		if(1 != fread(&origlen, sizeof(origlen), 1, fp))
-			return false;
-
-		//Timestamps sometimes have some jitter due to USB dongles combining several into one transaction,
-		//without logging actual arrival timestamps. So they can appear to be coming at too high a baud rate.
-		//Fudge the timestamp if it claims to have come before the previous frame ended
-		if(stamp < tend)
-			stamp = tend;
-
-		//Read CAN ID (32 bit on wire)
-		uint32_t id;
-		if(1 != fread(&id, sizeof(id), 1, fp))
-			return false;
-		id = ntohl(id);
-
-		//Read frame length
-		uint8_t nbytes;
-		if(1 != fread(&nbytes, sizeof(nbytes), 1, fp))
-			return false;
-		if(nbytes > 8)
-		{
-			LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
+				break;
 		}
 
-		//Skip 3 bytes of FD flags / reserved before the payload
-		fseek(fp, 3, SEEK_CUR);
+		off += blocklen;
+	}
+	return ret;
+}
 
-		//Read payload
-		uint8_t data[8];
-		if(nbytes != fread(data, 1, nbytes, fp))
-			return false;
+/**
+	@brief Parses a single SocketCAN Enhanced Packet Block
 
-		//Extract header bits (packed in with ID)
-		bool ext = (id & 0x80000000);
-		bool rtr = (id & 0x40000000);
-		bool err = (id & 0x20000000);
-		id &= 0x1fffffff;
-		bool fd = false;//(proto == 0x0d);
+	@return true if a valid frame was extracted
+ */
+bool PcapngImportFilter::ParseSocketCANFrame(const uint8_t* base, size_t /*len*/, size_t off, CANFrame& frame)
+{
+	//Block length was already bounds checked by ScanPacketBlocks(), so stay within it
+	uint32_t blocklen = ReadU32(base + off + 4);
 
-		//Add timeline samples
-		cap->m_offsets.push_back(stamp);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
+	//EPB headers: interface number (ignored), timestamp, captured length, original length (ignored)
+	if(blocklen < 36)
+		return false;
+	int64_t stamp = ReadU32(base + off + 12);
+	stamp = (stamp << 32) | ReadU32(base + off + 16);
+	uint32_t packlen = ReadU32(base + off + 20);
+	if(packlen < 16)
+	{
+		LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
+		return false;
+	}
 
-		cap->m_offsets.push_back(stamp + ui);
-		cap->m_durations.push_back(31 * ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
+	//CAN ID (32 bit big endian on wire), frame length, 3 bytes of FD flags / reserved, then payload
+	uint32_t id = ntohl(ReadU32(base + off + 28));
+	uint8_t nbytes = base[off + 32];
+	if(nbytes > 8)
+	{
+		LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
+		return false;
+	}
+	if(blocklen < (36u + nbytes))
+		return false;
 
-		cap->m_offsets.push_back(stamp + 32*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
+	frame.m_stamp = stamp;
+	frame.m_ext = (id & 0x80000000);
+	frame.m_rtr = (id & 0x40000000);
+	frame.m_err = (id & 0x20000000);
+	frame.m_fd = false;
+	frame.m_id = id & 0x1fffffff;
+	frame.m_bytes = nbytes;
+	memcpy(frame.m_data, base + off + 36, nbytes);
+	return true;
+}
 
-		cap->m_offsets.push_back(stamp + 33*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
+/**
+	@brief Parses a single Enhanced Packet Block containing a CAN frame with Linux cooked headers
 
-		cap->m_offsets.push_back(stamp + 34*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
+	@return true if a valid frame was extracted
+ */
+bool PcapngImportFilter::ParseCANLinuxCookedFrame(const uint8_t* base, size_t /*len*/, size_t off, CANFrame& frame)
+{
+	uint32_t blocklen = ReadU32(base + off + 4);
 
-		cap->m_offsets.push_back(stamp + 35*ui);
-		cap->m_durations.push_back(ui*4);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
+	//EPB headers: interface number (ignored), timestamp, captured length, original length (ignored)
+	if(blocklen < 52)
+		return false;
+	int64_t stamp = ReadU32(base + off + 12);
+	stamp = (stamp << 32) | ReadU32(base + off + 16);
+	uint32_t packlen = ReadU32(base + off + 20);
+	if(packlen < 16)
+	{
+		LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
+		return false;
+	}
 
-		//Data
-		for(size_t i=0; i<nbytes; i++)
-		{
-			cap->m_offsets.push_back(stamp + 39*ui + i*8*ui);
-			cap->m_durations.push_back(ui*8);
-			cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
-		}
+	//Linux cooked packet header: packet type (ignored), ARPHRD type, link layer address length,
+	//8 bytes of padding, protocol type
+	uint16_t arphrd = ntohs(ReadU16(base + off + 30));
+	if(arphrd != 280)
+	{
+		LogWarning("Unknown ARPHRD type %d in what we expected to be a CAN capture inside Linux cooked headers\n",
+			arphrd);
+		return false;
+	}
+	uint16_t linklen = ntohs(ReadU16(base + off + 32));
+	if(linklen != 0)
+	{
+		LogWarning("Invalid link layer address length %d (should be 0 for CAN)\n", linklen);
+		return false;
+	}
+	uint16_t proto = ntohs(ReadU16(base + off + 42));
+	if( (proto != 0x0c) && (proto != 0x0d) )
+	{
+		LogWarning("Invalid protocol type 0x%02x (should be 0x0c for CAN or 0x0d for CAN-FD)\n", proto);
+		return false;
+	}
 
-		tend = stamp + 39*ui + nbytes*8*ui;
+	//CAN ID, frame length, then payload
+	uint32_t id = ReadU32(base + off + 44);
+	uint32_t nbytes = ReadU32(base + off + 48);
+	if(nbytes > 8)
+	{
+		LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
+		return false;
+	}
+	if(blocklen < (52 + nbytes))
+		return false;
 
-		//CRC TODO
-		//CRC delim TODO
-		//ACK TODO
-		//ACK delim TODO
+	frame.m_stamp = stamp;
+	frame.m_ext = (id & 0x80000000);
+	frame.m_rtr = (id & 0x40000000);
+	frame.m_err = false;
+	frame.m_fd = (proto == 0x0d);
+	frame.m_id = id & 0x1fffffff;
+	frame.m_bytes = nbytes;
+	memcpy(frame.m_data, base + off + 52, nbytes);
+	return true;
+}
 
-		//Add the packet
-		//Fake the duration for now: assume 8 bytes payload, extended format, and no stuffing
-		//Leave format/type/ack blank, this doesn't seem to be saved in this capture format
-		auto pack = new Packet;
-		if(err)
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-		else if(rtr)
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
-		else
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
-		pack->m_headers["Format"] = ext ? "EXT" : "BASE";
-		pack->m_headers["ID"] = to_string_hex(id);
-		pack->m_headers["Mode"] = fd ? "CAN-FD" : "CAN";
-		pack->m_headers["Len"] = to_string(nbytes);
-		if(err)
-			pack->m_headers["Format"] = "ERR";
-		for(size_t i=0; i<nbytes; i++)
-			pack->m_data.push_back(data[i]);
-		pack->m_offset = stamp;
-		pack->m_len = 128 * ui;
-		m_packets.push_back(pack);
+bool PcapngImportFilter::LoadSocketCAN(const uint8_t* base, size_t len, size_t start)
+{
+	LogTrace("Loading SocketCAN packets\n");
+	LogIndenter li;
 
-		//End of the EPB, skip any unread contents
-		fseek(fp, blockstart + blocklen, SEEK_SET);
+	//Parse the packet blocks in parallel: each one is fully self contained, so the only serial work is
+	//the block boundary scan
+	auto blocks = ScanPacketBlocks(base, len, start);
+	size_t nblocks = blocks.size();
+	vector<CANFrame> frames(nblocks);
+	vector<uint8_t> valid(nblocks, 0);
+	#pragma omp parallel for
+	for(size_t i=0; i<nblocks; i++)
+		valid[i] = ParseSocketCANFrame(base, len, blocks[i], frames[i]);
+
+	//Drop any blocks that failed to parse
+	vector<CANFrame> good;
+	good.reserve(nblocks);
+	for(size_t i=0; i<nblocks; i++)
+	{
+		if(valid[i])
+			good.push_back(frames[i]);
 	}
 
+	BuildCANWaveform(good);
 	return true;
 }
 
-bool PcapngImportFilter::LoadLinuxCooked(FILE* fp)
+bool PcapngImportFilter::LoadLinuxCooked(const uint8_t* base, size_t len, size_t start)
 {
 	LogTrace("Loading Linux cooked format packets\n");
 	LogIndenter li;
 
 	//We don't know the interface format yet!
-	//Look ahead a bit to figure that out
-
-	//Outer headers
-	//uint32 block type
-	//uint32_t len
-
-	//EPB headers
-	//unit32 iface_id
-	//uint64 timestamp
-	//uint32 packlen
-	//uint32 origpacklen
-
-	//Linux cooked packet headers
-	//uint16 packet_type
-	//uint16 ARPHRD_type
-
-	//So we need to skip ahead 30 bytes and sneak a peek at the AHPHRD_type field to know
+	//Sneak a peek at the ARPHRD_type field of the first packet (30 bytes into the EPB) to know
 	//what kind of waveform we're dealing with.
 	//TODO: support multiple interfaces and multiple encapsulations in a single packet stream
-	auto orig = ftell(fp);
-	fseek(fp, 30, SEEK_CUR);
-
-	uint16_t arphrd;
-	if(1 != fread(&arphrd, sizeof(arphrd), 1, fp))
+	if(start + 32 > len)
 		return false;
-	arphrd = ntohs(arphrd);
-
-	//Ok, back to where we started
-	fseek(fp, orig, SEEK_SET);
+	uint16_t arphrd = ntohs(ReadU16(base + start + 30));
 
 	//So what is it?
 	switch(arphrd)
 	{
 		case 280:
-			return LoadCANLinuxCooked(fp);
+			return LoadCANLinuxCooked(base, len, start);
 
 		default:
 			LogError("Unknown inner format %d in Linux cooked encapsulation\n", arphrd);
@@ -452,11 +467,41 @@ bool PcapngImportFilter::LoadLinuxCooked(FILE* fp)
 	return true;
 }
 
-bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
+bool PcapngImportFilter::LoadCANLinuxCooked(const uint8_t* base, size_t len, size_t start)
 {
 	LogTrace("Loading CAN frames with Linux cooked encapsulation\n");
 	LogIndenter li;
 
+	//Same structure as LoadSocketCAN, just a different per-block parser
+	auto blocks = ScanPacketBlocks(base, len, start);
+	size_t nblocks = blocks.size();
+	vector<CANFrame> frames(nblocks);
+	vector<uint8_t> valid(nblocks, 0);
+	#pragma omp parallel for
+	for(size_t i=0; i<nblocks; i++)
+		valid[i] = ParseCANLinuxCookedFrame(base, len, blocks[i], frames[i]);
+
+	vector<CANFrame> good;
+	good.reserve(nblocks);
+	for(size_t i=0; i<nblocks; i++)
+	{
+		if(valid[i])
+			good.push_back(frames[i]);
+	}
+
+	BuildCANWaveform(good);
+	return true;
+}
+
+/**
+	@brief Constructs the output waveform and packet list from a list of parsed CAN frames
+
+	Frames may arrive in any order (parallel parsing keeps file order, but some capture hardware batches
+	frames with stale timestamps), so they are sorted by timestamp first. The waveform is then bulk
+	allocated at its final size and filled by index in parallel rather than grown sample by sample.
+ */
+void PcapngImportFilter::BuildCANWaveform(vector<CANFrame>& frames)
+{
 	//Create output waveform
 	auto cap = new CANWaveform;
 	cap->m_timescale = 1;
@@ -464,220 +509,88 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 	cap->PrepareForCpuAccess();
 	SetData(cap, 0);
 
-	bool first = true;
-	int64_t baseTimestamp = 0;
+	if(frames.empty())
+		return;
 
 	//Calculate length of a single bit on the bus
 	int64_t baud = m_parameters[m_datarate].GetIntVal();
 	int64_t ui = FS_PER_SECOND / baud;
 
-	uint32_t blocktype;
-	uint32_t blocklen;
+	//Restore timestamp order
+	stable_sort(frames.begin(), frames.end(),
+		[](const CANFrame& a, const CANFrame& b)
+		{ return a.m_stamp < b.m_stamp; });
+
+	//The first packet in the capture is the base timestamp and we measure offsets from that
+	int64_t baseTimestamp = frames[0].m_stamp;
+	int64_t ticks_per_fs = FS_PER_SECOND / m_timestampScale;
+	cap->m_startTimestamp = baseTimestamp / ticks_per_fs;
+	cap->m_startFemtoseconds = m_timestampScale * (baseTimestamp % ticks_per_fs);
+
+	//Convert timestamps to fs offsets and lay out each frame's slice of the sample arrays.
+	//Timestamps sometimes have some jitter due to USB dongles combining several into one transaction,
+	//without logging actual arrival timestamps. So they can appear to be coming at too high a baud rate.
+	//Fudge the timestamp if it claims to have come before the previous frame ended.
+	size_t nframes = frames.size();
+	vector<int64_t> stamps(nframes);
+	vector<size_t> sampbase(nframes);
 	int64_t tend = 0;
-	while(!feof(fp))
+	size_t nsamples = 0;
+	for(size_t i=0; i<nframes; i++)
 	{
-		auto blockstart = ftell(fp);
-
-		if(1 != fread(&blocktype, sizeof(blocktype), 1, fp))
-			return false;
-		if(1 != fread(&blocklen, sizeof(blocklen), 1, fp))
-			return false;
-
-		//Should be an EPB, ignore anything else
-		switch(blocktype)
-		{
-			case 5:
-				LogTrace("Found Block Statistics (%d bytes)\n", blocklen);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
-
-			case 6:
-				//LogTrace("Found EPB (%d bytes)\n", blocklen);
-				break;
-
-			default:
-				//unknown type, wut?
-				LogWarning("unknown block type %d\n", blocktype);
-				fseek(fp, blockstart + blocklen, SEEK_SET);
-				continue;
-		}
-		LogIndenter li2;
-
-		////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		// PCAPNG EPB headers
-
-		//For now, ignore interface number since we don't support mixed captures or multiple output streams yet
-		uint32_t ifacenum;
-		if(1 != fread(&ifacenum, sizeof(ifacenum), 1, fp))
-			return false;
-		//LogTrace("Interface %u\n", ifacenum);
-
-		//Timestamp
-		uint32_t tstamp[2];
-		if(2 != fread(tstamp, sizeof(uint32_t), 2, fp))
-			return false;
-
-		//Convert from packed format in native units to a single 64-bit integer
-		int64_t stamp = tstamp[0];
-		stamp = (stamp << 32) | tstamp[1];
-
-		//If this is the FIRST packet in the capture, it's the base timestamp and we measure offsets from that
-		if(first)
-		{
-			baseTimestamp = stamp;
-			stamp = 0;
-			first = false;
-
-			//Convert base timestamp to seconds and fs
-			int64_t ticks_per_fs = FS_PER_SECOND / m_timestampScale;
-			cap->m_startTimestamp = baseTimestamp / ticks_per_fs;
-			cap->m_startFemtoseconds = m_timestampScale * (baseTimestamp % ticks_per_fs);
-		}
-
-		//Not first, use relative offset
-		else
-			stamp -= baseTimestamp;
-
-		//Convert from native units to fs
-		stamp *= m_timestampScale;
-
-		//Actual as-captured packet length
-		uint32_t packlen;
-		if(1 != fread(&packlen, sizeof(packlen), 1, fp))
-			return false;
-		if(packlen < 16)
-		{
-			LogWarning("Invalid packet length %d (should be >= 16 to allow room for cooked headers)\n", packlen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		//Original packet length (might have been truncated, but ignore this)
-		uint32_t origlen;
-		if(1 != fread(&origlen, sizeof(origlen), 1, fp))
-			return false;
-
-		////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		// Linux cooked packet header
-
-		//Packet type (typically always be 0x01 broadcast, or 0x04 sent by us, for CAN)
-		uint16_t packtype;
-		if(1 != fread(&packtype, sizeof(packtype), 1, fp))
-			return false;
-
-		//ARPHRD type (should always be 280, CAN, if we get to this point)
-		uint16_t arphrd;
-		if(1 != fread(&arphrd, sizeof(arphrd), 1, fp))
-			return false;
-		arphrd = ntohs(arphrd);
-		if(arphrd != 280)
-		{
-			LogWarning("Unknown ARPHRD type %d in what we expected to be a CAN capture inside Linux cooked headers\n",
-				arphrd);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		//Link layer address length (should always be 0 for CAN bus)
-		uint16_t linklen;
-		if(1 != fread(&linklen, sizeof(linklen), 1, fp))
-			return false;
-		linklen = ntohs(linklen);
-		if(linklen != 0)
-		{
-			LogWarning("Invalid link layer address length %d (should be 0 for CAN)\n", linklen);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		//8 bytes of padding (where link layer address would be if we had one)
-		uint64_t padding;
-		if(1 != fread(&padding, sizeof(padding), 1, fp))
-			return false;
-
-		//Protocol type (should be 0x0C, CAN bus or 0x0d (CAN-FD))
-		uint16_t proto;
-		if(1 != fread(&proto, sizeof(proto), 1, fp))
-			return false;
-		proto = ntohs(proto);
-		if( (proto != 0x0c) && (proto != 0x0d) )
-		{
-			LogWarning("Invalid protocol type 0x%02x (should be 0x0c for CAN or 0x0d for CAN-FD)\n", proto);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		// CAN packet itself
-
-		//Timestamps sometimes have some jitter due to USB dongles combining several into one transaction,
-		//without logging actual arrival timestamps. So they can appear to be coming at too high a baud rate.
-		//Fudge the timestamp if it claims to have come before the previous frame ended
+		int64_t stamp = (frames[i].m_stamp - baseTimestamp) * m_timestampScale;
 		if(stamp < tend)
 			stamp = tend;
+		tend = stamp + 39*ui + frames[i].m_bytes*8*ui;
 
-		//Read CAN ID (32 bit on wire)
-		uint32_t id;
-		if(1 != fread(&id, sizeof(id), 1, fp))
-			return false;
-
-		//Read frame length
-		uint32_t nbytes;
-		if(1 != fread(&nbytes, sizeof(nbytes), 1, fp))
-			return false;
-		if(nbytes > 8)
-		{
-			LogWarning("Invalid DLC %d (should be <= 8)\n", nbytes);
-			fseek(fp, blockstart + blocklen, SEEK_SET);
-			continue;
-		}
-
-		//Read payload
-		uint8_t data[8];
-		if(nbytes != fread(data, 1, nbytes, fp))
-			return false;
+		stamps[i] = stamp;
+		sampbase[i] = nsamples;
+		nsamples += 6 + frames[i].m_bytes;
+	}
 
-		//Extract header bits (packed in with ID)
-		bool ext = (id & 0x80000000);
-		bool rtr = (id & 0x40000000);
-		id &= 0x1fffffff;
-		bool fd = (proto == 0x0d);
+	//Bulk allocate the output at final size, then fill it in parallel
+	cap->Resize(nsamples);
+	vector<Packet*> packs(nframes);
+	#pragma omp parallel for
+	for(size_t i=0; i<nframes; i++)
+	{
+		auto& f = frames[i];
+		int64_t stamp = stamps[i];
+		size_t j = sampbase[i];
 
 		//Add timeline samples
-		cap->m_offsets.push_back(stamp);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_SOF, 0));
+		cap->m_offsets[j] = stamp;
+		cap->m_durations[j] = ui;
+		cap->m_samples[j] = CANSymbol(CANSymbol::TYPE_SOF, 0);
 
-		cap->m_offsets.push_back(stamp + ui);
-		cap->m_durations.push_back(31 * ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_ID, id));
+		cap->m_offsets[j+1] = stamp + ui;
+		cap->m_durations[j+1] = 31 * ui;
+		cap->m_samples[j+1] = CANSymbol(CANSymbol::TYPE_ID, f.m_id);
 
-		cap->m_offsets.push_back(stamp + 32*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_RTR, rtr));
+		cap->m_offsets[j+2] = stamp + 32*ui;
+		cap->m_durations[j+2] = ui;
+		cap->m_samples[j+2] = CANSymbol(CANSymbol::TYPE_RTR, f.m_rtr);
 
-		cap->m_offsets.push_back(stamp + 33*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_FD, fd));
+		cap->m_offsets[j+3] = stamp + 33*ui;
+		cap->m_durations[j+3] = ui;
+		cap->m_samples[j+3] = CANSymbol(CANSymbol::TYPE_FD, f.m_fd);
 
-		cap->m_offsets.push_back(stamp + 34*ui);
-		cap->m_durations.push_back(ui);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_R0, 0));
+		cap->m_offsets[j+4] = stamp + 34*ui;
+		cap->m_durations[j+4] = ui;
+		cap->m_samples[j+4] = CANSymbol(CANSymbol::TYPE_R0, 0);
 
-		cap->m_offsets.push_back(stamp + 35*ui);
-		cap->m_durations.push_back(ui*4);
-		cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DLC, nbytes));
+		cap->m_offsets[j+5] = stamp + 35*ui;
+		cap->m_durations[j+5] = ui*4;
+		cap->m_samples[j+5] = CANSymbol(CANSymbol::TYPE_DLC, f.m_bytes);
 
 		//Data
-		for(size_t i=0; i<nbytes; i++)
+		for(size_t k=0; k<f.m_bytes; k++)
 		{
-			cap->m_offsets.push_back(stamp + 39*ui + i*8*ui);
-			cap->m_durations.push_back(ui*8);
-			cap->m_samples.push_back(CANSymbol(CANSymbol::TYPE_DATA, data[i]));
+			cap->m_offsets[j+6+k] = stamp + 39*ui + k*8*ui;
+			cap->m_durations[j+6+k] = ui*8;
+			cap->m_samples[j+6+k] = CANSymbol(CANSymbol::TYPE_DATA, f.m_data[k]);
 		}
 
-		tend = stamp + 39*ui + nbytes*8*ui;
-
 		//CRC TODO
 		//CRC delim TODO
 		//ACK TODO
@@ -687,25 +600,29 @@ bool PcapngImportFilter::LoadCANLinuxCooked(FILE* fp)
 		//Fake the duration for now: assume 8 bytes payload, extended format, and no stuffing
 		//Leave format/type/ack blank, this doesn't seem to be saved in this capture format
 		auto pack = new Packet;
-		if(rtr)
+		if(f.m_err)
+			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+		else if(f.m_rtr)
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
 		else
 			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
-		pack->m_headers["Format"] = ext ? "EXT" : "BASE";
-		pack->m_headers["ID"] = to_string_hex(id);
-		pack->m_headers["Mode"] = fd ? "CAN-FD" : "CAN";
-		pack->m_headers["Len"] = to_string(nbytes);
-		for(size_t i=0; i<nbytes; i++)
-			pack->m_data.push_back(data[i]);
+		pack->m_headers["Format"] = f.m_ext ? "EXT" : "BASE";
+		pack->m_headers["ID"] = to_string_hex(f.m_id);
+		pack->m_headers["Mode"] = f.m_fd ? "CAN-FD" : "CAN";
+		pack->m_headers["Len"] = to_string(f.m_bytes);
+		if(f.m_err)
+			pack->m_headers["Format"] = "ERR";
+		for(size_t k=0; k<f.m_bytes; k++)
+			pack->m_data.push_back(f.m_data[k]);
 		pack->m_offset = stamp;
 		pack->m_len = 128 * ui;
-		m_packets.push_back(pack);
-
-		//End of the EPB, skip any unread contents
-		fseek(fp, blockstart + blocklen, SEEK_SET);
+		packs[i] = pack;
 	}
 
-	return true;
+	for(size_t i=0; i<nframes; i++)
+		m_packets.push_back(packs[i]);
+
+	cap->MarkModifiedFromCpu();
 }
 
 /**
@@ -59,9 +59,36 @@ protected:
 	bool ReadIDB(FILE* fp);
 	std::string ReadFixedLengthString(uint16_t len, FILE* fp);
 
-	bool LoadLinuxCooked(FILE* fp);
-	bool LoadCANLinuxCooked(FILE* fp);
-	bool LoadSocketCAN(FILE* fp);
+	///@brief A CAN frame parsed from an Enhanced Packet Block, prior to waveform construction
+	struct CANFrame
+	{
+		///@brief Timestamp in native capture units
+		int64_t m_stamp;
+
+		///@brief CAN message ID with the flag bits stripped
+		uint32_t m_id;
+
+		///@brief Payload length
+		uint32_t m_bytes;
+
+		bool m_ext;
+		bool m_rtr;
+		bool m_err;
+		bool m_fd;
+
+		///@brief Payload
+		uint8_t m_data[8];
+	};
+
+	bool LoadLinuxCooked(const uint8_t* base, size_t len, size_t start);
+	bool LoadCANLinuxCooked(const uint8_t* base, size_t len, size_t start);
+	bool LoadSocketCAN(const uint8_t* base, size_t len, size_t start);
+
+	std::vector<size_t> ScanPacketBlocks(const uint8_t* base, size_t len, size_t start);
+	void BuildCANWaveform(std::vector<CANFrame>& frames);
+
+	static bool ParseSocketCANFrame(const uint8_t* base, size_t len, size_t off, CANFrame& frame);
+	static bool ParseCANLinuxCookedFrame(const uint8_t* base, size_t len, size_t off, CANFrame& frame);
 
 	enum LinkType
 	{
@@ -71,7 +71,7 @@ string PeaksFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void PeaksFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueHandle> /*queue*/)
+void PeaksFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	//Output units track the input
 	if(GetInput(0))
@@ -107,7 +107,8 @@ void PeaksFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, shared_ptr<QueueH
 	}
 	else if(udin)
 	{
-		FindPeaks(udin);
+		//Uniform waveforms can use the GPU candidate pass for the search
+		FindPeaks(udin, cmdBuf, queue);
 
 		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
 		cap->m_samples.CopyFrom(udin->m_samples);
@@ -0,0 +1,153 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "PointwiseFilter.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PointwiseFilter::PointwiseFilter(const string& color, Category cat)
+	: Filter(color, cat)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool PointwiseFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void PointwiseFilter::Refresh()
+{
+	//Make sure we've got valid inputs
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Collect our op and those of any upstream pointwise filters driving us, so the whole chain is
+	//evaluated in one pass over the chain head's input. Ops end up ordered head first.
+	vector<PointwiseOp> ops;
+	ops.push_back(GetPointwiseOp());
+	auto head = GetInput(0);
+	while(true)
+	{
+		auto up = dynamic_cast<PointwiseFilter*>(head.m_channel);
+		if(!up || (head.m_stream != 0) )
+			break;
+		auto upin = up->GetInput(0);
+		if(!upin.m_channel || !upin.GetData())
+			break;
+		ops.push_back(up->GetPointwiseOp());
+		head = up->GetInput(0);
+	}
+	reverse(ops.begin(), ops.end());
+
+	auto din = head.GetData();
+	size_t len = din->size();
+	din->PrepareForCpuAccess();
+
+	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
+	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
+
+	if(sdin)
+	{
+		auto cap = SetupSparseOutputWaveform(sdin, 0, 0, 0);
+		cap->PrepareForCpuAccess();
+		EvaluateOps(ops, sdin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len);
+		cap->MarkModifiedFromCpu();
+	}
+	else if(udin)
+	{
+		auto cap = SetupEmptyUniformAnalogOutputWaveform(udin, 0);
+		cap->Resize(len);
+		cap->PrepareForCpuAccess();
+		EvaluateOps(ops, udin->m_samples.GetCpuPointer(), cap->m_samples.GetCpuPointer(), len);
+		cap->MarkModifiedFromCpu();
+	}
+}
+
+/**
+	@brief Applies a composed chain of per-sample operations in a single pass
+
+	Intermediate values stay in registers; only the chain head input is read and only our own output
+	is written, regardless of how deep the chain is.
+ */
+void PointwiseFilter::EvaluateOps(const vector<PointwiseOp>& ops, const float* in, float* out, size_t len)
+{
+	const float* a = (const float*)__builtin_assume_aligned(in, 16);
+	float* o = (float*)__builtin_assume_aligned(out, 16);
+
+	size_t nops = ops.size();
+	const PointwiseOp* pops = &ops[0];
+
+	for(size_t i=0; i<len; i++)
+	{
+		float v = a[i];
+		for(size_t j=0; j<nops; j++)
+		{
+			switch(pops[j].m_op)
+			{
+				case PointwiseOp::OP_ADD:
+					v += pops[j].m_arg;
+					break;
+
+				case PointwiseOp::OP_NEGATE:
+					v = -v;
+					break;
+
+				case PointwiseOp::OP_CLIP_HI:
+					if(v > pops[j].m_arg)
+						v = pops[j].m_arg;
+					break;
+
+				case PointwiseOp::OP_CLIP_LO:
+					if(v < pops[j].m_arg)
+						v = pops[j].m_arg;
+					break;
+			}
+		}
+		o[i] = v;
+	}
+}
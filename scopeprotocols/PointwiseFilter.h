@@ -0,0 +1,97 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PointwiseFilter
+ */
+#ifndef PointwiseFilter_h
+#define PointwiseFilter_h
+
+/**
+	@brief Base class for cheap single-input pointwise filters (invert, clip, AC couple, etc)
+
+	Each subclass describes its per-sample operation as a PointwiseOp combinator instead of implementing its
+	own copy loop. The shared Refresh() then fuses chains: when the input is driven by another PointwiseFilter,
+	the upstream ops are collected and the composed chain is evaluated in a single pass reading directly from
+	the chain head's input waveform, with intermediate values staying in registers. Every stage of an N-deep
+	chain streams the same source buffer instead of N distinct intermediates, which matters for bandwidth-bound
+	arithmetic graphs.
+
+	Results are bit-identical to unfused evaluation since the same operations are applied in the same order.
+ */
+class PointwiseFilter : public Filter
+{
+public:
+	PointwiseFilter(const std::string& color, Category cat);
+
+	///@brief A single per-sample operation in a fused chain
+	struct PointwiseOp
+	{
+		enum op_t
+		{
+			///@brief Add m_arg to the sample
+			OP_ADD,
+
+			///@brief Negate the sample
+			OP_NEGATE,
+
+			///@brief Clip samples above m_arg to m_arg
+			OP_CLIP_HI,
+
+			///@brief Clip samples below m_arg to m_arg
+			OP_CLIP_LO
+		} m_op;
+
+		float m_arg;
+
+		PointwiseOp(op_t op, float arg = 0)
+			: m_op(op)
+			, m_arg(arg)
+		{}
+	};
+
+	virtual void Refresh() override;
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	/**
+		@brief Returns the per-sample operation this filter applies, for the current parameter values
+
+		Called once per refresh, after inputs have been validated. Implementations may inspect their
+		(already materialized) immediate input, e.g. to compute a DC offset.
+	 */
+	virtual PointwiseOp GetPointwiseOp() =0;
+
+protected:
+	void EvaluateOps(const std::vector<PointwiseOp>& ops, const float* in, float* out, size_t len);
+};
+
+#endif
@@ -100,7 +100,6 @@ void RiseMeasurement::Refresh()
 
 	//Get the input data
 	auto din = GetInputWaveform(0);
-	size_t len = din->size();
 	din->PrepareForCpuAccess();
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
@@ -119,6 +118,27 @@ void RiseMeasurement::Refresh()
 	cap->m_timescale = 1;
 	cap->PrepareForCpuAccess();
 
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sdin)
+		InnerLoop(sdin, cap, vstart, vend);
+	else
+		InnerLoop(udin, cap, vstart, vend);
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Edge timing loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and interpolation helpers resolve at
+	compile time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void RiseMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float vstart, float vend)
+{
+	size_t len = din->size();
+
 	float last = 1e20;
 	double tedge = 0;
 
@@ -130,15 +150,15 @@ void RiseMeasurement::Refresh()
 	int64_t num = 0;
 	for(size_t i=0; i < len; i++)
 	{
-		float cur = GetValue(sdin, udin, i);
-		int64_t tnow = ::GetOffsetScaled(sdin, udin, i);
+		float cur = din->m_samples[i];
+		int64_t tnow = ::GetOffsetScaled(din, i);
 
 		//Find start of edge
 		if(state == 0)
 		{
 			if( (cur > vstart) && (last <= vstart) )
 			{
-				tedge = tnow - din->m_timescale + InterpolateTime(sdin, udin, i-1, vstart)*din->m_timescale;
+				tedge = tnow - din->m_timescale + InterpolateTime(din, i-1, vstart)*din->m_timescale;
 				state = 1;
 			}
 		}
@@ -148,7 +168,7 @@ void RiseMeasurement::Refresh()
 		{
 			if( (cur > vend) && (last <= vend) )
 			{
-				double dt = InterpolateTime(sdin, udin, i-1, vend)*din->m_timescale + tnow - din->m_timescale - tedge;
+				double dt = InterpolateTime(din, i-1, vend)*din->m_timescale + tnow - din->m_timescale - tedge;
 
 				cap->m_offsets.push_back(tlast);
 				cap->m_durations.push_back(tnow-tlast);
@@ -165,8 +185,5 @@ void RiseMeasurement::Refresh()
 		last = cur;
 	}
 
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
-
 	m_streams[1].m_value = sum / num;
 }
@@ -50,6 +50,8 @@ public:
 	PROTOCOL_DECODER_INITPROC(RiseMeasurement)
 
 protected:
+	template<class W> void InnerLoop(W* din, SparseAnalogWaveform* cap, float vstart, float vend);
+
 	std::string m_startname;
 	std::string m_endname;
 };
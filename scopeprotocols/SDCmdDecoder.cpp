@@ -128,6 +128,8 @@ void SDCmdDecoder::Refresh()
 
 	int last_cmd = 0;
 	bool app_cmd = false;
+	uint8_t rawhdr = 0;
+	uint32_t rawarg = 0;
 	Packet* pack = NULL;
 	for(size_t i=0; i<len; i++)
 	{
@@ -152,7 +154,7 @@ void SDCmdDecoder::Refresh()
 						pack->m_headers.clear();
 					}
 					else
-						pack = new Packet;
+						pack = AllocatePacket();
 
 					pack->m_offset = dcmd.m_offsets[i];
 					pack->m_len = 0;
@@ -193,6 +195,13 @@ void SDCmdDecoder::Refresh()
 					cap->m_offsets.push_back(tstart);
 					cap->m_durations.push_back(end - tstart);
 
+					//Save the raw header byte (start bit, direction bit, command index) for CRC verification
+					//before we munge the command index for display
+					if(state == STATE_COMMAND_HEADER)
+						rawhdr = 0x40 | data;
+					else
+						rawhdr = data;
+
 					//If the last command was CMD55 (APP_CMD) then add 100.
 					//We code ACMD1 as 101, etc.
 					if(state == STATE_RESPONSE_HEADER)
@@ -271,6 +280,7 @@ void SDCmdDecoder::Refresh()
 					cap->m_durations.push_back(end - tstart);
 					cap->m_samples.push_back(SDCmdSymbol(SDCmdSymbol::TYPE_COMMAND_ARGS, data));
 
+					rawarg = data;
 					data = 0;
 					nbit = 0;
 					tstart = end;
@@ -322,6 +332,7 @@ void SDCmdDecoder::Refresh()
 						cap->m_durations.push_back(end - tstart);
 						cap->m_samples.push_back(SDCmdSymbol(SDCmdSymbol::TYPE_RESPONSE_ARGS, data));
 
+						rawarg = data;
 						data = 0;
 						nbit = 0;
 						tstart = end;
@@ -340,10 +351,26 @@ void SDCmdDecoder::Refresh()
 				nbit ++;
 				if(nbit == 7)
 				{
-					//TODO: verify the CRC
+					//Verify the CRC (covers the start/direction bits, command index, and argument; 4.5)
+					uint8_t crcbuf[5] =
+					{
+						rawhdr,
+						(uint8_t)(rawarg >> 24),
+						(uint8_t)(rawarg >> 16),
+						(uint8_t)(rawarg >> 8),
+						(uint8_t)(rawarg >> 0)
+					};
+					bool crc_ok = (data == CRC7(crcbuf, 5));
+
+					//ACMD41 response always has 0x7F here and not a real CRC (4.9.4)
+					if( !(rawhdr & 0x40) && (data == 0x7f) )
+						crc_ok = true;
+
+					auto type = crc_ok ? SDCmdSymbol::TYPE_CRC_OK : SDCmdSymbol::TYPE_CRC_BAD;
+
 					cap->m_offsets.push_back(tstart);
 					cap->m_durations.push_back(end - tstart);
-					cap->m_samples.push_back(SDCmdSymbol(SDCmdSymbol::TYPE_CRC_OK, data));
+					cap->m_samples.push_back(SDCmdSymbol(type, data));
 
 					state = STATE_STOP;
 				}
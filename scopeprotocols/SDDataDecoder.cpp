@@ -126,6 +126,10 @@ void SDDataDecoder::Refresh()
 	Packet* pack = NULL;
 	Packet* last_cmdbus_packet = NULL;
 
+	//Rolling cursor state for FindCommandBusPacket()
+	size_t cmdbus_search = 0;
+	Packet* cmdbus_match = NULL;
+
 	//Loop over the data and look for transactions
 	enum
 	{
@@ -162,7 +166,7 @@ void SDDataDecoder::Refresh()
 					state = STATE_DATA_HIGH;
 
 					//Find the command bus packet that triggered this data bus transaction
-					auto cmd_packet = FindCommandBusPacket(cmdbus, d0.m_offsets[i]);
+					auto cmd_packet = FindCommandBusPacket(cmdbus, d0.m_offsets[i], cmdbus_search, cmdbus_match);
 
 					//If it's the same as our last packet, or doesn't exist, don't make a new packet
 					if(cmd_packet == NULL)
@@ -321,13 +325,15 @@ vector<string> SDDataDecoder::GetHeaders()
 	return ret;
 }
 
-Packet* SDDataDecoder::FindCommandBusPacket(SDCmdDecoder* decode, int64_t timestamp)
+Packet* SDDataDecoder::FindCommandBusPacket(SDCmdDecoder* decode, int64_t timestamp, size_t& isearch, Packet*& lastMatch)
 {
-	//TODO: more efficient than linear search
-	Packet* ret = NULL;
-	auto packets = decode->GetPackets();
-	for(auto p : packets)
+	//The main decode loop queries monotonically increasing timestamps, so resume the scan where the previous
+	//call left off rather than walking the whole packet list again for every data bus transaction
+	auto& packets = decode->GetPackets();
+	for(; isearch < packets.size(); isearch++)
 	{
+		auto p = packets[isearch];
+
 		//If it's not a command, ignore it
 		if(p->m_headers["Type"] != "Command")
 			continue;
@@ -336,8 +342,7 @@ Packet* SDDataDecoder::FindCommandBusPacket(SDCmdDecoder* decode, int64_t timest
 		if(p->m_offset > timestamp)
 			break;
 
-		ret = p;
-
+		lastMatch = p;
 	}
-	return ret;
+	return lastMatch;
 }
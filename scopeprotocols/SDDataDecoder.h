@@ -93,7 +93,7 @@ public:
 	PROTOCOL_DECODER_INITPROC(SDDataDecoder)
 
 protected:
-	Packet* FindCommandBusPacket(SDCmdDecoder* decode, int64_t timestamp);
+	Packet* FindCommandBusPacket(SDCmdDecoder* decode, int64_t timestamp, size_t& isearch, Packet*& lastMatch);
 };
 
 #endif
@@ -46,6 +46,118 @@ SDRAMDecoderBase::~SDRAMDecoderBase()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Control line sampling
+
+/**
+	@brief Samples all of the command/address lines on rising edges of the clock
+
+	The clock is scanned for edges once, then each control line is sampled against the shared edge list.
+	This avoids re-walking a dense clock waveform once per control line, which dominates decode time on long
+	captures, and lets the per-line sampling run concurrently since the lines are independent of each other.
+
+	Edge timestamps use the same convention as SampleOnRisingEdges() (offset of the first high clock sample),
+	so the output is identical to sampling each line separately.
+
+	@param clk		Clock waveform. Must be sparse or uniform digital.
+	@param signals	Array of control line waveforms, each sparse or uniform digital.
+	@param samples	Array of output waveforms, one per control line.
+	@param count	Number of control lines.
+
+	@return Number of clock edges at which every control line was successfully sampled
+ */
+size_t SDRAMDecoderBase::SampleControlLines(
+	WaveformBase* clk,
+	WaveformBase** signals,
+	SparseDigitalWaveform* samples,
+	size_t count)
+{
+	//Extract the clock edge list once, rather than re-scanning the clock for every control line
+	vector<int64_t> edges;
+	auto sclk = dynamic_cast<SparseDigitalWaveform*>(clk);
+	auto uclk = dynamic_cast<UniformDigitalWaveform*>(clk);
+	if(sclk)
+	{
+		size_t len = sclk->size();
+		for(size_t i=1; i<len; i++)
+		{
+			if(sclk->m_samples[i] && !sclk->m_samples[i-1])
+				edges.push_back(GetOffsetScaled(sclk, i));
+		}
+	}
+	else if(uclk)
+	{
+		size_t len = uclk->size();
+		for(size_t i=1; i<len; i++)
+		{
+			if(uclk->m_samples[i] && !uclk->m_samples[i-1])
+				edges.push_back(GetOffsetScaled(uclk, i));
+		}
+	}
+	else
+		return 0;
+
+	//Sample each control line against the shared edge list
+	#pragma omp parallel for
+	for(size_t j=0; j<count; j++)
+	{
+		auto sdata = dynamic_cast<SparseDigitalWaveform*>(signals[j]);
+		auto udata = dynamic_cast<UniformDigitalWaveform*>(signals[j]);
+		if(sdata)
+			SampleOnEdgeList(sdata, edges, samples[j]);
+		else if(udata)
+			SampleOnEdgeList(udata, edges, samples[j]);
+	}
+
+	//A line can end early if its data runs out before the last clock edge,
+	//so only edges where every line has a sample are usable
+	size_t len = edges.size();
+	for(size_t j=0; j<count; j++)
+		len = min(len, samples[j].size());
+	return len;
+}
+
+/**
+	@brief Samples a single control line at a precomputed list of clock edge timestamps
+ */
+template<class T>
+void SDRAMDecoderBase::SampleOnEdgeList(T* data, const vector<int64_t>& edges, SparseDigitalWaveform& samples)
+{
+	samples.PrepareForCpuAccess();
+	samples.clear();
+	samples.SetGpuAccessHint(AcceleratorBuffer<bool>::HINT_NEVER);
+
+	size_t dlen = data->size();
+	size_t nedges = edges.size();
+	samples.m_offsets.reserve(nedges);
+	samples.m_samples.reserve(nedges);
+
+	size_t ndata = 0;
+	for(size_t i=0; i<nedges; i++)
+	{
+		//Throw away data samples until the data is synced with this clock edge
+		int64_t clkstart = edges[i];
+		while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
+			ndata ++;
+		if(ndata >= dlen)
+			break;
+
+		//Add the new sample
+		samples.m_offsets.push_back(clkstart);
+		samples.m_samples.push_back(data->m_samples[ndata]);
+	}
+
+	//Compute sample durations
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		FillDurationsAVX2(samples);
+	else
+	#endif
+		FillDurationsGeneric(samples);
+
+	samples.MarkModifiedFromCpu();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Pretty printing
 
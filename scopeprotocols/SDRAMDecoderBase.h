@@ -84,6 +84,16 @@ class SDRAMDecoderBase : public Filter
 public:
 	SDRAMDecoderBase(const std::string& color);
 	virtual ~SDRAMDecoderBase();
+
+protected:
+	size_t SampleControlLines(
+		WaveformBase* clk,
+		WaveformBase** signals,
+		SparseDigitalWaveform* samples,
+		size_t count);
+
+	template<class T>
+	void SampleOnEdgeList(T* data, const std::vector<int64_t>& edges, SparseDigitalWaveform& samples);
 };
 
 #endif
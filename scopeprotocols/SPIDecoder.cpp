@@ -111,6 +111,7 @@ void SPIDecoder::Refresh()
 	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
 	cap->m_triggerPhase = 0;
 	cap->PrepareForCpuAccess();
+	m_outputBuilder.Start(cap);
 
 	//TODO: different cpha/cpol modes
 
@@ -185,9 +186,7 @@ void SPIDecoder::Refresh()
 						//Add a "chip selected" event
 						if(first)
 						{
-							cap->m_offsets.push_back(bytestart);
-							cap->m_durations.push_back(timestamp - bytestart);
-							cap->m_samples.push_back(SPISymbol(SPISymbol::TYPE_SELECT, 0));
+							m_outputBuilder.Append(bytestart, timestamp - bytestart, SPISymbol(SPISymbol::TYPE_SELECT, 0));
 							first = false;
 						}
 
@@ -213,9 +212,7 @@ void SPIDecoder::Refresh()
 
 					if(bitcount == 8)
 					{
-						cap->m_offsets.push_back(bytestart);
-						cap->m_durations.push_back(timestamp - bytestart);
-						cap->m_samples.push_back(SPISymbol(SPISymbol::TYPE_DATA, current_byte));
+						m_outputBuilder.Append(bytestart, timestamp - bytestart, SPISymbol(SPISymbol::TYPE_DATA, current_byte));
 
 						bitcount = 0;
 						current_byte = 0;
@@ -227,9 +224,7 @@ void SPIDecoder::Refresh()
 				//TODO: error if a byte is truncated
 				else if(cur_cs)
 				{
-					cap->m_offsets.push_back(bytestart);
-					cap->m_durations.push_back(timestamp - bytestart);
-					cap->m_samples.push_back(SPISymbol(SPISymbol::TYPE_DESELECT, 0));
+					m_outputBuilder.Append(bytestart, timestamp - bytestart, SPISymbol(SPISymbol::TYPE_DESELECT, 0));
 
 					bytestart = timestamp;
 					state = STATE_DESELECTED;
@@ -245,9 +240,7 @@ void SPIDecoder::Refresh()
 				//TODO: error if a byte is truncated
 				else if(cur_cs)
 				{
-					cap->m_offsets.push_back(bytestart);
-					cap->m_durations.push_back(timestamp - bytestart);
-					cap->m_samples.push_back(SPISymbol(SPISymbol::TYPE_DESELECT, 0));
+					m_outputBuilder.Append(bytestart, timestamp - bytestart, SPISymbol(SPISymbol::TYPE_DESELECT, 0));
 
 					bytestart = timestamp;
 					state = STATE_DESELECTED;
@@ -272,6 +265,7 @@ void SPIDecoder::Refresh()
 		AdvanceToTimestampScaled(sdata, udata, idata, datalen, timestamp);
 	}
 
+	m_outputBuilder.Finish();
 	SetData(cap, 0);
 
 	cap->MarkModifiedFromCpu();
@@ -87,6 +87,9 @@ public:
 
 protected:
 	std::string m_cpol;
+
+	///@brief Reserves output capacity based on previous refreshes
+	SparseWaveformBuilder<SPISymbol> m_outputBuilder;
 };
 
 #endif
@@ -150,6 +150,11 @@ public:
 	virtual bool CanMerge(Packet* first, Packet* cur, Packet* next) override;
 	virtual Packet* CreateMergedHeader(Packet* pack, size_t i) override;
 
+	//Decoding a deep flash transaction stream is expensive, so retain a few previous configurations
+	//(e.g. toggling the flash type back and forth) instead of re-decoding them
+	virtual size_t GetOutputCacheDepth() override
+	{ return 4; }
+
 	PROTOCOL_DECODER_INITPROC(SPIFlashDecoder)
 
 
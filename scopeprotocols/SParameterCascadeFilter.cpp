@@ -161,23 +161,67 @@ void SParameterCascadeFilter::Refresh()
 	s21o.resize(npoints);
 	s22o.resize(npoints);
 
+	//Check if every input shares our reference frequency grid. If so, we can index each vector directly
+	//rather than re-running a binary search interpolation for all eight parameters at every point.
+	//This is the common case when all inputs come from the same Touchstone file or VNA sweep.
+	SParameterVector* vecs[8] = {&s11a, &s12a, &s21a, &s22a, &s11b, &s12b, &s21b, &s22b};
+	bool sameGrid = true;
+	for(size_t j=1; j<8; j++)
+	{
+		if(vecs[j]->size() != npoints)
+		{
+			sameGrid = false;
+			break;
+		}
+	}
+	for(size_t j=1; (j<8) && sameGrid; j++)
+	{
+		for(size_t i=0; i<npoints; i++)
+		{
+			if(vecs[j]->m_points[i].m_frequency != s11a.m_points[i].m_frequency)
+			{
+				sameGrid = false;
+				break;
+			}
+		}
+	}
+
 	//Concatenate the S-parameters
 	//(equation 2.18, page 118 of Dunsmore 2nd edition)
-	for(size_t i=0; i<npoints;i++)
+	//Each frequency point is independent, so spread them across all our cores
+	#pragma omp parallel for
+	for(int64_t i=0; i<(int64_t)npoints; i++)
 	{
 		float freq = s11a.m_points[i].m_frequency;
 
-		//Interpolate all inputs to our current frequency bin
-		//and convert from our default mag/angle representation to real/imaginary
-		auto p11a = s11a.InterpolatePoint(freq).ToComplex();
-		auto p12a = s12a.InterpolatePoint(freq).ToComplex();
-		auto p21a = s21a.InterpolatePoint(freq).ToComplex();
-		auto p22a = s22a.InterpolatePoint(freq).ToComplex();
-
-		auto p11b = s11b.InterpolatePoint(freq).ToComplex();
-		auto p12b = s12b.InterpolatePoint(freq).ToComplex();
-		auto p21b = s21b.InterpolatePoint(freq).ToComplex();
-		auto p22b = s22b.InterpolatePoint(freq).ToComplex();
+		//Convert from our default mag/angle representation to real/imaginary,
+		//interpolating to our current frequency bin if the grids don't line up
+		complex<float> p11a, p12a, p21a, p22a;
+		complex<float> p11b, p12b, p21b, p22b;
+		if(sameGrid)
+		{
+			p11a = s11a.m_points[i].ToComplex();
+			p12a = s12a.m_points[i].ToComplex();
+			p21a = s21a.m_points[i].ToComplex();
+			p22a = s22a.m_points[i].ToComplex();
+
+			p11b = s11b.m_points[i].ToComplex();
+			p12b = s12b.m_points[i].ToComplex();
+			p21b = s21b.m_points[i].ToComplex();
+			p22b = s22b.m_points[i].ToComplex();
+		}
+		else
+		{
+			p11a = s11a.InterpolatePoint(freq).ToComplex();
+			p12a = s12a.InterpolatePoint(freq).ToComplex();
+			p21a = s21a.InterpolatePoint(freq).ToComplex();
+			p22a = s22a.InterpolatePoint(freq).ToComplex();
+
+			p11b = s11b.InterpolatePoint(freq).ToComplex();
+			p12b = s12b.InterpolatePoint(freq).ToComplex();
+			p21b = s21b.InterpolatePoint(freq).ToComplex();
+			p22b = s22b.InterpolatePoint(freq).ToComplex();
+		}
 
 		//Do the actual math
 		auto one = complex<float>(1, 0);
@@ -112,6 +112,124 @@ void SWDDecoder::Refresh()
 	samples.PrepareForCpuAccess();
 	SampleOnRisingEdgesBase(data, clk, samples);
 
+	size_t len = samples.size();
+
+	//The protocol state machine is serial, but a line reset (c_reset_minseqlen or more consecutive 1 bits)
+	//re-synchronizes it completely: decode state immediately after one is known no matter what came before.
+	//For long captures, find those re-sync points up front and decode the stretches between them in parallel.
+	const size_t MIN_BLOCK = 1000000;
+	vector<size_t> starts;
+	starts.push_back(0);
+	if(len >= 2*MIN_BLOCK)
+	{
+		vector<size_t> resets;
+		FindLineResets(samples, resets);
+
+		//Keep blocks comfortably large so per-block overhead stays negligible
+		for(auto r : resets)
+		{
+			if(r >= starts.back() + MIN_BLOCK)
+				starts.push_back(r);
+		}
+	}
+
+	//Decode each block independently (every block but the first begins with a line reset)
+	size_t nblocks = starts.size();
+	vector<vector<int64_t>> offsets(nblocks);
+	vector<vector<int64_t>> durations(nblocks);
+	vector<vector<SWDSymbol>> symbols(nblocks);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(size_t b=0; b<nblocks; b++)
+	{
+		size_t iend = (b+1 < nblocks) ? starts[b+1] : len;
+		DecodeRange(samples, starts[b], iend, offsets[b], durations[b], symbols[b]);
+	}
+
+	//Concatenate the per-block output into the final waveform
+	size_t total = 0;
+	vector<size_t> blockStart(nblocks);
+	for(size_t b=0; b<nblocks; b++)
+	{
+		blockStart[b] = total;
+		total += offsets[b].size();
+	}
+	cap->Resize(total);
+
+	#pragma omp parallel for
+	for(size_t b=0; b<nblocks; b++)
+	{
+		size_t base = blockStart[b];
+		for(size_t i=0; i<offsets[b].size(); i++)
+		{
+			cap->m_offsets[base + i] = offsets[b][i];
+			cap->m_durations[base + i] = durations[b][i];
+			cap->m_samples[base + i] = symbols[b][i];
+		}
+	}
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Finds the starting indices of all line resets (runs of c_reset_minseqlen or more 1 bits) in the sampled bitstream
+
+	Each run is only reported once, at the index of its first bit.
+ */
+void SWDDecoder::FindLineResets(SparseDigitalWaveform& samples, vector<size_t>& starts)
+{
+	size_t len = samples.size();
+
+	const size_t CHUNK = 1024 * 1024;
+	size_t nchunks = (len + CHUNK - 1) / CHUNK;
+	vector<vector<size_t>> found(nchunks);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(size_t c=0; c<nchunks; c++)
+	{
+		size_t cstart = c * CHUNK;
+		size_t cend = min(cstart + CHUNK, len);
+		for(size_t i=cstart; i<cend; i++)
+		{
+			//Only consider the first bit of a maximal run of 1s
+			//(runs may extend past the end of our chunk, which is fine: the input is shared and read only)
+			if(!samples.m_samples[i])
+				continue;
+			if( (i > 0) && samples.m_samples[i-1])
+				continue;
+
+			size_t run = 0;
+			while( ((i + run) < len) && (run < c_reset_minseqlen) && samples.m_samples[i + run])
+				run++;
+			if(run >= c_reset_minseqlen)
+				found[c].push_back(i);
+		}
+	}
+
+	for(size_t c=0; c<nchunks; c++)
+	{
+		for(auto f : found[c])
+			starts.push_back(f);
+	}
+}
+
+/**
+	@brief Runs the protocol state machine over part of the sampled bitstream, appending decoded symbols to the supplied buffers
+
+	Decode state is assumed idle at ibegin, so a range must start either at the beginning of the capture or at the
+	first bit of a line reset (where the state machine re-synchronizes regardless of what preceded it). Forward scans
+	for resets, mode changes and dormant wakeups may read past iend, but never past the end of the capture.
+ */
+void SWDDecoder::DecodeRange(
+	SparseDigitalWaveform& samples,
+	size_t ibegin,
+	size_t iend,
+	vector<int64_t>& offsets,
+	vector<int64_t>& durations,
+	vector<SWDSymbol>& symbols)
+{
 	//Loop over the data and look for transactions
 	enum
 	{
@@ -142,7 +260,7 @@ void SWDDecoder::Refresh()
 	int64_t off;
 	int32_t parity = 0;
 
-	for(size_t i = 0; i < len; i++)
+	for(size_t i = ibegin; i < iend; i++)
 	{
 		//Offset sample from the clock so it's aligned to the data
 		dur = samples.m_durations[i];
@@ -152,7 +270,7 @@ void SWDDecoder::Refresh()
 		if(!ticks_to_zero)
 		{
 			uint64_t stateLen = 0;
-			while((samples.m_samples[i + ticks_to_zero]) && (i + ticks_to_zero < len))
+			while(((i + ticks_to_zero) < len) && samples.m_samples[i + ticks_to_zero])
 			{
 				stateLen += samples.m_durations[i + ticks_to_zero];
 				ticks_to_zero++;
@@ -161,31 +279,38 @@ void SWDDecoder::Refresh()
 			if(ticks_to_zero >= c_reset_minseqlen)
 			{
 				// Yep, this is a line reset, label it as such
-				cap->m_offsets.push_back(off);
-				cap->m_durations.push_back(stateLen);
+				offsets.push_back(off);
+				durations.push_back(stateLen);
 				tstart = off + dur;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_LINERESET, 0));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_LINERESET, 0));
 				state = STATE_IDLE;
 				i += ticks_to_zero;
 				ticks_to_zero = 0;
 
+				//Stop if the reset ran all the way to the end of the capture
+				if(i >= iend)
+					break;
+
 				// After a reset there can be a mode-change, so check for that
 				dur = samples.m_durations[i];
 				off = samples.m_offsets[i] - dur / 2;
 				current_word = 0;
 				stateLen = 0;
-				for(uint32_t it = 0; it < c_magic_seqlen; it++)
+				if((i + c_magic_seqlen) <= len)
 				{
-					current_word = (current_word >> 1) | (samples.m_samples[i + it] ? (1 << (c_magic_seqlen - 1)) : 0);
-					stateLen += samples.m_durations[i + it];
+					for(uint32_t it = 0; it < c_magic_seqlen; it++)
+					{
+						current_word = (current_word >> 1) | (samples.m_samples[i + it] ? (1 << (c_magic_seqlen - 1)) : 0);
+						stateLen += samples.m_durations[i + it];
+					}
 				}
 
 				if((current_word == c_JTAG_TO_SWD_SEQ) || (current_word == c_SWD_TO_JTAG_SEQ) ||
 					(current_word == c_SWD_TO_DORMANT_SEQ))
 				{
 					// This is a line state change
-					cap->m_offsets.push_back(off);
-					cap->m_durations.push_back(stateLen);
+					offsets.push_back(off);
+					durations.push_back(stateLen);
 					tstart = off + dur;
 					i += c_magic_seqlen - 1;
 					dur = samples.m_durations[i];
@@ -194,15 +319,15 @@ void SWDDecoder::Refresh()
 					switch(current_word)
 					{
 						case c_JTAG_TO_SWD_SEQ:
-							cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_JTAGTOSWD, 0));
+							symbols.push_back(SWDSymbol(SWDSymbol::TYPE_JTAGTOSWD, 0));
 							break;
 
 						case c_SWD_TO_JTAG_SEQ:
-							cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_SWDTOJTAG, 0));
+							symbols.push_back(SWDSymbol(SWDSymbol::TYPE_SWDTOJTAG, 0));
 							break;
 
 						case c_SWD_TO_DORMANT_SEQ:
-							cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_SWDTODORMANT, 0));
+							symbols.push_back(SWDSymbol(SWDSymbol::TYPE_SWDTODORMANT, 0));
 							break;
 
 						default:
@@ -219,17 +344,17 @@ void SWDDecoder::Refresh()
 		// Finally, check we're not being pulled out of dormant mode...
 		// just slide along the wakeup sequence and see if we make it to the other end
 		uint32_t dindex = 0;
-		while((dindex < c_magic_wakeuplen) &&
+		while((dindex < c_magic_wakeuplen) && ((i + dindex) < len) &&
 			  samples.m_samples[i + dindex] == (((c_wakeup[dindex / 8]) & (1 << (dindex % 8))) != 0))
 			dindex++;
 
 		if(dindex == c_magic_wakeuplen)
 		{
 			// This _is_ a wakeup sequence, label it
-			cap->m_offsets.push_back(off);
-			cap->m_durations.push_back(dur * c_magic_wakeuplen);
+			offsets.push_back(off);
+			durations.push_back(dur * c_magic_wakeuplen);
 			tstart = off + dur;
-			cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_LEAVEDORMANT, 0));
+			symbols.push_back(SWDSymbol(SWDSymbol::TYPE_LEAVEDORMANT, 0));
 			state = STATE_IDLE;
 			i += c_magic_wakeuplen;
 			ticks_to_zero = 0;
@@ -244,11 +369,11 @@ void SWDDecoder::Refresh()
 				{
 					state = STATE_AP_DP;
 
-					cap->m_offsets.push_back(off);
-					cap->m_durations.push_back(dur);
+					offsets.push_back(off);
+					durations.push_back(dur);
 					tstart = off + dur;
 					parity = 0;
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_START, 0));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_START, 0));
 				}
 
 				//ignore clocks with SWDIO at 0
@@ -256,20 +381,20 @@ void SWDDecoder::Refresh()
 
 			case STATE_AP_DP:
 				state = STATE_R_W;
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
 				parity = samples.m_samples[i] ? !parity : parity;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_AP_NDP, samples.m_samples[i]));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_AP_NDP, samples.m_samples[i]));
 				break;
 
 			case STATE_R_W:
 				state = STATE_ADDRESS;
 
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				parity = samples.m_samples[i] ? !parity : parity;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_R_NW, samples.m_samples[i]));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_R_NW, samples.m_samples[i]));
 
 				current_word = 0;
 				bitcount = 0;
@@ -291,9 +416,9 @@ void SWDDecoder::Refresh()
 
 				if(bitcount == 2)
 				{
-					cap->m_offsets.push_back(tstart);
-					cap->m_durations.push_back((off + dur) - tstart);
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_ADDRESS, current_word >> 28));
+					offsets.push_back(tstart);
+					durations.push_back((off + dur) - tstart);
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_ADDRESS, current_word >> 28));
 
 					state = STATE_ADDR_PARITY;
 
@@ -304,43 +429,43 @@ void SWDDecoder::Refresh()
 
 			case STATE_ADDR_PARITY:
 				state = STATE_STOP;
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
 				if(samples.m_samples[i] == parity)
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_OK, samples.m_samples[i]));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_OK, samples.m_samples[i]));
 				else
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_BAD, samples.m_samples[i]));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_BAD, samples.m_samples[i]));
 				break;
 
 			case STATE_STOP:
 				state = STATE_PARK;
 
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
 
 				//Stop bit should be a 0
 				if(!samples.m_samples[i])
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_STOP, 0));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_STOP, 0));
 				else
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_ERROR, 0));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_ERROR, 0));
 				break;
 
 			case STATE_PARK:
 				state = STATE_TURNAROUND;
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_PARK, samples.m_samples[i]));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_PARK, samples.m_samples[i]));
 				break;
 
 			case STATE_TURNAROUND:
 				state = STATE_ACK;
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
 
 				current_word = 0;
 				bitcount = 0;
@@ -356,9 +481,9 @@ void SWDDecoder::Refresh()
 				if(bitcount == 3)
 				{
 					parity = 0;
-					cap->m_offsets.push_back(tstart);
-					cap->m_durations.push_back((off + dur) - tstart);
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_ACK, current_word >> 29));
+					offsets.push_back(tstart);
+					durations.push_back((off + dur) - tstart);
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_ACK, current_word >> 29));
 
 					// Only proceed to reading or writing phase if we got an 'OK' response
 					// Otherwise line gets turned around for writing again
@@ -376,10 +501,10 @@ void SWDDecoder::Refresh()
 
 			case STATE_WRITE_TURNAROUND:
 				state = STATE_DATA;
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(dur);
+				offsets.push_back(tstart);
+				durations.push_back(dur);
 				tstart += dur;
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
 
 				current_word = 0;
 				bitcount = 0;
@@ -395,9 +520,9 @@ void SWDDecoder::Refresh()
 
 				if(bitcount == 32)
 				{
-					cap->m_offsets.push_back(tstart);
-					cap->m_durations.push_back((off + dur) - tstart);
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_DATA, current_word));
+					offsets.push_back(tstart);
+					durations.push_back((off + dur) - tstart);
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_DATA, current_word));
 
 					state = STATE_DATA_PARITY;
 
@@ -406,13 +531,13 @@ void SWDDecoder::Refresh()
 				break;
 
 			case STATE_DATA_PARITY:
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(min(dur, last_dur));	   //clock may stop between packets, don't extend sample
+				offsets.push_back(tstart);
+				durations.push_back(min(dur, last_dur));	   //clock may stop between packets, don't extend sample
 
 				if(samples.m_samples[i] == parity)
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_OK, samples.m_samples[i]));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_OK, samples.m_samples[i]));
 				else
-					cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_BAD, samples.m_samples[i]));
+					symbols.push_back(SWDSymbol(SWDSymbol::TYPE_PARITY_BAD, samples.m_samples[i]));
 				tstart += dur;
 
 				if(!writing)
@@ -427,17 +552,14 @@ void SWDDecoder::Refresh()
 			case STATE_READ_TURNAROUND:
 				state = STATE_IDLE;
 
-				cap->m_offsets.push_back(tstart);
-				cap->m_durations.push_back(last_dur);
-				cap->m_samples.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
+				offsets.push_back(tstart);
+				durations.push_back(last_dur);
+				symbols.push_back(SWDSymbol(SWDSymbol::TYPE_TURNAROUND, samples.m_samples[i]));
 				break;
 		}
 
 		last_dur = dur;
 	}
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
 }
 
 std::string SWDWaveform::GetColor(size_t i)
@@ -100,6 +100,17 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
 	PROTOCOL_DECODER_INITPROC(SWDDecoder)
+
+protected:
+	static void FindLineResets(SparseDigitalWaveform& samples, std::vector<size_t>& starts);
+
+	void DecodeRange(
+		SparseDigitalWaveform& samples,
+		size_t ibegin,
+		size_t iend,
+		std::vector<int64_t>& offsets,
+		std::vector<int64_t>& durations,
+		std::vector<SWDSymbol>& symbols);
 };
 
 #endif
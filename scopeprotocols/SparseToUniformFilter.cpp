@@ -0,0 +1,236 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#include "../scopehal/scopehal.h"
+#include "SparseToUniformFilter.h"
+
+#include <cinttypes>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SparseToUniformFilter::SparseToUniformFilter(const string& color)
+	: Filter(color, CAT_MATH)
+	, m_computePipeline("shaders/SparseToUniform.spv", 4, sizeof(SparseToUniformFilterArgs))
+{
+	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
+	CreateInput("din");
+
+	m_modeName = "Timebase";
+	m_parameters[m_modeName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_modeName].AddEnumValue("Auto (shortest sample)", MODE_AUTO);
+	m_parameters[m_modeName].AddEnumValue("Fixed rate", MODE_FIXED);
+	m_parameters[m_modeName].SetIntVal(MODE_AUTO);
+
+	m_rateName = "Sample rate";
+	m_parameters[m_rateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLERATE));
+	m_parameters[m_rateName].SetIntVal(100 * 1000L * 1000L);
+
+	m_fillName = "Fill policy";
+	m_parameters[m_fillName] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_fillName].AddEnumValue("Hold last value", FILL_HOLD);
+	m_parameters[m_fillName].AddEnumValue("Zero", FILL_ZERO);
+	m_parameters[m_fillName].AddEnumValue("NaN", FILL_NAN);
+	m_parameters[m_fillName].SetIntVal(FILL_HOLD);
+
+	//Use pinned memory for the segment index tables
+	m_segStarts.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segStarts.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segEnds.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segEnds.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool SparseToUniformFilter::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) && (stream.GetType() == Stream::STREAM_TYPE_ANALOG) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string SparseToUniformFilter::GetProtocolName()
+{
+	return "Sparse To Uniform";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void SparseToUniformFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
+{
+	//Get the input data. We're a sparse-to-uniform bridge, so fail if the input is already uniform.
+	auto din = dynamic_cast<SparseAnalogWaveform*>(GetInputWaveform(0));
+	if(!din || (din->size() == 0))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+	auto len = din->size();
+	din->PrepareForCpuAccess();
+
+	//Extract parameters
+	auto mode = static_cast<TimebaseMode>(m_parameters[m_modeName].GetIntVal());
+	auto fill = static_cast<FillPolicy>(m_parameters[m_fillName].GetIntVal());
+
+	SetYAxisUnits(m_inputs[0].GetYAxisUnits(), 0);
+
+	//Pick the output timescale: explicit sample rate, or the shortest sample duration in the input
+	//(so even the shortest sample lands on at least one output tick)
+	int64_t outscale;
+	if(mode == MODE_FIXED)
+	{
+		int64_t rate = m_parameters[m_rateName].GetIntVal();
+		if(rate <= 0)
+		{
+			SetData(NULL, 0);
+			return;
+		}
+		outscale = FS_PER_SECOND / rate;
+	}
+	else
+	{
+		int64_t mindur = 0;
+		for(size_t i=0; i<len; i++)
+		{
+			auto dur = din->m_durations[i];
+			if( (dur > 0) && ( (mindur == 0) || (dur < mindur) ) )
+				mindur = dur;
+		}
+
+		//Degenerate input with no nonzero durations: use unit duration
+		if(mindur == 0)
+			mindur = 1;
+
+		outscale = mindur * din->m_timescale;
+	}
+	if(outscale <= 0)
+		outscale = 1;
+
+	//Convert each input sample's start and duration-end to output sample indexes.
+	//The output timebase starts at the first input sample; the offset to the trigger moves into m_triggerPhase.
+	int64_t tbase = din->m_offsets[0];
+	int64_t outlen64 = ( (din->m_offsets[len-1] + din->m_durations[len-1] - tbase) * din->m_timescale ) / outscale;
+	if( (outlen64 <= 0) || (outlen64 > 0xffffffffLL) )
+	{
+		if(outlen64 > 0xffffffffLL)
+			LogWarning("SparseToUniformFilter: output of %" PRId64 " samples is too large, pick a lower sample rate\n",
+				outlen64);
+		SetData(NULL, 0);
+		return;
+	}
+	size_t outlen = outlen64;
+
+	m_segStarts.resize(len);
+	m_segEnds.resize(len);
+	m_segStarts.PrepareForCpuAccess();
+	m_segEnds.PrepareForCpuAccess();
+	#pragma omp parallel for
+	for(size_t i=0; i<len; i++)
+	{
+		m_segStarts[i] = ( (din->m_offsets[i] - tbase) * din->m_timescale ) / outscale;
+		m_segEnds[i] = ( (din->m_offsets[i] + din->m_durations[i] - tbase) * din->m_timescale ) / outscale;
+	}
+	m_segStarts.MarkModifiedFromCpu();
+	m_segEnds.MarkModifiedFromCpu();
+
+	//Create the output and configure it
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
+	cap->m_timescale = outscale;
+	cap->m_triggerPhase = din->m_triggerPhase + tbase * din->m_timescale;
+	cap->Resize(outlen);
+
+	if(g_gpuFilterEnabled)
+	{
+		cmdBuf.begin({});
+
+		//Update our descriptor sets with current buffers
+		m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(1, m_segStarts, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(2, m_segEnds, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(3, cap->m_samples, cmdBuf, true);
+
+		SparseToUniformFilterArgs args;
+		args.nsamples = outlen;
+		args.nsegments = len;
+		args.fillPolicy = fill;
+
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(outlen, 64));
+
+		//Done, submit to the queue and wait
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+		cap->MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		cap->PrepareForCpuAccess();
+
+		float fillValue = 0;
+		if(fill == FILL_NAN)
+			fillValue = numeric_limits<float>::quiet_NaN();
+
+		//Each input sample owns the output range up to the start of the next one, so the writes are disjoint
+		//and we can parallelize over input samples
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			size_t start = m_segStarts[i];
+			size_t next = (i+1 < len) ? m_segStarts[i+1] : outlen;
+			size_t end = min((size_t)m_segEnds[i], next);
+			float v = din->m_samples[i];
+
+			for(size_t j=start; j<end; j++)
+				cap->m_samples[j] = v;
+
+			float f = (fill == FILL_HOLD) ? v : fillValue;
+			for(size_t j=end; j<next; j++)
+				cap->m_samples[j] = f;
+		}
+
+		cap->MarkModifiedFromCpu();
+	}
+}
+
+Filter::DataLocation SparseToUniformFilter::GetInputLocation()
+{
+	//We explicitly manage our input memory and don't care where it is when Refresh() is called
+	return LOC_DONTCARE;
+}
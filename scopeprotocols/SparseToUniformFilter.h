@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of SparseToUniformFilter
+ */
+#ifndef SparseToUniformFilter_h
+#define SparseToUniformFilter_h
+
+class QueueHandle;
+
+struct SparseToUniformFilterArgs
+{
+	uint32_t nsamples;
+	uint32_t nsegments;
+	uint32_t fillPolicy;
+};
+
+/**
+	@brief Resamples a sparse analog waveform onto a uniform timebase
+
+	Bridge for feeding sparse decoder outputs (clock recovery, eye slicers, measurement trains, etc) to filters that
+	require uniform input, such as the FFT family. Each sparse sample is painted across the output ticks covered by
+	its duration; the gaps in between are filled according to a configurable policy (hold last value, zero, or NaN).
+ */
+class SparseToUniformFilter : public Filter
+{
+public:
+	SparseToUniformFilter(const std::string& color);
+
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
+	virtual DataLocation GetInputLocation() override;
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
+
+	PROTOCOL_DECODER_INITPROC(SparseToUniformFilter)
+
+protected:
+	enum TimebaseMode
+	{
+		MODE_AUTO,
+		MODE_FIXED
+	};
+
+	enum FillPolicy
+	{
+		FILL_HOLD,
+		FILL_ZERO,
+		FILL_NAN
+	};
+
+	std::string m_modeName;
+	std::string m_rateName;
+	std::string m_fillName;
+
+	///@brief Output sample index at which each input sample begins
+	AcceleratorBuffer<uint32_t> m_segStarts;
+
+	///@brief Output sample index at which each input sample's duration ends
+	AcceleratorBuffer<uint32_t> m_segEnds;
+
+	ComputePipeline m_computePipeline;
+};
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "../scopehal/AlignedAllocator.h"
+#include "../scopehal/VulkanFFTPlanPool.h"
 #include "SpectrogramFilter.h"
 #include "FFTFilter.h"
 
@@ -59,13 +60,20 @@ SpectrogramFilter::SpectrogramFilter(const string& color)
 	, m_fftLengthName("FFT length")
 	, m_rangeMinName("Range Min")
 	, m_rangeMaxName("Range Max")
-	, m_blackmanHarrisComputePipeline("shaders/BlackmanHarrisWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_rectangularComputePipeline("shaders/RectangularWindow.spv", 2, sizeof(WindowFunctionArgs))
-	, m_cosineSumComputePipeline("shaders/CosineSumWindow.spv", 2, sizeof(WindowFunctionArgs))
+	, m_blackmanHarrisComputePipeline("shaders/BatchedBlackmanHarrisWindow.spv", 2, sizeof(BatchedWindowFunctionArgs))
+	, m_rectangularComputePipeline("shaders/BatchedRectangularWindow.spv", 2, sizeof(BatchedWindowFunctionArgs))
+	, m_hannComputePipeline("shaders/BatchedCosineSumWindow.spv", 2, sizeof(BatchedWindowFunctionArgs))
+	, m_hammingComputePipeline("shaders/BatchedCosineSumWindow.spv", 2, sizeof(BatchedWindowFunctionArgs))
 	, m_postprocessComputePipeline("shaders/SpectrogramPostprocess.spv", 2, sizeof(SpectrogramPostprocessArgs))
 {
 	AddStream(Unit(Unit::UNIT_HZ), "data", Stream::STREAM_TYPE_SPECTROGRAM);
 
+	//Bake the cosine-sum window coefficients in as specialization constants, one pipeline per window type,
+	//so they're compile time constants in the shader rather than per-invocation push constant loads
+	const float hammingAlpha0 = 25.0f / 46;
+	m_hannComputePipeline.SetSpecializationConstants(vector<float>{0.5f, 0.5f});
+	m_hammingComputePipeline.SetSpecializationConstants(vector<float>{hammingAlpha0, 1 - hammingAlpha0});
+
 	//Set up channels
 	CreateInput("din");
 
@@ -156,15 +164,6 @@ void SpectrogramFilter::ReallocateBuffers(size_t fftlen, size_t nblocks)
 	m_cachedFFTLength = fftlen;
 	m_cachedFFTNumBlocks = nblocks;
 
-	size_t nouts = fftlen/2 + 1;
-	if(m_vkPlan)
-	{
-		if(m_vkPlan->size() != fftlen)
-			m_vkPlan = nullptr;
-	}
-	if(!m_vkPlan)
-		m_vkPlan = make_unique<VulkanFFTPlan>(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
-
 	m_rdinbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
 	m_rdinbuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_rdoutbuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
@@ -264,25 +263,17 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	}
 
 	//Configure the window
-	WindowFunctionArgs args;
-	args.numActualSamples = fftlen;
+	//All blocks are fully populated (the trailing partial block, if any, was truncated)
+	//so we can window every block in a single 2D dispatch
+	BatchedWindowFunctionArgs args;
 	args.npoints = fftlen;
+	args.nblocks = nblocks;
+	args.ygrid = min(g_maxComputeGroupCount[2], nblocks);
 	args.scale = 2 * M_PI / fftlen;
-	switch(window)
-	{
-		case FFTFilter::WINDOW_HANN:
-			args.alpha0 = 0.5;
-			break;
 
-		case FFTFilter::WINDOW_HAMMING:
-			args.alpha0 = 25.0f / 46;
-			break;
-
-		default:
-			args.alpha0 = 0;
-			break;
-	}
-	args.alpha1 = 1 - args.alpha0;
+	//Cosine-sum coefficients are baked into the specialized pipelines, so nothing window specific goes here
+	args.alpha0 = 0;
+	args.alpha1 = 0;
 
 	//Figure out which window shader to use
 	ComputePipeline* wpipe = nullptr;
@@ -293,8 +284,11 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 			break;
 
 		case FFTFilter::WINDOW_HANN:
+			wpipe = &m_hannComputePipeline;
+			break;
+
 		case FFTFilter::WINDOW_HAMMING:
-			wpipe = &m_cosineSumComputePipeline;
+			wpipe = &m_hammingComputePipeline;
 			break;
 
 		default:
@@ -315,23 +309,22 @@ void SpectrogramFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<Queu
 	//Prepare to do all of our compute stuff in one dispatch call to reduce overhead
 	cmdBuf.begin({});
 
-	//Grab the input and apply the window function
+	//Grab the input and apply the window function to all blocks in one dispatch
 	wpipe->BindBufferNonblocking(0, din->m_samples, cmdBuf);
 	wpipe->BindBufferNonblocking(1, m_rdinbuf, cmdBuf, true);
-	for(size_t block=0; block<nblocks; block++)
-	{
-		args.offsetIn = block*fftlen;
-		args.offsetOut = block*fftlen;
-
-		if(block == 0)
-			wpipe->Dispatch(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-		else
-			wpipe->DispatchNoRebind(cmdBuf, args, GetComputeBlockCount(fftlen, 64));
-	}
+	wpipe->Dispatch(
+		cmdBuf,
+		args,
+		GetComputeBlockCount(fftlen, 64),
+		ceil(nblocks * 1.0 / args.ygrid),
+		args.ygrid
+		);
 	wpipe->AddComputeMemoryBarrier(cmdBuf);
 
 	//Do the actual FFT
-	m_vkPlan->AppendForward(
+	//(the plan is checked out of the shared pool until we've finished waiting on the GPU below)
+	auto plan = VulkanFFTPlanPool::GetInstance().Acquire(fftlen, nouts, VulkanFFTPlan::DIRECTION_FORWARD, nblocks);
+	plan->AppendForward(
 		m_rdinbuf,
 		m_rdoutbuf,
 		cmdBuf);
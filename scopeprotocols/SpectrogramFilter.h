@@ -55,6 +55,20 @@ struct SpectrogramPostprocessArgs
 	float irange;
 };
 
+/**
+	@brief Arguments passed to the batched window function shaders, which window all FFT blocks in one dispatch
+	@ingroup rf
+ */
+struct BatchedWindowFunctionArgs
+{
+	uint32_t npoints;
+	uint32_t nblocks;
+	uint32_t ygrid;
+	float scale;
+	float alpha0;
+	float alpha1;
+};
+
 /**
 	@brief Waveform object for a spectrogram
 	@ingroup datamodel
@@ -127,11 +141,10 @@ protected:
 	std::string m_rangeMinName;
 	std::string m_rangeMaxName;
 
-	std::unique_ptr<VulkanFFTPlan> m_vkPlan;
-
 	ComputePipeline m_blackmanHarrisComputePipeline;
 	ComputePipeline m_rectangularComputePipeline;
-	ComputePipeline m_cosineSumComputePipeline;
+	ComputePipeline m_hannComputePipeline;
+	ComputePipeline m_hammingComputePipeline;
 
 	ComputePipeline m_postprocessComputePipeline;
 };
@@ -240,3 +240,9 @@ Filter::DataLocation SubtractFilter::GetInputLocation()
 	//We explicitly manage our input memory and don't care where it is when Refresh() is called
 	return LOC_DONTCARE;
 }
+
+bool SubtractFilter::IsDeferredSubmitSafe()
+{
+	//The GPU path never reads results back within Refresh(), so the executor may defer our fence wait
+	return true;
+}
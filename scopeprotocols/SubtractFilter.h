@@ -53,6 +53,7 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 	virtual DataLocation GetInputLocation() override;
+	virtual bool IsDeferredSubmitSafe() override;
 
 	static std::string GetProtocolName();
 
@@ -31,6 +31,12 @@
 #include "../scopehal/LeCroyOscilloscope.h"
 #include "TRCImportFilter.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +44,20 @@ using namespace std;
 
 TRCImportFilter::TRCImportFilter(const string& color)
 	: ImportFilter(color)
+	, m_samplesLoaded(true)
+	, m_dataOffset(0)
+	, m_numSamples(0)
+	, m_hdMode(false)
+	, m_gain(1)
+	, m_voff(0)
+	, m_pendingTimescale(0)
+	, m_pendingTimestamp(0)
+	, m_pendingStartFemtoseconds(0)
+	, m_pendingTriggerPhase(0)
+#ifndef _WIN32
+	, m_mapping(nullptr)
+	, m_mapLen(0)
+#endif
 {
 	m_fpname = "TRC File";
 	m_parameters[m_fpname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
@@ -70,6 +90,8 @@ TRCImportFilter::TRCImportFilter(const string& color)
 
 TRCImportFilter::~TRCImportFilter()
 {
+	CloseMapping();
+
 	m_commandBuffer = nullptr;
 	m_commandPool = nullptr;
 }
@@ -85,6 +107,13 @@ string TRCImportFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Parses the WAVEDESC and sets up lazy loading of the sample data
+
+	Only the first few hundred bytes of the file are read here, so opening a session referencing
+	many large .trc files is fast. The sample data is memory mapped and converted by the first
+	Refresh() that actually evaluates this filter.
+ */
 void TRCImportFilter::OnFileNameChanged()
 {
 	auto fname = m_parameters[m_fpname].ToString();
@@ -94,6 +123,11 @@ void TRCImportFilter::OnFileNameChanged()
 	LogTrace("Loading TRC waveform %s\n", fname.c_str());
 	LogIndenter li;
 
+	//Drop any stale state from a previously loaded file
+	CloseMapping();
+	m_numSamples = 0;
+	m_samplesLoaded = true;
+
 	FILE* fp = fopen(fname.c_str(), "rb");
 	if(!fp)
 	{
@@ -103,6 +137,7 @@ void TRCImportFilter::OnFileNameChanged()
 
 	//Read the SCPI file length header
 	//Expect #9 followed by 9 digit ASCII length
+	size_t headerLen = 11;
 	char header[13] = {0};
 	if(11 != fread(header, 1, 11, fp))
 	{
@@ -121,6 +156,7 @@ void TRCImportFilter::OnFileNameChanged()
 				fclose(fp);
 				return;
 			}
+			headerLen = 12;
 		}
 
 		else
@@ -209,127 +245,181 @@ void TRCImportFilter::OnFileNameChanged()
 		num_samples = datalen;
 	size_t num_per_segment = num_samples /* / num_sequences*/;
 
+	//Save the lazy load state; the samples are converted by the first Refresh() that evaluates us
+	m_pendingFileName = fname;
+	m_dataOffset = headerLen + wavedescSize;
+	m_numSamples = num_per_segment;
+	m_hdMode = hdMode;
+	m_gain = v_gain;
+	m_voff = v_off;
+	m_pendingTimescale = round(interval);
+	m_pendingTimestamp = ttime;
+	m_pendingStartFemtoseconds = basetime * FS_PER_SECOND;
+	m_pendingTriggerPhase = h_off_frac;
+	m_samplesLoaded = false;
+	LogTrace("Sample interval: %s\n", Unit(Unit::UNIT_FS).PrettyPrint(m_pendingTimescale).c_str());
+	LogTrace("Trigger phase: %s\n", Unit(Unit::UNIT_FS).PrettyPrint(m_pendingTriggerPhase).c_str());
+
+	//Memory map the file so materialization can convert straight out of the page cache
+	//with no staging copy. If mapping fails we fall back to a buffered read in LoadSamples().
+	#ifndef _WIN32
+	int fd = fileno(fp);
+	size_t maplen = headerLen + len;
+	void* mapping = mmap(nullptr, maplen, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(mapping != MAP_FAILED)
+	{
+		m_mapping = mapping;
+		m_mapLen = maplen;
+
+		//We'll stream through the samples front to back exactly once
+		madvise(m_mapping, m_mapLen, MADV_SEQUENTIAL);
+	}
+	#endif
+
+	//Old waveform (if any) no longer matches the file
+	SetData(nullptr, 0);
+
+	fclose(fp);
+}
+
+/**
+	@brief Materializes the sample data on first use
+ */
+void TRCImportFilter::Refresh()
+{
+	//Waveform data is static once loaded; the only work is faulting in the lazy load
+	if(!m_samplesLoaded)
+		LoadSamples();
+}
+
+/**
+	@brief Converts the file's sample data to the output waveform
+ */
+void TRCImportFilter::LoadSamples()
+{
+	//One shot: even if loading fails, don't retry every graph evaluation
+	m_samplesLoaded = true;
+
+	if(m_numSamples == 0)
+		return;
+
+	double start = GetTime();
+
 	//Create output waveform
 	auto wfm = new UniformAnalogWaveform;
-	wfm->m_timescale = round(interval);
-	wfm->m_startTimestamp = ttime;
-	wfm->m_startFemtoseconds = basetime * FS_PER_SECOND;
-	wfm->m_triggerPhase = h_off_frac;
+	wfm->m_timescale = m_pendingTimescale;
+	wfm->m_startTimestamp = m_pendingTimestamp;
+	wfm->m_startFemtoseconds = m_pendingStartFemtoseconds;
+	wfm->m_triggerPhase = m_pendingTriggerPhase;
 	SetData(wfm, 0);
-	LogTrace("Sample interval: %s\n", Unit(Unit::UNIT_FS).PrettyPrint(wfm->m_timescale).c_str());
-	LogTrace("Trigger phase: %s\n", Unit(Unit::UNIT_FS).PrettyPrint(wfm->m_triggerPhase).c_str());
 
-	wfm->Resize(num_per_segment);
+	wfm->Resize(m_numSamples);
+	wfm->PrepareForCpuAccess();
 
-	//16 bit sample path
-	if(hdMode)
+	//Fast path: convert directly out of the mapped file, letting the OS fault pages in as we go
+	#ifndef _WIN32
+	if(m_mapping)
 	{
-		AcceleratorBuffer<int16_t> buf;
-		buf.resize(num_per_segment);
-		buf.PrepareForCpuAccess();
+		auto base = reinterpret_cast<const uint8_t*>(m_mapping) + m_dataOffset;
 
-		if(num_per_segment != fread(&buf[0], sizeof(int16_t), num_per_segment, fp))
+		if(m_hdMode)
 		{
-			LogError("Failed to read sample data\n");
-			fclose(fp);
-			return;
+			Oscilloscope::Convert16BitSamples(
+				(float*)&wfm->m_samples[0],
+				reinterpret_cast<const int16_t*>(base),
+				m_gain,
+				m_voff,
+				m_numSamples);
 		}
-		buf.MarkModifiedFromCpu();
-
-		//The accelerated filter needs int16 support
-		/*if(g_hasShaderInt16 && g_gpuFilterEnabled)
+		else
 		{
-			m_commandBuffer->begin({});
-
-			//Update our descriptor sets with current buffers
-			m_computePipeline16Bit->BindBufferNonblocking(0, wfm->m_samples, *m_commandBuffer, true);
-			m_computePipeline16Bit->BindBufferNonblocking(1, buf, *m_commandBuffer);
-
-			ConvertRawSamplesShaderArgs args;
-			args.size = num_per_segment;
-			args.gain = v_gain;
-			args.offset = v_off;
+			Oscilloscope::Convert8BitSamples(
+				(float*)&wfm->m_samples[0],
+				reinterpret_cast<const int8_t*>(base),
+				m_gain,
+				m_voff,
+				m_numSamples);
+		}
 
-			//Dispatch the compute operation and block until it completes
-			//We are in an event handler, so use the global transfer queue here
-			m_computePipeline16Bit->Dispatch(*m_commandBuffer, args, GetComputeBlockCount(len, 64));
-			m_commandBuffer->end();
+		wfm->MarkModifiedFromCpu();
+		LogTrace("Materialized %zu samples in %.2f ms\n", wfm->size(), (GetTime() - start) * 1000);
+		return;
+	}
+	#endif
 
-			g_vkTransferQueue->SubmitAndBlock(*m_commandBuffer);
+	//Fallback: buffered read through a staging buffer
+	FILE* fp = fopen(m_pendingFileName.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open TRC file \"%s\"\n", m_pendingFileName.c_str());
+		SetData(nullptr, 0);
+		return;
+	}
+	fseek(fp, m_dataOffset, SEEK_SET);
 
-			wfm->MarkModifiedFromGpu();
-		}
+	//16 bit sample path
+	if(m_hdMode)
+	{
+		AcceleratorBuffer<int16_t> buf;
+		buf.resize(m_numSamples);
+		buf.PrepareForCpuAccess();
 
-		//Software fallback
-		else*/
+		if(m_numSamples != fread(&buf[0], sizeof(int16_t), m_numSamples, fp))
 		{
-			wfm->PrepareForCpuAccess();
-
-			Oscilloscope::Convert16BitSamples(
-				(float*)&wfm->m_samples[0],
-				&buf[0],
-				v_gain,
-				v_off,
-				num_per_segment);
-
-			wfm->MarkModifiedFromCpu();
+			LogError("Failed to read sample data\n");
+			fclose(fp);
+			SetData(nullptr, 0);
+			return;
 		}
+
+		Oscilloscope::Convert16BitSamples(
+			(float*)&wfm->m_samples[0],
+			&buf[0],
+			m_gain,
+			m_voff,
+			m_numSamples);
 	}
 
 	//8 bit sample path
 	else
 	{
 		AcceleratorBuffer<int8_t> buf;
-		buf.resize(num_per_segment);
+		buf.resize(m_numSamples);
 		buf.PrepareForCpuAccess();
 
-		if(num_per_segment != fread(&buf[0], sizeof(int8_t), num_per_segment, fp))
+		if(m_numSamples != fread(&buf[0], sizeof(int8_t), m_numSamples, fp))
 		{
 			LogError("Failed to read sample data\n");
 			fclose(fp);
+			SetData(nullptr, 0);
 			return;
 		}
-		buf.MarkModifiedFromCpu();
-
-		//The accelerated filter needs int8 support
-		/*if(g_hasShaderInt8 && g_gpuFilterEnabled)
-		{
-			m_commandBuffer->begin({});
-
-			//Update our descriptor sets with current buffers
-			m_computePipeline8Bit->BindBufferNonblocking(0, wfm->m_samples, *m_commandBuffer, true);
-			m_computePipeline8Bit->BindBufferNonblocking(1, buf, *m_commandBuffer);
-
-			ConvertRawSamplesShaderArgs args;
-			args.size = num_per_segment;
-			args.gain = v_gain;
-			args.offset = v_off;
 
-			//Dispatch the compute operation and block until it completes
-			//We are in an event handler, so use the global transfer queue here
-			m_computePipeline8Bit->Dispatch(*m_commandBuffer, args, GetComputeBlockCount(len, 64));
-			m_commandBuffer->end();
-
-			g_vkTransferQueue->SubmitAndBlock(*m_commandBuffer);
+		Oscilloscope::Convert8BitSamples(
+			(float*)&wfm->m_samples[0],
+			&buf[0],
+			m_gain,
+			m_voff,
+			m_numSamples);
+	}
 
-			wfm->MarkModifiedFromGpu();
-		}
+	wfm->MarkModifiedFromCpu();
+	fclose(fp);
 
-		//Software fallback
-		else*/
-		{
-			wfm->PrepareForCpuAccess();
-
-			Oscilloscope::Convert8BitSamples(
-				(float*)&wfm->m_samples[0],
-				&buf[0],
-				v_gain,
-				v_off,
-				num_per_segment);
+	LogTrace("Materialized %zu samples in %.2f ms\n", wfm->size(), (GetTime() - start) * 1000);
+}
 
-			wfm->MarkModifiedFromCpu();
-		}
+/**
+	@brief Releases the memory mapping, if we have one
+ */
+void TRCImportFilter::CloseMapping()
+{
+	#ifndef _WIN32
+	if(m_mapping)
+	{
+		munmap(m_mapping, m_mapLen);
+		m_mapping = nullptr;
+		m_mapLen = 0;
 	}
-
-	LogTrace("Loaded %zu samples\n", wfm->size());
+	#endif
 }
@@ -41,18 +41,60 @@ public:
 	TRCImportFilter(const std::string& color);
 	virtual ~TRCImportFilter();
 
+	virtual void Refresh() override;
+
 	static std::string GetProtocolName();
 
 	PROTOCOL_DECODER_INITPROC(TRCImportFilter)
 
 protected:
 	void OnFileNameChanged();
+	void LoadSamples();
+	void CloseMapping();
 
 	std::unique_ptr<ComputePipeline> m_computePipeline8Bit;
 	std::unique_ptr<ComputePipeline> m_computePipeline16Bit;
 
 	std::unique_ptr<vk::raii::CommandPool> m_commandPool;
 	std::unique_ptr<vk::raii::CommandBuffer> m_commandBuffer;
+
+	//Lazy load state: OnFileNameChanged() only parses the WAVEDESC, sample data is
+	//materialized by the first Refresh() that actually evaluates this filter
+
+	///@brief True if the output waveform holds the current file's samples
+	bool m_samplesLoaded;
+
+	///@brief Path of the file the lazy load state refers to
+	std::string m_pendingFileName;
+
+	///@brief Byte offset of the start of sample data within the file
+	size_t m_dataOffset;
+
+	///@brief Number of samples in the file
+	size_t m_numSamples;
+
+	///@brief True if samples are int16, false if int8
+	bool m_hdMode;
+
+	///@brief Vertical gain from the WAVEDESC
+	float m_gain;
+
+	///@brief Vertical offset from the WAVEDESC
+	float m_voff;
+
+	///@brief Pending waveform metadata from the WAVEDESC
+	int64_t m_pendingTimescale;
+	time_t m_pendingTimestamp;
+	int64_t m_pendingStartFemtoseconds;
+	int64_t m_pendingTriggerPhase;
+
+#ifndef _WIN32
+	///@brief Memory mapped view of the file (null if not mapped)
+	void* m_mapping;
+
+	///@brief Length of the mapping, in bytes
+	size_t m_mapLen;
+#endif
 };
 
 #endif
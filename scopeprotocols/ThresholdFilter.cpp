@@ -37,6 +37,7 @@ using namespace std;
 
 ThresholdFilter::ThresholdFilter(const string& color)
 	: Filter(color, CAT_MATH)
+	, m_computePipeline("shaders/Threshold.spv", 2, sizeof(ThresholdFilterArgs))
 {
 	AddDigitalStream("data");
 	CreateInput("din");
@@ -75,7 +76,76 @@ string ThresholdFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void ThresholdFilter::Refresh()
+/**
+	@brief Thresholds with hysteresis, block-parallel
+
+	A sample above the rising threshold or below the falling threshold forces the state; deadband samples inherit
+	the previous state. Phase 1 finds each block's last forcing decision, phase 2 chains the blocks' initial
+	states serially (cheap, one step per block), phase 3 runs the original serial loop within each block.
+	Produces bit-identical results to the single threaded loop.
+ */
+static void ThresholdWithHysteresis(
+	const float* fin, AcceleratorBuffer<bool>& dout, size_t len, float midpoint, float hys)
+{
+	float thresh_rising = midpoint + hys/2;
+	float thresh_falling = midpoint - hys/2;
+
+	const size_t blocksize = 262144;
+	size_t nblocks = (len + blocksize - 1) / blocksize;
+
+	//Phase 1: find the last forcing decision in each block (-1 = entire block is in the deadband)
+	vector<int8_t> blockDecision(nblocks, -1);
+	#pragma omp parallel for
+	for(int64_t b=0; b<(int64_t)nblocks; b++)
+	{
+		size_t start = b*blocksize;
+		size_t end = min(start + blocksize, len);
+		for(size_t i=end; i-- > start; )
+		{
+			float f = fin[i];
+			if(f > thresh_rising)
+			{
+				blockDecision[b] = 1;
+				break;
+			}
+			if(f < thresh_falling)
+			{
+				blockDecision[b] = 0;
+				break;
+			}
+		}
+	}
+
+	//Phase 2: chain initial states across blocks
+	vector<uint8_t> blockInitial(nblocks);
+	bool cur = fin[0] > midpoint;
+	for(size_t b=0; b<nblocks; b++)
+	{
+		blockInitial[b] = cur;
+		if(blockDecision[b] >= 0)
+			cur = (blockDecision[b] != 0);
+	}
+
+	//Phase 3: threshold each block, starting from its known initial state
+	#pragma omp parallel for
+	for(int64_t b=0; b<(int64_t)nblocks; b++)
+	{
+		bool c = (blockInitial[b] != 0);
+		size_t start = b*blocksize;
+		size_t end = min(start + blocksize, len);
+		for(size_t i=start; i<end; i++)
+		{
+			float f = fin[i];
+			if(c && (f < thresh_falling))
+				c = false;
+			else if(!c && (f > thresh_rising))
+				c = true;
+			dout[i] = c;
+		}
+	}
+}
+
+void ThresholdFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK())
 	{
@@ -91,74 +161,92 @@ void ThresholdFilter::Refresh()
 	float midpoint = m_parameters[m_threshname].GetFloatVal();
 	float hys = m_parameters[m_hysname].GetFloatVal();
 
-	din->PrepareForCpuAccess();
-
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
 	if(sdin)
 	{
+		//Timestamps are copied on the CPU either way
+		sdin->PrepareForCpuAccess();
 		auto cap = SetupSparseDigitalOutputWaveform(sdin, 0, 0, 0);
-		cap->PrepareForCpuAccess();
 
-		//Threshold all of our samples
-		//Optimized inner loop if no hysteresis
-		if(hys == 0)
-		{
-			#pragma omp parallel for
-			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = sdin->m_samples[i] > midpoint;
-		}
+		//Zero hysteresis: each sample is independent, so threshold on the GPU and stay GPU resident
+		if( (hys == 0) && g_gpuFilterEnabled)
+			RefreshGpu(cmdBuf, queue, sdin->m_samples, cap->m_samples, len, midpoint);
 		else
 		{
-			bool cur = sdin->m_samples[0] > midpoint;
-			float thresh_rising = midpoint + hys/2;
-			float thresh_falling = midpoint - hys/2;
+			cap->PrepareForCpuAccess();
 
-			for(size_t i=0; i<len; i++)
+			if(hys == 0)
 			{
-				float f = sdin->m_samples[i];
-				if(cur && (f < thresh_falling))
-					cur = false;
-				else if(!cur && (f > thresh_rising))
-					cur = true;
-				cap->m_samples[i] = cur;
+				#pragma omp parallel for
+				for(size_t i=0; i<len; i++)
+					cap->m_samples[i] = sdin->m_samples[i] > midpoint;
 			}
-		}
+			else
+				ThresholdWithHysteresis(sdin->m_samples.GetCpuPointer(), cap->m_samples, len, midpoint, hys);
 
-		cap->MarkModifiedFromCpu();
+			cap->MarkModifiedFromCpu();
+		}
 	}
 	else
 	{
 		auto cap = SetupEmptyUniformDigitalOutputWaveform(din, 0);
 		cap->Resize(len);
-		cap->PrepareForCpuAccess();
 
-		//Threshold all of our samples
-		//Optimized inner loop if no hysteresis
-		if(hys == 0)
-		{
-			#pragma omp parallel for
-			for(size_t i=0; i<len; i++)
-				cap->m_samples[i] = udin->m_samples[i] > midpoint;
-		}
+		//Zero hysteresis: each sample is independent, so threshold on the GPU and stay GPU resident
+		if( (hys == 0) && g_gpuFilterEnabled)
+			RefreshGpu(cmdBuf, queue, udin->m_samples, cap->m_samples, len, midpoint);
 		else
 		{
-			bool cur = udin->m_samples[0] > midpoint;
-			float thresh_rising = midpoint + hys/2;
-			float thresh_falling = midpoint - hys/2;
+			udin->PrepareForCpuAccess();
+			cap->PrepareForCpuAccess();
 
-			for(size_t i=0; i<len; i++)
+			if(hys == 0)
 			{
-				float f = udin->m_samples[i];
-				if(cur && (f < thresh_falling))
-					cur = false;
-				else if(!cur && (f > thresh_rising))
-					cur = true;
-				cap->m_samples[i] = cur;
+				#pragma omp parallel for
+				for(size_t i=0; i<len; i++)
+					cap->m_samples[i] = udin->m_samples[i] > midpoint;
 			}
-		}
+			else
+				ThresholdWithHysteresis(udin->m_samples.GetCpuPointer(), cap->m_samples, len, midpoint, hys);
 
-		cap->MarkModifiedFromCpu();
+			cap->MarkModifiedFromCpu();
+		}
 	}
 }
+
+/**
+	@brief Runs the zero-hysteresis threshold kernel
+
+	The shader writes packed 32-bit words of single byte bools, so the output buffer capacity is rounded up to a
+	word boundary first.
+ */
+void ThresholdFilter::RefreshGpu(
+	vk::raii::CommandBuffer& cmdBuf,
+	shared_ptr<QueueHandle> queue,
+	AcceleratorBuffer<float>& din,
+	AcceleratorBuffer<bool>& dout,
+	size_t len,
+	float midpoint)
+{
+	//Make sure the word-granular shader can't write past the end of the buffer
+	size_t roundedlen = (len + 3) & ~3ull;
+	if(roundedlen > dout.capacity())
+		dout.reserve(roundedlen);
+
+	ThresholdFilterArgs args;
+	args.nsamples = len;
+	args.threshold = midpoint;
+
+	cmdBuf.begin({});
+
+	m_computePipeline.BindBufferNonblocking(0, dout, cmdBuf, true);
+	m_computePipeline.BindBufferNonblocking(1, din, cmdBuf);
+
+	m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(roundedlen / 4, 64));
+
+	cmdBuf.end();
+	queue->SubmitAndBlock(cmdBuf);
+	dout.MarkModifiedFromGpu();
+}
@@ -35,12 +35,22 @@
 #ifndef ThresholdFilter_h
 #define ThresholdFilter_h
 
+///@brief Push constants for the Threshold compute shader
+struct ThresholdFilterArgs
+{
+	///@brief Number of input samples
+	uint32_t nsamples;
+
+	///@brief Threshold voltage
+	float threshold;
+};
+
 class ThresholdFilter : public Filter
 {
 public:
 	ThresholdFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	static std::string GetProtocolName();
 
@@ -49,8 +59,19 @@ public:
 	PROTOCOL_DECODER_INITPROC(ThresholdFilter)
 
 protected:
+	void RefreshGpu(
+		vk::raii::CommandBuffer& cmdBuf,
+		std::shared_ptr<QueueHandle> queue,
+		AcceleratorBuffer<float>& din,
+		AcceleratorBuffer<bool>& dout,
+		size_t len,
+		float midpoint);
+
 	std::string m_threshname;
 	std::string m_hysname;
+
+	///@brief Compute pipeline for the zero-hysteresis threshold
+	ComputePipeline m_computePipeline;
 };
 
 #endif
@@ -80,7 +80,6 @@ void TopMeasurement::Refresh()
 	din->PrepareForCpuAccess();
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
-	size_t len = din->size();
 
 	//Make a histogram of the waveform
 	float min = GetMinVoltage(sdin, udin);
@@ -112,17 +111,38 @@ void TopMeasurement::Refresh()
 	cap->m_timescale = 1;
 	cap->PrepareForCpuAccess();
 
-	float last = min;
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sdin)
+		InnerLoop(sdin, cap, midpoint, global_top, range * 0.1, min);
+	else
+		InnerLoop(udin, cap, midpoint, global_top, range * 0.1, min);
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Per-cycle top voltage loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and value helpers resolve at compile
+	time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void TopMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float midpoint, float global_top, float delta, float vmin)
+{
+	size_t len = din->size();
+
+	float last = vmin;
 	int64_t tedge = 0;
 	float sum = 0;
 	int64_t count = 0;
-	float delta = range * 0.1;
 
 	for(size_t i=0; i < len; i++)
 	{
 		//Wait for a rising edge
-		float cur = GetValue(sdin, udin, i);
-		int64_t tnow = ::GetOffsetScaled(sdin, udin, i);
+		float cur = din->m_samples[i];
+		int64_t tnow = ::GetOffsetScaled(din, i);
 
 		if( (cur > midpoint) && (last <= midpoint) )
 		{
@@ -146,8 +166,4 @@ void TopMeasurement::Refresh()
 
 		last = cur;
 	}
-
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
 }
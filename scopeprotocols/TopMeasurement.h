@@ -47,6 +47,10 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
 	PROTOCOL_DECODER_INITPROC(TopMeasurement)
+
+protected:
+	template<class W>
+	void InnerLoop(W* din, SparseAnalogWaveform* cap, float midpoint, float global_top, float delta, float vmin);
 };
 
 #endif
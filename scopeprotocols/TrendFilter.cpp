@@ -102,13 +102,26 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 	auto wfm = dynamic_cast<SparseAnalogWaveform*>(GetData(0));
 	if(wfm)
 	{
-		//Remove old samples
+		//Evict old samples in batches, allowing up to 25% slack over the configured depth.
+		//Retained samples are then moved once per batch rather than once per new point, so a day-long
+		//trend costs amortized constant time per update instead of a full rewrite of the history.
 		size_t nmax = m_parameters[m_depthname].GetIntVal();
-		while(wfm->m_samples.size() > nmax)
+		size_t slack = max(nmax / 4, (size_t)1);
+		if(wfm->m_samples.size() > (nmax + slack) )
 		{
-			wfm->m_samples.pop_front();
-			wfm->m_durations.pop_front();
-			wfm->m_offsets.pop_front();
+			wfm->PrepareForCpuAccess();
+
+			size_t nevict = wfm->m_samples.size() - nmax;
+			wfm->m_samples.pop_front_n(nevict);
+			wfm->m_durations.pop_front_n(nevict);
+			wfm->m_offsets.pop_front_n(nevict);
+
+			//Rebase the surviving offsets while we're touching them anyway,
+			//so they can't creep toward overflow over a very long soak test
+			int64_t base = wfm->m_offsets[0];
+			size_t nleft = wfm->m_offsets.size();
+			for(size_t i=0; i<nleft; i++)
+				wfm->m_offsets[i] -= base;
 		}
 	}
 	else
@@ -141,10 +154,9 @@ void TrendFilter::Refresh(vk::raii::CommandBuffer& /*cmdBuf*/, std::shared_ptr<Q
 	else
 		wfm->m_offsets.push_back(dt + wfm->m_offsets[len-1]);
 
-	//Update offsets of old samples
-	len = wfm->m_samples.size();
-	for(size_t i=0; i<len; i++)
-		wfm->m_offsets[i] -= dt;
+	//Anchor the newest sample at time zero by sliding the trigger phase, rather than
+	//rewriting every stored offset each time a new point arrives
+	wfm->m_triggerPhase = -wfm->m_offsets[wfm->m_offsets.size() - 1];
 
 	wfm->MarkModifiedFromCpu();
 
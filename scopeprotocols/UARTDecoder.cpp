@@ -43,6 +43,8 @@ using namespace std;
 
 UARTDecoder::UARTDecoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_resumeIndex(0)
+	, m_cachedBaud(0)
 {
 	//Set up channels
 	CreateInput("din");
@@ -92,6 +94,7 @@ void UARTDecoder::Refresh()
 	if(!VerifyAllInputsOK())
 	{
 		SetData(NULL, 0);
+		m_inputTracker.Reset();
 		return;
 	}
 
@@ -102,23 +105,35 @@ void UARTDecoder::Refresh()
 	auto udin = dynamic_cast<UniformDigitalWaveform*>(din);
 
 	//Get the bit period
-	float bit_period = FS_PER_SECOND / m_parameters[m_baudname].GetFloatVal();
+	float baud = m_parameters[m_baudname].GetFloatVal();
+	float bit_period = FS_PER_SECOND / baud;
 	int64_t ibitper = bit_period;
 	int64_t scaledbitper = ibitper / din->m_timescale;
 
-	//UART processing
-	auto cap = new ByteWaveform(m_displaycolor);
+	//If a streaming source only appended samples since our last run, and our configuration hasn't changed,
+	//keep the old output and resume the decode just after the last complete byte
+	auto cap = dynamic_cast<ByteWaveform*>(GetData(0));
+	size_t isample;
+	if( cap && (baud == m_cachedBaud) && m_inputTracker.IsAppendOnly(din) )
+		isample = m_resumeIndex;
+
+	//Otherwise decode the whole record from scratch
+	else
+	{
+		cap = new ByteWaveform(m_displaycolor);
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+		isample = 0;
+		m_resumeIndex = 0;
+	}
 	cap->PrepareForCpuAccess();
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
+	m_cachedBaud = baud;
+	m_outputBuilder.Start(cap);
 
 	//Time-domain processing to reflect potentially variable sampling rate for RLE captures
 	int64_t next_value = 0;
-	size_t isample = 0;
-	int64_t tlast = 0;
-	Packet* pack = NULL;
 	size_t len = din->size();
 	while(isample < len)
 	{
@@ -169,9 +184,21 @@ void UARTDecoder::Refresh()
 
 		//Save the sample
 		int64_t tend = next_value + (scaledbitper/2);
-		cap->m_offsets.push_back(tstart);
-		cap->m_durations.push_back(tend-tstart);
-		cap->m_samples.push_back(dval);
+		m_outputBuilder.Append(tstart, tend-tstart, dval);
+
+		//Next incremental decode can pick up here
+		m_resumeIndex = isample;
+	}
+
+	//Group the decoded bytes into packets. This is cheap compared to the bit level decode, so rather than
+	//trying to resume packetization mid-stream we just redo it over the full byte record each time.
+	int64_t tlast = 0;
+	Packet* pack = NULL;
+	size_t nbytes = cap->m_samples.size();
+	for(size_t k=0; k<nbytes; k++)
+	{
+		int64_t tstart = cap->m_offsets[k];
+		int64_t tend = tstart + cap->m_durations[k];
 
 		//If the last packet was more than 3 byte times ago, start a new one
 		if(pack != NULL)
@@ -193,7 +220,7 @@ void UARTDecoder::Refresh()
 		}
 
 		//Append to the existing packet
-		pack->m_data.push_back(dval);
+		pack->m_data.push_back(cap->m_samples[k]);
 		tlast = tstart;
 	}
 
@@ -204,7 +231,10 @@ void UARTDecoder::Refresh()
 		FinishPacket(pack);
 	}
 
+	m_outputBuilder.Finish();
 	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+	m_inputTracker.Commit(din);
 }
 
 void UARTDecoder::FinishPacket(Packet* pack)
@@ -68,6 +68,18 @@ public:
 protected:
 	void FinishPacket(Packet* pack);
 	std::string m_baudname;
+
+	///@brief Tracks the input waveform so we can resume decoding when a streaming source appends samples
+	InputDirtyRegionTracker m_inputTracker;
+
+	///@brief Input sample index to resume an incremental decode from (just after the last complete byte)
+	size_t m_resumeIndex;
+
+	///@brief Baud rate the committed decode state was produced with
+	float m_cachedBaud;
+
+	///@brief Reserves output capacity based on previous refreshes
+	SparseWaveformBuilder<char> m_outputBuilder;
 };
 
 #endif
@@ -30,9 +30,18 @@
 #include "../scopehal/scopehal.h"
 #include "USB2PMADecoder.h"
 #include <algorithm>
+#include <omp.h>
 
 using namespace std;
 
+///@brief One run of identical line states, produced by the chunk-parallel classification pass
+struct USB2PMARun
+{
+	int64_t m_offset;
+	int64_t m_duration;
+	uint8_t m_type;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -124,70 +133,111 @@ void USB2PMADecoder::Refresh()
 	//Figure out the line state for each input (no clock recovery yet)
 	auto cap = new USB2PMAWaveform;
 	cap->PrepareForCpuAccess();
-	for(size_t i=0; i<len; i++)
+
+	//Chunk-parallel pass: classify samples and run length encode each chunk independently.
+	//This is the only sample-rate loop in the USB2 decode stack (PCS and packet layers run at symbol rate),
+	//so it dominates end-to-end decode time on deep captures.
+	const size_t minChunkSize = 256 * 1024;
+	size_t nchunks = min((len + minChunkSize - 1) / minChunkSize, (size_t)omp_get_max_threads());
+	nchunks = max(nchunks, (size_t)1);
+	size_t chunkSize = (len + nchunks - 1) / nchunks;
+	vector<vector<USB2PMARun>> chunkRuns(nchunks);
+
+	#pragma omp parallel for
+	for(size_t c=0; c<nchunks; c++)
 	{
-		auto vp = GetValue(sdin_p, udin_p, i);
-		auto vn = GetValue(sdin_n, udin_n, i);
-		bool bp = (vp > threshold_se);
-		bool bn = (vn > threshold_se);
-		float vdiff = vp - vn;
-
-		USB2PMASymbol::SegmentType type = USB2PMASymbol::TYPE_SE1;
-		if(fabs(vdiff) > threshold_diff)
+		size_t start = c * chunkSize;
+		size_t end = min(start + chunkSize, len);
+		auto& runs = chunkRuns[c];
+
+		for(size_t i=start; i<end; i++)
 		{
-			if( (speed == SPEED_FULL) || (speed == SPEED_HIGH) )
+			auto vp = GetValue(sdin_p, udin_p, i);
+			auto vn = GetValue(sdin_n, udin_n, i);
+			bool bp = (vp > threshold_se);
+			bool bn = (vn > threshold_se);
+			float vdiff = vp - vn;
+
+			USB2PMASymbol::SegmentType type = USB2PMASymbol::TYPE_SE1;
+			if(fabs(vdiff) > threshold_diff)
 			{
-				if(vdiff > 0)
-					type = USB2PMASymbol::TYPE_J;
+				if( (speed == SPEED_FULL) || (speed == SPEED_HIGH) )
+				{
+					if(vdiff > 0)
+						type = USB2PMASymbol::TYPE_J;
+					else
+						type = USB2PMASymbol::TYPE_K;
+				}
 				else
-					type = USB2PMASymbol::TYPE_K;
+				{
+					if(vdiff > 0)
+						type = USB2PMASymbol::TYPE_K;
+					else
+						type = USB2PMASymbol::TYPE_J;
+				}
 			}
+			else if(bp && bn)
+				type = USB2PMASymbol::TYPE_SE1;
 			else
-			{
-				if(vdiff > 0)
-					type = USB2PMASymbol::TYPE_K;
-				else
-					type = USB2PMASymbol::TYPE_J;
-			}
-		}
-		else if(bp && bn)
-			type = USB2PMASymbol::TYPE_SE1;
-		else
-			type = USB2PMASymbol::TYPE_SE0;
+				type = USB2PMASymbol::TYPE_SE0;
 
-		//First sample goes as-is
-		if(cap->m_samples.empty())
-		{
-			cap->m_offsets.push_back(::GetOffset(sdin_p, udin_p, i));
-			cap->m_durations.push_back(GetDuration(sdin_p, udin_p, i));
-			cap->m_samples.push_back(type);
-			continue;
+			if(!runs.empty() && (runs.back().m_type == (uint8_t)type))
+				runs.back().m_duration += GetDuration(sdin_p, udin_p, i);
+			else
+				runs.push_back(USB2PMARun{::GetOffset(sdin_p, udin_p, i), GetDuration(sdin_p, udin_p, i), (uint8_t)type});
 		}
+	}
 
-		//Type match? Extend the existing sample
-		size_t iold = cap->size()-1;
-		auto oldtype = cap->m_samples[iold];
-		if(oldtype == type)
+	//Serial stitch pass: coalesce runs split at chunk boundaries and apply the SE0/SE1 transition fixup.
+	//This runs at symbol rate, so it's cheap compared to the classification pass above. Processing run by run
+	//gives the same output as the old per-sample loop: equal-type samples always extend the current run, so
+	//the type-change decisions (the only places the fixup can fire) happen at run boundaries either way.
+	size_t nruns = 0;
+	for(auto& v : chunkRuns)
+		nruns += v.size();
+	cap->m_offsets.reserve(nruns);
+	cap->m_durations.reserve(nruns);
+	cap->m_samples.reserve(nruns);
+	for(auto& v : chunkRuns)
+	{
+		for(auto& r : v)
 		{
-			cap->m_durations[iold] += GetDuration(sdin_p, udin_p, i);
-			continue;
-		}
+			auto type = static_cast<USB2PMASymbol::SegmentType>(r.m_type);
 
-		//Ignore SE0/SE1 states during transitions.
-		int64_t last_fs = cap->m_durations[iold] * din_p->m_timescale;
-		if(
-			( (oldtype == USB2PMASymbol::TYPE_SE0) || (oldtype == USB2PMASymbol::TYPE_SE1) ) &&
-			(last_fs < transition_time))
-		{
-			cap->m_samples[iold].m_type = type;
-			cap->m_durations[iold] += GetDuration(sdin_p, udin_p, i);
-			continue;
-		}
+			//First run goes as-is
+			if(cap->m_samples.empty())
+			{
+				cap->m_offsets.push_back(r.m_offset);
+				cap->m_durations.push_back(r.m_duration);
+				cap->m_samples.push_back(type);
+				continue;
+			}
+
+			//Type match? Extend the existing sample
+			size_t iold = cap->size()-1;
+			auto oldtype = cap->m_samples[iold];
+			if(oldtype == type)
+			{
+				cap->m_durations[iold] += r.m_duration;
+				continue;
+			}
 
-		//Not a match. Add a new sample.
-		cap->m_offsets.push_back(::GetOffset(sdin_p, udin_p, i));
-		cap->m_durations.push_back(GetDuration(sdin_p, udin_p, i));
-		cap->m_samples.push_back(type);
+			//Ignore SE0/SE1 states during transitions.
+			int64_t last_fs = cap->m_durations[iold] * din_p->m_timescale;
+			if(
+				( (oldtype == USB2PMASymbol::TYPE_SE0) || (oldtype == USB2PMASymbol::TYPE_SE1) ) &&
+				(last_fs < transition_time))
+			{
+				cap->m_samples[iold].m_type = type;
+				cap->m_durations[iold] += r.m_duration;
+				continue;
+			}
+
+			//Not a match. Add a new sample.
+			cap->m_offsets.push_back(r.m_offset);
+			cap->m_durations.push_back(r.m_duration);
+			cap->m_samples.push_back(type);
+		}
 	}
 
 	SetData(cap, 0);
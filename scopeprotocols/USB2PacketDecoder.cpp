@@ -352,23 +352,7 @@ void USB2PacketDecoder::Refresh()
  */
 uint16_t USB2PacketDecoder::CalculateCRC16(const std::vector<uint8_t>& data)
 {
-	uint16_t poly = 0xa001;
-	uint16_t crc = 0xffff;
-
-	for(size_t n=0; n<data.size(); n++)
-	{
-		uint8_t d = data[n];
-
-		for(int i=0; i<8; i++)
-		{
-			bool b = ( crc ^ (d >> i) ) & 1;
-			crc >>= 1;
-			if(b)
-				crc ^= poly;
-		}
-	}
-
-	return ~( (crc << 8) | ( (crc >> 8) & 0xff) );
+	return CRC16USB(data.data(), data.size());
 }
 
 /**
@@ -463,7 +447,7 @@ void USB2PacketDecoder::DecodeSof(USB2PacketWaveform* cap, size_t istart, size_t
 		return;
 
 	//Make the packet
-	Packet* pack = new Packet;
+	Packet* pack = AllocatePacket();
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 	pack->m_headers["Type"] = "SOF";
 	char tmp[128];
@@ -564,7 +548,7 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 	}
 
 	//Make the packet
-	Packet* pack = new Packet;
+	Packet* pack = AllocatePacket();
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 	pack->m_headers["Type"] = "SETUP";
 	pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
@@ -695,7 +679,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		i++;
 
 		//Add a line for the aborted transaction
-		Packet* pack = new Packet;
+		Packet* pack = AllocatePacket();
 		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 		if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 		{
@@ -726,7 +710,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		LogError("Not data PID (%x, i=%zu)\n", sdatpid.m_data, i);
 
 		//DEBUG
-		Packet* pack = new Packet;
+		Packet* pack = AllocatePacket();
 		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 		pack->m_headers["Details"] = "ERROR";
 		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
@@ -735,7 +719,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 	}
 
 	//Create the new packet
-	Packet* pack = new Packet;
+	Packet* pack = AllocatePacket();
 	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
 	if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 	{
@@ -81,7 +81,6 @@ void UndershootMeasurement::Refresh()
 	din->PrepareForCpuAccess();
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
-	size_t len = din->size();
 
 	//Figure out the nominal top of the waveform
 	float top = GetTopVoltage(sdin, udin);
@@ -92,6 +91,28 @@ void UndershootMeasurement::Refresh()
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0);
 	cap->PrepareForCpuAccess();
 
+	//Dispatch to a loop instantiated for the actual waveform type
+	if(sdin)
+		InnerLoop(sdin, cap, midpoint, base);
+	else
+		InnerLoop(udin, cap, midpoint, base);
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Per-cycle trough search loop, templated on the input waveform type
+
+	Instantiated separately for sparse and uniform inputs so the offset and value helpers resolve at compile
+	time, rather than branching between the two representations once per sample.
+ */
+template<class W>
+void UndershootMeasurement::InnerLoop(W* din, SparseAnalogWaveform* cap, float midpoint, float base)
+{
+	size_t len = din->size();
+
 	int64_t		tmin = 0;
 	float		vmin = FLT_MAX;
 
@@ -99,7 +120,7 @@ void UndershootMeasurement::Refresh()
 	for(size_t i=0; i < len; i++)
 	{
 		//If we're above the midpoint, reset everything and add a new sample
-		float v = GetValue(sdin, udin, i);
+		float v = din->m_samples[i];
 		if(v > midpoint)
 		{
 			//Add a sample for the current value (if any)
@@ -126,13 +147,9 @@ void UndershootMeasurement::Refresh()
 		{
 			if(v < vmin)
 			{
-				tmin = ::GetOffset(sdin, udin, i);
+				tmin = ::GetOffset(din, i);
 				vmin = v;
 			}
 		}
 	}
-
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
 }
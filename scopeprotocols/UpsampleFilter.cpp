@@ -73,6 +73,16 @@ UpsampleFilter::UpsampleFilter(const string& color)
 	m_parameters[m_factorname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
 	m_parameters[m_factorname].SetIntVal(10);
 
+	m_qualityname = "Kernel quality";
+	m_parameters[m_qualityname] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_qualityname].AddEnumValue("Draft", QUALITY_DRAFT);
+	m_parameters[m_qualityname].AddEnumValue("Good", QUALITY_GOOD);
+	m_parameters[m_qualityname].AddEnumValue("High", QUALITY_HIGH);
+	m_parameters[m_qualityname].SetIntVal(QUALITY_DRAFT);
+
+	m_cachedFactor = 0;
+	m_cachedWindow = 0;
+
 	//Use pinned memory for filter kernel
 	m_filter.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_filter.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
@@ -114,33 +124,62 @@ void UpsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 		return;
 	}
 
-	//Configuration parameters (TODO: allow window to be user specified)
+	//Configuration parameters
 	size_t upsample_factor = m_parameters[m_factorname].GetIntVal();
-	size_t window = 5;
-	size_t kernel = window*upsample_factor;
+	size_t window;
+	switch(m_parameters[m_qualityname].GetIntVal())
+	{
+		case QUALITY_HIGH:
+			window = 17;
+			break;
+
+		case QUALITY_GOOD:
+			window = 9;
+			break;
+
+		case QUALITY_DRAFT:
+		default:
+			window = 5;
+			break;
+	}
 	if(upsample_factor <= 0)
 	{
 		SetData(NULL, 0);
 		return;
 	}
 
-	//Create the interpolation filter
-	//TODO: if upsampling factor and window size have not changed, keep the same filter coefficients
-	//(no need to push every time)
-	float frac_kernel = kernel * 1.0f / upsample_factor;
-	m_filter.resize(kernel);
-	m_filter.PrepareForCpuAccess();
-	for(size_t i=0; i<kernel; i++)
+	//Create the interpolation filter, decomposed into one contiguous bank of taps per output phase
+	//so each thread reads a dense run of coefficients rather than striding through the full kernel.
+	//Only regenerate (and re-upload) when the factor or quality setting changes.
+	if( (m_cachedFactor != upsample_factor) || (m_cachedWindow != window) )
 	{
-		float frac = i*1.0f / upsample_factor;
-		m_filter[i] = sinc(frac, frac_kernel) * blackman(frac, frac_kernel);
+		float frac_kernel = window;
+		m_filter.resize(window * upsample_factor);
+		m_filter.PrepareForCpuAccess();
+		for(size_t j=0; j<upsample_factor; j++)
+		{
+			size_t start = (j == 0) ? 0 : (upsample_factor - j);
+			for(size_t t=0; t<window; t++)
+			{
+				float frac = (start + t*upsample_factor) * 1.0f / upsample_factor;
+				m_filter[j*window + t] = sinc(frac, frac_kernel) * blackman(frac, frac_kernel);
+			}
+		}
+		m_filter.MarkModifiedFromCpu();
+
+		m_cachedFactor = upsample_factor;
+		m_cachedWindow = window;
 	}
-	m_filter.MarkModifiedFromCpu();
 
 	//Create the output and configure it
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(din, 0);
 	cap->m_timescale = din->m_timescale / upsample_factor;
 	size_t len = din->size();
+	if(len < window)
+	{
+		SetData(NULL, 0);
+		return;
+	}
 	size_t imax = len - window;
 	size_t outlen = imax*upsample_factor;
 	cap->Resize(outlen);
@@ -157,7 +196,7 @@ void UpsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 		UpsampleFilterArgs args;
 		args.imax = imax;
 		args.upsample_factor = upsample_factor;
-		args.kernel = kernel;
+		args.window = window;
 
 		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(imax, 64), GetComputeBlockCount(upsample_factor, 1));
 
@@ -173,24 +212,19 @@ void UpsampleFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHa
 		cap->PrepareForCpuAccess();
 
 		//Logically, we upsample by inserting zeroes, then convolve with the sinc filter.
-		//Optimization: don't actually waste time multiplying by zero
+		//Optimization: don't actually waste time multiplying by zero, just run the per-phase bank
 		#pragma omp parallel for
 		for(size_t i=0; i < imax; i++)
 		{
 			size_t offset = i * upsample_factor;
 			for(size_t j=0; j<upsample_factor; j++)
 			{
-				size_t start = 0;
-				size_t sstart = 0;
-				if(j > 0)
-				{
-					sstart = 1;
-					start = upsample_factor - j;
-				}
+				size_t sstart = (j > 0) ? 1 : 0;
+				size_t base = j * window;
 
 				float f = 0;
-				for(size_t k = start; k<kernel; k += upsample_factor, sstart ++)
-					f += m_filter[k] * din->m_samples[i + sstart];
+				for(size_t t=0; t<window; t++)
+					f += m_filter[base + t] * din->m_samples[i + sstart + t];
 
 				cap->m_samples[offset + j] = f;
 			}
@@ -41,7 +41,7 @@ struct UpsampleFilterArgs
 {
 	uint32_t imax;
 	uint32_t upsample_factor;
-	uint32_t kernel;
+	uint32_t window;
 };
 
 class UpsampleFilter : public Filter
@@ -60,9 +60,24 @@ public:
 
 protected:
 	std::string m_factorname;
+	std::string m_qualityname;
 
+	enum KernelQuality
+	{
+		QUALITY_DRAFT,
+		QUALITY_GOOD,
+		QUALITY_HIGH
+	};
+
+	///@brief Interpolation kernel, decomposed into upsample_factor polyphase banks of window contiguous taps
 	AcceleratorBuffer<float> m_filter;
 
+	///@brief Upsampling factor the cached kernel was generated for
+	size_t m_cachedFactor;
+
+	///@brief Taps per polyphase bank in the cached kernel
+	size_t m_cachedWindow;
+
 	ComputePipeline m_computePipeline;
 };
 
@@ -29,6 +29,8 @@
 
 #include "../scopehal/scopehal.h"
 #include "VCDImportFilter.h"
+#include <omp.h>
+#include <string_view>
 
 using namespace std;
 
@@ -56,6 +58,125 @@ string VCDImportFilter::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+///@brief A single value change: timestamp plus a pointer to the value text within the dump body
+struct VCDChange
+{
+	///@brief Timestamp of the change, in timescale units
+	int64_t m_time;
+
+	///@brief Value text ('0'/'1'/'x'/'z' for scalars, bit string for vectors), not null terminated
+	const char* m_data;
+
+	///@brief Length of the value text
+	uint32_t m_len;
+};
+
+///@brief Bounded substring search (strnstr isn't portable)
+static const char* strnstr_local(const char* haystack, const char* needle, size_t len)
+{
+	size_t nlen = strlen(needle);
+	if(nlen > len)
+		return nullptr;
+	for(size_t i=0; i <= (len - nlen); i++)
+	{
+		if(0 == memcmp(haystack + i, needle, nlen))
+			return haystack + i;
+	}
+	return nullptr;
+}
+
+/**
+	@brief Parses one chunk of the value-change section of a VCD file
+
+	The dump section after $enddefinitions is timestamp-monotonic and every change line carries its full value,
+	so chunks split at timestamp lines can be parsed independently with no carried symbol state: each chunk reads
+	its start time from its own leading '#' line.
+
+	@param start		First character of the chunk (points at a '#' timestamp line, except for the first chunk)
+	@param end			One past the last character of the chunk
+	@param seedTime		Timestamp in effect at the start of the chunk (only used before the first '#' line)
+	@param symbolIndex	Map from symbol identifier to output slot
+	@param changes		Per-symbol change lists to append to
+ */
+static void ParseVCDChunk(
+	const char* start,
+	const char* end,
+	int64_t seedTime,
+	const map<string, size_t, less<>>& symbolIndex,
+	vector<vector<VCDChange>>& changes)
+{
+	int64_t current_time = seedTime;
+
+	const char* p = start;
+	while(p < end)
+	{
+		//Find the extent of this line (and where the next one starts)
+		const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+		const char* next = eol ? (eol + 1) : end;
+		if(!eol)
+			eol = end;
+
+		//Trim leading whitespace and trailing CR
+		while( (p < eol) && isspace((unsigned char)*p) )
+			p ++;
+		while( (eol > p) && isspace((unsigned char)eol[-1]) )
+			eol --;
+
+		if(p == eol)
+		{
+			p = next;
+			continue;
+		}
+
+		//Timestamp
+		if(*p == '#')
+			current_time = strtoll(p+1, nullptr, 10);
+
+		//Directives ($dumpvars, $dumpall, $end, etc): no effect on sample data, but skip over
+		//multi-line comment bodies so their contents aren't misparsed as value changes
+		else if(*p == '$')
+		{
+			if( (0 == strncmp(p, "$comment", 8)) && (nullptr == strnstr_local(p, "$end", eol - p)) )
+			{
+				while(next < end)
+				{
+					const char* ceol = static_cast<const char*>(memchr(next, '\n', end - next));
+					if(!ceol)
+						ceol = end;
+					bool done = (nullptr != strnstr_local(next, "$end", ceol - next));
+					next = (ceol < end) ? (ceol + 1) : end;
+					if(done)
+						break;
+				}
+			}
+		}
+
+		//Vector: 'b', bit string, space, symbol
+		else if( (*p == 'b') || (*p == 'B') )
+		{
+			const char* vstart = p + 1;
+			const char* space = static_cast<const char*>(memchr(vstart, ' ', eol - vstart));
+			if(space)
+			{
+				const char* sym = space + 1;
+				auto it = symbolIndex.find(string_view(sym, eol - sym));
+				if(it != symbolIndex.end())
+					changes[it->second].push_back(VCDChange{current_time, vstart, (uint32_t)(space - vstart)});
+			}
+		}
+
+		//Scalar: value character immediately followed by symbol
+		else
+		{
+			auto it = symbolIndex.find(string_view(p+1, eol - (p+1)));
+			if(it != symbolIndex.end())
+				changes[it->second].push_back(VCDChange{current_time, p, 1});
+		}
+
+		p = next;
+	}
+}
+
 void VCDImportFilter::OnFileNameChanged()
 {
 	auto fname = m_parameters[m_fpname].ToString();
@@ -83,9 +204,6 @@ void VCDImportFilter::OnFileNameChanged()
 		STATE_VERSION,
 		STATE_TIMESCALE,
 		STATE_VARS,
-		STATE_INITIAL,
-		STATE_DUMP,
-		STATE_DUMPALL,
 		STATE_COMMENT
 	} state = STATE_IDLE;
 
@@ -98,9 +216,13 @@ void VCDImportFilter::OnFileNameChanged()
 
 	//Map of signal IDs to signals
 	map<string, WaveformBase*> waveforms;
-	map<string, size_t> widths;
+	map<string, size_t, less<>> symbolIndex;
+	vector<WaveformBase*> wfmBySymbol;
+	vector<size_t> widthBySymbol;
 
-	//VCD is a line based format, so process everything in lines
+	//Parse the header serially: it's small, stateful (nested scopes), and ends at $enddefinitions.
+	//The value-change section after it is parsed in parallel below.
+	bool headerDone = false;
 	char buf[2048];
 	while(NULL != fgets(buf, sizeof(buf), fp))
 	{
@@ -135,10 +257,6 @@ void VCDImportFilter::OnFileNameChanged()
 					state = STATE_VERSION;
 				else if(s == "$timescale")
 					state = STATE_TIMESCALE;
-				else if(s == "$dumpvars")
-					state = STATE_INITIAL;
-				else if(s == "$dumpall")
-					state = STATE_DUMPALL;
 				else if(s.find("$comment") == 0)
 				{
 					if(s.find("$end") == string::npos)
@@ -226,7 +344,10 @@ void VCDImportFilter::OnFileNameChanged()
 						scope.pop_back();
 				}
 				else if(s.find("$enddefinitions") != string::npos)
+				{
 					state = STATE_IDLE;
+					headerDone = true;
+				}
 				else
 				{
 					//Format the current scope
@@ -263,102 +384,140 @@ void VCDImportFilter::OnFileNameChanged()
 					wfm->m_startFemtoseconds = fs;
 					wfm->m_triggerPhase = 0;
 					waveforms[symbol] = wfm;
-					widths[symbol] = width;
+					symbolIndex[symbol] = wfmBySymbol.size();
+					wfmBySymbol.push_back(wfm);
+					widthBySymbol.push_back(width);
 					SetData(wfm, m_streams.size() - 1);
 				}
 				break;	//end STATE_VARS
 
-			case STATE_INITIAL:
-			case STATE_DUMP:
+			case STATE_COMMENT:
+				//nothing to do, ignore it
+				break;
+		}
 
-				//Parse the current line
-				if(s[0] != '$')
+		//Reset at the end of a block
+		if(s.find("$end") != string::npos)
+		{
+			if(state != STATE_VARS)
+				state = STATE_IDLE;
+			if(headerDone)
+				break;
+		}
+	}
+
+	//Slurp the rest of the file (the value-change section) into memory for parallel parsing
+	long bodyStart = ftell(fp);
+	fseek(fp, 0, SEEK_END);
+	long bodyEnd = ftell(fp);
+	fseek(fp, bodyStart, SEEK_SET);
+	size_t bodyLen = bodyEnd - bodyStart;
+	vector<char> body(bodyLen + 1, 0);	//trailing NUL bounds strtoll() on a file with no final newline
+	if(bodyLen && (1 != fread(&body[0], bodyLen, 1, fp)) )
+	{
+		LogError("Failed to read VCD file \"%s\"\n", fname.c_str());
+		fclose(fp);
+		return;
+	}
+	fclose(fp);
+
+	size_t numSymbols = wfmBySymbol.size();
+	if(bodyLen && numSymbols)
+	{
+		//Carve the body into chunks, aligned so that every chunk after the first starts on a '#' timestamp line
+		//and thus needs no carried state beyond the header-seeded start time of chunk zero
+		size_t nchunks = min((size_t)(4 * omp_get_max_threads()), bodyLen / (64 * 1024) + 1);
+		const char* base = &body[0];
+		const char* bend = base + bodyLen;
+		vector<const char*> bounds;
+		bounds.push_back(base);
+		for(size_t i=1; i<nchunks; i++)
+		{
+			const char* target = base + (bodyLen * i) / nchunks;
+			if(target <= bounds.back())
+				continue;
+
+			//Advance to the start of the next '#' line
+			const char* q = static_cast<const char*>(memchr(target, '\n', bend - target));
+			while(q)
+			{
+				q ++;
+				if( (q < bend) && (*q == '#') )
+					break;
+				q = static_cast<const char*>(memchr(q, '\n', bend - q));
+			}
+			if(q && (q < bend) && (q > bounds.back()) )
+				bounds.push_back(q);
+		}
+		bounds.push_back(bend);
+		nchunks = bounds.size() - 1;
+
+		//Parse each chunk independently
+		vector<vector<vector<VCDChange>>> chunkChanges(nchunks);
+		#pragma omp parallel for
+		for(size_t i=0; i<nchunks; i++)
+		{
+			chunkChanges[i].resize(numSymbols);
+			ParseVCDChunk(bounds[i], bounds[i+1], current_time, symbolIndex, chunkChanges[i]);
+		}
+
+		//Assemble each signal's waveform from the per-chunk change lists
+		#pragma omp parallel for
+		for(size_t sym=0; sym<numSymbols; sym++)
+		{
+			size_t total = 0;
+			for(size_t i=0; i<nchunks; i++)
+				total += chunkChanges[i][sym].size();
+
+			auto swfm = dynamic_cast<SparseDigitalWaveform*>(wfmBySymbol[sym]);
+			auto bwfm = dynamic_cast<SparseDigitalBusWaveform*>(wfmBySymbol[sym]);
+			wfmBySymbol[sym]->Resize(total);
+
+			size_t n = 0;
+			int64_t prevOffset = 0;
+			for(size_t i=0; i<nchunks; i++)
+			{
+				for(auto& change : chunkChanges[i][sym])
 				{
-					//Vector: first char is 'b', then data, space, symbol name
-					if(s[0] == 'b')
+					if(swfm)
 					{
-						auto ispace = s.find(' ');
-						auto symbol = s.substr(ispace + 1);
-						auto wfm = dynamic_cast<SparseDigitalBusWaveform*>(waveforms[symbol]);
-						if(wfm)
-						{
-							//Parse the sample data (skipping the leading 'b')
-							vector<bool> sample;
-							for(size_t i = ispace-1; i > 0; i--)
-							{
-								if(s[i] == '1')
-									sample.push_back(true);
-								else
-									sample.push_back(false);
-							}
-
-							//Zero-pad the sample out to full width
-							auto width = widths[symbol];
-							while(sample.size() < width)
-								sample.push_back(false);
-
-							//Extend the previous sample, if there is one
-							auto len = wfm->size();
-							if(len)
-							{
-								auto last = len-1;
-								wfm->m_durations[last] = current_time - wfm->m_offsets[last];
-							}
-
-							//Add the new sample
-							wfm->m_offsets.push_back(current_time);
-							wfm->m_durations.push_back(1);
-							wfm->m_samples.push_back(sample);
-							wfm->MarkModifiedFromCpu();
-						}
-						else
-							LogError("Symbol \"%s\" is not a valid digital bus waveform\n", symbol.c_str());
+						swfm->m_offsets[n] = change.m_time;
+						swfm->m_samples[n] = (change.m_data[0] == '1');
+						if(n)
+							swfm->m_durations[n-1] = change.m_time - prevOffset;
 					}
-
-					//Scalar: first char is boolean value, rest is symbol name
 					else
 					{
-						auto symbol = s.substr(1);
-						auto wfm = dynamic_cast<SparseDigitalWaveform*>(waveforms[symbol]);
-						if(wfm)
-						{
-							//Extend the previous sample, if there is one
-							auto len = wfm->size();
-							if(len)
-							{
-								auto last = len-1;
-								wfm->m_durations[last] = current_time - wfm->m_offsets[last];
-							}
-
-							//Add the new sample
-							wfm->m_offsets.push_back(current_time);
-							wfm->m_durations.push_back(1);
-							wfm->m_samples.push_back(s[0] == '1');
-							wfm->MarkModifiedFromCpu();
-						}
-						else
-							LogError("Symbol \"%s\" is not a valid digital waveform\n", symbol.c_str());
+						//Bit string is MSB first; store LSB first and zero-pad to full width
+						vector<bool> sample;
+						for(size_t j=change.m_len; j > 0; j--)
+							sample.push_back(change.m_data[j-1] == '1');
+						auto width = widthBySymbol[sym];
+						while(sample.size() < width)
+							sample.push_back(false);
+
+						bwfm->m_offsets[n] = change.m_time;
+						bwfm->m_samples[n] = sample;
+						if(n)
+							bwfm->m_durations[n-1] = change.m_time - prevOffset;
 					}
+					prevOffset = change.m_time;
+					n ++;
 				}
+			}
 
-				break;	//end STATE_INITIAL / STATE_DUMP
-
-			case STATE_COMMENT:
-			case STATE_DUMPALL:
-				//nothing to do, ignore them
-				break;
-		}
+			//Last sample gets a nominal one-tick duration
+			if(total)
+			{
+				if(swfm)
+					swfm->m_durations[total-1] = 1;
+				else
+					bwfm->m_durations[total-1] = 1;
+			}
 
-		//Reset at the end of a block
-		if(s.find("$end") != string::npos)
-		{
-			if(state == STATE_INITIAL)
-				state = STATE_DUMP;
-			else if(state != STATE_VARS)
-				state = STATE_IDLE;
+			wfmBySymbol[sym]->MarkModifiedFromCpu();
 		}
 	}
-	fclose(fp);
 
 	//Nothing to do if we didn't get any channels
 	if(m_streams.empty())
@@ -32,11 +32,24 @@
 
 using namespace std;
 
+///@brief Block size for streamed reads of sample data (rounded down to a whole number of rows)
+static const size_t WAV_STREAM_BLOCK_SIZE = 16 * 1024 * 1024;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
 WAVImportFilter::WAVImportFilter(const string& color)
 	: ImportFilter(color)
+	, m_streamingActive(false)
+	, m_dataStart(0)
+	, m_totalSamples(0)
+	, m_streamChans(0)
+	, m_bytesPerRow(0)
+	, m_afmt(0)
+	, m_nbits(0)
+	, m_interval(0)
+	, m_timestamp(0)
+	, m_timestampFs(0)
 {
 	m_fpname = "WAV File";
 
@@ -44,6 +57,24 @@ WAVImportFilter::WAVImportFilter(const string& color)
 	m_parameters[m_fpname].m_fileFilterMask = "*.wav";
 	m_parameters[m_fpname].m_fileFilterName = "WAV files (*.wav)";
 	m_parameters[m_fpname].signal_changed().connect(sigc::mem_fun(*this, &WAVImportFilter::OnFileNameChanged));
+
+	m_thresholdname = "Streaming threshold";
+	m_parameters[m_thresholdname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BYTES));
+	m_parameters[m_thresholdname].SetIntVal(1024LL * 1024LL * 1024LL);
+
+	m_overviewname = "Overview points";
+	m_parameters[m_overviewname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_SAMPLEDEPTH));
+	m_parameters[m_overviewname].SetIntVal(1000 * 1000);
+
+	m_winstartname = "Window start";
+	m_parameters[m_winstartname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_winstartname].SetIntVal(0);
+	m_parameters[m_winstartname].signal_changed().connect(sigc::mem_fun(*this, &WAVImportFilter::OnWindowChanged));
+
+	m_windurname = "Window duration";
+	m_parameters[m_windurname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_windurname].SetIntVal(0);
+	m_parameters[m_windurname].signal_changed().connect(sigc::mem_fun(*this, &WAVImportFilter::OnWindowChanged));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -192,52 +223,150 @@ void WAVImportFilter::OnFileNameChanged()
 	size_t nsamples = datalen / bytes_per_row;
 	int64_t interval = FS_PER_SECOND / srate;
 
+	//Save format info so the windowed view can page data in later
+	m_streamFname = fname;
+	m_dataStart = ftell(fp);
+	m_totalSamples = nsamples;
+	m_streamChans = nchans;
+	m_bytesPerRow = bytes_per_row;
+	m_afmt = afmt;
+	m_nbits = nbits;
+	m_interval = interval;
+	m_timestamp = timestamp;
+	m_timestampFs = fs;
+
+	//Files bigger than the streaming threshold get a decimated overview plus an on-demand window
+	//rather than being loaded in full
+	m_streamingActive = (datalen > (size_t)m_parameters[m_thresholdname].GetIntVal());
+
 	//Configure output streams
-	SetupStreams(nchans);
+	SetupStreams(nchans, m_streamingActive);
+
+	//Decimation factor for the overview (1 for full loads)
+	size_t decim = 1;
+	size_t outsamples = nsamples;
+	if(m_streamingActive)
+	{
+		size_t targetPoints = max((int64_t)1, m_parameters[m_overviewname].GetIntVal());
+		decim = (nsamples + targetPoints - 1) / targetPoints;
+		outsamples = (nsamples + decim - 1) / decim;
+	}
 
 	vector<UniformAnalogWaveform*> wfms;
 	for(size_t i=0; i<nchans; i++)
 	{
 		//Create new waveform for channel
 		auto wfm = new UniformAnalogWaveform;
-		wfm->m_timescale = interval;
+		wfm->m_timescale = interval * decim;
 		wfm->m_startTimestamp = timestamp;
 		wfm->m_startFemtoseconds = fs;
 		wfm->m_triggerPhase = 0;
-		wfm->Resize(nsamples);
+		wfm->Resize(outsamples);
 		wfm->PrepareForCpuAccess();
 		wfms.push_back(wfm);
 		SetData(wfm, i);
 	}
 
-	//Read the entire file into a buffer rather than doing a whole bunch of tiny fread's
-	uint8_t* buf = new uint8_t[datalen];
-	if(datalen != fread(buf, 1, datalen, fp))
+	//Stream the sample data in bounded-size blocks rather than one giant allocation
+	size_t rowsPerBlock = max((size_t)1, WAV_STREAM_BLOCK_SIZE / bytes_per_row);
+	vector<uint8_t> buf(rowsPerBlock * bytes_per_row);
+	vector<float> frame(nchans);
+	vector<float> peak(nchans, 0);
+	bool readFailed = false;
+	size_t row = 0;
+	while(row < nsamples)
 	{
-		LogError("Failed to read WAV data\n");
-		fclose(fp);
-		return;
+		size_t nrows = min(rowsPerBlock, nsamples - row);
+		if(nrows != fread(&buf[0], bytes_per_row, nrows, fp))
+		{
+			LogError("Failed to read WAV data\n");
+			readFailed = true;
+			break;
+		}
+
+		if(!m_streamingActive)
+			DecodeFrames(&buf[0], nrows, row, wfms);
+
+		else
+		{
+			//Overview: keep the largest-magnitude sample in each bucket so narrow transients stay visible
+			//(a mean would smear them away at high decimation factors)
+			const uint8_t* p = &buf[0];
+			for(size_t i=0; i<nrows; i++)
+			{
+				size_t idx = row + i;
+				if( (idx % decim) == 0)
+					fill(peak.begin(), peak.end(), 0.0f);
+
+				for(size_t j=0; j<nchans; j++)
+				{
+					float val;
+					if(m_afmt == 3)
+						memcpy(&val, p, sizeof(float));
+					else if(m_nbits == 16)
+					{
+						int16_t ival;
+						memcpy(&ival, p, sizeof(int16_t));
+						val = ival / 32768.0f;
+					}
+					else
+						val = (*p - 127) / 127.0f;
+					p += bytes_per_sample;
+
+					if(fabs(val) >= fabs(peak[j]))
+						peak[j] = val;
+				}
+
+				//Commit the bucket on its last sample (or the last sample of the file)
+				if( ( (idx % decim) == (decim - 1) ) || (idx == (nsamples - 1)) )
+				{
+					size_t bucket = idx / decim;
+					for(size_t j=0; j<nchans; j++)
+						wfms[j]->m_samples[bucket] = peak[j];
+				}
+			}
+		}
+
+		row += nrows;
 	}
 	fclose(fp);
-	fp = NULL;
 
-	//TODO: vectorized shuffling for the common case of 2 channel?
+	if(readFailed)
+		return;
 
-	//Crunch the samples
+	for(auto w : wfms)
+		w->MarkModifiedFromCpu();
+
+	//Load the initial window, if one is configured
+	if(m_streamingActive)
+		OnWindowChanged();
+}
+
+/**
+	@brief Decodes a block of interleaved sample rows into per-channel waveforms
+
+	@param buf			Raw interleaved sample data
+	@param nframes		Number of sample rows to decode
+	@param startIndex	Output index of the first decoded row
+	@param wfms			Per-channel output waveforms
+ */
+void WAVImportFilter::DecodeFrames(const uint8_t* buf, size_t nframes, size_t startIndex, vector<UniformAnalogWaveform*>& wfms)
+{
+	size_t nchans = wfms.size();
 	size_t off = 0;
-	for(size_t i=0; i<nsamples; i++)
+	for(size_t i=0; i<nframes; i++)
 	{
 		for(size_t j=0; j<nchans; j++)
 		{
 			auto wfm = wfms[j];
 
 			//Floating point samples can be read as is
-			if(afmt == 3)
+			if(m_afmt == 3)
 			{
 				//Do not violate strict aliasing, compiler will optimize out the memcpy
 				float val;
-				memcpy(&val,buf+off,sizeof(float));
-				wfm->m_samples[i] = val;
+				memcpy(&val, buf+off, sizeof(float));
+				wfm->m_samples[startIndex + i] = val;
 				off += 4;
 			}
 
@@ -245,46 +374,132 @@ void WAVImportFilter::OnFileNameChanged()
 			else
 			{
 				//16 bit is signed
-				if(nbits == 16)
+				if(m_nbits == 16)
 				{
 					//Do not violate strict aliasing, compiler will optimize out the memcpy
 					int16_t val;
-					memcpy(&val,buf+off,sizeof(int16_t));
-					wfm->m_samples[i] = val / 32768.0f;
+					memcpy(&val, buf+off, sizeof(int16_t));
+					wfm->m_samples[startIndex + i] = val / 32768.0f;
 					off += 2;
 				}
 
 				//8 bit is unsigned
 				else
 				{
-					wfm->m_samples[i] = (*(uint8_t*)(buf + off) - 127) / 127.0f;
+					wfm->m_samples[startIndex + i] = (buf[off] - 127) / 127.0f;
 					off ++;
 				}
 			}
 		}
 	}
+}
+
+void WAVImportFilter::OnWindowChanged()
+{
+	if(!m_streamingActive)
+		return;
+
+	LoadWindow(m_parameters[m_winstartname].GetIntVal(), m_parameters[m_windurname].GetIntVal());
+}
+
+/**
+	@brief Pages a full-rate segment of a streaming-mode file into the window output streams
+
+	The requested range is clamped to the extent of the file and to the streaming threshold, so the window can
+	never use more memory than a full load of a threshold-sized file would.
+
+	@param startFs		Start of the window, in fs from the beginning of the capture
+	@param durationFs	Length of the window, in fs (0 clears the window streams)
+ */
+void WAVImportFilter::LoadWindow(int64_t startFs, int64_t durationFs)
+{
+	if(!m_streamingActive || !m_interval)
+		return;
+
+	size_t firstSample = min((size_t)max(startFs / m_interval, (int64_t)0), m_totalSamples);
+	size_t count = (size_t)max(durationFs / m_interval, (int64_t)0);
+	count = min(count, m_totalSamples - firstSample);
+
+	//Bound window memory to the streaming threshold
+	size_t maxRows = m_parameters[m_thresholdname].GetIntVal() / m_bytesPerRow;
+	count = min(count, maxRows);
+
+	if(!count)
+	{
+		for(size_t i=0; i<m_streamChans; i++)
+			SetData(nullptr, m_streamChans + i);
+		return;
+	}
+
+	FILE* fp = fopen(m_streamFname.c_str(), "rb");
+	if(!fp)
+	{
+		LogError("Couldn't open WAV file \"%s\"\n", m_streamFname.c_str());
+		return;
+	}
+	fseek(fp, m_dataStart + firstSample * m_bytesPerRow, SEEK_SET);
+
+	vector<UniformAnalogWaveform*> wfms;
+	for(size_t i=0; i<m_streamChans; i++)
+	{
+		auto wfm = dynamic_cast<UniformAnalogWaveform*>(GetData(m_streamChans + i));
+		if(!wfm)
+		{
+			wfm = new UniformAnalogWaveform;
+			SetData(wfm, m_streamChans + i);
+		}
+		wfm->m_timescale = m_interval;
+		wfm->m_startTimestamp = m_timestamp;
+		wfm->m_startFemtoseconds = m_timestampFs;
+		wfm->m_triggerPhase = firstSample * m_interval;
+		wfm->Resize(count);
+		wfm->PrepareForCpuAccess();
+		wfms.push_back(wfm);
+	}
+
+	size_t rowsPerBlock = max((size_t)1, WAV_STREAM_BLOCK_SIZE / m_bytesPerRow);
+	vector<uint8_t> buf(rowsPerBlock * m_bytesPerRow);
+	size_t row = 0;
+	while(row < count)
+	{
+		size_t nrows = min(rowsPerBlock, count - row);
+		if(nrows != fread(&buf[0], m_bytesPerRow, nrows, fp))
+		{
+			LogError("Failed to read WAV data\n");
+			break;
+		}
+		DecodeFrames(&buf[0], nrows, row, wfms);
+		row += nrows;
+	}
+	fclose(fp);
 
 	for(auto w : wfms)
 		w->MarkModifiedFromCpu();
-
-	//Done, clean up
-	delete[] buf;
 }
 
-void WAVImportFilter::SetupStreams(size_t chans)
+void WAVImportFilter::SetupStreams(size_t chans, bool streaming)
 {
 	ClearStreams();
 
 	for(size_t i=0; i<chans; i++)
 		AddStream(Unit(Unit::UNIT_VOLTS), string("CH") + to_string(i+1), Stream::STREAM_TYPE_ANALOG);
 
+	//Streaming mode adds a second set of streams carrying the full-rate window
+	if(streaming)
+	{
+		for(size_t i=0; i<chans; i++)
+			AddStream(Unit(Unit::UNIT_VOLTS), string("CH") + to_string(i+1) + " (window)", Stream::STREAM_TYPE_ANALOG);
+	}
+
+	size_t nstreams = streaming ? (chans * 2) : chans;
+
 	//Resize port arrays
 	size_t oldsize = m_ranges.size();
-	m_ranges.resize(chans);
-	m_offsets.resize(chans);
+	m_ranges.resize(nstreams);
+	m_offsets.resize(nstreams);
 
 	//If growing, fill new cells with reasonable default values
-	for(size_t i=oldsize; i<chans; i++)
+	for(size_t i=oldsize; i<nstreams; i++)
 	{
 		m_ranges[i] = 2;
 		m_offsets[i] = 0;
@@ -35,6 +35,15 @@
 #ifndef WAVImportFilter_h
 #define WAVImportFilter_h
 
+/**
+	@brief Imports WAV audio files
+
+	Small files are loaded in full. Files whose sample data exceeds the "Streaming threshold" parameter open in
+	streaming mode: a peak-preserving decimated overview (at most "Overview points" samples per channel) is built
+	immediately with a single bounded-memory pass over the file, and the "Window start" / "Window duration"
+	parameters page a full-rate segment of the capture into a second set of output streams on demand. This lets
+	recordings far larger than RAM open instantly.
+ */
 class WAVImportFilter : public ImportFilter
 {
 public:
@@ -42,11 +51,57 @@ public:
 
 	static std::string GetProtocolName();
 
+	///@brief Returns true if the current file is open in streaming (overview + window) mode
+	bool IsStreaming()
+	{ return m_streamingActive; }
+
+	void LoadWindow(int64_t startFs, int64_t durationFs);
+
 	PROTOCOL_DECODER_INITPROC(WAVImportFilter)
 
 protected:
 	void OnFileNameChanged();
-	void SetupStreams(size_t chans);
+	void OnWindowChanged();
+	void SetupStreams(size_t chans, bool streaming);
+	void DecodeFrames(const uint8_t* buf, size_t nframes, size_t startIndex, std::vector<UniformAnalogWaveform*>& wfms);
+
+	std::string m_thresholdname;
+	std::string m_overviewname;
+	std::string m_winstartname;
+	std::string m_windurname;
+
+	///@brief True if the current file is open in streaming mode
+	bool m_streamingActive;
+
+	///@brief Path of the file the streaming metadata below describes
+	std::string m_streamFname;
+
+	///@brief Byte offset of the start of sample data within the file
+	size_t m_dataStart;
+
+	///@brief Total number of sample rows in the file
+	size_t m_totalSamples;
+
+	///@brief Number of channels in the file
+	size_t m_streamChans;
+
+	///@brief Size of one interleaved sample row, in bytes
+	size_t m_bytesPerRow;
+
+	///@brief WAV sample encoding (1 = integer PCM, 3 = float)
+	uint16_t m_afmt;
+
+	///@brief Bits per sample
+	uint16_t m_nbits;
+
+	///@brief Sample interval, in fs
+	int64_t m_interval;
+
+	///@brief Timestamp of the file, used for waveform start times
+	time_t m_timestamp;
+
+	///@brief Fractional seconds of the file timestamp
+	int64_t m_timestampFs;
 };
 
 #endif
@@ -29,6 +29,14 @@
 
 #include "../scopehal/scopehal.h"
 #include "WFMImportFilter.h"
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -643,7 +651,61 @@ void WFMImportFilter::OnFileNameChanged()
 	wfm->PrepareForCpuAccess();
 	SetData(wfm, 0);
 
-	if(bytesperpoint == 2)
+	bool converted = false;
+#ifndef _WIN32
+	//Map the sample region of the file and convert in parallel chunks, straight into the destination buffer,
+	//rather than copying through an intermediate heap buffer
+	int fd = open(fname.c_str(), O_RDONLY);
+	if(fd >= 0)
+	{
+		//Sanity check that the curve buffer doesn't run off the end of the file before mapping,
+		//since touching pages past EOF would fault
+		size_t maplen = curveoffset + numBytes;
+		struct stat st;
+		if( (0 == fstat(fd, &st)) && (static_cast<size_t>(st.st_size) >= maplen) )
+		{
+			void* mapping = mmap(nullptr, maplen, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapping != MAP_FAILED)
+			{
+				const uint8_t* rawdata = reinterpret_cast<const uint8_t*>(mapping) + curveoffset;
+
+				//One chunk per core, but no point spinning up a lot of threads for a small capture
+				size_t nthreads = max<size_t>(thread::hardware_concurrency(), 1);
+				nthreads = min(nthreads, max(numRealSamples / (1024 * 1024), static_cast<size_t>(1)));
+				vector<thread> threads;
+				for(size_t t=0; t<nthreads; t++)
+				{
+					threads.emplace_back([&, t]()
+					{
+						size_t start = (numRealSamples * t) / nthreads;
+						size_t end = (numRealSamples * (t+1)) / nthreads;
+						if(bytesperpoint == 2)
+						{
+							auto samples = reinterpret_cast<const int16_t*>(rawdata);
+							for(size_t i=start; i<end; i++)
+								wfm->m_samples[i] = (samples[i] * yscale) + yoff;
+						}
+						else //if(bytesperpoint == 1)
+						{
+							auto samples = reinterpret_cast<const int8_t*>(rawdata);
+							for(size_t i=start; i<end; i++)
+								wfm->m_samples[i] = (samples[i] * yscale) + yoff;
+						}
+					});
+				}
+				for(auto& th : threads)
+					th.join();
+
+				munmap(mapping, maplen);
+				converted = true;
+			}
+		}
+		close(fd);
+	}
+#endif
+
+	//Fall back to a buffered read if we couldn't map the file
+	if(!converted && (bytesperpoint == 2))
 	{
 		//Read sample data
 		int16_t* rawdata = new int16_t[numRealSamples];
@@ -652,6 +714,7 @@ void WFMImportFilter::OnFileNameChanged()
 		{
 			LogError("Fail to read waveform data\n");
 			delete[] rawdata;
+			fclose(fp);
 			return;
 		}
 
@@ -661,7 +724,7 @@ void WFMImportFilter::OnFileNameChanged()
 
 		delete[] rawdata;
 	}
-	else //if(bytesperpoint == 1)
+	else if(!converted) //if(bytesperpoint == 1)
 	{
 		//Read sample data
 		int8_t* rawdata = new int8_t[numRealSamples];
@@ -670,6 +733,7 @@ void WFMImportFilter::OnFileNameChanged()
 		{
 			LogError("Fail to read waveform data\n");
 			delete[] rawdata;
+			fclose(fp);
 			return;
 		}
 
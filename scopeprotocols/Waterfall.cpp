@@ -38,19 +38,41 @@ using namespace std;
 
 WaterfallWaveform::WaterfallWaveform(size_t width, size_t height)
 	: DensityFunctionWaveform(width, height)
-	, m_tempBuf("WaterfallWaveform.m_tempBuf")
+	, m_writeRow(0)
+	, m_unwrapBuf("WaterfallWaveform.m_unwrapBuf")
 {
-	//Temporary buffer is GPU-only
-	m_tempBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
-	m_tempBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
-
-	m_tempBuf.resize(width*height);
+	//Unwrap buffer is only needed if somebody asks for a CPU-side linear view
+	m_unwrapBuf.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_unwrapBuf.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_UNLIKELY);
 }
 
 WaterfallWaveform::~WaterfallWaveform()
 {
 }
 
+/**
+	@brief Returns a CPU-side linear view of the image, with the circular row history unwrapped
+
+	This copies the whole plot, so it's strictly for CPU-side consumers (exports etc). GPU consumers should
+	sample m_outdata directly with wrapped row indices instead.
+ */
+float* WaterfallWaveform::GetData()
+{
+	m_outdata.PrepareForCpuAccess();
+	m_unwrapBuf.resize(m_width * m_height);
+
+	auto src = m_outdata.GetCpuPointer();
+	auto dst = m_unwrapBuf.GetCpuPointer();
+	for(size_t y=0; y<m_height; y++)
+	{
+		size_t srcRow = (m_writeRow + y) % m_height;
+		memcpy(dst + y*m_width, src + srcRow*m_width, m_width * sizeof(float));
+	}
+
+	m_unwrapBuf.MarkModifiedFromCpu();
+	return dst;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -59,7 +81,7 @@ Waterfall::Waterfall(const string& color)
 	, m_width(1)
 	, m_height(1)
 	, m_maxwidth("Max width")
-	, m_computePipeline("shaders/WaterfallFilter.spv", 3, sizeof(WaterfallFilterArgs))
+	, m_computePipeline("shaders/WaterfallFilter.spv", 2, sizeof(WaterfallFilterArgs))
 {
 	AddStream(Unit(Unit::UNIT_DBM), "data", Stream::STREAM_TYPE_WATERFALL);
 	m_xAxisUnit = Unit(Unit::UNIT_HZ);
@@ -153,8 +175,8 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	//Calculate some coefficients
 	WaterfallFilterArgs args;
 	args.width = m_width;
-	args.height = m_height;
 	args.inlen = inlen;
+	args.writeRow = cap->GetWriteRow();
 	args.vrange = m_inputs[0].GetVoltageRange(); //db from min to max scale
 	args.vfs = args.vrange/2 - m_inputs[0].GetOffset();
 
@@ -164,33 +186,18 @@ void Waterfall::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle>
 	//Make sure input is ready
 	din->PrepareForGpuAccess();
 	cap->PrepareForGpuAccess();
-	cap->m_tempBuf.PrepareForGpuAccess();
 
 	cmdBuf.begin({});
 
-	//Run the actual compute on the GPU
+	//Write the new FFT line over the oldest row of the circular image.
+	//No shifting: consumers unwrap by sampling rows mod height starting at the write pointer.
 	m_computePipeline.BindBufferNonblocking(0, din->m_samples, cmdBuf);
 	m_computePipeline.BindBufferNonblocking(1, cap->GetOutData(), cmdBuf);
-	m_computePipeline.BindBufferNonblocking(2, cap->m_tempBuf, cmdBuf, true);
-	m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.width, 64), m_height);
-
-	//Wait for the shader to finish
-	cmdBuf.pipelineBarrier(
-		vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
-		vk::PipelineStageFlagBits::eTransfer,
-		{},
-		vk::MemoryBarrier(
-			vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
-			vk::AccessFlagBits::eTransferRead),
-		{},
-		{});
-
-	//Copy the output buffer over the input
-	vk::BufferCopy region(0, 0, cap->GetOutData().size() * sizeof(float));
-	cmdBuf.copyBuffer(cap->m_tempBuf.GetBuffer(), cap->GetOutData().GetBuffer(), {region});
+	m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(args.width, 64));
 
 	cmdBuf.end();
 	queue->SubmitAndBlock(cmdBuf);
 
+	cap->AdvanceWriteRow();
 	cap->GetOutData().MarkModifiedFromGpu();
 }
@@ -40,13 +40,21 @@
 struct WaterfallFilterArgs
 {
 	uint32_t width;
-	uint32_t height;
 	uint32_t inlen;
+	uint32_t writeRow;
 	float vrange;
 	float vfs;
 	float timescaleRatio;
 };
 
+/**
+	@brief Rolling history of FFT rows, stored as a GPU-resident circular buffer
+
+	Rows are never shifted: each update overwrites the oldest row in place and advances the write pointer, so
+	updating a plot costs O(width) regardless of height. Storage row (GetWriteRow() + y) mod height holds display
+	row y (y=0 oldest, y=height-1 newest); GPU consumers should sample with that wrapped index, while CPU-side
+	consumers calling GetData() receive an unwrapped copy.
+ */
 class WaterfallWaveform : public DensityFunctionWaveform
 {
 public:
@@ -63,7 +71,22 @@ public:
 	virtual bool HasGpuBuffer() override
 	{ return false; }
 
-	AcceleratorBuffer<float> m_tempBuf;
+	virtual float* GetData() override;
+
+	///@brief Returns the storage index of the row to be overwritten next (the oldest row in the image)
+	size_t GetWriteRow()
+	{ return m_writeRow; }
+
+	///@brief Advances the rolling write row after a new FFT line has been written
+	void AdvanceWriteRow()
+	{ m_writeRow = (m_writeRow + 1) % m_height; }
+
+protected:
+	///@brief Storage index of the next row to overwrite
+	size_t m_writeRow;
+
+	///@brief Scratch buffer for unwrapping the circular image for CPU-side consumers
+	AcceleratorBuffer<float> m_unwrapBuf;
 };
 
 class Waterfall : public Filter
@@ -39,11 +39,20 @@ WaveformGenerationFilter::WaveformGenerationFilter(const string& color)
 	: Filter(color, CAT_GENERATION)
 	, m_sampleRate("Sample Rate")
 	, m_edgeTime("Transition Time")
+	, m_computePipeline("shaders/EdgeSynthesis.spv", 4, sizeof(EdgeSynthesisArgs))
 {
 	AddStream(Unit(Unit::UNIT_VOLTS), "data", Stream::STREAM_TYPE_ANALOG);
 	CreateInput("data");
 	CreateInput("clk");
 
+	//Use pinned memory for synthesis inputs
+	m_segStarts.SetCpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segStarts.SetGpuAccessHint(AcceleratorBuffer<uint32_t>::HINT_LIKELY);
+	m_segments.SetCpuAccessHint(AcceleratorBuffer<EdgeSynthesisSegment>::HINT_LIKELY);
+	m_segments.SetGpuAccessHint(AcceleratorBuffer<EdgeSynthesisSegment>::HINT_LIKELY);
+	m_shapes.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	m_shapes.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+
 	m_parameters[m_edgeTime] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
 	m_parameters[m_edgeTime].SetIntVal(10 * 1000);
 
@@ -91,7 +100,7 @@ float WaveformGenerationFilter::GetMinLevel()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
-void WaveformGenerationFilter::Refresh()
+void WaveformGenerationFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, shared_ptr<QueueHandle> queue)
 {
 	if(!VerifyAllInputsOK())
 	{
@@ -140,9 +149,17 @@ void WaveformGenerationFilter::Refresh()
 	size_t caplen = (samples.m_offsets[len-1] + samples.m_durations[len-1] - capstart) / samplePeriod;
 	cap->Resize(caplen);
 
-	//Process samples, two at a time
+	//Build one synthesis segment per symbol: a linear ramp from the previous level over the transition time,
+	//then flat at the symbol's level. The heavy per-sample work happens in the EdgeSynthesis kernel.
+	size_t nsymbols = len / bitsPerSymbol;
+	m_segStarts.resize(nsymbols);
+	m_segments.resize(nsymbols);
+	m_segStarts.PrepareForCpuAccess();
+	m_segments.PrepareForCpuAccess();
+
 	float vlast = levels[0];
 	size_t nsamp = 0;
+	uint32_t nsegments = 0;
 	for(size_t i=0; i<len; i += bitsPerSymbol)
 	{
 		//Convert start/end times to our output timebase
@@ -151,27 +168,70 @@ void WaveformGenerationFilter::Refresh()
 		size_t tend_rounded = tend / samplePeriod;
 
 		float v = levels[GetVoltageCode(i, samples)];
-		size_t tEdgeDone = nsamp + edgeSamples;
 
-		//Emit samples for the edge
-		float delta = v - vlast;
-		for(; (nsamp < tEdgeDone) && (nsamp < caplen); nsamp ++)
-		{
-			//Figure out how far along we are
-			float tnow = nsamp * samplePeriod;
-			float tdelta = tnow - tstart;
-			float frac = max(0.0f, tdelta / edgeTime);
-			float vcur = vlast + delta*frac;
+		EdgeSynthesisSegment seg;
+		seg.residualSec = ( (int64_t)(nsamp * samplePeriod) - (int64_t)tstart ) * SECONDS_PER_FS;
+		seg.vStart = vlast;
+		seg.vEnd = v;
+		seg.shapeIndex = 0;
 
-			cap->m_samples[nsamp] = vcur;
-		}
+		m_segStarts[nsegments] = nsamp;
+		m_segments[nsegments] = seg;
+		nsegments ++;
 
-		//Emit samples for the rest of the UI
-		for(; (nsamp < tend_rounded) && (nsamp < caplen); nsamp ++)
-			cap->m_samples[nsamp] = v;
+		//Next symbol begins once both the edge and the symbol period are over
+		nsamp = max(nsamp + edgeSamples, tend_rounded);
+		if(nsamp >= caplen)
+			break;
 
 		vlast = v;
 	}
+	m_segStarts.MarkModifiedFromCpu();
+	m_segments.MarkModifiedFromCpu();
+
+	if( (nsegments == 0) || (caplen == 0) )
+	{
+		SetData(NULL, 0);
+		return;
+	}
 
-	cap->MarkModifiedFromCpu();
+	//Single shape table: a linear ramp over the transition time
+	m_shapes.resize(4);
+	m_shapes.PrepareForCpuAccess();
+	m_shapes[0] = 0;
+	m_shapes[1] = 0;
+	m_shapes[2] = edgeTime * SECONDS_PER_FS;
+	m_shapes[3] = 1;
+	m_shapes.MarkModifiedFromCpu();
+
+	EdgeSynthesisArgs args;
+	args.nsamples = caplen;
+	args.nsegments = nsegments;
+	args.samplePeriodSec = samplePeriod * SECONDS_PER_FS;
+	args.shapeOffset0 = 0;
+	args.shapeLen0 = 2;
+	args.shapeOffset1 = 0;
+	args.shapeLen1 = 2;
+
+	if(g_gpuFilterEnabled)
+	{
+		cmdBuf.begin({});
+
+		m_computePipeline.BindBufferNonblocking(0, cap->m_samples, cmdBuf, true);
+		m_computePipeline.BindBufferNonblocking(1, m_segStarts, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(2, m_segments, cmdBuf);
+		m_computePipeline.BindBufferNonblocking(3, m_shapes, cmdBuf);
+
+		m_computePipeline.Dispatch(cmdBuf, args, GetComputeBlockCount(caplen, 64));
+
+		cmdBuf.end();
+		queue->SubmitAndBlock(cmdBuf);
+		cap->MarkModifiedFromGpu();
+	}
+
+	else
+	{
+		SynthesizeEdgesCpu(cap->m_samples, m_segStarts, m_segments, m_shapes, args);
+		cap->MarkModifiedFromCpu();
+	}
 }
@@ -35,12 +35,14 @@
 #ifndef WaveformGenerationFilter_h
 #define WaveformGenerationFilter_h
 
+#include "EdgeSynthesis.h"
+
 class WaveformGenerationFilter : public Filter
 {
 public:
 	WaveformGenerationFilter(const std::string& color);
 
-	virtual void Refresh() override;
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, std::shared_ptr<QueueHandle> queue) override;
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream) override;
 
@@ -54,6 +56,18 @@ protected:
 
 	std::string m_sampleRate;
 	std::string m_edgeTime;
+
+	///@brief Compute pipeline for output sample synthesis
+	ComputePipeline m_computePipeline;
+
+	///@brief Output sample index at which each symbol begins
+	AcceleratorBuffer<uint32_t> m_segStarts;
+
+	///@brief Edge segment descriptors for the synthesis shader
+	AcceleratorBuffer<EdgeSynthesisSegment> m_segments;
+
+	///@brief Edge shape table (a single linear ramp over the transition time)
+	AcceleratorBuffer<float> m_shapes;
 };
 
 #endif
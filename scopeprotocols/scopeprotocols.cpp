@@ -34,6 +34,7 @@
  */
 
 #include "scopeprotocols.h"
+#include "../scopehal/PipelineCacheManager.h"
 
 /**
 	@brief Static initialization for protocol list
@@ -42,6 +43,7 @@ void ScopeProtocolStaticInit()
 {
 	AddDecoderClass(ACCoupleFilter);
 	AddDecoderClass(ACRMSMeasurement);
+	AddDecoderClass(AdaptiveEqualizerFilter);
 	AddDecoderClass(AddFilter);
 	AddDecoderClass(ADL5205Decoder);
 	AddDecoderClass(AreaMeasurement);
@@ -125,6 +127,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(FullWidthHalfMax);
 	AddDecoderClass(GateFilter);
 	AddDecoderClass(GlitchRemovalFilter);
+	AddDecoderClass(GoertzelBankFilter);
 	AddDecoderClass(GroupDelayFilter);
 	AddDecoderClass(HistogramFilter);
 	AddDecoderClass(HorizontalBathtub);
@@ -144,6 +147,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(J1939SourceMatchFilter);
 	AddDecoderClass(J1939TransportDecoder);
 	AddDecoderClass(ISIMeasurement);
+	AddDecoderClass(JitterAnalysisFilter);
 	AddDecoderClass(JitterFilter);
 	AddDecoderClass(JitterSpectrumFilter);
 	AddDecoderClass(JtagDecoder);
@@ -159,6 +163,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(NoiseFilter);
 	AddDecoderClass(OneWireDecoder);
 	AddDecoderClass(OvershootMeasurement);
+	AddDecoderClass(PacketMatchFilter);
 	AddDecoderClass(PAM4DemodulatorFilter);
 	AddDecoderClass(PAMEdgeDetectorFilter);
 	//AddDecoderClass(ParallelBus);
@@ -195,6 +200,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(SNRFilter);
 	AddDecoderClass(SParameterCascadeFilter);
 	AddDecoderClass(SParameterDeEmbedFilter);
+	AddDecoderClass(SparseToUniformFilter);
 	AddDecoderClass(SpectrogramFilter);
 	AddDecoderClass(SPIDecoder);
 	AddDecoderClass(SPIFlashDecoder);
@@ -240,3 +246,51 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(WindowFilter);
 	AddDecoderClass(XYSweepFilter);
 }
+
+/**
+	@brief Ahead-of-time compilation of the full filter shader set
+
+	Instantiates one of every registered filter class (registering all of their compute pipelines), then builds every
+	pipeline in parallel across all cores, populating the on-disk pipeline cache. On subsequent launches the cache is
+	hot and this function returns immediately, so first-use compilation stalls never reach the user.
+
+	The completion marker is stored through PipelineCacheManager and thus invalidated automatically whenever the
+	device UUID or driver version changes, forcing a fresh precompile.
+
+	Call after ScopeProtocolStaticInit() and full Vulkan initialization, ideally from a background thread during
+	startup.
+ */
+void PrecompileFilterShaders()
+{
+	//Already precompiled for this device and driver? Nothing to do
+	if(g_pipelineCacheMgr->LookupRaw("filterShaderPrecompile") != nullptr)
+		return;
+
+	double start = GetTime();
+	LogDebug("Precompiling filter shaders\n");
+	LogIndenter li;
+
+	//Instantiate one of every filter class so all of their pipelines get registered
+	std::vector<std::string> names;
+	Filter::EnumProtocols(names);
+	std::vector<Filter*> filters;
+	for(auto& name : names)
+	{
+		auto f = Filter::CreateFilter(name);
+		if(f)
+			filters.push_back(f);
+	}
+
+	//Build all of the pipelines across every core
+	ComputePipeline::PrecompileAll();
+
+	for(auto f : filters)
+		delete f;
+
+	//Leave a marker so the next launch skips all of this
+	auto blob = std::make_shared<std::vector<uint8_t>>();
+	blob->push_back(1);
+	g_pipelineCacheMgr->StoreRaw("filterShaderPrecompile", blob);
+
+	LogDebug("Precompiled shaders for %zu filter classes in %.2f s\n", filters.size(), GetTime() - start);
+}
@@ -40,6 +40,7 @@
 #include "../scopehal/Filter.h"
 
 #include "ACCoupleFilter.h"
+#include "AdaptiveEqualizerFilter.h"
 #include "AddFilter.h"
 #include "ACRMSMeasurement.h"
 #include "ADL5205Decoder.h"
@@ -125,6 +126,7 @@
 #include "FFTFilter.h"
 #include "FIRFilter.h"
 #include "FrequencyMeasurement.h"
+#include "GoertzelBankFilter.h"
 #include "GroupDelayFilter.h"
 #include "HistogramFilter.h"
 #include "HorizontalBathtub.h"
@@ -144,6 +146,7 @@
 #include "J1939PDUDecoder.h"
 #include "J1939SourceMatchFilter.h"
 #include "J1939TransportDecoder.h"
+#include "JitterAnalysisFilter.h"
 #include "JitterFilter.h"
 #include "JitterSpectrumFilter.h"
 #include "JtagDecoder.h"
@@ -159,6 +162,7 @@
 #include "NoiseFilter.h"
 #include "OneWireDecoder.h"
 #include "OvershootMeasurement.h"
+#include "PacketMatchFilter.h"
 #include "ParallelBus.h"
 #include "PAM4DemodulatorFilter.h"
 #include "PAMEdgeDetectorFilter.h"
@@ -195,6 +199,7 @@
 #include "SNRFilter.h"
 #include "SParameterCascadeFilter.h"
 #include "SParameterDeEmbedFilter.h"
+#include "SparseToUniformFilter.h"
 #include "SpectrogramFilter.h"
 #include "SPIDecoder.h"
 #include "SPIFlashDecoder.h"
@@ -241,5 +246,6 @@
 #include "XYSweepFilter.h"
 
 void ScopeProtocolStaticInit();
+void PrecompileFilterShaders();
 
 #endif
@@ -51,38 +51,57 @@ layout(std430, push_constant) uniform constants
 	float irange;
 };
 
-layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+//The FFT output is one row per block, but the spectrogram is one column per block, so this shader is a transpose.
+//Stage each 32x32 tile through shared memory so both the loads and the stores are coalesced, rather than
+//scattering stride-nblocks writes across the whole output at large FFT sizes.
+const uint TILE_SIZE = 32;
+const uint ROWS_PER_PASS = 8;
+
+layout(local_size_x=32, local_size_y=8, local_size_z=1) in;
+
+//Pad each row by one element so the column-wise reads in the store phase hit different banks
+shared float g_tile[TILE_SIZE][TILE_SIZE + 1];
 
 void main()
 {
-	const float flog10 = log(10);
-	const float logscale = 10 / flog10;
+	uint tileBin = gl_WorkGroupID.x * TILE_SIZE;
+	uint tileBlock = gl_WorkGroupID.y * TILE_SIZE;
 
-	//If off end of array, stop
-	if(gl_GlobalInvocationID.x >= nouts)
-		return;
+	//Load phase: consecutive threads read consecutive FFT bins of one block
+	for(uint j=0; j<TILE_SIZE; j += ROWS_PER_PASS)
+	{
+		uint bin = tileBin + gl_LocalInvocationID.x;
+		uint block = tileBlock + gl_LocalInvocationID.y + j;
+		if( (bin < nouts) && (block < nblocks) )
+		{
+			//Rotate spectrogram by half the block size so center frequency is in the middle
+			//TODO: why is this needed?
+			uint isample = bin + (nouts/2);
+			if(isample >= nouts)
+				isample -= nouts;
 
-	//Find real Y coordinate
-	uint realy = gl_GlobalInvocationID.y*ygrid + gl_GlobalInvocationID.z;
-	if(realy >= nblocks)
-		return;
+			uint nin = (nouts*block + isample)*2;
+			float real = din[nin];
+			float imag = din[nin + 1];
 
-	//Rotate spectrogram by half the block size so center frequency is in the middle
-	//TODO: why is this needed?
-	uint isample = gl_GlobalInvocationID.x + (nouts/2);
-	if(isample >= nouts)
-		isample -= nouts;
+			float vsq = real*real + imag*imag;
+			float dbm = (logscale * log(vsq * impscale) + 30);
 
-	uint nin = (nouts*realy + isample)*2;
-	uint nout = gl_GlobalInvocationID.x*nblocks + realy;
+			float v = 0;
+			if(dbm >= minscale)
+				v = (dbm - minscale) * irange;
+			g_tile[gl_LocalInvocationID.y + j][gl_LocalInvocationID.x] = v;
+		}
+	}
 
-	float real = din[nin];
-	float imag = din[nin + 1];
+	barrier();
 
-	float vsq = real*real + imag*imag;
-	float dbm = (logscale * log(vsq * impscale) + 30);
-	if(dbm < minscale)
-		dout[nout] = 0;
-	else
-		dout[nout] = (dbm - minscale) * irange;
+	//Store phase: consecutive threads write consecutive blocks (one row of the transposed tile)
+	for(uint j=0; j<TILE_SIZE; j += ROWS_PER_PASS)
+	{
+		uint bin = tileBin + gl_LocalInvocationID.y + j;
+		uint block = tileBlock + gl_LocalInvocationID.x;
+		if( (bin < nouts) && (block < nblocks) )
+			dout[bin*nblocks + block] = g_tile[gl_LocalInvocationID.x][gl_LocalInvocationID.y + j];
+	}
 }
@@ -48,10 +48,13 @@ layout(std430, push_constant) uniform constants
 	uint offsetOut;
 
 	float scale;
-	float alpha0;
-	float alpha1;
 };
 
+//Window coefficients are baked in at pipeline build time (one pipeline per window type) so they're
+//compile time constants rather than per-invocation push constant loads
+layout(constant_id=0) const float alpha0 = 0.5;
+layout(constant_id=1) const float alpha1 = 0.5;
+
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
 
 void main()
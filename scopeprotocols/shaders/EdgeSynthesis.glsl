@@ -0,0 +1,130 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//Shared edge synthesis kernel for IBISDriverFilter and WaveformGenerationFilter.
+//Each invocation produces one output sample: find the active segment (the most recent edge in the
+//stimulus), then interpolate that segment's edge shape table at the time elapsed since the edge.
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+//Output sample index at which each segment begins (monotonic, first entry is 0)
+layout(std430, binding=1) restrict readonly buffer buf_segStarts
+{
+	uint segStarts[];
+};
+
+struct EdgeSynthesisSegment
+{
+	float residualSec;	//time from the segment's first output sample back to the edge itself
+	float vStart;
+	float vEnd;
+	uint shapeIndex;
+};
+
+layout(std430, binding=2) restrict readonly buffer buf_segments
+{
+	EdgeSynthesisSegment segments[];
+};
+
+//Concatenated edge shape tables: (time, value) pairs sorted by time
+layout(std430, binding=3) restrict readonly buffer buf_shapes
+{
+	vec2 shapes[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint nsamples;
+	uint nsegments;
+	float samplePeriodSec;
+	uint shapeOffset0;
+	uint shapeLen0;
+	uint shapeOffset1;
+	uint shapeLen1;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= nsamples)
+		return;
+
+	//Binary search for the last segment starting at or before our sample
+	uint lo = 0;
+	uint hi = nsegments - 1;
+	while(lo < hi)
+	{
+		uint mid = (lo + hi + 1) / 2;
+		if(segStarts[mid] <= i)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	EdgeSynthesisSegment seg = segments[lo];
+	float trel = float(i - segStarts[lo]) * samplePeriodSec + seg.residualSec;
+
+	uint off = (seg.shapeIndex == 0) ? shapeOffset0 : shapeOffset1;
+	uint len = (seg.shapeIndex == 0) ? shapeLen0 : shapeLen1;
+
+	//Interpolate the shape table at trel, clipping at either end
+	float frac;
+	if(trel <= shapes[off].x)
+		frac = shapes[off].y;
+	else if(trel >= shapes[off + len - 1].x)
+		frac = shapes[off + len - 1].y;
+	else
+	{
+		uint slo = off;
+		uint shi = off + len - 1;
+		while((shi - slo) > 1)
+		{
+			uint mid = (slo + shi) / 2;
+			if(shapes[mid].x > trel)
+				shi = mid;
+			else
+				slo = mid;
+		}
+
+		float t0 = shapes[slo].x;
+		float t1 = shapes[shi].x;
+		float f = (trel - t0) / (t1 - t0);
+		frac = mix(shapes[slo].y, shapes[shi].y, f);
+	}
+
+	dout[i] = mix(seg.vStart, seg.vEnd, frac);
+}
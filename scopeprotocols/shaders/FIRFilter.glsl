@@ -49,18 +49,22 @@ layout(std430, push_constant) uniform constants
 {
 	uint end;
 	uint filterlen;
+	uint offset;
 };
 
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
 
 void main()
 {
+	//Index of the output sample this thread computes (offset is nonzero for tiled dispatches)
+	uint nout = gl_GlobalInvocationID.x + offset;
+
 	//If off end of array, stop
-	if(gl_GlobalInvocationID.x >= end)
+	if(nout >= end)
 		return;
 
 	float temp = 0;
 	for(uint i=0; i<filterlen; i++)
-		temp += din[gl_GlobalInvocationID.x + i] * taps[i];
-	dout[gl_GlobalInvocationID.x] = temp;
+		temp += din[nout + i] * taps[i];
+	dout[nout] = temp;
 }
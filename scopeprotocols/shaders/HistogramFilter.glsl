@@ -0,0 +1,100 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, binding=1) restrict buffer buf_hist
+{
+	uint hist[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint size;
+	uint nbins;
+	float low;
+	float delta;
+};
+
+layout(local_size_x=256, local_size_y=1, local_size_z=1) in;
+
+//Per-workgroup bins so most atomics stay in shared memory.
+//4096 uints = 16 kB, the minimum maxComputeSharedMemorySize the spec guarantees.
+const uint MAX_SHARED_BINS = 4096;
+shared uint g_sharedBins[MAX_SHARED_BINS];
+
+void main()
+{
+	//If the histogram is too big for shared memory, fall back to binning straight into the global histogram
+	bool useSharedBins = (nbins <= MAX_SHARED_BINS);
+
+	//Clear our workgroup's private bins
+	if(useSharedBins)
+	{
+		for(uint i=gl_LocalInvocationID.x; i<nbins; i += gl_WorkGroupSize.x)
+			g_sharedBins[i] = 0;
+		barrier();
+	}
+
+	//Grid-stride loop over the input so each workgroup bins many samples
+	uint nthreads = gl_WorkGroupSize.x * gl_NumWorkGroups.x;
+	for(uint i=gl_GlobalInvocationID.x; i<size; i += nthreads)
+	{
+		//Out-of-range values clamp to the first/last bin, matching Filter::MakeHistogram
+		float fbin = (din[i] - low) / delta;
+		uint bin;
+		if(fbin < 0)
+			bin = 0;
+		else
+			bin = min(uint(floor(fbin * nbins)), nbins - 1);
+
+		if(useSharedBins)
+			atomicAdd(g_sharedBins[bin], 1);
+		else
+			atomicAdd(hist[bin], 1);
+	}
+
+	//Merge our private bins into the global histogram
+	if(useSharedBins)
+	{
+		barrier();
+		for(uint i=gl_LocalInvocationID.x; i<nbins; i += gl_WorkGroupSize.x)
+		{
+			uint count = g_sharedBins[i];
+			if(count != 0)
+				atomicAdd(hist[i], count);
+		}
+	}
+}
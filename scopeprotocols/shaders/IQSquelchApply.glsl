@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din_i
+{
+	float din_i[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_din_q
+{
+	float din_q[];
+};
+
+layout(std430, binding=2) restrict readonly buffer buf_blockmax
+{
+	float blockmax[];
+};
+
+layout(std430, binding=3) restrict writeonly buffer buf_dout_i
+{
+	float dout_i[];
+};
+
+layout(std430, binding=4) restrict writeonly buffer buf_dout_q
+{
+	float dout_q[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint holdtime;
+	float tsq;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//Samples per coarse block, must match IQSquelchBlockMax.glsl and IQSquelchFilter
+#define BLOCK_SIZE 64
+
+/**
+	Second pass of the squelch gate: threshold decision plus gating, fused into a single dispatch.
+
+	The sequential open/close state machine of the CPU implementation is equivalent to a trailing window
+	test: the squelch is open at sample i iff some sample in [i-holdtime, i] has squared magnitude above
+	the threshold. Full blocks inside the window are tested against the precomputed per-block maxima, and
+	only the partial blocks at the window edges are checked sample by sample.
+ */
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= len)
+		return;
+
+	uint wstart = (i >= holdtime) ? (i - holdtime) : 0;
+
+	uint bstart = wstart / BLOCK_SIZE;
+	uint bend = i / BLOCK_SIZE;
+
+	bool open = false;
+	for(uint b = bend; (b + 1) > bstart; b --)
+	{
+		//Most recent blocks first, since an open squelch usually means recent samples are above threshold
+		uint lo = max(wstart, b * BLOCK_SIZE);
+		uint hi = min(i, b * BLOCK_SIZE + (BLOCK_SIZE - 1));
+
+		//Full block inside the window: test the precomputed maximum
+		if( (lo == (b * BLOCK_SIZE)) && (hi == (b * BLOCK_SIZE + (BLOCK_SIZE - 1))) )
+			open = (blockmax[b] > tsq);
+
+		//Partial block at a window edge: check sample by sample
+		else
+		{
+			for(uint j = lo; (j <= hi) && !open; j ++)
+			{
+				float vi = din_i[j];
+				float vq = din_q[j];
+				open = ( (vi*vi + vq*vq) > tsq );
+			}
+		}
+
+		if(open)
+			break;
+	}
+
+	if(open)
+	{
+		dout_i[i] = din_i[i];
+		dout_q[i] = din_q[i];
+	}
+	else
+	{
+		dout_i[i] = 0;
+		dout_q[i] = 0;
+	}
+}
@@ -0,0 +1,83 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din_i
+{
+	float din_i[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_din_q
+{
+	float din_q[];
+};
+
+layout(std430, binding=2) restrict writeonly buffer buf_blockmax
+{
+	float blockmax[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint len;
+	uint nblocks;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+//Samples per coarse block, must match IQSquelchApply.glsl and IQSquelchFilter
+#define BLOCK_SIZE 64
+
+/**
+	First pass of the squelch gate: coarse per-block maximum of the squared I/Q magnitude.
+
+	The apply pass evaluates its trailing hold window against these maxima rather than the raw samples, so
+	the per-sample cost is O(holdtime / BLOCK_SIZE) instead of O(holdtime).
+ */
+void main()
+{
+	uint nblock = gl_GlobalInvocationID.x;
+	if(nblock >= nblocks)
+		return;
+
+	uint start = nblock * BLOCK_SIZE;
+	uint end = min(start + BLOCK_SIZE, len);
+
+	float vmax = 0;
+	for(uint i = start; i < end; i ++)
+	{
+		float vi = din_i[i];
+		float vq = din_q[i];
+		vmax = max(vmax, vi*vi + vq*vq);
+	}
+
+	blockmax[nblock] = vmax;
+}
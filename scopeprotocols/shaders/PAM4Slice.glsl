@@ -0,0 +1,78 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+#version 430
+#pragma shader_stage(compute)
+
+//Each input sample is one PAM4 symbol which slices to two output bits.
+//Output digital samples are single byte bools, so each invocation slices two symbols and writes one
+//packed 32-bit word (the filter rounds the output buffer capacity up to a word boundary)
+layout(std430, binding=0) restrict writeonly buffer buf_dout
+{
+	uint dout[];
+};
+
+layout(std430, binding=1) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+layout(std430, push_constant) uniform constants
+{
+	uint nsymbols;
+	float vlow;
+	float vmid;
+	float vhigh;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint nwords = (nsymbols + 1) / 2;
+	if(gl_GlobalInvocationID.x >= nwords)
+		return;
+
+	uint base = gl_GlobalInvocationID.x * 2;
+	uint word = 0;
+	for(uint k=0; k<2; k++)
+	{
+		uint i = base + k;
+		if(i >= nsymbols)
+			break;
+
+		//Slice and gray decode (levels are 00, 01, 11, 10 from lowest to highest)
+		float v = din[i];
+		uint firstbit = ((v >= vmid) ? 1u : 0u);
+		uint secondbit = ((v >= vlow) && (v < vhigh)) ? 1u : 0u;
+
+		word |= (firstbit << (k*16)) | (secondbit << (k*16 + 8));
+	}
+	dout[gl_GlobalInvocationID.x] = word;
+}
@@ -0,0 +1,98 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2024 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+//Sparse-to-uniform resampling kernel for SparseToUniformFilter.
+//Each invocation produces one output sample: binary search for the owning input sample (a gather, so no
+//write races and uniform work per thread), then apply the fill policy if we fall in the gap past its duration.
+
+#version 430
+#pragma shader_stage(compute)
+
+layout(std430, binding=0) restrict readonly buffer buf_din
+{
+	float din[];
+};
+
+//Output sample index at which each input sample begins (monotonic, first entry is 0)
+layout(std430, binding=1) restrict readonly buffer buf_segStarts
+{
+	uint segStarts[];
+};
+
+//Output sample index at which each input sample's duration ends
+layout(std430, binding=2) restrict readonly buffer buf_segEnds
+{
+	uint segEnds[];
+};
+
+layout(std430, binding=3) restrict writeonly buffer buf_dout
+{
+	float dout[];
+};
+
+//Fill policies, must match SparseToUniformFilter::FillPolicy
+#define FILL_HOLD	0
+#define FILL_ZERO	1
+#define FILL_NAN	2
+
+layout(std430, push_constant) uniform constants
+{
+	uint nsamples;
+	uint nsegments;
+	uint fillPolicy;
+};
+
+layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if(i >= nsamples)
+		return;
+
+	//Binary search for the last input sample starting at or before our output sample
+	uint lo = 0;
+	uint hi = nsegments - 1;
+	while(lo < hi)
+	{
+		uint mid = (lo + hi + 1) / 2;
+		if(segStarts[mid] <= i)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	//Inside the sample's duration (or holding): copy its value, otherwise apply the fill policy
+	if( (i < segEnds[lo]) || (fillPolicy == FILL_HOLD) )
+		dout[i] = din[lo];
+	else if(fillPolicy == FILL_ZERO)
+		dout[i] = 0.0;
+	else
+		dout[i] = uintBitsToFloat(0x7fc00000);
+}
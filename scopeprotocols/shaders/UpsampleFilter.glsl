@@ -49,7 +49,7 @@ layout(std430, push_constant) uniform constants
 {
 	uint imax;
 	uint upsample_factor;
-	uint kernel;
+	uint window;
 };
 
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
@@ -61,17 +61,13 @@ void main()
 	if(gl_GlobalInvocationID.y >= upsample_factor)	//j
 		return;
 
-	uint start = 0;
-	uint sstart = 0;
-	if(gl_GlobalInvocationID.y > 0)
-	{
-		sstart = 1;
-		start = upsample_factor - gl_GlobalInvocationID.y;
-	}
+	//Kernel is stored as one contiguous polyphase bank of taps per output phase
+	uint base = gl_GlobalInvocationID.y * window;
+	uint sstart = (gl_GlobalInvocationID.y > 0) ? 1 : 0;
 
 	float f = 0;
-	for(uint k = start; k<kernel; k += upsample_factor, sstart ++)
-		f += fkernel[k] * din[gl_GlobalInvocationID.x + sstart];
+	for(uint t = 0; t<window; t ++)
+		f += fkernel[base + t] * din[gl_GlobalInvocationID.x + sstart + t];
 
 	dout[gl_GlobalInvocationID.x*upsample_factor + gl_GlobalInvocationID.y] = f;
 }
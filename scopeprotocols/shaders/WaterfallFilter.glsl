@@ -35,12 +35,7 @@ layout(std430, binding=0) restrict readonly buffer buf_dnew
 	float dnew[];
 };
 
-layout(std430, binding=1) restrict readonly buffer buf_din
-{
-	float din[];
-};
-
-layout(std430, binding=2) restrict writeonly buffer buf_dout
+layout(std430, binding=1) restrict buffer buf_dout
 {
 	float dout[];
 };
@@ -48,8 +43,8 @@ layout(std430, binding=2) restrict writeonly buffer buf_dout
 layout(std430, push_constant) uniform constants
 {
 	uint width;
-	uint height;
 	uint inlen;
+	uint writeRow;
 	float vrange;
 	float vfs;
 	float timescaleRatio;
@@ -57,37 +52,26 @@ layout(std430, push_constant) uniform constants
 
 layout(local_size_x=64, local_size_y=1, local_size_z=1) in;
 
+//The waterfall image is a circular buffer indexed by a rolling write row: each update overwrites the oldest
+//row in place rather than shifting the whole plot, so the cost per update is O(width) regardless of height.
+//Consumers map display row y to storage row (writeRow + y) mod height to unwrap the history.
 void main()
 {
 	//Bounds check
 	if(gl_GlobalInvocationID.x >= width)
 		return;
-	if(gl_GlobalInvocationID.y >= height)
-		return;
-
-	//Lower rows move down
-	if(gl_GlobalInvocationID.y < (height-1) )
-	{
-		dout[gl_GlobalInvocationID.y * width + gl_GlobalInvocationID.x] =
-			din[(gl_GlobalInvocationID.y+1) * width + gl_GlobalInvocationID.x];
-	}
 
-	//Topmost row gets new content
-	else
-	{
-		float vmin = 1.0 / 255.0;
+	float vmin = 1.0 / 255.0;
 
-		uint binMin = uint(round(gl_GlobalInvocationID.x * timescaleRatio));
-		uint binMax = uint(round((gl_GlobalInvocationID.x+1) * timescaleRatio)) - 1;
+	uint binMin = uint(round(gl_GlobalInvocationID.x * timescaleRatio));
+	uint binMax = uint(round((gl_GlobalInvocationID.x+1) * timescaleRatio)) - 1;
 
-		float maxAmplitude = vmin;
-		for(uint i=binMin; (i <= binMax) && (i <= inlen); i++)
-		{
-			float v = 1 - ( (dnew[i] - vfs) / -vrange);
-			maxAmplitude = max(maxAmplitude, v);
-		}
-
-		dout[gl_GlobalInvocationID.y * width + gl_GlobalInvocationID.x] = maxAmplitude;
+	float maxAmplitude = vmin;
+	for(uint i=binMin; (i <= binMax) && (i <= inlen); i++)
+	{
+		float v = 1 - ( (dnew[i] - vfs) / -vrange);
+		maxAmplitude = max(maxAmplitude, v);
 	}
 
+	dout[writeRow * width + gl_GlobalInvocationID.x] = maxAmplitude;
 }